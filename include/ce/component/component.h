@@ -1,6 +1,11 @@
 #pragma once
 #include "ce/math/math.hpp"
+#include "ce/component/component_registry.h"
+#include "ce/utils/string_id.h"
 #include <vector>
+#include <unordered_map>
+#include <string_view>
+#include <functional>
 #include <mutex>
 #include <shared_mutex>
 
@@ -8,6 +13,43 @@ namespace CrossEngine
 {
     using Math::EulerRotOrder;
     class Window;
+    class Component;
+
+    /**
+     * @brief A reference to a component that does not keep it alive. Components owned by shared pointers
+     * are locked through a weak pointer, pooled components are resolved through their handle without
+     * touching a reference count.
+     */
+    struct ComponentLink
+    {
+        ComponentHandle handle;
+        std::weak_ptr<Component> owner;
+        bool is_shared = false;
+
+        /**
+         * @brief Create a link to a component.
+         *
+         * @param p_component The component, can be nullptr.
+         * @return ComponentLink The link to the component.
+         */
+        static ComponentLink Make(Component* p_component);
+
+        /**
+         * @brief Get the linked component. The result of a pooled component does not own it, pooled
+         * components live until every thread has finished the frame they are destroyed in.
+         *
+         * @return std::shared_ptr<Component> The component, nullptr if it is destroyed.
+         */
+        FORCE_INLINE std::shared_ptr<Component> Lock() const
+        {
+            if (is_shared)
+                return owner.lock();
+            return std::shared_ptr<Component>(std::shared_ptr<Component>(), ComponentRegistry::Get(handle));
+        }
+    };
+
+    template <typename T>
+    class ComponentPool;
 
     /**
      * @brief A Component is anything that can existed in the game.
@@ -17,13 +59,41 @@ namespace CrossEngine
     {
     private:
         std::string component_name;
+        StringId name_id;
         inline static Math::Mat4 identity = Math::Mat4();
 
         using WPComponent = std::weak_ptr<Component>;
-        WPComponent parent;
-        std::vector<WPComponent> children;
+        ComponentHandle handle;
+        ComponentLink parent;
+        std::vector<ComponentLink> children;
+        // The first child of every name, guarded by the children mutex.
+        std::unordered_map<StringId, ComponentLink> children_index;
         mutable std::shared_mutex children_mutex;
 
+        struct PathHash
+        {
+            using is_transparent = void;
+            size_t operator()(std::string_view p_path) const noexcept { return std::hash<std::string_view>()(p_path); }
+        };
+
+        // Incremented when a child is added, removed or renamed anywhere in the subtree.
+        std::atomic<uint64_t> structure_version = 0;
+        // Incremented when a transform, a visibility or a mesh changes anywhere in the subtree. A transform
+        // written through a reference counts once its subspace matrix is recomputed.
+        mutable std::atomic<uint64_t> content_version = 0;
+        // The resolved paths of the structure version path_cache_version, cleared when the structure changes.
+        std::unordered_map<std::string, ComponentLink, PathHash, std::equal_to<>> path_cache;
+        uint64_t path_cache_version = 0;
+        std::mutex path_cache_mutex;
+
+        void IncrementStructureVersion();
+        void IndexChildren();
+        template <typename T>
+        friend class ComponentPool;
+
+        // Detach the component from its parent and invalidate its handle, called by the pool destroying it.
+        void Retire();
+
         bool visible = true;
 
         bool activated = false;
@@ -35,6 +105,7 @@ namespace CrossEngine
         
         virtual void SetSubspaceMatrixDirty();
         void SetChildrenSubspaceMatrixDirty();
+        void IncrementContentVersion() const;
         void SetChildrenSubspaceMatrixInverseDirty();
 
         void Activate();
@@ -81,7 +152,14 @@ namespace CrossEngine
          * 
          * @param p_component_name The name of the component;
          */
-        FORCE_INLINE void SetName(const std::string& p_component_name) { component_name = p_component_name; }
+        void SetName(const std::string& p_component_name);
+
+        /**
+         * @brief Get the interned name of the component.
+         * 
+         * @return StringId The interned name of the component.
+         */
+        FORCE_INLINE StringId GetNameId() const noexcept { return name_id; }
 
         /**
          * @brief Remove a child from this component.
@@ -97,6 +175,20 @@ namespace CrossEngine
          */
         void AddChild(WPComponent p_child);
 
+        /**
+         * @brief Add a child to this component. Pooled components are added by pointer.
+         * 
+         * @param p_child The child to be added.
+         */
+        void AddChild(Component* p_child);
+
+        /**
+         * @brief Get the handle of this component.
+         * 
+         * @return const ComponentHandle& The handle of this component.
+         */
+        FORCE_INLINE const ComponentHandle& GetHandle() const noexcept { return handle; }
+
         /**
          * @brief Get the child of the corresponding name first appears.
          * 
@@ -104,19 +196,43 @@ namespace CrossEngine
          */
         std::shared_ptr<Component> GetChild(const std::string& p_child_name);
 
+        /**
+         * @brief Get the child of the corresponding interned name first appears.
+         * 
+         * @param p_child_name The interned name of the child.
+         * @return std::shared_ptr<Component> The child, nullptr if not found.
+         */
+        std::shared_ptr<Component> GetChild(StringId p_child_name);
+
+        /**
+         * @brief Get a descendant by the names of the components on the way to it, separated by '/'.
+         * The result is cached until a component is added, removed or renamed in the subtree.
+         * 
+         * @param p_path The path of the descendant, such as "level/room3/door".
+         * @return std::shared_ptr<Component> The descendant, nullptr if not found.
+         */
+        std::shared_ptr<Component> FindPath(std::string_view p_path);
+
         /**
          * @brief Get the parent of this component.
          * 
-         * @return WPComponent The parent of this component.
+         * @return std::shared_ptr<Component> The parent of this component, nullptr if it has no parent.
          */
-        const WPComponent GetParent() const { return parent; }
+        FORCE_INLINE std::shared_ptr<Component> GetParent() const { return parent.Lock(); }
 
         /**
-         * @brief Get the children of this component.
+         * @brief Get the living children of this component.
          * 
-         * @return const std::vector<Component*>& The children of this component.
+         * @return std::vector<std::shared_ptr<Component>> The children of this component.
          */
-        const std::vector<WPComponent>& GetChildren() const { return children; }
+        std::vector<std::shared_ptr<Component>> GetChildren() const;
+
+        /**
+         * @brief Call a function on every living child of this component.
+         * 
+         * @param p_func The function to call.
+         */
+        void ForEachChild(const std::function<void(const std::shared_ptr<Component>&)>& p_func) const;
 
         /**
          * @brief Get the subspace matrix of this component.
@@ -152,7 +268,23 @@ namespace CrossEngine
          * 
          * @param p_visible The visibility of the component.
          */
-        FORCE_INLINE void SetVisible(bool p_visible) { visible = p_visible; }
+        void SetVisible(bool p_visible);
+
+        /**
+         * @brief Get the version of the structure of the subtree. It changes when a child is added, removed
+         * or renamed anywhere in the subtree.
+         * 
+         * @return uint64_t The version of the structure.
+         */
+        FORCE_INLINE uint64_t GetStructureVersion() const noexcept { return structure_version.load(std::memory_order_acquire); }
+
+        /**
+         * @brief Get the version of the content of the subtree. It changes when a transform, a visibility or
+         * a mesh changes anywhere in the subtree.
+         * 
+         * @return uint64_t The version of the content.
+         */
+        FORCE_INLINE uint64_t GetContentVersion() const noexcept { return content_version.load(std::memory_order_acquire); }
 
         /**
          * @brief Exclude the context from drawing this component.
@@ -40,12 +40,20 @@ namespace CrossEngine
         FORCE_INLINE const Math::Vec4& GetPosition() const { return position; }
 
         /**
-         * @brief Get the reference of the position of the component.
+         * @brief Get the reference of the position of the component. A write through the reference changes
+         * the content version once the subspace matrix is recomputed, SetPosition changes it at once.
          * 
          * @return Math::Vec3& The reference of the position of the component.
          */
         Math::Vec4& Position();
 
+        /**
+         * @brief Set the position of the component.
+         * 
+         * @param p_position The position of the component.
+         */
+        void SetPosition(const Math::Vec4& p_position);
+
         /**
          * @brief Get the rotation of the component. The rotation
          * is ordered as pitch, yaw, roll.
@@ -62,6 +70,13 @@ namespace CrossEngine
          */
         Math::Vec4& Rotation();
 
+        /**
+         * @brief Set the rotation of the component as a quaternion.
+         * 
+         * @param p_rotation The rotation of the component.
+         */
+        void SetRotation(const Math::Vec4& p_rotation);
+
         /**
          * @brief Set the rotation of the component in Euler angle.
          * The rotation is ordered as pitch, yaw, roll.
@@ -125,6 +140,13 @@ namespace CrossEngine
          */
         Math::Vec4& Scale();
 
+        /**
+         * @brief Set the scale of the component.
+         * 
+         * @param p_scale The scale of the component.
+         */
+        void SetScale(const Math::Vec4& p_scale);
+
         /**
          * @brief Get the global position of this component.
          * 
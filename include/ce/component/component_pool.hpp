@@ -0,0 +1,216 @@
+#pragma once
+#include "ce/component/component.h"
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+
+namespace CrossEngine
+{
+    /**
+     * @brief Storage of components of a type, addressed by generational handles. The components are
+     * linked in the component tree by their handles, so walking pooled components does not touch
+     * reference counts.
+     * @details A destroyed component is detached from the tree at once, but its destructor only runs
+     * after every thread walking the tree has finished a frame, see ComponentRegistry::EndFrame.
+     *
+     * @tparam T The type of the components.
+     */
+    template <typename T>
+    class ComponentPool
+    {
+        static_assert(std::is_base_of_v<Component, T>, "The pooled type must be a component.");
+    public:
+        /**
+         * @brief The handle of a component in a pool.
+         */
+        struct Handle
+        {
+            uint32_t index = UINT32_MAX;
+            uint32_t generation = 0;
+
+            FORCE_INLINE bool IsValid() const noexcept { return index != UINT32_MAX; }
+            FORCE_INLINE bool operator==(const Handle& p_other) const noexcept = default;
+        };
+
+        static constexpr size_t CHUNK_SIZE = 1024;
+    private:
+        struct Slot
+        {
+            alignas(T) unsigned char storage[sizeof(T)];
+            uint32_t generation = 0;
+            uint32_t next_free = UINT32_MAX;
+            bool is_alive = false;
+            bool is_constructed = false;
+        };
+
+        struct PendingDestroy
+        {
+            uint32_t index;
+            size_t epoch;
+        };
+
+        // The chunks never move, so the components keep their addresses.
+        std::vector<std::unique_ptr<Slot[]>> chunks;
+        uint32_t slot_count = 0;
+        uint32_t free_head = UINT32_MAX;
+        size_t size = 0;
+        std::vector<PendingDestroy> pending_destroys;
+        mutable std::mutex pool_mutex;
+
+        FORCE_INLINE Slot& GetSlot(uint32_t p_index) const noexcept
+        {
+            return chunks[p_index / CHUNK_SIZE][p_index % CHUNK_SIZE];
+        }
+
+        FORCE_INLINE static T* GetObject(Slot& p_slot) noexcept
+        {
+            return std::launder(reinterpret_cast<T*>(p_slot.storage));
+        }
+
+        void DestroySlot(uint32_t p_index)
+        {
+            Slot& slot = GetSlot(p_index);
+            GetObject(slot)->~T();
+            slot.is_constructed = false;
+            slot.next_free = free_head;
+            free_head = p_index;
+        }
+
+        void CollectUnlocked()
+        {
+            size_t epoch = ComponentRegistry::GetEpoch();
+            std::erase_if(pending_destroys, [this, epoch](const PendingDestroy& p_pending) {
+                if (epoch < p_pending.epoch + 2)
+                    return false;
+                DestroySlot(p_pending.index);
+                return true;
+            });
+        }
+    public:
+        ComponentPool() = default;
+        ComponentPool(const ComponentPool&) = delete;
+        ComponentPool& operator=(const ComponentPool&) = delete;
+
+        /**
+         * @brief Destroy the pool and every component in it at once. No thread may walk the components
+         * of the pool anymore.
+         */
+        ~ComponentPool()
+        {
+            for (uint32_t i = 0; i < slot_count; ++i)
+            {
+                Slot& slot = GetSlot(i);
+                if (slot.is_alive)
+                    GetObject(slot)->Retire();
+            }
+            for (uint32_t i = 0; i < slot_count; ++i)
+            {
+                if (GetSlot(i).is_constructed)
+                    GetObject(GetSlot(i))->~T();
+            }
+        }
+
+        /**
+         * @brief Create a component.
+         *
+         * @param p_args The arguments of the constructor of the component.
+         * @return Handle The handle of the component.
+         */
+        template <typename... Args>
+        Handle Create(Args&&... p_args)
+        {
+            std::lock_guard<std::mutex> lock(pool_mutex);
+            CollectUnlocked();
+            uint32_t index;
+            if (free_head != UINT32_MAX)
+            {
+                index = free_head;
+                free_head = GetSlot(index).next_free;
+            }
+            else
+            {
+                index = slot_count++;
+                if (index / CHUNK_SIZE >= chunks.size())
+                    chunks.push_back(std::make_unique<Slot[]>(CHUNK_SIZE));
+            }
+            Slot& slot = GetSlot(index);
+            try
+            {
+                new (slot.storage) T(std::forward<Args>(p_args)...);
+            }
+            catch (...)
+            {
+                slot.next_free = free_head;
+                free_head = index;
+                throw;
+            }
+            slot.is_alive = true;
+            slot.is_constructed = true;
+            ++size;
+            return Handle{index, slot.generation};
+        }
+
+        /**
+         * @brief Get a component.
+         *
+         * @param p_handle The handle of the component.
+         * @return T* The component, nullptr if it is destroyed.
+         */
+        T* Get(const Handle& p_handle) const
+        {
+            std::lock_guard<std::mutex> lock(pool_mutex);
+            if (p_handle.index >= slot_count)
+                return nullptr;
+            Slot& slot = GetSlot(p_handle.index);
+            if (!slot.is_alive || slot.generation != p_handle.generation)
+                return nullptr;
+            return GetObject(slot);
+        }
+
+        /**
+         * @brief Destroy a component. The component is removed from its parent at once, and destroyed
+         * once no thread can be using it. Destroying a stale handle is ignored.
+         *
+         * @param p_handle The handle of the component.
+         */
+        void Destroy(const Handle& p_handle)
+        {
+            std::lock_guard<std::mutex> lock(pool_mutex);
+            if (p_handle.index >= slot_count)
+                return;
+            Slot& slot = GetSlot(p_handle.index);
+            if (!slot.is_alive || slot.generation != p_handle.generation)
+                return;
+            GetObject(slot)->Leave();
+            GetObject(slot)->Retire();
+            slot.is_alive = false;
+            ++slot.generation;
+            --size;
+            pending_destroys.push_back(PendingDestroy{p_handle.index, ComponentRegistry::GetEpoch()});
+            CollectUnlocked();
+        }
+
+        /**
+         * @brief Run the destructors of the destroyed components that no thread can be using anymore.
+         * Also done when components are created or destroyed.
+         */
+        void Collect()
+        {
+            std::lock_guard<std::mutex> lock(pool_mutex);
+            CollectUnlocked();
+        }
+
+        /**
+         * @brief Get the number of living components.
+         *
+         * @return size_t The number of living components.
+         */
+        size_t Size() const
+        {
+            std::lock_guard<std::mutex> lock(pool_mutex);
+            return size;
+        }
+    };
+}
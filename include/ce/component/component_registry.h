@@ -0,0 +1,132 @@
+#pragma once
+#include "ce/defs.hpp"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <cstdint>
+
+namespace CrossEngine
+{
+    class Component;
+
+    /**
+     * @brief A generational handle of a component. The handle of a destroyed component never resolves
+     * to a component created afterwards.
+     */
+    struct ComponentHandle
+    {
+        uint32_t index = UINT32_MAX;
+        uint32_t generation = 0;
+
+        FORCE_INLINE bool IsValid() const noexcept { return index != UINT32_MAX; }
+        FORCE_INLINE bool operator==(const ComponentHandle& p_other) const noexcept = default;
+    };
+
+    /**
+     * @brief Maps the handles of the living components to the components. Resolving a handle only reads
+     * atomics, so the component tree can be walked from every window thread without reference counting.
+     * @details The registry also keeps the frame epoch used to delay the destruction of pooled components
+     * until every thread walking the tree has finished a frame.
+     */
+    class ComponentRegistry
+    {
+    private:
+        ComponentRegistry() = delete;
+
+        static constexpr size_t CHUNK_SIZE = 4096;
+        static constexpr size_t MAX_CHUNK_COUNT = 4096;
+
+        struct Slot
+        {
+            std::atomic<Component*> component = nullptr;
+            std::atomic<uint32_t> generation = 0;
+            uint32_t next_free = UINT32_MAX;
+        };
+
+        // The slots never move, the chunks are only allocated.
+        inline static std::atomic<Slot*> chunks[MAX_CHUNK_COUNT] = {};
+        inline static std::unique_ptr<Slot[]> chunk_storage[MAX_CHUNK_COUNT];
+        inline static uint32_t slot_count = 0;
+        inline static uint32_t free_head = UINT32_MAX;
+        inline static size_t component_count = 0;
+        inline static std::mutex registry_mutex;
+
+        // An epoch ends when every thread has finished a frame.
+        inline static std::set<const void*> threads;
+        inline static std::set<const void*> finished_threads;
+        inline static std::atomic<size_t> epoch = 0;
+        inline static std::mutex epoch_mutex;
+
+    public:
+
+        /**
+         * @brief Register a component.
+         *
+         * @param p_component The component.
+         * @throw std::runtime_error Too many components.
+         * @return ComponentHandle The handle of the component.
+         */
+        static ComponentHandle Register(Component* p_component);
+
+        /**
+         * @brief Unregister a component. Unregistering a stale handle is ignored.
+         *
+         * @param p_handle The handle of the component.
+         */
+        static void Unregister(const ComponentHandle& p_handle);
+
+        /**
+         * @brief Get the component of a handle.
+         *
+         * @param p_handle The handle of the component.
+         * @return Component* The component, nullptr if it is unregistered.
+         */
+        FORCE_INLINE static Component* Get(const ComponentHandle& p_handle) noexcept
+        {
+            if (p_handle.index >= CHUNK_SIZE * MAX_CHUNK_COUNT)
+                return nullptr;
+            Slot* chunk = chunks[p_handle.index / CHUNK_SIZE].load(std::memory_order_acquire);
+            if (chunk == nullptr)
+                return nullptr;
+            Slot& slot = chunk[p_handle.index % CHUNK_SIZE];
+            if (slot.generation.load(std::memory_order_acquire) != p_handle.generation)
+                return nullptr;
+            Component* component = slot.component.load(std::memory_order_acquire);
+            // The slot may be reused between the loads.
+            if (slot.generation.load(std::memory_order_acquire) != p_handle.generation)
+                return nullptr;
+            return component;
+        }
+
+        /**
+         * @brief Called by a thread walking the component tree when it finishes a frame. The thread is
+         * registered on the first call.
+         *
+         * @param p_thread The owner of the thread, such as a window.
+         */
+        static void EndFrame(const void* p_thread);
+
+        /**
+         * @brief Called when a thread stops walking the component tree.
+         *
+         * @param p_thread The owner of the thread.
+         */
+        static void RemoveThread(const void* p_thread);
+
+        /**
+         * @brief Get the current frame epoch. A component retired in an epoch is no longer used by any
+         * thread two epochs later.
+         *
+         * @return size_t The current epoch.
+         */
+        FORCE_INLINE static size_t GetEpoch() noexcept { return epoch.load(std::memory_order_acquire); }
+
+        /**
+         * @brief Get the number of registered components.
+         *
+         * @return size_t The number of registered components.
+         */
+        static size_t GetComponentCount();
+    };
+}
@@ -1,27 +1,137 @@
 #pragma once
 #include <vector>
+#include <map>
 #include <mutex>
+#include <future>
 #include "ce/component/visual_mesh.h"
 #include "ce/geometry/triangle.h"
 #include "ce/graphics/window.h"
+#include "ce/utils/radix_sort.h"
 
 namespace CrossEngine
 {
     class DynamicMesh : public VisualMesh
     {
+    public:
+        /**
+         * @brief A triangle of a dynamic mesh being modified. The triangles of the mesh are locked while the
+         * edit exists, so the draws never upload a partly written triangle, and the triangle is marked to be
+         * uploaded again when the edit is destroyed.
+         * @note Other methods of the mesh must not be called while the edit exists.
+         */
+        class TriangleEdit
+        {
+        private:
+            friend class DynamicMesh;
+            DynamicMesh* mesh;
+            size_t index;
+            std::unique_lock<std::mutex> lock;
+
+            TriangleEdit(DynamicMesh& p_mesh, size_t p_index);
+        public:
+            TriangleEdit(TriangleEdit&& p_other) noexcept = default;
+            TriangleEdit(const TriangleEdit& p_other) = delete;
+            TriangleEdit& operator=(const TriangleEdit& p_other) = delete;
+
+            /**
+             * @brief Mark the triangle modified and unlock the triangles of the mesh.
+             */
+            ~TriangleEdit();
+
+            FORCE_INLINE Triangle& operator*() const noexcept { return *mesh->triangles[index]; }
+            FORCE_INLINE Triangle* operator->() const noexcept { return mesh->triangles[index]; }
+        };
+
     private:
         std::vector<Triangle*> triangles;
-        bool triangles_dirty = true;
+        bool centers_dirty = true;
         mutable std::mutex triangles_mutex;
 
-        void SetTrianglesDirty(bool p_dirty);
+        // Number of frames a region of the streaming buffer stays in flight.
+        static constexpr size_t STREAM_REGION_COUNT = 3;
+
+        // The vertex buffers are shared by the contexts. Triangle ranges [first, last) changed
+        // since the last upload to the vertex buffer of the base.
+        std::vector<std::pair<size_t, size_t>> dirty_ranges;
+        size_t uploaded_triangle_count = 0;
+
+        bool is_streaming = false;
+        bool is_stream_dirty = true;
+        unsigned int stream_vbo = 0;
+        size_t stream_capacity = 0;
+        size_t stream_region = 0;
+        // The whole ring mapped once when buffer storage is supported, otherwise null and each region is
+        // mapped for its write.
+        void* stream_mapping = nullptr;
+        // Changed when the ring is replaced by a new buffer, so the VAOs of the contexts are pointed at it.
+        size_t stream_generation = 0;
+
+        /**
+         * @brief The VAOs, the fences and the back to front triangle order of a context.
+         */
+        struct ContextState
+        {
+            GPUResourceRegistry::Handle stream_vao;
+            size_t stream_vao_generation = 0;
+            void* stream_fences[STREAM_REGION_COUNT] = {};
+
+            GPUResourceRegistry::Handle ebo;
+            size_t ebo_index_count = 0;
+            bool order_dirty = true;
+            std::vector<uint32_t> order;
+            Math::Vec4 camera_position;
+            Math::Mat4 subspace_matrix;
+        };
+        std::map<Window*, ContextState> context_states;
+
+        // Object space triangle centers, stored as all x, then all y, then all z.
+        std::vector<float> centers;
+        std::vector<uint32_t> sort_keys;
+        std::vector<uint32_t> sort_values;
+        RadixSortBuffers sort_buffers;
+        std::vector<float> upload_buffer;
+        float sort_distance_threshold = 0.01f;
+
+        void SetAllTrianglesDirty();
+        void ResetUploadState();
+        void UpdateCenters();
+        bool UpdateVertexBuffer(Window* p_context);
+        bool StreamVertices(Window* p_context, ContextState& p_state);
+        void AllocateStreamBuffer(size_t p_size);
+        void BindStreamVAO(Window* p_context, ContextState& p_state);
+        bool UpdateSortOrder(Window* p_context, ContextState& p_state);
     protected:
+
+        /**
+         * @brief Fill the vertex buffer with the vertices of the mesh. Called with the triangles locked.
+         * 
+         * @param p_context The context the vertex buffer is created in.
+         */
+        virtual void UploadVertexBuffer(Window* p_context) override;
+
+        /**
+         * @brief Get the vertex buffer the VAOs read from, creating it on the first call. The triangles are
+         * locked, as they guard the upload fence the draws replace.
+         * 
+         * @param p_context The context the vertex buffer is used in.
+         * @return unsigned int The vertex buffer.
+         */
+        virtual unsigned int AcquireVertexBuffer(Window* p_context) override;
         
         /**
-         * @brief Draw the mesh.
+         * @brief Issue the draw call of the mesh. Triangles of prioritized materials
+         * are drawn back to front through an index buffer.
          * 
+         * @param p_context The context to draw the mesh in.
          */
-        virtual void Draw(Window* p_context) override;
+        virtual void DrawMesh(Window* p_context) override;
+
+        /**
+         * @brief Build the BVH over the triangles, locked so a load cannot free them meanwhile.
+         * 
+         * @return std::shared_ptr<TriangleBVH> The BVH in object space.
+         */
+        virtual std::shared_ptr<TriangleBVH> CreateBVH() override;
     public:
 
         /**
@@ -67,14 +177,65 @@ namespace CrossEngine
         virtual float GetPriority(Window* p_context) const override;
 
         /**
-         * @brief Get the triangles of this mesh.
+         * @brief Get the distance the camera needs to move before the triangles are sorted again.
+         * 
+         * @return float The distance.
+         */
+        FORCE_INLINE float GetSortDistanceThreshold() const noexcept { return sort_distance_threshold; }
+
+        /**
+         * @brief Set the distance the camera needs to move before the triangles are sorted again.
+         * The triangles are always sorted again when the subspace matrix changes.
+         * 
+         * @param p_threshold The distance.
+         */
+        FORCE_INLINE void SetSortDistanceThreshold(float p_threshold) noexcept { sort_distance_threshold = p_threshold; }
+
+        /**
+         * @brief Get the triangles of this mesh. Every triangle is uploaded again on the next draw.
          * 
          * @return std::vector<Triangle*>& The triangles of this mesh.
          */
         std::vector<Triangle*>& Triangles();
 
         /**
-         * @brief Get the triangles.
+         * @brief Modify a triangle of this mesh. Only this triangle is uploaded again on the next draw.
+         * 
+         * @param p_index The index of the triangle.
+         * @throw std::out_of_range The index is out of range.
+         * @return TriangleEdit The edit of the triangle, the triangle is marked modified when it is destroyed.
+         */
+        TriangleEdit EditTriangle(size_t p_index);
+
+        /**
+         * @brief Mark a range of triangles as modified, so that only they are uploaded on the next draw.
+         * 
+         * @param p_first The index of the first modified triangle.
+         * @param p_count The number of modified triangles.
+         */
+        void SetTrianglesDirty(size_t p_first, size_t p_count);
+
+        /**
+         * @brief Is the mesh streamed through a ring of buffers.
+         * 
+         * @return true if the mesh is streamed.
+         * @return false if the mesh is updated in place.
+         */
+        FORCE_INLINE bool IsStreaming() const noexcept { return is_streaming; }
+
+        /**
+         * @brief Set whether the mesh is streamed. A streamed mesh is written to one of three
+         * regions of a buffer each time it changes, without waiting for the draws that still read
+         * the other regions. Use this for meshes that change every frame. With buffer storage the buffer
+         * stays mapped, otherwise each region is mapped for its write.
+         * 
+         * @param p_streaming Should the mesh be streamed.
+         */
+        void SetStreaming(bool p_streaming);
+
+        /**
+         * @brief Get the triangles. Not locked, a load may free them while they are read from
+         * another thread, see EditTriangle and GetBVH.
          * 
          * @return const std::vector<Triangle*>& The triangles of the mesh.
          */
@@ -114,5 +275,18 @@ namespace CrossEngine
          * @param p_file The file to load the triangles from.
          */
         virtual void LoadTrisWithNormal(const std::string& p_file) override;
+
+        /**
+         * @brief Load the triangles from a model file in the background, with the loader of its extension or
+         * its mesh cache, see Resource::LoadModel. The current triangles are drawn until the new ones are
+         * parsed, then they are swapped in.
+         * @note The mesh must be owned by a shared pointer. If it is destroyed first, the parsed
+         * triangles are discarded.
+         * 
+         * @param p_file The file to load the triangles from.
+         * @throw std::bad_weak_ptr The mesh is not owned by a shared pointer.
+         * @return std::future<void> The future of the load, it rethrows the errors of the parser.
+         */
+        std::future<void> LoadTrianglesAsync(const std::string& p_file);
     };
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include "ce/component/component3D.h"
 #include "ce/graphics/shader/shader_program.h"
+#include "ce/graphics/gpu_resource_registry.h"
 #include <map>
 
 namespace CrossEngine
@@ -12,14 +13,21 @@ namespace CrossEngine
     private:
         const static float vertices[108];
 
-        std::map<Window*, unsigned int> vbos;
-        std::map<Window*, unsigned int> vaos;
-        std::map<Window*, unsigned int> texture_cube_ids;
+        // The buffer and the texture are shared by the contexts, only the VAOs are per context.
+        unsigned int vbo = 0;
+        unsigned int texture_cube_id = 0;
+        // Waited for by each context before it first draws the skybox.
+        void* vbo_fence = nullptr;
+        void* texture_fence = nullptr;
+        std::map<Window*, GPUResourceRegistry::Handle> vaos;
         mutable std::shared_mutex context_resource_mutex;
 
-        void SetupSkybox(unsigned int p_vao, unsigned int p_vbo, unsigned int p_texture_id);
+        // The faces decoded by the resource loader, shared with the upload queued to a window.
+        struct PendingFaces;
+        std::shared_ptr<PendingFaces> pending_faces;
 
-        std::vector<std::string> faces;
+        void SetupSkybox();
+        bool UpdateTexture(Window* p_context);
     protected:
 
         /**
@@ -30,10 +38,11 @@ namespace CrossEngine
     public:
 
         /**
-         * @brief Construct a new Skybox object.
+         * @brief Construct a new Skybox object. The faces are decoded in the background, and the skybox
+         * is drawn once they are uploaded by the thread of the first window drawing it.
          * 
-         * @param p_context The context of the skybox.
          * @param p_faces The path to the images of faces of the skybox.
+         * @throw std::runtime_error There are not 6 faces.
          */
         Skybox(const std::vector<std::string>& p_faces, const std::string& p_component_name = "skybox");
         
@@ -44,25 +53,20 @@ namespace CrossEngine
         virtual ~Skybox() override;
 
         /**
-         * @brief Set the texture of the skybox.
+         * @brief Load six faces to a texture cube. The faces are decoded in parallel, and the calling
+         * thread waits for them.
          * 
          * @param p_faces The pathes to the images of faces of the skybox.
+         * @param p_texture_id The texture cube.
          */
         void SetSkyboxTexture(const std::vector<std::string>& p_faces, unsigned int p_texture_id);
 
         /**
-         * @brief Get the texture cube of the skybox.
+         * @brief Get the texture cube of the skybox, shared by every context.
          * 
-         * @return std::map<Window*, unsigned int> The texture cube of the skybox.
+         * @return unsigned int The texture cube of the skybox, 0 if it is not uploaded yet.
          */
-        FORCE_INLINE std::map<Window*, unsigned int> GetTextureCubeIDs() noexcept { return texture_cube_ids; }
-
-        /**
-         * @brief Get the texture cube of the skybox.
-         * 
-         * @return std::map<Window*, unsigned int> The texture cube of the skybox.
-         */
-        FORCE_INLINE const std::map<Window*, unsigned int>& GetTextureCubeIDs() const noexcept { return texture_cube_ids; }
+        FORCE_INLINE unsigned int GetTextureCubeID() const noexcept { return texture_cube_id; }
 
         virtual bool RegisterDraw(Window* p_context) override;
     };
@@ -0,0 +1,98 @@
+#pragma once
+#include "ce/component/visual_mesh.h"
+#include "ce/graphics/mesh_data.h"
+
+namespace CrossEngine
+{
+    /**
+     * @brief A mesh whose triangles do not change after they are loaded. Copies of a static mesh
+     * share the mesh data, and the copies with the same material are drawn with a single instanced
+     * draw call.
+     */
+    class StaticMesh : public VisualMesh
+    {
+    private:
+        std::shared_ptr<MeshData> mesh_data;
+
+        void SetMeshData(std::shared_ptr<MeshData> p_mesh_data);
+    protected:
+
+        /**
+         * @brief Get the vertex buffer of the mesh data.
+         *
+         * @param p_context The context the vertex buffer is used in.
+         * @return unsigned int The vertex buffer.
+         */
+        virtual unsigned int AcquireVertexBuffer(Window* p_context) override;
+
+        /**
+         * @brief Draw the vertices of the mesh data in the shared vertex buffer.
+         *
+         * @param p_context The context to draw the mesh in.
+         */
+        virtual void DrawMesh(Window* p_context) override;
+    public:
+
+        /**
+         * @brief Construct a new static mesh.
+         *
+         * @param p_component_name The name of the component.
+         */
+        explicit StaticMesh(const std::string& p_component_name = "static mesh");
+
+        /**
+         * @brief Construct a new static mesh.
+         *
+         * @param p_mesh_data The mesh data to draw.
+         * @param p_component_name The name of the component.
+         */
+        explicit StaticMesh(std::shared_ptr<MeshData> p_mesh_data, const std::string& p_component_name = "static mesh");
+
+        /**
+         * @brief Copy constructor for StaticMesh. The copy shares the mesh data.
+         */
+        StaticMesh(const StaticMesh& p_other);
+
+        /**
+         * @brief Get the mesh data of this mesh.
+         *
+         * @return const std::shared_ptr<MeshData>& The mesh data of this mesh.
+         */
+        FORCE_INLINE const std::shared_ptr<MeshData>& GetMeshData() const noexcept { return mesh_data; }
+
+        /**
+         * @brief Register the mesh to the draw list. Meshes of non-prioritized materials are
+         * added to the instance batch of their mesh data and material.
+         *
+         * @param p_context The context to register the mesh to.
+         */
+        virtual bool RegisterDraw(Window* p_context) override;
+
+        virtual size_t GetVertexCount() const override { return mesh_data->GetVertexCount(); }
+
+        virtual const std::vector<Triangle*>& GetTriangles() override { return mesh_data->GetTriangles(); }
+
+        virtual std::shared_ptr<const TriangleBVH> GetBVH() override { return mesh_data->GetBVH(); }
+
+        /**
+         * @brief Load the triangles into new mesh data.
+         *
+         * @param p_triangles The triangles to load.
+         */
+        virtual void LoadTriangles(std::vector<Triangle*>&& p_triangles) override;
+
+        /**
+         * @brief Load the triangles from a file into new mesh data.
+         *
+         * @param p_file The file to load the triangles from.
+         */
+        virtual void LoadTriangles(const std::string& p_file) override;
+
+        /**
+         * @brief Load the triangles from a file into new mesh data.
+         *
+         * @param p_file The file to load the triangles from.
+         */
+        virtual void LoadTrisWithNormal(const std::string& p_file) override;
+    };
+}
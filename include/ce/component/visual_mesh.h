@@ -1,5 +1,7 @@
 #pragma once
 #include "ce/component/component3D.h"
+#include "ce/geometry/bvh.h"
+#include "ce/graphics/gpu_resource_registry.h"
 #include <map>
 
 namespace CrossEngine
@@ -9,24 +11,67 @@ namespace CrossEngine
     class VisualMesh : public Component3D
     {
     protected:
-        std::map<Window*, unsigned int> vaos;
-        std::map<Window*, unsigned int> vbos;
+        // The vertex buffer is shared by the contexts, only the VAOs are per context.
+        std::map<Window*, GPUResourceRegistry::Handle> vaos;
+        unsigned int vbo = 0;
+        // Waited for by the other contexts before they draw the vertex buffer.
+        void* upload_fence = nullptr;
         mutable std::shared_mutex context_resource_mutex;
-        void UpdateVAO(const std::vector<Triangle*>& p_triangles, unsigned int p_vao, unsigned int p_vbo);
+
+        /**
+         * @brief Fill the vertex buffer with the vertices of the mesh. Called once when the vertex buffer is
+         * created, with the vertex buffer bound.
+         * 
+         * @param p_context The context the vertex buffer is created in.
+         */
+        virtual void UploadVertexBuffer(Window* p_context);
+
+        /**
+         * @brief Get the vertex buffer the VAOs read from, creating it on the first call.
+         * 
+         * @param p_context The context the vertex buffer is used in.
+         * @return unsigned int The vertex buffer.
+         */
+        virtual unsigned int AcquireVertexBuffer(Window* p_context);
 
         std::shared_ptr<AMaterial> material;
+        bool is_static = false;
+
+        std::shared_ptr<TriangleBVH> bvh;
+        bool bvh_dirty = true;
+        mutable std::mutex bvh_mutex;
+
+        /**
+         * @brief Mark the BVH of this mesh to be rebuilt on the next query.
+         */
+        void SetBVHDirty();
+
+        /**
+         * @brief Build the BVH over the current triangles. Called by GetBVH with the BVH locked.
+         * 
+         * @return std::shared_ptr<TriangleBVH> The BVH in object space.
+         */
+        virtual std::shared_ptr<TriangleBVH> CreateBVH();
 
         /**
          * @brief Draw the mesh.
          * 
          */
         virtual void Draw(Window* p_context);
+
+        /**
+         * @brief Issue the draw call of the mesh. The VAO of the context is bound and
+         * the uniforms are set when this is called.
+         * 
+         * @param p_context The context to draw the mesh in.
+         */
+        virtual void DrawMesh(Window* p_context);
     public:
         VisualMesh(const std::string& p_component_name = "visual mesh");
         ~VisualMesh();
 
         VisualMesh(const VisualMesh& p_other) 
-            : Component3D(p_other) {};
+            : Component3D(p_other), material(p_other.material), is_static(p_other.is_static) {};
 
         VisualMesh(VisualMesh&& p_other) noexcept;
 
@@ -51,6 +96,23 @@ namespace CrossEngine
          */
         FORCE_INLINE void SetMaterial(std::shared_ptr<AMaterial> p_material) { material = p_material; } 
 
+        /**
+         * @brief Is this mesh static. Static meshes of non-prioritized materials are merged into
+         * world space batches by the renderer.
+         * 
+         * @return true if the mesh is static.
+         * @return false if the mesh is drawn on its own.
+         */
+        FORCE_INLINE bool IsStatic() const noexcept { return is_static; }
+
+        /**
+         * @brief Set whether this mesh is static. The transform and the triangles of a static mesh are
+         * expected not to change; set the mesh to non-static for a frame to rebuild its batch.
+         * 
+         * @param p_static Should the mesh be static.
+         */
+        FORCE_INLINE void SetStatic(bool p_static) noexcept { is_static = p_static; }
+
         /**
          * @brief Register the current mesh to the draw list.
          * 
@@ -64,7 +126,7 @@ namespace CrossEngine
          * @param p_context The context to get the priority for.
          * @return float The priority of drawing this mesh
          */
-        virtual float GetPriority(Window* p_context) const { return 0.0f; }
+        virtual float GetPriority(Window*) const { return 0.0f; }
 
         /**
          * @brief Return the vao corresponding to the context
@@ -74,11 +136,11 @@ namespace CrossEngine
         unsigned int GetVAO(Window* p_context) const;
 
         /**
-         * @brief Return the vbo corresponding to the context
+         * @brief Return the vbo shared by every context.
          * 
-         * @return unsigned int the corresponding vbo
+         * @return unsigned int The vbo, 0 if the mesh is not drawn yet.
          */
-        unsigned int GetVBO(Window* p_context) const;
+        FORCE_INLINE unsigned int GetVBO() const noexcept { return vbo; }
 
         /**
          * @brief Get the vertex count of this mesh.
@@ -109,5 +171,47 @@ namespace CrossEngine
         virtual void LoadTrisWithNormal(const std::string& p_file) = 0;
 
         virtual const std::vector<Triangle*>& GetTriangles() = 0;
+
+        /**
+         * @brief Get the BVH of this mesh. The BVH is built lazily and rebuilt
+         * after the triangles are changed.
+         * @note Triangle indices reported by the BVH refer to the triangle order
+         * at the time it was built.
+         * @return std::shared_ptr<const TriangleBVH> The BVH in object space.
+         */
+        virtual std::shared_ptr<const TriangleBVH> GetBVH();
+
+        /**
+         * @brief Intersect a global ray with this mesh.
+         * 
+         * @param p_origin The global origin of the ray.
+         * @param p_direction The global direction of the ray.
+         * @param p_hit This will be set to the closest hit.
+         * @param p_max_distance The maximum distance along the ray.
+         * @return true The ray hits the mesh.
+         * @return false The ray does not hit the mesh.
+         */
+        bool Intersect(const Math::Vec4& p_origin, const Math::Vec4& p_direction, RayHit& p_hit,
+            float p_max_distance = std::numeric_limits<float>::infinity());
+
+        /**
+         * @brief Get the closest global position on this mesh to a point.
+         * 
+         * @param p_point The global point of interest.
+         * @param p_result This will be set to the closest position.
+         * @return true A position is found.
+         * @return false The mesh is empty.
+         */
+        bool GetClosestPosition(const Math::Vec4& p_point, ClosestHit& p_result);
+
+        /**
+         * @brief Find the triangles of this mesh overlapping a global sphere.
+         * 
+         * @param p_center The global center of the sphere.
+         * @param p_radius The radius of the sphere.
+         * @param p_result The indices of the overlapping triangles will be pushed back to this vector.
+         * @return size_t The number of overlapping triangles.
+         */
+        size_t OverlapSphere(const Math::Vec4& p_center, float p_radius, std::vector<size_t>& p_result);
     };
 }
\ No newline at end of file
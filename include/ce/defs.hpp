@@ -16,6 +16,10 @@
     #define FORCE_INLINE inline
 #endif
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define CE_SIMD_SSE2 1
+#endif
+
 namespace CrossEngine
 {
     using byte_t = char;
@@ -1,5 +1,6 @@
 #pragma once
 #include "ce/math/math.hpp"
+#include "ce/game/scene_bvh.h"
 #include <memory>
 #include <mutex>
 #include <set>
@@ -25,6 +26,7 @@ namespace CrossEngine
         std::shared_ptr<Component> base_component;
         std::set<Window*> available_contexts;
         std::mutex available_context_mutex;
+        std::shared_ptr<SceneBVH> scene_bvh;
     public:
 
         /**
@@ -159,6 +161,62 @@ namespace CrossEngine
          */
         void RegisterEvent(std::shared_ptr<AEvent> p_event);
 
+        /**
+         * @brief Get the ray through a cursor position of a window.
+         * 
+         * @param p_window The window, its projection matrix and camera are used.
+         * @param p_cursor_position The cursor position in window coordinates, as reported by OnMouseMoveEvent.
+         * @return Ray The global ray starting on the near plane, with a normalized direction.
+         */
+        static Ray ScreenPointToRay(const Window* p_window, const Math::Vector<double, 2>& p_cursor_position);
+
+        /**
+         * @brief Cast a ray against the visual meshes of the scene and get the closest hit.
+         * 
+         * @param p_origin The global origin of the ray.
+         * @param p_direction The global direction of the ray.
+         * @param p_hit This will be set to the closest hit.
+         * @param p_max_distance The maximum distance along the ray.
+         * @return true The ray hits a mesh.
+         * @return false The ray does not hit any mesh.
+         */
+        bool RayCast(const Math::Vec4& p_origin, const Math::Vec4& p_direction, RayCastHit& p_hit,
+            float p_max_distance = std::numeric_limits<float>::infinity());
+
+        /**
+         * @brief Cast a ray through a cursor position against the visual meshes of the scene.
+         * 
+         * @param p_window The window the cursor is in.
+         * @param p_cursor_position The cursor position in window coordinates, as reported by OnMouseMoveEvent.
+         * @param p_hit This will be set to the closest hit.
+         * @return true The ray hits a mesh.
+         * @return false The ray does not hit any mesh.
+         */
+        bool RayCast(const Window* p_window, const Math::Vector<double, 2>& p_cursor_position, RayCastHit& p_hit);
+
+        /**
+         * @brief Cast a batch of rays against the visual meshes of the scene.
+         * 
+         * @param p_rays The global rays.
+         * @param p_hits This will be set to the closest hit of each ray. The mesh of a hit
+         * is nullptr if the ray hits nothing.
+         * @param p_max_distance The maximum distance along the rays.
+         * @return size_t The number of rays that hit a mesh.
+         */
+        size_t RayCast(const std::vector<Ray>& p_rays, std::vector<RayCastHit>& p_hits,
+            float p_max_distance = std::numeric_limits<float>::infinity());
+
+        /**
+         * @brief Cast a ray against the visual meshes of the scene and get the closest hit of every mesh that is hit.
+         * 
+         * @param p_origin The global origin of the ray.
+         * @param p_direction The global direction of the ray.
+         * @param p_max_distance The maximum distance along the ray.
+         * @return std::vector<RayCastHit> The hits sorted by distance.
+         */
+        std::vector<RayCastHit> RayCastAll(const Math::Vec4& p_origin, const Math::Vec4& p_direction,
+            float p_max_distance = std::numeric_limits<float>::infinity());
+
         /**
          * @brief Run the game.
          * 
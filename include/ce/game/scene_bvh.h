@@ -0,0 +1,117 @@
+#pragma once
+#include "ce/geometry/bvh.h"
+#include "ce/component/component.h"
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace CrossEngine
+{
+    class Component;
+    class VisualMesh;
+
+    /**
+     * @brief The result of a ray cast against the scene.
+     */
+    struct RayCastHit
+    {
+        /**
+         * @brief The mesh that is hit, nullptr if nothing is hit.
+         */
+        std::shared_ptr<VisualMesh> mesh;
+
+        /**
+         * @brief The global position of the hit.
+         */
+        Math::Vec4 position = Math::Pos();
+
+        /**
+         * @brief The distance along the ray, in units of the ray direction.
+         */
+        float distance = std::numeric_limits<float>::infinity();
+
+        /**
+         * @brief The index of the hit triangle in the mesh.
+         */
+        size_t triangle_index = 0;
+
+        /**
+         * @brief The barycentric coordinates of the hit.
+         */
+        float u = 0.0f;
+        float v = 0.0f;
+    };
+
+    /**
+     * @brief Two level acceleration structure over the visual meshes of the scene.
+     * @details Every visual mesh contributes its lazily built object space BVH as an
+     * instance of a top level BVH. The top level BVH is rebuilt when the set of meshes
+     * changes and refit when only their subspace matrices change. The scene is only walked
+     * again when the structure or the content version of the root has changed.
+     */
+    class SceneBVH
+    {
+    private:
+        std::vector<ComponentLink> meshes;
+        std::vector<std::shared_ptr<const TriangleBVH>> mesh_bvhs;
+        InstanceBVH instance_bvh;
+        ComponentLink root;
+        uint64_t structure_version = 0;
+        uint64_t content_version = 0;
+        mutable std::mutex scene_mutex;
+
+        void CollectMeshes(const std::shared_ptr<Component>& p_component,
+            std::vector<std::shared_ptr<VisualMesh>>& p_result) const;
+        void Update(const std::shared_ptr<Component>& p_root);
+        RayCastHit CreateHit(const InstanceHit& p_hit, const Ray& p_ray) const;
+
+    public:
+        SceneBVH() = default;
+        SceneBVH(const SceneBVH&) = delete;
+        SceneBVH& operator=(const SceneBVH&) = delete;
+
+        /**
+         * @brief Get the number of meshes in the structure after the last query.
+         * 
+         * @return size_t The number of meshes.
+         */
+        size_t GetMeshCount() const;
+
+        /**
+         * @brief Cast a ray against the scene and get the closest hit.
+         * 
+         * @param p_root The root component of the scene.
+         * @param p_ray The global ray.
+         * @param p_hit This will be set to the closest hit.
+         * @param p_max_distance The maximum distance along the ray.
+         * @return true The ray hits a mesh.
+         * @return false The ray does not hit any mesh.
+         */
+        bool RayCast(const std::shared_ptr<Component>& p_root, const Ray& p_ray, RayCastHit& p_hit,
+            float p_max_distance = std::numeric_limits<float>::infinity());
+
+        /**
+         * @brief Cast a ray against the scene and get the closest hit of every mesh that is hit.
+         * 
+         * @param p_root The root component of the scene.
+         * @param p_ray The global ray.
+         * @param p_max_distance The maximum distance along the ray.
+         * @return std::vector<RayCastHit> The hits sorted by distance.
+         */
+        std::vector<RayCastHit> RayCastAll(const std::shared_ptr<Component>& p_root, const Ray& p_ray,
+            float p_max_distance = std::numeric_limits<float>::infinity());
+
+        /**
+         * @brief Cast a batch of rays against the scene. The rays are traced in SIMD packets.
+         * 
+         * @param p_root The root component of the scene.
+         * @param p_rays The global rays.
+         * @param p_hits This will be resized to the count of rays and set to the closest
+         * hit of each ray. The mesh of a hit is nullptr if the ray hits nothing.
+         * @param p_max_distance The maximum distance along the rays.
+         * @return size_t The number of rays that hit a mesh.
+         */
+        size_t RayCast(const std::shared_ptr<Component>& p_root, const std::vector<Ray>& p_rays,
+            std::vector<RayCastHit>& p_hits, float p_max_distance = std::numeric_limits<float>::infinity());
+    };
+}
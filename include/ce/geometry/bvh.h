@@ -0,0 +1,451 @@
+#pragma once
+#include "ce/geometry/triangle.h"
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <limits>
+
+namespace CrossEngine
+{
+    /**
+     * @brief A ray with an origin and a direction.
+     */
+    struct Ray
+    {
+        Math::Vec4 origin = Math::Pos();
+        Math::Vec4 direction = Math::FRONT<4>;
+    };
+
+    /**
+     * @brief A packet of rays traced together, stored as structure of arrays.
+     * @details Lanes whose distance is negative are inactive. The distance of each
+     * lane is the maximum distance on input, and it is updated on hit.
+     */
+    struct RayPacket
+    {
+        static constexpr size_t SIZE = 4;
+
+        alignas(16) float origin[3][SIZE];
+        alignas(16) float direction[3][SIZE];
+        alignas(16) float distance[SIZE];
+        alignas(16) float u[SIZE];
+        alignas(16) float v[SIZE];
+        uint32_t triangle_index[SIZE];
+    };
+
+    /**
+     * @brief The result of a ray query against a BVH.
+     */
+    struct RayHit
+    {
+        /**
+         * @brief The distance along the ray, in units of the ray direction.
+         */
+        float distance = std::numeric_limits<float>::infinity();
+
+        /**
+         * @brief The barycentric coordinates of the hit.
+         */
+        float u = 0.0f;
+        float v = 0.0f;
+
+        /**
+         * @brief The index of the hit triangle in the source triangle list.
+         */
+        size_t triangle_index = 0;
+    };
+
+    /**
+     * @brief The result of a closest point query against a BVH.
+     */
+    struct ClosestHit
+    {
+        /**
+         * @brief The closest position on the mesh.
+         */
+        Math::Vec4 position = Math::Pos();
+
+        /**
+         * @brief The squared distance to the closest position.
+         */
+        float distance_squared = std::numeric_limits<float>::infinity();
+
+        /**
+         * @brief The index of the closest triangle in the source triangle list.
+         */
+        size_t triangle_index = 0;
+    };
+
+    /**
+     * @brief A bounding volume hierarchy over the triangles of a mesh.
+     * @details The hierarchy is built in object space with a binned SAH and stored in
+     * a flattened node array. Large meshes are built in parallel. Instance queries take
+     * the subspace matrix of the mesh and transform the query into object space.
+     */
+    class TriangleBVH
+    {
+    public:
+        /**
+         * @brief A node of the hierarchy. Interior nodes store the index of their
+         * left child, the right child is always next to it. Leaf nodes store the
+         * first triangle and the triangle count.
+         */
+        struct Node
+        {
+            float min[3];
+            uint32_t left_first;
+            float max[3];
+            uint32_t count;
+
+            FORCE_INLINE bool IsLeaf() const noexcept { return count != 0; }
+        };
+
+        /**
+         * @brief The maximum triangle count of a leaf.
+         */
+        static constexpr uint32_t MAX_LEAF_SIZE = 4;
+
+        /**
+         * @brief The number of bins used for the SAH.
+         */
+        static constexpr uint32_t BIN_COUNT = 16;
+
+        /**
+         * @brief Nodes with more triangles than this are built on a separate thread.
+         */
+        static constexpr uint32_t PARALLEL_BUILD_THRESHOLD = 1 << 16;
+
+    private:
+        std::vector<Node> nodes;
+
+        // Triangle data in leaf order: v0, edge1, edge2.
+        std::vector<float> tri_data;
+        std::vector<uint32_t> tri_indices;
+
+        bool IntersectObjectSpace(const float* p_origin, const float* p_direction, RayHit& p_hit) const;
+        void GetTriangleVertices(uint32_t p_leaf_index, Math::Vec4& p_v0, Math::Vec4& p_v1, Math::Vec4& p_v2) const;
+
+    public:
+        TriangleBVH() = default;
+
+        /**
+         * @brief Construct a BVH over triangles.
+         *
+         * @param p_triangles The triangles to build the hierarchy from.
+         */
+        explicit TriangleBVH(const std::vector<Triangle*>& p_triangles);
+
+        /**
+         * @brief Construct a BVH over raw triangle positions.
+         *
+         * @param p_positions The positions of the triangles, 9 floats per triangle.
+         * @param p_triangle_count The number of triangles.
+         */
+        TriangleBVH(const float* p_positions, size_t p_triangle_count);
+
+        /**
+         * @brief Build the BVH over triangles.
+         *
+         * @param p_triangles The triangles to build the hierarchy from.
+         */
+        void Build(const std::vector<Triangle*>& p_triangles);
+
+        /**
+         * @brief Build the BVH over raw triangle positions.
+         *
+         * @param p_positions The positions of the triangles, 9 floats per triangle.
+         * @param p_triangle_count The number of triangles.
+         */
+        void Build(const float* p_positions, size_t p_triangle_count);
+
+        /**
+         * @brief Clear the hierarchy.
+         */
+        void Clear();
+
+        /**
+         * @brief Is the hierarchy empty.
+         *
+         * @return true The hierarchy contains no triangle.
+         * @return false The hierarchy contains triangles.
+         */
+        FORCE_INLINE bool IsEmpty() const noexcept { return tri_indices.empty(); }
+
+        /**
+         * @brief Get the number of triangles in the hierarchy.
+         *
+         * @return size_t The number of triangles.
+         */
+        FORCE_INLINE size_t GetTriangleCount() const noexcept { return tri_indices.size(); }
+
+        /**
+         * @brief Get the number of nodes in the hierarchy.
+         *
+         * @return size_t The number of nodes.
+         */
+        FORCE_INLINE size_t GetNodeCount() const noexcept { return nodes.size(); }
+
+        /**
+         * @brief Get the flattened nodes.
+         *
+         * @return const Node* The nodes, the root is the first one.
+         */
+        FORCE_INLINE const Node* GetNodes() const noexcept { return nodes.data(); }
+
+        /**
+         * @brief Get the object space bounds of the mesh.
+         *
+         * @param p_min This will be set to the minimum corner.
+         * @param p_max This will be set to the maximum corner.
+         */
+        void GetBounds(Math::Vec4& p_min, Math::Vec4& p_max) const;
+
+        /**
+         * @brief Intersect a ray with the mesh in object space.
+         *
+         * @param p_origin The origin of the ray.
+         * @param p_direction The direction of the ray. It does not need to be normalized.
+         * @param p_hit This will be set to the closest hit.
+         * @param p_max_distance The maximum distance along the ray.
+         * @return true The ray hits the mesh.
+         * @return false The ray does not hit the mesh.
+         */
+        bool Intersect(const Math::Vec4& p_origin, const Math::Vec4& p_direction, RayHit& p_hit,
+            float p_max_distance = std::numeric_limits<float>::infinity()) const;
+
+        /**
+         * @brief Intersect a global ray with an instance of the mesh.
+         * @note The hit distance is measured in units of the global direction.
+         * @param p_subspace_matrix The subspace matrix of the instance.
+         * @param p_origin The global origin of the ray.
+         * @param p_direction The global direction of the ray.
+         * @param p_hit This will be set to the closest hit.
+         * @param p_max_distance The maximum distance along the ray.
+         * @return true The ray hits the mesh.
+         * @return false The ray does not hit the mesh.
+         */
+        bool Intersect(const Math::Mat4& p_subspace_matrix, const Math::Vec4& p_origin, const Math::Vec4& p_direction,
+            RayHit& p_hit, float p_max_distance = std::numeric_limits<float>::infinity()) const;
+
+        /**
+         * @brief Intersect a packet of rays with the mesh in object space.
+         * @details The packet is traced with SIMD instructions when they are available.
+         * @param p_packet The packet. Hit lanes will have their distance, barycentric
+         * coordinates and triangle index updated.
+         * @return uint32_t The bit mask of the lanes that hit the mesh.
+         */
+        uint32_t Intersect(RayPacket& p_packet) const;
+
+        /**
+         * @brief Intersect a batch of global rays with an instance of the mesh.
+         * @details The rays are traced in packets of RayPacket::SIZE.
+         * @param p_subspace_matrix The subspace matrix of the instance.
+         * @param p_rays The rays.
+         * @param p_hits The hits. The distance of each hit is used as the maximum
+         * distance, and the hit is only updated if a closer hit is found.
+         * @param p_count The number of rays.
+         * @return size_t The number of updated hits.
+         */
+        size_t Intersect(const Math::Mat4& p_subspace_matrix, const Ray* p_rays, RayHit* p_hits, size_t p_count) const;
+
+        /**
+         * @brief Get the closest position on the mesh to a point in object space.
+         *
+         * @param p_point The point of interest.
+         * @param p_result This will be set to the closest position.
+         * @param p_max_distance Positions further than this are ignored.
+         * @return true A position is found.
+         * @return false No position is found within the distance.
+         */
+        bool GetClosestPosition(const Math::Vec4& p_point, ClosestHit& p_result,
+            float p_max_distance = std::numeric_limits<float>::infinity()) const;
+
+        /**
+         * @brief Get the closest global position on an instance of the mesh to a point.
+         * @note The subspace matrix is expected to be a composition of translation, rotation
+         * and scale.
+         * @param p_subspace_matrix The subspace matrix of the instance.
+         * @param p_point The global point of interest.
+         * @param p_result This will be set to the closest global position.
+         * @param p_max_distance Positions further than this are ignored.
+         * @return true A position is found.
+         * @return false No position is found within the distance.
+         */
+        bool GetClosestPosition(const Math::Mat4& p_subspace_matrix, const Math::Vec4& p_point, ClosestHit& p_result,
+            float p_max_distance = std::numeric_limits<float>::infinity()) const;
+
+        /**
+         * @brief Find the triangles overlapping a sphere in object space.
+         *
+         * @param p_center The center of the sphere.
+         * @param p_radius The radius of the sphere.
+         * @param p_result The indices of the overlapping triangles will be pushed back to this vector.
+         * @return size_t The number of overlapping triangles.
+         */
+        size_t OverlapSphere(const Math::Vec4& p_center, float p_radius, std::vector<size_t>& p_result) const;
+
+        /**
+         * @brief Find the triangles of an instance overlapping a global sphere.
+         * @note The subspace matrix is expected to be a composition of translation, rotation
+         * and scale.
+         * @param p_subspace_matrix The subspace matrix of the instance.
+         * @param p_center The global center of the sphere.
+         * @param p_radius The radius of the sphere.
+         * @param p_result The indices of the overlapping triangles will be pushed back to this vector.
+         * @return size_t The number of overlapping triangles.
+         */
+        size_t OverlapSphere(const Math::Mat4& p_subspace_matrix, const Math::Vec4& p_center, float p_radius,
+            std::vector<size_t>& p_result) const;
+
+        /**
+         * @brief Get the closest position on a triangle to a point.
+         *
+         * @param p_point The point of interest.
+         * @param p_v0 The first vertex of the triangle.
+         * @param p_v1 The second vertex of the triangle.
+         * @param p_v2 The third vertex of the triangle.
+         * @return Math::Vec4 The closest position.
+         */
+        static Math::Vec4 ClosestPositionOnTriangle(const Math::Vec4& p_point,
+            const Math::Vec4& p_v0, const Math::Vec4& p_v1, const Math::Vec4& p_v2);
+    };
+
+    /**
+     * @brief The result of a ray query against an InstanceBVH.
+     */
+    struct InstanceHit : public RayHit
+    {
+        /**
+         * @brief The index of the hit instance.
+         */
+        size_t instance_index = 0;
+    };
+
+    /**
+     * @brief A top level BVH over instances of triangle BVHs.
+     * @details Each instance refers to a shared object space TriangleBVH and the
+     * subspace matrix of the instance. When only the transforms change, the
+     * hierarchy can be refit instead of rebuilt.
+     */
+    class InstanceBVH
+    {
+    public:
+        using Node = TriangleBVH::Node;
+
+        /**
+         * @brief An instance in the hierarchy.
+         */
+        struct Instance
+        {
+            std::shared_ptr<const TriangleBVH> bvh;
+            Math::Mat4 subspace_matrix;
+            Math::Mat4 subspace_matrix_inverse;
+            float min[3];
+            float max[3];
+        };
+
+    private:
+        std::vector<Node> nodes;
+        std::vector<Instance> instances;
+        std::vector<uint32_t> instance_indices;
+        bool refit_needed = false;
+
+        void UpdateInstanceBounds(Instance& p_instance);
+        void TransformPacket(const Instance& p_instance, const RayPacket& p_packet, RayPacket& p_result) const;
+
+    public:
+        InstanceBVH() = default;
+
+        /**
+         * @brief Build the hierarchy over instances.
+         * @note Empty BVHs are kept as instances but are never hit.
+         * @param p_bvhs The BVH of each instance.
+         * @param p_subspace_matrices The subspace matrix of each instance.
+         * @throw std::invalid_argument The sizes of the two lists do not match.
+         */
+        void Build(const std::vector<std::shared_ptr<const TriangleBVH>>& p_bvhs,
+            const std::vector<Math::Mat4>& p_subspace_matrices);
+
+        /**
+         * @brief Clear the hierarchy.
+         */
+        void Clear();
+
+        /**
+         * @brief Get the number of instances.
+         *
+         * @return size_t The number of instances.
+         */
+        FORCE_INLINE size_t GetInstanceCount() const noexcept { return instances.size(); }
+
+        /**
+         * @brief Get an instance.
+         *
+         * @param p_index The index of the instance.
+         * @return const Instance& The instance.
+         */
+        FORCE_INLINE const Instance& GetInstance(size_t p_index) const { return instances.at(p_index); }
+
+        /**
+         * @brief Set the subspace matrix of an instance. The hierarchy will be refit
+         * before the next query, or when Refit is called.
+         *
+         * @param p_index The index of the instance.
+         * @param p_subspace_matrix The new subspace matrix.
+         */
+        void SetSubspaceMatrix(size_t p_index, const Math::Mat4& p_subspace_matrix);
+
+        /**
+         * @brief Refit the node bounds to the current instance bounds.
+         */
+        void Refit();
+
+        /**
+         * @brief Is a refit needed before querying.
+         *
+         * @return true The instance transforms have changed since the last refit.
+         * @return false The hierarchy is up to date.
+         */
+        FORCE_INLINE bool IsRefitNeeded() const noexcept { return refit_needed; }
+
+        /**
+         * @brief Intersect a global ray with the instances.
+         *
+         * @param p_origin The global origin of the ray.
+         * @param p_direction The global direction of the ray.
+         * @param p_hit This will be set to the closest hit.
+         * @param p_max_distance The maximum distance along the ray.
+         * @throw std::logic_error The hierarchy needs a refit.
+         * @return true The ray hits an instance.
+         * @return false The ray does not hit any instance.
+         */
+        bool Intersect(const Math::Vec4& p_origin, const Math::Vec4& p_direction, InstanceHit& p_hit,
+            float p_max_distance = std::numeric_limits<float>::infinity()) const;
+
+        /**
+         * @brief Intersect a global ray with the instances and get the closest hit of
+         * every instance that is hit.
+         *
+         * @param p_origin The global origin of the ray.
+         * @param p_direction The global direction of the ray.
+         * @param p_hits The hits will be pushed back to this vector, sorted by distance.
+         * @param p_max_distance The maximum distance along the ray.
+         * @throw std::logic_error The hierarchy needs a refit.
+         * @return size_t The number of hits.
+         */
+        size_t IntersectAll(const Math::Vec4& p_origin, const Math::Vec4& p_direction, std::vector<InstanceHit>& p_hits,
+            float p_max_distance = std::numeric_limits<float>::infinity()) const;
+
+        /**
+         * @brief Intersect a batch of global rays with the instances.
+         * @details The rays are traced in packets of RayPacket::SIZE.
+         * @param p_rays The rays.
+         * @param p_hits The hits. The distance of each hit is used as the maximum
+         * distance, and the hit is only updated if a closer hit is found.
+         * @param p_count The number of rays.
+         * @throw std::logic_error The hierarchy needs a refit.
+         * @return size_t The number of updated hits.
+         */
+        size_t Intersect(const Ray* p_rays, InstanceHit* p_hits, size_t p_count) const;
+    };
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include "ce/geometry/triangle.h"
+#include <vector>
+#include <cstddef>
+
+namespace CrossEngine
+{
+    /**
+     * @brief An arena holding the triangles of an asset. The triangles and their vertices are bumped out of
+     * large blocks and are released together with the arena, without running their destructors.
+     * @note Triangles created by an arena must not be deleted.
+     */
+    class GeometryArena
+    {
+    public:
+        /**
+         * @brief The default size of a block of the arena.
+         */
+        static constexpr size_t DEFAULT_BLOCK_SIZE = 1 << 20;
+
+        /**
+         * @brief The bytes of a triangle and its vertices in the arena.
+         */
+        static constexpr size_t TRIANGLE_SIZE = sizeof(Triangle) + 3 * sizeof(Vertex);
+    private:
+        static constexpr size_t ALIGNMENT = alignof(Triangle) > alignof(Vertex) ? alignof(Triangle) : alignof(Vertex);
+
+        struct Block
+        {
+            std::byte* data;
+            size_t size;
+        };
+
+        std::vector<Block> blocks;
+        size_t block_size;
+        size_t offset = 0;
+        size_t used_bytes = 0;
+        size_t reserved_bytes = 0;
+        size_t triangle_count = 0;
+
+        void* Allocate(size_t p_size);
+        void AddBlock(size_t p_size);
+    public:
+        /**
+         * @brief Construct a new geometry arena.
+         *
+         * @param p_block_size The size of the blocks of the arena.
+         */
+        explicit GeometryArena(size_t p_block_size = DEFAULT_BLOCK_SIZE);
+
+        GeometryArena(const GeometryArena& p_other) = delete;
+        GeometryArena& operator=(const GeometryArena& p_other) = delete;
+
+        /**
+         * @brief Destroy the geometry arena and every triangle created by it.
+         */
+        ~GeometryArena();
+
+        /**
+         * @brief Create a triangle with default vertices.
+         *
+         * @return Triangle* The triangle, owned by the arena.
+         */
+        Triangle* CreateTriangle();
+
+        /**
+         * @brief Create a triangle with copies of the vertices.
+         *
+         * @param p_v1 The first vertex.
+         * @param p_v2 The second vertex.
+         * @param p_v3 The third vertex.
+         * @return Triangle* The triangle, owned by the arena.
+         */
+        Triangle* CreateTriangle(const Vertex& p_v1, const Vertex& p_v2, const Vertex& p_v3);
+
+        /**
+         * @brief Get the count of triangles created by the arena.
+         *
+         * @return size_t The count of triangles.
+         */
+        FORCE_INLINE size_t GetTriangleCount() const noexcept { return triangle_count; }
+
+        /**
+         * @brief Get the count of blocks of the arena.
+         *
+         * @return size_t The count of blocks.
+         */
+        FORCE_INLINE size_t GetBlockCount() const noexcept { return blocks.size(); }
+
+        /**
+         * @brief Get the bytes used by the objects of the arena.
+         *
+         * @return size_t The used bytes.
+         */
+        FORCE_INLINE size_t GetUsedBytes() const noexcept { return used_bytes; }
+
+        /**
+         * @brief Get the bytes of the blocks of the arena.
+         *
+         * @return size_t The reserved bytes.
+         */
+        FORCE_INLINE size_t GetReservedBytes() const noexcept { return reserved_bytes; }
+    };
+}
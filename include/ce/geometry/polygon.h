@@ -5,6 +5,8 @@
 
 namespace CrossEngine
 {
+    class GeometryArena;
+
     class PolygonN : public AGeometry
     {
         std::vector<Vertex*> vertices;
@@ -39,7 +41,9 @@ namespace CrossEngine
          * @brief Triangulate the PolygonN.
          * 
          * @param p_triangles The triangles to be filled.
+         * @param p_arena The arena to create the triangles in, the triangles are created by the triangle
+         * pool if it is nullptr.
          */
-        void Triangulate(std::vector<Triangle*>& p_triangles) const;
+        void Triangulate(std::vector<Triangle*>& p_triangles, GeometryArena* p_arena = nullptr) const;
     };
 }
\ No newline at end of file
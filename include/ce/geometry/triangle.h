@@ -16,6 +16,26 @@ namespace CrossEngine
     public:
 
         static constexpr size_t TRIANGLE_ARRAY_SIZE = 3 * (Vertex::ARRAY_SIZE);
+
+        /**
+         * @brief Allocate a triangle from the triangle pool. Derived types are allocated by the global
+         * allocator.
+         */
+        static void* operator new(size_t p_size)
+        {
+            return p_size == sizeof(Triangle) ? PoolAllocator<Triangle>::Allocate() : ::operator new(p_size);
+        }
+
+        /**
+         * @brief Free a triangle to the triangle pool.
+         */
+        static void operator delete(void* p_ptr, size_t p_size) noexcept
+        {
+            if (p_size == sizeof(Triangle))
+                PoolAllocator<Triangle>::Free(p_ptr);
+            else
+                ::operator delete(p_ptr);
+        }
         
         /**
          * @brief Constructor.
@@ -1,5 +1,6 @@
 #pragma once
 #include "ce/math/math.hpp"
+#include "ce/utils/pool_allocator.hpp"
 
 namespace CrossEngine
 {
@@ -26,6 +27,25 @@ namespace CrossEngine
          */
         static constexpr size_t ARRAY_SIZE = 11;
 
+        /**
+         * @brief Allocate a vertex from the vertex pool.
+         */
+        static void* operator new(size_t p_size)
+        {
+            return p_size == sizeof(Vertex) ? PoolAllocator<Vertex>::Allocate() : ::operator new(p_size);
+        }
+
+        /**
+         * @brief Free a vertex to the vertex pool.
+         */
+        static void operator delete(void* p_ptr, size_t p_size) noexcept
+        {
+            if (p_size == sizeof(Vertex))
+                PoolAllocator<Vertex>::Free(p_ptr);
+            else
+                ::operator delete(p_ptr);
+        }
+
         /**
          * @brief Constructor for Vertex.
          */
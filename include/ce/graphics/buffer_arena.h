@@ -0,0 +1,287 @@
+#pragma once
+#include "ce/utils/tlsf_allocator.h"
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <set>
+
+namespace CrossEngine
+{
+    /**
+     * @brief The buffer operations used by a buffer arena.
+     */
+    class IBufferBackend
+    {
+    public:
+        virtual ~IBufferBackend() = default;
+
+        /**
+         * @brief Create a buffer.
+         *
+         * @param p_size The size of the buffer in bytes.
+         * @return unsigned int The buffer.
+         */
+        virtual unsigned int CreateBuffer(size_t p_size) = 0;
+
+        /**
+         * @brief Delete a buffer.
+         *
+         * @param p_buffer The buffer to delete.
+         */
+        virtual void DeleteBuffer(unsigned int p_buffer) = 0;
+
+        /**
+         * @brief Write data to a range of a buffer.
+         *
+         * @param p_buffer The buffer to write to.
+         * @param p_offset The offset of the range in bytes.
+         * @param p_size The size of the range in bytes.
+         * @param p_data The data to write.
+         */
+        virtual void UploadBuffer(unsigned int p_buffer, size_t p_offset, size_t p_size, const void* p_data) = 0;
+
+        /**
+         * @brief Copy a range of a buffer to another range of the same buffer. The ranges do not overlap.
+         *
+         * @param p_buffer The buffer to copy in.
+         * @param p_src_offset The offset of the source range in bytes.
+         * @param p_dst_offset The offset of the destination range in bytes.
+         * @param p_size The size of the ranges in bytes.
+         */
+        virtual void CopyBuffer(unsigned int p_buffer, size_t p_src_offset, size_t p_dst_offset, size_t p_size) = 0;
+
+        /**
+         * @brief Make the previous operations visible to the other contexts.
+         */
+        virtual void Flush() = 0;
+
+        /**
+         * @brief Create a fence signaled when the previous operations have completed.
+         *
+         * @return void* The fence.
+         */
+        virtual void* CreateFence() = 0;
+
+        /**
+         * @brief Check if a fence is signaled, without waiting for it.
+         *
+         * @param p_fence The fence.
+         * @return true The operations before the fence have completed.
+         * @return false The operations before the fence are still running.
+         */
+        virtual bool IsFenceSignaled(void* p_fence) = 0;
+
+        /**
+         * @brief Delete a fence.
+         *
+         * @param p_fence The fence to delete.
+         */
+        virtual void DeleteFence(void* p_fence) = 0;
+    };
+
+    /**
+     * @brief The buffer backend using OpenGL array buffers.
+     */
+    class GLBufferBackend : public IBufferBackend
+    {
+    public:
+        virtual unsigned int CreateBuffer(size_t p_size) override;
+        virtual void DeleteBuffer(unsigned int p_buffer) override;
+        virtual void UploadBuffer(unsigned int p_buffer, size_t p_offset, size_t p_size, const void* p_data) override;
+        virtual void CopyBuffer(unsigned int p_buffer, size_t p_src_offset, size_t p_dst_offset, size_t p_size) override;
+        virtual void Flush() override;
+        virtual void* CreateFence() override;
+        virtual bool IsFenceSignaled(void* p_fence) override;
+        virtual void DeleteFence(void* p_fence) override;
+    };
+
+    /**
+     * @brief A few large buffers shared by many meshes, each sub-allocated with a TLSF allocator.
+     * @details Freed ranges and the ranges left behind by defragmentation are only reused after every
+     * context has finished a whole frame since, so draws already issued with the old offsets stay valid.
+     * The new offset of a moved range is only published once the fence after its copy is signaled, so no
+     * context draws from the new range before the copy has completed. A range is only moved once the fence
+     * after its last upload is signaled, so the copy never reads data still being written by another context.
+     * The buffers are indexed by the size class of their largest free range, so finding a buffer that fits
+     * a range does not depend on the number of buffers.
+     */
+    class BufferArena
+    {
+    public:
+        using Handle = uint32_t;
+        static constexpr Handle INVALID_HANDLE = UINT32_MAX;
+    private:
+        struct Page
+        {
+            unsigned int buffer = 0;
+            TLSFAllocator allocator;
+            // The handle owning each block of the allocator.
+            std::vector<Handle> owners;
+            // The size class of the largest free range, and the position of the page in its class.
+            uint32_t free_class = TLSFAllocator::INVALID_CLASS;
+            uint32_t class_position = 0;
+
+            Page(unsigned int p_buffer, size_t p_size, size_t p_granularity)
+                : buffer(p_buffer), allocator(p_size, p_granularity)
+            {}
+        };
+
+        struct Allocation
+        {
+            uint32_t page = 0;
+            uint32_t block = TLSFAllocator::INVALID_BLOCK;
+            // The block the range is being copied to, not published until the copy has completed.
+            uint32_t moving_block = TLSFAllocator::INVALID_BLOCK;
+            // Signaled when the last upload to the range has completed.
+            void* upload_fence = nullptr;
+        };
+
+        struct PendingFree
+        {
+            uint32_t page;
+            uint32_t block;
+            size_t epoch;
+        };
+
+        struct PendingMove
+        {
+            Handle handle;
+            uint32_t page;
+            uint32_t block;
+        };
+
+        struct PendingMoves
+        {
+            void* fence;
+            std::vector<PendingMove> moves;
+        };
+
+        std::unique_ptr<IBufferBackend> backend;
+        std::vector<std::unique_ptr<Page>> pages;
+        std::vector<Allocation> allocations;
+        std::vector<Handle> unused_handles;
+        std::vector<PendingFree> pending_frees;
+        std::vector<PendingMoves> pending_moves;
+
+        // The pages by the size class of their largest free range, with a bit set for each class that has
+        // pages and a bit set for each word of those bits that is not 0.
+        static constexpr size_t CLASS_WORD_COUNT = (TLSFAllocator::CLASS_COUNT + 63) / 64;
+        std::vector<std::vector<uint32_t>> class_pages;
+        uint64_t class_bitmaps[CLASS_WORD_COUNT] = {};
+        uint32_t class_word_bitmap = 0;
+        mutable std::mutex arena_mutex;
+
+        size_t page_size;
+        size_t granularity;
+
+        // An epoch ends when every context has finished a frame.
+        std::set<const void*> contexts;
+        std::set<const void*> finished_contexts;
+        size_t epoch = 0;
+
+        void SetOwner(uint32_t p_page, uint32_t p_block, Handle p_handle);
+        // Move a page to the class of its largest free range, after its allocator has changed.
+        void UpdatePageClass(uint32_t p_page);
+        // Find a page with a free range fitting a size, INVALID_PAGE if there is none.
+        uint32_t FindPage(size_t p_size) const;
+        static constexpr uint32_t INVALID_PAGE = UINT32_MAX;
+        void ReleasePendingFrees();
+        void CancelMove(Handle p_handle);
+        void PublishMoves();
+    public:
+
+        /**
+         * @brief Construct a new buffer arena.
+         *
+         * @param p_backend The backend of the buffer operations.
+         * @param p_page_size The size of each buffer in bytes.
+         * @param p_granularity Offsets and sizes are multiples of the granularity in bytes.
+         */
+        BufferArena(std::unique_ptr<IBufferBackend> p_backend, size_t p_page_size, size_t p_granularity);
+
+        BufferArena(const BufferArena&) = delete;
+        BufferArena& operator=(const BufferArena&) = delete;
+
+        /**
+         * @brief Destroy the buffer arena and its buffers.
+         */
+        ~BufferArena();
+
+        /**
+         * @brief Allocate a range. A new buffer is created when no buffer has a fitting free range.
+         *
+         * @param p_size The size of the range in bytes.
+         * @return Handle The handle of the range.
+         */
+        Handle Allocate(size_t p_size);
+
+        /**
+         * @brief Free a range.
+         *
+         * @param p_handle The handle of the range.
+         */
+        void Free(Handle p_handle);
+
+        /**
+         * @brief Write data to the beginning of a range. The range is not moved by Defragment until the write has completed.
+         *
+         * @param p_handle The handle of the range.
+         * @param p_data The data to write.
+         * @param p_size The size of the data in bytes.
+         */
+        void Upload(Handle p_handle, const void* p_data, size_t p_size);
+
+        /**
+         * @brief Get the buffer of a range. The buffer of a range never changes.
+         *
+         * @param p_handle The handle of the range.
+         * @return unsigned int The buffer of the range.
+         */
+        unsigned int GetBuffer(Handle p_handle) const;
+
+        /**
+         * @brief Get the current offset of a range in its buffer. The offset changes when the arena is defragmented.
+         *
+         * @param p_handle The handle of the range.
+         * @return size_t The offset of the range in bytes.
+         */
+        size_t GetOffset(Handle p_handle) const;
+
+        /**
+         * @brief Move the ranges at the end of each buffer to free ranges before them. The ranges moved by
+         * the previous calls whose copies have completed get their new offsets first.
+         *
+         * @param p_max_bytes The maximum number of bytes to move.
+         * @return size_t The number of bytes moved.
+         */
+        size_t Defragment(size_t p_max_bytes);
+
+        /**
+         * @brief Called by a context when it finishes a frame. The context is registered on the first call.
+         *
+         * @param p_context The context.
+         */
+        void EndFrame(const void* p_context);
+
+        /**
+         * @brief Called when a context is destroyed.
+         *
+         * @param p_context The context.
+         */
+        void RemoveContext(const void* p_context);
+
+        /**
+         * @brief Get the number of buffers.
+         *
+         * @return size_t The number of buffers.
+         */
+        size_t GetPageCount() const;
+
+        /**
+         * @brief Get the total size of the free ranges in bytes, not counting the ranges waiting to be reused.
+         *
+         * @return size_t The total size of the free ranges.
+         */
+        size_t GetFreeSize() const;
+    };
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include "ce/utils/slot_map.hpp"
+#include "ce/utils/mpsc_queue.hpp"
+#include <mutex>
+
+namespace CrossEngine
+{
+    /**
+     * @brief The OpenGL objects owned by a context, such as VAOs, that must be deleted on the thread of
+     * the context. Registering is O(1), and freeing only pushes to a lock-free queue, so resources can
+     * be freed from any thread. The thread of the context releases the freed resources every frame.
+     */
+    class GPUResourceRegistry
+    {
+    public:
+        using ReleaseFunction = void(*)(int, const unsigned int*);
+    private:
+        struct Resource
+        {
+            unsigned int id;
+            ReleaseFunction release_func;
+        };
+        using SlotHandle = SlotMap<Resource>::Handle;
+
+        SlotMap<Resource> resources;
+        mutable std::mutex registry_mutex;
+        MPSCQueue<SlotHandle> free_queue;
+    public:
+
+        /**
+         * @brief The handle of a registered resource. The resource is released with the function it was
+         * registered with.
+         */
+        class Handle
+        {
+            friend class GPUResourceRegistry;
+        private:
+            SlotHandle slot;
+            unsigned int id = 0;
+        public:
+            /**
+             * @brief Get the OpenGL name of the resource.
+             *
+             * @return unsigned int The name of the resource, 0 if the handle is invalid.
+             */
+            FORCE_INLINE unsigned int GetId() const noexcept { return id; }
+
+            /**
+             * @brief Does the handle refer to a registered resource.
+             *
+             * @return true if the handle was returned by a registration.
+             * @return false if the handle is default constructed.
+             */
+            FORCE_INLINE bool IsValid() const noexcept { return slot.IsValid(); }
+        };
+
+        GPUResourceRegistry() = default;
+        GPUResourceRegistry(const GPUResourceRegistry&) = delete;
+        GPUResourceRegistry& operator=(const GPUResourceRegistry&) = delete;
+
+        /**
+         * @brief Register a resource.
+         *
+         * @param p_id The OpenGL name of the resource.
+         * @param p_release_func The function to release the resource.
+         * @return Handle The handle of the resource.
+         */
+        Handle Register(unsigned int p_id, ReleaseFunction p_release_func);
+
+        /**
+         * @brief Queue a resource to be released by the next call to ReleaseFreed. Can be called from any
+         * thread without blocking. Freeing a handle again is ignored.
+         *
+         * @param p_handle The handle of the resource.
+         */
+        void Free(const Handle& p_handle);
+
+        /**
+         * @brief Release the freed resources. Must be called on the thread of the context.
+         *
+         * @return size_t The number of resources released.
+         */
+        size_t ReleaseFreed();
+
+        /**
+         * @brief Release every registered resource. Must be called on the thread of the context.
+         */
+        void ReleaseAll();
+
+        /**
+         * @brief Get the number of registered resources, including the freed ones that are not released yet.
+         *
+         * @return size_t The number of registered resources.
+         */
+        size_t GetResourceCount() const;
+    };
+}
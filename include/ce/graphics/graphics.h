@@ -3,6 +3,9 @@
 #include "ce/defs.hpp"
 #include "ce/math/math.hpp"
 #include "ce/materials/material.h"
+#include "ce/texture/block_compression.h"
+#include "ce/texture/mip_chain.h"
+#include <atomic>
 #include <vector>
 #include <mutex>
 
@@ -13,6 +16,8 @@ namespace CrossEngine
     class TextureConfig;
     class AMaterial;
     class ATexture;
+    class BufferArena;
+    class Skybox;
     class Graphics
     {
     private:
@@ -21,12 +26,40 @@ namespace CrossEngine
         inline static std::mutex init_mutex;
         inline static std::mutex create_window_mutex;
 
+        using ReleaseFunction = void(*)(int, const unsigned int*);
+        struct SharedResource
+        {
+            unsigned int id;
+            ReleaseFunction destroy_func;
+        };
+        inline static void* shared_context = nullptr;
+        inline static std::vector<SharedResource> freed_shared_resources;
+        inline static std::vector<void*> freed_fences;
+        inline static std::mutex shared_resources_mutex;
+        inline static BufferArena* vertex_arena = nullptr;
+        // Counts the deletions of textures, whose names can then be reused by new textures.
+        inline static std::atomic<size_t> texture_release_serial = 0;
+
+        using MultiDrawArraysIndirectFunction = void(*)(unsigned int, const void*, int, int);
+        inline static MultiDrawArraysIndirectFunction multi_draw_arrays_indirect = nullptr;
+        using BufferStorageFunction = void(*)(unsigned int, ptrdiff_t, const void*, unsigned int);
+        // Loaded by each new window while the render threads of the others read it.
+        inline static std::atomic<BufferStorageFunction> buffer_storage = nullptr;
+
+        // The compressed formats are read by worker threads deciding whether to decompress a texture.
+        inline static std::atomic<bool> is_s3tc_supported = false;
+        inline static std::atomic<bool> is_rgtc_supported = false;
+        inline static std::atomic<bool> is_bptc_supported = false;
+
         static std::shared_ptr<ATexture> default_albedo;
         static std::shared_ptr<ATexture> default_normal;
         static std::shared_ptr<ATexture> default_metallic;
         static std::shared_ptr<ATexture> default_roughness;
         static std::shared_ptr<ATexture> default_ao;
         static std::shared_ptr<AMaterial> default_material;
+        // Created by the first window, so its faces are not decoded by programs without windows.
+        static std::shared_ptr<Skybox> default_skybox;
+        inline static std::mutex default_skybox_mutex;
 
     public:
 
@@ -41,6 +74,14 @@ namespace CrossEngine
         FORCE_INLINE static std::shared_ptr<ATexture> GetDefaultAO() noexcept { return default_ao; }
         FORCE_INLINE static std::shared_ptr<AMaterial> GetDefaultMaterial() noexcept { return default_material; }
 
+        /**
+         * @brief Get the skybox drawn by the windows, shared by every window so its faces are uploaded once.
+         * It is created on the first call, and destroyed when graphics is terminated.
+         * 
+         * @return std::shared_ptr<Skybox> The default skybox.
+         */
+        static std::shared_ptr<Skybox> GetDefaultSkybox();
+
         /**
          * @brief Initialize graphics.
          * @throw std::runtime_error Failed to initialize GLFW.
@@ -80,6 +121,76 @@ namespace CrossEngine
          */
         static void* CreateGLFWContext(size_t p_width, size_t p_height, const std::string& p_title, bool p_fullscreen, bool p_resizable, void* p_shared);
 
+        /**
+         * @brief Get the hidden context every window context shares its resources with. Buffers and
+         * textures created in any window context are visible in all of them, only container objects
+         * such as VAOs and framebuffers are per context.
+         * 
+         * @throw std::runtime_error Failed to create GLFW window.
+         * @throw std::runtime_error Graphics not initialized.
+         * @return void* The shared context.
+         */
+        static void* GetSharedContext();
+
+        /**
+         * @brief Free a resource that is shared by the window contexts. The resource is released by the next
+         * window context that updates its resources.
+         * 
+         * @param p_id The ID of the resource.
+         * @param p_destroy_func The function to destroy the resource.
+         */
+        static void FreeSharedResource(unsigned int p_id, ReleaseFunction p_destroy_func);
+
+        /**
+         * @brief Release the freed shared resources. Must be called with a window context current.
+         */
+        static void ReleaseSharedResources();
+
+        /**
+         * @brief Fence the commands issued so far by the current context, such as the upload of a buffer or a
+         * texture, and flush them, so the other contexts can wait for them with WaitUpload.
+         * 
+         * @param p_fence The fence of the resource, replaced by the new fence. nullptr if it has none.
+         */
+        static void FenceUpload(void*& p_fence);
+
+        /**
+         * @brief Make the current context wait for the upload of a resource before it uses the resource. Only
+         * the commands of the context wait, not the calling thread. The fence is deleted once it is signaled.
+         * @note The caller must hold the lock guarding the fence, as for FenceUpload.
+         * 
+         * @param p_fence The fence of the resource, set to nullptr once it is signaled.
+         * @return true if the upload is finished, no context has to wait for it anymore.
+         * @return false if the upload may still be in progress.
+         */
+        static bool WaitUpload(void*& p_fence);
+
+        /**
+         * @brief Free a fence from any thread. The fence is deleted by the next window context that updates
+         * its resources.
+         * 
+         * @param p_fence The fence, may be nullptr.
+         */
+        static void FreeFence(void* p_fence);
+
+        /**
+         * @brief The size of each buffer of the vertex arena in bytes.
+         */
+        static constexpr size_t VERTEX_ARENA_PAGE_SIZE = 32 * 1024 * 1024;
+
+        /**
+         * @brief The maximum number of bytes moved to defragment the vertex arena in a frame.
+         */
+        static constexpr size_t VERTEX_ARENA_DEFRAGMENT_BYTES = 1024 * 1024;
+
+        /**
+         * @brief Get the arena holding the vertices of the meshes that share their vertex data. Offsets in
+         * the arena are multiples of the vertex size.
+         * 
+         * @return BufferArena* The vertex arena, nullptr if graphics is not initialized.
+         */
+        FORCE_INLINE static BufferArena* GetVertexArena() noexcept { return vertex_arena; }
+
         /**
          * @brief Destroy the window context.
          * 
@@ -88,29 +199,171 @@ namespace CrossEngine
         static void DestroyGLFWContex(void* p_context);
 
         /**
-         * @brief Generate VBO from vertices.
+         * @brief Generate a shared VBO from vertices.
          * 
          * @param p_vao The VAO to generate VBO from.
          * @param p_vertices The vertices to generate VBO from.
          * @param p_size The size of the vertices.
          * @return unsigned int The ID of the VBO.
          */
-        static unsigned int GenerateVBO(unsigned int p_vao, float* p_vertices, size_t p_size, const Window* p_context);
+        static unsigned int GenerateVBO(unsigned int p_vao, float* p_vertices, size_t p_size);
 
         /**
-         * @brief Generate a texture.
+         * @brief Generate a shared texture.
          * 
          * @return unsigned int The ID of the texture.
          */
-        static unsigned int GenerateTexture(const Window* p_context);
+        static unsigned int GenerateTexture();
 
         /**
-         * @brief Delete a texture.
+         * @brief Delete a shared texture.
          * 
          * @param p_texture_id The texture ID to be deleted
-         * @param p_context The context that the texture is in.
          */
-        static void DeleteTexture(unsigned int p_texture_id, const Window* p_context);
+        static void DeleteTexture(unsigned int p_texture_id);
+
+        /**
+         * @brief Delete textures now, on the current context. Every texture is deleted through this, so the
+         * caches of bound textures can tell when a name may refer to a new texture.
+         * 
+         * @param p_count The number of textures.
+         * @param p_texture_ids The textures to delete.
+         */
+        static void ReleaseTextures(int p_count, const unsigned int* p_texture_ids);
+
+        /**
+         * @brief Get the number of times textures have been deleted. A texture name cached before the number
+         * changed may now be a different texture.
+         * 
+         * @return size_t The number of deletions.
+         */
+        FORCE_INLINE static size_t GetTextureReleaseSerial() noexcept { return texture_release_serial.load(std::memory_order_acquire); }
+
+        /**
+         * @brief Set the vertex attributes of the bound VAO to read the vertices of the bound vertex buffer.
+         */
+        static void SetVertexAttributes();
+
+        /**
+         * @brief The target of the buffer holding the commands of indirect draws, missing from the OpenGL 3.3 loader.
+         */
+        static constexpr unsigned int DRAW_INDIRECT_BUFFER = 0x8F3F;
+
+        /**
+         * @brief Load the multi-draw indirect entry point of the current context. Requires OpenGL 4.3, or the
+         * ARB_multi_draw_indirect and ARB_base_instance extensions.
+         * 
+         * @return true if multi-draw indirect is supported by the current context.
+         * @return false if the draws have to be issued one by one.
+         */
+        static bool LoadMultiDrawIndirect();
+
+        /**
+         * @brief The flags of buffer storage and buffer mapping for buffers mapped while they are used by draws,
+         * missing from the OpenGL 3.3 loader.
+         */
+        static constexpr unsigned int MAP_PERSISTENT_BIT = 0x0040;
+        static constexpr unsigned int MAP_COHERENT_BIT = 0x0080;
+
+        /**
+         * @brief Load the buffer storage entry point of the current context. Requires OpenGL 4.4, or the
+         * ARB_buffer_storage extension.
+         * 
+         * @return true if buffer storage is supported by the current context.
+         * @return false if buffers have to be mapped for each write.
+         */
+        static bool LoadBufferStorage();
+
+        /**
+         * @brief Check if buffers can be created with immutable storage and persistently mapped.
+         * 
+         * @return true if buffer storage is supported.
+         */
+        FORCE_INLINE static bool IsBufferStorageSupported() noexcept { return buffer_storage != nullptr; }
+
+        /**
+         * @brief Create the immutable storage of the buffer bound to a target.
+         * 
+         * @param p_target The target the buffer is bound to.
+         * @param p_size The size of the storage in bytes.
+         * @param p_flags The usage flags of the storage, such as GL_MAP_WRITE_BIT and MAP_PERSISTENT_BIT.
+         * @throw std::runtime_error Buffer storage is not supported.
+         */
+        static void BufferStorage(unsigned int p_target, size_t p_size, unsigned int p_flags);
+
+        /**
+         * @brief Check which compressed texture formats the current context supports. BC1 and BC3 require the
+         * EXT_texture_compression_s3tc extension, BC5 OpenGL 3.0, and BC7 OpenGL 4.2 or the
+         * ARB_texture_compression_bptc extension.
+         */
+        static void LoadTextureCompression();
+
+        /**
+         * @brief Check if the contexts support a compressed texture format. Can be called from any thread.
+         * @note The formats are only supported once a window is initialized.
+         * 
+         * @param p_format The format.
+         * @return true if the textures of the format can be uploaded without decompressing them.
+         * @return false if the textures of the format must be decompressed.
+         */
+        FORCE_INLINE static bool IsBlockFormatSupported(BlockFormat p_format) noexcept
+        {
+            switch (p_format)
+            {
+            case BlockFormat::BC1:
+            case BlockFormat::BC3:
+                return is_s3tc_supported;
+            case BlockFormat::BC5:
+                return is_rgtc_supported;
+            case BlockFormat::BC7:
+                return is_bptc_supported;
+            default:
+                return false;
+            }
+        }
+
+        static constexpr unsigned int COMPRESSED_RGB_S3TC_DXT1 = 0x83F0;
+        static constexpr unsigned int COMPRESSED_RGBA_S3TC_DXT5 = 0x83F3;
+        static constexpr unsigned int COMPRESSED_RG_RGTC2 = 0x8DBD;
+        static constexpr unsigned int COMPRESSED_RGBA_BPTC_UNORM = 0x8E8C;
+
+        /**
+         * @brief Get the internal format of the textures of a compressed format.
+         * 
+         * @param p_format The format, not BlockFormat::NONE.
+         * @return unsigned int The internal format.
+         */
+        FORCE_INLINE static unsigned int GetBlockInternalFormat(BlockFormat p_format) noexcept
+        {
+            switch (p_format)
+            {
+            case BlockFormat::BC1:
+                return COMPRESSED_RGB_S3TC_DXT1;
+            case BlockFormat::BC3:
+                return COMPRESSED_RGBA_S3TC_DXT5;
+            case BlockFormat::BC5:
+                return COMPRESSED_RG_RGTC2;
+            case BlockFormat::BC7:
+                return COMPRESSED_RGBA_BPTC_UNORM;
+            default:
+                return 0;
+            }
+        }
+
+        /**
+         * @brief Bind a buffer to the draw indirect buffer target.
+         * 
+         * @param p_buffer The buffer holding the draw commands, 0 to unbind.
+         */
+        static void BindDrawIndirectBuffer(unsigned int p_buffer);
+
+        /**
+         * @brief Draw triangles with the commands at the beginning of the bound draw indirect buffer. Each command
+         * holds the vertex count, instance count, first vertex and base instance of a draw.
+         * 
+         * @param p_command_count The number of commands.
+         */
+        static void MultiDrawArraysIndirect(size_t p_command_count);
 
         /**
          * @brief Configure a texture.
@@ -128,6 +381,8 @@ namespace CrossEngine
          * @param p_height The height of the texture.
          * @param p_channels The channels of the texture.
          * @param p_data The data of the texture.
+         * @param p_mipmap Should the driver build the smaller levels, on the calling thread. The levels built by
+         * MipChain::Generate on a worker thread are usually better.
          */
         static void SetTexture(unsigned int p_texture_id, size_t p_width, size_t p_height, size_t p_channels, const ubyte_t* p_data, bool p_mipmap);
 
@@ -139,7 +394,8 @@ namespace CrossEngine
         static Math::Vec2s GetScreenSize();
 
         /**
-         * @brief Called every frame in the main thread.
+         * @brief Called every frame in the main thread. Defragments the vertex arena in the shared context,
+         * which is only current in the main thread.
          * 
          */
         static void Update();
@@ -180,5 +436,22 @@ namespace CrossEngine
         TextureFilterMode filter_mode_min = TextureFilterMode::LINEAR;
         TextureFilterMode filter_mode_mag = TextureFilterMode::LINEAR;
         bool mipmap = true;
+        // How the smaller levels are built, on the worker threads.
+        MipFilter mip_filter = MipFilter::KAISER;
+        TextureContent content = TextureContent::LINEAR;
+
+        /**
+         * @brief Get how the levels of a texture with this config are built on a worker thread.
+         *
+         * @return MipConfig How the levels are built.
+         */
+        FORCE_INLINE MipConfig GetMipConfig() const noexcept
+        {
+            MipConfig result;
+            result.mipmap = mipmap;
+            result.filter = mip_filter;
+            result.content = content;
+            return result;
+        }
     };
 }
\ No newline at end of file
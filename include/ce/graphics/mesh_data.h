@@ -0,0 +1,107 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <mutex>
+#include "ce/geometry/bvh.h"
+#include "ce/geometry/geometry_arena.h"
+#include "ce/resource/mesh_cache.h"
+
+namespace CrossEngine
+{
+    class Triangle;
+    class Window;
+
+    /**
+     * @brief Immutable triangles and their vertex buffer, shared by every mesh that
+     * draws the same geometry.
+     */
+    class MeshData
+    {
+    private:
+        mutable std::vector<Triangle*> triangles;
+        // The triangles are released with the arena when they are loaded into one.
+        mutable std::unique_ptr<GeometryArena> arena;
+        // The triangles of mesh data loaded from a cache are created when they are first used.
+        std::shared_ptr<const MeshCache> cache;
+        size_t vertex_count;
+        // The vertices are a range of the vertex arena of the graphics.
+        uint32_t arena_handle = UINT32_MAX;
+        // Waited for by the other contexts before they draw the vertices.
+        void* upload_fence = nullptr;
+        std::shared_ptr<TriangleBVH> bvh;
+        mutable std::mutex mesh_data_mutex;
+    public:
+        /**
+         * @brief Construct a new mesh data.
+         *
+         * @param p_triangles The triangles of the mesh data, owned by the mesh data.
+         * @param p_arena The arena the triangles are created in, nullptr if they are created by the triangle pool.
+         */
+        explicit MeshData(std::vector<Triangle*>&& p_triangles, std::unique_ptr<GeometryArena>&& p_arena = nullptr);
+
+        /**
+         * @brief Construct a new mesh data from a mesh cache. The vertices are uploaded from the cache, and the
+         * triangles are only created if they are used.
+         *
+         * @param p_cache The mesh cache.
+         */
+        explicit MeshData(std::shared_ptr<const MeshCache> p_cache);
+
+        /**
+         * @brief Load the mesh data of a model file through its mesh cache. The mesh data is shared with
+         * the other loads of the file, see Resource::LoadSharedMeshData.
+         *
+         * @param p_path The path to the model file.
+         * @throw std::runtime_error Failed to load the model file.
+         * @return std::shared_ptr<MeshData> The mesh data.
+         */
+        static std::shared_ptr<MeshData> Load(const std::string& p_path);
+
+        MeshData(const MeshData& p_other) = delete;
+        MeshData& operator=(const MeshData& p_other) = delete;
+
+        /**
+         * @brief Destroy the mesh data.
+         */
+        ~MeshData();
+
+        /**
+         * @brief Get the triangles of the mesh data, created on the first call if the mesh data is loaded
+         * from a cache.
+         *
+         * @return const std::vector<Triangle*>& The triangles of the mesh data.
+         */
+        const std::vector<Triangle*>& GetTriangles() const;
+
+        /**
+         * @brief Get the vertex count of the mesh data.
+         *
+         * @return size_t The vertex count of the mesh data.
+         */
+        FORCE_INLINE size_t GetVertexCount() const noexcept { return vertex_count; }
+
+        /**
+         * @brief Get the vertex buffer shared by every context, uploading the vertices on the first call.
+         * The buffer is shared with other mesh data, the vertices start at GetFirstVertex.
+         *
+         * @param p_context The context the vertex buffer is used in.
+         * @return unsigned int The vertex buffer.
+         */
+        unsigned int GetVBO(Window* p_context);
+
+        /**
+         * @brief Get the index of the first vertex of the mesh data in its vertex buffer. The index changes
+         * when the vertex arena is defragmented, so it is queried for every draw.
+         *
+         * @return size_t The index of the first vertex.
+         */
+        size_t GetFirstVertex() const;
+
+        /**
+         * @brief Get the BVH of the mesh data, built on the first call.
+         *
+         * @return std::shared_ptr<const TriangleBVH> The BVH in object space.
+         */
+        std::shared_ptr<const TriangleBVH> GetBVH();
+    };
+}
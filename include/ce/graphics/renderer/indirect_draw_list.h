@@ -0,0 +1,77 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace CrossEngine
+{
+    class Component3D;
+
+    /**
+     * @brief The per-draw data of a bucket of instanced draws, laid out to be submitted with a single
+     * multi-draw indirect call: one command per draw, and the model matrices of every instance.
+     */
+    class IndirectDrawList
+    {
+    public:
+        /**
+         * @brief The layout of a draw arrays indirect command.
+         */
+        struct Command
+        {
+            uint32_t count;
+            uint32_t instance_count;
+            uint32_t first;
+            uint32_t base_instance;
+        };
+
+        // Number of instances whose model matrices are filled by one job.
+        static constexpr size_t FILL_CHUNK_SIZE = 1024;
+    private:
+        std::vector<Command> commands;
+        std::vector<const Component3D*> instances;
+        std::vector<float> matrices;
+    public:
+
+        /**
+         * @brief Remove the draws.
+         */
+        void Clear();
+
+        /**
+         * @brief Add a draw. The model matrices of its instances follow the ones of the previous draws.
+         *
+         * @param p_first The first vertex of the draw.
+         * @param p_count The vertex count of the draw.
+         * @param p_instances The components providing the model matrices of the instances.
+         */
+        void AddDraw(uint32_t p_first, uint32_t p_count, const std::vector<const Component3D*>& p_instances);
+
+        /**
+         * @brief Fill the model matrices of the instances, column by column. Large lists are filled in parallel
+         * by the workers of the JobSystem.
+         */
+        void Build();
+
+        /**
+         * @brief Get the commands of the draws.
+         *
+         * @return const std::vector<Command>& The commands.
+         */
+        const std::vector<Command>& GetCommands() const noexcept { return commands; }
+
+        /**
+         * @brief Get the model matrices filled by Build, 16 floats per instance.
+         *
+         * @return const std::vector<float>& The model matrices.
+         */
+        const std::vector<float>& GetMatrices() const noexcept { return matrices; }
+
+        /**
+         * @brief Get the number of instances of every draw.
+         *
+         * @return size_t The number of instances.
+         */
+        size_t GetInstanceCount() const noexcept { return instances.size(); }
+    };
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <string>
+#include <algorithm>
+#include <cmath>
+#include "ce/math/math.hpp"
+
+namespace CrossEngine
+{
+    /**
+     * @brief The math of weighted blended order independent transparency. The constants are compiled
+     * into the fragment shader and the composite shader of OITPass as OIT_* defines, so the shaders and
+     * the functions here share one source.
+     */
+    struct OITMath
+    {
+        // weight = clamp((min(1, alpha * ALPHA_SCALE) + ALPHA_BIAS)^3 * WEIGHT_SCALE * (1 - depth * DEPTH_SCALE)^3,
+        // WEIGHT_MIN, WEIGHT_MAX)
+        static constexpr float WEIGHT_ALPHA_SCALE = 10.0f;
+        static constexpr float WEIGHT_ALPHA_BIAS = 0.01f;
+        static constexpr float WEIGHT_SCALE = 1e8f;
+        static constexpr float WEIGHT_DEPTH_SCALE = 0.9f;
+        static constexpr float WEIGHT_MIN = 1e-2f;
+        static constexpr float WEIGHT_MAX = 3e3f;
+        // A pixel revealing at least this much of the opaque color has no transparent fragment.
+        static constexpr float REVEALED_THRESHOLD = 0.9999f;
+        // The smallest sum of weights divided by, so pixels with tiny weights do not divide by 0.
+        static constexpr float MIN_WEIGHT_SUM = 1e-5f;
+
+        /**
+         * @brief Get the defines of the constants, to be compiled into the shaders.
+         *
+         * @return std::string The defines, one per line.
+         */
+        static std::string GetShaderDefines();
+
+        /**
+         * @brief Get the weight of a transparent fragment, as computed by the fragment shader. Nearer and
+         * more opaque fragments weigh more.
+         *
+         * @param p_alpha The alpha of the fragment.
+         * @param p_depth The window space depth of the fragment, from 0 at the near plane to 1 at the far plane.
+         * @return float The weight.
+         */
+        FORCE_INLINE static float GetWeight(float p_alpha, float p_depth) noexcept
+        {
+            return std::clamp(std::pow(std::min(1.0f, p_alpha * WEIGHT_ALPHA_SCALE) + WEIGHT_ALPHA_BIAS, 3.0f) * WEIGHT_SCALE
+                * std::pow(1.0f - p_depth * WEIGHT_DEPTH_SCALE, 3.0f), WEIGHT_MIN, WEIGHT_MAX);
+        }
+
+        /**
+         * @brief Blend a transparent fragment into a pixel of the targets, as the blend function set by
+         * OITPass::BeginTransparent does.
+         *
+         * @param p_color The color of the fragment.
+         * @param p_depth The window space depth of the fragment.
+         * @param p_accumulation The pixel of the accumulation target, cleared to 0.
+         * @param p_revealage The pixel of the revealage target, cleared to (0, 0, 0, 1).
+         */
+        FORCE_INLINE static void BlendFragment(const Math::Vec4& p_color, float p_depth, Math::Vec4& p_accumulation,
+            Math::Vec4& p_revealage) noexcept
+        {
+            float alpha = p_color[3];
+            float weight = GetWeight(alpha, p_depth);
+            for (size_t i = 0; i < 3; ++i)
+                p_accumulation[i] += p_color[i] * alpha * weight;
+            p_accumulation[3] *= 1.0f - alpha;
+            p_revealage[0] += alpha * weight;
+            p_revealage[3] *= 1.0f - alpha;
+        }
+
+        /**
+         * @brief Resolve a pixel of the targets over the opaque color, as the composite shader does.
+         *
+         * @param p_opaque The opaque color.
+         * @param p_accumulation The pixel of the accumulation target.
+         * @param p_revealage The pixel of the revealage target.
+         * @return Math::Vec4 The resolved color.
+         */
+        FORCE_INLINE static Math::Vec4 ResolvePixel(const Math::Vec4& p_opaque, const Math::Vec4& p_accumulation,
+            const Math::Vec4& p_revealage) noexcept
+        {
+            if (p_revealage[3] >= REVEALED_THRESHOLD)
+                return p_opaque;
+            float divisor = std::max(p_revealage[0], MIN_WEIGHT_SUM);
+            Math::Vec4 result;
+            for (size_t i = 0; i < 3; ++i)
+                result[i] = p_accumulation[i] / divisor * (1.0f - p_revealage[3]) + p_opaque[i] * p_revealage[3];
+            result[3] = 1.0f;
+            return result;
+        }
+    };
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <memory>
+#include "ce/math/math.hpp"
+
+namespace CrossEngine
+{
+    class ShaderProgram;
+
+    /**
+     * @brief Weighted blended order independent transparency.
+     * @details The opaque scene is drawn into an offscreen target. Transparent fragments are then
+     * accumulated into an accumulation and a revealage target sharing its depth buffer, without sorting,
+     * and the composite pass resolves everything into the default framebuffer.
+     * Only functions of OpenGL 3.3 are used, a single blend function is shared by both targets.
+     */
+    class OITPass
+    {
+    private:
+        Math::Vec2s size;
+        unsigned int opaque_fbo = 0;
+        unsigned int transparent_fbo = 0;
+        unsigned int opaque_texture = 0;
+        unsigned int depth_texture = 0;
+        unsigned int accumulation_texture = 0;
+        unsigned int revealage_texture = 0;
+        unsigned int composite_vao = 0;
+        std::unique_ptr<ShaderProgram> composite_program;
+
+        void CreateTargets();
+        void DestroyTargets();
+    public:
+        /**
+         * @brief Constructor of OITPass. Must be called on the thread of the context.
+         * 
+         * @param p_size The size of the framebuffer.
+         */
+        explicit OITPass(const Math::Vec2s& p_size);
+
+        OITPass(const OITPass&) = delete;
+
+        /**
+         * @brief Destructor of OITPass. Must be called on the thread of the context.
+         */
+        ~OITPass();
+
+        /**
+         * @brief Get the size of the targets.
+         * 
+         * @return const Math::Vec2s& The size of the targets.
+         */
+        FORCE_INLINE const Math::Vec2s& GetSize() const noexcept { return size; }
+
+        /**
+         * @brief Resize the targets.
+         * 
+         * @param p_size The new size.
+         */
+        void Resize(const Math::Vec2s& p_size);
+
+        /**
+         * @brief Start drawing opaque objects into the offscreen target.
+         * 
+         * @param p_clear_color The color to clear the target with.
+         */
+        void BeginOpaque(const Math::Vec4& p_clear_color);
+
+        /**
+         * @brief Start accumulating transparent objects.
+         */
+        void BeginTransparent();
+
+        /**
+         * @brief Resolve the transparent objects over the opaque objects into the default framebuffer,
+         * and restore the render states.
+         */
+        void Composite();
+    };
+}
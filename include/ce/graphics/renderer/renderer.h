@@ -1,17 +1,71 @@
 #pragma once
 #include <vector>
 #include <memory>
+#include <map>
 #include "ce/utils/task.h"
+#include "ce/graphics/renderer/indirect_draw_list.h"
 
 namespace CrossEngine
 {
     class ShaderProgram;
+    class Window;
+    class MeshData;
+    class AMaterial;
+    class Component3D;
+    class VisualMesh;
+    class StaticBatcher;
     class Renderer
     {
     private:
         std::vector<Task> render_tasks;
         std::vector<Task> unprioritized_render_tasks;
         std::unique_ptr<ShaderProgram> shader_program;
+        std::unique_ptr<StaticBatcher> static_batcher;
+        bool is_static_batch_task_added = false;
+
+        /**
+         * @brief The instances of the same mesh data drawn with the same material in the current frame.
+         */
+        struct InstanceBatch
+        {
+            std::shared_ptr<MeshData> mesh_data;
+            std::shared_ptr<AMaterial> material;
+            std::vector<const Component3D*> instances;
+        };
+        std::map<std::pair<const MeshData*, const AMaterial*>, InstanceBatch> instance_batches;
+
+        /**
+         * @brief The VAO and the buffer of model matrices used to draw the instances of a mesh data.
+         */
+        struct InstanceBuffer
+        {
+            std::weak_ptr<MeshData> mesh_data;
+            unsigned int vao = 0;
+            unsigned int vbo = 0;
+            size_t capacity = 0;
+        };
+        std::map<const MeshData*, InstanceBuffer> instance_buffers;
+
+        /**
+         * @brief The batches of a material whose mesh data share a vertex buffer, drawn with a single
+         * multi-draw indirect call.
+         */
+        struct IndirectBucket
+        {
+            std::shared_ptr<AMaterial> material;
+            unsigned int vertex_buffer = 0;
+            std::vector<InstanceBatch*> batches;
+            unsigned int vao = 0;
+            unsigned int instance_vbo = 0;
+            unsigned int command_buffer = 0;
+            size_t instance_capacity = 0;
+            size_t command_capacity = 0;
+        };
+        std::map<std::pair<const AMaterial*, unsigned int>, IndirectBucket> indirect_buckets;
+        IndirectDrawList draw_list;
+
+        void DrawInstances(Window* p_context, InstanceBatch& p_batch);
+        void DrawIndirectBucket(Window* p_context, IndirectBucket& p_bucket);
     public:
         Renderer(ShaderProgram*&& p_shader_program) noexcept;
         
@@ -24,6 +78,13 @@ namespace CrossEngine
          */
         const std::unique_ptr<ShaderProgram>& GetShaderProgram() const { return shader_program; }
 
+        /**
+         * @brief Get the batcher that merges the static meshes of this renderer.
+         * 
+         * @return StaticBatcher* The static batcher.
+         */
+        FORCE_INLINE StaticBatcher* GetStaticBatcher() { return static_batcher.get(); }
+
         /**
          * @brief Add a render task to the renderer.
          * 
@@ -31,6 +92,29 @@ namespace CrossEngine
          */
         void AddRenderTask(const Task& p_task);
 
+        /**
+         * @brief Add an instance of a mesh data to the renderer. The instances sharing the mesh data
+         * and the material are drawn with a single instanced draw call among the tasks without priority.
+         * When the context uses multi-draw indirect, the draws of a material sharing a vertex buffer are
+         * submitted with a single call.
+         * 
+         * @param p_context The context to render in.
+         * @param p_mesh_data The mesh data of the instance.
+         * @param p_material The material of the instance.
+         * @param p_instance The component that provides the model matrix of the instance.
+         */
+        void AddInstance(Window* p_context, const std::shared_ptr<MeshData>& p_mesh_data,
+            const std::shared_ptr<AMaterial>& p_material, const Component3D* p_instance);
+
+        /**
+         * @brief Add a static mesh to the renderer. The static meshes are drawn from merged world space
+         * buffers among the tasks without priority.
+         * 
+         * @param p_context The context to render in.
+         * @param p_mesh The static mesh.
+         */
+        void AddStaticMesh(Window* p_context, VisualMesh* p_mesh);
+
         /**
          * @brief Refresh the renderer.
          */
@@ -42,5 +126,18 @@ namespace CrossEngine
          * @param p_context The context to render in.
          */
         void Render();
+
+        /**
+         * @brief Render the tasks without priority.
+         */
+        void RenderOpaque();
+
+        /**
+         * @brief Render the tasks with priority.
+         * 
+         * @param p_sort Should the tasks be sorted by their priority before rendering. Order independent
+         * transparency does not need the tasks to be sorted.
+         */
+        void RenderTransparent(bool p_sort = true);
     };
 }
\ No newline at end of file
@@ -0,0 +1,154 @@
+#pragma once
+#include <map>
+#include <tuple>
+#include <vector>
+#include <memory>
+#include "ce/math/math.hpp"
+#include "ce/component/component.h"
+
+namespace CrossEngine
+{
+    class Window;
+    class Component;
+    class VisualMesh;
+    class AMaterial;
+    class ShaderProgram;
+
+    /**
+     * @brief Merges the static meshes of a context into world space vertex buffers, one per material
+     * in each chunk of space. Only the batches whose meshes are added or removed are rebuilt, and the
+     * batches outside the view are skipped.
+     */
+    class StaticBatcher
+    {
+    public:
+        /**
+         * @brief The chunk coordinates and the material of a batch.
+         */
+        using BatchKey = std::tuple<int, int, int, const AMaterial*>;
+
+    private:
+        struct Batch
+        {
+            std::shared_ptr<AMaterial> material;
+            unsigned int vao = 0;
+            unsigned int vbo = 0;
+            size_t vertex_count = 0;
+            float bounds_min[3] = {};
+            float bounds_max[3] = {};
+            bool is_dirty = true;
+            std::vector<const VisualMesh*> meshes;
+        };
+
+        struct Entry
+        {
+            ComponentLink mesh;
+            BatchKey key;
+            // The world matrix the mesh is batched with. Compared instead of the transform of the mesh, since
+            // moving an ancestor moves the mesh too.
+            Math::Mat4 model;
+            bool is_seen = true;
+        };
+
+        std::map<const VisualMesh*, Entry> entries;
+        std::map<BatchKey, Batch> batches;
+        std::vector<float> vertices;
+        float chunk_size = 32.0f;
+        size_t batch_draw_count = 0;
+
+        void RebuildBatch(Window* p_context, Batch& p_batch);
+        static bool IsOutsideView(const Math::Mat4& p_view_proj, const Batch& p_batch);
+    public:
+        StaticBatcher() = default;
+        StaticBatcher(const StaticBatcher&) = delete;
+        StaticBatcher& operator=(const StaticBatcher&) = delete;
+
+        /**
+         * @brief Destroy the batcher. Must be called in the context of the batches.
+         */
+        ~StaticBatcher();
+
+        /**
+         * @brief Add a static mesh to the current frame. A mesh that is not added in a
+         * frame is removed from its batch. A mesh whose world matrix or material changed since
+         * the last frame is moved to the batch of its new key, and both batches are rebuilt.
+         *
+         * @param p_mesh The mesh to add.
+         */
+        void AddMesh(VisualMesh* p_mesh);
+
+        /**
+         * @brief Rebuild the changed batches and draw the batches in the view.
+         *
+         * @param p_context The context to draw in.
+         * @param p_shader_program The shader program used to draw.
+         */
+        void Draw(Window* p_context, const ShaderProgram* p_shader_program);
+
+        /**
+         * @brief Remove the meshes that were not added in the current frame, and start the next frame.
+         */
+        void EndFrame();
+
+        /**
+         * @brief Get the size of the cubic chunks the static meshes are split into.
+         *
+         * @return float The size of a chunk.
+         */
+        FORCE_INLINE float GetChunkSize() const noexcept { return chunk_size; }
+
+        /**
+         * @brief Set the size of the cubic chunks the static meshes are split into. Every batch is rebuilt.
+         * Must be called in the thread of the context.
+         *
+         * @param p_chunk_size The size of a chunk.
+         */
+        void SetChunkSize(float p_chunk_size);
+
+        /**
+         * @brief Get the number of batches drawn in the last frame.
+         *
+         * @return size_t The number of batches drawn.
+         */
+        FORCE_INLINE size_t GetBatchDrawCount() const noexcept { return batch_draw_count; }
+
+        /**
+         * @brief Get the number of batches.
+         *
+         * @return size_t The number of batches.
+         */
+        FORCE_INLINE size_t GetBatchCount() const noexcept { return batches.size(); }
+
+        /**
+         * @brief Get the number of meshes in a batch.
+         *
+         * @param p_key The key of the batch.
+         * @return size_t The number of meshes, 0 if there is no such batch.
+         */
+        size_t GetBatchMeshCount(const BatchKey& p_key) const;
+
+        /**
+         * @brief Get the key of the batch of a mesh.
+         *
+         * @param p_position The global position of the mesh.
+         * @param p_chunk_size The size of a chunk.
+         * @param p_material The material of the mesh.
+         * @return BatchKey The key of the batch.
+         */
+        static BatchKey GetBatchKey(const Math::Vec4& p_position, float p_chunk_size, const AMaterial* p_material);
+
+        /**
+         * @brief Transform vertices in the layout of the vertex buffers to world space, and grow bounds
+         * to contain their positions.
+         *
+         * @param p_vertices The vertices, transformed in place.
+         * @param p_vertex_count The number of vertices.
+         * @param p_model The world matrix of the mesh.
+         * @param p_model_inverse The inverse of the world matrix, the normals are transformed by its transpose.
+         * @param p_bounds_min The minimum corner of the bounds.
+         * @param p_bounds_max The maximum corner of the bounds.
+         */
+        static void TransformVertices(float* p_vertices, size_t p_vertex_count, const Math::Mat4& p_model,
+            const Math::Mat4& p_model_inverse, float* p_bounds_min, float* p_bounds_max);
+    };
+}
@@ -8,15 +8,18 @@ namespace CrossEngine
     protected:
 
         std::string shader_path;
+        // Compiled right after the #version line of the source.
+        std::string defines;
         unsigned int shader_id;
     public:
         /**
          * @brief Constructor for AShader.
          * 
          * @param p_shader_path The path to the shader file.
+         * @param p_defines The defines compiled after the #version line, one per line.
          */
-        AShader(const std::string& p_shader_path) noexcept
-            : shader_path(p_shader_path) {}
+        AShader(const std::string& p_shader_path, const std::string& p_defines = "") noexcept
+            : shader_path(p_shader_path), defines(p_defines) {}
 
         /**
          * @brief Destructor for AShader.
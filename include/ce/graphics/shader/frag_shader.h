@@ -11,8 +11,9 @@ namespace CrossEngine
          * @brief Construct a new Frag Shader object
          * 
          * @param p_shader_path The path to the shader file.
+         * @param p_defines The defines compiled after the #version line, one per line.
          */
-        FragShader(const std::string& p_shader_path);
+        FragShader(const std::string& p_shader_path, const std::string& p_defines = "");
 
         /**
          * @brief Get the shader type.
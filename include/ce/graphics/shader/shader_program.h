@@ -5,6 +5,9 @@
 #include "ce/math/math.hpp"
 #include "ce/component/point_light.h"
 #include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace CrossEngine
 {
@@ -16,7 +19,17 @@ namespace CrossEngine
         std::shared_ptr<AShader> frag_shader;
         std::mutex compile_mutex;
         bool usable = false;
-        mutable int sampler_count = 0;
+        // The texture unit of each sampler uniform, fixed when the program is linked. Unit 0 is left to the
+        // uploads, so binding a texture elsewhere never replaces a sampler's texture.
+        std::unordered_map<std::string, int> sampler_units;
+        // The texture bound to each unit by this program since it was last used, so binding it again is skipped.
+        // Other programs bind textures to the same units, so they are forgotten when the program is used, and
+        // a deleted texture's name can be reused, so they are forgotten when textures are deleted.
+        mutable std::vector<unsigned int> unit_textures;
+        mutable size_t unit_textures_serial = 0;
+
+        void AssignSamplerUnits();
+        void BindSampler(int p_unit, unsigned int p_target, unsigned int p_texture_id) const;
     public:
 
         /**
@@ -65,7 +78,12 @@ namespace CrossEngine
          * @param p_name The name of the uniform.
          * @param p_float The float to set the uniform to.
          */
-        void SetUniform(const std::string& p_name, float p_float) const;
+        void SetUniform(const char* p_name, float p_float) const;
+
+        /**
+         * @brief Set the uniform for the shader.
+         */
+        FORCE_INLINE void SetUniform(const std::string& p_name, float p_float) const { SetUniform(p_name.c_str(), p_float); }
 
         /**
          * @brief Set the uniform for the shader.
@@ -73,7 +91,12 @@ namespace CrossEngine
          * @param p_name The name of the uniform.
          * @param p_data The integer to set the uniform to.
          */
-        void SetUniform(const std::string& p_name, int p_int) const;
+        void SetUniform(const char* p_name, int p_int) const;
+
+        /**
+         * @brief Set the uniform for the shader.
+         */
+        FORCE_INLINE void SetUniform(const std::string& p_name, int p_int) const { SetUniform(p_name.c_str(), p_int); }
 
         /**
          * @brief Set the uniform for the shader.
@@ -81,7 +104,12 @@ namespace CrossEngine
          * @param p_name The name of the uniform.
          * @param p_mat4 The Math::Mat4f to set the uniform to.
          */
-        void SetUniform(const std::string& p_name, const Math::Mat4& p_mat4) const;
+        void SetUniform(const char* p_name, const Math::Mat4& p_mat4) const;
+
+        /**
+         * @brief Set the uniform for the shader.
+         */
+        FORCE_INLINE void SetUniform(const std::string& p_name, const Math::Mat4& p_mat4) const { SetUniform(p_name.c_str(), p_mat4); }
 
         /**
          * @brief Set the uniform for the shader.
@@ -89,7 +117,12 @@ namespace CrossEngine
          * @param p_name The name of the uniform.
          * @param p_vec4 TheMath::Vec4f to set the uniform to.
          */
-        void SetUniform(const std::string& p_name, const Math::Vec4& p_vec4) const;
+        void SetUniform(const char* p_name, const Math::Vec4& p_vec4) const;
+
+        /**
+         * @brief Set the uniform for the shader.
+         */
+        FORCE_INLINE void SetUniform(const std::string& p_name, const Math::Vec4& p_vec4) const { SetUniform(p_name.c_str(), p_vec4); }
 
         /**
          * @brief Set the sampler uniform for the shader.
@@ -97,7 +130,12 @@ namespace CrossEngine
          * @param p_name The name of the uniform.
          * @param p_texture_id The texture id to set the uniform to.
          */
-        void SetSampler2DUniform(const std::string& p_name, unsigned int p_texture_id) const;
+        void SetSampler2DUniform(const char* p_name, unsigned int p_texture_id) const;
+
+        /**
+         * @brief Set the sampler uniform for the shader.
+         */
+        FORCE_INLINE void SetSampler2DUniform(const std::string& p_name, unsigned int p_texture_id) const { SetSampler2DUniform(p_name.c_str(), p_texture_id); }
 
         /**
          * @brief Set the sampler uniform for the shader.
@@ -105,7 +143,25 @@ namespace CrossEngine
          * @param p_name The name of the uniform.
          * @param p_texture_id The texture id to set the uniform to.
          */
-        void SetSamplerCubeUniform(const std::string& p_name, unsigned int p_texture_id) const;
+        void SetSamplerCubeUniform(const char* p_name, unsigned int p_texture_id) const;
+
+        /**
+         * @brief Set the sampler uniform for the shader.
+         */
+        FORCE_INLINE void SetSamplerCubeUniform(const std::string& p_name, unsigned int p_texture_id) const { SetSamplerCubeUniform(p_name.c_str(), p_texture_id); }
+
+        /**
+         * @brief Set the sampler uniform for the shader.
+         * 
+         * @param p_name The name of the uniform.
+         * @param p_texture_id The id of the texture array to set the uniform to.
+         */
+        void SetSampler2DArrayUniform(const char* p_name, unsigned int p_texture_id) const;
+
+        /**
+         * @brief Set the sampler uniform for the shader.
+         */
+        FORCE_INLINE void SetSampler2DArrayUniform(const std::string& p_name, unsigned int p_texture_id) const { SetSampler2DArrayUniform(p_name.c_str(), p_texture_id); }
 
         /**
          * @brief Compile the shader program.
@@ -117,17 +173,12 @@ namespace CrossEngine
         void Compile();
 
         /**
-         * @brief Activate this shader program.
+         * @brief Activate this shader program. The textures bound to its samplers are bound again by the
+         * next calls setting them.
          * 
          */
         void Use();
 
-        /**
-         * @brief Refresh the shader program.
-         * 
-         */
-        void Refresh();
-
         /**
          * @brief Returns whether or not this shader program is usable.
          * The shader program will be usable if it has been successfully
@@ -152,6 +203,13 @@ namespace CrossEngine
          */
         FORCE_INLINE std::shared_ptr<AShader> GetFragShader() const { return frag_shader; }
 
-        FORCE_INLINE int GetSamplerNewIndex() const { return sampler_count++; }
+        /**
+         * @brief Get the texture unit of a sampler uniform. Each sampler of the program keeps its own unit, so
+         * samplers of different types never share one.
+         *
+         * @param p_name The name of the sampler uniform.
+         * @return int The texture unit, -1 if the program has no such sampler.
+         */
+        int GetSamplerUnit(const char* p_name) const;
     };
 }
\ No newline at end of file
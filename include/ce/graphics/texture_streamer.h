@@ -0,0 +1,201 @@
+#pragma once
+#include "ce/defs.hpp"
+#include "ce/texture/mip_chain.h"
+#include <vector>
+#include <deque>
+#include <memory>
+#include <future>
+#include <mutex>
+#include <atomic>
+
+namespace CrossEngine
+{
+    /**
+     * @brief A texture streamed by a texture streamer. The texture can be bound once its smallest level is
+     * uploaded, and gets sharper as the larger levels are uploaded.
+     */
+    class TextureStream
+    {
+    private:
+        friend class TextureStreamer;
+
+        unsigned int texture_id = 0;
+        std::shared_ptr<const MipChain> image;
+        std::atomic<size_t> uploaded_level_count = 0;
+        std::atomic<bool> is_cancelled = false;
+        // Held while a chunk is uploaded, so the texture is not released meanwhile.
+        std::mutex stream_mutex;
+        // The fence of the last chunk uploaded, waited for by the other contexts before they sample the texture.
+        void* upload_fence = nullptr;
+    public:
+        TextureStream(unsigned int p_texture_id, std::shared_ptr<const MipChain> p_image)
+            : texture_id(p_texture_id), image(std::move(p_image)) {}
+
+        ~TextureStream();
+
+        FORCE_INLINE unsigned int GetTexture() const noexcept { return texture_id; }
+
+        /**
+         * @brief Get the count of levels of the texture.
+         *
+         * @return size_t The count of levels.
+         */
+        FORCE_INLINE size_t GetLevelCount() const noexcept { return image->levels.size(); }
+
+        /**
+         * @brief Get the count of levels uploaded, from the smallest one. Can be called from any thread.
+         *
+         * @return size_t The count of uploaded levels.
+         */
+        FORCE_INLINE size_t GetUploadedLevelCount() const noexcept { return uploaded_level_count.load(std::memory_order_acquire); }
+
+        /**
+         * @brief Check if every level of the texture is uploaded.
+         *
+         * @return true if the texture is uploaded.
+         * @return false if some levels are still waiting.
+         */
+        FORCE_INLINE bool IsComplete() const noexcept { return GetUploadedLevelCount() == GetLevelCount(); }
+
+        /**
+         * @brief Skip the levels that are not uploaded yet. Must be called before the texture is deleted.
+         * Can be called from any thread.
+         */
+        void Cancel();
+
+        /**
+         * @brief Make the current context wait for the levels uploaded so far by the context of the streamer,
+         * before it samples the texture.
+         *
+         * @return true if the uploaded levels are finished, no context has to wait for them anymore.
+         * @return false if the uploaded levels may still be in progress.
+         */
+        bool WaitUpload();
+    };
+
+    /**
+     * @brief Textures uploaded over several frames through a ring of pixel buffers. The levels of a texture
+     * are uploaded from the smallest to the largest, a few rows at a time. The rows are copied to a mapped
+     * pixel buffer by a worker of the resource loader, and copied from the buffer to the texture by the
+     * thread of the window, so neither the thread of the window nor the transfer wait for each other.
+     * @details A pixel buffer is reused once the fence of its last transfer is signaled. The buffers are
+     * filled and transferred in the order of the ring.
+     * @note Except the streams, the streamer must only be used by the thread of the context it is created in.
+     */
+    class TextureStreamer
+    {
+    public:
+        /**
+         * @brief The default count of pixel buffers.
+         */
+        static constexpr size_t DEFAULT_SLOT_COUNT = 4;
+
+        /**
+         * @brief The default size of the pixel buffers in bytes. The levels larger than it are split by rows.
+         */
+        static constexpr size_t DEFAULT_SLOT_SIZE = 4 << 20;
+
+        /**
+         * @brief The size in bytes from which a texture is worth streaming, smaller textures are uploaded at once.
+         */
+        static constexpr size_t MIN_STREAMED_SIZE = 256 << 10;
+
+        /**
+         * @brief The rows of a level copied by one transfer.
+         */
+        struct Chunk
+        {
+            size_t level = 0;
+            size_t first_row = 0;
+            size_t row_count = 0;
+        };
+    private:
+        enum class SlotState
+        {
+            FREE,
+            FILLING,
+            IN_FLIGHT
+        };
+
+        struct Slot
+        {
+            unsigned int buffer = 0;
+            size_t capacity = 0;
+            SlotState state = SlotState::FREE;
+            std::future<void> fill;
+            void* fence = nullptr;
+            std::shared_ptr<TextureStream> stream;
+            Chunk chunk;
+        };
+
+        struct Job
+        {
+            std::shared_ptr<TextureStream> stream;
+            std::vector<Chunk> chunks;
+            size_t next_chunk = 0;
+        };
+
+        std::vector<Slot> slots;
+        size_t slot_size;
+        size_t fill_index = 0;
+        size_t transfer_index = 0;
+        std::deque<Job> jobs;
+
+        bool Fill(Slot& p_slot, std::shared_ptr<TextureStream> p_stream, const Chunk& p_chunk);
+        size_t Transfer(Slot& p_slot);
+    public:
+        /**
+         * @brief Construct a new texture streamer in the current context.
+         *
+         * @param p_slot_count The count of pixel buffers.
+         * @param p_slot_size The size of the pixel buffers in bytes.
+         */
+        TextureStreamer(size_t p_slot_count = DEFAULT_SLOT_COUNT, size_t p_slot_size = DEFAULT_SLOT_SIZE);
+
+        TextureStreamer(const TextureStreamer& p_other) = delete;
+        TextureStreamer& operator=(const TextureStreamer& p_other) = delete;
+
+        /**
+         * @brief Destroy the streamer and its pixel buffers, in the context it is created in. The streams that
+         * are not finished are left incomplete.
+         */
+        ~TextureStreamer();
+
+        /**
+         * @brief Split the levels of a texture to the chunks streamed, from the smallest level to the largest.
+         *
+         * @param p_image The levels of the texture.
+         * @param p_slot_size The size of the pixel buffers in bytes. A chunk has at least one row.
+         * @return std::vector<Chunk> The chunks.
+         */
+        static std::vector<Chunk> SplitLevels(const MipChain& p_image, size_t p_slot_size);
+
+        /**
+         * @brief Allocate the levels of a texture and start streaming its pixels.
+         *
+         * @param p_texture_id The texture.
+         * @param p_image The levels of the texture, with 1, 3 or 4 channels, or compressed in a format supported
+         * by the context.
+         * @throw std::runtime_error The image has no level, an unsupported number of channels, or an unsupported
+         * compressed format.
+         * @return std::shared_ptr<TextureStream> The stream of the texture.
+         */
+        std::shared_ptr<TextureStream> Stream(unsigned int p_texture_id, std::shared_ptr<const MipChain> p_image);
+
+        /**
+         * @brief Transfer the filled pixel buffers, and start filling the free ones. Called once every frame.
+         *
+         * @param p_byte_budget The bytes transferred in this frame. At least one chunk is transferred if one is
+         * ready, so a chunk larger than the budget still gets uploaded.
+         * @return size_t The bytes transferred.
+         */
+        size_t Update(size_t p_byte_budget);
+
+        /**
+         * @brief Get the count of textures with chunks not filled yet.
+         *
+         * @return size_t The count of textures.
+         */
+        FORCE_INLINE size_t GetPendingStreamCount() const noexcept { return jobs.size(); }
+    };
+}
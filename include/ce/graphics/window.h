@@ -8,9 +8,12 @@
 #include <vector>
 #include <map>
 #include <functional>
+#include <atomic>
 #include "ce/math/math.hpp"
 #include "ce/graphics/shader/shader_program.h"
 #include "ce/event/i_event_listener.h"
+#include "ce/graphics/gpu_resource_registry.h"
+#include "ce/utils/mpsc_queue.hpp"
 #include <memory>
 
 namespace CrossEngine
@@ -21,31 +24,33 @@ namespace CrossEngine
     class Skybox;
     class ATexture;
     class Renderer;
+    class OITPass;
+    class TextureStreamer;
     class Window : public IEventListener
     {
     private:
-        using ReleaseFunction = void(*)(int, const unsigned int*);
-        
-        struct ThreadResource
-        {
-            bool is_queue_freed;
-            unsigned int id;
-            ReleaseFunction destroy_func;
-            
-            ThreadResource(unsigned int p_id, ReleaseFunction p_destroy_func)
-                : id(p_id), destroy_func(p_destroy_func), is_queue_freed(false)
-            {}
-        };
-
-        mutable std::vector<ThreadResource> queued_thread_resources;
-        mutable std::mutex queued_thread_resources_mutex;
+        using ReleaseFunction = GPUResourceRegistry::ReleaseFunction;
+
+        mutable GPUResourceRegistry thread_resources;
         
         mutable size_t point_light_count = 0;
         mutable size_t parallel_light_count = 0;
 
+        mutable std::atomic<size_t> upload_bytes = 0;
+        size_t frame_upload_bytes = 0;
+
+        mutable MPSCQueue<std::function<void()>> upload_queue;
+        float upload_time_budget = DEFAULT_UPLOAD_TIME_BUDGET;
+        std::unique_ptr<TextureStreamer> texture_streamer;
+        size_t upload_byte_budget = DEFAULT_UPLOAD_BYTE_BUDGET;
+
         Renderer* current_renderer = nullptr;
         Renderer* main_renderer = nullptr;
         Renderer* skybox_renderer = nullptr;
+        OITPass* oit_pass = nullptr;
+        bool is_oit_enabled = false;
+        bool is_multi_draw_indirect_supported = false;
+        bool is_multi_draw_indirect_enabled = false;
 
     protected:
         void* glfw_context = nullptr;
@@ -63,7 +68,7 @@ namespace CrossEngine
         std::unique_ptr<std::thread> window_thread;
         bool is_closed = false;
         bool should_close = false;
-        Skybox* skybox = nullptr;
+        std::shared_ptr<Skybox> skybox;
 
         unsigned int vao = 0;
         
@@ -84,9 +89,19 @@ namespace CrossEngine
         static void OnMouseButton(void* p_glfw_context, int p_key, int p_action, int p_mods);
         static void OnMouseMove(void* p_glfw_context, double p_x, double p_y);
         void UpdateThreadResource();
+        void UpdateUploads();
         void ClearResource();
 
     public:
+        /**
+         * @brief The default time in seconds a frame spends on the queued uploads.
+         */
+        static constexpr float DEFAULT_UPLOAD_TIME_BUDGET = 0.002f;
+
+        /**
+         * @brief The default bytes a frame transfers to the streamed textures.
+         */
+        static constexpr size_t DEFAULT_UPLOAD_BYTE_BUDGET = 8 << 20;
 
         /**
          * @brief Constructor for window.
@@ -209,18 +224,66 @@ namespace CrossEngine
         /**
          * @brief Register a resource that needs to be freed at the end of the thread.
          * 
-         * @param p_context The context of the resource.
          * @param p_id The ID of the resource.
          * @param p_destroy_func The function to destroy the resource.
+         * @return GPUResourceRegistry::Handle The handle of the resource.
          */
-        void RegisterThreadResource(unsigned int p_id, ReleaseFunction p_destroy_func) const;
+        GPUResourceRegistry::Handle RegisterThreadResource(unsigned int p_id, ReleaseFunction p_destroy_func) const;
 
         /**
-         * @brief Free a resource that was registered.
+         * @brief Free a resource that was registered. The resource is destroyed by the thread of the window
+         * in its next frame. Can be called from any thread.
          * 
-         * @param p_id The ID of the resource.
+         * @param p_handle The handle of the resource.
+         */
+        void FreeThreadResource(const GPUResourceRegistry::Handle& p_handle) const;
+
+        /**
+         * @brief Queue an upload to be run by the thread of the window. Every frame, the thread runs the queued
+         * uploads in order until the upload time budget is spent, the rest wait for the next frames. Can be
+         * called from any thread.
+         * @note The uploads are dropped if the window is closed before they run.
+         * 
+         * @param p_upload The upload.
+         */
+        FORCE_INLINE void QueueUpload(std::function<void()> p_upload) const { upload_queue.Push(std::move(p_upload)); }
+
+        /**
+         * @brief Get the time in seconds a frame spends on the queued uploads.
+         * 
+         * @return float The upload time budget.
+         */
+        FORCE_INLINE float GetUploadTimeBudget() const noexcept { return upload_time_budget; }
+
+        /**
+         * @brief Set the time in seconds a frame spends on the queued uploads. At least one upload runs every
+         * frame, so an upload longer than the budget still runs.
+         * 
+         * @param p_budget The upload time budget.
+         */
+        FORCE_INLINE void SetUploadTimeBudget(float p_budget) noexcept { upload_time_budget = p_budget; }
+
+        /**
+         * @brief Get the texture streamer of the window. Must only be used by the thread of the window.
+         * 
+         * @return TextureStreamer* The texture streamer, nullptr if the window is not initialized.
+         */
+        FORCE_INLINE TextureStreamer* GetTextureStreamer() const noexcept { return texture_streamer.get(); }
+
+        /**
+         * @brief Get the bytes a frame transfers to the streamed textures.
+         * 
+         * @return size_t The upload byte budget.
+         */
+        FORCE_INLINE size_t GetUploadByteBudget() const noexcept { return upload_byte_budget; }
+
+        /**
+         * @brief Set the bytes a frame transfers to the streamed textures. At least one chunk of a texture is
+         * transferred every frame, so a chunk larger than the budget still gets uploaded.
+         * 
+         * @param p_budget The upload byte budget.
          */
-        void FreeThreadResource(unsigned int p_id) const;
+        FORCE_INLINE void SetUploadByteBudget(size_t p_budget) noexcept { upload_byte_budget = p_budget; }
 
     #ifdef _WIN32
         /**
@@ -244,6 +307,39 @@ namespace CrossEngine
          */
         void SetClearColor(const Math::Vec4& p_clear_color);
 
+        /**
+         * @brief Is weighted blended order independent transparency used to draw the prioritized materials.
+         * 
+         * @return true if order independent transparency is used.
+         * @return false if the prioritized materials are sorted back to front.
+         */
+        FORCE_INLINE bool IsOITEnabled() const noexcept { return is_oit_enabled; }
+
+        /**
+         * @brief Set whether weighted blended order independent transparency is used to draw the prioritized
+         * materials. When enabled, transparent meshes are not sorted, and the scene is drawn without multisampling.
+         * 
+         * @param p_enabled Should order independent transparency be used.
+         */
+        FORCE_INLINE void SetOITEnabled(bool p_enabled) noexcept { is_oit_enabled = p_enabled; }
+
+        /**
+         * @brief Are the instanced draws of a material submitted with a single multi-draw indirect call.
+         * 
+         * @return true if multi-draw indirect is enabled and supported by the context.
+         * @return false if every mesh data is drawn with its own instanced draw call.
+         */
+        FORCE_INLINE bool IsMultiDrawIndirectEnabled() const noexcept
+        { return is_multi_draw_indirect_enabled && is_multi_draw_indirect_supported; }
+
+        /**
+         * @brief Set whether the instanced draws of a material are submitted with a single multi-draw indirect
+         * call. Ignored when the context does not support it.
+         * 
+         * @param p_enabled Should multi-draw indirect be used.
+         */
+        FORCE_INLINE void SetMultiDrawIndirectEnabled(bool p_enabled) noexcept { is_multi_draw_indirect_enabled = p_enabled; }
+
         /**
          * @brief Hide and lock the cursor.
          * 
@@ -361,6 +457,20 @@ namespace CrossEngine
          */
         FORCE_INLINE int GetPointLightCount() const noexcept { return point_light_count; }
 
+        /**
+         * @brief Count the bytes uploaded to the buffers of this context in the current frame.
+         * 
+         * @param p_bytes The number of bytes uploaded.
+         */
+        FORCE_INLINE void AddUploadBytes(size_t p_bytes) const noexcept { upload_bytes += p_bytes; }
+
+        /**
+         * @brief Get the number of bytes uploaded to the buffers of this context in the last frame.
+         * 
+         * @return size_t The number of bytes uploaded in the last frame.
+         */
+        FORCE_INLINE size_t GetFrameUploadBytes() const noexcept { return frame_upload_bytes; }
+
         /**
          * @brief Get the number of parallel lights.
          * 
@@ -0,0 +1,104 @@
+#pragma once
+#include "ce/defs.hpp"
+#include "ce/math/math.hpp"
+#include "ce/texture/texture_array.h"
+#include "ce/utils/rectangle_packer.h"
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace CrossEngine
+{
+    struct MipChain;
+    class Window;
+
+    /**
+     * @brief The textures of a material to add to a MaterialAtlas. A missing texture is filled with the
+     * value of the default texture, white, or a flat normal.
+     */
+    struct MaterialTextures
+    {
+        const MipChain* albedo = nullptr;
+        const MipChain* normal = nullptr;
+        const MipChain* metallic = nullptr;
+        const MipChain* roughness = nullptr;
+        const MipChain* ao = nullptr;
+    };
+
+    /**
+     * @brief The textures of many materials packed into one texture array for each kind of texture, so the
+     * materials of the atlas bind the same textures.
+     * @details A material whose textures are as large as a layer takes a whole layer. Smaller ones are
+     * packed in the layers, the five textures of a material at the same place in their arrays, and the
+     * material samples its rectangle through a UV transform. The packed textures are aligned to and padded
+     * by the size of a pixel of the smallest level, with their edge pixels repeated, so their levels do not
+     * bleed into each other.
+     */
+    class MaterialAtlas
+    {
+    public:
+        static constexpr size_t TEXTURE_COUNT = 5;
+        static constexpr size_t DEFAULT_LEVEL_COUNT = 5;
+
+        /**
+         * @brief Where the textures of a material are in the atlas.
+         */
+        struct Entry
+        {
+            size_t layer = 0;
+            // The scale of the UV in xy, and its offset in zw.
+            Math::Vec4 uv_transform = Math::Vec4(1.0f, 1.0f, 0.0f, 0.0f);
+        };
+    private:
+        size_t page_size;
+        // The packed textures are placed on a grid of cells, a pixel of the smallest level each.
+        size_t cell_size;
+        std::vector<RectanglePacker> packers;
+        std::unique_ptr<TextureArray> arrays[TEXTURE_COUNT];
+        mutable std::mutex atlas_mutex;
+    public:
+        /**
+         * @brief Construct a new material atlas.
+         *
+         * @param p_page_size The width and height of the layers.
+         * @param p_layer_count The count of layers.
+         * @param p_level_count The count of levels of the layers. More levels pad the packed textures more.
+         * @throw std::invalid_argument The page size is not a multiple of the smallest level's pixels, or a
+         * count is 0.
+         */
+        MaterialAtlas(size_t p_page_size, size_t p_layer_count, size_t p_level_count = DEFAULT_LEVEL_COUNT);
+
+        MaterialAtlas(const MaterialAtlas&) = delete;
+
+        FORCE_INLINE size_t GetPageSize() const noexcept { return page_size; }
+        FORCE_INLINE size_t GetLayerCount() const noexcept { return packers.size(); }
+
+        /**
+         * @brief Get the texture array of a kind of texture.
+         *
+         * @param p_index The kind of texture, in the order of MaterialTextures.
+         * @return TextureArray* The texture array.
+         */
+        FORCE_INLINE TextureArray* GetArray(size_t p_index) const noexcept { return arrays[p_index].get(); }
+
+        /**
+         * @brief Add the textures of a material. The textures should bring their smaller levels, built as
+         * their content needs, the others are built with the default MipConfig.
+         *
+         * @param p_textures The textures, not compressed, all of the same size.
+         * @throw std::invalid_argument The textures are compressed, of different sizes, or larger than a layer.
+         * @throw std::runtime_error There is no room left in the atlas.
+         * @return Entry Where the textures are.
+         */
+        Entry Add(const MaterialTextures& p_textures);
+
+        /**
+         * @brief Bind the texture arrays of the atlas.
+         *
+         * @param p_context The context to bind in.
+         * @param p_uniform_name The name of the uniform struct with a sampler2DArray for each kind of texture.
+         */
+        void BindTextures(Window* p_context, const std::string& p_uniform_name) const;
+    };
+}
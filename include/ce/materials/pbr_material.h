@@ -1,6 +1,9 @@
 #pragma once
 #include "ce/materials/material.h"
+#include "ce/materials/material_atlas.h"
 #include "ce/math/math.hpp"
+#include "ce/texture/mip_chain.h"
+#include <string>
 
 namespace CrossEngine
 {
@@ -10,6 +13,8 @@ namespace CrossEngine
         Math::Vec4 scaler_albedo;
         float scaler_roughness;
         float scaler_metallic;
+        std::shared_ptr<MaterialAtlas> atlas;
+        MaterialAtlas::Entry atlas_entry;
     public:
         /**
          * @brief Construct a new PBRMaterial object.
@@ -26,6 +31,51 @@ namespace CrossEngine
          */
         PBRMaterial(const Math::Vec4& p_albedo, float p_roughness, float p_metallic, bool p_should_prioritize = false);
 
+        /**
+         * @brief Load the albedo of the material, shared with the other loads of the file.
+         * 
+         * @param p_path The path to the texture file.
+         * @param p_content What the pixels of the texture hold, sRGB colors by default.
+         * @throw std::runtime_error Failed to load the texture file.
+         */
+        void LoadAlbedo(const std::string& p_path, TextureContent p_content = TextureContent::SRGB);
+
+        /**
+         * @brief Load the normal of the material, shared with the other loads of the file.
+         * 
+         * @param p_path The path to the texture file.
+         * @param p_content What the pixels of the texture hold, normals by default.
+         * @throw std::runtime_error Failed to load the texture file.
+         */
+        void LoadNormal(const std::string& p_path, TextureContent p_content = TextureContent::NORMAL);
+
+        /**
+         * @brief Load the metallic of the material, shared with the other loads of the file.
+         * 
+         * @param p_path The path to the texture file.
+         * @param p_content What the pixels of the texture hold.
+         * @throw std::runtime_error Failed to load the texture file.
+         */
+        void LoadMetallic(const std::string& p_path, TextureContent p_content = TextureContent::LINEAR);
+
+        /**
+         * @brief Load the roughness of the material, shared with the other loads of the file.
+         * 
+         * @param p_path The path to the texture file.
+         * @param p_content What the pixels of the texture hold.
+         * @throw std::runtime_error Failed to load the texture file.
+         */
+        void LoadRoughness(const std::string& p_path, TextureContent p_content = TextureContent::LINEAR);
+
+        /**
+         * @brief Load the ambient occlusion of the material, shared with the other loads of the file.
+         * 
+         * @param p_path The path to the texture file.
+         * @param p_content What the pixels of the texture hold.
+         * @throw std::runtime_error Failed to load the texture file.
+         */
+        void LoadAO(const std::string& p_path, TextureContent p_content = TextureContent::LINEAR);
+
         /**
          * @brief Get the albedo of the material.
          * 
@@ -166,6 +216,33 @@ namespace CrossEngine
          */
         FORCE_INLINE float& MetallicScaler() noexcept { return scaler_metallic; }
 
+        /**
+         * @brief Sample the textures of the material from an atlas instead of its own textures, so the
+         * materials of the atlas bind the same texture arrays.
+         *
+         * @param p_atlas The atlas, nullptr to sample the textures of the material again.
+         * @param p_entry Where the textures of the material are in the atlas, returned by MaterialAtlas::Add.
+         */
+        FORCE_INLINE void SetAtlas(std::shared_ptr<MaterialAtlas> p_atlas, const MaterialAtlas::Entry& p_entry) noexcept
+        {
+            atlas = std::move(p_atlas);
+            atlas_entry = p_entry;
+        }
+
+        /**
+         * @brief Get the atlas the textures of the material are sampled from.
+         *
+         * @return const std::shared_ptr<MaterialAtlas>& The atlas, nullptr if the material samples its own textures.
+         */
+        FORCE_INLINE const std::shared_ptr<MaterialAtlas>& GetAtlas() const noexcept { return atlas; }
+
+        /**
+         * @brief Get where the textures of the material are in its atlas.
+         *
+         * @return const MaterialAtlas::Entry& The entry of the material.
+         */
+        FORCE_INLINE const MaterialAtlas::Entry& GetAtlasEntry() const noexcept { return atlas_entry; }
+
         /**
          * @brief Set the uniform for this material.
          * 
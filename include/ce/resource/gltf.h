@@ -0,0 +1,217 @@
+#pragma once
+#include "ce/defs.hpp"
+#include "ce/resource/virtual_file_system.h"
+#include "ce/utils/json.h"
+#include "ce/math/math.hpp"
+#include <vector>
+#include <string>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <cstdint>
+
+namespace CrossEngine
+{
+    class MeshCache;
+    struct MeshCacheSource;
+    class Component3D;
+    class PBRMaterial;
+
+    /**
+     * @brief A view of an accessor of a glTF asset. The view points into the mapped binary chunk,
+     * nothing is copied until the elements are read.
+     */
+    struct GltfAccessor
+    {
+        static constexpr uint32_t BYTE = 5120;
+        static constexpr uint32_t UNSIGNED_BYTE = 5121;
+        static constexpr uint32_t SHORT = 5122;
+        static constexpr uint32_t UNSIGNED_SHORT = 5123;
+        static constexpr uint32_t UNSIGNED_INT = 5125;
+        static constexpr uint32_t FLOAT = 5126;
+
+        const std::byte* data = nullptr;
+        size_t count = 0;
+        // The count of bytes from an element to the next one.
+        size_t stride = 0;
+        uint32_t component_type = 0;
+        size_t component_count = 0;
+        bool normalized = false;
+
+        /**
+         * @brief Get the size of a component of the accessor in bytes.
+         *
+         * @return size_t The size of a component.
+         */
+        size_t GetComponentSize() const noexcept;
+
+        /**
+         * @brief Check if the elements are packed without gaps.
+         *
+         * @return true The elements are packed.
+         * @return false There are gaps between the elements.
+         */
+        FORCE_INLINE bool IsPacked() const noexcept { return stride == GetComponentSize() * component_count; }
+
+        /**
+         * @brief Get the components of a packed accessor as a span.
+         *
+         * @tparam T The type of the components.
+         * @throw std::runtime_error The accessor is not packed, or its components are not of the type.
+         * @return std::span<const T> The components of every element.
+         */
+        template <typename T>
+        std::span<const T> AsSpan() const
+        {
+            if (!IsPacked() || sizeof(T) != GetComponentSize() || (component_type == FLOAT) != std::is_floating_point_v<T>
+                || reinterpret_cast<uintptr_t>(data) % alignof(T) != 0)
+                throw std::runtime_error("The accessor cannot be viewed as a span of the type.");
+            return std::span<const T>(reinterpret_cast<const T*>(data), count * component_count);
+        }
+
+        /**
+         * @brief Read a component as a float. Normalized integers are converted to [0, 1] or [-1, 1].
+         *
+         * @param p_index The index of the element.
+         * @param p_component The index of the component.
+         * @return float The component.
+         */
+        float GetFloat(size_t p_index, size_t p_component) const noexcept;
+
+        /**
+         * @brief Read an element of an index accessor, of an unsigned integer type.
+         *
+         * @param p_index The index of the element.
+         * @return uint32_t The index.
+         */
+        uint32_t GetIndex(size_t p_index) const noexcept;
+    };
+
+    /**
+     * @brief A primitive of a mesh of a glTF asset, decoded to a vertex stream.
+     */
+    struct GltfPrimitive
+    {
+        std::shared_ptr<const MeshCache> cache;
+        // The index of the material, -1 if the primitive uses the default material.
+        int64_t material = -1;
+    };
+
+    /**
+     * @brief The components created from a glTF asset. The components are linked by weak links, so the
+     * scene owns every component of the hierarchy.
+     */
+    struct GltfScene
+    {
+        std::shared_ptr<Component3D> root;
+        std::vector<std::shared_ptr<Component3D>> components;
+        std::vector<std::shared_ptr<PBRMaterial>> materials;
+    };
+
+    /**
+     * @brief A binary glTF 2.0 asset (.glb). The file is opened through the virtual file system, and the
+     * accessors are read in place from the binary chunk.
+     * @note The buffers are read from the binary chunk, and the images from the binary chunk or from
+     * external files. Data URIs are not supported.
+     */
+    class GltfAsset : public std::enable_shared_from_this<GltfAsset>
+    {
+    public:
+        /**
+         * @brief The magic number at the start of a .glb file, "glTF".
+         */
+        static constexpr uint32_t MAGIC = 0x46546C67;
+    private:
+        std::string path;
+        VirtualFile file;
+        Json document;
+        const std::byte* binary = nullptr;
+        size_t binary_size = 0;
+
+        std::span<const std::byte> GetBuffer(size_t p_index) const;
+    public:
+        /**
+         * @brief Open a .glb file and parse its json chunk.
+         *
+         * @param p_path The path to the file.
+         * @throw std::runtime_error Failed to open the file, or the file is not a valid glTF 2.0 binary.
+         */
+        explicit GltfAsset(const std::string& p_path);
+
+        GltfAsset(const GltfAsset& p_other) = delete;
+        GltfAsset& operator=(const GltfAsset& p_other) = delete;
+
+        FORCE_INLINE const std::string& GetPath() const noexcept { return path; }
+
+        /**
+         * @brief Get the json document of the asset.
+         *
+         * @return const Json& The document.
+         */
+        FORCE_INLINE const Json& GetDocument() const noexcept { return document; }
+
+        /**
+         * @brief Get a buffer view.
+         *
+         * @param p_index The index of the buffer view.
+         * @throw std::runtime_error The buffer view is out of range.
+         * @return std::span<const std::byte> The bytes of the buffer view.
+         */
+        std::span<const std::byte> GetBufferView(size_t p_index) const;
+
+        /**
+         * @brief Get an accessor.
+         *
+         * @param p_index The index of the accessor.
+         * @throw std::runtime_error The accessor is invalid or out of range.
+         * @return GltfAccessor The view of the accessor.
+         */
+        GltfAccessor GetAccessor(size_t p_index) const;
+
+        /**
+         * @brief Decode the triangles of every mesh. The primitives are decoded in parallel.
+         * @note Primitives of points and lines are skipped.
+         *
+         * @throw std::runtime_error A primitive is invalid.
+         * @return std::vector<std::vector<GltfPrimitive>> The primitives of every mesh.
+         */
+        std::vector<std::vector<GltfPrimitive>> DecodeMeshes() const;
+
+        /**
+         * @brief Get the local transform of a node, in the conventions of Component3D.
+         *
+         * @param p_node The index of the node.
+         * @param p_translation This will be set to the translation.
+         * @param p_rotation This will be set to the quaternion rotation.
+         * @param p_scale This will be set to the scale.
+         */
+        void GetNodeTransform(size_t p_node, Math::Vec4& p_translation, Math::Vec4& p_rotation, Math::Vec4& p_scale) const;
+
+        /**
+         * @brief Get the root nodes of the default scene, or the nodes without parent if there is no scene.
+         *
+         * @return std::vector<size_t> The indices of the root nodes.
+         */
+        std::vector<size_t> GetRootNodes() const;
+
+        /**
+         * @brief Merge the meshes of every node into a mesh cache, with the node transforms applied.
+         *
+         * @param p_source The source the mesh cache is converted from.
+         * @throw std::runtime_error A mesh or a node is invalid.
+         * @return MeshCache The mesh cache.
+         */
+        MeshCache CreateMeshCache(const MeshCacheSource& p_source) const;
+
+        /**
+         * @brief Create the component hierarchy of the asset. A node becomes a Component3D, and the primitives
+         * of its mesh become StaticMesh children of it. The textures are decoded in the background when they are
+         * first bound, the default textures of the engine are bound until then.
+         * @note The asset must be owned by a shared pointer, the textures keep it alive until they are decoded.
+         *
+         * @return GltfScene The components.
+         */
+        GltfScene CreateScene() const;
+    };
+}
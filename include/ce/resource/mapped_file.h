@@ -0,0 +1,71 @@
+#pragma once
+#include "ce/defs.hpp"
+#include <string>
+#include <string_view>
+#include <memory>
+
+namespace CrossEngine
+{
+    /**
+     * @brief A read only view of a file mapped into memory. The pages of the file are loaded by the system
+     * when they are read, so the file is never copied into a buffer of the engine.
+     * @note If the file cannot be mapped, it is read into a buffer owned by the view instead.
+     */
+    class MappedFile
+    {
+    private:
+        const byte_t* data = nullptr;
+        size_t size = 0;
+        void* mapping = nullptr;
+        std::unique_ptr<byte_t[]> buffer;
+
+        void Release() noexcept;
+    public:
+        /**
+         * @brief Map a file into memory.
+         *
+         * @param p_path The path to the file.
+         * @throw std::runtime_error Failed to open file.
+         */
+        explicit MappedFile(const std::string& p_path);
+
+        MappedFile(const MappedFile& p_other) = delete;
+        MappedFile& operator=(const MappedFile& p_other) = delete;
+        MappedFile(MappedFile&& p_other) noexcept;
+        MappedFile& operator=(MappedFile&& p_other) noexcept;
+
+        /**
+         * @brief Unmap the file.
+         */
+        ~MappedFile();
+
+        /**
+         * @brief Get the data of the file.
+         *
+         * @return const byte_t* The data of the file, nullptr if the file is empty.
+         */
+        FORCE_INLINE const byte_t* GetData() const noexcept { return data; }
+
+        /**
+         * @brief Get the size of the file.
+         *
+         * @return size_t The size of the file in bytes.
+         */
+        FORCE_INLINE size_t GetSize() const noexcept { return size; }
+
+        /**
+         * @brief Get the content of the file as text.
+         *
+         * @return std::string_view The content of the file.
+         */
+        FORCE_INLINE std::string_view GetText() const noexcept { return std::string_view(data, size); }
+
+        /**
+         * @brief Check if the file is mapped, or read into a buffer because mapping failed.
+         *
+         * @return true The file is mapped.
+         * @return false The file is read into a buffer.
+         */
+        FORCE_INLINE bool IsMapped() const noexcept { return mapping != nullptr; }
+    };
+}
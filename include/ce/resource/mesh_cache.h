@@ -0,0 +1,226 @@
+#pragma once
+#include "ce/defs.hpp"
+#include "ce/resource/virtual_file_system.h"
+#include "ce/geometry/triangle.h"
+#include <vector>
+#include <string>
+#include <memory>
+#include <functional>
+#include <cstdint>
+
+namespace CrossEngine
+{
+    class GeometryArena;
+
+    /**
+     * @brief The header at the start of a mesh cache file. Every section of the file starts at a
+     * multiple of MeshCache::ALIGNMENT, so the streams are read in place from the mapped file.
+     */
+    struct MeshCacheHeader
+    {
+        char magic[8];
+        uint32_t version;
+        // The count of floats of a vertex.
+        uint32_t vertex_stride;
+        uint64_t vertex_count;
+        uint64_t index_count;
+        uint64_t lod_count;
+        uint64_t vertex_offset;
+        uint64_t index_offset;
+        uint64_t lod_offset;
+        // The source the cache is converted from.
+        uint64_t source_size;
+        int64_t source_time;
+        uint64_t source_hash;
+        float bounds_min[3];
+        float bounds_max[3];
+    };
+
+    /**
+     * @brief A level of detail of a mesh cache, a range of the vertex stream and of the index stream.
+     * The index range is empty if the level is drawn without indices.
+     */
+    struct MeshCacheLod
+    {
+        uint32_t first_vertex;
+        uint32_t vertex_count;
+        uint32_t first_index;
+        uint32_t index_count;
+    };
+
+    /**
+     * @brief The identity of the source file of a mesh cache.
+     */
+    struct MeshCacheSource
+    {
+        uint64_t size = 0;
+        int64_t time = 0;
+        uint64_t hash = 0;
+    };
+
+    /**
+     * @brief A binary mesh converted from a model file. The vertices are stored in the layout of the vertex
+     * buffers, so a mapped cache is uploaded without being parsed or converted.
+     */
+    class MeshCache
+    {
+    public:
+        /**
+         * @brief The version of the format, caches of other versions are converted again.
+         */
+        static constexpr uint32_t VERSION = 1;
+
+        /**
+         * @brief The alignment of the sections of the file.
+         */
+        static constexpr size_t ALIGNMENT = 64;
+
+        /**
+         * @brief The extension of mesh cache files.
+         */
+        static constexpr const char* EXTENSION = ".cemesh";
+    private:
+        VirtualFile file;
+        std::vector<std::byte> memory;
+        const std::byte* data = nullptr;
+        size_t size = 0;
+
+        MeshCache() = default;
+
+        const MeshCacheHeader& GetHeader() const noexcept { return *reinterpret_cast<const MeshCacheHeader*>(data); }
+        void Validate(const std::string& p_name) const;
+
+        // Allocate a cache in memory with a level of detail per count, the vertices are left to be written.
+        static MeshCache Allocate(const std::vector<size_t>& p_lod_vertex_counts, const MeshCacheSource& p_source);
+        float* GetVertexData() noexcept { return reinterpret_cast<float*>(memory.data() + GetHeader().vertex_offset); }
+        void UpdateBounds() noexcept;
+    public:
+        /**
+         * @brief Open a mesh cache file through the virtual file system.
+         *
+         * @param p_path The path to the mesh cache file.
+         * @throw std::runtime_error Failed to open the file, or the file is not a valid mesh cache.
+         */
+        explicit MeshCache(const std::string& p_path);
+
+        MeshCache(const MeshCache& p_other) = delete;
+        MeshCache& operator=(const MeshCache& p_other) = delete;
+        MeshCache(MeshCache&& p_other) noexcept = default;
+        MeshCache& operator=(MeshCache&& p_other) noexcept = default;
+
+        /**
+         * @brief Convert the levels of detail of a mesh to a mesh cache in memory.
+         *
+         * @param p_lods The triangles of every level of detail, the first level is the mesh itself.
+         * @param p_source The source the mesh is loaded from.
+         * @return MeshCache The mesh cache.
+         */
+        static MeshCache Create(const std::vector<std::vector<Triangle*>>& p_lods, const MeshCacheSource& p_source = {});
+
+        /**
+         * @brief Create a mesh cache in memory by writing its vertex stream in place.
+         *
+         * @param p_vertex_count The count of vertices, three vertices per triangle.
+         * @param p_write Write the vertex stream, Vertex::ARRAY_SIZE floats per vertex in the layout of the
+         * vertex buffers.
+         * @param p_source The source the mesh is loaded from.
+         * @throw std::invalid_argument The vertex count is not a multiple of 3.
+         * @return MeshCache The mesh cache.
+         */
+        static MeshCache Create(size_t p_vertex_count, const std::function<void(float* p_vertices)>& p_write, const MeshCacheSource& p_source = {});
+
+        /**
+         * @brief Get the path of the mesh cache of a model file.
+         *
+         * @param p_source_path The path to the model file.
+         * @return std::string The path of the mesh cache.
+         */
+        static std::string GetCachePath(const std::string& p_source_path);
+
+        /**
+         * @brief Get the identity of a source file on the disk.
+         *
+         * @param p_path The path on the disk to the source file, see VirtualFileSystem::GetDiskPath.
+         * @param p_hash If the content of the file is hashed.
+         * @throw std::runtime_error Failed to open file.
+         * @return MeshCacheSource The identity of the file.
+         */
+        static MeshCacheSource IdentifySource(const std::string& p_path, bool p_hash = true);
+
+        /**
+         * @brief Open the mesh cache next to a model file on the disk if it is up to date.
+         *
+         * @param p_source_path The path on the disk to the model file, see VirtualFileSystem::GetDiskPath.
+         * @return std::unique_ptr<MeshCache> The mesh cache, nullptr if there is no valid cache for the
+         * current content of the model file.
+         */
+        static std::unique_ptr<MeshCache> Open(const std::string& p_source_path);
+
+        /**
+         * @brief Write the mesh cache to a file. The file is replaced at once, so readers never see
+         * a partial cache.
+         *
+         * @param p_path The path of the file.
+         * @throw std::runtime_error Failed to write the file.
+         */
+        void Save(const std::string& p_path) const;
+
+        /**
+         * @brief Check if the cache is converted from the current content of a source file. The size and
+         * the modification time are compared first, the content is only hashed if the time differs.
+         *
+         * @param p_source_path The path on the disk to the source file.
+         * @return true The cache is up to date, or the source file does not exist.
+         * @return false The source file has changed.
+         */
+        bool IsUpToDate(const std::string& p_source_path) const;
+
+        /**
+         * @brief Create the triangles of a level of detail.
+         *
+         * @param p_result The result triangles. The triangles will be pushed back to this vector.
+         * @param p_arena The arena to create the triangles in, the triangles are created by the triangle
+         * pool if it is nullptr.
+         * @param p_lod The level of detail.
+         */
+        void CreateTriangles(std::vector<Triangle*>& p_result, GeometryArena* p_arena = nullptr, size_t p_lod = 0) const;
+
+        /**
+         * @brief Get the vertex stream, Vertex::ARRAY_SIZE floats per vertex.
+         *
+         * @return const float* The vertex stream.
+         */
+        FORCE_INLINE const float* GetVertices() const noexcept { return reinterpret_cast<const float*>(data + GetHeader().vertex_offset); }
+
+        /**
+         * @brief Get the index stream.
+         *
+         * @return const uint32_t* The index stream.
+         */
+        FORCE_INLINE const uint32_t* GetIndices() const noexcept { return reinterpret_cast<const uint32_t*>(data + GetHeader().index_offset); }
+
+        FORCE_INLINE size_t GetVertexCount() const noexcept { return GetHeader().vertex_count; }
+        FORCE_INLINE size_t GetIndexCount() const noexcept { return GetHeader().index_count; }
+        FORCE_INLINE size_t GetLodCount() const noexcept { return GetHeader().lod_count; }
+
+        /**
+         * @brief Get a level of detail.
+         *
+         * @param p_lod The level of detail.
+         * @return const MeshCacheLod& The ranges of the level of detail.
+         */
+        FORCE_INLINE const MeshCacheLod& GetLod(size_t p_lod) const { return reinterpret_cast<const MeshCacheLod*>(data + GetHeader().lod_offset)[p_lod]; }
+
+        FORCE_INLINE Math::Vec4 GetBoundsMin() const noexcept { return Math::Pos(GetHeader().bounds_min[0], GetHeader().bounds_min[1], GetHeader().bounds_min[2]); }
+        FORCE_INLINE Math::Vec4 GetBoundsMax() const noexcept { return Math::Pos(GetHeader().bounds_max[0], GetHeader().bounds_max[1], GetHeader().bounds_max[2]); }
+        FORCE_INLINE MeshCacheSource GetSource() const noexcept { return {GetHeader().source_size, GetHeader().source_time, GetHeader().source_hash}; }
+
+        /**
+         * @brief Check if the cache is read in place from a file.
+         *
+         * @return true The cache is read from a file.
+         * @return false The cache is in memory.
+         */
+        FORCE_INLINE bool IsMapped() const noexcept { return file.GetData() != nullptr; }
+    };
+}
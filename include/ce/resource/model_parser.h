@@ -0,0 +1,61 @@
+#pragma once
+#include "ce/defs.hpp"
+#include "ce/geometry/triangle.h"
+#include <vector>
+#include <string_view>
+
+namespace CrossEngine
+{
+    class GeometryArena;
+
+    /**
+     * @brief Parsers of the text model formats. The numbers are parsed in place from the text without
+     * copying the lines or the words. Large texts are split into chunks on line boundaries, the chunks are
+     * parsed in parallel and their results are merged in the order of the text.
+     */
+    class ModelParser
+    {
+    public:
+        /**
+         * @brief The smallest chunk of a text parsed by a thread.
+         */
+        static constexpr size_t MIN_CHUNK_SIZE = 1 << 20;
+
+        ModelParser() = delete;
+
+        /**
+         * @brief Parse the triangles of a tris file.
+         *
+         * @param p_text The text of the tris file.
+         * @param p_result The result triangles. The triangles will be pushed back to this vector.
+         * @param p_arena The arena to create the triangles in, the triangles are created by the triangle
+         * pool if it is nullptr.
+         * @throw std::runtime_error The text is not a valid tris file.
+         */
+        static void ParseTris(std::string_view p_text, std::vector<Triangle*>& p_result, GeometryArena* p_arena = nullptr);
+
+        /**
+         * @brief Parse the triangles of a tris with normal file.
+         *
+         * @param p_text The text of the tris with normal file.
+         * @param p_result The result triangles. The triangles will be pushed back to this vector.
+         * @param p_arena The arena to create the triangles in, the triangles are created by the triangle
+         * pool if it is nullptr.
+         * @throw std::runtime_error The text is not a valid tris with normal file.
+         */
+        static void ParseTrisWithNormal(std::string_view p_text, std::vector<Triangle*>& p_result, GeometryArena* p_arena = nullptr);
+
+        /**
+         * @brief Parse the triangles of an obj file. The faces can reference the texture coordinates and the
+         * normals or leave them out, and can use negative indices. The normals of the faces without normals
+         * are induced from their positions.
+         *
+         * @param p_text The text of the obj file.
+         * @param p_result The result triangles. The triangles will be pushed back to this vector.
+         * @param p_arena The arena to create the triangles in, the triangles are created by the triangle
+         * pool if it is nullptr.
+         * @throw std::runtime_error The text is not a valid obj file.
+         */
+        static void ParseObj(std::string_view p_text, std::vector<Triangle*>& p_result, GeometryArena* p_arena = nullptr);
+    };
+}
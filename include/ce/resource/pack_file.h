@@ -0,0 +1,187 @@
+#pragma once
+#include "ce/defs.hpp"
+#include "ce/resource/mapped_file.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <span>
+#include <cstdint>
+
+namespace CrossEngine
+{
+    /**
+     * @brief An archive of many files in a single mapped file. The table of contents is a hash table read in
+     * place, and the entries of a page or more start at page boundaries, so an uncompressed entry is read
+     * without copying.
+     * @details The file starts with a Header, followed by the hash table of Entry, the names of the entries,
+     * and the data of the entries. An entry is either stored as is, or compressed in LZ4 block format.
+     */
+    class PackFile
+    {
+    public:
+        /**
+         * @brief The magic number at the start of a pack file, "CEPK".
+         */
+        static constexpr uint32_t MAGIC = 0x4B504543;
+        static constexpr uint32_t VERSION = 1;
+
+        /**
+         * @brief The alignment of the data of the entries of a page or more.
+         */
+        static constexpr size_t PAGE_SIZE = 4096;
+
+        /**
+         * @brief The extension of pack files.
+         */
+        static constexpr const char* EXTENSION = ".pack";
+
+        static constexpr uint32_t COMPRESSION_NONE = 0;
+        static constexpr uint32_t COMPRESSION_LZ4 = 1;
+
+        struct Header
+        {
+            uint32_t magic;
+            uint32_t version;
+            uint64_t entry_count;
+            // The count of slots of the hash table, a power of 2.
+            uint64_t slot_count;
+            uint64_t table_offset;
+            uint64_t names_offset;
+            uint64_t names_size;
+        };
+
+        /**
+         * @brief A slot of the hash table. The slots without name are empty.
+         */
+        struct Entry
+        {
+            uint64_t hash;
+            uint64_t offset;
+            // The size of the data of the entry.
+            uint64_t size;
+            // The size of the data stored in the file, compressed or not.
+            uint64_t stored_size;
+            uint32_t name_offset;
+            uint32_t name_size;
+            uint32_t compression;
+            uint32_t reserved;
+        };
+
+        /**
+         * @brief A file to add to a pack.
+         */
+        struct Source
+        {
+            // The name of the entry, with '/' separators.
+            std::string name;
+            // The path of the file to read the entry from.
+            std::string path;
+        };
+    private:
+        std::string path;
+        MappedFile file;
+        const Header* header = nullptr;
+        const Entry* table = nullptr;
+        const byte_t* names = nullptr;
+    public:
+        /**
+         * @brief Map a pack file.
+         *
+         * @param p_path The path to the pack file.
+         * @throw std::runtime_error Failed to open the file, or the file is not a valid pack.
+         */
+        explicit PackFile(const std::string& p_path);
+
+        PackFile(const PackFile& p_other) = delete;
+        PackFile& operator=(const PackFile& p_other) = delete;
+
+        FORCE_INLINE const std::string& GetPath() const noexcept { return path; }
+
+        /**
+         * @brief Get the count of entries of the pack.
+         *
+         * @return size_t The count of entries.
+         */
+        FORCE_INLINE size_t GetEntryCount() const noexcept { return header->entry_count; }
+
+        /**
+         * @brief Hash the name of an entry.
+         *
+         * @param p_name The name of the entry.
+         * @return uint64_t The hash of the name.
+         */
+        static uint64_t HashName(std::string_view p_name) noexcept;
+
+        /**
+         * @brief Find an entry.
+         *
+         * @param p_name The name of the entry, with '/' separators.
+         * @return const Entry* The entry, nullptr if there is no such entry.
+         */
+        const Entry* Find(std::string_view p_name) const noexcept;
+
+        /**
+         * @brief Get the name of an entry.
+         *
+         * @param p_entry The entry.
+         * @return std::string_view The name of the entry.
+         */
+        FORCE_INLINE std::string_view GetName(const Entry& p_entry) const noexcept
+        { return std::string_view(names + p_entry.name_offset, p_entry.name_size); }
+
+        /**
+         * @brief Get the entries of the pack, in the order of the hash table.
+         *
+         * @return std::vector<const Entry*> The entries.
+         */
+        std::vector<const Entry*> GetEntries() const;
+
+        /**
+         * @brief Get the stored data of an entry in place. The data is compressed if the entry is compressed.
+         *
+         * @param p_entry The entry.
+         * @return std::span<const byte_t> The stored data, valid as long as the pack.
+         */
+        FORCE_INLINE std::span<const byte_t> GetStoredData(const Entry& p_entry) const noexcept
+        { return std::span<const byte_t>(file.GetData() + p_entry.offset, p_entry.stored_size); }
+
+        /**
+         * @brief Read the data of an entry, decompressing it if it is compressed.
+         *
+         * @param p_entry The entry.
+         * @param p_buffer The buffer to read the data to, at least the size of the entry.
+         * @throw std::runtime_error The compressed data is corrupted.
+         */
+        void Read(const Entry& p_entry, byte_t* p_buffer) const;
+
+        /**
+         * @brief Write a pack file.
+         *
+         * @param p_path The path of the pack file.
+         * @param p_sources The files to add to the pack.
+         * @param p_compress Should the entries be compressed. An entry is only compressed if it gets smaller.
+         * @throw std::runtime_error Failed to read a file or to write the pack, or two files have the same name.
+         */
+        static void Create(const std::string& p_path, const std::vector<Source>& p_sources, bool p_compress);
+
+        /**
+         * @brief Compress data in LZ4 block format.
+         *
+         * @param p_data The data to compress.
+         * @param p_size The size of the data.
+         * @return std::vector<byte_t> The compressed data.
+         */
+        static std::vector<byte_t> Compress(const byte_t* p_data, size_t p_size);
+
+        /**
+         * @brief Decompress data in LZ4 block format.
+         *
+         * @param p_data The compressed data.
+         * @param p_size The size of the compressed data.
+         * @param p_buffer The buffer to decompress to.
+         * @param p_buffer_size The size of the decompressed data.
+         * @throw std::runtime_error The data is corrupted, or does not decompress to the size of the buffer.
+         */
+        static void Decompress(const byte_t* p_data, size_t p_size, byte_t* p_buffer, size_t p_buffer_size);
+    };
+}
@@ -1,10 +1,20 @@
 #pragma once
 #include "ce/defs.hpp"
 #include <vector>
+#include <memory>
 #include "ce/geometry/triangle.h"
+#include "ce/resource/resource_cache.hpp"
 
 namespace CrossEngine
 {
+    class GeometryArena;
+    class MeshCache;
+    class MeshData;
+    class ATexture;
+    struct TextureConfig;
+    enum class TextureContent;
+    struct GltfScene;
+
     class Resource
     {
     public:
@@ -60,32 +70,136 @@ namespace CrossEngine
          * 
          * @param p_path The path of the tris file.
          * @param p_result The result triangles. The triangles will be pushed back to this vector.
+         * @param p_arena The arena to create the triangles in, the triangles are created by the triangle
+         * pool if it is nullptr.
          */
-        static void LoadTris(const std::string& p_path, std::vector<Triangle*>& p_result);
+        static void LoadTris(const std::string& p_path, std::vector<Triangle*>& p_result, GeometryArena* p_arena = nullptr);
 
         /**
          * @brief Load the triangles from a tris with normal file.
          * 
          * @param p_path The path of the tris with normal file.
-         * @return std::vector<Triangle*> The result triangles. The triangles will be pushed back to this vector.
+         * @param p_result The result triangles. The triangles will be pushed back to this vector.
+         * @param p_arena The arena to create the triangles in, the triangles are created by the triangle
+         * pool if it is nullptr.
          */
-        static void LoadTrisWithNormal(const std::string& p_path, std::vector<Triangle*>& p_result);
+        static void LoadTrisWithNormal(const std::string& p_path, std::vector<Triangle*>& p_result, GeometryArena* p_arena = nullptr);
 
         /**
-         * @brief Load the triangles from a model file.
+         * @brief Load the triangles from a model file. The triangles are read from the mesh cache of the
+         * file if it is up to date, otherwise the file is parsed and its mesh cache is written.
          * 
          * @param p_path The path of the model file.
          * @param p_result The result triangles. The triangles will be pushed back to this vector.
+         * @param p_arena The arena to create the triangles in, the triangles are created by the triangle
+         * pool if it is nullptr.
+         */
+        static void LoadModel(const std::string& p_path, std::vector<Triangle*>& p_result, GeometryArena* p_arena = nullptr);
+
+        /**
+         * @brief Load the mesh cache of a model file, converting the file if its cache is missing or out
+         * of date. The cache is kept in memory if it cannot be written.
+         * 
+         * @param p_path The path of the model file, or of a mesh cache file.
+         * @throw std::runtime_error Failed to load the model file.
+         * @return std::shared_ptr<const MeshCache> The mesh cache.
          */
-        static void LoadModel(const std::string& p_path, std::vector<Triangle*>& p_result);
+        static std::shared_ptr<const MeshCache> LoadMeshCache(const std::string& p_path);
 
         /**
          * @brief Load the triangles from a obj file.
          * 
          * @param p_path The path of the obj file.
          * @param p_result The result triangles. The triangles will be pushed back to this vector.
+         * @param p_arena The arena to create the triangles in, the triangles are created by the triangle
+         * pool if it is nullptr.
+         */
+        static void LoadObjModel(const std::string& p_path, std::vector<Triangle*>& p_result, GeometryArena* p_arena = nullptr);
+
+        /**
+         * @brief Load the component hierarchy of a binary glTF file. The meshes are decoded in parallel, and
+         * the textures are decoded in the background when they are first bound.
+         * 
+         * @param p_path The path of the .glb file.
+         * @throw std::runtime_error Failed to load the file.
+         * @return GltfScene The components of the file.
+         */
+        static GltfScene LoadGltfScene(const std::string& p_path);
+
+        /**
+         * @brief The memory budget of the texture cache by default, in bytes.
+         */
+        static constexpr size_t DEFAULT_TEXTURE_CACHE_BUDGET = 256 * 1024 * 1024;
+
+        /**
+         * @brief The memory budget of the mesh data cache by default, in bytes.
+         */
+        static constexpr size_t DEFAULT_MESH_DATA_CACHE_BUDGET = 128 * 1024 * 1024;
+
+        /**
+         * @brief Get the canonical form of a path, so the different paths of a file are the same key of
+         * the resource caches. The file does not need to exist.
+         * 
+         * @param p_path The path.
+         * @return std::string The canonical path.
+         */
+        static std::string GetCanonicalPath(const std::string& p_path);
+
+        /**
+         * @brief Get the cache of the textures loaded by LoadSharedTexture. The memory of a texture is
+         * the size of its pixels.
+         * 
+         * @return ResourceCache<ATexture>& The texture cache.
+         */
+        static ResourceCache<ATexture>& GetTextureCache();
+
+        /**
+         * @brief Get the cache of the mesh data loaded by LoadSharedMeshData. The memory of a mesh data is
+         * the size of its vertices.
+         * 
+         * @return ResourceCache<MeshData>& The mesh data cache.
+         */
+        static ResourceCache<MeshData>& GetMeshDataCache();
+
+        /**
+         * @brief Load a texture with the default config, shared with the other loads of the file.
+         * 
+         * @param p_path The path to the texture file.
+         * @throw std::runtime_error Failed to load the texture file.
+         * @return std::shared_ptr<ATexture> The texture.
+         */
+        static std::shared_ptr<ATexture> LoadSharedTexture(const std::string& p_path);
+
+        /**
+         * @brief Load a texture, shared with the other loads of the file with the same config.
+         * 
+         * @param p_path The path to the texture file.
+         * @param p_config The config of the texture.
+         * @throw std::runtime_error Failed to load the texture file.
+         * @return std::shared_ptr<ATexture> The texture.
+         */
+        static std::shared_ptr<ATexture> LoadSharedTexture(const std::string& p_path, const TextureConfig& p_config);
+
+        /**
+         * @brief Load a texture with the default config and the content of its pixels, shared with the
+         * other loads of the file with the same content.
+         * 
+         * @param p_path The path to the texture file.
+         * @param p_content What the pixels of the texture hold.
+         * @throw std::runtime_error Failed to load the texture file.
+         * @return std::shared_ptr<ATexture> The texture.
          */
-        static void LoadObjModel(const std::string& p_path, std::vector<Triangle*>& p_result);
+        static std::shared_ptr<ATexture> LoadSharedTexture(const std::string& p_path, TextureContent p_content);
+
+        /**
+         * @brief Load the mesh data of a model file through its mesh cache, shared with the other loads
+         * of the file.
+         * 
+         * @param p_path The path to the model file.
+         * @throw std::runtime_error Failed to load the model file.
+         * @return std::shared_ptr<MeshData> The mesh data.
+         */
+        static std::shared_ptr<MeshData> LoadSharedMeshData(const std::string& p_path);
 
         /**
          * @brief Load the triangles from a Tris file.
@@ -144,6 +258,19 @@ namespace CrossEngine
         static ubyte_t* LoadTextureImage(const std::string& p_path, ubyte_t* p_buffer, size_t p_buffer_size,
             size_t& p_width, size_t& p_height, size_t& p_channels);
 
+        /**
+         * @brief Decode an image from memory.
+         * 
+         * @param p_data The encoded image.
+         * @param p_size The size of the encoded image.
+         * @param p_width This will be set to the width of the image.
+         * @param p_height This will be set to the height of the image.
+         * @param p_channels This will be set to the number of channels of the image.
+         * @throw std::runtime_error Failed to decode the image.
+         * @return ubyte_t* The pixels, you must free them manually.
+         */
+        static ubyte_t* DecodeTextureImage(const ubyte_t* p_data, size_t p_size, size_t& p_width, size_t& p_height, size_t& p_channels);
+
         /**
          * @brief Load an HDR image.
          * 
@@ -0,0 +1,229 @@
+#pragma once
+#include "ce/defs.hpp"
+#include <string>
+#include <list>
+#include <unordered_map>
+#include <memory>
+#include <future>
+#include <mutex>
+#include <functional>
+#include <cstdint>
+
+namespace CrossEngine
+{
+    /**
+     * @brief Resources shared by key, so a resource loaded twice is only loaded once. The cache keeps the
+     * resources nobody else references, and evicts them least recently used first when the memory of the
+     * resources is over the budget.
+     * @details A resource is loaded by the first thread asking for it, without holding the lock of the cache.
+     * Other threads asking for it meanwhile wait for that load. A load that throws is not cached.
+     *
+     * @tparam T The type of the resources.
+     */
+    template <typename T>
+    class ResourceCache
+    {
+    public:
+        /**
+         * @brief Measure the memory of a resource in bytes.
+         */
+        using SizeFunction = std::function<size_t(const T&)>;
+
+        /**
+         * @brief The statistics of a cache.
+         */
+        struct Statistics
+        {
+            size_t hit_count = 0;
+            size_t miss_count = 0;
+            size_t eviction_count = 0;
+            size_t entry_count = 0;
+            size_t memory_usage = 0;
+        };
+    private:
+        struct Entry
+        {
+            std::shared_future<std::shared_ptr<T>> resource;
+            size_t size = 0;
+            typename std::list<std::string>::iterator lru_position;
+        };
+
+        SizeFunction size_of;
+        size_t budget;
+        std::unordered_map<std::string, Entry> entries;
+        // The keys, the most recently used first.
+        std::list<std::string> lru;
+        size_t memory_usage = 0;
+        size_t hit_count = 0;
+        size_t miss_count = 0;
+        size_t eviction_count = 0;
+        mutable std::mutex cache_mutex;
+
+        // Get the resource of an entry, nullptr if it is still loading.
+        FORCE_INLINE static const std::shared_ptr<T>* GetLoaded(const Entry& p_entry)
+        {
+            if (p_entry.resource.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+                return nullptr;
+            return &p_entry.resource.get();
+        }
+
+        // The resources may grow after they are loaded, such as a texture decoded in the background.
+        void UpdateSize(Entry& p_entry, const std::shared_ptr<T>& p_resource)
+        {
+            memory_usage -= p_entry.size;
+            p_entry.size = p_resource != nullptr ? size_of(*p_resource) : 0;
+            memory_usage += p_entry.size;
+        }
+
+        void EvictUnused(size_t p_budget)
+        {
+            auto i = lru.end();
+            while (i != lru.begin() && (memory_usage > p_budget || p_budget == 0))
+            {
+                --i;
+                auto entry = entries.find(*i);
+                auto resource = GetLoaded(entry->second);
+                // The cache holds the only reference of an unused resource.
+                if (resource == nullptr || resource->use_count() > 1)
+                    continue;
+                memory_usage -= entry->second.size;
+                ++eviction_count;
+                entries.erase(entry);
+                i = lru.erase(i);
+            }
+        }
+    public:
+        /**
+         * @brief Construct a new resource cache.
+         *
+         * @param p_size_of The function measuring the memory of a resource.
+         * @param p_budget The memory in bytes the resources are evicted down to. If it is 0, no unused
+         * resource is kept.
+         */
+        explicit ResourceCache(SizeFunction p_size_of, size_t p_budget = SIZE_MAX)
+            : size_of(std::move(p_size_of)), budget(p_budget) {}
+
+        ResourceCache(const ResourceCache& p_other) = delete;
+        ResourceCache& operator=(const ResourceCache& p_other) = delete;
+
+        /**
+         * @brief Get a resource, loading it if it is not cached.
+         *
+         * @tparam F The type of the loader.
+         * @param p_key The key of the resource, such as its canonical path and the parameters it is loaded with.
+         * @param p_load The loader of the resource, returning a std::shared_ptr<T>.
+         * @throw Any exception thrown by the loader of the resource.
+         * @return std::shared_ptr<T> The resource.
+         */
+        template <typename F>
+        std::shared_ptr<T> Get(const std::string& p_key, F&& p_load)
+        {
+            std::promise<std::shared_ptr<T>> promise;
+            std::shared_future<std::shared_ptr<T>> future;
+            {
+                std::lock_guard<std::mutex> lock(cache_mutex);
+                auto entry = entries.find(p_key);
+                if (entry != entries.end())
+                {
+                    ++hit_count;
+                    lru.splice(lru.begin(), lru, entry->second.lru_position);
+                    if (auto resource = GetLoaded(entry->second))
+                    {
+                        UpdateSize(entry->second, *resource);
+                        return *resource;
+                    }
+                    future = entry->second.resource;
+                }
+                else
+                {
+                    ++miss_count;
+                    lru.push_front(p_key);
+                    entries.emplace(p_key, Entry{promise.get_future().share(), 0, lru.begin()});
+                }
+            }
+            // Another thread is loading the resource.
+            if (future.valid())
+                return future.get();
+
+            std::shared_ptr<T> resource;
+            try
+            {
+                resource = p_load();
+            }
+            catch (...)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(cache_mutex);
+                    auto entry = entries.find(p_key);
+                    lru.erase(entry->second.lru_position);
+                    entries.erase(entry);
+                }
+                promise.set_exception(std::current_exception());
+                throw;
+            }
+            promise.set_value(resource);
+            std::lock_guard<std::mutex> lock(cache_mutex);
+            UpdateSize(entries.find(p_key)->second, resource);
+            EvictUnused(budget);
+            return resource;
+        }
+
+        /**
+         * @brief Get the memory in bytes the resources are evicted down to.
+         *
+         * @return size_t The budget.
+         */
+        size_t GetBudget() const
+        {
+            std::lock_guard<std::mutex> lock(cache_mutex);
+            return budget;
+        }
+
+        /**
+         * @brief Set the memory in bytes the resources are evicted down to, and evict the unused resources
+         * over it.
+         *
+         * @param p_budget The budget.
+         */
+        void SetBudget(size_t p_budget)
+        {
+            std::lock_guard<std::mutex> lock(cache_mutex);
+            budget = p_budget;
+            EvictUnused(budget);
+        }
+
+        /**
+         * @brief Measure the resources again, and evict the unused resources over the budget.
+         */
+        void Trim()
+        {
+            std::lock_guard<std::mutex> lock(cache_mutex);
+            for (auto& entry : entries)
+            {
+                if (auto resource = GetLoaded(entry.second))
+                    UpdateSize(entry.second, *resource);
+            }
+            EvictUnused(budget);
+        }
+
+        /**
+         * @brief Evict every unused resource. The resources that are still referenced stay cached.
+         */
+        void Clear()
+        {
+            std::lock_guard<std::mutex> lock(cache_mutex);
+            EvictUnused(0);
+        }
+
+        /**
+         * @brief Get the statistics of the cache. The hits and misses are counted since the cache is constructed.
+         *
+         * @return Statistics The statistics.
+         */
+        Statistics GetStatistics() const
+        {
+            std::lock_guard<std::mutex> lock(cache_mutex);
+            return Statistics{hit_count, miss_count, eviction_count, entries.size(), memory_usage};
+        }
+    };
+}
@@ -0,0 +1,136 @@
+#pragma once
+#include "ce/defs.hpp"
+#include "ce/texture/mip_chain.h"
+#include <vector>
+#include <deque>
+#include <string>
+#include <memory>
+#include <thread>
+#include <future>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <type_traits>
+#include <stdexcept>
+
+namespace CrossEngine
+{
+    /**
+     * @brief The pixels of a decoded image.
+     */
+    struct TextureImage
+    {
+        std::unique_ptr<ubyte_t[]> pixels;
+        size_t width = 0;
+        size_t height = 0;
+        size_t channels = 0;
+    };
+
+    /**
+     * @brief A pool of worker threads reading and decoding resources in the background. A job returns
+     * a future of its result, and the resources created from the results are uploaded by the thread of a
+     * window, see Window::QueueUpload.
+     * @note The jobs must not touch OpenGL, the workers have no context.
+     */
+    class ResourceLoader
+    {
+    private:
+        std::vector<std::thread> workers;
+        std::deque<std::move_only_function<void()>> jobs;
+        mutable std::mutex jobs_mutex;
+        std::condition_variable jobs_condition;
+        bool is_stopping = false;
+
+        void WorkerFunc();
+        void PushJob(std::move_only_function<void()>&& p_job);
+    public:
+        /**
+         * @brief Construct a new resource loader.
+         *
+         * @param p_worker_count The count of worker threads, at least 1.
+         */
+        explicit ResourceLoader(size_t p_worker_count);
+
+        ResourceLoader(const ResourceLoader& p_other) = delete;
+        ResourceLoader& operator=(const ResourceLoader& p_other) = delete;
+
+        /**
+         * @brief Destroy the resource loader. The running jobs are finished, and the futures of the jobs
+         * that are not started yet are abandoned.
+         */
+        ~ResourceLoader();
+
+        /**
+         * @brief Get the resource loader shared by the engine. It has a worker for every hardware thread
+         * but one, and is created when it is first used.
+         *
+         * @return ResourceLoader& The resource loader.
+         */
+        static ResourceLoader& GetInstance();
+
+        /**
+         * @brief Get the count of worker threads.
+         *
+         * @return size_t The count of worker threads.
+         */
+        FORCE_INLINE size_t GetWorkerCount() const noexcept { return workers.size(); }
+
+        /**
+         * @brief Get the count of jobs that are not started yet.
+         *
+         * @return size_t The count of waiting jobs.
+         */
+        size_t GetPendingJobCount() const;
+
+        /**
+         * @brief Run a job on a worker thread. The jobs are started in the order they are submitted.
+         *
+         * @tparam F The type of the job.
+         * @param p_job The job. Exceptions thrown by the job are rethrown by the future.
+         * @throw std::runtime_error The loader is being destroyed.
+         * @return std::future<std::invoke_result_t<std::decay_t<F>>> The future of the result of the job.
+         */
+        template <typename F>
+        std::future<std::invoke_result_t<std::decay_t<F>>> Submit(F&& p_job)
+        {
+            std::packaged_task<std::invoke_result_t<std::decay_t<F>>()> task(std::forward<F>(p_job));
+            auto result = task.get_future();
+            PushJob([task = std::move(task)]() mutable { task(); });
+            return result;
+        }
+
+        /**
+         * @brief Read and decode an image on a worker thread.
+         *
+         * @param p_path The path to the image.
+         * @return std::future<TextureImage> The future of the image. It throws std::runtime_error if
+         * the image cannot be loaded.
+         */
+        std::future<TextureImage> LoadTextureImage(const std::string& p_path);
+
+        /**
+         * @brief Read and decode an image, and build its levels, on a worker thread. The levels of a texture
+         * file are read as they are baked, see TextureFile::Load.
+         *
+         * @param p_path The path to the image or the texture file.
+         * @param p_config How the levels are built. Ignored for texture files.
+         * @return std::future<MipChain> The future of the levels. It throws std::runtime_error if the image
+         * cannot be loaded.
+         */
+        std::future<MipChain> LoadMipChain(const std::string& p_path, const MipConfig& p_config);
+
+        /**
+         * @brief Check if the result of a job is available, without waiting.
+         *
+         * @tparam T The type of the result.
+         * @param p_future The future of the job.
+         * @return true if the result is available.
+         * @return false if the job is not finished, or the future is empty.
+         */
+        template <typename T>
+        FORCE_INLINE static bool IsReady(const std::future<T>& p_future)
+        {
+            return p_future.valid() && p_future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        }
+    };
+}
@@ -0,0 +1,122 @@
+#pragma once
+#include "ce/defs.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+
+namespace CrossEngine
+{
+    class PackFile;
+
+    /**
+     * @brief The data of a file opened through the virtual file system. The data of a file in a directory
+     * is mapped, and the data of an uncompressed pack entry is read in place from the mapped pack.
+     */
+    class VirtualFile
+    {
+    private:
+        // Keeps the data alive, the mapped file, the pack or the decompressed buffer.
+        std::shared_ptr<const void> owner;
+        const byte_t* data = nullptr;
+        size_t size = 0;
+    public:
+        VirtualFile() = default;
+        VirtualFile(std::shared_ptr<const void> p_owner, const byte_t* p_data, size_t p_size) noexcept
+            : owner(std::move(p_owner)), data(p_data), size(p_size) {}
+
+        FORCE_INLINE const byte_t* GetData() const noexcept { return data; }
+
+        FORCE_INLINE size_t GetSize() const noexcept { return size; }
+
+        FORCE_INLINE std::string_view GetText() const noexcept { return std::string_view(data, size); }
+    };
+
+    /**
+     * @brief Files read through mount points. A mount point is a path prefix redirected to a directory or to a
+     * pack file, so the paths the engine builds, such as the ones under Resource::GetExeDirectory(), are read
+     * from a pack once the pack is mounted at their directory. The paths under no mount point are read from
+     * the disk as they are.
+     * @details The mount points mounted last are searched first. A file missing from the mounted directories
+     * and packs of its path is read from the disk.
+     */
+    class VirtualFileSystem
+    {
+    private:
+        struct MountPoint
+        {
+            std::string mount_point;
+            std::string directory;
+            std::shared_ptr<const PackFile> pack;
+        };
+
+        std::vector<MountPoint> mounts;
+        mutable std::shared_mutex mounts_mutex;
+    public:
+        VirtualFileSystem() = default;
+        VirtualFileSystem(const VirtualFileSystem& p_other) = delete;
+        VirtualFileSystem& operator=(const VirtualFileSystem& p_other) = delete;
+
+        /**
+         * @brief Get the file system the resources are loaded through.
+         *
+         * @return VirtualFileSystem& The file system.
+         */
+        static VirtualFileSystem& GetInstance();
+
+        /**
+         * @brief Normalize a path, so the paths of a file compare equal: the separators are '/', and the "."
+         * and ".." components are resolved lexically.
+         *
+         * @param p_path The path.
+         * @return std::string The normalized path.
+         */
+        static std::string NormalizePath(std::string_view p_path);
+
+        /**
+         * @brief Mount a directory or a pack file. A path ending with PackFile::EXTENSION is mounted as a pack.
+         *
+         * @param p_mount_point The path prefix redirected to the directory or the pack.
+         * @param p_path The path to the directory or the pack file.
+         * @throw std::runtime_error Failed to open the pack file.
+         */
+        void Mount(const std::string& p_mount_point, const std::string& p_path);
+
+        /**
+         * @brief Unmount every directory and pack of a mount point.
+         *
+         * @param p_mount_point The mount point.
+         * @return size_t The count of unmounted directories and packs.
+         */
+        size_t Unmount(const std::string& p_mount_point);
+
+        /**
+         * @brief Check if a file exists in the mounted directories and packs, or on the disk.
+         *
+         * @param p_path The path to the file.
+         * @return true if the file exists.
+         * @return false if the file does not exist.
+         */
+        bool Exists(const std::string& p_path) const;
+
+        /**
+         * @brief Get the path on the disk a file is read from, such as its path in a mounted directory.
+         *
+         * @param p_path The path to the file.
+         * @return std::optional<std::string> The path on the disk, std::nullopt if the file is read from a pack
+         * or does not exist.
+         */
+        std::optional<std::string> GetDiskPath(const std::string& p_path) const;
+
+        /**
+         * @brief Open a file.
+         *
+         * @param p_path The path to the file.
+         * @throw std::runtime_error Failed to open the file, or its pack entry is corrupted.
+         * @return VirtualFile The data of the file.
+         */
+        VirtualFile Open(const std::string& p_path) const;
+    };
+}
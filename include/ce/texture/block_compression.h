@@ -0,0 +1,146 @@
+#pragma once
+#include "ce/defs.hpp"
+#include <cstdint>
+#include <string_view>
+
+namespace CrossEngine
+{
+    struct MipChain;
+
+    /**
+     * @brief The block compressed formats of textures. Each block holds 4x4 pixels.
+     */
+    enum class BlockFormat : uint32_t
+    {
+        // The pixels are not compressed.
+        NONE = 0,
+        // RGB, 8 bytes per block.
+        BC1 = 1,
+        // RGBA, 16 bytes per block.
+        BC3 = 3,
+        // Two channels, such as the X and Y of a normal map, 16 bytes per block.
+        BC5 = 5,
+        // RGBA of higher quality, 16 bytes per block.
+        BC7 = 7
+    };
+
+    /**
+     * @brief Encode and decode textures in the block compressed formats.
+     * @details The endpoints of a block are fitted along the principal axis of its pixels, and refined with
+     * least squares against the pixels they are chosen for. BC7 blocks are encoded in mode 6, a single pair of
+     * RGBA endpoints with 16 levels, and only mode 6 blocks are decoded.
+     */
+    class BlockCompression
+    {
+    private:
+        BlockCompression() = delete;
+    public:
+        /**
+         * @brief The width and height of a block in pixels.
+         */
+        static constexpr size_t BLOCK_WIDTH = 4;
+
+        /**
+         * @brief Get the size of a block.
+         *
+         * @param p_format The format.
+         * @return size_t The size of a block in bytes, 0 if the format is not compressed.
+         */
+        static size_t GetBlockSize(BlockFormat p_format) noexcept;
+
+        /**
+         * @brief Get the channels of the pixels decoded from a format. The Z of a BC5 normal map is rebuilt
+         * from its X and Y to the third channel.
+         *
+         * @param p_format The format.
+         * @return size_t The count of channels.
+         */
+        static size_t GetChannels(BlockFormat p_format) noexcept;
+
+        /**
+         * @brief Get the size of a compressed texture.
+         *
+         * @param p_format The format.
+         * @param p_width The width of the texture.
+         * @param p_height The height of the texture.
+         * @return size_t The size in bytes.
+         */
+        static size_t GetCompressedSize(BlockFormat p_format, size_t p_width, size_t p_height) noexcept;
+
+        /**
+         * @brief Parse the name of a format, such as "bc7".
+         *
+         * @param p_name The name of the format.
+         * @throw std::runtime_error The format is unknown.
+         * @return BlockFormat The format.
+         */
+        static BlockFormat ParseFormat(std::string_view p_name);
+
+        /**
+         * @brief Encode a block.
+         *
+         * @param p_format The format, not BlockFormat::NONE.
+         * @param p_pixels The 4x4 RGBA pixels of the block, row by row.
+         * @param p_block The block, of GetBlockSize(p_format) bytes.
+         */
+        static void EncodeBlock(BlockFormat p_format, const ubyte_t* p_pixels, ubyte_t* p_block);
+
+        /**
+         * @brief Decode a block.
+         *
+         * @param p_format The format, not BlockFormat::NONE.
+         * @param p_block The block.
+         * @param p_pixels The 4x4 RGBA pixels of the block, row by row.
+         * @throw std::runtime_error The BC7 block is not in mode 6.
+         */
+        static void DecodeBlock(BlockFormat p_format, const ubyte_t* p_block, ubyte_t* p_pixels);
+
+        /**
+         * @brief Encode a texture. The rows of blocks are shared by several threads.
+         *
+         * @param p_format The format, not BlockFormat::NONE.
+         * @param p_pixels The pixels of the texture.
+         * @param p_width The width of the texture.
+         * @param p_height The height of the texture.
+         * @param p_channels The channels of the texture, 1 to 4.
+         * @param p_output The compressed texture, of GetCompressedSize bytes.
+         * @param p_thread_count The count of chunks the rows of blocks are split into, run by the workers of the JobSystem.
+         * @throw std::runtime_error The format is not compressed, or the texture has an unsupported number of
+         * channels.
+         */
+        static void Encode(BlockFormat p_format, const ubyte_t* p_pixels, size_t p_width, size_t p_height, size_t p_channels,
+            ubyte_t* p_output, size_t p_thread_count);
+
+        /**
+         * @brief Decode a texture.
+         *
+         * @param p_format The format, not BlockFormat::NONE.
+         * @param p_data The compressed texture.
+         * @param p_width The width of the texture.
+         * @param p_height The height of the texture.
+         * @param p_output The pixels, of GetChannels(p_format) channels.
+         * @throw std::runtime_error The BC7 blocks are not in mode 6.
+         */
+        static void Decode(BlockFormat p_format, const ubyte_t* p_data, size_t p_width, size_t p_height, ubyte_t* p_output);
+
+        /**
+         * @brief Encode every level of a texture.
+         *
+         * @param p_image The levels of the texture, not compressed.
+         * @param p_format The format, not BlockFormat::NONE.
+         * @param p_thread_count The count of chunks the rows of blocks of each level are split into.
+         * @throw std::runtime_error The levels are already compressed.
+         * @return MipChain The compressed levels.
+         */
+        static MipChain Compress(const MipChain& p_image, BlockFormat p_format, size_t p_thread_count);
+
+        /**
+         * @brief Decode every level of a texture, for the contexts that do not support its format.
+         *
+         * @param p_image The compressed levels of the texture.
+         * @throw std::runtime_error The levels are not compressed, or the BC7 blocks are not in mode 6.
+         * @return MipChain The levels, of GetChannels channels.
+         */
+        static MipChain Decompress(const MipChain& p_image);
+    };
+}
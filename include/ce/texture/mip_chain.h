@@ -0,0 +1,147 @@
+#pragma once
+#include "ce/defs.hpp"
+#include "ce/texture/block_compression.h"
+#include <vector>
+#include <memory>
+
+namespace CrossEngine
+{
+    /**
+     * @brief The filters building the smaller levels of a texture.
+     */
+    enum class MipFilter
+    {
+        // Averages the pixels each pixel of the smaller level covers.
+        BOX,
+        // A Kaiser windowed sinc, sharper than the box filter.
+        KAISER
+    };
+
+    /**
+     * @brief What the pixels of a texture hold, which decides how they are filtered.
+     */
+    enum class TextureContent
+    {
+        // Values filtered as they are, such as roughness or a mask.
+        LINEAR,
+        // Colors encoded in sRGB, filtered in linear space. The alpha is linear.
+        SRGB,
+        // Normals encoded from [-1, 1] to the first three channels, normalized after filtering.
+        NORMAL
+    };
+
+    /**
+     * @brief How the levels of a texture are built.
+     */
+    struct MipConfig
+    {
+        // Should the smaller levels be built. If not, the chain only has the texture itself.
+        bool mipmap = true;
+        MipFilter filter = MipFilter::KAISER;
+        TextureContent content = TextureContent::LINEAR;
+        // The count of chunks the rows of each level are split into, run by the workers of the JobSystem.
+        // Worker threads that already build a texture each should keep 1.
+        size_t thread_count = 1;
+    };
+
+    /**
+     * @brief The levels of a texture, the largest first, packed in one buffer. Each level is half the size of
+     * the previous one, down to 1x1. The levels are either pixels, or blocks of a compressed format.
+     */
+    struct MipChain
+    {
+        struct Level
+        {
+            size_t width = 0;
+            size_t height = 0;
+            // The offset of the pixels of the level in the buffer, in bytes.
+            size_t offset = 0;
+        };
+
+        std::unique_ptr<ubyte_t[]> pixels;
+        std::vector<Level> levels;
+        size_t channels = 0;
+        BlockFormat format = BlockFormat::NONE;
+
+        /**
+         * @brief Get the height in pixels of a row of the levels, a row of blocks if the levels are compressed.
+         *
+         * @return size_t The height of a row.
+         */
+        FORCE_INLINE size_t GetRowHeight() const noexcept { return format == BlockFormat::NONE ? 1 : BlockCompression::BLOCK_WIDTH; }
+
+        /**
+         * @brief Get the size of a row of a level, a row of blocks if the levels are compressed.
+         *
+         * @param p_level The index of the level.
+         * @return size_t The size in bytes.
+         */
+        FORCE_INLINE size_t GetRowSize(size_t p_level) const noexcept
+        {
+            if (format == BlockFormat::NONE)
+                return levels[p_level].width * channels;
+            return (levels[p_level].width + BlockCompression::BLOCK_WIDTH - 1) / BlockCompression::BLOCK_WIDTH
+                * BlockCompression::GetBlockSize(format);
+        }
+
+        /**
+         * @brief Get the size of the pixels of a level.
+         *
+         * @param p_level The index of the level.
+         * @return size_t The size in bytes.
+         */
+        FORCE_INLINE size_t GetLevelSize(size_t p_level) const noexcept
+        { return (levels[p_level].height + GetRowHeight() - 1) / GetRowHeight() * GetRowSize(p_level); }
+
+        /**
+         * @brief Get the pixels of a level.
+         *
+         * @param p_level The index of the level.
+         * @return const ubyte_t* The pixels of the level.
+         */
+        FORCE_INLINE const ubyte_t* GetLevelData(size_t p_level) const noexcept { return pixels.get() + levels[p_level].offset; }
+
+        /**
+         * @brief Get the size of the pixels of every level.
+         *
+         * @return size_t The size in bytes.
+         */
+        FORCE_INLINE size_t GetSize() const noexcept
+        { return levels.empty() ? 0 : levels.back().offset + GetLevelSize(levels.size() - 1); }
+
+        /**
+         * @brief Get the count of levels of a texture with every level down to 1x1.
+         *
+         * @param p_width The width of the texture.
+         * @param p_height The height of the texture.
+         * @return size_t The count of levels.
+         */
+        static size_t GetLevelCount(size_t p_width, size_t p_height) noexcept;
+
+        /**
+         * @brief Build the levels of a texture with the default MipConfig.
+         *
+         * @param p_pixels The pixels of the texture.
+         * @param p_width The width of the texture.
+         * @param p_height The height of the texture.
+         * @param p_channels The channels of the texture.
+         * @param p_mipmap Should the smaller levels be built. If not, the chain only has the texture itself.
+         * @return MipChain The levels of the texture.
+         */
+        static MipChain Generate(const ubyte_t* p_pixels, size_t p_width, size_t p_height, size_t p_channels, bool p_mipmap);
+
+        /**
+         * @brief Build the levels of a texture. Each level is filtered from the previous one in floating point,
+         * so the rounding does not add up over the levels. Odd sizes are filtered by the area each pixel covers.
+         *
+         * @param p_pixels The pixels of the texture.
+         * @param p_width The width of the texture.
+         * @param p_height The height of the texture.
+         * @param p_channels The channels of the texture, 1 to 4.
+         * @param p_config How the levels are built.
+         * @throw std::runtime_error The channels are not supported, or a normal map has less than 3 channels.
+         * @return MipChain The levels of the texture.
+         */
+        static MipChain Generate(const ubyte_t* p_pixels, size_t p_width, size_t p_height, size_t p_channels, const MipConfig& p_config);
+    };
+}
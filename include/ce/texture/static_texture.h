@@ -1,6 +1,7 @@
 #pragma once
 #include "ce/texture/texture.h"
-#include <map>
+#include <mutex>
+#include <functional>
 
 namespace CrossEngine
 {
@@ -8,9 +9,33 @@ namespace CrossEngine
     class Window;
     class StaticTexture : public ATexture
     {
+    public:
+        /**
+         * @brief Decode the pixels of a texture.
+         *
+         * @param p_width This will be set to the width of the texture.
+         * @param p_height This will be set to the height of the texture.
+         * @param p_channels This will be set to the number of channels of the texture.
+         * @return ubyte_t* The pixels, owned by the texture.
+         */
+        using Decoder = std::function<ubyte_t*(size_t& p_width, size_t& p_height, size_t& p_channels)>;
     private:
+        // The image decoded by the resource loader, shared with the upload queued to a window.
+        struct PendingImage;
+
         std::unique_ptr<ubyte_t[]> data;
-        std::map<Window*, unsigned int> texture_ids;
+        // The texture is decoded in the background when it is first bound if it is loaded with a decoder.
+        Decoder decoder;
+        std::shared_ptr<PendingImage> pending;
+        // Bound instead of the texture until it is uploaded.
+        std::shared_ptr<ATexture> placeholder;
+        // The texture is shared by every context.
+        unsigned int texture_id = 0;
+        // Waited for by the other contexts before they bind the texture.
+        void* upload_fence = nullptr;
+        std::mutex texture_mutex;
+
+        void ReleasePending();
 
     public:
 
@@ -19,9 +44,19 @@ namespace CrossEngine
         StaticTexture(const std::string& p_path, const TextureConfig& p_config = TextureConfig());
 
         /**
-         * @brief Get the number of channels of the texture.
+         * @brief Construct a texture decoded when it is first bound.
+         *
+         * @param p_decoder The decoder of the texture.
+         * @param p_config The config of the texture.
+         */
+        StaticTexture(Decoder&& p_decoder, const TextureConfig& p_config = TextureConfig());
+
+        /**
+         * @brief Load a texture from a file. The baked levels of a texture file are streamed when the texture
+         * is first bound, compressed if the contexts support their format, see TextureFile.
+         * @note The size of a texture loaded from a texture file is only known after it is uploaded.
          * 
-         * @return size_t The number of channels of the texture.
+         * @param p_path The path to the texture file.
          */
         virtual void LoadTexture(const std::string& p_path) override;
         
@@ -40,7 +75,42 @@ namespace CrossEngine
         virtual void LoadTexture(const ubyte_t* p_data, size_t p_width, size_t p_height, size_t p_channels) override;
 
         /**
-         * @brief Bind the texture.
+         * @brief Load a texture decoded in the background when it is first bound, so loading a model does not
+         * wait for its images. The placeholder is bound until the texture is uploaded.
+         * @note The size of the texture is only known after it is uploaded.
+         *
+         * @param p_decoder The decoder of the texture, called by a worker of the resource loader.
+         */
+        void LoadTexture(Decoder&& p_decoder);
+
+        /**
+         * @brief Start reading and decoding a texture file in the background. The decoded texture is streamed
+         * by the thread of the first window that binds it, within the upload budgets of the window, from its
+         * smallest level to its largest one. The placeholder is bound until the smallest level is uploaded. If
+         * the file cannot be loaded, the placeholder is kept.
+         *
+         * @param p_path The path to the texture file.
+         */
+        void LoadTextureAsync(const std::string& p_path);
+
+        /**
+         * @brief Get the texture bound while the texture is loaded in the background.
+         *
+         * @return std::shared_ptr<ATexture> The placeholder, nullptr if the default albedo is bound.
+         */
+        FORCE_INLINE std::shared_ptr<ATexture> GetPlaceholder() const noexcept { return placeholder; }
+
+        /**
+         * @brief Set the texture bound while the texture is loaded in the background.
+         *
+         * @param p_placeholder The placeholder, nullptr to bind the default albedo.
+         */
+        FORCE_INLINE void SetPlaceholder(std::shared_ptr<ATexture> p_placeholder) noexcept { placeholder = std::move(p_placeholder); }
+
+        /**
+         * @brief Bind the texture. A texture decoded in the background, with smaller levels, or larger than
+         * TextureStreamer::MIN_STREAMED_SIZE, is streamed by the window, see LoadTextureAsync. Its levels are built
+         * on a worker thread as the config asks, see TextureConfig::GetMipConfig.
          */
         virtual void BindTexture(Window* p_context, const std::string& p_uniform_name) override;
 
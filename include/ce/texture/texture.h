@@ -12,6 +12,8 @@ namespace CrossEngine
         size_t width = 0;
         size_t height = 0;
         size_t channels = 0;
+        // The format of the levels on the GPU, BlockFormat::NONE for pixels.
+        BlockFormat format = BlockFormat::NONE;
         TextureConfig config;
 
     public:
@@ -39,6 +41,13 @@ namespace CrossEngine
          */
         FORCE_INLINE size_t GetChannels() const { return channels; }
 
+        /**
+         * @brief Get the format of the levels of the texture on the GPU.
+         * 
+         * @return BlockFormat The format, BlockFormat::NONE if the texture is not compressed or not bound yet.
+         */
+        FORCE_INLINE BlockFormat GetBlockFormat() const { return format; }
+
         /**
          * @brief Load a texture from a file.
          * 
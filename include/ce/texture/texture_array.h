@@ -0,0 +1,103 @@
+#pragma once
+#include "ce/defs.hpp"
+#include <array>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace CrossEngine
+{
+    class Window;
+
+    /**
+     * @brief A GL_TEXTURE_2D_ARRAY of RGBA layers of the same size, so textures in different layers are
+     * sampled through one binding. The layers are written from any thread, and uploaded by the window the
+     * array is first bound in after the writes.
+     */
+    class TextureArray
+    {
+    private:
+        struct PendingWrite
+        {
+            size_t layer;
+            size_t level;
+            size_t x;
+            size_t y;
+            size_t width;
+            size_t height;
+            std::vector<ubyte_t> pixels;
+        };
+
+        size_t width;
+        size_t height;
+        size_t layer_count;
+        size_t level_count;
+        unsigned int texture_id = 0;
+        // Waited for by the other contexts before they bind the texture.
+        void* upload_fence = nullptr;
+        std::vector<PendingWrite> pending_writes;
+        mutable std::mutex array_mutex;
+    public:
+        /**
+         * @brief Construct a new texture array. The texture is created when it is first bound.
+         *
+         * @param p_width The width of the layers.
+         * @param p_height The height of the layers.
+         * @param p_layer_count The count of layers.
+         * @param p_level_count The count of levels of each layer, at most MipChain::GetLevelCount of the size.
+         * @throw std::invalid_argument A size is 0, or there are more levels than the size allows.
+         */
+        TextureArray(size_t p_width, size_t p_height, size_t p_layer_count, size_t p_level_count);
+
+        TextureArray(const TextureArray&) = delete;
+
+        virtual ~TextureArray();
+
+        FORCE_INLINE size_t GetWidth() const noexcept { return width; }
+        FORCE_INLINE size_t GetHeight() const noexcept { return height; }
+        FORCE_INLINE size_t GetLayerCount() const noexcept { return layer_count; }
+        FORCE_INLINE size_t GetLevelCount() const noexcept { return level_count; }
+
+        /**
+         * @brief Write RGBA pixels to a rectangle of a level of a layer.
+         *
+         * @param p_layer The layer.
+         * @param p_level The level.
+         * @param p_x The left of the rectangle in the level.
+         * @param p_y The top of the rectangle in the level.
+         * @param p_width The width of the rectangle.
+         * @param p_height The height of the rectangle.
+         * @param p_pixels The pixels of the rectangle, 4 bytes each.
+         * @throw std::out_of_range The rectangle is not in the level, or the pixels do not fill it.
+         */
+        void Write(size_t p_layer, size_t p_level, size_t p_x, size_t p_y, size_t p_width, size_t p_height,
+            std::vector<ubyte_t>&& p_pixels);
+
+        /**
+         * @brief Get the count of writes not uploaded yet.
+         *
+         * @return size_t The count of writes.
+         */
+        size_t GetPendingWriteCount() const;
+
+        /**
+         * @brief Get a pixel written but not uploaded yet. The last write covering the pixel wins.
+         *
+         * @param p_layer The layer.
+         * @param p_level The level.
+         * @param p_x The column of the pixel in the level.
+         * @param p_y The row of the pixel in the level.
+         * @return std::optional<std::array<ubyte_t, 4>> The RGBA pixel, empty if no pending write covers it.
+         */
+        std::optional<std::array<ubyte_t, 4>> GetPendingPixel(size_t p_layer, size_t p_level, size_t p_x, size_t p_y) const;
+
+        /**
+         * @brief Bind the texture array, after uploading the pending writes.
+         *
+         * @param p_context The context to bind in.
+         * @param p_uniform_name The name of the sampler2DArray uniform.
+         */
+        void BindTexture(Window* p_context, const std::string& p_uniform_name);
+    };
+}
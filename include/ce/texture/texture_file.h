@@ -0,0 +1,87 @@
+#pragma once
+#include "ce/defs.hpp"
+#include "ce/texture/mip_chain.h"
+#include <string>
+#include <cstdint>
+
+namespace CrossEngine
+{
+    /**
+     * @brief A texture file holding every level of a texture, ready to be uploaded. The levels are baked
+     * offline, usually compressed, so loading the texture decodes no image and builds no level.
+     * @details The file starts with a Header, followed by a Level for each level of the texture, and the data
+     * of the levels, the largest first.
+     */
+    class TextureFile
+    {
+    public:
+        /**
+         * @brief The magic number at the start of a texture file, "CETX".
+         */
+        static constexpr uint32_t MAGIC = 0x58544543;
+        static constexpr uint32_t VERSION = 1;
+
+        /**
+         * @brief The extension of texture files.
+         */
+        static constexpr const char* EXTENSION = ".cetex";
+
+        struct Header
+        {
+            uint32_t magic;
+            uint32_t version;
+            // A BlockFormat.
+            uint32_t format;
+            // The channels of the levels if they are not compressed.
+            uint32_t channels;
+            uint64_t width;
+            uint64_t height;
+            uint64_t level_count;
+        };
+
+        struct Level
+        {
+            uint64_t offset;
+            uint64_t size;
+        };
+    private:
+        TextureFile() = delete;
+    public:
+        /**
+         * @brief Check if a path is a texture file by its extension.
+         *
+         * @param p_path The path.
+         * @return true if the path ends with EXTENSION.
+         * @return false if the path is another file.
+         */
+        static bool IsTextureFile(const std::string& p_path) noexcept;
+
+        /**
+         * @brief Read the levels of a texture file as they are stored.
+         *
+         * @param p_path The path to the texture file.
+         * @throw std::runtime_error Failed to read the file, or the file is not a valid texture file.
+         * @return MipChain The levels of the texture.
+         */
+        static MipChain Read(const std::string& p_path);
+
+        /**
+         * @brief Read the levels of a texture file to be uploaded. The levels in a compressed format the
+         * contexts do not support are decompressed.
+         *
+         * @param p_path The path to the texture file.
+         * @throw std::runtime_error Failed to read the file, or the file is not a valid texture file.
+         * @return MipChain The levels of the texture.
+         */
+        static MipChain Load(const std::string& p_path);
+
+        /**
+         * @brief Write the levels of a texture to a texture file.
+         *
+         * @param p_path The path of the texture file.
+         * @param p_image The levels of the texture.
+         * @throw std::runtime_error Failed to write the file.
+         */
+        static void Write(const std::string& p_path, const MipChain& p_image);
+    };
+}
@@ -0,0 +1,126 @@
+#pragma once
+#include "ce/defs.hpp"
+#include <memory_resource>
+#include <vector>
+#include <cstddef>
+
+namespace CrossEngine
+{
+    /**
+     * @brief A linear allocator for the transient allocations of a frame. Allocating bumps an offset in a block,
+     * freeing does nothing, and every allocation is released at once when the allocator is reset at the end
+     * of the frame. It is a memory resource, so standard containers use it through std::pmr.
+     * @details When a frame outgrows the block, the extra blocks are merged into a single larger block on reset,
+     * so the allocator stops requesting memory from the global heap once it has seen its largest frame.
+     */
+    class FrameAllocator
+        : public std::pmr::memory_resource
+    {
+    public:
+        /**
+         * @brief The default size of the block of a frame allocator.
+         */
+        static constexpr size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+        /**
+         * @brief The count of frames before the allocations of the global heap are reported as steady state
+         * allocations.
+         */
+        static constexpr size_t WARM_UP_FRAME_COUNT = 120;
+    private:
+        struct Block
+        {
+            std::byte* data;
+            size_t size;
+        };
+
+        std::vector<Block> blocks;
+        size_t block_size;
+        size_t offset = 0;
+        size_t frame_bytes = 0;
+        size_t peak_bytes = 0;
+        size_t upstream_allocation_count = 0;
+        size_t frame_count = 0;
+        size_t heap_allocation_mark = 0;
+        size_t steady_heap_allocation_count = 0;
+
+        void AddBlock(size_t p_size);
+        void ReleaseBlocks();
+    protected:
+        void* do_allocate(size_t p_bytes, size_t p_alignment) override;
+        void do_deallocate(void*, size_t, size_t) override {}
+        bool do_is_equal(const std::pmr::memory_resource& p_other) const noexcept override { return this == &p_other; }
+    public:
+        /**
+         * @brief Construct a new frame allocator.
+         *
+         * @param p_block_size The size of the first block of the allocator.
+         */
+        explicit FrameAllocator(size_t p_block_size = DEFAULT_BLOCK_SIZE);
+
+        FrameAllocator(const FrameAllocator& p_other) = delete;
+        FrameAllocator& operator=(const FrameAllocator& p_other) = delete;
+
+        /**
+         * @brief Destroy the frame allocator.
+         */
+        ~FrameAllocator();
+
+        /**
+         * @brief Get the frame allocator of the calling thread. The thread must reset it at the end of
+         * every frame.
+         *
+         * @return FrameAllocator& The frame allocator of the calling thread.
+         */
+        static FrameAllocator& GetThreadInstance();
+
+        /**
+         * @brief Get the count of global heap allocations made by the calling thread. It is only counted when
+         * the engine is built with CE_TRACK_HEAP_ALLOCATIONS, otherwise it is 0.
+         *
+         * @return size_t The count of global heap allocations.
+         */
+        static size_t GetThreadHeapAllocationCount() noexcept;
+
+        /**
+         * @brief Release every allocation of the frame. After the warm up frames, the global heap
+         * allocations the calling thread made since the last reset are counted as steady state allocations.
+         */
+        void Reset();
+
+        /**
+         * @brief Get the bytes allocated in the current frame.
+         *
+         * @return size_t The bytes allocated in the current frame.
+         */
+        FORCE_INLINE size_t GetFrameBytes() const noexcept { return frame_bytes; }
+
+        /**
+         * @brief Get the most bytes allocated in a frame.
+         *
+         * @return size_t The most bytes allocated in a frame.
+         */
+        FORCE_INLINE size_t GetPeakBytes() const noexcept { return peak_bytes; }
+
+        /**
+         * @brief Get the count of blocks the allocator requested from the global heap.
+         *
+         * @return size_t The count of blocks requested from the global heap.
+         */
+        FORCE_INLINE size_t GetUpstreamAllocationCount() const noexcept { return upstream_allocation_count; }
+
+        /**
+         * @brief Get the count of frames the allocator is reset.
+         *
+         * @return size_t The count of frames.
+         */
+        FORCE_INLINE size_t GetFrameCount() const noexcept { return frame_count; }
+
+        /**
+         * @brief Get the count of global heap allocations made after the warm up frames.
+         *
+         * @return size_t The count of steady state global heap allocations.
+         */
+        FORCE_INLINE size_t GetSteadyHeapAllocationCount() const noexcept { return steady_heap_allocation_count; }
+    };
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include "ce/defs.hpp"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace CrossEngine
+{
+    /**
+     * @brief Persistent worker threads running the short parallel work of a frame, so the frame does not
+     * create and join threads. Long running work, such as loading resources, belongs to the ResourceLoader.
+     */
+    class JobSystem
+    {
+    private:
+        std::vector<std::thread> workers;
+        std::deque<std::function<void()>> jobs;
+        std::mutex jobs_mutex;
+        std::condition_variable jobs_condition;
+        bool is_stopping = false;
+
+        void WorkerFunc();
+    public:
+        /**
+         * @brief Construct a new job system.
+         *
+         * @param p_worker_count The count of worker threads, at least 1.
+         */
+        explicit JobSystem(size_t p_worker_count);
+
+        JobSystem(const JobSystem& p_other) = delete;
+        JobSystem& operator=(const JobSystem& p_other) = delete;
+
+        /**
+         * @brief Destroy the job system. The jobs already queued are finished.
+         */
+        ~JobSystem();
+
+        /**
+         * @brief Get the job system shared by the engine. It has a worker for every hardware thread but one,
+         * and is created when it is first used.
+         *
+         * @return JobSystem& The job system.
+         */
+        static JobSystem& GetInstance();
+
+        /**
+         * @brief Get the count of worker threads.
+         *
+         * @return size_t The count of worker threads.
+         */
+        FORCE_INLINE size_t GetWorkerCount() const noexcept { return workers.size(); }
+
+        /**
+         * @brief Run a function over a range split into chunks, on the workers and the calling thread, and
+         * wait for every chunk. A single chunk runs on the calling thread only.
+         *
+         * @param p_count The size of the range.
+         * @param p_chunk_size The size of the chunks, at least 1.
+         * @param p_func The function called with the first and the past the last index of each chunk. The
+         * first exception it throws is rethrown once every chunk is finished.
+         */
+        void ParallelFor(size_t p_count, size_t p_chunk_size, const std::function<void(size_t, size_t)>& p_func);
+    };
+}
@@ -0,0 +1,119 @@
+#pragma once
+#include "ce/defs.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <utility>
+
+namespace CrossEngine
+{
+    /**
+     * @brief A parsed JSON value. The members of an object are kept in the order of the text,
+     * and looked up linearly, the objects of asset files only have a few members.
+     */
+    class Json
+    {
+    public:
+        enum class Type
+        {
+            Null,
+            Boolean,
+            Number,
+            String,
+            Array,
+            Object
+        };
+    private:
+        Type type = Type::Null;
+        bool boolean = false;
+        double number = 0.0;
+        std::string string;
+        std::vector<Json> elements;
+        std::vector<std::pair<std::string, Json>> members;
+
+        friend class JsonParser;
+    public:
+        /**
+         * @brief Construct a null value.
+         */
+        Json() = default;
+
+        /**
+         * @brief Parse a JSON text.
+         *
+         * @param p_text The text to parse.
+         * @throw std::runtime_error The text is not valid JSON.
+         * @return Json The parsed value.
+         */
+        static Json Parse(std::string_view p_text);
+
+        FORCE_INLINE Type GetType() const noexcept { return type; }
+        FORCE_INLINE bool IsNull() const noexcept { return type == Type::Null; }
+        FORCE_INLINE bool IsNumber() const noexcept { return type == Type::Number; }
+        FORCE_INLINE bool IsString() const noexcept { return type == Type::String; }
+        FORCE_INLINE bool IsArray() const noexcept { return type == Type::Array; }
+        FORCE_INLINE bool IsObject() const noexcept { return type == Type::Object; }
+
+        /**
+         * @brief Get the value as a boolean.
+         *
+         * @param p_default The value returned if this is not a boolean.
+         * @return bool The boolean.
+         */
+        FORCE_INLINE bool GetBoolean(bool p_default = false) const noexcept { return type == Type::Boolean ? boolean : p_default; }
+
+        /**
+         * @brief Get the value as a number.
+         *
+         * @param p_default The value returned if this is not a number.
+         * @return double The number.
+         */
+        FORCE_INLINE double GetNumber(double p_default = 0.0) const noexcept { return type == Type::Number ? number : p_default; }
+
+        /**
+         * @brief Get the value as a string.
+         *
+         * @return const std::string& The string, empty if this is not a string.
+         */
+        FORCE_INLINE const std::string& GetString() const noexcept { return string; }
+
+        /**
+         * @brief Get the count of the elements of an array, or of the members of an object.
+         *
+         * @return size_t The count, 0 if this is neither an array nor an object.
+         */
+        FORCE_INLINE size_t GetSize() const noexcept { return type == Type::Object ? members.size() : elements.size(); }
+
+        /**
+         * @brief Get the members of an object.
+         *
+         * @return const std::vector<std::pair<std::string, Json>>& The members in the order of the text.
+         */
+        FORCE_INLINE const std::vector<std::pair<std::string, Json>>& GetMembers() const noexcept { return members; }
+
+        /**
+         * @brief Get an element of an array.
+         *
+         * @param p_index The index of the element.
+         * @throw std::out_of_range The index is out of range.
+         * @return const Json& The element.
+         */
+        const Json& operator[](size_t p_index) const;
+
+        /**
+         * @brief Find a member of an object.
+         *
+         * @param p_key The key of the member.
+         * @return const Json* The member, nullptr if there is no such member.
+         */
+        const Json* Find(std::string_view p_key) const noexcept;
+
+        /**
+         * @brief Get a member of an object.
+         *
+         * @param p_key The key of the member.
+         * @return const Json& The member, a null value if there is no such member.
+         */
+        const Json& operator[](std::string_view p_key) const noexcept;
+    };
+}
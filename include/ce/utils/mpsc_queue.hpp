@@ -0,0 +1,80 @@
+#pragma once
+#include <atomic>
+#include <utility>
+
+namespace CrossEngine
+{
+    /**
+     * @brief A lock-free queue with many producers and a single consumer.
+     * @details Pushing only exchanges the head pointer, so producers never wait for each other or
+     * for the consumer. A value whose producer is preempted during the push becomes visible to
+     * the consumer once the push completes.
+     *
+     * @tparam T The type of the values, default constructible.
+     */
+    template <typename T>
+    class MPSCQueue
+    {
+    private:
+        struct Node
+        {
+            std::atomic<Node*> next = nullptr;
+            T value{};
+        };
+
+        // Producers append after the head, the consumer pops after the tail.
+        std::atomic<Node*> head;
+        Node* tail;
+    public:
+
+        MPSCQueue()
+        {
+            tail = new Node();
+            head.store(tail, std::memory_order_relaxed);
+        }
+
+        MPSCQueue(const MPSCQueue&) = delete;
+        MPSCQueue& operator=(const MPSCQueue&) = delete;
+
+        ~MPSCQueue()
+        {
+            while (tail != nullptr)
+            {
+                Node* next = tail->next.load(std::memory_order_relaxed);
+                delete tail;
+                tail = next;
+            }
+        }
+
+        /**
+         * @brief Push a value. Can be called from any thread.
+         *
+         * @param p_value The value to push.
+         */
+        void Push(T p_value)
+        {
+            Node* node = new Node();
+            node->value = std::move(p_value);
+            Node* previous = head.exchange(node, std::memory_order_acq_rel);
+            previous->next.store(node, std::memory_order_release);
+        }
+
+        /**
+         * @brief Pop the oldest value. Must only be called from the consumer thread.
+         *
+         * @param p_value The popped value.
+         * @return true if a value is popped.
+         * @return false if the queue is empty.
+         */
+        bool Pop(T& p_value)
+        {
+            Node* next = tail->next.load(std::memory_order_acquire);
+            if (next == nullptr)
+                return false;
+            p_value = std::move(next->value);
+            delete tail;
+            tail = next;
+            return true;
+        }
+    };
+}
@@ -0,0 +1,234 @@
+#pragma once
+#include "ce/defs.hpp"
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <algorithm>
+#include <cstddef>
+
+namespace CrossEngine
+{
+    /**
+     * @brief The counters of an allocator.
+     */
+    struct AllocatorStats
+    {
+        size_t allocation_count = 0;
+        size_t free_count = 0;
+        size_t live_count = 0;
+        size_t chunk_count = 0;
+        size_t reserved_bytes = 0;
+    };
+
+    /**
+     * @brief A process wide pool of fixed size blocks for the objects of a type. Every thread keeps a cache
+     * of free blocks, so allocating and freeing only take the lock of the pool once per batch of blocks.
+     * The chunks of the pool are never returned to the system, the objects of the type are expected to be
+     * allocated again.
+     *
+     * @tparam T The type of the objects.
+     */
+    template <typename T>
+    class PoolAllocator
+    {
+    public:
+        /**
+         * @brief The count of blocks of a chunk.
+         */
+        static constexpr size_t CHUNK_BLOCK_COUNT = 4096;
+
+        /**
+         * @brief The count of blocks moved between a thread and the pool at once.
+         */
+        static constexpr size_t BATCH_SIZE = 256;
+    private:
+        struct FreeNode
+        {
+            FreeNode* next;
+        };
+
+        static constexpr size_t BLOCK_ALIGNMENT = std::max(alignof(T), alignof(FreeNode));
+        static constexpr size_t BLOCK_SIZE = (std::max(sizeof(T), sizeof(FreeNode)) + BLOCK_ALIGNMENT - 1)
+            / BLOCK_ALIGNMENT * BLOCK_ALIGNMENT;
+
+        // Trivially destructible, so it stays usable while the thread is destroying its other objects.
+        struct ThreadCache
+        {
+            FreeNode* head;
+            size_t count;
+            // Counted locally and added to the pool counters with every batch.
+            size_t allocation_count;
+            size_t free_count;
+            bool is_released;
+        };
+
+        struct ThreadCacheReleaser
+        {
+            ~ThreadCacheReleaser()
+            {
+                ReturnBlocks(cache.count);
+                cache.is_released = true;
+            }
+        };
+
+        inline static std::mutex pool_mutex;
+        inline static FreeNode* pool_head = nullptr;
+        inline static size_t pool_free_count = 0;
+        inline static std::atomic<size_t> allocation_count = 0;
+        inline static std::atomic<size_t> free_count = 0;
+        inline static std::atomic<size_t> chunk_count = 0;
+
+        inline static thread_local ThreadCache cache = {};
+        inline static thread_local ThreadCacheReleaser releaser;
+
+        static void FlushCounters()
+        {
+            allocation_count.fetch_add(cache.allocation_count, std::memory_order_relaxed);
+            free_count.fetch_add(cache.free_count, std::memory_order_relaxed);
+            cache.allocation_count = 0;
+            cache.free_count = 0;
+        }
+
+        static void TakeBlocks()
+        {
+            // Construct the releaser of this thread before the cache holds any block.
+            (void)&releaser;
+            FlushCounters();
+            std::lock_guard<std::mutex> lock(pool_mutex);
+            if (pool_head == nullptr)
+            {
+                auto chunk = static_cast<std::byte*>(::operator new(BLOCK_SIZE * CHUNK_BLOCK_COUNT, std::align_val_t(BLOCK_ALIGNMENT)));
+                for (size_t i = CHUNK_BLOCK_COUNT; i > 0; --i)
+                {
+                    auto node = reinterpret_cast<FreeNode*>(chunk + (i - 1) * BLOCK_SIZE);
+                    node->next = pool_head;
+                    pool_head = node;
+                }
+                pool_free_count += CHUNK_BLOCK_COUNT;
+                chunk_count.fetch_add(1, std::memory_order_relaxed);
+            }
+            while (pool_head != nullptr && cache.count < BATCH_SIZE)
+            {
+                FreeNode* node = pool_head;
+                pool_head = node->next;
+                node->next = cache.head;
+                cache.head = node;
+                ++cache.count;
+                --pool_free_count;
+            }
+        }
+
+        static void ReturnBlocks(size_t p_count)
+        {
+            FlushCounters();
+            std::lock_guard<std::mutex> lock(pool_mutex);
+            for (; p_count > 0 && cache.head != nullptr; --p_count)
+            {
+                FreeNode* node = cache.head;
+                cache.head = node->next;
+                node->next = pool_head;
+                pool_head = node;
+                --cache.count;
+                ++pool_free_count;
+            }
+        }
+    public:
+        PoolAllocator() = delete;
+
+        /**
+         * @brief Allocate a block for an object.
+         *
+         * @return void* The block, uninitialized.
+         */
+        static void* Allocate()
+        {
+            if (cache.is_released) [[unlikely]]
+            {
+                // The thread is exiting, the blocks go through the pool directly.
+                cache.is_released = false;
+                void* result = Allocate();
+                ReturnBlocks(cache.count);
+                cache.is_released = true;
+                return result;
+            }
+            if (cache.head == nullptr)
+                TakeBlocks();
+            FreeNode* node = cache.head;
+            cache.head = node->next;
+            --cache.count;
+            ++cache.allocation_count;
+            return node;
+        }
+
+        /**
+         * @brief Free a block allocated by the pool.
+         *
+         * @param p_block The block, can be allocated by another thread.
+         */
+        static void Free(void* p_block) noexcept
+        {
+            if (p_block == nullptr)
+                return;
+            auto node = static_cast<FreeNode*>(p_block);
+            node->next = cache.head;
+            cache.head = node;
+            ++cache.count;
+            ++cache.free_count;
+            if (cache.is_released || cache.count >= 2 * BATCH_SIZE)
+                ReturnBlocks(cache.is_released ? cache.count : BATCH_SIZE);
+        }
+
+        /**
+         * @brief Get the counters of the pool. The counters of the other threads are added with every
+         * batch they take or return, so they can be behind by less than a batch per thread.
+         *
+         * @return AllocatorStats The counters of the pool.
+         */
+        static AllocatorStats GetStats()
+        {
+            FlushCounters();
+            AllocatorStats stats;
+            stats.allocation_count = allocation_count.load(std::memory_order_relaxed);
+            stats.free_count = free_count.load(std::memory_order_relaxed);
+            stats.live_count = stats.allocation_count >= stats.free_count ? stats.allocation_count - stats.free_count : 0;
+            stats.chunk_count = chunk_count.load(std::memory_order_relaxed);
+            stats.reserved_bytes = stats.chunk_count * CHUNK_BLOCK_COUNT * BLOCK_SIZE;
+            return stats;
+        }
+    };
+
+    /**
+     * @brief A standard allocator allocating single objects from the pool of their type, such as the
+     * objects made by std::allocate_shared. Arrays are allocated by the global allocator.
+     *
+     * @tparam T The type of the objects.
+     */
+    template <typename T>
+    struct PoolStdAllocator
+    {
+        using value_type = T;
+
+        PoolStdAllocator() noexcept = default;
+
+        template <typename U>
+        PoolStdAllocator(const PoolStdAllocator<U>&) noexcept {}
+
+        T* allocate(size_t p_count)
+        {
+            if (p_count == 1)
+                return static_cast<T*>(PoolAllocator<T>::Allocate());
+            return static_cast<T*>(::operator new(p_count * sizeof(T), std::align_val_t(alignof(T))));
+        }
+
+        void deallocate(T* p_ptr, size_t p_count) noexcept
+        {
+            if (p_count == 1)
+                PoolAllocator<T>::Free(p_ptr);
+            else
+                ::operator delete(p_ptr, std::align_val_t(alignof(T)));
+        }
+
+        template <typename U>
+        bool operator==(const PoolStdAllocator<U>&) const noexcept { return true; }
+    };
+}
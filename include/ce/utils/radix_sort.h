@@ -0,0 +1,53 @@
+#pragma once
+#include "ce/defs.hpp"
+#include <vector>
+#include <cstdint>
+#include <cstring>
+
+namespace CrossEngine
+{
+    /**
+     * @brief Convert a float to a key that sorts in the same order as the float.
+     * 
+     * @param p_value The float to convert.
+     * @return uint32_t The key.
+     */
+    FORCE_INLINE uint32_t FloatToSortKey(float p_value) noexcept
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &p_value, sizeof(bits));
+        // Flip all bits of negative floats and only the sign bit of positive ones.
+        return bits ^ ((uint32_t)((int32_t)bits >> 31) | 0x80000000u);
+    }
+
+    /**
+     * @brief The scratch memory of RadixSort. Kept by a caller that sorts every frame, so the sorts reuse
+     * the memory of the previous ones instead of allocating.
+     */
+    struct RadixSortBuffers
+    {
+        std::vector<uint32_t> keys;
+        std::vector<uint32_t> values;
+        std::vector<uint32_t> histograms;
+    };
+
+    /**
+     * @brief Stable LSD radix sort of keys with their values in ascending key order.
+     * 
+     * @param p_keys The keys to sort.
+     * @param p_values The values that move together with the keys.
+     * @param p_buffers The scratch memory, only grown when the keys do not fit.
+     * @throw std::invalid_argument The sizes of the keys and the values do not match.
+     */
+    void RadixSort(std::vector<uint32_t>& p_keys, std::vector<uint32_t>& p_values, RadixSortBuffers& p_buffers);
+
+    /**
+     * @brief Stable LSD radix sort of keys with their values in ascending key order, with scratch memory
+     * allocated by the call.
+     * 
+     * @param p_keys The keys to sort.
+     * @param p_values The values that move together with the keys.
+     * @throw std::invalid_argument The sizes of the keys and the values do not match.
+     */
+    void RadixSort(std::vector<uint32_t>& p_keys, std::vector<uint32_t>& p_values);
+}
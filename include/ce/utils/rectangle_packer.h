@@ -0,0 +1,70 @@
+#pragma once
+#include "ce/defs.hpp"
+#include <optional>
+#include <vector>
+
+namespace CrossEngine
+{
+    /**
+     * @brief Pack rectangles of different sizes into a larger one, such as the textures of an atlas.
+     * @details The packed rectangles are tracked by their skyline, the top edge of what is packed below each
+     * column. A rectangle is placed where its top is the lowest, on the narrowest segment if several are,
+     * which keeps the skyline flat and the wasted space below it small.
+     */
+    class RectanglePacker
+    {
+    public:
+        struct Rect
+        {
+            size_t x = 0;
+            size_t y = 0;
+            size_t width = 0;
+            size_t height = 0;
+        };
+    private:
+        struct Segment
+        {
+            size_t x;
+            size_t y;
+            size_t width;
+        };
+
+        size_t width;
+        size_t height;
+        size_t used_area = 0;
+        std::vector<Segment> skyline;
+    public:
+        /**
+         * @brief Construct a new packer.
+         *
+         * @param p_width The width of the rectangle to pack into.
+         * @param p_height The height of the rectangle to pack into.
+         * @throw std::invalid_argument The width or the height is 0.
+         */
+        RectanglePacker(size_t p_width, size_t p_height);
+
+        /**
+         * @brief Pack a rectangle.
+         *
+         * @param p_width The width of the rectangle.
+         * @param p_height The height of the rectangle.
+         * @return std::optional<Rect> Where the rectangle is packed, std::nullopt if it does not fit or is empty.
+         */
+        std::optional<Rect> Insert(size_t p_width, size_t p_height);
+
+        /**
+         * @brief Remove every packed rectangle.
+         */
+        void Clear();
+
+        FORCE_INLINE size_t GetWidth() const noexcept { return width; }
+        FORCE_INLINE size_t GetHeight() const noexcept { return height; }
+
+        /**
+         * @brief Get the area of the packed rectangles.
+         *
+         * @return size_t The area.
+         */
+        FORCE_INLINE size_t GetUsedArea() const noexcept { return used_area; }
+    };
+}
@@ -0,0 +1,172 @@
+#pragma once
+#include "ce/defs.hpp"
+#include <vector>
+#include <optional>
+#include <cstdint>
+
+namespace CrossEngine
+{
+    /**
+     * @brief Values addressed by generational handles. Inserting and removing are O(1), and a handle
+     * of a removed value never addresses the value inserted in its slot afterwards.
+     *
+     * @tparam T The type of the values.
+     */
+    template <typename T>
+    class SlotMap
+    {
+    public:
+        /**
+         * @brief The handle of a value in a slot map.
+         */
+        struct Handle
+        {
+            uint32_t index = UINT32_MAX;
+            uint32_t generation = 0;
+
+            FORCE_INLINE bool IsValid() const noexcept { return index != UINT32_MAX; }
+            FORCE_INLINE bool operator==(const Handle& p_other) const noexcept = default;
+        };
+    private:
+        static constexpr uint32_t NO_SLOT = UINT32_MAX;
+
+        struct Slot
+        {
+            std::optional<T> value;
+            // Incremented every time the value of the slot is removed.
+            uint32_t generation = 0;
+            uint32_t next_free = NO_SLOT;
+        };
+
+        std::vector<Slot> slots;
+        uint32_t free_head = NO_SLOT;
+        size_t size = 0;
+
+        FORCE_INLINE const Slot* GetSlot(const Handle& p_handle) const noexcept
+        {
+            if (p_handle.index >= slots.size())
+                return nullptr;
+            const Slot& slot = slots[p_handle.index];
+            if (slot.generation != p_handle.generation || !slot.value.has_value())
+                return nullptr;
+            return &slot;
+        }
+    public:
+
+        /**
+         * @brief Insert a value, reusing the slot of the last removed value.
+         *
+         * @param p_value The value to insert.
+         * @return Handle The handle of the value.
+         */
+        Handle Insert(T p_value)
+        {
+            uint32_t index;
+            if (free_head != NO_SLOT)
+            {
+                index = free_head;
+                free_head = slots[index].next_free;
+            }
+            else
+            {
+                index = (uint32_t)slots.size();
+                slots.emplace_back();
+            }
+            slots[index].value.emplace(std::move(p_value));
+            ++size;
+            return Handle{index, slots[index].generation};
+        }
+
+        /**
+         * @brief Remove a value.
+         *
+         * @param p_handle The handle of the value.
+         * @return true if the value is removed.
+         * @return false if the handle does not address a value.
+         */
+        bool Remove(const Handle& p_handle) noexcept
+        {
+            if (GetSlot(p_handle) == nullptr)
+                return false;
+            Slot& slot = slots[p_handle.index];
+            slot.value.reset();
+            ++slot.generation;
+            slot.next_free = free_head;
+            free_head = p_handle.index;
+            --size;
+            return true;
+        }
+
+        /**
+         * @brief Get a value.
+         *
+         * @param p_handle The handle of the value.
+         * @return T* The value, nullptr if the handle does not address a value.
+         */
+        FORCE_INLINE T* Get(const Handle& p_handle) noexcept
+        {
+            auto slot = GetSlot(p_handle);
+            return slot == nullptr ? nullptr : &slots[p_handle.index].value.value();
+        }
+
+        /**
+         * @brief Get a value.
+         *
+         * @param p_handle The handle of the value.
+         * @return const T* The value, nullptr if the handle does not address a value.
+         */
+        FORCE_INLINE const T* Get(const Handle& p_handle) const noexcept
+        {
+            auto slot = GetSlot(p_handle);
+            return slot == nullptr ? nullptr : &slot->value.value();
+        }
+
+        /**
+         * @brief Does a handle address a value.
+         *
+         * @param p_handle The handle.
+         * @return true if the handle addresses a value.
+         * @return false if the value is removed or the handle is invalid.
+         */
+        FORCE_INLINE bool Contains(const Handle& p_handle) const noexcept { return GetSlot(p_handle) != nullptr; }
+
+        /**
+         * @brief Get the number of values.
+         *
+         * @return size_t The number of values.
+         */
+        FORCE_INLINE size_t Size() const noexcept { return size; }
+
+        /**
+         * @brief Call a function with every value.
+         *
+         * @param p_func The function, called with a reference to each value.
+         */
+        template <typename F>
+        void ForEach(F&& p_func)
+        {
+            for (auto& slot : slots)
+            {
+                if (slot.value.has_value())
+                    p_func(slot.value.value());
+            }
+        }
+
+        /**
+         * @brief Remove every value. The handles of the removed values stay invalid.
+         */
+        void Clear() noexcept
+        {
+            for (uint32_t i = 0; i < slots.size(); ++i)
+            {
+                if (!slots[i].value.has_value())
+                    continue;
+                slots[i].value.reset();
+                ++slots[i].generation;
+                slots[i].next_free = free_head;
+                free_head = i;
+            }
+            size = 0;
+        }
+    };
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include "ce/defs.hpp"
+#include <string>
+#include <string_view>
+#include <functional>
+#include <cstdint>
+
+namespace CrossEngine
+{
+    /**
+     * @brief An interned string. Every equal string is interned to the same id, so comparing and hashing
+     * interned strings only touches the id.
+     * @note Interned strings live until the process exits.
+     */
+    class StringId
+    {
+    private:
+        uint32_t id = UINT32_MAX;
+
+        explicit StringId(uint32_t p_id) noexcept : id(p_id) {}
+    public:
+        /**
+         * @brief Construct an invalid string id.
+         */
+        StringId() noexcept = default;
+
+        /**
+         * @brief Intern a string.
+         *
+         * @param p_string The string to intern.
+         * @return StringId The id of the string.
+         */
+        static StringId Intern(std::string_view p_string);
+
+        /**
+         * @brief Find the id of a string without interning it.
+         *
+         * @param p_string The string to find.
+         * @return StringId The id of the string, invalid if the string is not interned.
+         */
+        static StringId Find(std::string_view p_string);
+
+        /**
+         * @brief Get the count of interned strings.
+         *
+         * @return size_t The count of interned strings.
+         */
+        static size_t GetInternedCount();
+
+        /**
+         * @brief Get the interned string.
+         *
+         * @return const std::string& The string, empty if the id is invalid.
+         */
+        const std::string& GetString() const;
+
+        FORCE_INLINE uint32_t GetId() const noexcept { return id; }
+        FORCE_INLINE bool IsValid() const noexcept { return id != UINT32_MAX; }
+        FORCE_INLINE bool operator==(const StringId& p_other) const noexcept = default;
+    };
+}
+
+template <>
+struct std::hash<CrossEngine::StringId>
+{
+    size_t operator()(const CrossEngine::StringId& p_id) const noexcept
+    {
+        return std::hash<uint32_t>()(p_id.GetId());
+    }
+};
@@ -1,7 +1,9 @@
 #pragma once
 #include "ce/defs.hpp"
+#include "ce/utils/frame_allocator.h"
 #include <functional>
 #include <iostream>
+#include <type_traits>
 
 namespace CrossEngine
 {
@@ -13,10 +15,36 @@ namespace CrossEngine
         float priority;
         Task(const std::function<void()>& p_task, float priority)
             : task(p_task), priority(priority) {}
+
+        /**
+         * @brief Construct a task from a callable. Callables larger than the storage of std::function are
+         * stored by the frame allocator of the calling thread, so the task must run before the thread ends
+         * its frame.
+         *
+         * @param p_task The callable.
+         * @param priority The priority of the task.
+         */
+        template <typename F>
+            requires (!std::is_same_v<std::decay_t<F>, std::function<void()>>)
+        Task(F&& p_task, float priority)
+            : priority(priority)
+        {
+            using Callable = std::decay_t<F>;
+            if constexpr (sizeof(Callable) > 2 * sizeof(void*) && std::is_trivially_destructible_v<Callable>)
+            {
+                void* storage = FrameAllocator::GetThreadInstance().allocate(sizeof(Callable), alignof(Callable));
+                Callable* callable = ::new (storage) Callable(std::forward<F>(p_task));
+                task = [callable]() { (*callable)(); };
+            }
+            else
+            {
+                task = std::forward<F>(p_task);
+            }
+        }
         
         FORCE_INLINE auto operator <=>(const Task& p_other) const
         {
             return priority <=> p_other.priority;
         }
     };
-}
\ No newline at end of file
+}
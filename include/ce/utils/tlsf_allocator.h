@@ -0,0 +1,175 @@
+#pragma once
+#include "ce/defs.hpp"
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace CrossEngine
+{
+    /**
+     * @brief A two-level segregated fit allocator handing out ranges of an external memory, such as a GPU buffer.
+     * @details The free blocks are kept in lists segregated by a first level power of two and a second level
+     * linear subdivision. Bitmaps over the lists find a fitting block with two bit scans, so both allocating
+     * and freeing take constant time. Freed blocks are merged with their free neighbours.
+     */
+    class TLSFAllocator
+    {
+    public:
+        static constexpr uint32_t INVALID_BLOCK = UINT32_MAX;
+    private:
+        static constexpr size_t SL_LOG2 = 4;
+        static constexpr size_t SL_COUNT = 1 << SL_LOG2;
+        static constexpr size_t FL_COUNT = 64 - SL_LOG2 + 1;
+
+        struct Block
+        {
+            size_t offset = 0;
+            size_t size = 0;
+            uint32_t prev_physical = INVALID_BLOCK;
+            uint32_t next_physical = INVALID_BLOCK;
+            uint32_t prev_free = INVALID_BLOCK;
+            uint32_t next_free = INVALID_BLOCK;
+            bool is_free = false;
+        };
+
+        std::vector<Block> blocks;
+        std::vector<uint32_t> unused_blocks;
+        uint64_t fl_bitmap = 0;
+        uint32_t sl_bitmaps[FL_COUNT] = {};
+        uint32_t free_lists[FL_COUNT][SL_COUNT];
+
+        size_t granularity;
+        size_t size = 0;
+        size_t free_size = 0;
+        uint32_t last_block = INVALID_BLOCK;
+
+        static void MapSize(size_t p_units, size_t& p_fl, size_t& p_sl);
+        // Map a size to the first list whose blocks all fit it.
+        void MapSearchSize(size_t p_size, size_t& p_fl, size_t& p_sl) const;
+        uint32_t NewBlock();
+        void InsertFreeBlock(uint32_t p_block);
+        void RemoveFreeBlock(uint32_t p_block);
+        void MergeWithNext(uint32_t p_block);
+    public:
+
+        /**
+         * @brief Construct a new allocator.
+         *
+         * @param p_size The size of the managed memory in bytes.
+         * @param p_granularity Offsets and sizes are multiples of the granularity in bytes.
+         * @throw std::invalid_argument The granularity is 0.
+         */
+        TLSFAllocator(size_t p_size, size_t p_granularity = 16);
+
+        /**
+         * @brief Allocate a range.
+         *
+         * @param p_size The size of the range in bytes, rounded up to the granularity.
+         * @return uint32_t The block of the range, INVALID_BLOCK if no free block fits.
+         */
+        uint32_t Allocate(size_t p_size);
+
+        /**
+         * @brief Free a range.
+         *
+         * @param p_block The block of the range returned by Allocate.
+         * @throw std::invalid_argument The block is not allocated.
+         */
+        void Free(uint32_t p_block);
+
+        /**
+         * @brief Extend the managed memory. The new memory starts at the end of the old one.
+         *
+         * @param p_size The new size of the managed memory in bytes.
+         */
+        void Grow(size_t p_size);
+
+        /**
+         * @brief Get the offset of a range in bytes.
+         *
+         * @param p_block The block of the range.
+         * @return size_t The offset of the range.
+         */
+        FORCE_INLINE size_t GetOffset(uint32_t p_block) const { return blocks[p_block].offset * granularity; }
+
+        /**
+         * @brief Get the size of a range in bytes.
+         *
+         * @param p_block The block of the range.
+         * @return size_t The size of the range, rounded up to the granularity.
+         */
+        FORCE_INLINE size_t GetSize(uint32_t p_block) const { return blocks[p_block].size * granularity; }
+
+        /**
+         * @brief Allocate the free range at the end of the memory, so following allocations come before it.
+         *
+         * @return uint32_t The block of the range, INVALID_BLOCK if the end of the memory is allocated.
+         */
+        uint32_t AllocateLast();
+
+        /**
+         * @brief Is a block free.
+         *
+         * @param p_block The block.
+         * @return true if the block is free.
+         * @return false if the block is allocated.
+         */
+        FORCE_INLINE bool IsFree(uint32_t p_block) const { return blocks[p_block].is_free; }
+
+        /**
+         * @brief Get the block right before a block in the memory.
+         *
+         * @param p_block The block.
+         * @return uint32_t The previous block, INVALID_BLOCK if the block is at the beginning of the memory.
+         */
+        FORCE_INLINE uint32_t GetPreviousBlock(uint32_t p_block) const { return blocks[p_block].prev_physical; }
+
+        /**
+         * @brief Get the allocated block with the highest offset.
+         *
+         * @return uint32_t The allocated block with the highest offset, INVALID_BLOCK if nothing is allocated.
+         */
+        uint32_t GetLastAllocatedBlock() const noexcept;
+
+        /**
+         * @brief Get the size of the managed memory in bytes.
+         *
+         * @return size_t The size of the managed memory.
+         */
+        FORCE_INLINE size_t GetCapacity() const noexcept { return size * granularity; }
+
+        /**
+         * @brief Get the total size of the free ranges in bytes.
+         *
+         * @return size_t The total size of the free ranges.
+         */
+        FORCE_INLINE size_t GetFreeSize() const noexcept { return free_size * granularity; }
+
+        /**
+         * @brief Get the granularity of the offsets and the sizes in bytes.
+         *
+         * @return size_t The granularity.
+         */
+        FORCE_INLINE size_t GetGranularity() const noexcept { return granularity; }
+
+        // The count of size classes, one per free list.
+        static constexpr uint32_t CLASS_COUNT = FL_COUNT * SL_COUNT;
+        static constexpr uint32_t INVALID_CLASS = UINT32_MAX;
+
+        /**
+         * @brief Get the size class of the largest free block. Allocate fits a size if this is at least the
+         * class returned by GetAllocationClass for the size.
+         *
+         * @return uint32_t The size class, INVALID_CLASS if nothing is free.
+         */
+        uint32_t GetLargestFreeClass() const noexcept;
+
+        /**
+         * @brief Get the smallest size class whose free blocks all fit a size.
+         *
+         * @param p_size The size in bytes.
+         * @return uint32_t The size class, INVALID_CLASS if no block can fit the size.
+         */
+        uint32_t GetAllocationClass(size_t p_size) const noexcept;
+    };
+}
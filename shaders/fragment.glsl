@@ -1,6 +1,10 @@
 #version 330 core
 
-out vec4 FragColor;
+layout (location = 0) out vec4 FragColor;
+// The revealage of the weighted blended transparency pass.
+layout (location = 1) out vec4 FragRevealage;
+
+uniform int oit;
 
 #define MAX_POINT_LIGHTS 4
 struct PointLight {
@@ -37,6 +41,20 @@ struct Material {
     sampler2D metallic;
     sampler2D roughness;
     sampler2D ao;
+    // Set when the normal is a two channel BC5 texture, which only stores X and Y.
+    int normal_two_channel;
+};
+
+// The textures of the materials packed in a MaterialAtlas.
+struct MaterialArray {
+    sampler2DArray albedo;
+    sampler2DArray normal;
+    sampler2DArray metallic;
+    sampler2DArray roughness;
+    sampler2DArray ao;
+    float layer;
+    // The scale of the UV in xy, and its offset in zw.
+    vec4 uv_transform;
 };
 
 uniform vec4 scaler_albedo;
@@ -50,6 +68,8 @@ float roughness;
 float ao;
 
 uniform Material material;
+uniform MaterialArray material_array;
+uniform int use_material_array;
 
 const float PI = 3.141592653589793;
 
@@ -59,19 +79,22 @@ float TRGGX(vec4 p_normal, vec4 p_half);
 float SchlickGGX(float p_dot_norm_vec, float p_k);
 float GSmith(float p_dot_normal_cam, float p_dot_normal_light);
 vec4 FresnelSchlick(vec4 p_half, vec4 p_to_camera, vec4 f0);
+vec4 SampleMaterial(sampler2D p_texture, sampler2DArray p_array);
 
 vec4 f0;
 void main()
 {
     vec4 to_camera = normalize(camera_position - frag_position);
 
-    albedo = scaler_albedo * texture(material.albedo, frag_texture_uv);
-    normal = texture(material.normal, frag_texture_uv) * 2.0 - vec4(1.0);
+    albedo = scaler_albedo * SampleMaterial(material.albedo, material_array.albedo);
+    normal = SampleMaterial(material.normal, material_array.normal) * 2.0 - vec4(1.0);
+    if (use_material_array == 0 && material.normal_two_channel != 0)
+        normal.z = sqrt(max(1.0 - dot(normal.xy, normal.xy), 0.0));
     normal.w = 0.0;
     normal = normalize(frag_tbn * normal);
-    metallic = scaler_metallic * texture(material.metallic, frag_texture_uv).r;
-    roughness = scaler_roughness * texture(material.roughness, frag_texture_uv).r;
-    ao = texture(material.ao, frag_texture_uv).r;
+    metallic = scaler_metallic * SampleMaterial(material.metallic, material_array.metallic).r;
+    roughness = scaler_roughness * SampleMaterial(material.roughness, material_array.roughness).r;
+    ao = SampleMaterial(material.ao, material_array.ao).r;
 
 
     f0 = mix(vec4(0.04), albedo, metallic);
@@ -91,7 +114,18 @@ void main()
     temp_color *= ao;
 
     temp_color[3] = albedo[3];
-    FragColor = temp_color;
+    if (oit == 0)
+    {
+        FragColor = temp_color;
+        return;
+    }
+    // Weighted blended order independent transparency, nearer and more opaque fragments weigh more.
+    // The OIT_* constants are defined by OITMath.
+    float alpha = temp_color[3];
+    float weight = clamp(pow(min(1.0, alpha * OIT_WEIGHT_ALPHA_SCALE) + OIT_WEIGHT_ALPHA_BIAS, 3.0) * OIT_WEIGHT_SCALE
+        * pow(1.0 - gl_FragCoord.z * OIT_WEIGHT_DEPTH_SCALE, 3.0), OIT_WEIGHT_MIN, OIT_WEIGHT_MAX);
+    FragColor = vec4(temp_color.rgb * alpha * weight, alpha);
+    FragRevealage = vec4(alpha * weight, 0.0, 0.0, alpha);
 }
 
 vec4 ShadeColor(vec4 p_to_camera, vec4 p_to_light, float p_d_to_light, vec4 p_normal, vec4 p_color, float p_intensity)
@@ -130,4 +164,15 @@ float GSmith(float p_dot_normal_cam, float p_dot_normal_light)
 vec4 FresnelSchlick(vec4 p_half, vec4 p_to_camera, vec4 f0)
 {
     return f0 + (1 - f0) * pow(clamp(1.0 - dot(p_half, p_to_camera), 0.0, 1.0), 5.0);
+}
+
+vec4 SampleMaterial(sampler2D p_texture, sampler2DArray p_array)
+{
+    if (use_material_array == 0)
+        return texture(p_texture, frag_texture_uv);
+    // The UV repeats within the rectangle of the material. The gradients of the unrepeated UV pick the level,
+    // so the level does not jump at the edges of the rectangle.
+    vec2 scale = material_array.uv_transform.xy;
+    vec2 uv = fract(frag_texture_uv) * scale + material_array.uv_transform.zw;
+    return textureGrad(p_array, vec3(uv, material_array.layer), dFdx(frag_texture_uv) * scale, dFdy(frag_texture_uv) * scale);
 }
\ No newline at end of file
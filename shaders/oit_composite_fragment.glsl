@@ -0,0 +1,24 @@
+#version 330 core
+
+out vec4 FragColor;
+
+in vec2 frag_texture_uv;
+
+uniform sampler2D opaque;
+uniform sampler2D accumulation;
+uniform sampler2D revealage;
+
+// The OIT_* constants are defined by OITMath.
+void main()
+{
+    vec4 opaque_color = texture(opaque, frag_texture_uv);
+    vec4 reveal = texture(revealage, frag_texture_uv);
+    // The alpha of the revealage target is the product of (1 - alpha) of every transparent fragment.
+    if (reveal.a >= OIT_REVEALED_THRESHOLD)
+    {
+        FragColor = opaque_color;
+        return;
+    }
+    vec3 average_color = texture(accumulation, frag_texture_uv).rgb / max(reveal.r, OIT_MIN_WEIGHT_SUM);
+    FragColor = vec4(mix(average_color, opaque_color.rgb, reveal.a), 1.0);
+}
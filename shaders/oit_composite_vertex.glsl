@@ -0,0 +1,11 @@
+#version 330 core
+
+out vec2 frag_texture_uv;
+
+void main()
+{
+    // A triangle covering the whole screen.
+    vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    frag_texture_uv = position;
+    gl_Position = vec4(position * 2.0 - 1.0, 0.0, 1.0);
+}
@@ -0,0 +1,75 @@
+#include "../benchmark.h"
+#include "ce/component/component.h"
+#include <vector>
+
+using namespace CrossEngine;
+
+void Benchmark::BenchComponentLookup()
+{
+    constexpr size_t QUERY_COUNT = 100000;
+
+    for (size_t sibling_count : {10, 10000})
+    {
+        auto root = std::make_shared<Component>("root");
+        auto level = std::make_shared<Component>("level");
+        root->AddChild(level);
+        std::vector<std::shared_ptr<Component>> rooms;
+        for (size_t i = 0; i < sibling_count; ++i)
+        {
+            rooms.push_back(std::make_shared<Component>("room" + std::to_string(i)));
+            level->AddChild(rooms.back());
+        }
+        auto door = std::make_shared<Component>("door");
+        rooms.back()->AddChild(door);
+        std::string last_name = rooms.back()->GetName();
+        std::string path = "level/" + last_name + "/door";
+        std::string siblings = " (" + std::to_string(sibling_count) + " siblings)";
+
+        size_t found = 0;
+        // The linear scan comparing the names, as GetChild did before the index.
+        double time = Measure([&](){
+            for (size_t i = 0; i < QUERY_COUNT; ++i)
+            {
+                level->ForEachChild([&](const std::shared_ptr<Component>& p_child) {
+                    found += p_child->GetName() == last_name;
+                });
+            }
+        });
+        Report("GetChild linear scan" + siblings, time / QUERY_COUNT * 1e9, "ns");
+
+        time = Measure([&](){
+            for (size_t i = 0; i < QUERY_COUNT; ++i)
+                found += level->GetChild(last_name) != nullptr;
+        });
+        Report("GetChild by name" + siblings, time / QUERY_COUNT * 1e9, "ns");
+
+        StringId name_id = StringId::Intern(last_name);
+        time = Measure([&](){
+            for (size_t i = 0; i < QUERY_COUNT; ++i)
+                found += level->GetChild(name_id) != nullptr;
+        });
+        Report("GetChild by interned name" + siblings, time / QUERY_COUNT * 1e9, "ns");
+
+        time = Measure([&](){
+            for (size_t i = 0; i < QUERY_COUNT; ++i)
+                found += root->FindPath(path) != nullptr;
+        });
+        Report("FindPath cached" + siblings, time / QUERY_COUNT * 1e9, "ns");
+
+        // Every query follows a change of the subtree, so the path is resolved again.
+        auto spawned = std::make_shared<Component>("spawned");
+        time = Measure([&](){
+            for (size_t i = 0; i < QUERY_COUNT; ++i)
+            {
+                if (i % 2 == 0)
+                    door->AddChild(spawned);
+                else
+                    door->RemoveChild(spawned.get());
+                found += root->FindPath(path) != nullptr;
+            }
+        });
+        Report("FindPath after a change of the subtree" + siblings, time / QUERY_COUNT * 1e9, "ns");
+        if (found != 5 * QUERY_COUNT)
+            throw std::runtime_error("The lookups should find the component.");
+    }
+}
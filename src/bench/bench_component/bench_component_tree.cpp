@@ -0,0 +1,88 @@
+#include "../benchmark.h"
+#include "ce/component/component3D.h"
+#include "ce/component/component_pool.hpp"
+#include <thread>
+#include <vector>
+#include <memory>
+
+using namespace CrossEngine;
+
+void Benchmark::BenchComponentTree()
+{
+    constexpr size_t BRANCH_COUNT = 100;
+    constexpr size_t LEAF_COUNT = 1000;
+    constexpr size_t FRAME_COUNT = 20;
+    // The game thread and three window threads walk the tree at the same time.
+    constexpr size_t THREAD_COUNT = 4;
+
+    auto measure_tree = [](const std::string& p_name, Component3D* p_root, const std::vector<Component3D*>& p_nodes) {
+        double time = Measure([&](){
+            for (size_t frame = 0; frame < FRAME_COUNT; ++frame)
+                p_root->Update(0.01f);
+        });
+        Report(p_name + " update (100k nodes)", time / FRAME_COUNT * 1000.0, "ms");
+
+        time = 0.0;
+        for (size_t frame = 0; frame < FRAME_COUNT; ++frame)
+        {
+            // Clean matrices are marked dirty again when the root moves.
+            for (auto node : p_nodes)
+                node->GetSubspaceMatrix();
+            time += Measure([&](){ p_root->Rotate(Math::UP<4>, 0.01f); });
+        }
+        Report(p_name + " dirty propagation (100k nodes)", time / FRAME_COUNT * 1000.0, "ms");
+
+        time = Measure([&](){
+            std::vector<std::thread> threads;
+            for (size_t i = 0; i < THREAD_COUNT; ++i)
+            {
+                threads.emplace_back([p_root](){
+                    for (size_t frame = 0; frame < FRAME_COUNT; ++frame)
+                        p_root->RegisterDraw(nullptr);
+                });
+            }
+            for (auto& i : threads)
+                i.join();
+        });
+        Report(p_name + " concurrent walk (100k nodes, 4 threads)", time / FRAME_COUNT * 1000.0, "ms");
+    };
+
+    {
+        auto root = std::make_shared<Component3D>();
+        std::vector<std::shared_ptr<Component3D>> nodes;
+        std::vector<Component3D*> node_pointers;
+        for (size_t i = 0; i < BRANCH_COUNT; ++i)
+        {
+            auto branch = std::make_shared<Component3D>();
+            root->AddChild(branch);
+            nodes.push_back(branch);
+            for (size_t j = 0; j < LEAF_COUNT; ++j)
+            {
+                auto leaf = std::make_shared<Component3D>();
+                branch->AddChild(leaf);
+                nodes.push_back(leaf);
+            }
+        }
+        for (auto& i : nodes)
+            node_pointers.push_back(i.get());
+        measure_tree("Shared component tree", root.get(), node_pointers);
+    }
+    {
+        ComponentPool<Component3D> pool;
+        std::vector<Component3D*> nodes;
+        auto root = pool.Get(pool.Create());
+        for (size_t i = 0; i < BRANCH_COUNT; ++i)
+        {
+            auto branch = pool.Get(pool.Create());
+            root->AddChild(branch);
+            nodes.push_back(branch);
+            for (size_t j = 0; j < LEAF_COUNT; ++j)
+            {
+                auto leaf = pool.Get(pool.Create());
+                branch->AddChild(leaf);
+                nodes.push_back(leaf);
+            }
+        }
+        measure_tree("Pooled component tree", root, nodes);
+    }
+}
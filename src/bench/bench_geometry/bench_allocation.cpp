@@ -0,0 +1,142 @@
+#include "../benchmark.h"
+#include "ce/geometry/geometry_arena.h"
+#include <vector>
+#include <thread>
+#include <future>
+
+using namespace CrossEngine;
+
+namespace
+{
+    constexpr size_t TRIANGLE_COUNT = 1000000;
+
+    const Vertex VERTICES[3] = {Vertex(Math::Pos(0.0f, 0.0f, 0.0f)), Vertex(Math::Pos(1.0f, 0.0f, 0.0f)), Vertex(Math::Pos(0.0f, 1.0f, 0.0f))};
+
+    // A triangle and its vertices allocated one by one by the global allocator, as before the pools.
+    Triangle* CreateHeapTriangle()
+    {
+        Vertex* v1 = ::new Vertex(VERTICES[0]);
+        Vertex* v2 = ::new Vertex(VERTICES[1]);
+        Vertex* v3 = ::new Vertex(VERTICES[2]);
+        return ::new (::operator new(sizeof(Triangle))) Triangle(std::move(v1), std::move(v2), std::move(v3));
+    }
+
+    void DestroyHeapTriangle(Triangle* p_triangle)
+    {
+        for (int i = 0; i < 3; ++i)
+            ::delete p_triangle->GetVertex(i);
+        // The destructor of the triangle would free its vertices to the pool.
+        ::operator delete(p_triangle);
+    }
+
+    // An asset of triangles, loaded and unloaded the way its allocation strategy does it.
+    struct Asset
+    {
+        std::vector<Triangle*> triangles;
+        std::unique_ptr<GeometryArena> arena;
+    };
+
+    void LoadHeap(Asset& p_asset, size_t p_count)
+    {
+        for (size_t i = 0; i < p_count; ++i)
+            p_asset.triangles.push_back(CreateHeapTriangle());
+    }
+
+    void UnloadHeap(Asset& p_asset)
+    {
+        for (auto i : p_asset.triangles)
+            DestroyHeapTriangle(i);
+        p_asset.triangles.clear();
+    }
+
+    void LoadPool(Asset& p_asset, size_t p_count)
+    {
+        for (size_t i = 0; i < p_count; ++i)
+            p_asset.triangles.push_back(new Triangle(VERTICES[0], VERTICES[1], VERTICES[2]));
+    }
+
+    void UnloadPool(Asset& p_asset)
+    {
+        for (auto i : p_asset.triangles)
+            delete i;
+        p_asset.triangles.clear();
+    }
+
+    void LoadArena(Asset& p_asset, size_t p_count)
+    {
+        p_asset.arena = std::make_unique<GeometryArena>();
+        for (size_t i = 0; i < p_count; ++i)
+            p_asset.triangles.push_back(p_asset.arena->CreateTriangle(VERTICES[0], VERTICES[1], VERTICES[2]));
+    }
+
+    void UnloadArena(Asset& p_asset)
+    {
+        p_asset.arena.reset();
+        p_asset.triangles.clear();
+    }
+
+    struct Strategy
+    {
+        const char* name;
+        void(*load)(Asset&, size_t);
+        void(*unload)(Asset&);
+    };
+
+    constexpr Strategy STRATEGIES[] = {
+        {"global heap", LoadHeap, UnloadHeap},
+        {"pool", LoadPool, UnloadPool},
+        {"arena", LoadArena, UnloadArena}};
+}
+
+void Benchmark::BenchGeometryAllocation()
+{
+    for (auto& strategy : STRATEGIES)
+    {
+        Asset asset;
+        asset.triangles.reserve(TRIANGLE_COUNT);
+        // The first round fills the pools, the second one is measured.
+        strategy.load(asset, TRIANGLE_COUNT);
+        strategy.unload(asset);
+        double load_time = Measure([&](){ strategy.load(asset, TRIANGLE_COUNT); });
+        double unload_time = Measure([&](){ strategy.unload(asset); });
+        Report(std::string("Triangle load (1M, ") + strategy.name + ")", TRIANGLE_COUNT / load_time, "triangles/s");
+        Report(std::string("Triangle unload (1M, ") + strategy.name + ")", TRIANGLE_COUNT / unload_time, "triangles/s");
+    }
+
+    // Assets loaded and unloaded by several threads at once.
+    size_t thread_count = std::max(1u, std::thread::hardware_concurrency());
+    for (auto& strategy : STRATEGIES)
+    {
+        double time = Measure([&](){
+            std::vector<std::future<void>> futures;
+            for (size_t t = 0; t < thread_count; ++t)
+            {
+                futures.push_back(std::async(std::launch::async, [&strategy, thread_count](){
+                    Asset asset;
+                    for (size_t round = 0; round < 4; ++round)
+                    {
+                        strategy.load(asset, TRIANGLE_COUNT / thread_count);
+                        strategy.unload(asset);
+                    }
+                }));
+            }
+            for (auto& future : futures)
+                future.get();
+        });
+        Report("Triangle load and unload (4M, " + std::to_string(thread_count) + " threads, " + strategy.name + ")",
+            4 * TRIANGLE_COUNT / time, "triangles/s");
+    }
+
+    auto triangle_stats = PoolAllocator<Triangle>::GetStats();
+    auto vertex_stats = PoolAllocator<Vertex>::GetStats();
+    Report("Triangle pool allocations", (double)triangle_stats.allocation_count, "");
+    Report("Triangle pool live", (double)triangle_stats.live_count, "");
+    Report("Triangle pool reserved", triangle_stats.reserved_bytes / 1048576.0, "MiB");
+    Report("Vertex pool allocations", (double)vertex_stats.allocation_count, "");
+    Report("Vertex pool reserved", vertex_stats.reserved_bytes / 1048576.0, "MiB");
+
+    Asset asset;
+    LoadArena(asset, TRIANGLE_COUNT);
+    Report("Arena blocks (1M triangles)", (double)asset.arena->GetBlockCount(), "");
+    Report("Arena used", asset.arena->GetUsedBytes() / 1048576.0, "MiB");
+}
@@ -0,0 +1,89 @@
+#include "../benchmark.h"
+#include "ce/geometry/bvh.h"
+#include <random>
+#include <thread>
+#include <future>
+
+using namespace CrossEngine;
+
+void Benchmark::BenchBVH()
+{
+    constexpr size_t TRIANGLE_COUNT = 1000000;
+    constexpr size_t QUERY_COUNT = 1000000;
+
+    // Small random triangles scattered in a cube.
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+    std::uniform_real_distribution<float> offset(-1.0f, 1.0f);
+    std::vector<float> positions(TRIANGLE_COUNT * 9);
+    for (size_t i = 0; i < TRIANGLE_COUNT; ++i)
+    {
+        float center[3] = {position(random), position(random), position(random)};
+        for (size_t j = 0; j < 9; ++j)
+            positions[i * 9 + j] = center[j % 3] + offset(random);
+    }
+
+    TriangleBVH bvh;
+    Report("BVH build (1M triangles)", Measure([&](){ bvh.Build(positions.data(), TRIANGLE_COUNT); }) * 1000.0, "ms");
+    Report("BVH node count", (double)bvh.GetNodeCount(), "nodes");
+
+    std::vector<Math::Vec4> origins(QUERY_COUNT), directions(QUERY_COUNT);
+    for (size_t i = 0; i < QUERY_COUNT; ++i)
+    {
+        origins[i] = Math::Pos(position(random), position(random), -150.0f);
+        directions[i] = Math::Vec4(offset(random) * 0.5f, offset(random) * 0.5f, 1.0f, 0.0f);
+    }
+
+    size_t hit_count = 0;
+    double time = Measure([&](){
+        RayHit hit;
+        for (size_t i = 0; i < QUERY_COUNT; ++i)
+            hit_count += bvh.Intersect(origins[i], directions[i], hit);
+    });
+    Report("BVH ray queries (single thread)", QUERY_COUNT / time, "queries/s");
+    Report("BVH ray hit rate", (double)hit_count / QUERY_COUNT, "");
+
+    // Coherent rays from a pinhole camera, as used for picking and visibility.
+    constexpr size_t RESOLUTION = 1000;
+    std::vector<Ray> rays(RESOLUTION * RESOLUTION);
+    for (size_t i = 0; i < RESOLUTION; ++i)
+    {
+        for (size_t j = 0; j < RESOLUTION; ++j)
+        {
+            rays[i * RESOLUTION + j] = {Math::Pos(0.0f, 0.0f, -150.0f),
+                Math::Vec4((float)j / RESOLUTION - 0.5f, (float)i / RESOLUTION - 0.5f, 1.0f, 0.0f)};
+        }
+    }
+    std::vector<RayHit> hits(rays.size());
+    time = Measure([&](){
+        for (size_t i = 0; i < rays.size(); ++i)
+            bvh.Intersect(rays[i].origin, rays[i].direction, hits[i]);
+    });
+    Report("BVH coherent ray queries (single ray)", rays.size() / time, "queries/s");
+    hits.assign(rays.size(), RayHit());
+    time = Measure([&](){ bvh.Intersect(Math::Mat4(), rays.data(), hits.data(), rays.size()); });
+    Report("BVH coherent ray queries (packets of " + std::to_string(RayPacket::SIZE) + ")", rays.size() / time, "queries/s");
+
+    size_t thread_count = std::max(1u, std::thread::hardware_concurrency());
+    time = Measure([&](){
+        std::vector<std::future<void>> futures;
+        for (size_t t = 0; t < thread_count; ++t)
+        {
+            futures.push_back(std::async(std::launch::async, [&, t](){
+                RayHit hit;
+                for (size_t i = t; i < QUERY_COUNT; i += thread_count)
+                    bvh.Intersect(origins[i], directions[i], hit);
+            }));
+        }
+        for (auto& future : futures)
+            future.get();
+    });
+    Report("BVH ray queries (" + std::to_string(thread_count) + " threads)", QUERY_COUNT / time, "queries/s");
+
+    time = Measure([&](){
+        ClosestHit closest;
+        for (size_t i = 0; i < QUERY_COUNT / 10; ++i)
+            bvh.GetClosestPosition(origins[i], closest);
+    });
+    Report("BVH closest position queries", QUERY_COUNT / 10 / time, "queries/s");
+}
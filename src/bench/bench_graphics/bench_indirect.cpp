@@ -0,0 +1,41 @@
+#include "../benchmark.h"
+#include "ce/graphics/renderer/indirect_draw_list.h"
+#include "ce/component/component3D.h"
+#include <random>
+#include <memory>
+
+using namespace CrossEngine;
+
+void Benchmark::BenchIndirectDrawList()
+{
+    constexpr size_t DRAW_COUNT = 10000;
+    constexpr size_t FRAME_COUNT = 100;
+
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+    std::vector<std::unique_ptr<Component3D>> components(DRAW_COUNT);
+    for (auto& i : components)
+    {
+        i = std::make_unique<Component3D>();
+        i->SetGlobalPosition(Math::Pos(position(random), position(random), position(random)));
+    }
+
+    // One instance per draw, the worst case of a scene of distinct meshes.
+    std::vector<std::vector<const Component3D*>> draws(DRAW_COUNT);
+    for (size_t i = 0; i < DRAW_COUNT; ++i)
+        draws[i].push_back(components[i].get());
+
+    IndirectDrawList list;
+    double time = Measure([&](){
+        for (size_t frame = 0; frame < FRAME_COUNT; ++frame)
+        {
+            list.Clear();
+            for (size_t i = 0; i < DRAW_COUNT; ++i)
+                list.AddDraw((uint32_t)(i * 36), 36, draws[i]);
+            list.Build();
+        }
+    });
+    Report("Indirect draw list build (10k draws)", time / FRAME_COUNT * 1000.0, "ms");
+    Report("Indirect draw list upload size", (double)(list.GetCommands().size() * sizeof(IndirectDrawList::Command)
+        + list.GetMatrices().size() * sizeof(float)) / 1024.0, "KB");
+}
@@ -0,0 +1,40 @@
+#include "../benchmark.h"
+#include "ce/graphics/gpu_resource_registry.h"
+#include <vector>
+
+using namespace CrossEngine;
+
+namespace
+{
+    void NoRelease(int, const unsigned int*) {}
+}
+
+void Benchmark::BenchGPUResourceRegistry()
+{
+    constexpr size_t CHURN_COUNT = 1000;
+    constexpr size_t FRAME_COUNT = 100;
+
+    // A frame frees and registers a thousand resources, the frame cost should not depend on the live count.
+    for (size_t live_count : {1000, 100000})
+    {
+        GPUResourceRegistry registry;
+        std::vector<GPUResourceRegistry::Handle> handles;
+        for (size_t i = 0; i < live_count; ++i)
+            handles.push_back(registry.Register((unsigned int)i, NoRelease));
+
+        double time = Measure([&](){
+            for (size_t frame = 0; frame < FRAME_COUNT; ++frame)
+            {
+                for (size_t i = 0; i < CHURN_COUNT; ++i)
+                {
+                    size_t index = (frame * CHURN_COUNT + i) * 7919 % live_count;
+                    registry.Free(handles[index]);
+                    handles[index] = registry.Register((unsigned int)index, NoRelease);
+                }
+                registry.ReleaseFreed();
+            }
+        });
+        Report("GPU resource registry frame (" + std::to_string(live_count) + " live, 1k freed)",
+            time / FRAME_COUNT * 1000.0, "ms");
+    }
+}
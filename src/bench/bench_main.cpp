@@ -0,0 +1,8 @@
+#include "benchmark.h"
+
+int main()
+{
+    Benchmark::Start();
+
+    return 0;
+}
@@ -0,0 +1,116 @@
+#include "../benchmark.h"
+#include "ce/resource/model_parser.h"
+#include "ce/resource/mapped_file.h"
+#include "ce/resource/mesh_cache.h"
+#include "ce/resource/gltf.h"
+#include "ce/geometry/geometry_arena.h"
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdio>
+
+using namespace CrossEngine;
+
+void Benchmark::BenchGltf()
+{
+    // The grid of BenchMeshCache, as an indexed glb and as the equivalent obj.
+    constexpr size_t GRID_SIZE = 500;
+    constexpr size_t VERTEX_COUNT = GRID_SIZE * GRID_SIZE;
+    constexpr size_t INDEX_COUNT = (GRID_SIZE - 1) * (GRID_SIZE - 1) * 6;
+    std::vector<float> positions, normals, uvs;
+    std::vector<uint32_t> indices;
+    std::string text;
+    char line[256];
+    for (size_t y = 0; y < GRID_SIZE; ++y)
+    {
+        for (size_t x = 0; x < GRID_SIZE; ++x)
+        {
+            float height = (float)((x * 7 + y * 3) % 11) * 0.1f;
+            positions.insert(positions.end(), {(float)x, height, (float)y});
+            normals.insert(normals.end(), {0.0f, 1.0f, 0.0f});
+            uvs.insert(uvs.end(), {(float)x / GRID_SIZE, (float)y / GRID_SIZE});
+            text.append(line, std::snprintf(line, sizeof(line), "v %.6f %.6f %.6f\nvt %.6f %.6f\nvn 0.000000 1.000000 0.000000\n",
+                (float)x, height, (float)y, (float)x / GRID_SIZE, (float)y / GRID_SIZE));
+        }
+    }
+    for (size_t y = 0; y + 1 < GRID_SIZE; ++y)
+    {
+        for (size_t x = 0; x + 1 < GRID_SIZE; ++x)
+        {
+            uint32_t a = (uint32_t)(y * GRID_SIZE + x), b = a + 1, c = a + GRID_SIZE, d = c + 1;
+            indices.insert(indices.end(), {a, b, d, a, d, c});
+            text.append(line, std::snprintf(line, sizeof(line), "f %u/%u/%u %u/%u/%u %u/%u/%u\nf %u/%u/%u %u/%u/%u %u/%u/%u\n",
+                a + 1, a + 1, a + 1, b + 1, b + 1, b + 1, d + 1, d + 1, d + 1, a + 1, a + 1, a + 1, d + 1, d + 1, d + 1, c + 1, c + 1, c + 1));
+        }
+    }
+    auto directory = std::filesystem::temp_directory_path();
+    std::string obj_path = (directory / "ce_bench_gltf.obj").string();
+    std::string glb_path = (directory / "ce_bench_gltf.glb").string();
+    {
+        std::ofstream file(obj_path, std::ios::binary);
+        file << text;
+    }
+    text = std::string();
+
+    {
+        size_t position_size = positions.size() * sizeof(float), normal_size = normals.size() * sizeof(float);
+        size_t uv_size = uvs.size() * sizeof(float), index_size = indices.size() * sizeof(uint32_t);
+        size_t binary_size = position_size + normal_size + uv_size + index_size;
+        std::string json = "{\"asset\": {\"version\": \"2.0\"}, \"nodes\": [{\"mesh\": 0}],"
+            "\"meshes\": [{\"primitives\": [{\"attributes\": {\"POSITION\": 0, \"NORMAL\": 1, \"TEXCOORD_0\": 2}, \"indices\": 3}]}],"
+            "\"buffers\": [{\"byteLength\": " + std::to_string(binary_size) + "}],"
+            "\"bufferViews\": ["
+            "{\"buffer\": 0, \"byteOffset\": 0, \"byteLength\": " + std::to_string(position_size) + "},"
+            "{\"buffer\": 0, \"byteOffset\": " + std::to_string(position_size) + ", \"byteLength\": " + std::to_string(normal_size) + "},"
+            "{\"buffer\": 0, \"byteOffset\": " + std::to_string(position_size + normal_size) + ", \"byteLength\": " + std::to_string(uv_size) + "},"
+            "{\"buffer\": 0, \"byteOffset\": " + std::to_string(position_size + normal_size + uv_size) + ", \"byteLength\": " + std::to_string(index_size) + "}],"
+            "\"accessors\": ["
+            "{\"bufferView\": 0, \"componentType\": 5126, \"count\": " + std::to_string(VERTEX_COUNT) + ", \"type\": \"VEC3\"},"
+            "{\"bufferView\": 1, \"componentType\": 5126, \"count\": " + std::to_string(VERTEX_COUNT) + ", \"type\": \"VEC3\"},"
+            "{\"bufferView\": 2, \"componentType\": 5126, \"count\": " + std::to_string(VERTEX_COUNT) + ", \"type\": \"VEC2\"},"
+            "{\"bufferView\": 3, \"componentType\": 5125, \"count\": " + std::to_string(INDEX_COUNT) + ", \"type\": \"SCALAR\"}]}";
+        json.resize((json.size() + 3) / 4 * 4, ' ');
+        uint32_t header[] = {GltfAsset::MAGIC, 2, (uint32_t)(12 + 8 + json.size() + 8 + binary_size),
+            (uint32_t)json.size(), 0x4E4F534A};
+        uint32_t binary_header[] = {(uint32_t)binary_size, 0x004E4942};
+        std::ofstream file(glb_path, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(header), sizeof(header));
+        file << json;
+        file.write(reinterpret_cast<const char*>(binary_header), sizeof(binary_header));
+        file.write(reinterpret_cast<const char*>(positions.data()), position_size);
+        file.write(reinterpret_cast<const char*>(normals.data()), normal_size);
+        file.write(reinterpret_cast<const char*>(uvs.data()), uv_size);
+        file.write(reinterpret_cast<const char*>(indices.data()), index_size);
+    }
+
+    std::vector<float> vertices(INDEX_COUNT / 3 * Triangle::TRIANGLE_ARRAY_SIZE);
+    double time = Measure([&](){
+        GeometryArena arena;
+        std::vector<Triangle*> triangles;
+        MappedFile file(obj_path);
+        ModelParser::ParseObj(file.GetText(), triangles, &arena);
+        for (size_t i = 0; i < triangles.size(); ++i)
+            triangles[i]->GetVertexArray(vertices.data() + i * Triangle::TRIANGLE_ARRAY_SIZE, Triangle::TRIANGLE_ARRAY_SIZE);
+    });
+    Report("Obj to vertex stream (500k triangles)", time * 1000.0, "ms");
+
+    size_t vertex_count = 0;
+    time = Measure([&](){
+        GltfAsset asset(glb_path);
+        auto meshes = asset.DecodeMeshes();
+        vertex_count += meshes[0][0].cache->GetVertexCount();
+    });
+    Report("Glb to vertex stream (500k triangles)", time * 1000.0, "ms");
+
+    time = Measure([&](){
+        auto cache = GltfAsset(glb_path).CreateMeshCache({});
+        vertex_count += cache.GetVertexCount();
+    });
+    Report("Glb to merged mesh cache", time * 1000.0, "ms");
+
+    std::filesystem::remove(obj_path);
+    std::filesystem::remove(glb_path);
+    if (vertex_count == 0)
+        throw std::runtime_error("Unexpected empty stream.");
+}
@@ -0,0 +1,88 @@
+#include "../benchmark.h"
+#include "ce/resource/model_parser.h"
+#include "ce/resource/mapped_file.h"
+#include "ce/resource/mesh_cache.h"
+#include "ce/geometry/geometry_arena.h"
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdio>
+
+using namespace CrossEngine;
+
+void Benchmark::BenchMeshCache()
+{
+    // A grid of 500 by 500 vertices, two triangles per cell.
+    constexpr size_t GRID_SIZE = 500;
+    constexpr size_t TRIANGLE_COUNT = (GRID_SIZE - 1) * (GRID_SIZE - 1) * 2;
+    std::string text;
+    char line[256];
+    for (size_t y = 0; y < GRID_SIZE; ++y)
+    {
+        for (size_t x = 0; x < GRID_SIZE; ++x)
+        {
+            text.append(line, std::snprintf(line, sizeof(line), "v %.6f %.6f %.6f\nvt %.6f %.6f\nvn 0.000000 1.000000 0.000000\n",
+                (float)x, (float)((x * 7 + y * 3) % 11) * 0.1f, (float)y, (float)x / GRID_SIZE, (float)y / GRID_SIZE));
+        }
+    }
+    for (size_t y = 0; y + 1 < GRID_SIZE; ++y)
+    {
+        for (size_t x = 0; x + 1 < GRID_SIZE; ++x)
+        {
+            size_t a = y * GRID_SIZE + x + 1, b = a + 1, c = a + GRID_SIZE, d = c + 1;
+            text.append(line, std::snprintf(line, sizeof(line), "f %zu/%zu/%zu %zu/%zu/%zu %zu/%zu/%zu\nf %zu/%zu/%zu %zu/%zu/%zu %zu/%zu/%zu\n",
+                a, a, a, b, b, b, d, d, d, a, a, a, d, d, d, c, c, c));
+        }
+    }
+    std::string source_path = (std::filesystem::temp_directory_path() / "ce_bench_mesh_cache.obj").string();
+    {
+        std::ofstream file(source_path, std::ios::binary);
+        file << text;
+    }
+    text = std::string();
+
+    // The vertex stream as it is uploaded, flattened from the triangles as before the cache.
+    std::vector<float> vertices(TRIANGLE_COUNT * Triangle::TRIANGLE_ARRAY_SIZE);
+    double time = Measure([&](){
+        GeometryArena arena;
+        std::vector<Triangle*> triangles;
+        MappedFile file(source_path);
+        ModelParser::ParseObj(file.GetText(), triangles, &arena);
+        for (size_t i = 0; i < triangles.size(); ++i)
+            triangles[i]->GetVertexArray(vertices.data() + i * Triangle::TRIANGLE_ARRAY_SIZE, Triangle::TRIANGLE_ARRAY_SIZE);
+    });
+    Report("Obj to vertex stream (500k triangles)", time * 1000.0, "ms");
+
+    time = Measure([&](){
+        GeometryArena arena;
+        std::vector<Triangle*> triangles;
+        MappedFile file(source_path);
+        ModelParser::ParseObj(file.GetText(), triangles, &arena);
+        MeshCache::Create({triangles}, MeshCache::IdentifySource(source_path)).Save(MeshCache::GetCachePath(source_path));
+    });
+    Report("Convert to mesh cache", time * 1000.0, "ms");
+
+    // Reading every page of the stream stands in for the upload.
+    float sum = 0.0f;
+    time = Measure([&](){
+        auto cache = MeshCache::Open(source_path);
+        const float* stream = cache->GetVertices();
+        for (size_t i = 0; i < cache->GetVertexCount() * Vertex::ARRAY_SIZE; i += 1024)
+            sum += stream[i];
+    });
+    Report("Mesh cache to vertex stream", time * 1000.0, "ms");
+
+    time = Measure([&](){
+        GeometryArena arena;
+        std::vector<Triangle*> triangles;
+        MeshCache::Open(source_path)->CreateTriangles(triangles, &arena);
+        sum += triangles.size();
+    });
+    Report("Mesh cache to triangles", time * 1000.0, "ms");
+
+    std::filesystem::remove(MeshCache::GetCachePath(source_path));
+    std::filesystem::remove(source_path);
+    if (sum == 0.0f)
+        throw std::runtime_error("Unexpected empty stream.");
+}
@@ -0,0 +1,225 @@
+#include "../benchmark.h"
+#include "ce/resource/model_parser.h"
+#include "ce/resource/mapped_file.h"
+#include "ce/geometry/polygon.h"
+#include "ce/geometry/geometry_arena.h"
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstdio>
+
+using namespace CrossEngine;
+
+namespace
+{
+    // The obj loader before the model parser, reading the file into a buffer, copying every line and every
+    // word before parsing them with atof and atoi.
+    namespace Legacy
+    {
+        bool IsAlpha(byte_t p_char)
+        {
+            return (p_char >= 'a' && p_char <= 'z') || (p_char >= 'A' && p_char <= 'Z');
+        }
+
+        bool IsDigit(byte_t p_char)
+        {
+            return (p_char >= '0' && p_char <= '9') || p_char == '.' || p_char == '-';
+        }
+
+        byte_t* GetWord(byte_t* p_start, byte_t* buff, size_t buff_size)
+        {
+            for (size_t i = 0; i < buff_size; ++i)
+            {
+                if (!(IsAlpha(p_start[i]) || IsDigit(p_start[i]) || p_start[i] == '_'))
+                {
+                    buff[i] = '\0';
+                    return buff;
+                }
+                buff[i] = p_start[i];
+            }
+            buff[buff_size - 1] = '\0';
+            return buff;
+        }
+
+        byte_t* GetLine(byte_t* p_start, byte_t* buff, size_t buff_size)
+        {
+            for (size_t i = 0; i < buff_size; ++i)
+            {
+                if (p_start[i] == '\n' || p_start[i] == '\0')
+                {
+                    buff[i] = '\0';
+                    return buff;
+                }
+                buff[i] = p_start[i];
+            }
+            buff[buff_size - 1] = '\0';
+            return buff;
+        }
+
+        void MovePToNextSpace(byte_t** p)
+        {
+            while (**p != '\n' && **p != ' ' && **p != '\t' && **p != '\0')
+                ++(*p);
+        }
+
+        void MovePToNextWord(byte_t** p)
+        {
+            while (IsAlpha(**p) || IsDigit(**p) || **p == '_')
+                ++(*p);
+        }
+
+        void MovePToNextLine(byte_t** p)
+        {
+            while (**p != '\n' && **p != '\0')
+                ++(*p);
+        }
+
+        void LoadObjModel(const std::string& p_path, std::vector<Triangle*>& p_result, GeometryArena* p_arena)
+        {
+            std::ifstream file(p_path.c_str(), std::ios::binary);
+            file.seekg(0, std::ios::end);
+            size_t file_size = file.tellg();
+            file.seekg(0, std::ios::beg);
+            auto data = std::unique_ptr<byte_t[]>(new byte_t[file_size + 10]);
+            file.read(data.get(), file_size);
+            data[file_size] = '\0';
+            byte_t* p = data.get();
+
+            std::vector<Math::Vec4> positions;
+            std::vector<Math::Vec4> normals;
+            std::vector<Math::Vec2> tex_coords;
+            byte_t line_buff[1024];
+            byte_t word_buff[256];
+            while (p < data.get() + file_size)
+            {
+                GetLine(p, line_buff, 1024);
+                auto* pp = line_buff;
+                if ((pp[0] == 'v' && pp[1] == ' ') || (pp[0] == 'v' && pp[1] == 'n'))
+                {
+                    bool is_position = pp[1] == ' ';
+                    pp += is_position ? 2 : 3;
+                    Math::Vec4 value = is_position ? Math::Pos() : Math::Vec4();
+                    for (size_t i = 0; i < 3; ++i)
+                    {
+                        GetWord(pp, word_buff, 256);
+                        value[i] = std::atof(word_buff);
+                        MovePToNextSpace(&pp);
+                        ++pp;
+                    }
+                    (is_position ? positions : normals).push_back(value);
+                }
+                else if (pp[0] == 'v' && pp[1] == 't')
+                {
+                    pp += 3;
+                    Math::Vec2 tex_coord;
+                    for (size_t i = 0; i < 2; ++i)
+                    {
+                        GetWord(pp, word_buff, 256);
+                        tex_coord[i] = std::atof(word_buff);
+                        MovePToNextSpace(&pp);
+                        ++pp;
+                    }
+                    tex_coords.push_back(tex_coord);
+                }
+                else if (pp[0] == 'f' && pp[1] == ' ')
+                {
+                    ++pp;
+                    PolygonN poly;
+                    while (*pp != '\0')
+                    {
+                        ++pp;
+                        Vertex* vert = new Vertex;
+                        int position_index = std::atoi(GetWord(pp, word_buff, 256)) - 1;
+                        if (position_index < 0 || (size_t)position_index >= positions.size())
+                            throw std::runtime_error("Invalid obj file.");
+                        vert->Position() = positions[(size_t)position_index];
+                        MovePToNextWord(&pp);
+                        ++pp;
+                        vert->UV() = tex_coords[std::atoi(GetWord(pp, word_buff, 256)) - 1];
+                        MovePToNextWord(&pp);
+                        ++pp;
+                        int normal_index = std::atoi(GetWord(pp, word_buff, 256)) - 1;
+                        if (normal_index < 0 || (size_t)normal_index >= normals.size())
+                            throw std::runtime_error("Invalid obj file.");
+                        vert->Normal() = normals[(size_t)normal_index];
+                        MovePToNextWord(&pp);
+                        poly.AddVertex(poly.GetVertexCount(), vert);
+                    }
+                    std::vector<Triangle*> temp_triangles;
+                    poly.Triangulate(temp_triangles, p_arena);
+                    for (size_t i = 0; i < temp_triangles.size(); ++i)
+                        p_result.push_back(temp_triangles[i]);
+                }
+                MovePToNextLine(&p);
+                ++p;
+            }
+        }
+    }
+
+    // A grid of vertices with two triangles per cell, as exported by a modelling tool.
+    std::string CreateObjText(size_t p_grid_size)
+    {
+        std::mt19937 random(0);
+        std::uniform_real_distribution<float> height(-1.0f, 1.0f);
+        std::string text;
+        char line[128];
+        for (size_t y = 0; y < p_grid_size; ++y)
+        {
+            for (size_t x = 0; x < p_grid_size; ++x)
+            {
+                text.append(line, std::snprintf(line, sizeof(line), "v %.6f %.6f %.6f\n", (float)x, height(random), (float)y));
+                text.append(line, std::snprintf(line, sizeof(line), "vt %.6f %.6f\n", (float)x / p_grid_size, (float)y / p_grid_size));
+                text.append(line, std::snprintf(line, sizeof(line), "vn %.6f %.6f %.6f\n", height(random), 1.0f, height(random)));
+            }
+        }
+        for (size_t y = 0; y + 1 < p_grid_size; ++y)
+        {
+            for (size_t x = 0; x + 1 < p_grid_size; ++x)
+            {
+                size_t a = y * p_grid_size + x + 1, b = a + 1, c = a + p_grid_size, d = c + 1;
+                text.append(line, std::snprintf(line, sizeof(line), "f %zu/%zu/%zu %zu/%zu/%zu %zu/%zu/%zu\n", a, a, a, b, b, b, d, d, d));
+                text.append(line, std::snprintf(line, sizeof(line), "f %zu/%zu/%zu %zu/%zu/%zu %zu/%zu/%zu\n", a, a, a, d, d, d, c, c, c));
+            }
+        }
+        return text;
+    }
+}
+
+void Benchmark::BenchModelParser()
+{
+    constexpr size_t GRID_SIZE = 1000;
+    std::string text = CreateObjText(GRID_SIZE);
+    auto path = std::filesystem::temp_directory_path() / "ce_bench_model_parser.obj";
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << text;
+    }
+    double size_mb = text.size() / (1024.0 * 1024.0);
+    Report("Obj file size", size_mb, "MB");
+    text = std::string();
+
+    auto bench = [&](const std::string& p_name, const std::function<void(std::vector<Triangle*>&, GeometryArena&)>& p_load) {
+        std::vector<Triangle*> triangles;
+        auto arena = std::make_unique<GeometryArena>();
+        double time = Measure([&](){ p_load(triangles, *arena); });
+        if (triangles.size() != (GRID_SIZE - 1) * (GRID_SIZE - 1) * 2)
+            throw std::runtime_error("Unexpected triangle count.");
+        Report(p_name, size_mb / time, "MB/s");
+    };
+    bench("Obj load (line buffers, atof)", [&](std::vector<Triangle*>& p_triangles, GeometryArena& p_arena) {
+        Legacy::LoadObjModel(path.string(), p_triangles, &p_arena);
+    });
+    bench("Obj load (mapped, from_chars)", [&](std::vector<Triangle*>& p_triangles, GeometryArena& p_arena) {
+        MappedFile file(path.string());
+        ModelParser::ParseObj(file.GetText(), p_triangles, &p_arena);
+    });
+    {
+        MappedFile file(path.string());
+        bench("Obj parse (from_chars, no file)", [&](std::vector<Triangle*>& p_triangles, GeometryArena& p_arena) {
+            ModelParser::ParseObj(file.GetText(), p_triangles, &p_arena);
+        });
+    }
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,79 @@
+#include "../benchmark.h"
+#include "ce/utils/task.h"
+#include "ce/utils/frame_allocator.h"
+#include <vector>
+#include <string>
+
+using namespace CrossEngine;
+
+void Benchmark::BenchFrameAllocator()
+{
+    constexpr size_t TASK_COUNT = 10000;
+    constexpr size_t FRAME_COUNT = 100;
+
+    // A frame of render tasks capturing three pointers, as the instanced draws of the renderer do.
+    std::vector<Task> tasks;
+    tasks.reserve(TASK_COUNT);
+    size_t a = 0, b = 0, c = 0;
+    double time = Measure([&](){
+        for (size_t frame = 0; frame < FRAME_COUNT; ++frame)
+        {
+            for (size_t i = 0; i < TASK_COUNT; ++i)
+                tasks.push_back(Task(std::function<void()>([&a, &b, &c](){ a += b + c; }), 0));
+            for (auto& task : tasks)
+                task.task();
+            tasks.clear();
+        }
+    });
+    Report("Render tasks (10k, std::function)", time / FRAME_COUNT * 1000.0, "ms/frame");
+
+    auto& frame_allocator = FrameAllocator::GetThreadInstance();
+    time = Measure([&](){
+        for (size_t frame = 0; frame < FRAME_COUNT; ++frame)
+        {
+            for (size_t i = 0; i < TASK_COUNT; ++i)
+                tasks.push_back(Task([&a, &b, &c](){ a += b + c; }, 0));
+            for (auto& task : tasks)
+                task.task();
+            tasks.clear();
+            frame_allocator.Reset();
+        }
+    });
+    Report("Render tasks (10k, frame allocator)", time / FRAME_COUNT * 1000.0, "ms/frame");
+
+    // The uniform names of a frame of lights.
+    constexpr size_t LIGHT_COUNT = 1000;
+    size_t length_sum = 0;
+    time = Measure([&](){
+        for (size_t frame = 0; frame < FRAME_COUNT; ++frame)
+        {
+            for (size_t i = 0; i < LIGHT_COUNT; ++i)
+            {
+                std::string name = std::string("point_light") + "[" + std::to_string(i) + "]";
+                length_sum += (name + ".position").size() + (name + ".color").size() + (name + ".intensity").size();
+            }
+        }
+    });
+    Report("Light uniform names (1k, std::string)", time / FRAME_COUNT * 1000.0, "ms/frame");
+    time = Measure([&](){
+        for (size_t frame = 0; frame < FRAME_COUNT; ++frame)
+        {
+            for (size_t i = 0; i < LIGHT_COUNT; ++i)
+            {
+                std::pmr::string name(&frame_allocator);
+                name.append("point_light").append("[").append(std::to_string(i)).append("]");
+                size_t length = name.size();
+                length_sum += name.append(".position").size();
+                name.resize(length);
+                length_sum += name.append(".color").size();
+                name.resize(length);
+                length_sum += name.append(".intensity").size();
+            }
+            frame_allocator.Reset();
+        }
+    });
+    Report("Light uniform names (1k, frame allocator)", time / FRAME_COUNT * 1000.0, "ms/frame");
+    Report("Frame allocator peak", frame_allocator.GetPeakBytes() / 1024.0, "KiB");
+    Report("Frame allocator blocks requested", (double)frame_allocator.GetUpstreamAllocationCount(), "");
+    Report("Checksum", (double)(a + length_sum), "");
+}
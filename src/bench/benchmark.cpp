@@ -0,0 +1,31 @@
+#include "benchmark.h"
+
+double Benchmark::Measure(const std::function<void()>& p_func)
+{
+    auto start = std::chrono::steady_clock::now();
+    p_func();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void Benchmark::Report(const std::string& p_name, double p_value, const std::string& p_unit)
+{
+    std::cout << p_name << ": " << p_value << " " << p_unit << '\n';
+}
+
+void Benchmark::Start()
+{
+    std::cout << "Running benchmarks..." << '\n';
+
+    RUN_BENCHMARK(BenchBVH);
+    RUN_BENCHMARK(BenchGeometryAllocation);
+    RUN_BENCHMARK(BenchIndirectDrawList);
+    RUN_BENCHMARK(BenchGPUResourceRegistry);
+    RUN_BENCHMARK(BenchComponentTree);
+    RUN_BENCHMARK(BenchComponentLookup);
+    RUN_BENCHMARK(BenchFrameAllocator);
+    RUN_BENCHMARK(BenchModelParser);
+    RUN_BENCHMARK(BenchMeshCache);
+    RUN_BENCHMARK(BenchGltf);
+
+    std::cout << "Benchmarks finished.\n";
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include "ce/defs.hpp"
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <string>
+
+#define RUN_BENCHMARK(p_func, ...) \
+    try {\
+        p_func(__VA_ARGS__);\
+    }\
+    catch(std::exception& e) {\
+        std::cerr << "Benchmark throwed an exception at file: " << __FILE__ << ":" << __LINE__ << ".\n" << e.what() << '\n';\
+    }(void(0))
+
+/**
+ * @brief Benchmark class.
+ * This class is used for measuring the performance of engine modules
+ * that do not require a window.
+ */
+class Benchmark
+{
+public:
+
+    /**
+     * @brief Start the benchmarks.
+     */
+    static void Start();
+
+private:
+
+    /**
+     * @brief Measure the time to run a function.
+     * 
+     * @param p_func The function to measure.
+     * @return double The time in seconds.
+     */
+    static double Measure(const std::function<void()>& p_func);
+
+    /**
+     * @brief Report a measured value.
+     * 
+     * @param p_name The name of the value.
+     * @param p_value The value.
+     * @param p_unit The unit of the value.
+     */
+    static void Report(const std::string& p_name, double p_value, const std::string& p_unit);
+
+    /** Geometry Benchmark Start **/
+    static void BenchBVH();
+    static void BenchGeometryAllocation();
+    /** Geometry Benchmark End **/
+
+    /** Graphics Benchmark Start **/
+    static void BenchIndirectDrawList();
+    static void BenchGPUResourceRegistry();
+    /** Graphics Benchmark End **/
+
+    /** Component Benchmark Start **/
+    static void BenchComponentTree();
+    static void BenchComponentLookup();
+    /** Component Benchmark End **/
+
+    /** Utils Benchmark Start **/
+    static void BenchFrameAllocator();
+    /** Utils Benchmark End **/
+
+    /** Resource Benchmark Start **/
+    static void BenchModelParser();
+    static void BenchMeshCache();
+    static void BenchGltf();
+    /** Resource Benchmark End **/
+};
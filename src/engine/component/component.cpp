@@ -4,34 +4,59 @@
 
 namespace CrossEngine
 {
+    ComponentLink ComponentLink::Make(Component* p_component)
+    {
+        ComponentLink link;
+        if (p_component == nullptr)
+            return link;
+        link.handle = p_component->GetHandle();
+        link.owner = p_component->weak_from_this();
+        // Pooled components are not owned by a shared pointer.
+        link.is_shared = !link.owner.expired();
+        return link;
+    }
+
     Component::Component(const std::string& p_component_name)
-        : component_name(p_component_name)
+        : component_name(p_component_name), name_id(StringId::Intern(p_component_name)), handle(ComponentRegistry::Register(this))
     {
         
     }
 
     Component::Component(const Component& p_other)
+        : std::enable_shared_from_this<Component>(), handle(ComponentRegistry::Register(this))
     {
         SetSubspaceMatrixDirty();
         component_name = p_other.component_name;
-        if (!p_other.parent.expired())
-            p_other.parent.lock()->AddChild(shared_from_this());
+        name_id = p_other.name_id;
+        if (auto other_parent = p_other.parent.Lock())
+            other_parent->AddChild(shared_from_this());
         
     }
 
     Component::Component(Component&& p_other) noexcept
+        : std::enable_shared_from_this<Component>(), handle(ComponentRegistry::Register(this))
     {
         SetSubspaceMatrixDirty();
         component_name = p_other.component_name;
-        if (!p_other.parent.expired())
-            p_other.parent.lock()->AddChild(shared_from_this());
-        p_other.parent.reset();
+        name_id = p_other.name_id;
+        if (auto other_parent = p_other.parent.Lock())
+            other_parent->AddChild(shared_from_this());
+        p_other.parent = ComponentLink();
         children = std::move(p_other.children);
+        children_index = std::move(p_other.children_index);
     }
 
     Component::~Component()
     {
+        ComponentRegistry::Unregister(handle);
+    }
 
+    void Component::Retire()
+    {
+        if (auto current_parent = parent.Lock())
+            current_parent->RemoveChild(this);
+        ComponentRegistry::Unregister(handle);
+        handle = ComponentHandle();
     }
 
     void Component::Update(float p_delta)
@@ -42,9 +67,8 @@ namespace CrossEngine
             std::shared_lock lock(children_mutex);
             for (auto& child : children)
             {
-                if (child.expired())
-                    continue;
-                child.lock()->Update(p_delta);
+                if (auto shared = child.Lock())
+                    shared->Update(p_delta);
             }
         }
     }
@@ -56,53 +80,194 @@ namespace CrossEngine
             
             for (auto it = children.begin(); it != children.end(); ++it)
             {
-                if ((*it).lock().get() == p_child)
+                if (it->handle == p_child->handle)
                 {
                     children.erase(it);
                     break;
                 }
             }
+            auto indexed = children_index.find(p_child->name_id);
+            if (indexed != children_index.end() && indexed->second.handle == p_child->handle)
+            {
+                // Another child of the same name becomes the first one.
+                children_index.erase(indexed);
+                for (auto& i : children)
+                {
+                    auto shared = i.Lock();
+                    if (shared != nullptr && shared->name_id == p_child->name_id)
+                    {
+                        children_index.emplace(p_child->name_id, i);
+                        break;
+                    }
+                }
+            }
         }
-        p_child->parent.reset();
+        p_child->parent = ComponentLink();
+        IncrementStructureVersion();
     }
 
     void Component::AddChild(WPComponent p_child)
+    {
+        AddChild(p_child.lock().get());
+    }
+
+    void Component::AddChild(Component* p_child)
     {
         {
             std::shared_lock lock(children_mutex);
             for (auto& i : children)
             {
-                if (i.lock().get() == p_child.lock().get())
+                if (i.handle == p_child->handle)
                     return;
             }
         }
         {
             std::unique_lock lock(children_mutex);
-            children.push_back(p_child);
+            auto link = ComponentLink::Make(p_child);
+            children.push_back(link);
+            children_index.try_emplace(p_child->name_id, link);
         }
-        auto child = p_child.lock();
-        if (!child->parent.expired())
-            child->parent.lock()->RemoveChild(child.get());
-        child->SetSubspaceMatrixDirty();
-        child->parent = shared_from_this();
+        if (auto child_parent = p_child->parent.Lock())
+            child_parent->RemoveChild(p_child);
+        p_child->SetSubspaceMatrixDirty();
+        p_child->parent = ComponentLink::Make(this);
+        IncrementStructureVersion();
         if (activated)
         {
-            p_child.lock()->Activate();
+            p_child->Activate();
         }
     }
 
     std::shared_ptr<Component> Component::GetChild(const std::string& p_child_name)
     {
+        // A name that is not interned is not the name of any component.
+        return GetChild(StringId::Find(p_child_name));
+    }
+
+    std::shared_ptr<Component> Component::GetChild(StringId p_child_name)
+    {
+        if (!p_child_name.IsValid())
+            return nullptr;
         std::shared_lock lock(children_mutex);
+        auto indexed = children_index.find(p_child_name);
+        if (indexed == children_index.end())
+            return nullptr;
+        if (auto shared = indexed->second.Lock())
+            return shared;
+        // The first child of the name is destroyed without being removed, find the next one.
         for (auto& i : children)
         {
-            auto shared = i.lock();
-            if (shared->GetName() == p_child_name)
+            auto shared = i.Lock();
+            if (shared != nullptr && shared->name_id == p_child_name)
                 return shared;
         }
         return nullptr;
     }
 
+    std::shared_ptr<Component> Component::FindPath(std::string_view p_path)
+    {
+        uint64_t version = structure_version.load(std::memory_order_acquire);
+        {
+            std::lock_guard<std::mutex> lock(path_cache_mutex);
+            auto cached = path_cache.find(p_path);
+            if (path_cache_version == version && cached != path_cache.end())
+            {
+                if (auto shared = cached->second.Lock())
+                    return shared;
+            }
+        }
+
+        auto current = ComponentLink::Make(this).Lock();
+        size_t begin = 0;
+        while (current != nullptr && begin <= p_path.size())
+        {
+            size_t end = p_path.find('/', begin);
+            if (end == std::string_view::npos)
+                end = p_path.size();
+            if (end > begin)
+                current = current->GetChild(StringId::Find(p_path.substr(begin, end - begin)));
+            begin = end + 1;
+        }
+        if (current == nullptr)
+            return nullptr;
+
+        std::lock_guard<std::mutex> lock(path_cache_mutex);
+        // The subtree changed while resolving, the result may already be stale.
+        if (structure_version.load(std::memory_order_acquire) == version)
+        {
+            // The paths of older versions are never read again.
+            if (path_cache_version != version)
+            {
+                path_cache.clear();
+                path_cache_version = version;
+            }
+            path_cache.insert_or_assign(std::string(p_path), ComponentLink::Make(current.get()));
+        }
+        return current;
+    }
+
+    void Component::SetName(const std::string& p_component_name)
+    {
+        component_name = p_component_name;
+        name_id = StringId::Intern(p_component_name);
+        if (auto current_parent = parent.Lock())
+        {
+            current_parent->IndexChildren();
+            current_parent->IncrementStructureVersion();
+        }
+    }
+
+    void Component::IndexChildren()
+    {
+        std::unique_lock lock(children_mutex);
+        children_index.clear();
+        for (auto& i : children)
+        {
+            if (auto shared = i.Lock())
+                children_index.try_emplace(shared->name_id, i);
+        }
+    }
+
+    void Component::IncrementStructureVersion()
+    {
+        structure_version.fetch_add(1, std::memory_order_release);
+        for (auto ancestor = GetParent(); ancestor != nullptr; ancestor = ancestor->GetParent())
+            ancestor->structure_version.fetch_add(1, std::memory_order_release);
+    }
+
+    void Component::IncrementContentVersion() const
+    {
+        content_version.fetch_add(1, std::memory_order_release);
+        for (auto ancestor = GetParent(); ancestor != nullptr; ancestor = ancestor->GetParent())
+            ancestor->content_version.fetch_add(1, std::memory_order_release);
+    }
+
+    void Component::SetVisible(bool p_visible)
+    {
+        if (visible == p_visible)
+            return;
+        visible = p_visible;
+        IncrementContentVersion();
+    }
+
+    std::vector<std::shared_ptr<Component>> Component::GetChildren() const
+    {
+        std::vector<std::shared_ptr<Component>> result;
+        ForEachChild([&result](const std::shared_ptr<Component>& p_child) { result.push_back(p_child); });
+        return result;
+    }
+
+    void Component::ForEachChild(const std::function<void(const std::shared_ptr<Component>&)>& p_func) const
+    {
+        std::shared_lock lock(children_mutex);
+        for (auto& i : children)
+        {
+            auto shared = i.Lock();
+            if (shared != nullptr)
+                p_func(shared);
+        }
+    }
+
     const Math::Mat4& Component::GetSubspaceMatrix() const
     {
         return identity;
@@ -124,7 +289,8 @@ namespace CrossEngine
         std::shared_lock lock(children_mutex);
         for (auto& child : children)
         {
-            child.lock()->SetSubspaceMatrixDirty();
+            if (auto shared = child.Lock())
+                shared->SetSubspaceMatrixDirty();
         }
     }
 
@@ -151,7 +317,8 @@ namespace CrossEngine
         std::shared_lock lock(children_mutex);
         for (auto& child : children)
         {
-            child.lock()->SetSubspaceMatrixDirty();
+            if (auto shared = child.Lock())
+                shared->SetSubspaceMatrixDirty();
         }
     }
 
@@ -194,10 +361,9 @@ namespace CrossEngine
         std::shared_lock lock(children_mutex);
         for (auto& child : children)
         {
-            if (child.expired())
-                continue;
-            child.lock()->RegisterDraw(p_context);
+            if (auto shared = child.Lock())
+                shared->RegisterDraw(p_context);
         }
         return true;
     }
-}
\ No newline at end of file
+}
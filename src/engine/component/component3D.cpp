@@ -26,19 +26,23 @@ namespace CrossEngine
 
     void Component3D::UpdateSubspaceMatrix() const
     {
-        if (GetParent().expired())
+        auto parent = GetParent();
+        if (parent == nullptr)
             subspace_matrix = Math::Model(position, rotation, scale);
         else
-            subspace_matrix = GetParent().lock()->GetSubspaceMatrix() * Math::Model(position, rotation, scale);
+            subspace_matrix = parent->GetSubspaceMatrix() * Math::Model(position, rotation, scale);
         subspace_matrix_dirty = false;
+        // After the matrix is written, so a reader of the version never gets the old matrix with the new version.
+        IncrementContentVersion();
     }
 
     void Component3D::UpdateSubspaceMatrixInverse() const
     {
-        if (GetParent().expired())
+        auto parent = GetParent();
+        if (parent == nullptr)
             subspace_matrix_inverse = Math::ModelInv(position, rotation, scale);
         else
-            subspace_matrix_inverse = Math::ModelInv(position, rotation, scale) * GetParent().lock()->GetSubspaceMatrixInverse();
+            subspace_matrix_inverse = Math::ModelInv(position, rotation, scale) * parent->GetSubspaceMatrixInverse();
         subspace_matrix_inverse_dirty = false;
     }
 
@@ -71,6 +75,13 @@ namespace CrossEngine
         return position;
     }
 
+    void Component3D::SetPosition(const Math::Vec4& p_position)
+    {
+        position = p_position;
+        SetSubspaceMatrixDirty();
+        IncrementContentVersion();
+    }
+
     Math::Vec4& Component3D::Rotation()
     {
         rotation.Normalize();
@@ -78,14 +89,22 @@ namespace CrossEngine
         return rotation;
     }
 
+    void Component3D::SetRotation(const Math::Vec4& p_rotation)
+    {
+        rotation = p_rotation;
+        rotation.Normalize();
+        SetSubspaceMatrixDirty();
+        IncrementContentVersion();
+    }
+
     void Component3D::SetRotationEuler(const Math::Vec4& p_rotation, EulerRotOrder p_order)
     {
-        Rotation() = EulerToQuat(p_rotation, p_order);
+        SetRotation(EulerToQuat(p_rotation, p_order));
     }
 
     void Component3D::SetRotationEuler(const Math::Vec3& p_rotation, EulerRotOrder p_order)
     {
-        Rotation() = EulerToQuat(p_rotation, p_order);
+        SetRotation(EulerToQuat(p_rotation, p_order));
     }
 
     Math::Vec4 Component3D::GetRotationEuler() const
@@ -105,7 +124,7 @@ namespace CrossEngine
         quat[0] = p_axis[0] * sin_half_angle;
         quat[1] = p_axis[1] * sin_half_angle;
         quat[2] = p_axis[2] * sin_half_angle;
-        Rotation() = QuatProd(quat, rotation);
+        SetRotation(QuatProd(quat, rotation));
     }
 
     void Component3D::SetRotate(Math::Vec4 p_axis, float p_angle)
@@ -118,13 +137,13 @@ namespace CrossEngine
         quat[0] = p_axis[0] * sin_half_angle;
         quat[1] = p_axis[1] * sin_half_angle;
         quat[2] = p_axis[2] * sin_half_angle;
-        Rotation() = quat;
+        SetRotation(quat);
     }
 
     void Component3D::Scale(Math::Vec4 p_direction, float p_scale)
     {
         p_direction.Normalize();
-        Scale() *= p_direction * p_scale;
+        SetScale(scale * (p_direction * p_scale));
     }
 
     Math::Vec4& Component3D::Scale()
@@ -133,6 +152,13 @@ namespace CrossEngine
         return scale;
     }
 
+    void Component3D::SetScale(const Math::Vec4& p_scale)
+    {
+        scale = p_scale;
+        SetSubspaceMatrixDirty();
+        IncrementContentVersion();
+    }
+
     Math::Vec4 Component3D::GetGlobalPosition() const
     {
         return GetSubspaceMatrix() * Math::Vec4(0.0f, 0.0f, 0.0f, 1.0f);
@@ -150,15 +176,16 @@ namespace CrossEngine
 
     void Component3D::SetGlobalPosition(const Math::Vec4& p_position)
     {
-        if (GetParent().expired())
-            Position() = p_position;
+        auto parent = GetParent();
+        if (parent == nullptr)
+            SetPosition(p_position);
         else
-            Position() = GetParent().lock()->GetSubspaceMatrixInverse() * p_position;
+            SetPosition(parent->GetSubspaceMatrixInverse() * p_position);
     }
 
     void Component3D::Move(const Math::Vec4& p_direction, float p_distance)
     {
-        Position() += p_direction.Normalized() * p_distance;
+        SetPosition(position + p_direction.Normalized() * p_distance);
     }
     
     const Math::Mat4& Component3D::GetSubspaceMatrix() const
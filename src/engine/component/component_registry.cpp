@@ -0,0 +1,79 @@
+#include "ce/component/component_registry.h"
+#include <stdexcept>
+
+namespace CrossEngine
+{
+    ComponentHandle ComponentRegistry::Register(Component* p_component)
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        uint32_t index;
+        if (free_head != UINT32_MAX)
+        {
+            index = free_head;
+            free_head = chunks[index / CHUNK_SIZE].load(std::memory_order_relaxed)[index % CHUNK_SIZE].next_free;
+        }
+        else
+        {
+            if (slot_count == CHUNK_SIZE * MAX_CHUNK_COUNT)
+                throw std::runtime_error("Too many components.");
+            index = slot_count++;
+            if (index % CHUNK_SIZE == 0)
+            {
+                chunk_storage[index / CHUNK_SIZE] = std::make_unique<Slot[]>(CHUNK_SIZE);
+                chunks[index / CHUNK_SIZE].store(chunk_storage[index / CHUNK_SIZE].get(), std::memory_order_release);
+            }
+        }
+        Slot& slot = chunks[index / CHUNK_SIZE].load(std::memory_order_relaxed)[index % CHUNK_SIZE];
+        slot.component.store(p_component, std::memory_order_release);
+        ++component_count;
+        return ComponentHandle{index, slot.generation.load(std::memory_order_relaxed)};
+    }
+
+    void ComponentRegistry::Unregister(const ComponentHandle& p_handle)
+    {
+        if (!p_handle.IsValid())
+            return;
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        if (p_handle.index >= slot_count)
+            return;
+        Slot& slot = chunks[p_handle.index / CHUNK_SIZE].load(std::memory_order_relaxed)[p_handle.index % CHUNK_SIZE];
+        if (slot.generation.load(std::memory_order_relaxed) != p_handle.generation)
+            return;
+        // Invalidate the handles before the slot is cleared.
+        slot.generation.store(p_handle.generation + 1, std::memory_order_release);
+        slot.component.store(nullptr, std::memory_order_release);
+        slot.next_free = free_head;
+        free_head = p_handle.index;
+        --component_count;
+    }
+
+    void ComponentRegistry::EndFrame(const void* p_thread)
+    {
+        std::lock_guard<std::mutex> lock(epoch_mutex);
+        threads.insert(p_thread);
+        finished_threads.insert(p_thread);
+        if (finished_threads.size() >= threads.size())
+        {
+            finished_threads.clear();
+            epoch.fetch_add(1, std::memory_order_acq_rel);
+        }
+    }
+
+    void ComponentRegistry::RemoveThread(const void* p_thread)
+    {
+        std::lock_guard<std::mutex> lock(epoch_mutex);
+        threads.erase(p_thread);
+        finished_threads.erase(p_thread);
+        if (!threads.empty() && finished_threads.size() >= threads.size())
+        {
+            finished_threads.clear();
+            epoch.fetch_add(1, std::memory_order_acq_rel);
+        }
+    }
+
+    size_t ComponentRegistry::GetComponentCount()
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        return component_count;
+    }
+}
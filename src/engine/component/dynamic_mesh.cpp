@@ -1,19 +1,115 @@
 #include "ce/component/dynamic_mesh.h"
 #include "ce/resource/resource.h"
+#include "ce/resource/resource_loader.h"
 #include "ce/graphics/graphics.h"
 #include "glad/glad.h"
 #include "ce/graphics/window.h"
 #include "ce/component/camera.h"
 #include "ce/graphics/renderer/renderer.h"
+#include "ce/game/game.h"
+#include "ce/utils/radix_sort.h"
+#include "ce/utils/frame_allocator.h"
 
 #include <algorithm>
+#include <numeric>
+#include <limits>
+#ifdef CE_SIMD_SSE2
+    #include <emmintrin.h>
+#endif
 
 namespace CrossEngine
 {
-    void DynamicMesh::SetTrianglesDirty(bool p_dirty)
+    namespace
     {
-        std::lock_guard<std::mutex> lock(triangles_mutex);
-        triangles_dirty = p_dirty;
+        // Compute the back to front sort key of every triangle center. A smaller key is further away.
+        void ComputeDepthKeys(const float* p_centers, size_t p_count, const Math::Mat4& p_subspace_matrix,
+            const Math::Vec4& p_camera_position, uint32_t* p_keys)
+        {
+            const float* xs = p_centers;
+            const float* ys = p_centers + p_count;
+            const float* zs = p_centers + p_count * 2;
+            float m[12];
+            for (size_t i = 0; i < 3; ++i)
+            {
+                m[i * 4] = p_subspace_matrix(i * 4);
+                m[i * 4 + 1] = p_subspace_matrix(i * 4 + 1);
+                m[i * 4 + 2] = p_subspace_matrix(i * 4 + 2);
+                m[i * 4 + 3] = p_subspace_matrix(i * 4 + 3) - p_camera_position[i];
+            }
+            size_t i = 0;
+#ifdef CE_SIMD_SSE2
+            __m128 row[12];
+            for (size_t j = 0; j < 12; ++j)
+                row[j] = _mm_set1_ps(m[j]);
+            // Squared distances are positive, so flipping the lower bits of the float orders them descending.
+            const __m128i flip = _mm_set1_epi32(0x7FFFFFFF);
+            for (; i + 4 <= p_count; i += 4)
+            {
+                __m128 x = _mm_loadu_ps(xs + i);
+                __m128 y = _mm_loadu_ps(ys + i);
+                __m128 z = _mm_loadu_ps(zs + i);
+                __m128 wx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(row[0], x), _mm_mul_ps(row[1], y)), _mm_add_ps(_mm_mul_ps(row[2], z), row[3]));
+                __m128 wy = _mm_add_ps(_mm_add_ps(_mm_mul_ps(row[4], x), _mm_mul_ps(row[5], y)), _mm_add_ps(_mm_mul_ps(row[6], z), row[7]));
+                __m128 wz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(row[8], x), _mm_mul_ps(row[9], y)), _mm_add_ps(_mm_mul_ps(row[10], z), row[11]));
+                __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(wx, wx), _mm_mul_ps(wy, wy)), _mm_mul_ps(wz, wz));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(p_keys + i), _mm_xor_si128(_mm_castps_si128(distance), flip));
+            }
+#endif
+            for (; i < p_count; ++i)
+            {
+                float wx = m[0] * xs[i] + m[1] * ys[i] + m[2] * zs[i] + m[3];
+                float wy = m[4] * xs[i] + m[5] * ys[i] + m[6] * zs[i] + m[7];
+                float wz = m[8] * xs[i] + m[9] * ys[i] + m[10] * zs[i] + m[11];
+                p_keys[i] = ~FloatToSortKey(wx * wx + wy * wy + wz * wz);
+            }
+        }
+
+        // Sort and merge the dirty ranges, ranges closer than the gap are merged to save upload calls.
+        void MergeRanges(std::vector<std::pair<size_t, size_t>>& p_ranges, size_t p_count, size_t p_gap)
+        {
+            std::sort(p_ranges.begin(), p_ranges.end());
+            size_t merged = 0;
+            for (auto& range : p_ranges)
+            {
+                range.second = std::min(range.second, p_count);
+                if (range.first >= range.second)
+                    continue;
+                if (merged != 0 && range.first <= p_ranges[merged - 1].second + p_gap)
+                    p_ranges[merged - 1].second = std::max(p_ranges[merged - 1].second, range.second);
+                else
+                    p_ranges[merged++] = range;
+            }
+            p_ranges.resize(merged);
+        }
+    }
+
+    void DynamicMesh::SetAllTrianglesDirty()
+    {
+        {
+            std::lock_guard<std::mutex> lock(triangles_mutex);
+            ResetUploadState();
+        }
+        SetBVHDirty();
+    }
+
+    void DynamicMesh::ResetUploadState()
+    {
+        uploaded_triangle_count = std::numeric_limits<size_t>::max();
+        is_stream_dirty = true;
+        centers_dirty = true;
+    }
+
+    void DynamicMesh::SetTrianglesDirty(size_t p_first, size_t p_count)
+    {
+        if (p_count == 0)
+            return;
+        {
+            std::lock_guard<std::mutex> lock(triangles_mutex);
+            dirty_ranges.emplace_back(p_first, p_first + p_count);
+            is_stream_dirty = true;
+            centers_dirty = true;
+        }
+        SetBVHDirty();
     }
 
     DynamicMesh::DynamicMesh(const std::string& p_component_name)
@@ -39,20 +135,81 @@ namespace CrossEngine
         : VisualMesh(std::move(p_other))
     {
         triangles = std::move(p_other.triangles);
+        // The states describe the buffers, which are moved with the base.
+        dirty_ranges = std::move(p_other.dirty_ranges);
+        uploaded_triangle_count = p_other.uploaded_triangle_count;
+        is_streaming = p_other.is_streaming;
+        is_stream_dirty = p_other.is_stream_dirty;
+        stream_vbo = p_other.stream_vbo;
+        stream_capacity = p_other.stream_capacity;
+        stream_region = p_other.stream_region;
+        stream_mapping = p_other.stream_mapping;
+        stream_generation = p_other.stream_generation;
+        context_states = std::move(p_other.context_states);
+        p_other.stream_vbo = 0;
+        p_other.stream_mapping = nullptr;
     }
 
     DynamicMesh::~DynamicMesh()
     {
         for (auto i : triangles)
             delete i;
+        if (!Game::IsInitialized())
+            return;
+        if (stream_vbo != 0)
+            Graphics::FreeSharedResource(stream_vbo, glDeleteBuffers);
+        for (auto& i : context_states)
+        {
+            for (auto fence : i.second.stream_fences)
+                Graphics::FreeFence(fence);
+            if (!Game::GetInstance()->IsContextAvailable(i.first))
+                continue;
+            i.first->FreeThreadResource(i.second.ebo);
+            i.first->FreeThreadResource(i.second.stream_vao);
+        }
     }
 
     std::vector<Triangle*>& DynamicMesh::Triangles()
     {
-        SetTrianglesDirty(true);
+        SetAllTrianglesDirty();
         return triangles;
     }
 
+    DynamicMesh::TriangleEdit::TriangleEdit(DynamicMesh& p_mesh, size_t p_index)
+        : mesh(&p_mesh), index(p_index), lock(p_mesh.triangles_mutex)
+    {
+        if (p_index >= p_mesh.triangles.size())
+            throw std::out_of_range("Triangle index out of range.");
+    }
+
+    DynamicMesh::TriangleEdit::~TriangleEdit()
+    {
+        // A moved edit does not hold the lock.
+        if (!lock.owns_lock())
+            return;
+        mesh->dirty_ranges.emplace_back(index, index + 1);
+        mesh->is_stream_dirty = true;
+        mesh->centers_dirty = true;
+        lock.unlock();
+        mesh->SetBVHDirty();
+    }
+
+    DynamicMesh::TriangleEdit DynamicMesh::EditTriangle(size_t p_index)
+    {
+        return TriangleEdit(*this, p_index);
+    }
+
+    void DynamicMesh::SetStreaming(bool p_streaming)
+    {
+        std::lock_guard<std::mutex> lock(triangles_mutex);
+        if (is_streaming == p_streaming)
+            return;
+        is_streaming = p_streaming;
+        // Each path only keeps its own buffer up to date.
+        uploaded_triangle_count = std::numeric_limits<size_t>::max();
+        is_stream_dirty = true;
+    }
+
     void DynamicMesh::Update(float p_delta)
     {
     }
@@ -61,7 +218,13 @@ namespace CrossEngine
     {
         if (material->ShouldPrioritize())
         {
+            // Order independent transparency only needs the mesh to be drawn in the transparent pass.
+            if (p_context->IsOITEnabled())
+                return 1.0f;
             std::lock_guard<std::mutex> lock(triangles_mutex);
+            // The triangles may still be loading.
+            if (triangles.empty())
+                return 0.0f;
             auto to_camera = p_context->GetUsingCamera()->GetGlobalPosition() - GetSubspaceMatrix() * triangles[0]->GetCenter();
             return to_camera.LengthSquared();
         }
@@ -71,58 +234,387 @@ namespace CrossEngine
         }
     }
 
+    std::shared_ptr<TriangleBVH> DynamicMesh::CreateBVH()
+    {
+        // The triangles may be replaced by a load meanwhile, which frees the old ones.
+        std::lock_guard<std::mutex> lock(triangles_mutex);
+        return std::make_shared<TriangleBVH>(triangles);
+    }
+
     void DynamicMesh::LoadTriangles(std::vector<Triangle*>&& p_triangles)
     {
-        for (auto i : triangles)
+        // Freed once swapped out under the lock, the readers of the old triangles hold it.
+        std::vector<Triangle*> old_triangles = std::move(p_triangles);
+        {
+            // The draws see either the old triangles with their upload state or the new ones to upload.
+            std::lock_guard<std::mutex> lock(triangles_mutex);
+            triangles.swap(old_triangles);
+            ResetUploadState();
+        }
+        for (auto i : old_triangles)
             delete i;
-        triangles = std::move(p_triangles);
-        SetTrianglesDirty(true);
+        SetBVHDirty();
     }
 
     void DynamicMesh::LoadTriangles(const std::string& p_file)
     {
-        for (auto i : triangles)
-            delete i;
-        Resource::LoadTris(p_file, triangles);
-        SetTrianglesDirty(true);
+        LoadTriangles(Resource::LoadTris(p_file));
     }
 
     void DynamicMesh::LoadTrisWithNormal(const std::string& p_file)
     {
-        for (auto i : triangles)
-            delete i;
-        Resource::LoadTrisWithNormal(p_file, triangles);
-        SetTrianglesDirty(true);
+        LoadTriangles(Resource::LoadTrisWithNormal(p_file));
     }
 
-    void DynamicMesh::Draw(Window* p_context)
+    std::future<void> DynamicMesh::LoadTrianglesAsync(const std::string& p_file)
     {
-        VisualMesh::Draw(p_context);
-        if (material->ShouldPrioritize())
+        std::weak_ptr<DynamicMesh> mesh = std::static_pointer_cast<DynamicMesh>(shared_from_this());
+        return ResourceLoader::GetInstance().Submit([mesh, p_file]() {
+            auto result = Resource::LoadModel(p_file);
+            auto target = mesh.lock();
+            if (target == nullptr)
+            {
+                for (auto i : result)
+                    delete i;
+                return;
+            }
+            target->LoadTriangles(std::move(result));
+        });
+    }
+
+    void DynamicMesh::UpdateCenters()
+    {
+        size_t count = triangles.size();
+        centers.resize(count * 3);
+        for (size_t i = 0; i < count; ++i)
         {
-            std::lock_guard<std::mutex> lock(triangles_mutex);
-            auto camera_pos = p_context->GetUsingCamera()->GetGlobalPosition();
-            auto subspace_matrix = GetSubspaceMatrix();
-            
-            std::sort(triangles.begin(), triangles.end(), [&camera_pos, &subspace_matrix]
-                (const Triangle* p_a, const Triangle* p_b)
+            auto center = triangles[i]->GetCenter();
+            centers[i] = center[0];
+            centers[count + i] = center[1];
+            centers[count * 2 + i] = center[2];
+        }
+    }
+
+    bool DynamicMesh::UpdateSortOrder(Window* p_context, ContextState& p_state)
+    {
+        size_t count = triangles.size();
+        auto camera_position = p_context->GetUsingCamera() == nullptr ? Math::Pos() : p_context->GetUsingCamera()->GetGlobalPosition();
+        const auto& subspace_matrix = GetSubspaceMatrix();
+        if (!p_state.order_dirty && p_state.order.size() == count && p_state.subspace_matrix == subspace_matrix
+            && (camera_position - p_state.camera_position).LengthSquared() <= sort_distance_threshold * sort_distance_threshold)
+            return false;
+
+        bool is_new_order = p_state.order.size() != count;
+        if (is_new_order)
+        {
+            p_state.order.resize(count);
+            std::iota(p_state.order.begin(), p_state.order.end(), 0);
+        }
+        p_state.camera_position = camera_position;
+        p_state.subspace_matrix = subspace_matrix;
+
+        sort_keys.resize(count);
+        ComputeDepthKeys(centers.data(), count, subspace_matrix, camera_position, sort_keys.data());
+
+        // The order of the last sort is usually almost right, count where it descends.
+        size_t descent_count = 0;
+        for (size_t i = 1; i < count; ++i)
+        {
+            if (sort_keys[p_state.order[i - 1]] > sort_keys[p_state.order[i]])
+                ++descent_count;
+        }
+        if (descent_count == 0)
+            return is_new_order;
+
+        if (descent_count <= count / 64)
+        {
+            // Insertion sort is linear on an almost sorted order, but few descents can still
+            // need many shifts (two swapped sorted runs), so give up after a linear budget.
+            size_t shift_budget = count * 2;
+            bool is_sorted = true;
+            for (size_t i = 1; i < count && is_sorted; ++i)
             {
-                auto a = subspace_matrix * p_a->GetCenter();
-                auto b = subspace_matrix * p_b->GetCenter();
-                return (a - camera_pos).LengthSquared() > (b - camera_pos).LengthSquared();
-            });
-            UpdateVAO(triangles, GetVAO(p_context), GetVBO(p_context));
-            triangles_dirty = false;
+                uint32_t index = p_state.order[i];
+                uint32_t key = sort_keys[index];
+                size_t j = i;
+                for (; j > 0 && sort_keys[p_state.order[j - 1]] > key; --j)
+                {
+                    if (shift_budget == 0)
+                    {
+                        is_sorted = false;
+                        break;
+                    }
+                    --shift_budget;
+                    p_state.order[j] = p_state.order[j - 1];
+                }
+                p_state.order[j] = index;
+            }
+            if (is_sorted)
+                return true;
+        }
+
+        // The radix sort is stable, so equal depths keep the order of the last sort.
+        sort_values = p_state.order;
+        for (size_t i = 0; i < count; ++i)
+            p_state.order[i] = sort_keys[sort_values[i]];
+        RadixSort(p_state.order, sort_values, sort_buffers);
+        p_state.order.swap(sort_values);
+        return true;
+    }
+
+    void DynamicMesh::UploadVertexBuffer(Window* p_context)
+    {
+        constexpr size_t triangle_size = Triangle::TRIANGLE_ARRAY_SIZE * sizeof(float);
+        size_t count = triangles.size();
+        upload_buffer.resize(count * Triangle::TRIANGLE_ARRAY_SIZE);
+        Resource::CreateModelVertexArray(triangles, upload_buffer.data(), upload_buffer.size());
+        glBufferData(GL_ARRAY_BUFFER, count * triangle_size, upload_buffer.data(), GL_DYNAMIC_DRAW);
+        p_context->AddUploadBytes(count * triangle_size);
+        uploaded_triangle_count = count;
+        dirty_ranges.clear();
+    }
+
+    unsigned int DynamicMesh::AcquireVertexBuffer(Window* p_context)
+    {
+        std::lock_guard<std::mutex> lock(triangles_mutex);
+        return VisualMesh::AcquireVertexBuffer(p_context);
+    }
+
+    bool DynamicMesh::UpdateVertexBuffer(Window* p_context)
+    {
+        constexpr size_t triangle_size = Triangle::TRIANGLE_ARRAY_SIZE * sizeof(float);
+        size_t count = triangles.size();
+        glBindBuffer(GL_ARRAY_BUFFER, GetVBO());
+        if (uploaded_triangle_count != count)
+        {
+            // Reallocating also orphans the storage still read by earlier draws.
+            upload_buffer.resize(count * Triangle::TRIANGLE_ARRAY_SIZE);
+            Resource::CreateModelVertexArray(triangles, upload_buffer.data(), upload_buffer.size());
+            glBufferData(GL_ARRAY_BUFFER, count * triangle_size, upload_buffer.data(), GL_DYNAMIC_DRAW);
+            p_context->AddUploadBytes(count * triangle_size);
+            uploaded_triangle_count = count;
+            dirty_ranges.clear();
+            return true;
+        }
+        if (dirty_ranges.empty())
+            return false;
+
+        MergeRanges(dirty_ranges, count, 16);
+        size_t dirty_count = 0;
+        for (auto& range : dirty_ranges)
+            dirty_count += range.second - range.first;
+        if (dirty_count * 2 > count)
+        {
+            // Most of the mesh changed, orphan the buffer rather than waiting for the draws reading it.
+            dirty_ranges.assign(1, { 0, count });
+            glBufferData(GL_ARRAY_BUFFER, count * triangle_size, nullptr, GL_DYNAMIC_DRAW);
+        }
+        for (auto& range : dirty_ranges)
+        {
+            size_t range_count = range.second - range.first;
+            upload_buffer.resize(range_count * Triangle::TRIANGLE_ARRAY_SIZE);
+            for (size_t i = 0; i < range_count; ++i)
+                triangles[range.first + i]->GetVertexArray(upload_buffer.data() + i * Triangle::TRIANGLE_ARRAY_SIZE, Triangle::TRIANGLE_ARRAY_SIZE);
+            glBufferSubData(GL_ARRAY_BUFFER, range.first * triangle_size, range_count * triangle_size, upload_buffer.data());
+            p_context->AddUploadBytes(range_count * triangle_size);
+        }
+        dirty_ranges.clear();
+        return true;
+    }
+
+    void DynamicMesh::AllocateStreamBuffer(size_t p_size)
+    {
+        if (!Graphics::IsBufferStorageSupported())
+        {
+            if (stream_vbo == 0)
+                glGenBuffers(1, &stream_vbo);
+            glBindBuffer(GL_ARRAY_BUFFER, stream_vbo);
+            glBufferData(GL_ARRAY_BUFFER, p_size, nullptr, GL_STREAM_DRAW);
             return;
         }
-        if (triangles_dirty)
+        // Immutable storage cannot be resized, the old buffer is deleted once the contexts are done with it.
+        if (stream_vbo != 0)
+            Graphics::FreeSharedResource(stream_vbo, glDeleteBuffers);
+        glGenBuffers(1, &stream_vbo);
+        ++stream_generation;
+        glBindBuffer(GL_ARRAY_BUFFER, stream_vbo);
+        // Coherent, so the writes are seen by the draws issued after them without flushing the ranges.
+        constexpr unsigned int flags = GL_MAP_WRITE_BIT | Graphics::MAP_PERSISTENT_BIT | Graphics::MAP_COHERENT_BIT;
+        Graphics::BufferStorage(GL_ARRAY_BUFFER, p_size, flags);
+        stream_mapping = glMapBufferRange(GL_ARRAY_BUFFER, 0, p_size, flags);
+        if (stream_mapping == nullptr)
+            throw std::runtime_error("Failed to map the stream buffer.");
+    }
+
+    void DynamicMesh::BindStreamVAO(Window* p_context, ContextState& p_state)
+    {
+        if (!p_state.stream_vao.IsValid())
         {
-            std::lock_guard<std::mutex> lock(triangles_mutex);
-            if (triangles_dirty)
+            unsigned int vao;
+            glGenVertexArrays(1, &vao);
+            p_state.stream_vao = p_context->RegisterThreadResource(vao, glDeleteVertexArrays);
+            p_state.stream_vao_generation = stream_generation - 1;
+        }
+        glBindVertexArray(p_state.stream_vao.GetId());
+        glBindBuffer(GL_ARRAY_BUFFER, stream_vbo);
+        // The attributes can only be set once the ring has a buffer.
+        if (stream_vbo != 0 && p_state.stream_vao_generation != stream_generation)
+        {
+            Graphics::SetVertexAttributes();
+            p_state.stream_vao_generation = stream_generation;
+        }
+    }
+
+    bool DynamicMesh::StreamVertices(Window* p_context, ContextState& p_state)
+    {
+        constexpr size_t triangle_size = Triangle::TRIANGLE_ARRAY_SIZE * sizeof(float);
+        size_t count = triangles.size();
+        if (!is_stream_dirty || count == 0)
+        {
+            BindStreamVAO(p_context, p_state);
+            return false;
+        }
+        is_stream_dirty = false;
+        // The vertex buffer of the base is not updated while streaming.
+        uploaded_triangle_count = std::numeric_limits<size_t>::max();
+        dirty_ranges.clear();
+
+        if (stream_capacity < count)
+        {
+            // The old storage is orphaned, so the fences guarding it are no longer needed.
+            for (auto& i : context_states)
             {
-                UpdateVAO(triangles, GetVAO(p_context), GetVBO(p_context));
-                triangles_dirty = false;
+                for (auto& fence : i.second.stream_fences)
+                {
+                    if (fence != nullptr)
+                        glDeleteSync(static_cast<GLsync>(fence));
+                    fence = nullptr;
+                }
             }
+            stream_capacity = count;
+            AllocateStreamBuffer(STREAM_REGION_COUNT * stream_capacity * triangle_size);
+            stream_region = 0;
+        }
+        else
+        {
+            stream_region = (stream_region + 1) % STREAM_REGION_COUNT;
+        }
+
+        // Wait until the draws of every context that read this region the last time are finished.
+        for (auto& i : context_states)
+        {
+            auto& fence = i.second.stream_fences[stream_region];
+            if (fence == nullptr)
+                continue;
+            GLenum result = glClientWaitSync(static_cast<GLsync>(fence), GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+            while (result == GL_TIMEOUT_EXPIRED)
+                result = glClientWaitSync(static_cast<GLsync>(fence), GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+            if (result == GL_WAIT_FAILED)
+                throw std::runtime_error("Failed to wait for the stream buffer fence.");
+            glDeleteSync(static_cast<GLsync>(fence));
+            fence = nullptr;
+        }
+
+        BindStreamVAO(p_context, p_state);
+        size_t offset = stream_region * stream_capacity * triangle_size;
+        if (stream_mapping != nullptr)
+        {
+            Resource::CreateModelVertexArray(triangles, reinterpret_cast<float*>(static_cast<char*>(stream_mapping) + offset),
+                count * Triangle::TRIANGLE_ARRAY_SIZE);
+        }
+        else
+        {
+            void* mapped = glMapBufferRange(GL_ARRAY_BUFFER, offset, count * triangle_size,
+                GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+            if (mapped == nullptr)
+                throw std::runtime_error("Failed to map the stream buffer.");
+            Resource::CreateModelVertexArray(triangles, static_cast<float*>(mapped), count * Triangle::TRIANGLE_ARRAY_SIZE);
+            glUnmapBuffer(GL_ARRAY_BUFFER);
+        }
+        p_context->AddUploadBytes(count * triangle_size);
+        return true;
+    }
+
+    void DynamicMesh::DrawMesh(Window* p_context)
+    {
+        std::lock_guard<std::mutex> lock(triangles_mutex);
+        if (centers_dirty)
+        {
+            UpdateCenters();
+            // The orders are kept and sorted again, they are only reset when the triangle count changes.
+            for (auto& i : context_states)
+                i.second.order_dirty = true;
+            centers_dirty = false;
+        }
+
+        auto& state = context_states[p_context];
+        GLint base_vertex = 0;
+        bool is_uploaded;
+        if (is_streaming)
+        {
+            is_uploaded = StreamVertices(p_context, state);
+            base_vertex = (GLint)(stream_region * stream_capacity * 3);
+        }
+        else
+        {
+            is_uploaded = UpdateVertexBuffer(p_context);
+        }
+        // The buffers are shared, another context may have changed them since this one last drew.
+        if (is_uploaded)
+            Graphics::FenceUpload(upload_fence);
+        else
+            Graphics::WaitUpload(upload_fence);
+
+        if (!material->ShouldPrioritize() || triangles.empty() || p_context->IsOITEnabled())
+        {
+            glDrawArrays(GL_TRIANGLES, base_vertex, GetVertexCount());
+        }
+        else
+        {
+            if (UpdateSortOrder(p_context, state))
+                state.order_dirty = true;
+            if (!state.ebo.IsValid())
+            {
+                unsigned int ebo;
+                glGenBuffers(1, &ebo);
+                state.ebo = p_context->RegisterThreadResource(ebo, glDeleteBuffers);
+            }
+            // The element array binding is part of the VAO state.
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, state.ebo.GetId());
+            size_t index_count = triangles.size() * 3;
+            if (state.order_dirty)
+            {
+                std::pmr::vector<uint32_t> indices(index_count, &FrameAllocator::GetThreadInstance());
+                for (size_t i = 0; i < state.order.size(); ++i)
+                {
+                    indices[i * 3] = state.order[i] * 3;
+                    indices[i * 3 + 1] = state.order[i] * 3 + 1;
+                    indices[i * 3 + 2] = state.order[i] * 3 + 2;
+                }
+                if (state.ebo_index_count != index_count)
+                {
+                    glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_count * sizeof(uint32_t), indices.data(), GL_DYNAMIC_DRAW);
+                    state.ebo_index_count = index_count;
+                }
+                else
+                {
+                    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, index_count * sizeof(uint32_t), indices.data());
+                }
+                p_context->AddUploadBytes(index_count * sizeof(uint32_t));
+                state.order_dirty = false;
+            }
+            glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)index_count, GL_UNSIGNED_INT, (void*)0, base_vertex);
+        }
+
+        if (is_streaming)
+        {
+            auto& fence = state.stream_fences[stream_region];
+            if (fence != nullptr)
+                glDeleteSync(static_cast<GLsync>(fence));
+            fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            // Other contexts can only wait for the fence once it is flushed.
+            if (context_states.size() > 1)
+                glFlush();
         }
     }
-}
\ No newline at end of file
+}
@@ -1,6 +1,7 @@
 #include "ce/component/parallel_light.h"
 #include "ce/graphics/renderer/renderer.h"
 #include "ce/graphics/window.h"
+#include "ce/utils/frame_allocator.h"
 
 namespace CrossEngine
 {
@@ -29,12 +30,17 @@ namespace CrossEngine
 
     void ParallelLight::SetUniform(Window* p_context, size_t p_index)
     {
-        std::stringstream ss;
-        ss << UniformName() << "[" << p_index << "]";
-        p_context->GetRenderer()->GetShaderProgram()->SetUniform(ss.str() + ".direction", direction);
-        p_context->GetRenderer()->GetShaderProgram()->SetUniform(ss.str() + ".color", color);
-        p_context->GetRenderer()->GetShaderProgram()->SetUniform(ss.str() + ".ambient", ambient);
-        p_context->GetRenderer()->GetShaderProgram()->SetUniform(ss.str() + ".intensity", intensity);
+        std::pmr::string name(&FrameAllocator::GetThreadInstance());
+        name.append(UniformName()).append("[").append(std::to_string(p_index)).append("]");
+        size_t length = name.size();
+        const auto& shader_program = p_context->GetRenderer()->GetShaderProgram();
+        shader_program->SetUniform(name.append(".direction").c_str(), direction);
+        name.resize(length);
+        shader_program->SetUniform(name.append(".color").c_str(), color);
+        name.resize(length);
+        shader_program->SetUniform(name.append(".ambient").c_str(), ambient);
+        name.resize(length);
+        shader_program->SetUniform(name.append(".intensity").c_str(), intensity);
     }
 
     void ParallelLight::Draw(Window* p_context)
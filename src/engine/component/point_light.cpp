@@ -3,7 +3,8 @@
 #include "ce/component/camera.h"
 #include "ce/graphics/renderer/renderer.h"
 #include <type_traits>
-#include <sstream>
+#include "ce/utils/frame_allocator.h"
+#include <string>
 
 namespace CrossEngine
 {
@@ -28,11 +29,16 @@ namespace CrossEngine
     void PointLight::SetUniform(Window* p_context, size_t p_index)
     {
         auto global_position = GetGlobalPosition();
-        std::stringstream ss;
-        ss << UniformName() << "[" << p_index << "]";
-        p_context->GetRenderer()->GetShaderProgram()->SetUniform(ss.str() + ".position", global_position);
-        p_context->GetRenderer()->GetShaderProgram()->SetUniform(ss.str() + ".color", color);
-        p_context->GetRenderer()->GetShaderProgram()->SetUniform(ss.str() + ".intensity", intensity);
+        // The names are built every frame, so they are allocated by the frame allocator.
+        std::pmr::string name(&FrameAllocator::GetThreadInstance());
+        name.append(UniformName()).append("[").append(std::to_string(p_index)).append("]");
+        size_t length = name.size();
+        const auto& shader_program = p_context->GetRenderer()->GetShaderProgram();
+        shader_program->SetUniform(name.append(".position").c_str(), global_position);
+        name.resize(length);
+        shader_program->SetUniform(name.append(".color").c_str(), color);
+        name.resize(length);
+        shader_program->SetUniform(name.append(".intensity").c_str(), intensity);
     }
 
     void PointLight::Draw(Window* p_context)
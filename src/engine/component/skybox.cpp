@@ -1,11 +1,14 @@
 #include "ce/component/skybox.h"
 #include "ce/graphics/window.h"
 #include "ce/resource/resource.h"
+#include "ce/resource/resource_loader.h"
 #include "ce/graphics/graphics.h"
 #include "ce/graphics/renderer/renderer.h"
+#include "ce/graphics/shader/shader_program.h"
 #include "ce/game/game.h"
 
 #include <glad/glad.h>
+#include <algorithm>
 
 namespace CrossEngine
 {
@@ -59,91 +62,168 @@ namespace CrossEngine
         1.0f,  1.0f, -1.0f
     };
 
-    void Skybox::SetSkyboxTexture(const std::vector<std::string>& p_faces, unsigned int p_texture_id)
+    struct Skybox::PendingFaces
     {
-        if (p_faces.size() != 6)
-            throw std::runtime_error("Skybox must have 6 faces.");
-        
-        glBindTexture(GL_TEXTURE_CUBE_MAP, p_texture_id);
-        size_t img_width, img_height, img_channels;
-        Resource::GetImageSize(p_faces[0], img_width, img_height, img_channels);
-        size_t buffer_size = img_width * img_height * img_channels;
-        std::unique_ptr<byte[]> buffer = 
-            std::unique_ptr<byte[]>(new byte[buffer_size]);
-        std::vector<unsigned char> image_data;
-        for (size_t i = 0; i < p_faces.size(); ++i)
+        std::mutex mutex;
+        std::vector<std::future<TextureImage>> images;
+        unsigned int texture_id = 0;
+        void* upload_fence = nullptr;
+        bool is_queued = false;
+        // Set when the skybox is destroyed, the queued upload is skipped.
+        bool is_released = false;
+    };
+
+    namespace
+    {
+        std::vector<std::future<TextureImage>> LoadFaces(const std::vector<std::string>& p_faces)
         {
-            Resource::LoadTextureImage(p_faces[i], buffer.get(), buffer_size, img_width, img_height, img_channels);
-            switch (img_channels)
+            if (p_faces.size() != 6)
+                throw std::runtime_error("Skybox must have 6 faces.");
+            // The faces are decoded in parallel.
+            std::vector<std::future<TextureImage>> result;
+            for (auto& face : p_faces)
+                result.push_back(ResourceLoader::GetInstance().LoadTextureImage(face));
+            return result;
+        }
+
+        void UploadFaces(unsigned int p_texture_id, std::vector<std::future<TextureImage>>& p_images)
+        {
+            glBindTexture(GL_TEXTURE_CUBE_MAP, p_texture_id);
+            for (size_t i = 0; i < p_images.size(); ++i)
             {
-            case 1:
-                glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-                glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RED, img_width, img_height, 0, GL_RED, GL_UNSIGNED_BYTE, buffer.get());
-                break;
-            case 3:
-                glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-                glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, img_width, img_height, 0, GL_RGB, GL_UNSIGNED_BYTE, buffer.get());
-                break;
-            case 4:
-                glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
-                glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGBA, img_width, img_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, buffer.get());
-                break;
-            default:
-                throw std::runtime_error("Invalid image format.");
+                auto image = p_images[i].get();
+                switch (image.channels)
+                {
+                case 1:
+                    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+                    glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RED, image.width, image.height, 0, GL_RED, GL_UNSIGNED_BYTE, image.pixels.get());
+                    break;
+                case 3:
+                    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+                    glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, image.width, image.height, 0, GL_RGB, GL_UNSIGNED_BYTE, image.pixels.get());
+                    break;
+                case 4:
+                    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+                    glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGBA, image.width, image.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image.pixels.get());
+                    break;
+                default:
+                    throw std::runtime_error("Invalid image format.");
+                }
             }
+            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
         }
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    }
+
+    void Skybox::SetSkyboxTexture(const std::vector<std::string>& p_faces, unsigned int p_texture_id)
+    {
+        auto images = LoadFaces(p_faces);
+        UploadFaces(p_texture_id, images);
     }
 
     Skybox::Skybox(const std::vector<std::string>& p_faces, const std::string& p_component_name)
-        : faces(p_faces), Component3D(p_component_name)
+        : Component3D(p_component_name)
     {
         Scale() = Math::Vec4(10.0f, 10.0f, 10.0f);
+        pending_faces = std::make_shared<PendingFaces>();
+        pending_faces->images = LoadFaces(p_faces);
     }
 
-    void Skybox::SetupSkybox(unsigned int p_vao, unsigned int p_vbo, unsigned int p_texture_id)
+    void Skybox::SetupSkybox()
     {
-        glBindBuffer(GL_ARRAY_BUFFER, p_vbo);
+        glGenBuffers(1, &vbo);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
         glBufferData(GL_ARRAY_BUFFER, 108 * sizeof(float), vertices, GL_STATIC_DRAW);
-        
-        glBindVertexArray(p_vao);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(0);
-        SetSkyboxTexture(faces, p_texture_id);
+        Graphics::FenceUpload(vbo_fence);
+    }
+
+    bool Skybox::UpdateTexture(Window* p_context)
+    {
+        {
+            std::shared_lock<std::shared_mutex> lock(context_resource_mutex);
+            if (texture_cube_id != 0)
+                return true;
+        }
+        std::unique_lock<std::shared_mutex> lock(context_resource_mutex);
+        if (texture_cube_id != 0)
+            return true;
+        if (pending_faces == nullptr)
+            return false;
+        auto faces = pending_faces;
+        std::lock_guard<std::mutex> faces_lock(faces->mutex);
+        if (faces->texture_id != 0)
+        {
+            texture_cube_id = faces->texture_id;
+            texture_fence = faces->upload_fence;
+            faces->texture_id = 0;
+            faces->upload_fence = nullptr;
+            pending_faces.reset();
+            return true;
+        }
+        if (faces->is_queued || !std::all_of(faces->images.begin(), faces->images.end(),
+            [](const std::future<TextureImage>& p_image) { return ResourceLoader::IsReady(p_image); }))
+            return false;
+        faces->is_queued = true;
+        p_context->QueueUpload([faces]() {
+            std::lock_guard<std::mutex> lock(faces->mutex);
+            if (faces->is_released)
+                return;
+            unsigned int id = Graphics::GenerateTexture();
+            try
+            {
+                UploadFaces(id, faces->images);
+            }
+            catch (const std::exception&)
+            {
+                // A skybox that cannot be loaded is not drawn.
+                Graphics::ReleaseTextures(1, &id);
+                return;
+            }
+            Graphics::FenceUpload(faces->upload_fence);
+            faces->texture_id = id;
+        });
+        return false;
     }
 
     Skybox::~Skybox()
     {
         if (!Game::IsInitialized())
             return;
-        for (auto& i : vbos)
-        {
-            if (Game::GetInstance()->IsContextAvailable(i.first))
-                i.first->FreeThreadResource(i.second);
-        }
         for (auto& i : vaos)
         {
             if (Game::GetInstance()->IsContextAvailable(i.first))
                 i.first->FreeThreadResource(i.second);
         }
-        for (auto& i : texture_cube_ids)
+        if (vbo != 0)
+            Graphics::FreeSharedResource(vbo, glDeleteBuffers);
+        if (texture_cube_id != 0)
+            Graphics::DeleteTexture(texture_cube_id);
+        Graphics::FreeFence(vbo_fence);
+        Graphics::FreeFence(texture_fence);
+        if (pending_faces != nullptr)
         {
-            if (Game::GetInstance()->IsContextAvailable(i.first))
-                i.first->FreeThreadResource(i.second);
+            std::lock_guard<std::mutex> lock(pending_faces->mutex);
+            pending_faces->is_released = true;
+            // The texture is uploaded but not drawn yet.
+            if (pending_faces->texture_id != 0)
+                Graphics::DeleteTexture(pending_faces->texture_id);
+            Graphics::FreeFence(pending_faces->upload_fence);
         }
     }
 
     void Skybox::Draw(Window* p_context)
     {
+        // The skybox is not drawn until its faces are uploaded.
+        if (!UpdateTexture(p_context))
+            return;
         bool should_add_context_resource = false;
         
         {
             std::shared_lock<std::shared_mutex> lock(context_resource_mutex);
-            if (!vbos.contains(p_context))
+            if (!vaos.contains(p_context))
             {
                 should_add_context_resource = true;
             }
@@ -152,26 +232,27 @@ namespace CrossEngine
         if (should_add_context_resource)
         {
             std::unique_lock<std::shared_mutex> lock(context_resource_mutex);
+            if (vbo == 0)
+                SetupSkybox();
+            // The buffer and the texture may be uploaded by another context.
+            Graphics::WaitUpload(vbo_fence);
+            Graphics::WaitUpload(texture_fence);
             
-            unsigned int vbo, vao, texture_id;
-            glGenBuffers(1, &vbo);
-            p_context->RegisterThreadResource(vbo, glDeleteBuffers);
+            unsigned int vao;
             glGenVertexArrays(1, &vao);
-            p_context->RegisterThreadResource(vao, glDeleteVertexArrays);
-            glGenTextures(1, &texture_id);
-            p_context->RegisterThreadResource(texture_id, glDeleteTextures);
-            SetupSkybox(vao, vbo, texture_id);
-            vbos[p_context] = vbo;
-            vaos[p_context] = vao;
-            texture_cube_ids[p_context] = texture_id;
+            vaos[p_context] = p_context->RegisterThreadResource(vao, glDeleteVertexArrays);
+            glBindVertexArray(vao);
+            glBindBuffer(GL_ARRAY_BUFFER, vbo);
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+            glEnableVertexAttribArray(0);
         }
         
         glDepthMask(GL_FALSE);
         p_context->GetRenderer()->GetShaderProgram()->SetUniform("model", GetSubspaceMatrix());
         {
             std::shared_lock<std::shared_mutex> lock(context_resource_mutex);
-            glBindVertexArray(vaos[p_context]);
-            glBindTexture(GL_TEXTURE_CUBE_MAP, texture_cube_ids[p_context]);
+            glBindVertexArray(vaos[p_context].GetId());
+            p_context->GetRenderer()->GetShaderProgram()->SetSamplerCubeUniform("skybox", texture_cube_id);
         }
         glDrawArrays(GL_TRIANGLES, 0, 36);
         glDepthMask(GL_TRUE);
@@ -0,0 +1,81 @@
+#include "ce/component/static_mesh.h"
+#include "ce/graphics/window.h"
+#include "ce/graphics/renderer/renderer.h"
+#include "ce/materials/material.h"
+#include "ce/resource/resource.h"
+#include "ce/game/game.h"
+#include <glad/glad.h>
+
+namespace CrossEngine
+{
+    StaticMesh::StaticMesh(const std::string& p_component_name)
+        : VisualMesh(p_component_name), mesh_data(std::make_shared<MeshData>(std::vector<Triangle*>()))
+    {
+    }
+
+    StaticMesh::StaticMesh(std::shared_ptr<MeshData> p_mesh_data, const std::string& p_component_name)
+        : VisualMesh(p_component_name), mesh_data(p_mesh_data)
+    {
+    }
+
+    StaticMesh::StaticMesh(const StaticMesh& p_other)
+        : VisualMesh(p_other), mesh_data(p_other.mesh_data)
+    {
+    }
+
+    void StaticMesh::SetMeshData(std::shared_ptr<MeshData> p_mesh_data)
+    {
+        std::unique_lock<std::shared_mutex> lock(context_resource_mutex);
+        // The VAOs read from the vertex buffer of the previous mesh data.
+        if (Game::IsInitialized())
+        {
+            for (auto& i : vaos)
+            {
+                if (Game::GetInstance()->IsContextAvailable(i.first))
+                    i.first->FreeThreadResource(i.second);
+            }
+        }
+        vaos.clear();
+        mesh_data = p_mesh_data;
+        lock.unlock();
+        IncrementContentVersion();
+    }
+
+    unsigned int StaticMesh::AcquireVertexBuffer(Window* p_context)
+    {
+        return mesh_data->GetVBO(p_context);
+    }
+
+    void StaticMesh::DrawMesh(Window*)
+    {
+        glDrawArrays(GL_TRIANGLES, mesh_data->GetFirstVertex(), GetVertexCount());
+    }
+
+    bool StaticMesh::RegisterDraw(Window* p_context)
+    {
+        if (!Component3D::RegisterDraw(p_context))
+            return false;
+        if (material->ShouldPrioritize())
+            p_context->GetRenderer()->AddRenderTask(Task([this, p_context](){Draw(p_context);}, GetPriority(p_context)));
+        else if (is_static)
+            p_context->GetRenderer()->AddStaticMesh(p_context, this);
+        else
+            p_context->GetRenderer()->AddInstance(p_context, mesh_data, material, this);
+        return true;
+    }
+
+    void StaticMesh::LoadTriangles(std::vector<Triangle*>&& p_triangles)
+    {
+        SetMeshData(std::make_shared<MeshData>(std::move(p_triangles)));
+    }
+
+    void StaticMesh::LoadTriangles(const std::string& p_file)
+    {
+        SetMeshData(MeshData::Load(p_file));
+    }
+
+    void StaticMesh::LoadTrisWithNormal(const std::string& p_file)
+    {
+        SetMeshData(MeshData::Load(p_file));
+    }
+}
@@ -21,14 +21,13 @@ namespace CrossEngine
     {
         if (!Game::IsInitialized())
             return;
-        for (auto& i : vbos) {
-            if (Game::GetInstance()->IsContextAvailable(i.first))
-                i.first->FreeThreadResource(i.second);
-        }
         for (auto& i : vaos) {
             if (Game::GetInstance()->IsContextAvailable(i.first))
                 i.first->FreeThreadResource(i.second);
         }
+        if (vbo != 0)
+            Graphics::FreeSharedResource(vbo, glDeleteBuffers);
+        Graphics::FreeFence(upload_fence);
     }
 
 
@@ -36,27 +35,28 @@ namespace CrossEngine
         : Component3D(std::move(p_other))
     {
         vaos = std::move(p_other.vaos);
-        vbos = std::move(p_other.vbos);
+        vbo = p_other.vbo;
+        p_other.vbo = 0;
+        upload_fence = p_other.upload_fence;
+        p_other.upload_fence = nullptr;
         material = p_other.material;
+        is_static = p_other.is_static;
     }
 
     unsigned int VisualMesh::GetVAO(Window* p_context) const
     {
         std::shared_lock<std::shared_mutex> context_resource_mutex;
-        return vaos.at(p_context);
-    }
-
-    unsigned int VisualMesh::GetVBO(Window* p_context) const
-    {
-        std::shared_lock<std::shared_mutex> context_resource_mutex;
-        return vbos.at(p_context);
+        return vaos.at(p_context).GetId();
     }
 
     bool VisualMesh::RegisterDraw(Window* p_context)
     {
         if (Component3D::RegisterDraw(p_context))
         {
-            p_context->GetRenderer()->AddRenderTask(Task([this, p_context](){Draw(p_context);}, GetPriority(p_context)));
+            if (is_static && !material->ShouldPrioritize())
+                p_context->GetRenderer()->AddStaticMesh(p_context, this);
+            else
+                p_context->GetRenderer()->AddRenderTask(Task([this, p_context](){Draw(p_context);}, GetPriority(p_context)));
             return true;
         }
         return false;
@@ -80,14 +80,14 @@ namespace CrossEngine
         if (should_add_context_resource)
         {
             std::unique_lock<std::shared_mutex> lock(context_resource_mutex);
-            unsigned int vao, vbo;
-            glGenBuffers(1, &vbo);
-            p_context->RegisterThreadResource(vbo, glDeleteBuffers);
+            unsigned int vertex_buffer = AcquireVertexBuffer(p_context);
+            unsigned int vao;
             glGenVertexArrays(1, &vao);
-            p_context->RegisterThreadResource(vao, glDeleteVertexArrays);
-            UpdateVAO(GetTriangles(), vao, vbo);
-            vaos[p_context] = vao;
-            vbos[p_context] = vbo;
+            vaos[p_context] = p_context->RegisterThreadResource(vao, glDeleteVertexArrays);
+            glBindVertexArray(vao);
+            glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+            Graphics::SetVertexAttributes();
+            glBindVertexArray(0);
         }
 
         if (p_context->GetThreadId() != std::this_thread::get_id())
@@ -95,31 +95,83 @@ namespace CrossEngine
         
         {
             std::shared_lock<std::shared_mutex> lock(context_resource_mutex);
-            glBindVertexArray(vaos[p_context]);
+            glBindVertexArray(vaos[p_context].GetId());
         }
         
         p_context->GetRenderer()->GetShaderProgram()->SetUniform("model", GetSubspaceMatrix());
         material->SetUniform(p_context);
         
+        DrawMesh(p_context);
+    }
+
+    void VisualMesh::DrawMesh(Window*)
+    {
         glDrawArrays(GL_TRIANGLES, 0, GetVertexCount());
     }
 
-    void VisualMesh::UpdateVAO(const std::vector<Triangle*>& p_triangles, unsigned int p_vao, unsigned int p_vbo)
+    void VisualMesh::SetBVHDirty()
+    {
+        {
+            std::lock_guard<std::mutex> lock(bvh_mutex);
+            bvh_dirty = true;
+        }
+        IncrementContentVersion();
+    }
+
+    std::shared_ptr<TriangleBVH> VisualMesh::CreateBVH()
+    {
+        return std::make_shared<TriangleBVH>(GetTriangles());
+    }
+
+    std::shared_ptr<const TriangleBVH> VisualMesh::GetBVH()
+    {
+        std::lock_guard<std::mutex> lock(bvh_mutex);
+        if (bvh_dirty || bvh == nullptr)
+        {
+            // Readers holding the previous BVH keep it alive.
+            bvh = CreateBVH();
+            bvh_dirty = false;
+        }
+        return bvh;
+    }
+
+    bool VisualMesh::Intersect(const Math::Vec4& p_origin, const Math::Vec4& p_direction, RayHit& p_hit, float p_max_distance)
+    {
+        return GetBVH()->Intersect(GetSubspaceMatrix(), p_origin, p_direction, p_hit, p_max_distance);
+    }
+
+    bool VisualMesh::GetClosestPosition(const Math::Vec4& p_point, ClosestHit& p_result)
+    {
+        return GetBVH()->GetClosestPosition(GetSubspaceMatrix(), p_point, p_result);
+    }
+
+    size_t VisualMesh::OverlapSphere(const Math::Vec4& p_center, float p_radius, std::vector<size_t>& p_result)
+    {
+        return GetBVH()->OverlapSphere(GetSubspaceMatrix(), p_center, p_radius, p_result);
+    }
+
+    unsigned int VisualMesh::AcquireVertexBuffer(Window* p_context)
+    {
+        if (vbo == 0)
+        {
+            glGenBuffers(1, &vbo);
+            glBindBuffer(GL_ARRAY_BUFFER, vbo);
+            UploadVertexBuffer(p_context);
+            Graphics::FenceUpload(upload_fence);
+        }
+        else
+        {
+            Graphics::WaitUpload(upload_fence);
+        }
+        return vbo;
+    }
+
+    void VisualMesh::UploadVertexBuffer(Window* p_context)
     {
         auto vertex_count = GetVertexCount();
         auto vertices = std::unique_ptr<float[]>(new float[vertex_count * Vertex::ARRAY_SIZE]);
-        Resource::CreateModelVertexArray(p_triangles, vertices.get(), vertex_count * Vertex::ARRAY_SIZE);
-        glBindVertexArray(p_vao);
-        glBindBuffer(GL_ARRAY_BUFFER, p_vbo);
+        Resource::CreateModelVertexArray(GetTriangles(), vertices.get(), vertex_count * Vertex::ARRAY_SIZE);
         glBufferData(GL_ARRAY_BUFFER, vertex_count * Vertex::ARRAY_SIZE * sizeof(float), vertices.get(), GL_STATIC_DRAW);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, Vertex::ARRAY_SIZE * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, Vertex::ARRAY_SIZE * sizeof(float), (void*)(3 * sizeof(float)));
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, Vertex::ARRAY_SIZE * sizeof(float), (void*)(6 * sizeof(float)));
-        glEnableVertexAttribArray(2);
-        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, Vertex::ARRAY_SIZE * sizeof(float), (void*)(8 * sizeof(float)));
-        glEnableVertexAttribArray(3);
-        glBindVertexArray(0);
+        p_context->AddUploadBytes(vertex_count * Vertex::ARRAY_SIZE * sizeof(float));
     }
 }
\ No newline at end of file
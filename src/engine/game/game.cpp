@@ -3,7 +3,9 @@
 #include "ce/managers/input_manager.h"
 #include "ce/managers/event_manager.h"
 #include "ce/graphics/graphics.h"
+#include "ce/utils/frame_allocator.h"
 #include "ce/component/component.h"
+#include "ce/component/camera.h"
 #include <GLFW/glfw3.h>
 
 namespace CrossEngine
@@ -16,6 +18,7 @@ namespace CrossEngine
         input_manager = std::make_shared<InputManager>();
         event_manager = std::make_shared<EventManager>();
         base_component = std::make_shared<Component>();
+        scene_bvh = std::make_shared<SceneBVH>();
 
         event_manager->AddEventListener(input_manager);
         Ready();
@@ -96,6 +99,51 @@ namespace CrossEngine
         event_manager->RegisterEvent(p_event);
     }
 
+    Ray Game::ScreenPointToRay(const Window* p_window, const Math::Vector<double, 2>& p_cursor_position)
+    {
+        const auto& window_size = p_window->GetWindowSize();
+        if (window_size[0] == 0 || window_size[1] == 0)
+            throw std::domain_error("The window has no area.");
+        float x = (float)(2.0 * p_cursor_position[0] / window_size[0] - 1.0);
+        float y = (float)(1.0 - 2.0 * p_cursor_position[1] / window_size[1]);
+
+        Math::Mat4 view;
+        if (p_window->GetUsingCamera() != nullptr)
+            view = p_window->GetUsingCamera()->GetViewMatrix();
+        Math::Mat4 inverse = Math::Inverse(p_window->GetProjMatrix() * view);
+        Math::Vec4 near_point = inverse * Math::Vec4(x, y, -1.0f, 1.0f);
+        Math::Vec4 far_point = inverse * Math::Vec4(x, y, 1.0f, 1.0f);
+        near_point = near_point / near_point[3];
+        far_point = far_point / far_point[3];
+
+        Ray ray;
+        ray.origin = near_point;
+        ray.direction = far_point - near_point;
+        ray.direction[3] = 0.0f;
+        ray.direction.Normalize();
+        return ray;
+    }
+
+    bool Game::RayCast(const Math::Vec4& p_origin, const Math::Vec4& p_direction, RayCastHit& p_hit, float p_max_distance)
+    {
+        return scene_bvh->RayCast(base_component, Ray{p_origin, p_direction}, p_hit, p_max_distance);
+    }
+
+    bool Game::RayCast(const Window* p_window, const Math::Vector<double, 2>& p_cursor_position, RayCastHit& p_hit)
+    {
+        return scene_bvh->RayCast(base_component, ScreenPointToRay(p_window, p_cursor_position), p_hit);
+    }
+
+    size_t Game::RayCast(const std::vector<Ray>& p_rays, std::vector<RayCastHit>& p_hits, float p_max_distance)
+    {
+        return scene_bvh->RayCast(base_component, p_rays, p_hits, p_max_distance);
+    }
+
+    std::vector<RayCastHit> Game::RayCastAll(const Math::Vec4& p_origin, const Math::Vec4& p_direction, float p_max_distance)
+    {
+        return scene_bvh->RayCastAll(base_component, Ray{p_origin, p_direction}, p_max_distance);
+    }
+
     void Game::Run()
     {
         float frame_start;
@@ -106,6 +154,8 @@ namespace CrossEngine
             event_manager->DispatchEvents();
             Process(delta);
             base_component->Update(delta);
+            ComponentRegistry::EndFrame(this);
+            FrameAllocator::GetThreadInstance().Reset();
             Graphics::Update();
             Sleep(1);
             delta = (float)glfwGetTime() - frame_start;
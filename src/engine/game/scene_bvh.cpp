@@ -0,0 +1,127 @@
+#include "ce/game/scene_bvh.h"
+#include "ce/component/visual_mesh.h"
+
+namespace CrossEngine
+{
+    void SceneBVH::CollectMeshes(const std::shared_ptr<Component>& p_component,
+        std::vector<std::shared_ptr<VisualMesh>>& p_result) const
+    {
+        if (!p_component->IsVisible())
+            return;
+        auto mesh = std::dynamic_pointer_cast<VisualMesh>(p_component);
+        if (mesh != nullptr)
+            p_result.push_back(mesh);
+        p_component->ForEachChild([this, &p_result](const std::shared_ptr<Component>& p_child) {
+            CollectMeshes(p_child, p_result);
+        });
+    }
+
+    void SceneBVH::Update(const std::shared_ptr<Component>& p_root)
+    {
+        // Read before walking the scene, so a change made while walking is seen by the next query.
+        uint64_t current_structure_version = p_root->GetStructureVersion();
+        uint64_t current_content_version = p_root->GetContentVersion();
+        if (root.Lock() == p_root && structure_version == current_structure_version && content_version == current_content_version)
+            return;
+        root = ComponentLink::Make(p_root.get());
+        structure_version = current_structure_version;
+        content_version = current_content_version;
+
+        std::vector<std::shared_ptr<VisualMesh>> current_meshes;
+        CollectMeshes(p_root, current_meshes);
+        std::vector<std::shared_ptr<const TriangleBVH>> current_bvhs;
+        current_bvhs.reserve(current_meshes.size());
+        for (auto& mesh : current_meshes)
+            current_bvhs.push_back(mesh->GetBVH());
+
+        bool should_rebuild = current_meshes.size() != meshes.size();
+        for (size_t i = 0; !should_rebuild && i < current_meshes.size(); ++i)
+            should_rebuild = meshes[i].Lock() != current_meshes[i] || mesh_bvhs[i] != current_bvhs[i];
+
+        if (should_rebuild)
+        {
+            std::vector<Math::Mat4> subspace_matrices;
+            subspace_matrices.reserve(current_meshes.size());
+            meshes.clear();
+            for (auto& mesh : current_meshes)
+            {
+                subspace_matrices.push_back(mesh->GetSubspaceMatrix());
+                meshes.push_back(ComponentLink::Make(mesh.get()));
+            }
+            mesh_bvhs = std::move(current_bvhs);
+            instance_bvh.Build(mesh_bvhs, subspace_matrices);
+            return;
+        }
+
+        for (size_t i = 0; i < current_meshes.size(); ++i)
+        {
+            const auto& subspace_matrix = current_meshes[i]->GetSubspaceMatrix();
+            if (!(instance_bvh.GetInstance(i).subspace_matrix == subspace_matrix))
+                instance_bvh.SetSubspaceMatrix(i, subspace_matrix);
+        }
+        if (instance_bvh.IsRefitNeeded())
+            instance_bvh.Refit();
+    }
+
+    RayCastHit SceneBVH::CreateHit(const InstanceHit& p_hit, const Ray& p_ray) const
+    {
+        RayCastHit result;
+        result.mesh = std::static_pointer_cast<VisualMesh>(meshes[p_hit.instance_index].Lock());
+        result.distance = p_hit.distance;
+        result.triangle_index = p_hit.triangle_index;
+        result.u = p_hit.u;
+        result.v = p_hit.v;
+        for (size_t i = 0; i < 3; ++i)
+            result.position[i] = p_ray.origin[i] + p_ray.direction[i] * p_hit.distance;
+        result.position[3] = 1.0f;
+        return result;
+    }
+
+    size_t SceneBVH::GetMeshCount() const
+    {
+        std::lock_guard<std::mutex> lock(scene_mutex);
+        return meshes.size();
+    }
+
+    bool SceneBVH::RayCast(const std::shared_ptr<Component>& p_root, const Ray& p_ray, RayCastHit& p_hit, float p_max_distance)
+    {
+        std::lock_guard<std::mutex> lock(scene_mutex);
+        Update(p_root);
+        InstanceHit hit;
+        if (!instance_bvh.Intersect(p_ray.origin, p_ray.direction, hit, p_max_distance))
+            return false;
+        p_hit = CreateHit(hit, p_ray);
+        return true;
+    }
+
+    std::vector<RayCastHit> SceneBVH::RayCastAll(const std::shared_ptr<Component>& p_root, const Ray& p_ray, float p_max_distance)
+    {
+        std::lock_guard<std::mutex> lock(scene_mutex);
+        Update(p_root);
+        std::vector<InstanceHit> hits;
+        instance_bvh.IntersectAll(p_ray.origin, p_ray.direction, hits, p_max_distance);
+        std::vector<RayCastHit> result;
+        result.reserve(hits.size());
+        for (auto& hit : hits)
+            result.push_back(CreateHit(hit, p_ray));
+        return result;
+    }
+
+    size_t SceneBVH::RayCast(const std::shared_ptr<Component>& p_root, const std::vector<Ray>& p_rays,
+        std::vector<RayCastHit>& p_hits, float p_max_distance)
+    {
+        std::lock_guard<std::mutex> lock(scene_mutex);
+        Update(p_root);
+        std::vector<InstanceHit> hits(p_rays.size());
+        for (auto& hit : hits)
+            hit.distance = p_max_distance;
+        size_t result = instance_bvh.Intersect(p_rays.data(), hits.data(), p_rays.size());
+        p_hits.assign(p_rays.size(), RayCastHit());
+        for (size_t i = 0; i < p_rays.size(); ++i)
+        {
+            if (hits[i].distance < p_max_distance)
+                p_hits[i] = CreateHit(hits[i], p_rays[i]);
+        }
+        return result;
+    }
+}
@@ -0,0 +1,1084 @@
+#include "ce/geometry/bvh.h"
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <cmath>
+
+#ifdef CE_SIMD_SSE2
+    #include <emmintrin.h>
+#endif
+
+namespace CrossEngine
+{
+    namespace
+    {
+        constexpr float INF = std::numeric_limits<float>::infinity();
+        constexpr uint32_t STACK_SIZE = 64;
+
+        struct AABB
+        {
+            float min[3] = {INF, INF, INF};
+            float max[3] = {-INF, -INF, -INF};
+
+            FORCE_INLINE void Grow(const float* p_point) noexcept
+            {
+                for (int i = 0; i < 3; ++i)
+                {
+                    min[i] = std::min(min[i], p_point[i]);
+                    max[i] = std::max(max[i], p_point[i]);
+                }
+            }
+
+            FORCE_INLINE void Grow(const AABB& p_other) noexcept
+            {
+                for (int i = 0; i < 3; ++i)
+                {
+                    min[i] = std::min(min[i], p_other.min[i]);
+                    max[i] = std::max(max[i], p_other.max[i]);
+                }
+            }
+
+            FORCE_INLINE float HalfArea() const noexcept
+            {
+                float ex = max[0] - min[0], ey = max[1] - min[1], ez = max[2] - min[2];
+                if (ex < 0.0f)
+                    return 0.0f;
+                return ex * ey + ey * ez + ez * ex;
+            }
+        };
+
+        FORCE_INLINE float RayBox(const TriangleBVH::Node& p_node, const float* p_origin, const float* p_inv_dir, float p_max) noexcept
+        {
+            float t_min = 0.0f;
+            float t_max = p_max;
+            for (int i = 0; i < 3; ++i)
+            {
+                float t0 = (p_node.min[i] - p_origin[i]) * p_inv_dir[i];
+                float t1 = (p_node.max[i] - p_origin[i]) * p_inv_dir[i];
+                if (t0 > t1)
+                    std::swap(t0, t1);
+                // NaN from 0 * inf is discarded by the comparisons.
+                t_min = t0 > t_min ? t0 : t_min;
+                t_max = t1 < t_max ? t1 : t_max;
+            }
+            return t_min <= t_max ? t_min : INF;
+        }
+
+        FORCE_INLINE float BoxDistanceSquared(const TriangleBVH::Node& p_node, const float* p_point) noexcept
+        {
+            float result = 0.0f;
+            for (int i = 0; i < 3; ++i)
+            {
+                float d = std::max(std::max(p_node.min[i] - p_point[i], 0.0f), p_point[i] - p_node.max[i]);
+                result += d * d;
+            }
+            return result;
+        }
+
+        FORCE_INLINE Math::Vec4 ToVec(const float* p_data, float p_w) noexcept
+        {
+            return Math::Vec4(p_data[0], p_data[1], p_data[2], p_w);
+        }
+
+        // The minimum and maximum scale of the upper 3x3 part of a TRS matrix.
+        void GetScaleRange(const Math::Mat4& p_matrix, float& p_min, float& p_max)
+        {
+            p_min = INF;
+            p_max = 0.0f;
+            for (size_t j = 0; j < 3; ++j)
+            {
+                float s = std::sqrt(p_matrix(j) * p_matrix(j)
+                    + p_matrix(4 + j) * p_matrix(4 + j)
+                    + p_matrix(8 + j) * p_matrix(8 + j));
+                p_min = std::min(p_min, s);
+                p_max = std::max(p_max, s);
+            }
+        }
+
+        // Binned SAH builder shared by the triangle and the instance hierarchies.
+        struct BVHBuilder
+        {
+            std::vector<AABB> bounds;
+            std::vector<float> centroids;
+            std::vector<uint32_t> indices;
+            std::vector<TriangleBVH::Node>& nodes;
+            uint32_t max_leaf_size;
+            uint32_t max_sah_leaf_size;
+            std::atomic<uint32_t> next_node = 1;
+
+            BVHBuilder(std::vector<TriangleBVH::Node>& p_nodes, size_t p_count, uint32_t p_max_leaf_size, uint32_t p_max_sah_leaf_size)
+                : bounds(p_count), centroids(p_count * 3), indices(p_count), nodes(p_nodes),
+                max_leaf_size(p_max_leaf_size), max_sah_leaf_size(p_max_sah_leaf_size)
+            {
+                if (p_count >= std::numeric_limits<uint32_t>::max() / 2)
+                    throw std::out_of_range("Too many primitives for a BVH.");
+            }
+
+            void Build()
+            {
+                for (size_t i = 0; i < indices.size(); ++i)
+                {
+                    for (int j = 0; j < 3; ++j)
+                        centroids[i * 3 + j] = (bounds[i].min[j] + bounds[i].max[j]) * 0.5f;
+                    indices[i] = static_cast<uint32_t>(i);
+                }
+                nodes.resize(indices.size() * 2);
+                BuildRecursive(0, 0, static_cast<uint32_t>(indices.size()), 0);
+                nodes.resize(next_node.load());
+                nodes.shrink_to_fit();
+            }
+
+            void BuildRecursive(uint32_t p_node_index, uint32_t p_first, uint32_t p_count, uint32_t p_depth)
+            {
+                constexpr uint32_t BIN_COUNT = TriangleBVH::BIN_COUNT;
+                AABB node_bounds, centroid_bounds;
+                for (uint32_t i = p_first; i < p_first + p_count; ++i)
+                {
+                    uint32_t index = indices[i];
+                    node_bounds.Grow(bounds[index]);
+                    centroid_bounds.Grow(&centroids[index * 3]);
+                }
+                TriangleBVH::Node& node = nodes[p_node_index];
+                for (int i = 0; i < 3; ++i)
+                {
+                    node.min[i] = node_bounds.min[i];
+                    node.max[i] = node_bounds.max[i];
+                }
+                node.left_first = p_first;
+                node.count = p_count;
+                if (p_count <= max_leaf_size || p_depth >= STACK_SIZE - 1)
+                    return;
+
+                // Binned SAH over all three axes.
+                int best_axis = -1;
+                uint32_t best_split = 0;
+                float best_cost = INF;
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    float extent = centroid_bounds.max[axis] - centroid_bounds.min[axis];
+                    if (extent <= 0.0f)
+                        continue;
+                    AABB bin_bounds[BIN_COUNT];
+                    uint32_t bin_counts[BIN_COUNT] = {};
+                    float scale = BIN_COUNT / extent;
+                    for (uint32_t i = p_first; i < p_first + p_count; ++i)
+                    {
+                        uint32_t index = indices[i];
+                        uint32_t bin = std::min(BIN_COUNT - 1,
+                            static_cast<uint32_t>((centroids[index * 3 + axis] - centroid_bounds.min[axis]) * scale));
+                        ++bin_counts[bin];
+                        bin_bounds[bin].Grow(bounds[index]);
+                    }
+                    float left_area[BIN_COUNT - 1], right_area[BIN_COUNT - 1];
+                    uint32_t left_count[BIN_COUNT - 1], right_count[BIN_COUNT - 1];
+                    AABB left_box, right_box;
+                    uint32_t left_sum = 0, right_sum = 0;
+                    for (uint32_t i = 0; i < BIN_COUNT - 1; ++i)
+                    {
+                        left_sum += bin_counts[i];
+                        left_count[i] = left_sum;
+                        left_box.Grow(bin_bounds[i]);
+                        left_area[i] = left_box.HalfArea();
+                        right_sum += bin_counts[BIN_COUNT - 1 - i];
+                        right_count[BIN_COUNT - 2 - i] = right_sum;
+                        right_box.Grow(bin_bounds[BIN_COUNT - 1 - i]);
+                        right_area[BIN_COUNT - 2 - i] = right_box.HalfArea();
+                    }
+                    for (uint32_t i = 0; i < BIN_COUNT - 1; ++i)
+                    {
+                        if (left_count[i] == 0 || right_count[i] == 0)
+                            continue;
+                        float cost = left_count[i] * left_area[i] + right_count[i] * right_area[i];
+                        if (cost < best_cost)
+                        {
+                            best_cost = cost;
+                            best_axis = axis;
+                            best_split = i;
+                        }
+                    }
+                }
+
+                uint32_t mid;
+                if (best_axis < 0)
+                {
+                    // All centroids coincide, split in the middle to keep the leaves small.
+                    mid = p_first + p_count / 2;
+                }
+                else
+                {
+                    float leaf_cost = static_cast<float>(p_count);
+                    float split_cost = 1.0f + best_cost / node_bounds.HalfArea();
+                    if (split_cost >= leaf_cost && p_count <= max_sah_leaf_size)
+                        return;
+                    float scale = BIN_COUNT / (centroid_bounds.max[best_axis] - centroid_bounds.min[best_axis]);
+                    float axis_min = centroid_bounds.min[best_axis];
+                    auto it = std::partition(indices.begin() + p_first, indices.begin() + p_first + p_count,
+                        [&](uint32_t p_index) {
+                            uint32_t bin = std::min(BIN_COUNT - 1,
+                                static_cast<uint32_t>((centroids[p_index * 3 + best_axis] - axis_min) * scale));
+                            return bin <= best_split;
+                        });
+                    mid = static_cast<uint32_t>(it - indices.begin());
+                    if (mid == p_first || mid == p_first + p_count)
+                        mid = p_first + p_count / 2;
+                }
+
+                uint32_t left = next_node.fetch_add(2);
+                node.left_first = left;
+                node.count = 0;
+                uint32_t left_count = mid - p_first;
+                uint32_t right_count = p_count - left_count;
+                if (p_count > TriangleBVH::PARALLEL_BUILD_THRESHOLD)
+                {
+                    auto future = std::async(std::launch::async, [&, left, left_count]() {
+                        BuildRecursive(left, p_first, left_count, p_depth + 1);
+                    });
+                    BuildRecursive(left + 1, mid, right_count, p_depth + 1);
+                    future.get();
+                }
+                else
+                {
+                    BuildRecursive(left, p_first, left_count, p_depth + 1);
+                    BuildRecursive(left + 1, mid, right_count, p_depth + 1);
+                }
+            }
+        };
+
+        // Slab test of every lane of a packet against a node. Returns the mask of hit lanes.
+        FORCE_INLINE int PacketBox(const TriangleBVH::Node& p_node, const RayPacket& p_packet,
+            const float (&p_inv_dir)[3][RayPacket::SIZE], float* p_t_min) noexcept
+        {
+#ifdef CE_SIMD_SSE2
+            __m128 t_min = _mm_setzero_ps();
+            __m128 t_max = _mm_load_ps(p_packet.distance);
+            for (int i = 0; i < 3; ++i)
+            {
+                __m128 origin = _mm_load_ps(p_packet.origin[i]);
+                __m128 inv_dir = _mm_load_ps(p_inv_dir[i]);
+                __m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(p_node.min[i]), origin), inv_dir);
+                __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(p_node.max[i]), origin), inv_dir);
+                // The running value is the second operand so NaN lanes keep it.
+                t_min = _mm_max_ps(_mm_min_ps(t0, t1), t_min);
+                t_max = _mm_min_ps(_mm_max_ps(t0, t1), t_max);
+            }
+            _mm_storeu_ps(p_t_min, t_min);
+            return _mm_movemask_ps(_mm_cmple_ps(t_min, t_max));
+#else
+            int mask = 0;
+            for (size_t lane = 0; lane < RayPacket::SIZE; ++lane)
+            {
+                float t_min = 0.0f;
+                float t_max = p_packet.distance[lane];
+                for (int i = 0; i < 3; ++i)
+                {
+                    float t0 = (p_node.min[i] - p_packet.origin[i][lane]) * p_inv_dir[i][lane];
+                    float t1 = (p_node.max[i] - p_packet.origin[i][lane]) * p_inv_dir[i][lane];
+                    if (t0 > t1)
+                        std::swap(t0, t1);
+                    t_min = t0 > t_min ? t0 : t_min;
+                    t_max = t1 < t_max ? t1 : t_max;
+                }
+                p_t_min[lane] = t_min;
+                if (t_min <= t_max)
+                    mask |= 1 << lane;
+            }
+            return mask;
+#endif
+        }
+
+        // Moller-Trumbore of every lane of a packet against one triangle. Returns the mask of hit lanes.
+        FORCE_INLINE int PacketTriangle(const float* p_data, RayPacket& p_packet) noexcept
+        {
+#ifdef CE_SIMD_SSE2
+            __m128 e1[3], e2[3], d[3], s[3];
+            for (int i = 0; i < 3; ++i)
+            {
+                e1[i] = _mm_set1_ps(p_data[3 + i]);
+                e2[i] = _mm_set1_ps(p_data[6 + i]);
+                d[i] = _mm_load_ps(p_packet.direction[i]);
+                s[i] = _mm_sub_ps(_mm_load_ps(p_packet.origin[i]), _mm_set1_ps(p_data[i]));
+            }
+            auto cross = [](const __m128* a, const __m128* b, __m128* r) {
+                r[0] = _mm_sub_ps(_mm_mul_ps(a[1], b[2]), _mm_mul_ps(a[2], b[1]));
+                r[1] = _mm_sub_ps(_mm_mul_ps(a[2], b[0]), _mm_mul_ps(a[0], b[2]));
+                r[2] = _mm_sub_ps(_mm_mul_ps(a[0], b[1]), _mm_mul_ps(a[1], b[0]));
+            };
+            auto dot = [](const __m128* a, const __m128* b) {
+                return _mm_add_ps(_mm_add_ps(_mm_mul_ps(a[0], b[0]), _mm_mul_ps(a[1], b[1])), _mm_mul_ps(a[2], b[2]));
+            };
+            __m128 p[3], q[3];
+            cross(d, e2, p);
+            __m128 det = dot(e1, p);
+            __m128 abs_det = _mm_andnot_ps(_mm_set1_ps(-0.0f), det);
+            __m128 mask = _mm_cmpgt_ps(abs_det, _mm_set1_ps(1e-12f));
+            __m128 inv_det = _mm_div_ps(_mm_set1_ps(1.0f), det);
+            __m128 u = _mm_mul_ps(dot(s, p), inv_det);
+            cross(s, e1, q);
+            __m128 v = _mm_mul_ps(dot(d, q), inv_det);
+            __m128 t = _mm_mul_ps(dot(e2, q), inv_det);
+            __m128 zero = _mm_setzero_ps();
+            __m128 distance = _mm_load_ps(p_packet.distance);
+            mask = _mm_and_ps(mask, _mm_cmpge_ps(u, zero));
+            mask = _mm_and_ps(mask, _mm_cmpge_ps(v, zero));
+            mask = _mm_and_ps(mask, _mm_cmple_ps(_mm_add_ps(u, v), _mm_set1_ps(1.0f)));
+            mask = _mm_and_ps(mask, _mm_cmpge_ps(t, zero));
+            mask = _mm_and_ps(mask, _mm_cmplt_ps(t, distance));
+            int bits = _mm_movemask_ps(mask);
+            if (bits == 0)
+                return 0;
+            _mm_store_ps(p_packet.distance, _mm_or_ps(_mm_and_ps(mask, t), _mm_andnot_ps(mask, distance)));
+            _mm_store_ps(p_packet.u, _mm_or_ps(_mm_and_ps(mask, u), _mm_andnot_ps(mask, _mm_load_ps(p_packet.u))));
+            _mm_store_ps(p_packet.v, _mm_or_ps(_mm_and_ps(mask, v), _mm_andnot_ps(mask, _mm_load_ps(p_packet.v))));
+            return bits;
+#else
+            int bits = 0;
+            const float* e1 = p_data + 3;
+            const float* e2 = p_data + 6;
+            for (size_t lane = 0; lane < RayPacket::SIZE; ++lane)
+            {
+                float d[3] = {p_packet.direction[0][lane], p_packet.direction[1][lane], p_packet.direction[2][lane]};
+                float p[3] = {d[1] * e2[2] - d[2] * e2[1], d[2] * e2[0] - d[0] * e2[2], d[0] * e2[1] - d[1] * e2[0]};
+                float det = e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2];
+                if (std::abs(det) < 1e-12f)
+                    continue;
+                float inv_det = 1.0f / det;
+                float s[3] = {
+                    p_packet.origin[0][lane] - p_data[0],
+                    p_packet.origin[1][lane] - p_data[1],
+                    p_packet.origin[2][lane] - p_data[2]
+                };
+                float u = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) * inv_det;
+                float q[3] = {s[1] * e1[2] - s[2] * e1[1], s[2] * e1[0] - s[0] * e1[2], s[0] * e1[1] - s[1] * e1[0]};
+                float v = (d[0] * q[0] + d[1] * q[1] + d[2] * q[2]) * inv_det;
+                float t = (e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) * inv_det;
+                if (u < 0.0f || v < 0.0f || u + v > 1.0f || t < 0.0f || t >= p_packet.distance[lane])
+                    continue;
+                p_packet.distance[lane] = t;
+                p_packet.u[lane] = u;
+                p_packet.v[lane] = v;
+                bits |= 1 << lane;
+            }
+            return bits;
+#endif
+        }
+
+        void GetInverseDirection(const RayPacket& p_packet, float (&p_inv_dir)[3][RayPacket::SIZE]) noexcept
+        {
+            for (int i = 0; i < 3; ++i)
+            {
+                for (size_t lane = 0; lane < RayPacket::SIZE; ++lane)
+                    p_inv_dir[i][lane] = 1.0f / p_packet.direction[i][lane];
+            }
+        }
+
+        // Fill a packet with global rays. Lanes past the end of the batch are inactive.
+        template <typename Hit>
+        void LoadPacket(const Ray* p_rays, const Hit* p_hits, size_t p_count, const Math::Mat4* p_transform, RayPacket& p_packet)
+        {
+            for (size_t lane = 0; lane < RayPacket::SIZE; ++lane)
+            {
+                if (lane >= p_count)
+                {
+                    for (int i = 0; i < 3; ++i)
+                    {
+                        p_packet.origin[i][lane] = 0.0f;
+                        p_packet.direction[i][lane] = 1.0f;
+                    }
+                    p_packet.distance[lane] = -1.0f;
+                    continue;
+                }
+                Math::Vec4 origin(p_rays[lane].origin[0], p_rays[lane].origin[1], p_rays[lane].origin[2], 1.0f);
+                Math::Vec4 direction(p_rays[lane].direction[0], p_rays[lane].direction[1], p_rays[lane].direction[2], 0.0f);
+                if (p_transform != nullptr)
+                {
+                    origin = *p_transform * origin;
+                    direction = *p_transform * direction;
+                }
+                for (int i = 0; i < 3; ++i)
+                {
+                    p_packet.origin[i][lane] = origin[i];
+                    p_packet.direction[i][lane] = direction[i];
+                }
+                p_packet.distance[lane] = p_hits[lane].distance;
+                p_packet.u[lane] = 0.0f;
+                p_packet.v[lane] = 0.0f;
+                p_packet.triangle_index[lane] = 0;
+            }
+        }
+    }
+
+    TriangleBVH::TriangleBVH(const std::vector<Triangle*>& p_triangles)
+    {
+        Build(p_triangles);
+    }
+
+    TriangleBVH::TriangleBVH(const float* p_positions, size_t p_triangle_count)
+    {
+        Build(p_positions, p_triangle_count);
+    }
+
+    void TriangleBVH::Build(const std::vector<Triangle*>& p_triangles)
+    {
+        std::vector<float> positions(p_triangles.size() * 9);
+        for (size_t i = 0; i < p_triangles.size(); ++i)
+        {
+            for (int j = 0; j < 3; ++j)
+            {
+                const auto& position = p_triangles[i]->GetVertex(j)->GetPosition();
+                positions[i * 9 + j * 3] = position[0];
+                positions[i * 9 + j * 3 + 1] = position[1];
+                positions[i * 9 + j * 3 + 2] = position[2];
+            }
+        }
+        Build(positions.data(), p_triangles.size());
+    }
+
+    void TriangleBVH::Build(const float* p_positions, size_t p_triangle_count)
+    {
+        Clear();
+        if (p_triangle_count == 0)
+            return;
+
+        BVHBuilder builder(nodes, p_triangle_count, MAX_LEAF_SIZE, MAX_LEAF_SIZE * 4);
+        for (size_t i = 0; i < p_triangle_count; ++i)
+        {
+            const float* tri = p_positions + i * 9;
+            builder.bounds[i].Grow(tri);
+            builder.bounds[i].Grow(tri + 3);
+            builder.bounds[i].Grow(tri + 6);
+        }
+        builder.Build();
+
+        tri_data.resize(p_triangle_count * 9);
+        tri_indices = std::move(builder.indices);
+        for (size_t i = 0; i < p_triangle_count; ++i)
+        {
+            const float* tri = p_positions + static_cast<size_t>(tri_indices[i]) * 9;
+            float* data = tri_data.data() + i * 9;
+            for (int j = 0; j < 3; ++j)
+            {
+                data[j] = tri[j];
+                data[3 + j] = tri[3 + j] - tri[j];
+                data[6 + j] = tri[6 + j] - tri[j];
+            }
+        }
+    }
+
+    void TriangleBVH::Clear()
+    {
+        nodes.clear();
+        tri_data.clear();
+        tri_indices.clear();
+    }
+
+    void TriangleBVH::GetBounds(Math::Vec4& p_min, Math::Vec4& p_max) const
+    {
+        if (IsEmpty())
+            throw std::out_of_range("The BVH is empty.");
+        p_min = ToVec(nodes[0].min, 1.0f);
+        p_max = ToVec(nodes[0].max, 1.0f);
+    }
+
+    void TriangleBVH::GetTriangleVertices(uint32_t p_leaf_index, Math::Vec4& p_v0, Math::Vec4& p_v1, Math::Vec4& p_v2) const
+    {
+        const float* data = tri_data.data() + static_cast<size_t>(p_leaf_index) * 9;
+        p_v0 = Math::Vec4(data[0], data[1], data[2], 1.0f);
+        p_v1 = Math::Vec4(data[0] + data[3], data[1] + data[4], data[2] + data[5], 1.0f);
+        p_v2 = Math::Vec4(data[0] + data[6], data[1] + data[7], data[2] + data[8], 1.0f);
+    }
+
+    bool TriangleBVH::IntersectObjectSpace(const float* p_origin, const float* p_direction, RayHit& p_hit) const
+    {
+        float inv_dir[3];
+        for (int i = 0; i < 3; ++i)
+            inv_dir[i] = 1.0f / p_direction[i];
+        bool hit = false;
+        uint32_t stack[STACK_SIZE];
+        uint32_t stack_size = 0;
+        if (RayBox(nodes[0], p_origin, inv_dir, p_hit.distance) == INF)
+            return false;
+        stack[stack_size++] = 0;
+        while (stack_size > 0)
+        {
+            const Node& node = nodes[stack[--stack_size]];
+            if (node.IsLeaf())
+            {
+                for (uint32_t i = node.left_first; i < node.left_first + node.count; ++i)
+                {
+                    // Moller-Trumbore.
+                    const float* data = tri_data.data() + static_cast<size_t>(i) * 9;
+                    const float* e1 = data + 3;
+                    const float* e2 = data + 6;
+                    float p[3] = {
+                        p_direction[1] * e2[2] - p_direction[2] * e2[1],
+                        p_direction[2] * e2[0] - p_direction[0] * e2[2],
+                        p_direction[0] * e2[1] - p_direction[1] * e2[0]
+                    };
+                    float det = e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2];
+                    if (std::abs(det) < 1e-12f)
+                        continue;
+                    float inv_det = 1.0f / det;
+                    float s[3] = {p_origin[0] - data[0], p_origin[1] - data[1], p_origin[2] - data[2]};
+                    float u = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) * inv_det;
+                    if (u < 0.0f || u > 1.0f)
+                        continue;
+                    float q[3] = {
+                        s[1] * e1[2] - s[2] * e1[1],
+                        s[2] * e1[0] - s[0] * e1[2],
+                        s[0] * e1[1] - s[1] * e1[0]
+                    };
+                    float v = (p_direction[0] * q[0] + p_direction[1] * q[1] + p_direction[2] * q[2]) * inv_det;
+                    if (v < 0.0f || u + v > 1.0f)
+                        continue;
+                    float t = (e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) * inv_det;
+                    if (t >= 0.0f && t < p_hit.distance)
+                    {
+                        p_hit.distance = t;
+                        p_hit.u = u;
+                        p_hit.v = v;
+                        p_hit.triangle_index = tri_indices[i];
+                        hit = true;
+                    }
+                }
+                continue;
+            }
+            uint32_t near_index = node.left_first;
+            uint32_t far_index = node.left_first + 1;
+            float near_t = RayBox(nodes[near_index], p_origin, inv_dir, p_hit.distance);
+            float far_t = RayBox(nodes[far_index], p_origin, inv_dir, p_hit.distance);
+            if (far_t < near_t)
+            {
+                std::swap(near_index, far_index);
+                std::swap(near_t, far_t);
+            }
+            if (far_t != INF)
+                stack[stack_size++] = far_index;
+            if (near_t != INF)
+                stack[stack_size++] = near_index;
+        }
+        return hit;
+    }
+
+    bool TriangleBVH::Intersect(const Math::Vec4& p_origin, const Math::Vec4& p_direction, RayHit& p_hit, float p_max_distance) const
+    {
+        if (IsEmpty())
+            return false;
+        float origin[3] = {p_origin[0], p_origin[1], p_origin[2]};
+        float direction[3] = {p_direction[0], p_direction[1], p_direction[2]};
+        RayHit hit;
+        hit.distance = p_max_distance;
+        if (!IntersectObjectSpace(origin, direction, hit))
+            return false;
+        p_hit = hit;
+        return true;
+    }
+
+    bool TriangleBVH::Intersect(const Math::Mat4& p_subspace_matrix, const Math::Vec4& p_origin, const Math::Vec4& p_direction,
+        RayHit& p_hit, float p_max_distance) const
+    {
+        if (IsEmpty())
+            return false;
+        // An affine transform keeps the ray parameter, so the distance stays in global units.
+        Math::Mat4 inverse = Math::Inverse(p_subspace_matrix);
+        Math::Vec4 origin = inverse * Math::Vec4(p_origin[0], p_origin[1], p_origin[2], 1.0f);
+        Math::Vec4 direction = inverse * Math::Vec4(p_direction[0], p_direction[1], p_direction[2], 0.0f);
+        return Intersect(origin, direction, p_hit, p_max_distance);
+    }
+
+    bool TriangleBVH::GetClosestPosition(const Math::Vec4& p_point, ClosestHit& p_result, float p_max_distance) const
+    {
+        return GetClosestPosition(Math::Mat4(), p_point, p_result, p_max_distance);
+    }
+
+    bool TriangleBVH::GetClosestPosition(const Math::Mat4& p_subspace_matrix, const Math::Vec4& p_point, ClosestHit& p_result,
+        float p_max_distance) const
+    {
+        if (IsEmpty())
+            return false;
+        float min_scale, max_scale;
+        GetScaleRange(p_subspace_matrix, min_scale, max_scale);
+        Math::Mat4 inverse = Math::Inverse(p_subspace_matrix);
+        Math::Vec4 local = inverse * Math::Vec4(p_point[0], p_point[1], p_point[2], 1.0f);
+        float point[3] = {local[0], local[1], local[2]};
+        Math::Vec4 global_point = Math::Vec4(p_point[0], p_point[1], p_point[2], 1.0f);
+
+        // Object space distances are scaled by at least the minimum scale in global space.
+        float min_scale_squared = min_scale * min_scale;
+        float best = p_max_distance == INF ? INF : p_max_distance * p_max_distance;
+        bool found = false;
+        uint32_t stack[STACK_SIZE];
+        uint32_t stack_size = 0;
+        stack[stack_size++] = 0;
+        while (stack_size > 0)
+        {
+            const Node& node = nodes[stack[--stack_size]];
+            if (BoxDistanceSquared(node, point) * min_scale_squared > best)
+                continue;
+            if (node.IsLeaf())
+            {
+                for (uint32_t i = node.left_first; i < node.left_first + node.count; ++i)
+                {
+                    Math::Vec4 v0, v1, v2;
+                    GetTriangleVertices(i, v0, v1, v2);
+                    Math::Vec4 position = ClosestPositionOnTriangle(global_point,
+                        p_subspace_matrix * v0, p_subspace_matrix * v1, p_subspace_matrix * v2);
+                    float distance = (position - global_point).LengthSquared();
+                    if (distance <= best)
+                    {
+                        best = distance;
+                        p_result.position = position;
+                        p_result.distance_squared = distance;
+                        p_result.triangle_index = tri_indices[i];
+                        found = true;
+                    }
+                }
+                continue;
+            }
+            uint32_t near_index = node.left_first;
+            uint32_t far_index = node.left_first + 1;
+            if (BoxDistanceSquared(nodes[far_index], point) < BoxDistanceSquared(nodes[near_index], point))
+                std::swap(near_index, far_index);
+            stack[stack_size++] = far_index;
+            stack[stack_size++] = near_index;
+        }
+        return found;
+    }
+
+    size_t TriangleBVH::OverlapSphere(const Math::Vec4& p_center, float p_radius, std::vector<size_t>& p_result) const
+    {
+        return OverlapSphere(Math::Mat4(), p_center, p_radius, p_result);
+    }
+
+    size_t TriangleBVH::OverlapSphere(const Math::Mat4& p_subspace_matrix, const Math::Vec4& p_center, float p_radius,
+        std::vector<size_t>& p_result) const
+    {
+        if (IsEmpty() || p_radius < 0.0f)
+            return 0;
+        float min_scale, max_scale;
+        GetScaleRange(p_subspace_matrix, min_scale, max_scale);
+        Math::Mat4 inverse = Math::Inverse(p_subspace_matrix);
+        Math::Vec4 global_center = Math::Vec4(p_center[0], p_center[1], p_center[2], 1.0f);
+        Math::Vec4 local = inverse * global_center;
+        float center[3] = {local[0], local[1], local[2]};
+        float local_radius = p_radius / min_scale;
+        float local_radius_squared = local_radius * local_radius;
+        float radius_squared = p_radius * p_radius;
+
+        size_t count = 0;
+        uint32_t stack[STACK_SIZE];
+        uint32_t stack_size = 0;
+        stack[stack_size++] = 0;
+        while (stack_size > 0)
+        {
+            const Node& node = nodes[stack[--stack_size]];
+            if (BoxDistanceSquared(node, center) > local_radius_squared)
+                continue;
+            if (!node.IsLeaf())
+            {
+                stack[stack_size++] = node.left_first;
+                stack[stack_size++] = node.left_first + 1;
+                continue;
+            }
+            for (uint32_t i = node.left_first; i < node.left_first + node.count; ++i)
+            {
+                Math::Vec4 v0, v1, v2;
+                GetTriangleVertices(i, v0, v1, v2);
+                Math::Vec4 position = ClosestPositionOnTriangle(global_center,
+                    p_subspace_matrix * v0, p_subspace_matrix * v1, p_subspace_matrix * v2);
+                if ((position - global_center).LengthSquared() <= radius_squared)
+                {
+                    p_result.push_back(tri_indices[i]);
+                    ++count;
+                }
+            }
+        }
+        return count;
+    }
+
+    Math::Vec4 TriangleBVH::ClosestPositionOnTriangle(const Math::Vec4& p_point,
+        const Math::Vec4& p_v0, const Math::Vec4& p_v1, const Math::Vec4& p_v2)
+    {
+        // Voronoi region classification, see Ericson, Real-Time Collision Detection 5.1.5.
+        Math::Vec4 ab = p_v1 - p_v0;
+        Math::Vec4 ac = p_v2 - p_v0;
+        Math::Vec4 ap = p_point - p_v0;
+        ab[3] = ac[3] = ap[3] = 0.0f;
+        float d1 = ab.Dot(ap);
+        float d2 = ac.Dot(ap);
+        if (d1 <= 0.0f && d2 <= 0.0f)
+            return p_v0;
+
+        Math::Vec4 bp = p_point - p_v1;
+        bp[3] = 0.0f;
+        float d3 = ab.Dot(bp);
+        float d4 = ac.Dot(bp);
+        if (d3 >= 0.0f && d4 <= d3)
+            return p_v1;
+
+        float vc = d1 * d4 - d3 * d2;
+        if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+            return p_v0 + (d1 / (d1 - d3)) * ab;
+
+        Math::Vec4 cp = p_point - p_v2;
+        cp[3] = 0.0f;
+        float d5 = ab.Dot(cp);
+        float d6 = ac.Dot(cp);
+        if (d6 >= 0.0f && d5 <= d6)
+            return p_v2;
+
+        float vb = d5 * d2 - d1 * d6;
+        if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+            return p_v0 + (d2 / (d2 - d6)) * ac;
+
+        float va = d3 * d6 - d5 * d4;
+        if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+            return p_v1 + ((d4 - d3) / ((d4 - d3) + (d5 - d6))) * (p_v2 - p_v1);
+
+        float denom = 1.0f / (va + vb + vc);
+        return p_v0 + (vb * denom) * ab + (vc * denom) * ac;
+    }
+
+    uint32_t TriangleBVH::Intersect(RayPacket& p_packet) const
+    {
+        if (IsEmpty())
+            return 0;
+        alignas(16) float inv_dir[3][RayPacket::SIZE];
+        GetInverseDirection(p_packet, inv_dir);
+        alignas(16) float t_min[RayPacket::SIZE];
+        if (PacketBox(nodes[0], p_packet, inv_dir, t_min) == 0)
+            return 0;
+
+        uint32_t result = 0;
+        uint32_t stack[STACK_SIZE];
+        uint32_t stack_size = 0;
+        stack[stack_size++] = 0;
+        while (stack_size > 0)
+        {
+            const Node& node = nodes[stack[--stack_size]];
+            if (node.IsLeaf())
+            {
+                for (uint32_t i = node.left_first; i < node.left_first + node.count; ++i)
+                {
+                    int bits = PacketTriangle(tri_data.data() + static_cast<size_t>(i) * 9, p_packet);
+                    for (size_t lane = 0; lane < RayPacket::SIZE; ++lane)
+                    {
+                        if (bits & (1 << lane))
+                            p_packet.triangle_index[lane] = tri_indices[i];
+                    }
+                    result |= bits;
+                }
+                continue;
+            }
+            // The packet is coherent, so the children are ordered by the nearest lane.
+            alignas(16) float near_t_min[RayPacket::SIZE];
+            alignas(16) float far_t_min[RayPacket::SIZE];
+            uint32_t near_index = node.left_first;
+            uint32_t far_index = node.left_first + 1;
+            int near_mask = PacketBox(nodes[near_index], p_packet, inv_dir, near_t_min);
+            int far_mask = PacketBox(nodes[far_index], p_packet, inv_dir, far_t_min);
+            float near_t = INF, far_t = INF;
+            for (size_t lane = 0; lane < RayPacket::SIZE; ++lane)
+            {
+                if (near_mask & (1 << lane))
+                    near_t = std::min(near_t, near_t_min[lane]);
+                if (far_mask & (1 << lane))
+                    far_t = std::min(far_t, far_t_min[lane]);
+            }
+            if (far_t < near_t)
+            {
+                std::swap(near_index, far_index);
+                std::swap(near_mask, far_mask);
+            }
+            if (far_mask != 0)
+                stack[stack_size++] = far_index;
+            if (near_mask != 0)
+                stack[stack_size++] = near_index;
+        }
+        return result;
+    }
+
+    size_t TriangleBVH::Intersect(const Math::Mat4& p_subspace_matrix, const Ray* p_rays, RayHit* p_hits, size_t p_count) const
+    {
+        if (IsEmpty())
+            return 0;
+        Math::Mat4 inverse = Math::Inverse(p_subspace_matrix);
+        size_t result = 0;
+        RayPacket packet;
+        for (size_t first = 0; first < p_count; first += RayPacket::SIZE)
+        {
+            size_t count = std::min(RayPacket::SIZE, p_count - first);
+            LoadPacket(p_rays + first, p_hits + first, count, &inverse, packet);
+            uint32_t bits = Intersect(packet);
+            for (size_t lane = 0; lane < count; ++lane)
+            {
+                if (!(bits & (1 << lane)))
+                    continue;
+                RayHit& hit = p_hits[first + lane];
+                hit.distance = packet.distance[lane];
+                hit.u = packet.u[lane];
+                hit.v = packet.v[lane];
+                hit.triangle_index = packet.triangle_index[lane];
+                ++result;
+            }
+        }
+        return result;
+    }
+
+    void InstanceBVH::UpdateInstanceBounds(Instance& p_instance)
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            p_instance.min[i] = INF;
+            p_instance.max[i] = -INF;
+        }
+        if (p_instance.bvh == nullptr || p_instance.bvh->IsEmpty())
+            return;
+        try
+        {
+            p_instance.subspace_matrix_inverse = Math::Inverse(p_instance.subspace_matrix);
+        }
+        catch (const std::domain_error&)
+        {
+            // A degenerated instance has no volume and can never be hit.
+            return;
+        }
+        const Node& root = p_instance.bvh->GetNodes()[0];
+        for (int corner = 0; corner < 8; ++corner)
+        {
+            Math::Vec4 position = p_instance.subspace_matrix * Math::Vec4(
+                (corner & 1) ? root.max[0] : root.min[0],
+                (corner & 2) ? root.max[1] : root.min[1],
+                (corner & 4) ? root.max[2] : root.min[2], 1.0f);
+            for (int i = 0; i < 3; ++i)
+            {
+                p_instance.min[i] = std::min(p_instance.min[i], position[i]);
+                p_instance.max[i] = std::max(p_instance.max[i], position[i]);
+            }
+        }
+    }
+
+    void InstanceBVH::Build(const std::vector<std::shared_ptr<const TriangleBVH>>& p_bvhs,
+        const std::vector<Math::Mat4>& p_subspace_matrices)
+    {
+        if (p_bvhs.size() != p_subspace_matrices.size())
+            throw std::invalid_argument("The count of BVHs does not match the count of subspace matrices.");
+        Clear();
+        if (p_bvhs.empty())
+            return;
+        instances.resize(p_bvhs.size());
+        BVHBuilder builder(nodes, p_bvhs.size(), 1, 1);
+        for (size_t i = 0; i < p_bvhs.size(); ++i)
+        {
+            instances[i].bvh = p_bvhs[i];
+            instances[i].subspace_matrix = p_subspace_matrices[i];
+            UpdateInstanceBounds(instances[i]);
+            if (instances[i].min[0] <= instances[i].max[0])
+            {
+                builder.bounds[i].Grow(instances[i].min);
+                builder.bounds[i].Grow(instances[i].max);
+            }
+            else
+            {
+                // Keep empty instances in the hierarchy so they can be refit later.
+                float origin[3] = {0.0f, 0.0f, 0.0f};
+                builder.bounds[i].Grow(origin);
+            }
+        }
+        builder.Build();
+        instance_indices = std::move(builder.indices);
+        Refit();
+    }
+
+    void InstanceBVH::Clear()
+    {
+        nodes.clear();
+        instances.clear();
+        instance_indices.clear();
+        refit_needed = false;
+    }
+
+    void InstanceBVH::SetSubspaceMatrix(size_t p_index, const Math::Mat4& p_subspace_matrix)
+    {
+        Instance& instance = instances.at(p_index);
+        instance.subspace_matrix = p_subspace_matrix;
+        UpdateInstanceBounds(instance);
+        refit_needed = true;
+    }
+
+    void InstanceBVH::Refit()
+    {
+        // Children are always allocated after their parent.
+        for (size_t i = nodes.size(); i-- > 0;)
+        {
+            Node& node = nodes[i];
+            AABB box;
+            if (node.IsLeaf())
+            {
+                for (uint32_t j = node.left_first; j < node.left_first + node.count; ++j)
+                {
+                    const Instance& instance = instances[instance_indices[j]];
+                    box.Grow(instance.min);
+                    box.Grow(instance.max);
+                }
+            }
+            else
+            {
+                box.Grow(nodes[node.left_first].min);
+                box.Grow(nodes[node.left_first].max);
+                box.Grow(nodes[node.left_first + 1].min);
+                box.Grow(nodes[node.left_first + 1].max);
+            }
+            for (int j = 0; j < 3; ++j)
+            {
+                node.min[j] = box.min[j];
+                node.max[j] = box.max[j];
+            }
+        }
+        refit_needed = false;
+    }
+
+    bool InstanceBVH::Intersect(const Math::Vec4& p_origin, const Math::Vec4& p_direction, InstanceHit& p_hit, float p_max_distance) const
+    {
+        InstanceHit hit;
+        hit.distance = p_max_distance;
+        Ray ray{p_origin, p_direction};
+        if (Intersect(&ray, &hit, 1) == 0)
+            return false;
+        p_hit = hit;
+        return true;
+    }
+
+    size_t InstanceBVH::IntersectAll(const Math::Vec4& p_origin, const Math::Vec4& p_direction, std::vector<InstanceHit>& p_hits,
+        float p_max_distance) const
+    {
+        if (refit_needed)
+            throw std::logic_error("The instance BVH needs to be refit before querying.");
+        if (nodes.empty())
+            return 0;
+        float origin[3] = {p_origin[0], p_origin[1], p_origin[2]};
+        float inv_dir[3] = {1.0f / p_direction[0], 1.0f / p_direction[1], 1.0f / p_direction[2]};
+        Math::Vec4 global_origin(p_origin[0], p_origin[1], p_origin[2], 1.0f);
+        Math::Vec4 global_direction(p_direction[0], p_direction[1], p_direction[2], 0.0f);
+        size_t first_hit = p_hits.size();
+
+        uint32_t stack[STACK_SIZE];
+        uint32_t stack_size = 0;
+        stack[stack_size++] = 0;
+        while (stack_size > 0)
+        {
+            const Node& node = nodes[stack[--stack_size]];
+            if (RayBox(node, origin, inv_dir, p_max_distance) == INF)
+                continue;
+            if (!node.IsLeaf())
+            {
+                stack[stack_size++] = node.left_first;
+                stack[stack_size++] = node.left_first + 1;
+                continue;
+            }
+            for (uint32_t i = node.left_first; i < node.left_first + node.count; ++i)
+            {
+                uint32_t index = instance_indices[i];
+                const Instance& instance = instances[index];
+                if (instance.min[0] > instance.max[0])
+                    continue;
+                InstanceHit hit;
+                if (instance.bvh->Intersect(instance.subspace_matrix_inverse * global_origin,
+                    instance.subspace_matrix_inverse * global_direction, hit, p_max_distance))
+                {
+                    hit.instance_index = index;
+                    p_hits.push_back(hit);
+                }
+            }
+        }
+        std::sort(p_hits.begin() + first_hit, p_hits.end(), [](const InstanceHit& p_a, const InstanceHit& p_b) {
+            return p_a.distance < p_b.distance;
+        });
+        return p_hits.size() - first_hit;
+    }
+
+    void InstanceBVH::TransformPacket(const Instance& p_instance, const RayPacket& p_packet, RayPacket& p_result) const
+    {
+        const Math::Mat4& m = p_instance.subspace_matrix_inverse;
+        for (size_t lane = 0; lane < RayPacket::SIZE; ++lane)
+        {
+            for (size_t i = 0; i < 3; ++i)
+            {
+                p_result.origin[i][lane] = m(i * 4) * p_packet.origin[0][lane] + m(i * 4 + 1) * p_packet.origin[1][lane]
+                    + m(i * 4 + 2) * p_packet.origin[2][lane] + m(i * 4 + 3);
+                p_result.direction[i][lane] = m(i * 4) * p_packet.direction[0][lane] + m(i * 4 + 1) * p_packet.direction[1][lane]
+                    + m(i * 4 + 2) * p_packet.direction[2][lane];
+            }
+            p_result.distance[lane] = p_packet.distance[lane];
+        }
+    }
+
+    size_t InstanceBVH::Intersect(const Ray* p_rays, InstanceHit* p_hits, size_t p_count) const
+    {
+        if (refit_needed)
+            throw std::logic_error("The instance BVH needs to be refit before querying.");
+        if (nodes.empty())
+            return 0;
+        size_t result = 0;
+        RayPacket packet, local_packet;
+        uint32_t instance_hit[RayPacket::SIZE];
+        for (size_t first = 0; first < p_count; first += RayPacket::SIZE)
+        {
+            size_t count = std::min(RayPacket::SIZE, p_count - first);
+            LoadPacket(p_rays + first, p_hits + first, count, nullptr, packet);
+            alignas(16) float inv_dir[3][RayPacket::SIZE];
+            GetInverseDirection(packet, inv_dir);
+            uint32_t bits = 0;
+
+            uint32_t stack[STACK_SIZE];
+            uint32_t stack_size = 0;
+            stack[stack_size++] = 0;
+            while (stack_size > 0)
+            {
+                const Node& node = nodes[stack[--stack_size]];
+                alignas(16) float t_min[RayPacket::SIZE];
+                if (PacketBox(node, packet, inv_dir, t_min) == 0)
+                    continue;
+                if (!node.IsLeaf())
+                {
+                    stack[stack_size++] = node.left_first + 1;
+                    stack[stack_size++] = node.left_first;
+                    continue;
+                }
+                for (uint32_t i = node.left_first; i < node.left_first + node.count; ++i)
+                {
+                    uint32_t index = instance_indices[i];
+                    const Instance& instance = instances[index];
+                    if (instance.min[0] > instance.max[0])
+                        continue;
+                    TransformPacket(instance, packet, local_packet);
+                    uint32_t local_bits = instance.bvh->Intersect(local_packet);
+                    for (size_t lane = 0; lane < RayPacket::SIZE; ++lane)
+                    {
+                        if (!(local_bits & (1 << lane)))
+                            continue;
+                        packet.distance[lane] = local_packet.distance[lane];
+                        packet.u[lane] = local_packet.u[lane];
+                        packet.v[lane] = local_packet.v[lane];
+                        packet.triangle_index[lane] = local_packet.triangle_index[lane];
+                        instance_hit[lane] = index;
+                    }
+                    bits |= local_bits;
+                }
+            }
+
+            for (size_t lane = 0; lane < count; ++lane)
+            {
+                if (!(bits & (1 << lane)))
+                    continue;
+                InstanceHit& hit = p_hits[first + lane];
+                hit.distance = packet.distance[lane];
+                hit.u = packet.u[lane];
+                hit.v = packet.v[lane];
+                hit.triangle_index = packet.triangle_index[lane];
+                hit.instance_index = instance_hit[lane];
+                ++result;
+            }
+        }
+        return result;
+    }
+}
@@ -0,0 +1,61 @@
+#include "ce/geometry/geometry_arena.h"
+#include <new>
+#include <algorithm>
+
+namespace CrossEngine
+{
+    namespace
+    {
+        constexpr size_t AlignUp(size_t p_size, size_t p_alignment)
+        {
+            return (p_size + p_alignment - 1) / p_alignment * p_alignment;
+        }
+    }
+
+    GeometryArena::GeometryArena(size_t p_block_size)
+        : block_size(p_block_size)
+    {
+    }
+
+    GeometryArena::~GeometryArena()
+    {
+        // The triangles only own memory of the arena, so their destructors are skipped.
+        for (auto& block : blocks)
+            ::operator delete(block.data, std::align_val_t(ALIGNMENT));
+    }
+
+    void GeometryArena::AddBlock(size_t p_size)
+    {
+        blocks.push_back({static_cast<std::byte*>(::operator new(p_size, std::align_val_t(ALIGNMENT))), p_size});
+        offset = 0;
+        reserved_bytes += p_size;
+    }
+
+    void* GeometryArena::Allocate(size_t p_size)
+    {
+        p_size = AlignUp(p_size, ALIGNMENT);
+        if (blocks.empty() || offset + p_size > blocks.back().size)
+            AddBlock(std::max(block_size, p_size));
+        void* result = blocks.back().data + offset;
+        offset += p_size;
+        used_bytes += p_size;
+        return result;
+    }
+
+    Triangle* GeometryArena::CreateTriangle()
+    {
+        return CreateTriangle(Vertex(), Vertex(), Vertex());
+    }
+
+    Triangle* GeometryArena::CreateTriangle(const Vertex& p_v1, const Vertex& p_v2, const Vertex& p_v3)
+    {
+        Vertex* v1 = ::new (Allocate(sizeof(Vertex))) Vertex(p_v1);
+        Vertex* v2 = ::new (Allocate(sizeof(Vertex))) Vertex(p_v2);
+        Vertex* v3 = ::new (Allocate(sizeof(Vertex))) Vertex(p_v3);
+        v1->InsertNext(v2);
+        v2->InsertNext(v3);
+        v3->InsertNext(v1);
+        ++triangle_count;
+        return ::new (Allocate(sizeof(Triangle))) Triangle(std::move(v1), std::move(v2), std::move(v3));
+    }
+}
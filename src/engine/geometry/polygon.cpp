@@ -1,7 +1,18 @@
 #include "ce/geometry/polygon.h"
+#include "ce/geometry/geometry_arena.h"
 
 namespace CrossEngine
 {
+    namespace
+    {
+        Triangle* CreateTriangle(GeometryArena* p_arena, const Vertex& p_v1, const Vertex& p_v2, const Vertex& p_v3)
+        {
+            if (p_arena != nullptr)
+                return p_arena->CreateTriangle(p_v1, p_v2, p_v3);
+            return new Triangle(p_v1, p_v2, p_v3);
+        }
+    }
+
     PolygonN::PolygonN()
     {
     }
@@ -37,13 +48,13 @@ namespace CrossEngine
         vertices[p_index - 1]->InsertNext(p_vertex);
     }
 
-    void PolygonN::Triangulate(std::vector<Triangle*>& p_triangles) const
+    void PolygonN::Triangulate(std::vector<Triangle*>& p_triangles, GeometryArena* p_arena) const
     {
         if (vertices.size() < 3)
             throw std::runtime_error("Cannot triangulate a PolygonN with less than 3 vertices");
         if (vertices.size() == 3)
         {
-            p_triangles.push_back(new Triangle(*(vertices[0]), *(vertices[1]), *(vertices[2])));
+            p_triangles.push_back(CreateTriangle(p_arena, *(vertices[0]), *(vertices[1]), *(vertices[2])));
             return;
         }
         auto current_vertex = vertices[0];
@@ -52,13 +63,13 @@ namespace CrossEngine
         {
             if (/*current_vertex->IsEar()*/ true)
             {
-                p_triangles.push_back(new Triangle(*(current_vertex->GetPrev()), *current_vertex, *(current_vertex->GetNext())));
+                p_triangles.push_back(CreateTriangle(p_arena, *(current_vertex->GetPrev()), *current_vertex, *(current_vertex->GetNext())));
                 auto temp = current_vertex->GetNext();
                 current_vertex->GetPrev()->RemoveNext();
                 current_vertex = temp;
             }
             current_vertex = current_vertex->GetNext();
         }
-        p_triangles.push_back(new Triangle(*(current_vertex->GetPrev()), *current_vertex, *(current_vertex->GetNext())));
+        p_triangles.push_back(CreateTriangle(p_arena, *(current_vertex->GetPrev()), *current_vertex, *(current_vertex->GetNext())));
     }
 }
\ No newline at end of file
@@ -0,0 +1,369 @@
+#include "ce/graphics/buffer_arena.h"
+#include <glad/glad.h>
+#include <stdexcept>
+#include <algorithm>
+#include <bit>
+
+namespace CrossEngine
+{
+    unsigned int GLBufferBackend::CreateBuffer(size_t p_size)
+    {
+        unsigned int buffer;
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        glBufferData(GL_ARRAY_BUFFER, p_size, nullptr, GL_STATIC_DRAW);
+        return buffer;
+    }
+
+    void GLBufferBackend::DeleteBuffer(unsigned int p_buffer)
+    {
+        glDeleteBuffers(1, &p_buffer);
+    }
+
+    void GLBufferBackend::UploadBuffer(unsigned int p_buffer, size_t p_offset, size_t p_size, const void* p_data)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, p_buffer);
+        glBufferSubData(GL_ARRAY_BUFFER, p_offset, p_size, p_data);
+    }
+
+    void GLBufferBackend::CopyBuffer(unsigned int p_buffer, size_t p_src_offset, size_t p_dst_offset, size_t p_size)
+    {
+        glBindBuffer(GL_COPY_READ_BUFFER, p_buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, p_buffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, p_src_offset, p_dst_offset, p_size);
+    }
+
+    void GLBufferBackend::Flush()
+    {
+        glFlush();
+    }
+
+    void* GLBufferBackend::CreateFence()
+    {
+        return glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    bool GLBufferBackend::IsFenceSignaled(void* p_fence)
+    {
+        GLenum result = glClientWaitSync(static_cast<GLsync>(p_fence), 0, 0);
+        return result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED;
+    }
+
+    void GLBufferBackend::DeleteFence(void* p_fence)
+    {
+        glDeleteSync(static_cast<GLsync>(p_fence));
+    }
+
+    BufferArena::BufferArena(std::unique_ptr<IBufferBackend> p_backend, size_t p_page_size, size_t p_granularity)
+        : backend(std::move(p_backend)), class_pages(TLSFAllocator::CLASS_COUNT), page_size(p_page_size),
+        granularity(p_granularity)
+    {
+        if (p_granularity == 0)
+            throw std::invalid_argument("The granularity must not be 0.");
+    }
+
+    BufferArena::~BufferArena()
+    {
+        for (auto& pending : pending_moves)
+            backend->DeleteFence(pending.fence);
+        for (auto& allocation : allocations)
+        {
+            if (allocation.upload_fence != nullptr)
+                backend->DeleteFence(allocation.upload_fence);
+        }
+        for (auto& page : pages)
+            backend->DeleteBuffer(page->buffer);
+    }
+
+    void BufferArena::SetOwner(uint32_t p_page, uint32_t p_block, Handle p_handle)
+    {
+        auto& owners = pages[p_page]->owners;
+        if (owners.size() <= p_block)
+            owners.resize(p_block + 1, INVALID_HANDLE);
+        owners[p_block] = p_handle;
+    }
+
+    void BufferArena::UpdatePageClass(uint32_t p_page)
+    {
+        auto& page = *pages[p_page];
+        uint32_t free_class = page.allocator.GetLargestFreeClass();
+        if (free_class == page.free_class)
+            return;
+        if (page.free_class != TLSFAllocator::INVALID_CLASS)
+        {
+            auto& old_pages = class_pages[page.free_class];
+            uint32_t last = old_pages.back();
+            old_pages[page.class_position] = last;
+            pages[last]->class_position = page.class_position;
+            old_pages.pop_back();
+            if (old_pages.empty())
+            {
+                size_t word = page.free_class / 64;
+                class_bitmaps[word] &= ~((uint64_t)1 << (page.free_class % 64));
+                if (class_bitmaps[word] == 0)
+                    class_word_bitmap &= ~((uint32_t)1 << word);
+            }
+        }
+        page.free_class = free_class;
+        if (free_class != TLSFAllocator::INVALID_CLASS)
+        {
+            auto& new_pages = class_pages[free_class];
+            page.class_position = (uint32_t)new_pages.size();
+            new_pages.push_back(p_page);
+            class_bitmaps[free_class / 64] |= (uint64_t)1 << (free_class % 64);
+            class_word_bitmap |= (uint32_t)1 << (free_class / 64);
+        }
+    }
+
+    uint32_t BufferArena::FindPage(size_t p_size) const
+    {
+        if (pages.empty())
+            return INVALID_PAGE;
+        // Every page has the same granularity, so any allocator gives the class.
+        uint32_t size_class = pages.front()->allocator.GetAllocationClass(p_size);
+        if (size_class == TLSFAllocator::INVALID_CLASS)
+            return INVALID_PAGE;
+        // The first class at least as large as the size class that has pages.
+        size_t word = size_class / 64;
+        uint64_t bits = class_bitmaps[word] & (~(uint64_t)0 << (size_class % 64));
+        if (bits == 0)
+        {
+            uint32_t words = word + 1 < CLASS_WORD_COUNT ? class_word_bitmap & (~(uint32_t)0 << (word + 1)) : 0;
+            if (words == 0)
+                return INVALID_PAGE;
+            word = std::countr_zero(words);
+            bits = class_bitmaps[word];
+        }
+        return class_pages[word * 64 + std::countr_zero(bits)].back();
+    }
+
+    BufferArena::Handle BufferArena::Allocate(size_t p_size)
+    {
+        std::lock_guard<std::mutex> lock(arena_mutex);
+        Allocation allocation;
+        allocation.page = FindPage(p_size);
+        if (allocation.page == INVALID_PAGE)
+        {
+            // Ranges larger than a page get a buffer of their own.
+            size_t size = std::max(page_size, (p_size + granularity - 1) / granularity * granularity);
+            pages.push_back(std::make_unique<Page>(backend->CreateBuffer(size), size, granularity));
+            allocation.page = (uint32_t)(pages.size() - 1);
+        }
+        allocation.block = pages[allocation.page]->allocator.Allocate(p_size);
+        UpdatePageClass(allocation.page);
+
+        Handle handle;
+        if (!unused_handles.empty())
+        {
+            handle = unused_handles.back();
+            unused_handles.pop_back();
+            allocations[handle] = allocation;
+        }
+        else
+        {
+            handle = (Handle)allocations.size();
+            allocations.push_back(allocation);
+        }
+        SetOwner(allocation.page, allocation.block, handle);
+        return handle;
+    }
+
+    void BufferArena::Free(Handle p_handle)
+    {
+        std::lock_guard<std::mutex> lock(arena_mutex);
+        if (p_handle >= allocations.size() || allocations[p_handle].block == TLSFAllocator::INVALID_BLOCK)
+            throw std::invalid_argument("The handle is not allocated.");
+        CancelMove(p_handle);
+        auto& allocation = allocations[p_handle];
+        if (allocation.upload_fence != nullptr)
+        {
+            backend->DeleteFence(allocation.upload_fence);
+            allocation.upload_fence = nullptr;
+        }
+        pages[allocation.page]->owners[allocation.block] = INVALID_HANDLE;
+        pending_frees.push_back({allocation.page, allocation.block, epoch});
+        allocation.block = TLSFAllocator::INVALID_BLOCK;
+        unused_handles.push_back(p_handle);
+    }
+
+    void BufferArena::Upload(Handle p_handle, const void* p_data, size_t p_size)
+    {
+        std::lock_guard<std::mutex> lock(arena_mutex);
+        auto& allocation = allocations.at(p_handle);
+        const auto& page = *pages[allocation.page];
+        if (p_size > page.allocator.GetSize(allocation.block))
+            throw std::out_of_range("The data is larger than the range.");
+        // The copy of a moving range would miss the new data.
+        CancelMove(p_handle);
+        backend->UploadBuffer(page.buffer, page.allocator.GetOffset(allocation.block), p_size, p_data);
+        // Defragment may run on another context, which only sees the fence after the flush.
+        if (allocation.upload_fence != nullptr)
+            backend->DeleteFence(allocation.upload_fence);
+        allocation.upload_fence = backend->CreateFence();
+        backend->Flush();
+    }
+
+    unsigned int BufferArena::GetBuffer(Handle p_handle) const
+    {
+        std::lock_guard<std::mutex> lock(arena_mutex);
+        return pages[allocations.at(p_handle).page]->buffer;
+    }
+
+    size_t BufferArena::GetOffset(Handle p_handle) const
+    {
+        std::lock_guard<std::mutex> lock(arena_mutex);
+        const auto& allocation = allocations.at(p_handle);
+        return pages[allocation.page]->allocator.GetOffset(allocation.block);
+    }
+
+    void BufferArena::CancelMove(Handle p_handle)
+    {
+        // The block the range was copied to is released when the fence of the copy is signaled.
+        allocations[p_handle].moving_block = TLSFAllocator::INVALID_BLOCK;
+    }
+
+    void BufferArena::PublishMoves()
+    {
+        std::erase_if(pending_moves, [this](const PendingMoves& p_pending)
+        {
+            if (!backend->IsFenceSignaled(p_pending.fence))
+                return false;
+            backend->DeleteFence(p_pending.fence);
+            for (const auto& move : p_pending.moves)
+            {
+                auto& allocation = allocations[move.handle];
+                if (allocation.moving_block != move.block || allocation.page != move.page)
+                {
+                    // The range was freed or written while it was copied.
+                    pages[move.page]->allocator.Free(move.block);
+                    UpdatePageClass(move.page);
+                    continue;
+                }
+                pages[move.page]->owners[allocation.block] = INVALID_HANDLE;
+                pending_frees.push_back({move.page, allocation.block, epoch});
+                allocation.block = move.block;
+                allocation.moving_block = TLSFAllocator::INVALID_BLOCK;
+                SetOwner(move.page, move.block, move.handle);
+                UpdatePageClass(move.page);
+            }
+            return true;
+        });
+    }
+
+    size_t BufferArena::Defragment(size_t p_max_bytes)
+    {
+        std::lock_guard<std::mutex> lock(arena_mutex);
+        PublishMoves();
+        size_t moved = 0;
+        std::vector<PendingMove> moves;
+        for (uint32_t i = 0; i < pages.size() && moved < p_max_bytes; ++i)
+        {
+            auto& page = *pages[i];
+            // With the free range at the end reserved, every free range is before the ranges to move.
+            uint32_t tail = page.allocator.AllocateLast();
+            uint32_t block = tail != TLSFAllocator::INVALID_BLOCK ?
+                page.allocator.GetPreviousBlock(tail) : page.allocator.GetLastAllocatedBlock();
+            while (block != TLSFAllocator::INVALID_BLOCK && moved < p_max_bytes)
+            {
+                // Skip the ranges that are waiting to be reused or being copied.
+                if (page.allocator.IsFree(block) || page.owners[block] == INVALID_HANDLE
+                    || allocations[page.owners[block]].moving_block != TLSFAllocator::INVALID_BLOCK)
+                {
+                    block = page.allocator.GetPreviousBlock(block);
+                    continue;
+                }
+                // Skip the ranges whose last upload has not completed, so the copy does not read stale data.
+                auto& allocation = allocations[page.owners[block]];
+                if (allocation.upload_fence != nullptr)
+                {
+                    if (!backend->IsFenceSignaled(allocation.upload_fence))
+                    {
+                        block = page.allocator.GetPreviousBlock(block);
+                        continue;
+                    }
+                    backend->DeleteFence(allocation.upload_fence);
+                    allocation.upload_fence = nullptr;
+                }
+                size_t size = page.allocator.GetSize(block);
+                uint32_t new_block = page.allocator.Allocate(size);
+                if (new_block == TLSFAllocator::INVALID_BLOCK)
+                    break;
+                if (page.allocator.GetOffset(new_block) > page.allocator.GetOffset(block))
+                {
+                    page.allocator.Free(new_block);
+                    break;
+                }
+                backend->CopyBuffer(page.buffer, page.allocator.GetOffset(block), page.allocator.GetOffset(new_block), size);
+                Handle handle = page.owners[block];
+                allocation.moving_block = new_block;
+                SetOwner(i, new_block, INVALID_HANDLE);
+                moves.push_back({handle, i, new_block});
+                moved += size;
+                block = page.allocator.GetPreviousBlock(block);
+            }
+            if (tail != TLSFAllocator::INVALID_BLOCK)
+                page.allocator.Free(tail);
+            UpdatePageClass(i);
+        }
+        if (!moves.empty())
+        {
+            pending_moves.push_back({backend->CreateFence(), std::move(moves)});
+            backend->Flush();
+        }
+        return moved;
+    }
+
+    void BufferArena::ReleasePendingFrees()
+    {
+        // Every context has finished at least one whole frame since the range was freed.
+        std::erase_if(pending_frees, [this](const PendingFree& p_pending)
+        {
+            if (p_pending.epoch + 2 > epoch)
+                return false;
+            pages[p_pending.page]->allocator.Free(p_pending.block);
+            UpdatePageClass(p_pending.page);
+            return true;
+        });
+    }
+
+    void BufferArena::EndFrame(const void* p_context)
+    {
+        std::lock_guard<std::mutex> lock(arena_mutex);
+        contexts.insert(p_context);
+        finished_contexts.insert(p_context);
+        if (finished_contexts.size() == contexts.size())
+        {
+            ++epoch;
+            finished_contexts.clear();
+            ReleasePendingFrees();
+        }
+    }
+
+    void BufferArena::RemoveContext(const void* p_context)
+    {
+        std::lock_guard<std::mutex> lock(arena_mutex);
+        contexts.erase(p_context);
+        finished_contexts.erase(p_context);
+        if (!contexts.empty() && finished_contexts.size() == contexts.size())
+        {
+            ++epoch;
+            finished_contexts.clear();
+            ReleasePendingFrees();
+        }
+    }
+
+    size_t BufferArena::GetPageCount() const
+    {
+        std::lock_guard<std::mutex> lock(arena_mutex);
+        return pages.size();
+    }
+
+    size_t BufferArena::GetFreeSize() const
+    {
+        std::lock_guard<std::mutex> lock(arena_mutex);
+        size_t result = 0;
+        for (auto& page : pages)
+            result += page->allocator.GetFreeSize();
+        return result;
+    }
+}
@@ -0,0 +1,52 @@
+#include "ce/graphics/gpu_resource_registry.h"
+
+namespace CrossEngine
+{
+    GPUResourceRegistry::Handle GPUResourceRegistry::Register(unsigned int p_id, ReleaseFunction p_release_func)
+    {
+        Handle handle;
+        handle.id = p_id;
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        handle.slot = resources.Insert(Resource{p_id, p_release_func});
+        return handle;
+    }
+
+    void GPUResourceRegistry::Free(const Handle& p_handle)
+    {
+        if (p_handle.IsValid())
+            free_queue.Push(p_handle.slot);
+    }
+
+    size_t GPUResourceRegistry::ReleaseFreed()
+    {
+        size_t count = 0;
+        SlotHandle slot;
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        while (free_queue.Pop(slot))
+        {
+            auto resource = resources.Get(slot);
+            // The handle was freed more than once.
+            if (resource == nullptr)
+                continue;
+            resource->release_func(1, &resource->id);
+            resources.Remove(slot);
+            ++count;
+        }
+        return count;
+    }
+
+    void GPUResourceRegistry::ReleaseAll()
+    {
+        SlotHandle slot;
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        while (free_queue.Pop(slot));
+        resources.ForEach([](Resource& p_resource){ p_resource.release_func(1, &p_resource.id); });
+        resources.Clear();
+    }
+
+    size_t GPUResourceRegistry::GetResourceCount() const
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        return resources.Size();
+    }
+}
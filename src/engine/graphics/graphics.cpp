@@ -4,6 +4,8 @@
 #include "ce/texture/static_texture.h"
 #include "ce/resource/resource.h"
 #include "ce/materials/pbr_material.h"
+#include "ce/graphics/buffer_arena.h"
+#include "ce/component/skybox.h"
 #include "glad/glad.h"
 #include "GLFW/glfw3.h"
 #include "ce/defs.hpp"
@@ -16,6 +18,7 @@ namespace CrossEngine
     std::shared_ptr<ATexture> Graphics::default_roughness;
     std::shared_ptr<ATexture> Graphics::default_ao;
     std::shared_ptr<AMaterial> Graphics::default_material;
+    std::shared_ptr<Skybox> Graphics::default_skybox;
 
     void Graphics::InitGraphics()
     {
@@ -25,19 +28,20 @@ namespace CrossEngine
             if (!initialized)
             {
                 
-                default_albedo = std::make_shared<StaticTexture>();
-                default_normal = std::make_shared<StaticTexture>();
-                default_metallic = std::make_shared<StaticTexture>();
-                default_roughness = std::make_shared<StaticTexture>();
-                default_ao = std::make_shared<StaticTexture>();
-
-                default_albedo->LoadTexture(Resource::GetExeDirectory() + "/textures/default_transparent.png");
-                default_normal->LoadTexture(Resource::GetExeDirectory() + "/textures/default_normal.png");
-                default_metallic->LoadTexture(WHITE_IMAGE, 2, 2, 1);
-                default_roughness->LoadTexture(WHITE_IMAGE, 2, 2, 1);
-                default_ao->LoadTexture(WHITE_IMAGE, 2, 2, 1);
+                default_albedo = Resource::LoadSharedTexture(Resource::GetExeDirectory() + "/textures/default_transparent.png",
+                    TextureContent::SRGB);
+                default_normal = Resource::LoadSharedTexture(Resource::GetExeDirectory() + "/textures/default_normal.png",
+                    TextureContent::NORMAL);
+                // The metallic, the roughness and the ambient occlusion share the same white texture.
+                auto white = std::make_shared<StaticTexture>();
+                white->LoadTexture(WHITE_IMAGE, 2, 2, 1);
+                default_metallic = white;
+                default_roughness = white;
+                default_ao = white;
                 
                 default_material = std::shared_ptr<AMaterial>(new PBRMaterial(true));
+                vertex_arena = new BufferArena(std::make_unique<GLBufferBackend>(), VERTEX_ARENA_PAGE_SIZE,
+                    Vertex::ARRAY_SIZE * sizeof(float));
             
                 if (!glfwInit())
                     throw std::runtime_error("Failed to initialize GLFW.");
@@ -60,6 +64,27 @@ namespace CrossEngine
             std::lock_guard<std::mutex> lock(init_mutex);
             if (initialized)
             {
+                // The unused resources are released while their contexts exist.
+                Resource::GetTextureCache().Clear();
+                Resource::GetMeshDataCache().Clear();
+                {
+                    std::lock_guard<std::mutex> skybox_lock(default_skybox_mutex);
+                    default_skybox.reset();
+                }
+                // The buffers of the arena and the freed resources are deleted in the shared context.
+                if (shared_context != nullptr)
+                {
+                    glfwMakeContextCurrent(static_cast<GLFWwindow*>(shared_context));
+                    ReleaseSharedResources();
+                }
+                delete vertex_arena;
+                vertex_arena = nullptr;
+                // Destroying the last context of the share group releases the shared resources.
+                if (shared_context != nullptr)
+                    glfwDestroyWindow(static_cast<GLFWwindow*>(shared_context));
+                shared_context = nullptr;
+                freed_shared_resources.clear();
+                freed_fences.clear();
                 glfwTerminate();
                 initialized = false;
             }
@@ -98,12 +123,100 @@ namespace CrossEngine
 
     }
 
+    void* Graphics::GetSharedContext()
+    {
+        if (!initialized)
+            throw std::runtime_error("Graphics not initialized.");
+        std::lock_guard<std::mutex> lock(create_window_mutex);
+        if (shared_context == nullptr)
+        {
+            glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+            shared_context = glfwCreateWindow(1, 1, "", NULL, NULL);
+            glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+            if (shared_context == nullptr)
+            {
+                glfwTerminate();
+                throw std::runtime_error("Failed to create shared context");
+            }
+        }
+        return shared_context;
+    }
+
+    void Graphics::FreeSharedResource(unsigned int p_id, ReleaseFunction p_destroy_func)
+    {
+        std::lock_guard<std::mutex> lock(shared_resources_mutex);
+        freed_shared_resources.push_back({p_id, p_destroy_func});
+    }
+
+    void Graphics::ReleaseSharedResources()
+    {
+        std::lock_guard<std::mutex> lock(shared_resources_mutex);
+        for (auto& resource : freed_shared_resources)
+            resource.destroy_func(1, &resource.id);
+        freed_shared_resources.clear();
+        for (auto fence : freed_fences)
+            glDeleteSync(static_cast<GLsync>(fence));
+        freed_fences.clear();
+    }
+
+    void Graphics::FenceUpload(void*& p_fence)
+    {
+        if (p_fence != nullptr)
+        {
+            // The new fence also covers the uploads the previous fence waits for, possibly from another context.
+            glWaitSync(static_cast<GLsync>(p_fence), 0, GL_TIMEOUT_IGNORED);
+            glDeleteSync(static_cast<GLsync>(p_fence));
+        }
+        p_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        // Other contexts can only wait for the fence once it is flushed.
+        glFlush();
+    }
+
+    bool Graphics::WaitUpload(void*& p_fence)
+    {
+        if (p_fence == nullptr)
+            return true;
+        GLenum status = glClientWaitSync(static_cast<GLsync>(p_fence), 0, 0);
+        if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED)
+        {
+            glDeleteSync(static_cast<GLsync>(p_fence));
+            p_fence = nullptr;
+            return true;
+        }
+        glWaitSync(static_cast<GLsync>(p_fence), 0, GL_TIMEOUT_IGNORED);
+        return false;
+    }
+
+    void Graphics::FreeFence(void* p_fence)
+    {
+        if (p_fence == nullptr)
+            return;
+        std::lock_guard<std::mutex> lock(shared_resources_mutex);
+        freed_fences.push_back(p_fence);
+    }
+
+    std::shared_ptr<Skybox> Graphics::GetDefaultSkybox()
+    {
+        std::lock_guard<std::mutex> lock(default_skybox_mutex);
+        if (default_skybox == nullptr)
+        {
+            default_skybox = std::make_shared<Skybox>(std::vector<std::string>{
+                Resource::GetExeDirectory() + "/textures/skybox/default/right.jpg",
+                Resource::GetExeDirectory() + "/textures/skybox/default/left.jpg",
+                Resource::GetExeDirectory() + "/textures/skybox/default/top.jpg",
+                Resource::GetExeDirectory() + "/textures/skybox/default/bottom.jpg",
+                Resource::GetExeDirectory() + "/textures/skybox/default/front.jpg",
+                Resource::GetExeDirectory() + "/textures/skybox/default/back.jpg"});
+        }
+        return default_skybox;
+    }
+
     void Graphics::DestroyGLFWContex(void* p_context)
     {
         glfwDestroyWindow(static_cast<GLFWwindow*>(p_context));
     }
 
-    unsigned int Graphics::GenerateVBO(unsigned int p_vao, float* p_vertices, size_t p_size, const Window* p_context)
+    unsigned int Graphics::GenerateVBO(unsigned int p_vao, float* p_vertices, size_t p_size)
     {
         unsigned int vbo;
         glGenBuffers(1, &vbo);
@@ -113,21 +226,127 @@ namespace CrossEngine
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, Vertex::ARRAY_SIZE * sizeof(float), (void*)0);
         glEnableVertexAttribArray(0);
         glBindVertexArray(0);
-        p_context->RegisterThreadResource(vbo, glDeleteBuffers);
         return vbo;
     }
 
-    unsigned int Graphics::GenerateTexture(const Window* p_context)
+    unsigned int Graphics::GenerateTexture()
     {
         unsigned int texture_id;
         glGenTextures(1, &texture_id);
-        p_context->RegisterThreadResource(texture_id, glDeleteTextures);
         return texture_id;
     }
 
-    void Graphics::DeleteTexture(unsigned int p_texture_id, const Window* p_context)
+    void Graphics::DeleteTexture(unsigned int p_texture_id)
     {
-        p_context->FreeThreadResource(p_texture_id);
+        FreeSharedResource(p_texture_id, ReleaseTextures);
+    }
+
+    void Graphics::ReleaseTextures(int p_count, const unsigned int* p_texture_ids)
+    {
+        glDeleteTextures(p_count, p_texture_ids);
+        texture_release_serial.fetch_add(1, std::memory_order_release);
+    }
+
+    void Graphics::SetVertexAttributes()
+    {
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, Vertex::ARRAY_SIZE * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, Vertex::ARRAY_SIZE * sizeof(float), (void*)(3 * sizeof(float)));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, Vertex::ARRAY_SIZE * sizeof(float), (void*)(6 * sizeof(float)));
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, Vertex::ARRAY_SIZE * sizeof(float), (void*)(8 * sizeof(float)));
+        glEnableVertexAttribArray(3);
+    }
+
+    bool Graphics::LoadMultiDrawIndirect()
+    {
+        GLint major = 0, minor = 0;
+        glGetIntegerv(GL_MAJOR_VERSION, &major);
+        glGetIntegerv(GL_MINOR_VERSION, &minor);
+        bool supported = major > 4 || (major == 4 && minor >= 3);
+        if (!supported)
+        {
+            bool has_multi_draw_indirect = false, has_base_instance = false;
+            GLint extension_count = 0;
+            glGetIntegerv(GL_NUM_EXTENSIONS, &extension_count);
+            for (GLint i = 0; i < extension_count; ++i)
+            {
+                std::string extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+                if (extension == "GL_ARB_multi_draw_indirect")
+                    has_multi_draw_indirect = true;
+                else if (extension == "GL_ARB_base_instance")
+                    has_base_instance = true;
+            }
+            supported = has_multi_draw_indirect && has_base_instance;
+        }
+        if (!supported)
+            return false;
+        auto function = reinterpret_cast<MultiDrawArraysIndirectFunction>(glfwGetProcAddress("glMultiDrawArraysIndirect"));
+        if (function == nullptr)
+            return false;
+        multi_draw_arrays_indirect = function;
+        return true;
+    }
+
+    bool Graphics::LoadBufferStorage()
+    {
+        GLint major = 0, minor = 0;
+        glGetIntegerv(GL_MAJOR_VERSION, &major);
+        glGetIntegerv(GL_MINOR_VERSION, &minor);
+        bool supported = major > 4 || (major == 4 && minor >= 4);
+        if (!supported)
+        {
+            GLint extension_count = 0;
+            glGetIntegerv(GL_NUM_EXTENSIONS, &extension_count);
+            for (GLint i = 0; i < extension_count && !supported; ++i)
+                supported = std::string(reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i))) == "GL_ARB_buffer_storage";
+        }
+        auto function = supported ? reinterpret_cast<BufferStorageFunction>(glfwGetProcAddress("glBufferStorage")) : nullptr;
+        buffer_storage = function;
+        return function != nullptr;
+    }
+
+    void Graphics::BufferStorage(unsigned int p_target, size_t p_size, unsigned int p_flags)
+    {
+        auto function = buffer_storage.load();
+        if (function == nullptr)
+            throw std::runtime_error("Buffer storage is not supported.");
+        function(p_target, static_cast<ptrdiff_t>(p_size), nullptr, p_flags);
+    }
+
+    void Graphics::LoadTextureCompression()
+    {
+        GLint major = 0, minor = 0;
+        glGetIntegerv(GL_MAJOR_VERSION, &major);
+        glGetIntegerv(GL_MINOR_VERSION, &minor);
+        bool has_s3tc = false;
+        bool has_bptc = major > 4 || (major == 4 && minor >= 2);
+        GLint extension_count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &extension_count);
+        for (GLint i = 0; i < extension_count; ++i)
+        {
+            std::string extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+            if (extension == "GL_EXT_texture_compression_s3tc")
+                has_s3tc = true;
+            else if (extension == "GL_ARB_texture_compression_bptc")
+                has_bptc = true;
+        }
+        is_s3tc_supported = has_s3tc;
+        is_rgtc_supported = major >= 3;
+        is_bptc_supported = has_bptc;
+    }
+
+    void Graphics::BindDrawIndirectBuffer(unsigned int p_buffer)
+    {
+        glBindBuffer(DRAW_INDIRECT_BUFFER, p_buffer);
+    }
+
+    void Graphics::MultiDrawArraysIndirect(size_t p_command_count)
+    {
+        if (multi_draw_arrays_indirect == nullptr)
+            throw std::runtime_error("Multi-draw indirect is not supported.");
+        multi_draw_arrays_indirect(GL_TRIANGLES, nullptr, static_cast<int>(p_command_count), 0);
     }
 
     void Graphics::ConfigTexture(unsigned int p_texture_id, const TextureConfig& p_config)
@@ -228,5 +447,16 @@ namespace CrossEngine
 
     void Graphics::Update()
     {
+        void* context;
+        {
+            std::lock_guard<std::mutex> lock(create_window_mutex);
+            context = shared_context;
+        }
+        // The functions are loaded by the first window.
+        if (vertex_arena == nullptr || context == nullptr || !GLAD_GL_VERSION_3_3)
+            return;
+        if (glfwGetCurrentContext() != context)
+            glfwMakeContextCurrent(static_cast<GLFWwindow*>(context));
+        vertex_arena->Defragment(VERTEX_ARENA_DEFRAGMENT_BYTES);
     }
 }
\ No newline at end of file
@@ -0,0 +1,95 @@
+#include "ce/graphics/mesh_data.h"
+#include "ce/graphics/graphics.h"
+#include "ce/graphics/buffer_arena.h"
+#include "ce/graphics/window.h"
+#include "ce/geometry/triangle.h"
+#include "ce/resource/resource.h"
+#include <glad/glad.h>
+
+namespace CrossEngine
+{
+    MeshData::MeshData(std::vector<Triangle*>&& p_triangles, std::unique_ptr<GeometryArena>&& p_arena)
+        : triangles(std::move(p_triangles)), arena(std::move(p_arena)), vertex_count(triangles.size() * 3)
+    {
+    }
+
+    // The triangles of the cache are created in the arena, so they are never deleted one by one.
+    MeshData::MeshData(std::shared_ptr<const MeshCache> p_cache)
+        : arena(std::make_unique<GeometryArena>()), cache(std::move(p_cache)), vertex_count(cache->GetLod(0).vertex_count)
+    {
+    }
+
+    std::shared_ptr<MeshData> MeshData::Load(const std::string& p_path)
+    {
+        return Resource::LoadSharedMeshData(p_path);
+    }
+
+    const std::vector<Triangle*>& MeshData::GetTriangles() const
+    {
+        std::lock_guard<std::mutex> lock(mesh_data_mutex);
+        if (cache != nullptr && triangles.empty() && vertex_count != 0)
+            cache->CreateTriangles(triangles, arena.get());
+        return triangles;
+    }
+
+    MeshData::~MeshData()
+    {
+        if (arena == nullptr)
+        {
+            for (auto i : triangles)
+                delete i;
+        }
+        if (arena_handle != BufferArena::INVALID_HANDLE && Graphics::GetVertexArena() != nullptr)
+            Graphics::GetVertexArena()->Free(arena_handle);
+        Graphics::FreeFence(upload_fence);
+    }
+
+    unsigned int MeshData::GetVBO(Window* p_context)
+    {
+        std::lock_guard<std::mutex> lock(mesh_data_mutex);
+        auto arena = Graphics::GetVertexArena();
+        if (arena_handle == BufferArena::INVALID_HANDLE)
+        {
+            size_t size = vertex_count * Vertex::ARRAY_SIZE * sizeof(float);
+            arena_handle = arena->Allocate(size);
+            if (cache != nullptr)
+            {
+                // The vertex stream of the cache is already in the layout of the buffer.
+                arena->Upload(arena_handle, cache->GetVertices() + cache->GetLod(0).first_vertex * Vertex::ARRAY_SIZE, size);
+            }
+            else
+            {
+                auto vertices = std::unique_ptr<float[]>(new float[vertex_count * Vertex::ARRAY_SIZE]);
+                Resource::CreateModelVertexArray(triangles, vertices.get(), vertex_count * Vertex::ARRAY_SIZE);
+                arena->Upload(arena_handle, vertices.get(), size);
+            }
+            p_context->AddUploadBytes(size);
+            Graphics::FenceUpload(upload_fence);
+        }
+        else
+        {
+            Graphics::WaitUpload(upload_fence);
+        }
+        return arena->GetBuffer(arena_handle);
+    }
+
+    size_t MeshData::GetFirstVertex() const
+    {
+        std::lock_guard<std::mutex> lock(mesh_data_mutex);
+        if (arena_handle == BufferArena::INVALID_HANDLE)
+            return 0;
+        return Graphics::GetVertexArena()->GetOffset(arena_handle) / (Vertex::ARRAY_SIZE * sizeof(float));
+    }
+
+    std::shared_ptr<const TriangleBVH> MeshData::GetBVH()
+    {
+        std::lock_guard<std::mutex> lock(mesh_data_mutex);
+        if (bvh == nullptr)
+        {
+            if (cache != nullptr && triangles.empty() && vertex_count != 0)
+                cache->CreateTriangles(triangles, arena.get());
+            bvh = std::make_shared<TriangleBVH>(triangles);
+        }
+        return bvh;
+    }
+}
@@ -0,0 +1,45 @@
+#include "ce/graphics/renderer/indirect_draw_list.h"
+#include "ce/component/component3D.h"
+#include "ce/utils/job_system.h"
+#include <algorithm>
+
+namespace CrossEngine
+{
+    namespace
+    {
+        void FillMatrices(const std::vector<const Component3D*>& p_instances, size_t p_first, size_t p_last, float* p_result)
+        {
+            for (size_t i = p_first; i < p_last; ++i)
+            {
+                const auto& matrix = p_instances[i]->GetSubspaceMatrix();
+                float* result = p_result + i * 16;
+                // Attributes read the matrices column by column.
+                for (size_t column = 0; column < 4; ++column)
+                {
+                    for (size_t row = 0; row < 4; ++row)
+                        result[column * 4 + row] = matrix[row][column];
+                }
+            }
+        }
+    }
+
+    void IndirectDrawList::Clear()
+    {
+        commands.clear();
+        instances.clear();
+    }
+
+    void IndirectDrawList::AddDraw(uint32_t p_first, uint32_t p_count, const std::vector<const Component3D*>& p_instances)
+    {
+        commands.push_back({p_count, (uint32_t)p_instances.size(), p_first, (uint32_t)instances.size()});
+        instances.insert(instances.end(), p_instances.begin(), p_instances.end());
+    }
+
+    void IndirectDrawList::Build()
+    {
+        matrices.resize(instances.size() * 16);
+        JobSystem::GetInstance().ParallelFor(instances.size(), FILL_CHUNK_SIZE, [this](size_t p_first, size_t p_last) {
+            FillMatrices(instances, p_first, p_last, matrices.data());
+        });
+    }
+}
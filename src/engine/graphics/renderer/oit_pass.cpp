@@ -0,0 +1,166 @@
+#include "ce/graphics/renderer/oit_pass.h"
+#include "ce/graphics/renderer/oit_math.h"
+#include "ce/graphics/shader/shader_program.h"
+#include "ce/graphics/shader/vert_shader.h"
+#include "ce/graphics/shader/frag_shader.h"
+#include "ce/graphics/graphics.h"
+#include "ce/resource/resource.h"
+#include "glad/glad.h"
+#include <algorithm>
+#include <charconv>
+
+namespace CrossEngine
+{
+    namespace
+    {
+        unsigned int CreateTargetTexture(const Math::Vec2s& p_size, GLint p_internal_format, GLenum p_format, GLenum p_type)
+        {
+            unsigned int texture;
+            glGenTextures(1, &texture);
+            glBindTexture(GL_TEXTURE_2D, texture);
+            glTexImage2D(GL_TEXTURE_2D, 0, p_internal_format, (GLsizei)p_size[0], (GLsizei)p_size[1], 0, p_format, p_type, nullptr);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            return texture;
+        }
+
+        // Scientific notation, so GLSL reads every value as a float.
+        std::string FormatShaderFloat(float p_value)
+        {
+            char buffer[32];
+            auto result = std::to_chars(buffer, buffer + sizeof(buffer), p_value, std::chars_format::scientific);
+            return std::string(buffer, result.ptr);
+        }
+
+        void CheckFramebuffer(const char* p_name)
+        {
+            if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+                throw std::runtime_error(std::string("Incomplete OIT framebuffer: ") + p_name);
+        }
+    }
+
+    std::string OITMath::GetShaderDefines()
+    {
+        std::string result;
+        auto add = [&](const char* p_name, float p_value) {
+            result += std::string("#define ") + p_name + " " + FormatShaderFloat(p_value) + "\n";
+        };
+        add("OIT_WEIGHT_ALPHA_SCALE", WEIGHT_ALPHA_SCALE);
+        add("OIT_WEIGHT_ALPHA_BIAS", WEIGHT_ALPHA_BIAS);
+        add("OIT_WEIGHT_SCALE", WEIGHT_SCALE);
+        add("OIT_WEIGHT_DEPTH_SCALE", WEIGHT_DEPTH_SCALE);
+        add("OIT_WEIGHT_MIN", WEIGHT_MIN);
+        add("OIT_WEIGHT_MAX", WEIGHT_MAX);
+        add("OIT_REVEALED_THRESHOLD", REVEALED_THRESHOLD);
+        add("OIT_MIN_WEIGHT_SUM", MIN_WEIGHT_SUM);
+        return result;
+    }
+
+    OITPass::OITPass(const Math::Vec2s& p_size)
+        : size(p_size)
+    {
+        composite_program = std::make_unique<ShaderProgram>(
+            new VertShader(Resource::GetExeDirectory() + "/shaders/oit_composite_vertex.glsl"),
+            new FragShader(Resource::GetExeDirectory() + "/shaders/oit_composite_fragment.glsl", OITMath::GetShaderDefines()));
+        composite_program->Compile();
+        // The core profile needs a vertex array bound to draw, even without attributes.
+        glGenVertexArrays(1, &composite_vao);
+        CreateTargets();
+    }
+
+    OITPass::~OITPass()
+    {
+        DestroyTargets();
+        if (composite_vao != 0)
+            glDeleteVertexArrays(1, &composite_vao);
+    }
+
+    void OITPass::CreateTargets()
+    {
+        // Zero sized framebuffers are incomplete, which happens when the window is minimized.
+        Math::Vec2s target_size = Math::Vec2s(std::max<size_t>(size[0], 1), std::max<size_t>(size[1], 1));
+        opaque_texture = CreateTargetTexture(target_size, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE);
+        depth_texture = CreateTargetTexture(target_size, GL_DEPTH24_STENCIL8, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8);
+        accumulation_texture = CreateTargetTexture(target_size, GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT);
+        revealage_texture = CreateTargetTexture(target_size, GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        glGenFramebuffers(1, &opaque_fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, opaque_fbo);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, opaque_texture, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, depth_texture, 0);
+        CheckFramebuffer("opaque");
+
+        // Transparent fragments are tested against the opaque depth without writing it.
+        glGenFramebuffers(1, &transparent_fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, transparent_fbo);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, accumulation_texture, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, revealage_texture, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, depth_texture, 0);
+        const GLenum draw_buffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+        glDrawBuffers(2, draw_buffers);
+        CheckFramebuffer("transparent");
+
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    void OITPass::DestroyTargets()
+    {
+        unsigned int fbos[] = { opaque_fbo, transparent_fbo };
+        glDeleteFramebuffers(2, fbos);
+        unsigned int textures[] = { opaque_texture, depth_texture, accumulation_texture, revealage_texture };
+        Graphics::ReleaseTextures(4, textures);
+        opaque_fbo = transparent_fbo = 0;
+        opaque_texture = depth_texture = accumulation_texture = revealage_texture = 0;
+    }
+
+    void OITPass::Resize(const Math::Vec2s& p_size)
+    {
+        if (p_size == size)
+            return;
+        size = p_size;
+        DestroyTargets();
+        CreateTargets();
+    }
+
+    void OITPass::BeginOpaque(const Math::Vec4& p_clear_color)
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, opaque_fbo);
+        glClearColor(p_clear_color[0], p_clear_color[1], p_clear_color[2], p_clear_color[3]);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    }
+
+    void OITPass::BeginTransparent()
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, transparent_fbo);
+        const float accumulation_clear[] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        const float revealage_clear[] = { 0.0f, 0.0f, 0.0f, 1.0f };
+        glClearBufferfv(GL_COLOR, 0, accumulation_clear);
+        glClearBufferfv(GL_COLOR, 1, revealage_clear);
+        glDepthMask(GL_FALSE);
+        // Color channels are summed, the alpha channel is multiplied by (1 - alpha).
+        glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ZERO, GL_ONE_MINUS_SRC_ALPHA);
+    }
+
+    void OITPass::Composite()
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glDepthMask(GL_TRUE);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glDisable(GL_DEPTH_TEST);
+        glDisable(GL_BLEND);
+
+        composite_program->Use();
+        composite_program->SetSampler2DUniform("opaque", opaque_texture);
+        composite_program->SetSampler2DUniform("accumulation", accumulation_texture);
+        composite_program->SetSampler2DUniform("revealage", revealage_texture);
+        glBindVertexArray(composite_vao);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        glBindVertexArray(0);
+
+        glEnable(GL_BLEND);
+        glEnable(GL_DEPTH_TEST);
+    }
+}
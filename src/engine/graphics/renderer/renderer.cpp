@@ -1,18 +1,63 @@
 #include "ce/graphics/renderer/renderer.h"
 #include "ce/graphics/shader/shader_program.h"
+#include "ce/graphics/renderer/static_batcher.h"
+#include "ce/graphics/graphics.h"
+#include "ce/graphics/window.h"
+#include "ce/graphics/mesh_data.h"
+#include "ce/component/component3D.h"
+#include "ce/materials/material.h"
 #include "glad/glad.h"
 
 #include <algorithm>
 
 namespace CrossEngine
 {
+    namespace
+    {
+        /**
+         * @brief Set the attributes of the model matrices of the instances, read from the bound buffer.
+         */
+        void SetInstanceAttributes()
+        {
+            for (unsigned int i = 0; i < 4; ++i)
+            {
+                glVertexAttribPointer(4 + i, 4, GL_FLOAT, GL_FALSE, 16 * sizeof(float), (void*)(i * 4 * sizeof(float)));
+                glEnableVertexAttribArray(4 + i);
+                glVertexAttribDivisor(4 + i, 1);
+            }
+        }
+
+        /**
+         * @brief Orphan the bound buffer when it is too small, and write the data to its beginning.
+         */
+        void UploadStreamBuffer(unsigned int p_target, size_t& p_capacity, const void* p_data, size_t p_size)
+        {
+            if (p_size > p_capacity)
+                p_capacity = std::max(p_size, p_capacity * 2);
+            // Orphan the buffer so the draws of the last frame do not stall the upload.
+            glBufferData(p_target, p_capacity, nullptr, GL_STREAM_DRAW);
+            glBufferSubData(p_target, 0, p_size, p_data);
+        }
+    }
+
     Renderer::Renderer(ShaderProgram*&& p_shader_program) noexcept
-        : shader_program(p_shader_program)
+        : shader_program(p_shader_program), static_batcher(std::make_unique<StaticBatcher>())
     {
     }
 
     Renderer::~Renderer()
     {
+        for (auto& i : instance_buffers)
+        {
+            glDeleteVertexArrays(1, &i.second.vao);
+            glDeleteBuffers(1, &i.second.vbo);
+        }
+        for (auto& i : indirect_buckets)
+        {
+            glDeleteVertexArrays(1, &i.second.vao);
+            glDeleteBuffers(1, &i.second.instance_vbo);
+            glDeleteBuffers(1, &i.second.command_buffer);
+        }
     }
 
     void Renderer::AddRenderTask(const Task& p_task)
@@ -23,22 +68,194 @@ namespace CrossEngine
             render_tasks.push_back(p_task);
     }
 
+    void Renderer::AddInstance(Window* p_context, const std::shared_ptr<MeshData>& p_mesh_data,
+        const std::shared_ptr<AMaterial>& p_material, const Component3D* p_instance)
+    {
+        auto& batch = instance_batches[{p_mesh_data.get(), p_material.get()}];
+        if (batch.instances.empty())
+        {
+            batch.mesh_data = p_mesh_data;
+            batch.material = p_material;
+            // The batch is drawn once, when its first instance of the frame is added.
+            if (p_context->IsMultiDrawIndirectEnabled())
+            {
+                unsigned int vertex_buffer = p_mesh_data->GetVBO(p_context);
+                auto& bucket = indirect_buckets[{p_material.get(), vertex_buffer}];
+                if (bucket.batches.empty())
+                {
+                    bucket.material = p_material;
+                    bucket.vertex_buffer = vertex_buffer;
+                    AddRenderTask(Task([this, p_context, &bucket](){ DrawIndirectBucket(p_context, bucket); }, 0));
+                }
+                bucket.batches.push_back(&batch);
+            }
+            else
+            {
+                AddRenderTask(Task([this, p_context, &batch](){ DrawInstances(p_context, batch); }, 0));
+            }
+        }
+        batch.instances.push_back(p_instance);
+    }
+
+    void Renderer::AddStaticMesh(Window* p_context, VisualMesh* p_mesh)
+    {
+        static_batcher->AddMesh(p_mesh);
+        if (!is_static_batch_task_added)
+        {
+            is_static_batch_task_added = true;
+            AddRenderTask(Task([this, p_context](){ static_batcher->Draw(p_context, shader_program.get()); }, 0));
+        }
+    }
+
+    void Renderer::DrawInstances(Window* p_context, InstanceBatch& p_batch)
+    {
+        size_t count = p_batch.instances.size();
+        if (count == 0 || p_batch.mesh_data->GetVertexCount() == 0)
+            return;
+
+        auto& buffer = instance_buffers[p_batch.mesh_data.get()];
+        if (buffer.vao != 0 && buffer.mesh_data.expired())
+        {
+            // The address is reused by a new mesh data.
+            glDeleteVertexArrays(1, &buffer.vao);
+            glDeleteBuffers(1, &buffer.vbo);
+            buffer = InstanceBuffer();
+        }
+        if (buffer.vao == 0)
+        {
+            buffer.mesh_data = p_batch.mesh_data;
+            glGenVertexArrays(1, &buffer.vao);
+            glGenBuffers(1, &buffer.vbo);
+            glBindVertexArray(buffer.vao);
+            glBindBuffer(GL_ARRAY_BUFFER, p_batch.mesh_data->GetVBO(p_context));
+            Graphics::SetVertexAttributes();
+            glBindBuffer(GL_ARRAY_BUFFER, buffer.vbo);
+            SetInstanceAttributes();
+        }
+
+        draw_list.Clear();
+        draw_list.AddDraw(p_batch.mesh_data->GetFirstVertex(), p_batch.mesh_data->GetVertexCount(), p_batch.instances);
+        draw_list.Build();
+
+        glBindVertexArray(buffer.vao);
+        glBindBuffer(GL_ARRAY_BUFFER, buffer.vbo);
+        size_t size = count * 16 * sizeof(float);
+        UploadStreamBuffer(GL_ARRAY_BUFFER, buffer.capacity, draw_list.GetMatrices().data(), size);
+        p_context->AddUploadBytes(size);
+
+        shader_program->SetUniform("instanced", 1);
+        p_batch.material->SetUniform(p_context);
+        glDrawArraysInstanced(GL_TRIANGLES, p_batch.mesh_data->GetFirstVertex(), p_batch.mesh_data->GetVertexCount(), count);
+        shader_program->SetUniform("instanced", 0);
+    }
+
+    void Renderer::DrawIndirectBucket(Window* p_context, IndirectBucket& p_bucket)
+    {
+        draw_list.Clear();
+        for (auto batch : p_bucket.batches)
+        {
+            if (batch->mesh_data->GetVertexCount() != 0)
+                draw_list.AddDraw(batch->mesh_data->GetFirstVertex(), batch->mesh_data->GetVertexCount(), batch->instances);
+        }
+        if (draw_list.GetCommands().empty())
+            return;
+        draw_list.Build();
+
+        if (p_bucket.vao == 0)
+        {
+            glGenVertexArrays(1, &p_bucket.vao);
+            glGenBuffers(1, &p_bucket.instance_vbo);
+            glGenBuffers(1, &p_bucket.command_buffer);
+            glBindVertexArray(p_bucket.vao);
+            glBindBuffer(GL_ARRAY_BUFFER, p_bucket.vertex_buffer);
+            Graphics::SetVertexAttributes();
+            glBindBuffer(GL_ARRAY_BUFFER, p_bucket.instance_vbo);
+            // The base instance of each command selects the model matrices of its instances.
+            SetInstanceAttributes();
+        }
+
+        glBindVertexArray(p_bucket.vao);
+        glBindBuffer(GL_ARRAY_BUFFER, p_bucket.instance_vbo);
+        size_t matrices_size = draw_list.GetMatrices().size() * sizeof(float);
+        UploadStreamBuffer(GL_ARRAY_BUFFER, p_bucket.instance_capacity, draw_list.GetMatrices().data(), matrices_size);
+        Graphics::BindDrawIndirectBuffer(p_bucket.command_buffer);
+        size_t commands_size = draw_list.GetCommands().size() * sizeof(IndirectDrawList::Command);
+        UploadStreamBuffer(Graphics::DRAW_INDIRECT_BUFFER, p_bucket.command_capacity, draw_list.GetCommands().data(), commands_size);
+        p_context->AddUploadBytes(matrices_size + commands_size);
+
+        shader_program->SetUniform("instanced", 1);
+        p_bucket.material->SetUniform(p_context);
+        Graphics::MultiDrawArraysIndirect(draw_list.GetCommands().size());
+        shader_program->SetUniform("instanced", 0);
+        Graphics::BindDrawIndirectBuffer(0);
+    }
+
     void Renderer::Refresh()
     {
-        shader_program->Refresh();
         render_tasks.clear();
         unprioritized_render_tasks.clear();
+        static_batcher->EndFrame();
+        is_static_batch_task_added = false;
+        for (auto i = instance_batches.begin(); i != instance_batches.end();)
+        {
+            // Keep the batches drawn in this frame, their storage is likely reused in the next one.
+            if (i->second.instances.empty())
+            {
+                i = instance_batches.erase(i);
+                continue;
+            }
+            i->second.instances.clear();
+            ++i;
+        }
+        for (auto i = indirect_buckets.begin(); i != indirect_buckets.end();)
+        {
+            if (i->second.batches.empty())
+            {
+                glDeleteVertexArrays(1, &i->second.vao);
+                glDeleteBuffers(1, &i->second.instance_vbo);
+                glDeleteBuffers(1, &i->second.command_buffer);
+                i = indirect_buckets.erase(i);
+                continue;
+            }
+            i->second.batches.clear();
+            ++i;
+        }
+        for (auto i = instance_buffers.begin(); i != instance_buffers.end();)
+        {
+            if (i->second.mesh_data.expired())
+            {
+                glDeleteVertexArrays(1, &i->second.vao);
+                glDeleteBuffers(1, &i->second.vbo);
+                i = instance_buffers.erase(i);
+                continue;
+            }
+            ++i;
+        }
     }
 
     void Renderer::Render()
+    {
+        RenderOpaque();
+        RenderTransparent();
+    }
+
+    void Renderer::RenderOpaque()
     {
         glEnable(GL_CULL_FACE);
         shader_program->Use();
         for (auto& task : unprioritized_render_tasks)
             task.task();
+    }
+
+    void Renderer::RenderTransparent(bool p_sort)
+    {
         glDisable(GL_CULL_FACE);
-        std::sort(render_tasks.begin(), render_tasks.end(),
-            [](const Task& a, const Task& b) { return a > b; });
+        shader_program->Use();
+        if (p_sort)
+        {
+            std::sort(render_tasks.begin(), render_tasks.end(),
+                [](const Task& a, const Task& b) { return a > b; });
+        }
         for (auto& task : render_tasks)
         {
             task.task();
@@ -0,0 +1,260 @@
+#include "ce/graphics/renderer/static_batcher.h"
+#include "ce/graphics/graphics.h"
+#include "ce/graphics/window.h"
+#include "ce/graphics/shader/shader_program.h"
+#include "ce/component/visual_mesh.h"
+#include "ce/component/camera.h"
+#include "ce/materials/material.h"
+#include "ce/geometry/triangle.h"
+#include "ce/resource/resource.h"
+#include <glad/glad.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace CrossEngine
+{
+    namespace
+    {
+        bool IsSameMatrix(const Math::Mat4& p_a, const Math::Mat4& p_b)
+        {
+            for (size_t row = 0; row < 4; ++row)
+            {
+                for (size_t column = 0; column < 4; ++column)
+                {
+                    if (p_a[row][column] != p_b[row][column])
+                        return false;
+                }
+            }
+            return true;
+        }
+    }
+
+    StaticBatcher::~StaticBatcher()
+    {
+        for (auto& i : batches)
+        {
+            if (i.second.vao != 0)
+            {
+                glDeleteVertexArrays(1, &i.second.vao);
+                glDeleteBuffers(1, &i.second.vbo);
+            }
+        }
+    }
+
+    void StaticBatcher::AddMesh(VisualMesh* p_mesh)
+    {
+        const auto& model = p_mesh->GetSubspaceMatrix();
+        auto material = p_mesh->GetMaterial();
+        auto entry = entries.find(p_mesh);
+        if (entry != entries.end())
+        {
+            auto mesh = entry->second.mesh.Lock();
+            // The address may be reused by a new mesh, or the mesh may be moved or its material changed.
+            if (mesh.get() == p_mesh && std::get<3>(entry->second.key) == material.get() && IsSameMatrix(entry->second.model, model))
+            {
+                entry->second.is_seen = true;
+                return;
+            }
+            auto& batch = batches[entry->second.key];
+            std::erase(batch.meshes, p_mesh);
+            batch.is_dirty = true;
+            entries.erase(entry);
+        }
+
+        BatchKey key = GetBatchKey(model * Math::Vec4(0.0f, 0.0f, 0.0f, 1.0f), chunk_size, material.get());
+        auto& batch = batches[key];
+        batch.material = material;
+        batch.meshes.push_back(p_mesh);
+        batch.is_dirty = true;
+        entries[p_mesh] = Entry{ ComponentLink::Make(p_mesh), key, model, true };
+    }
+
+    size_t StaticBatcher::GetBatchMeshCount(const BatchKey& p_key) const
+    {
+        auto batch = batches.find(p_key);
+        return batch != batches.end() ? batch->second.meshes.size() : 0;
+    }
+
+    StaticBatcher::BatchKey StaticBatcher::GetBatchKey(const Math::Vec4& p_position, float p_chunk_size, const AMaterial* p_material)
+    {
+        return {
+            (int)std::floor(p_position[0] / p_chunk_size),
+            (int)std::floor(p_position[1] / p_chunk_size),
+            (int)std::floor(p_position[2] / p_chunk_size),
+            p_material
+        };
+    }
+
+    void StaticBatcher::TransformVertices(float* p_vertices, size_t p_vertex_count, const Math::Mat4& p_model,
+        const Math::Mat4& p_model_inverse, float* p_bounds_min, float* p_bounds_max)
+    {
+        for (float* vertex = p_vertices; vertex != p_vertices + p_vertex_count * Vertex::ARRAY_SIZE; vertex += Vertex::ARRAY_SIZE)
+        {
+            float position[3] = { vertex[0], vertex[1], vertex[2] };
+            float normal[3] = { vertex[3], vertex[4], vertex[5] };
+            float tangent[3] = { vertex[8], vertex[9], vertex[10] };
+            for (size_t row = 0; row < 3; ++row)
+            {
+                vertex[row] = p_model[row][0] * position[0] + p_model[row][1] * position[1]
+                    + p_model[row][2] * position[2] + p_model[row][3];
+                // Normals are transformed by the inverse transpose.
+                vertex[3 + row] = p_model_inverse[0][row] * normal[0] + p_model_inverse[1][row] * normal[1]
+                    + p_model_inverse[2][row] * normal[2];
+                vertex[8 + row] = p_model[row][0] * tangent[0] + p_model[row][1] * tangent[1] + p_model[row][2] * tangent[2];
+                p_bounds_min[row] = std::min(p_bounds_min[row], vertex[row]);
+                p_bounds_max[row] = std::max(p_bounds_max[row], vertex[row]);
+            }
+        }
+    }
+
+    void StaticBatcher::EndFrame()
+    {
+        for (auto i = entries.begin(); i != entries.end();)
+        {
+            if (!i->second.is_seen)
+            {
+                auto& batch = batches[i->second.key];
+                std::erase(batch.meshes, i->first);
+                batch.is_dirty = true;
+                i = entries.erase(i);
+                continue;
+            }
+            i->second.is_seen = false;
+            ++i;
+        }
+    }
+
+    void StaticBatcher::SetChunkSize(float p_chunk_size)
+    {
+        if (p_chunk_size <= 0.0f)
+            throw std::invalid_argument("The chunk size must be positive.");
+        chunk_size = p_chunk_size;
+        // The meshes are added to the batches of their new chunks in the next frame.
+        entries.clear();
+        for (auto& i : batches)
+        {
+            i.second.meshes.clear();
+            i.second.is_dirty = true;
+        }
+    }
+
+    void StaticBatcher::RebuildBatch(Window* p_context, Batch& p_batch)
+    {
+        size_t vertex_count = 0;
+        for (auto i : p_batch.meshes)
+        {
+            if (auto mesh = entries[i].mesh.Lock())
+                vertex_count += static_cast<VisualMesh*>(mesh.get())->GetTriangles().size() * 3;
+        }
+        // The batch is drawn with a single draw call.
+        if (vertex_count > (size_t)std::numeric_limits<GLsizei>::max())
+            throw std::runtime_error("Too many vertices in a static batch.");
+        vertices.resize(vertex_count * Vertex::ARRAY_SIZE);
+
+        for (size_t i = 0; i < 3; ++i)
+        {
+            p_batch.bounds_min[i] = std::numeric_limits<float>::max();
+            p_batch.bounds_max[i] = std::numeric_limits<float>::lowest();
+        }
+
+        float* current = vertices.data();
+        for (auto i : p_batch.meshes)
+        {
+            auto mesh = entries[i].mesh.Lock();
+            if (mesh == nullptr)
+                continue;
+            auto visual_mesh = static_cast<VisualMesh*>(mesh.get());
+            const auto& triangles = visual_mesh->GetTriangles();
+            size_t size = triangles.size() * Triangle::TRIANGLE_ARRAY_SIZE;
+            Resource::CreateModelVertexArray(triangles, current, size);
+            TransformVertices(current, triangles.size() * 3, visual_mesh->GetSubspaceMatrix(),
+                visual_mesh->GetSubspaceMatrixInverse(), p_batch.bounds_min, p_batch.bounds_max);
+            current += size;
+        }
+
+        p_batch.vertex_count = vertex_count;
+        p_batch.is_dirty = false;
+        if (vertex_count == 0)
+            return;
+        if (p_batch.vao == 0)
+        {
+            glGenVertexArrays(1, &p_batch.vao);
+            glGenBuffers(1, &p_batch.vbo);
+            glBindVertexArray(p_batch.vao);
+            glBindBuffer(GL_ARRAY_BUFFER, p_batch.vbo);
+            Graphics::SetVertexAttributes();
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, p_batch.vbo);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+        p_context->AddUploadBytes(vertices.size() * sizeof(float));
+    }
+
+    bool StaticBatcher::IsOutsideView(const Math::Mat4& p_view_proj, const Batch& p_batch)
+    {
+        // Outside if every corner of the bounds is outside the same clip plane.
+        int outside[6] = {};
+        for (size_t corner = 0; corner < 8; ++corner)
+        {
+            float point[3] = {
+                (corner & 1) ? p_batch.bounds_max[0] : p_batch.bounds_min[0],
+                (corner & 2) ? p_batch.bounds_max[1] : p_batch.bounds_min[1],
+                (corner & 4) ? p_batch.bounds_max[2] : p_batch.bounds_min[2]
+            };
+            float clip[4];
+            for (size_t row = 0; row < 4; ++row)
+            {
+                clip[row] = p_view_proj[row][0] * point[0] + p_view_proj[row][1] * point[1]
+                    + p_view_proj[row][2] * point[2] + p_view_proj[row][3];
+            }
+            for (size_t axis = 0; axis < 3; ++axis)
+            {
+                outside[axis * 2] += clip[axis] < -clip[3];
+                outside[axis * 2 + 1] += clip[axis] > clip[3];
+            }
+        }
+        for (auto i : outside)
+        {
+            if (i == 8)
+                return true;
+        }
+        return false;
+    }
+
+    void StaticBatcher::Draw(Window* p_context, const ShaderProgram* p_shader_program)
+    {
+        for (auto i = batches.begin(); i != batches.end();)
+        {
+            if (i->second.is_dirty)
+                RebuildBatch(p_context, i->second);
+            if (i->second.vertex_count == 0)
+            {
+                if (i->second.vao != 0)
+                {
+                    glDeleteVertexArrays(1, &i->second.vao);
+                    glDeleteBuffers(1, &i->second.vbo);
+                }
+                i = batches.erase(i);
+                continue;
+            }
+            ++i;
+        }
+
+        Math::Mat4 view_proj = p_context->GetProjMatrix();
+        if (p_context->GetUsingCamera() != nullptr)
+            view_proj = view_proj * p_context->GetUsingCamera()->GetViewMatrix();
+
+        batch_draw_count = 0;
+        // The vertices are already in world space.
+        p_shader_program->SetUniform("model", Math::Mat4());
+        for (auto& i : batches)
+        {
+            if (IsOutsideView(view_proj, i.second))
+                continue;
+            i.second.material->SetUniform(p_context);
+            glBindVertexArray(i.second.vao);
+            glDrawArrays(GL_TRIANGLES, 0, (GLsizei)i.second.vertex_count);
+            ++batch_draw_count;
+        }
+    }
+}
@@ -16,8 +16,19 @@ namespace CrossEngine
         size_t size;
         auto shader_source = std::unique_ptr<char[]>(Resource::LoadFile(shader_path, size));
         shader_source[size] = '\0';
-        auto p = shader_source.get();
-        glShaderSource(shader_id, 1, (const char**)&p, NULL);
+        // The defines follow the #version line, which has to come first.
+        std::string_view source(shader_source.get(), size);
+        size_t version_end = 0;
+        if (!defines.empty() && source.starts_with("#version"))
+        {
+            version_end = source.find('\n');
+            version_end = version_end == std::string_view::npos ? size : version_end + 1;
+        }
+        std::string header;
+        if (version_end != 0)
+            header = std::string(source.substr(0, version_end)) + defines + "#line 2\n";
+        const char* sources[2] = { header.c_str(), shader_source.get() + version_end };
+        glShaderSource(shader_id, 2, sources, NULL);
         glCompileShader(shader_id);
         int success;
         char info_log[512];
@@ -3,8 +3,8 @@
 
 namespace CrossEngine
 {
-    FragShader::FragShader(const std::string& p_shader_path)
-        : AShader(p_shader_path)
+    FragShader::FragShader(const std::string& p_shader_path, const std::string& p_defines)
+        : AShader(p_shader_path, p_defines)
     {
         shader_id = glCreateShader(GL_FRAGMENT_SHADER);
     }
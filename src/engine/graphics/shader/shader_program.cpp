@@ -1,12 +1,66 @@
 #include "ce/graphics/shader/shader_program.h"
 #include "ce/graphics/shader/vert_shader.h"
 #include "ce/graphics/shader/frag_shader.h"
+#include "ce/graphics/graphics.h"
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include <algorithm>
+#include <climits>
 
 namespace CrossEngine
 {
+    namespace
+    {
+        bool IsSamplerType(GLenum p_type)
+        {
+            switch (p_type)
+            {
+            case GL_SAMPLER_1D:
+            case GL_SAMPLER_2D:
+            case GL_SAMPLER_3D:
+            case GL_SAMPLER_CUBE:
+            case GL_SAMPLER_2D_SHADOW:
+            case GL_SAMPLER_1D_ARRAY:
+            case GL_SAMPLER_2D_ARRAY:
+            case GL_SAMPLER_2D_ARRAY_SHADOW:
+            case GL_SAMPLER_CUBE_SHADOW:
+            case GL_SAMPLER_2D_MULTISAMPLE:
+            case GL_SAMPLER_BUFFER:
+            case GL_INT_SAMPLER_2D:
+            case GL_INT_SAMPLER_2D_ARRAY:
+            case GL_UNSIGNED_INT_SAMPLER_2D:
+            case GL_UNSIGNED_INT_SAMPLER_2D_ARRAY:
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        // Set for the units whose texture is not known.
+        constexpr unsigned int UNKNOWN_TEXTURE = UINT_MAX;
+    }
+
+    void ShaderProgram::BindSampler(int p_unit, unsigned int p_target, unsigned int p_texture_id) const
+    {
+        if (p_unit < 0)
+            return;
+        size_t serial = Graphics::GetTextureReleaseSerial();
+        if (serial != unit_textures_serial)
+        {
+            std::fill(unit_textures.begin(), unit_textures.end(), UNKNOWN_TEXTURE);
+            unit_textures_serial = serial;
+        }
+        // The materials sharing texture arrays bind the same textures for every draw.
+        if (unit_textures[p_unit] == p_texture_id)
+            return;
+        unit_textures[p_unit] = p_texture_id;
+        glActiveTexture(GL_TEXTURE0 + p_unit);
+        glBindTexture(p_target, p_texture_id);
+        // Uploads bind their textures to the active unit, which holds no sampler.
+        glActiveTexture(GL_TEXTURE0);
+    }
+
     ShaderProgram::ShaderProgram(const std::string& p_vert_shader_path, const std::string& p_frag_shader_path)
         : vert_shader(new VertShader(p_vert_shader_path)), frag_shader(new FragShader(p_frag_shader_path))
     {
@@ -28,76 +82,107 @@ namespace CrossEngine
     ShaderProgram::ShaderProgram(ShaderProgram&& p_other) noexcept
     {
         program_id = p_other.program_id;
+        sampler_units = std::move(p_other.sampler_units);
         vert_shader = std::move(p_other.vert_shader);
         frag_shader = std::move(p_other.frag_shader);
         p_other.program_id = 0;
     }
 
-    void ShaderProgram::SetUniform(const std::string& p_name, float p_float) const
+    void ShaderProgram::SetUniform(const char* p_name, float p_float) const
     {
         if (usable)
         {
-            int location = glGetUniformLocation(program_id, p_name.c_str());
+            int location = glGetUniformLocation(program_id, p_name);
             if (location == -1)
                 return;
             glUniform1f(location, p_float);
         }
     }
 
-    void ShaderProgram::SetUniform(const std::string& p_name, int p_int) const
+    void ShaderProgram::SetUniform(const char* p_name, int p_int) const
     {
         if (usable)
         {
-            int location = glGetUniformLocation(program_id, p_name.c_str());
+            int location = glGetUniformLocation(program_id, p_name);
             if (location == -1)
                 return;
             glUniform1i(location, p_int);
         }
     }
 
-    void ShaderProgram::SetUniform(const std::string& p_name, const Math::Mat4& p_mat4) const
+    void ShaderProgram::SetUniform(const char* p_name, const Math::Mat4& p_mat4) const
     {
         if (usable)
         {
-            int location = glGetUniformLocation(program_id, p_name.c_str());
+            int location = glGetUniformLocation(program_id, p_name);
             if (location == -1)
                 return;
             glUniformMatrix4fv(location, 1, GL_TRUE, p_mat4.GetRaw());
         }
     }
 
-    void ShaderProgram::SetUniform(const std::string& p_name, const Math::Vec4& p_vec4) const
+    void ShaderProgram::SetUniform(const char* p_name, const Math::Vec4& p_vec4) const
     {
         if (usable)
         {
-            int location = glGetUniformLocation(program_id, p_name.c_str());
+            int location = glGetUniformLocation(program_id, p_name);
             if (location == -1)
                 return;
             glUniform4fv(location, 1, p_vec4.GetRaw());
         }
     }
 
-    void ShaderProgram::SetSampler2DUniform(const std::string& p_name, unsigned int p_texture_id) const
+    void ShaderProgram::SetSampler2DUniform(const char* p_name, unsigned int p_texture_id) const
     {
-        if (usable)
-        {
-            int index = GetSamplerNewIndex();
-            SetUniform(p_name, index);
-            glActiveTexture(GL_TEXTURE0 + index);
-            glBindTexture(GL_TEXTURE_2D, p_texture_id);
-        }
+        BindSampler(GetSamplerUnit(p_name), GL_TEXTURE_2D, p_texture_id);
     }
 
-    void ShaderProgram::SetSamplerCubeUniform(const std::string& p_name, unsigned int p_texture_id) const
+    void ShaderProgram::SetSamplerCubeUniform(const char* p_name, unsigned int p_texture_id) const
     {
-        if (usable)
+        BindSampler(GetSamplerUnit(p_name), GL_TEXTURE_CUBE_MAP, p_texture_id);
+    }
+
+    void ShaderProgram::SetSampler2DArrayUniform(const char* p_name, unsigned int p_texture_id) const
+    {
+        BindSampler(GetSamplerUnit(p_name), GL_TEXTURE_2D_ARRAY, p_texture_id);
+    }
+
+    int ShaderProgram::GetSamplerUnit(const char* p_name) const
+    {
+        auto unit = sampler_units.find(p_name);
+        return unit == sampler_units.end() ? -1 : unit->second;
+    }
+
+    void ShaderProgram::AssignSamplerUnits()
+    {
+        sampler_units.clear();
+        int current_program = 0;
+        glGetIntegerv(GL_CURRENT_PROGRAM, &current_program);
+        glUseProgram(program_id);
+        int uniform_count = 0;
+        glGetProgramiv(program_id, GL_ACTIVE_UNIFORMS, &uniform_count);
+        int unit = 1;
+        for (int i = 0; i < uniform_count; ++i)
         {
-            int index = GetSamplerNewIndex();
-            SetUniform(p_name, index);
-            glActiveTexture(GL_TEXTURE0 + index);
-            glBindTexture(GL_TEXTURE_CUBE_MAP, p_texture_id);
+            char name[256];
+            int size = 0;
+            GLenum type = 0;
+            glGetActiveUniform(program_id, i, sizeof(name), nullptr, &size, &type, name);
+            if (!IsSamplerType(type))
+                continue;
+            // The elements of a sampler array take consecutive units.
+            std::string base = name;
+            if (base.ends_with("[0]"))
+                base.resize(base.size() - 3);
+            for (int j = 0; j < size; ++j, ++unit)
+            {
+                std::string element = size == 1 ? base : base + "[" + std::to_string(j) + "]";
+                sampler_units[element] = unit;
+                glUniform1i(glGetUniformLocation(program_id, element.c_str()), unit);
+            }
         }
-
+        unit_textures.assign(unit, UNKNOWN_TEXTURE);
+        glUseProgram(current_program);
     }
 
     ShaderProgram::~ShaderProgram()
@@ -134,6 +219,7 @@ namespace CrossEngine
                     glGetProgramInfoLog(program_id, 512, NULL, info_log);
                     throw std::runtime_error("Failed to link shader program: " + std::string(info_log));
                 }
+                AssignSamplerUnits();
                 usable = true;
             }
         }
@@ -143,10 +229,6 @@ namespace CrossEngine
     {
         if (usable)
             glUseProgram(program_id);
-    }
-
-    void ShaderProgram::Refresh()
-    {
-        sampler_count = 0;
+        std::fill(unit_textures.begin(), unit_textures.end(), UNKNOWN_TEXTURE);
     }
 }
\ No newline at end of file
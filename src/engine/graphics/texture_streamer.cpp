@@ -0,0 +1,270 @@
+#include "ce/graphics/texture_streamer.h"
+#include "ce/resource/resource_loader.h"
+#include "ce/graphics/graphics.h"
+#include "glad/glad.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace CrossEngine
+{
+    namespace
+    {
+        GLenum GetFormat(size_t p_channels)
+        {
+            switch (p_channels)
+            {
+            case 1:
+                return GL_RED;
+            case 3:
+                return GL_RGB;
+            case 4:
+                return GL_RGBA;
+            default:
+                throw std::runtime_error("Unsupported number of channels.");
+            }
+        }
+
+        FORCE_INLINE size_t GetChunkOffset(const MipChain& p_image, const TextureStreamer::Chunk& p_chunk) noexcept
+        {
+            return p_image.levels[p_chunk.level].offset + p_chunk.first_row / p_image.GetRowHeight() * p_image.GetRowSize(p_chunk.level);
+        }
+
+        FORCE_INLINE size_t GetChunkSize(const MipChain& p_image, const TextureStreamer::Chunk& p_chunk) noexcept
+        {
+            return (p_chunk.row_count + p_image.GetRowHeight() - 1) / p_image.GetRowHeight() * p_image.GetRowSize(p_chunk.level);
+        }
+    }
+
+    TextureStream::~TextureStream()
+    {
+        Graphics::FreeFence(upload_fence);
+    }
+
+    void TextureStream::Cancel()
+    {
+        std::lock_guard<std::mutex> lock(stream_mutex);
+        is_cancelled.store(true, std::memory_order_relaxed);
+    }
+
+    bool TextureStream::WaitUpload()
+    {
+        std::lock_guard<std::mutex> lock(stream_mutex);
+        return Graphics::WaitUpload(upload_fence);
+    }
+
+    TextureStreamer::TextureStreamer(size_t p_slot_count, size_t p_slot_size)
+        : slots(std::max<size_t>(p_slot_count, 1)), slot_size(p_slot_size)
+    {
+        for (auto& slot : slots)
+        {
+            glGenBuffers(1, &slot.buffer);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, slot_size, nullptr, GL_STREAM_DRAW);
+            slot.capacity = slot_size;
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+
+    TextureStreamer::~TextureStreamer()
+    {
+        for (auto& slot : slots)
+        {
+            if (slot.state == SlotState::FILLING)
+            {
+                // The worker may still be writing to the mapped buffer.
+                slot.fill.wait();
+                glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+                glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            }
+            if (slot.fence != nullptr)
+                glDeleteSync(static_cast<GLsync>(slot.fence));
+            glDeleteBuffers(1, &slot.buffer);
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+
+    std::vector<TextureStreamer::Chunk> TextureStreamer::SplitLevels(const MipChain& p_image, size_t p_slot_size)
+    {
+        std::vector<Chunk> result;
+        for (size_t level = p_image.levels.size(); level-- > 0;)
+        {
+            // The rows of a compressed level are rows of blocks, a chunk holds whole blocks.
+            size_t row_size = p_image.GetRowSize(level);
+            size_t height = p_image.levels[level].height;
+            size_t rows = row_size == 0 ? height : std::max<size_t>(p_slot_size / row_size, 1) * p_image.GetRowHeight();
+            // An empty level still gets a chunk, so its upload completes.
+            size_t row = 0;
+            do
+            {
+                size_t count = std::min(rows, height - row);
+                result.push_back(Chunk{level, row, count});
+                row += count;
+            } while (row < height);
+        }
+        return result;
+    }
+
+    std::shared_ptr<TextureStream> TextureStreamer::Stream(unsigned int p_texture_id, std::shared_ptr<const MipChain> p_image)
+    {
+        if (p_image->levels.empty())
+            throw std::runtime_error("Cannot stream a texture without level.");
+        size_t last_level = p_image->levels.size() - 1;
+        if (p_image->format != BlockFormat::NONE)
+        {
+            if (!Graphics::IsBlockFormatSupported(p_image->format))
+                throw std::runtime_error("Unsupported compressed texture format.");
+            GLenum format = Graphics::GetBlockInternalFormat(p_image->format);
+            glBindTexture(GL_TEXTURE_2D, p_texture_id);
+            for (size_t i = 0; i <= last_level; ++i)
+                glCompressedTexImage2D(GL_TEXTURE_2D, i, format, p_image->levels[i].width, p_image->levels[i].height, 0,
+                    p_image->GetLevelSize(i), nullptr);
+        }
+        else
+        {
+            GLenum format = GetFormat(p_image->channels);
+            glBindTexture(GL_TEXTURE_2D, p_texture_id);
+            for (size_t i = 0; i <= last_level; ++i)
+                glTexImage2D(GL_TEXTURE_2D, i, format, p_image->levels[i].width, p_image->levels[i].height, 0, format, GL_UNSIGNED_BYTE, nullptr);
+        }
+        // Only the uploaded levels are sampled.
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, last_level);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, last_level);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        auto stream = std::make_shared<TextureStream>(p_texture_id, p_image);
+        jobs.push_back(Job{stream, SplitLevels(*p_image, slot_size), 0});
+        return stream;
+    }
+
+    bool TextureStreamer::Fill(Slot& p_slot, std::shared_ptr<TextureStream> p_stream, const Chunk& p_chunk)
+    {
+        size_t size = GetChunkSize(*p_stream->image, p_chunk);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, p_slot.buffer);
+        if (p_slot.capacity < size)
+        {
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+            p_slot.capacity = size;
+        }
+        void* mapped = nullptr;
+        if (size != 0)
+        {
+            // The fence of the last transfer from the buffer is signaled, there is nothing to wait for.
+            mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size,
+                GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+            if (mapped == nullptr)
+            {
+                glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+                return false;
+            }
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        const ubyte_t* source = p_stream->image->pixels.get() + GetChunkOffset(*p_stream->image, p_chunk);
+        p_slot.fill = ResourceLoader::GetInstance().Submit([image = p_stream->image, source, mapped, size]() {
+            if (size != 0)
+                std::memcpy(mapped, source, size);
+        });
+        p_slot.stream = std::move(p_stream);
+        p_slot.chunk = p_chunk;
+        p_slot.state = SlotState::FILLING;
+        return true;
+    }
+
+    size_t TextureStreamer::Transfer(Slot& p_slot)
+    {
+        auto& image = *p_slot.stream->image;
+        auto& chunk = p_slot.chunk;
+        auto& level = image.levels[chunk.level];
+        size_t size = GetChunkSize(image, chunk);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, p_slot.buffer);
+        if (size != 0 && glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_FALSE)
+        {
+            // The content of the buffer is lost, such as when the display mode changes, it is copied again.
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            p_slot.state = SlotState::FREE;
+            if (!Fill(p_slot, p_slot.stream, chunk))
+                throw std::runtime_error("Failed to map the pixel buffer.");
+            return 0;
+        }
+        {
+            std::lock_guard<std::mutex> lock(p_slot.stream->stream_mutex);
+            if (!p_slot.stream->is_cancelled.load(std::memory_order_relaxed))
+            {
+                glBindTexture(GL_TEXTURE_2D, p_slot.stream->texture_id);
+                if (size != 0 && image.format != BlockFormat::NONE)
+                {
+                    glCompressedTexSubImage2D(GL_TEXTURE_2D, chunk.level, 0, chunk.first_row, level.width, chunk.row_count,
+                        Graphics::GetBlockInternalFormat(image.format), size, nullptr);
+                }
+                else if (size != 0)
+                {
+                    // The alignment is context state the other uploads of the context rely on.
+                    GLint alignment;
+                    glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+                    glPixelStorei(GL_UNPACK_ALIGNMENT, image.channels == 4 ? 4 : 1);
+                    glTexSubImage2D(GL_TEXTURE_2D, chunk.level, 0, chunk.first_row, level.width, chunk.row_count,
+                        GetFormat(image.channels), GL_UNSIGNED_BYTE, nullptr);
+                    glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+                }
+                bool is_level_complete = chunk.first_row + chunk.row_count == level.height;
+                if (is_level_complete)
+                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, chunk.level);
+                glBindTexture(GL_TEXTURE_2D, 0);
+                // Fenced before the level is published, so a context binding the level can wait for it.
+                Graphics::FenceUpload(p_slot.stream->upload_fence);
+                if (is_level_complete)
+                    p_slot.stream->uploaded_level_count.store(image.levels.size() - chunk.level, std::memory_order_release);
+            }
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        p_slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        p_slot.stream.reset();
+        p_slot.state = SlotState::IN_FLIGHT;
+        return size;
+    }
+
+    size_t TextureStreamer::Update(size_t p_byte_budget)
+    {
+        size_t result = 0;
+        size_t transfer_count = 0;
+        while (transfer_count == 0 || result < p_byte_budget)
+        {
+            auto& slot = slots[transfer_index];
+            if (slot.state != SlotState::FILLING || !ResourceLoader::IsReady(slot.fill))
+                break;
+            slot.fill.get();
+            result += Transfer(slot);
+            if (slot.state != SlotState::IN_FLIGHT)
+                break;
+            ++transfer_count;
+            transfer_index = (transfer_index + 1) % slots.size();
+        }
+
+        while (!jobs.empty())
+        {
+            auto& job = jobs.front();
+            if (job.next_chunk == job.chunks.size() || job.stream->is_cancelled.load(std::memory_order_relaxed))
+            {
+                jobs.pop_front();
+                continue;
+            }
+            auto& slot = slots[fill_index];
+            if (slot.state == SlotState::IN_FLIGHT)
+            {
+                GLenum status = glClientWaitSync(static_cast<GLsync>(slot.fence), 0, 0);
+                if (status == GL_TIMEOUT_EXPIRED)
+                    break;
+                if (status == GL_WAIT_FAILED)
+                    throw std::runtime_error("Failed to wait for the pixel buffer fence.");
+                glDeleteSync(static_cast<GLsync>(slot.fence));
+                slot.fence = nullptr;
+                slot.state = SlotState::FREE;
+            }
+            if (slot.state != SlotState::FREE || !Fill(slot, job.stream, job.chunks[job.next_chunk]))
+                break;
+            ++job.next_chunk;
+            fill_index = (fill_index + 1) % slots.size();
+        }
+        return result;
+    }
+}
@@ -1,6 +1,14 @@
 #include "ce/graphics/window.h"
 #include "ce/graphics/graphics.h"
 #include "ce/graphics/renderer/renderer.h"
+#include "ce/graphics/renderer/oit_pass.h"
+#include "ce/graphics/renderer/oit_math.h"
+#include "ce/graphics/shader/vert_shader.h"
+#include "ce/graphics/shader/frag_shader.h"
+#include "ce/graphics/buffer_arena.h"
+#include "ce/graphics/texture_streamer.h"
+#include "ce/utils/frame_allocator.h"
+#include "ce/utils/pool_allocator.hpp"
 #include "ce/resource/resource.h"
 #include "ce/managers/input_manager.h"
 #include "ce/managers/event_manager.h"
@@ -10,6 +18,7 @@
 #include "ce/texture/static_texture.h"
 #include "ce/component/camera.h"
 #include "ce/component/skybox.h"
+#include "ce/component/component_registry.h"
 #include "glad/glad.h"
 #include "GLFW/glfw3.h"
 #ifdef _WIN32
@@ -68,42 +77,37 @@ namespace CrossEngine
 
     void Window::UpdateThreadResource()
     {
-        for (size_t i = 0; i < queued_thread_resources.size(); ++i)
+        Graphics::ReleaseSharedResources();
+        thread_resources.ReleaseFreed();
+    }
+
+    void Window::UpdateUploads()
+    {
+        double start = glfwGetTime();
+        std::function<void()> upload;
+        while (upload_queue.Pop(upload))
         {
-            if (queued_thread_resources[i].is_queue_freed)
-            {
-                queued_thread_resources[i].destroy_func(1, &queued_thread_resources[i].id);
-                queued_thread_resources.erase(queued_thread_resources.begin() + i);
-                --i;
-            }
+            upload();
+            if (glfwGetTime() - start >= upload_time_budget)
+                break;
         }
+        AddUploadBytes(texture_streamer->Update(upload_byte_budget));
     }
 
     void Window::ClearResource()
     {
-        std::lock_guard<std::mutex> lock(queued_thread_resources_mutex);
-        for (auto& resource : queued_thread_resources)
-            resource.destroy_func(1, &resource.id);
-        queued_thread_resources.clear();
+        Graphics::ReleaseSharedResources();
+        thread_resources.ReleaseAll();
     }
 
-    void Window::RegisterThreadResource(unsigned int p_id, ReleaseFunction p_destroy_func) const
+    GPUResourceRegistry::Handle Window::RegisterThreadResource(unsigned int p_id, ReleaseFunction p_destroy_func) const
     {
-        std::lock_guard<std::mutex> lock(queued_thread_resources_mutex);
-        queued_thread_resources.push_back(ThreadResource(p_id, p_destroy_func));
+        return thread_resources.Register(p_id, p_destroy_func);
     }
 
-    void Window::FreeThreadResource(unsigned int p_id) const
+    void Window::FreeThreadResource(const GPUResourceRegistry::Handle& p_handle) const
     {
-        std::lock_guard<std::mutex> lock(queued_thread_resources_mutex);
-        for (auto& resource : queued_thread_resources)
-        {
-            if (resource.id == p_id)
-            {
-                resource.is_queue_freed = true;
-                return;
-            }
-        }
+        thread_resources.Free(p_handle);
     }
 
     void Window::SetClearColor(const Math::Vec4& p_clear_color)
@@ -133,10 +137,11 @@ namespace CrossEngine
         Graphics::InitGraphics();
         if (window_size[0] == 0)
             window_size = Graphics::GetScreenSize();
+        void* shared_context = Graphics::GetSharedContext();
         glfw_context = Graphics::CreateGLFWContext(
             window_size[0], window_size[1], 
             window_title.c_str(), 
-            is_fullscreen, is_resizable, nullptr);
+            is_fullscreen, is_resizable, shared_context);
 
         context_window_finder[glfw_context] = this;
         glfwMakeContextCurrent((GLFWwindow*)(glfw_context));
@@ -145,6 +150,10 @@ namespace CrossEngine
             glfwTerminate();
             throw std::runtime_error("Failed to initialize GLAD");
         }
+        is_multi_draw_indirect_supported = Graphics::LoadMultiDrawIndirect();
+        Graphics::LoadBufferStorage();
+        Graphics::LoadTextureCompression();
+        texture_streamer = std::make_unique<TextureStreamer>();
         glfwSetFramebufferSizeCallback((GLFWwindow*)(glfw_context), (GLFWframebuffersizefun)(WindowResized));
         glfwSetWindowFocusCallback((GLFWwindow*)(glfw_context), (GLFWwindowfocusfun)(WindowFocused));
 
@@ -162,8 +171,8 @@ namespace CrossEngine
         glfwSetCursorPosCallback((GLFWwindow*)(glfw_context), (GLFWcursorposfun)(OnMouseMove));
         glfwSetMouseButtonCallback((GLFWwindow*)(glfw_context), (GLFWmousebuttonfun)(OnMouseButton));
         
-        auto shader_program = new ShaderProgram(Resource::GetExeDirectory() + "/shaders/vertex.glsl", 
-                                        Resource::GetExeDirectory() + "/shaders/fragment.glsl");
+        auto shader_program = new ShaderProgram(new VertShader(Resource::GetExeDirectory() + "/shaders/vertex.glsl"),
+            new FragShader(Resource::GetExeDirectory() + "/shaders/fragment.glsl", OITMath::GetShaderDefines()));
         shader_program->Compile();
         main_renderer = new Renderer(std::move(shader_program));
 
@@ -176,13 +185,7 @@ namespace CrossEngine
         proj_matrix = Math::ProjPersp(
             0.2f * aspect_ratio, -0.2f * aspect_ratio, 0.2f, -0.2f, 0.5f, 1000.0f);
 
-        skybox = new Skybox({Resource::GetExeDirectory() + "/textures/skybox/default/right.jpg",
-                            Resource::GetExeDirectory() + "/textures/skybox/default/left.jpg",
-                            Resource::GetExeDirectory() + "/textures/skybox/default/top.jpg",
-                            Resource::GetExeDirectory() + "/textures/skybox/default/bottom.jpg",
-                            Resource::GetExeDirectory() + "/textures/skybox/default/front.jpg",
-                            Resource::GetExeDirectory() + "/textures/skybox/default/back.jpg"});
-        
+        skybox = Graphics::GetDefaultSkybox();
     }
 
     void Window::UpdateWindowSize(const Math::Vec2s& p_new_window_size)
@@ -190,6 +193,8 @@ namespace CrossEngine
         glViewport(0, 0, p_new_window_size[0], p_new_window_size[1]);
         
         window_size = p_new_window_size;
+        if (oit_pass != nullptr)
+            oit_pass->Resize(window_size);
     }
 
     void Window::ThreadFunc()
@@ -207,27 +212,38 @@ namespace CrossEngine
                 glfwPollEvents();
                 glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
                 Process(delta);
+                UpdateUploads();
                 Draw();
                 main_renderer->Refresh();
                 skybox_renderer->Refresh();
                 Game::GetInstance()->UpdateInput(this);
                 UpdateThreadResource();
+                Graphics::GetVertexArena()->EndFrame(this);
+                ComponentRegistry::EndFrame(this);
+                FrameAllocator::GetThreadInstance().Reset();
                 point_light_count = 0;
                 parallel_light_count = 0;
+                frame_upload_bytes = upload_bytes.exchange(0);
                 delta = glfwGetTime() - frame_start;
             }
             Game::GetInstance()->SetContextUnAvailable(this);
             OnClose();
-            Game::GetInstance()->RegisterEvent(std::make_shared<OnWindowCloseEvent>(this));
+            Game::GetInstance()->RegisterEvent(std::allocate_shared<OnWindowCloseEvent>(PoolStdAllocator<OnWindowCloseEvent>(), this));
             ClearResource();
+            Graphics::GetVertexArena()->RemoveContext(this);
+            ComponentRegistry::RemoveThread(this);
             delete main_renderer;
             delete skybox_renderer;
+            delete oit_pass;
+            texture_streamer.reset();
             Graphics::DestroyGLFWContex(glfw_context);
             is_closed = true;
         }
         catch (const std::exception& e){
             delete main_renderer;
             delete skybox_renderer;
+            delete oit_pass;
+            texture_streamer.reset();
             std::cerr << "Application throwed an error: " << e.what() << std::endl;
             throw std::runtime_error("Application throwed an error: " + std::string(e.what()));
         }
@@ -242,29 +258,36 @@ namespace CrossEngine
     void Window::WindowFocused(void* p_glfw_context, int p_focused)
     {
         Window* window = context_window_finder[p_glfw_context];
-        Game::GetInstance()->RegisterEvent(std::make_shared<OnWindowFocusEvent>(window, p_focused));
+        Game::GetInstance()->RegisterEvent(std::allocate_shared<OnWindowFocusEvent>(PoolStdAllocator<OnWindowFocusEvent>(), window, p_focused));
     }
 
     void Window::OnKey(void* p_glfw_context, int p_key, int p_scancode, int p_action, int p_mods)
     {
         Window* window = context_window_finder[p_glfw_context];
-        Game::GetInstance()->RegisterEvent(std::make_shared<OnKeyEvent>(window, p_key, p_scancode, p_action, p_mods));
+        Game::GetInstance()->RegisterEvent(std::allocate_shared<OnKeyEvent>(PoolStdAllocator<OnKeyEvent>(), window, p_key, p_scancode, p_action, p_mods));
     }
 
     void Window::OnMouseButton(void* p_glfw_context, int p_key, int p_action, int p_mods)
     {
         Window* window = context_window_finder[p_glfw_context];
-        Game::GetInstance()->RegisterEvent(std::make_shared<OnKeyEvent>(window, p_key, 0, p_action, p_mods));
+        Game::GetInstance()->RegisterEvent(std::allocate_shared<OnKeyEvent>(PoolStdAllocator<OnKeyEvent>(), window, p_key, 0, p_action, p_mods));
     }
 
     void Window::OnMouseMove(void* p_glfw_context, double p_x, double p_y)
     {
         Window* window = context_window_finder[p_glfw_context];
-        Game::GetInstance()->RegisterEvent(std::make_shared<OnMouseMoveEvent>(window, Math::Vector<double, 2>(p_x, p_y)));
+        Game::GetInstance()->RegisterEvent(std::allocate_shared<OnMouseMoveEvent>(PoolStdAllocator<OnMouseMoveEvent>(), window, Math::Vector<double, 2>(p_x, p_y)));
     }
 
     void Window::Draw()
     {
+        if (is_oit_enabled)
+        {
+            if (oit_pass == nullptr)
+                oit_pass = new OITPass(window_size);
+            oit_pass->BeginOpaque(clear_color);
+        }
+
         if (skybox != nullptr)
         {
             current_renderer = skybox_renderer;
@@ -296,11 +319,25 @@ namespace CrossEngine
                 current_renderer->GetShaderProgram()->SetUniform("camera_position", using_camera->GetGlobalPosition());
             }
             if (skybox != nullptr)
-                current_renderer->GetShaderProgram()->SetSamplerCubeUniform("skybox", skybox->GetTextureCubeIDs()[this]);
+                current_renderer->GetShaderProgram()->SetSamplerCubeUniform("skybox", skybox->GetTextureCubeID());
         }, -1));
         
         Game::GetInstance()->GetBaseComponent()->RegisterDraw(this);
-        current_renderer->Render();
+        if (is_oit_enabled)
+        {
+            current_renderer->RenderOpaque();
+            oit_pass->BeginTransparent();
+            current_renderer->GetShaderProgram()->SetUniform("oit", 1);
+            current_renderer->RenderTransparent(false);
+            current_renderer->GetShaderProgram()->SetUniform("oit", 0);
+            oit_pass->Composite();
+            // The composite leaves its program bound, the light counts below are set on the main program.
+            current_renderer->GetShaderProgram()->Use();
+        }
+        else
+        {
+            current_renderer->Render();
+        }
         current_renderer->GetShaderProgram()->SetUniform("point_light_count", GetPointLightCount());
         current_renderer->GetShaderProgram()->SetUniform("parallel_light_count", GetParallelLightCount());
     }
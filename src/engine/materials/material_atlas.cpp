@@ -0,0 +1,140 @@
+#include "ce/materials/material_atlas.h"
+#include "ce/texture/mip_chain.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace CrossEngine
+{
+    namespace
+    {
+        constexpr const char* TEXTURE_NAMES[MaterialAtlas::TEXTURE_COUNT] = {".albedo", ".normal", ".metallic", ".roughness", ".ao"};
+        // The value of the default texture of each kind, used for the textures a material does not have.
+        constexpr ubyte_t DEFAULT_VALUES[MaterialAtlas::TEXTURE_COUNT][4] = {
+            {255, 255, 255, 255}, {128, 128, 255, 255}, {255, 255, 255, 255}, {255, 255, 255, 255}, {255, 255, 255, 255}};
+
+        // Copy a level to a padded rectangle of RGBA pixels, repeating its edge pixels in the padding.
+        void CopyPadded(const MipChain& p_image, size_t p_level, size_t p_padding, size_t p_width, size_t p_height, ubyte_t* p_result)
+        {
+            const auto& level = p_image.levels[p_level];
+            const ubyte_t* pixels = p_image.GetLevelData(p_level);
+            size_t channels = p_image.channels;
+            for (size_t y = 0; y < p_height; ++y)
+            {
+                size_t source_y = std::min(y - std::min(y, p_padding), level.height - 1);
+                for (size_t x = 0; x < p_width; ++x)
+                {
+                    size_t source_x = std::min(x - std::min(x, p_padding), level.width - 1);
+                    const ubyte_t* pixel = pixels + (source_y * level.width + source_x) * channels;
+                    ubyte_t* rgba = p_result + (y * p_width + x) * 4;
+                    rgba[0] = pixel[0];
+                    rgba[1] = channels == 1 ? pixel[0] : pixel[1];
+                    rgba[2] = channels == 1 ? pixel[0] : channels == 2 ? 0 : pixel[2];
+                    rgba[3] = channels == 4 ? pixel[3] : 255;
+                }
+            }
+        }
+    }
+
+    MaterialAtlas::MaterialAtlas(size_t p_page_size, size_t p_layer_count, size_t p_level_count)
+        : page_size(p_page_size), cell_size(p_level_count == 0 ? 1 : (size_t)1 << (p_level_count - 1))
+    {
+        if (p_page_size == 0 || p_layer_count == 0 || p_level_count == 0 || p_page_size % cell_size != 0)
+            throw std::invalid_argument("The page size of a material atlas should be a multiple of the pixels of its smallest level.");
+        for (size_t i = 0; i < p_layer_count; ++i)
+            packers.emplace_back(p_page_size / cell_size, p_page_size / cell_size);
+        for (auto& array : arrays)
+            array = std::make_unique<TextureArray>(p_page_size, p_page_size, p_layer_count, p_level_count);
+    }
+
+    MaterialAtlas::Entry MaterialAtlas::Add(const MaterialTextures& p_textures)
+    {
+        const MipChain* images[TEXTURE_COUNT] = {p_textures.albedo, p_textures.normal, p_textures.metallic, p_textures.roughness, p_textures.ao};
+        size_t width = 0;
+        size_t height = 0;
+        for (auto image : images)
+        {
+            if (image == nullptr)
+                continue;
+            if (image->format != BlockFormat::NONE || image->levels.empty())
+                throw std::invalid_argument("The textures of a material atlas should not be compressed.");
+            if (width == 0)
+            {
+                width = image->levels[0].width;
+                height = image->levels[0].height;
+            }
+            else if (image->levels[0].width != width || image->levels[0].height != height)
+                throw std::invalid_argument("The textures of a material should have the same size.");
+        }
+        // A material without textures takes a pixel of the default values.
+        if (width == 0)
+            width = height = 1;
+
+        size_t level_count = arrays[0]->GetLevelCount();
+        // The levels down to 1x1 a texture needs, the smaller levels of the layers repeat its last one.
+        size_t needed_levels = std::min(level_count, MipChain::GetLevelCount(width, height));
+        MipChain generated[TEXTURE_COUNT];
+        for (size_t i = 0; i < TEXTURE_COUNT; ++i)
+        {
+            if (images[i] != nullptr && images[i]->levels.size() < needed_levels)
+            {
+                generated[i] = MipChain::Generate(images[i]->GetLevelData(0), width, height, images[i]->channels, true);
+                images[i] = &generated[i];
+            }
+        }
+
+        // A texture as large as a layer needs no padding, the layer repeats on its own.
+        bool is_full = width == page_size && height == page_size;
+        size_t padding = is_full ? 0 : cell_size;
+        size_t cells_x = (width + padding * 2 + cell_size - 1) / cell_size;
+        size_t cells_y = (height + padding * 2 + cell_size - 1) / cell_size;
+        if (cells_x * cell_size > page_size || cells_y * cell_size > page_size)
+            throw std::invalid_argument("The textures are larger than a layer of the material atlas.");
+        Entry result;
+        size_t x = 0;
+        size_t y = 0;
+        {
+            std::lock_guard<std::mutex> lock(atlas_mutex);
+            for (result.layer = 0; result.layer < packers.size(); ++result.layer)
+            {
+                auto rect = packers[result.layer].Insert(cells_x, cells_y);
+                if (rect.has_value())
+                {
+                    x = rect->x * cell_size + padding;
+                    y = rect->y * cell_size + padding;
+                    break;
+                }
+            }
+            if (result.layer == packers.size())
+                throw std::runtime_error("The material atlas is full.");
+        }
+        float page = (float)page_size;
+        result.uv_transform = Math::Vec4(width / page, height / page, x / page, y / page);
+
+        for (size_t level = 0; level < level_count; ++level)
+        {
+            size_t level_padding = padding >> level;
+            size_t block_width = std::max<size_t>(width >> level, 1) + level_padding * 2;
+            size_t block_height = std::max<size_t>(height >> level, 1) + level_padding * 2;
+            for (size_t i = 0; i < TEXTURE_COUNT; ++i)
+            {
+                std::vector<ubyte_t> block(block_width * block_height * 4);
+                if (images[i] != nullptr)
+                    CopyPadded(*images[i], std::min(level, images[i]->levels.size() - 1), level_padding, block_width, block_height, block.data());
+                else
+                {
+                    for (size_t j = 0; j < block.size(); ++j)
+                        block[j] = DEFAULT_VALUES[i][j % 4];
+                }
+                arrays[i]->Write(result.layer, level, (x >> level) - level_padding, (y >> level) - level_padding,
+                    block_width, block_height, std::move(block));
+            }
+        }
+        return result;
+    }
+
+    void MaterialAtlas::BindTextures(Window* p_context, const std::string& p_uniform_name) const
+    {
+        for (size_t i = 0; i < TEXTURE_COUNT; ++i)
+            arrays[i]->BindTexture(p_context, p_uniform_name + TEXTURE_NAMES[i]);
+    }
+}
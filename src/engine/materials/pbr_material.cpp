@@ -24,16 +24,53 @@ namespace CrossEngine
         
     }
 
-    void PBRMaterial::SetUniform(Window* p_context) const
+    void PBRMaterial::LoadAlbedo(const std::string& p_path, TextureContent p_content)
+    {
+        albedo = Resource::LoadSharedTexture(p_path, p_content);
+    }
+
+    void PBRMaterial::LoadNormal(const std::string& p_path, TextureContent p_content)
+    {
+        normal = Resource::LoadSharedTexture(p_path, p_content);
+    }
+
+    void PBRMaterial::LoadMetallic(const std::string& p_path, TextureContent p_content)
+    {
+        metallic = Resource::LoadSharedTexture(p_path, p_content);
+    }
+
+    void PBRMaterial::LoadRoughness(const std::string& p_path, TextureContent p_content)
+    {
+        roughness = Resource::LoadSharedTexture(p_path, p_content);
+    }
+
+    void PBRMaterial::LoadAO(const std::string& p_path, TextureContent p_content)
     {
-        albedo->BindTexture(p_context, GetUniformName() + ".albedo");
-        p_context->GetRenderer()->GetShaderProgram()->SetUniform("scaler_albedo", scaler_albedo);
-        normal->BindTexture(p_context, GetUniformName() + ".normal");
-        metallic->BindTexture(p_context, GetUniformName() + ".metallic");
-        p_context->GetRenderer()->GetShaderProgram()->SetUniform("scaler_metallic", scaler_metallic);
-        roughness->BindTexture(p_context, GetUniformName() + ".roughness");
-        p_context->GetRenderer()->GetShaderProgram()->SetUniform("scaler_roughness", scaler_roughness);
-        ao->BindTexture(p_context, GetUniformName() + ".ao");
+        ao = Resource::LoadSharedTexture(p_path, p_content);
+    }
 
+    void PBRMaterial::SetUniform(Window* p_context) const
+    {
+        const auto& shader_program = p_context->GetRenderer()->GetShaderProgram();
+        if (atlas != nullptr)
+        {
+            atlas->BindTextures(p_context, "material_array");
+            shader_program->SetUniform("material_array.layer", (float)atlas_entry.layer);
+            shader_program->SetUniform("material_array.uv_transform", atlas_entry.uv_transform);
+            shader_program->SetUniform("use_material_array", 1);
+        }
+        else
+        {
+            albedo->BindTexture(p_context, GetUniformName() + ".albedo");
+            normal->BindTexture(p_context, GetUniformName() + ".normal");
+            shader_program->SetUniform(GetUniformName() + ".normal_two_channel", normal->GetBlockFormat() == BlockFormat::BC5 ? 1 : 0);
+            metallic->BindTexture(p_context, GetUniformName() + ".metallic");
+            roughness->BindTexture(p_context, GetUniformName() + ".roughness");
+            ao->BindTexture(p_context, GetUniformName() + ".ao");
+            shader_program->SetUniform("use_material_array", 0);
+        }
+        shader_program->SetUniform("scaler_albedo", scaler_albedo);
+        shader_program->SetUniform("scaler_metallic", scaler_metallic);
+        shader_program->SetUniform("scaler_roughness", scaler_roughness);
     }
 }
\ No newline at end of file
@@ -0,0 +1,582 @@
+#include "ce/resource/gltf.h"
+#include "ce/resource/mesh_cache.h"
+#include "ce/geometry/vertex.h"
+#include "ce/utils/job_system.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace CrossEngine
+{
+    namespace
+    {
+        constexpr uint32_t CHUNK_JSON = 0x4E4F534A;
+        constexpr uint32_t CHUNK_BIN = 0x004E4942;
+        constexpr size_t TRIANGLES = 4;
+        constexpr size_t TRIANGLE_STRIP = 5;
+        constexpr size_t TRIANGLE_FAN = 6;
+
+        [[noreturn]] void Fail(const std::string& p_path, const std::string& p_message)
+        {
+            throw std::runtime_error("Invalid glTF file: \"" + p_path + "\", " + p_message + ".");
+        }
+
+        uint32_t ReadUInt32(const byte_t* p_data) noexcept
+        {
+            uint32_t result;
+            std::memcpy(&result, p_data, sizeof(uint32_t));
+            return result;
+        }
+
+        // Get an index or a count stored in the document.
+        size_t GetSize(const std::string& p_path, const Json& p_value, const char* p_name)
+        {
+            double value = p_value.GetNumber(-1.0);
+            if (value < 0.0 || value != std::floor(value) || value > 9007199254740992.0)
+                Fail(p_path, std::string("invalid ") + p_name);
+            return (size_t)value;
+        }
+
+        size_t GetComponentCount(const std::string& p_type) noexcept
+        {
+            if (p_type == "SCALAR")
+                return 1;
+            if (p_type == "VEC2")
+                return 2;
+            if (p_type == "VEC3")
+                return 3;
+            if (p_type == "VEC4" || p_type == "MAT2")
+                return 4;
+            if (p_type == "MAT3")
+                return 9;
+            if (p_type == "MAT4")
+                return 16;
+            return 0;
+        }
+
+        // Read the first components of an element, floats are copied without conversion.
+        FORCE_INLINE void ReadFloats(const GltfAccessor& p_accessor, size_t p_index, float* p_result, size_t p_count) noexcept
+        {
+            if (p_accessor.component_type == GltfAccessor::FLOAT)
+                std::memcpy(p_result, p_accessor.data + p_index * p_accessor.stride, p_count * sizeof(float));
+            else
+            {
+                for (size_t i = 0; i < p_count; ++i)
+                    p_result[i] = p_accessor.GetFloat(p_index, i);
+            }
+        }
+
+        void Normalize3(float* p_vector) noexcept
+        {
+            float length = std::sqrt(p_vector[0] * p_vector[0] + p_vector[1] * p_vector[1] + p_vector[2] * p_vector[2]);
+            if (length > 0.0f)
+            {
+                for (size_t i = 0; i < 3; ++i)
+                    p_vector[i] /= length;
+            }
+        }
+
+        // The normal and the tangent of a triangle as computed by Triangle, for primitives without them.
+        void ComputeFlatNormal(const float* p_v1, const float* p_v2, const float* p_v3, float* p_result) noexcept
+        {
+            float e1[3], e2[3];
+            for (size_t i = 0; i < 3; ++i)
+            {
+                e1[i] = p_v2[i] - p_v1[i];
+                e2[i] = p_v3[i] - p_v1[i];
+            }
+            p_result[0] = e1[1] * e2[2] - e1[2] * e2[1];
+            p_result[1] = e1[2] * e2[0] - e1[0] * e2[2];
+            p_result[2] = e1[0] * e2[1] - e1[1] * e2[0];
+            Normalize3(p_result);
+        }
+
+        void ComputeTangent(const float* p_v1, const float* p_v2, const float* p_v3, float* p_result) noexcept
+        {
+            float delta_uv1[2] = {p_v2[6] - p_v1[6], p_v2[7] - p_v1[7]};
+            float delta_uv2[2] = {p_v3[6] - p_v1[6], p_v3[7] - p_v1[7]};
+            float determinant = delta_uv1[0] * delta_uv2[1] - delta_uv2[0] * delta_uv1[1];
+            for (size_t i = 0; i < 3; ++i)
+            {
+                float delta_pos1 = p_v2[i] - p_v1[i], delta_pos2 = p_v3[i] - p_v1[i];
+                // Without texture coordinates, any direction along the triangle will do.
+                p_result[i] = determinant == 0.0f ? delta_pos1 : (delta_uv2[1] * delta_pos1 - delta_uv1[1] * delta_pos2) / determinant;
+            }
+            Normalize3(p_result);
+        }
+
+        std::shared_ptr<const MeshCache> DecodePrimitive(const GltfAsset& p_asset, const Json& p_primitive)
+        {
+            auto& path = p_asset.GetPath();
+            size_t mode = p_primitive["mode"].IsNull() ? TRIANGLES : GetSize(path, p_primitive["mode"], "primitive mode");
+            if (mode != TRIANGLES && mode != TRIANGLE_STRIP && mode != TRIANGLE_FAN)
+                return nullptr;
+            auto& attributes = p_primitive["attributes"];
+            if (attributes["POSITION"].IsNull())
+                Fail(path, "primitive without positions");
+            GltfAccessor positions = p_asset.GetAccessor(GetSize(path, attributes["POSITION"], "accessor"));
+            if (positions.component_type != GltfAccessor::FLOAT || positions.component_count != 3)
+                Fail(path, "invalid positions");
+            auto get_attribute = [&](const char* p_name, size_t p_component_count, GltfAccessor& p_result) {
+                if (attributes[p_name].IsNull())
+                    return false;
+                p_result = p_asset.GetAccessor(GetSize(path, attributes[p_name], "accessor"));
+                if (p_result.component_count != p_component_count || p_result.count != positions.count)
+                    Fail(path, std::string("invalid ") + p_name);
+                return true;
+            };
+            GltfAccessor normals, uvs, tangents, indices;
+            bool has_normals = get_attribute("NORMAL", 3, normals);
+            bool has_uvs = get_attribute("TEXCOORD_0", 2, uvs);
+            bool has_tangents = get_attribute("TANGENT", 4, tangents);
+            bool has_indices = !p_primitive["indices"].IsNull();
+            if (has_indices)
+            {
+                indices = p_asset.GetAccessor(GetSize(path, p_primitive["indices"], "accessor"));
+                if (indices.component_count != 1 || (indices.component_type != GltfAccessor::UNSIGNED_BYTE
+                    && indices.component_type != GltfAccessor::UNSIGNED_SHORT && indices.component_type != GltfAccessor::UNSIGNED_INT))
+                    Fail(path, "invalid indices");
+            }
+
+            size_t corner_count = has_indices ? indices.count : positions.count;
+            size_t triangle_count = mode == TRIANGLES ? corner_count / 3 : (corner_count >= 3 ? corner_count - 2 : 0);
+            auto get_corner = [&](size_t p_triangle, size_t p_corner) {
+                size_t corner;
+                if (mode == TRIANGLES)
+                    corner = p_triangle * 3 + p_corner;
+                else if (mode == TRIANGLE_STRIP)
+                    corner = p_triangle + (p_corner == 0 ? 0 : p_corner == 1 ? 1 + p_triangle % 2 : 2 - p_triangle % 2);
+                else
+                    corner = p_corner == 2 ? 0 : p_triangle + p_corner + 1;
+                size_t index = has_indices ? indices.GetIndex(corner) : corner;
+                if (index >= positions.count)
+                    Fail(path, "index out of range");
+                return index;
+            };
+
+            // The vertices are written straight into the stream of the cache.
+            auto write = [&](float* p_vertices) {
+                for (size_t i = 0; i < triangle_count; ++i)
+                {
+                    float* triangle = p_vertices + i * Triangle::TRIANGLE_ARRAY_SIZE;
+                    for (size_t j = 0; j < 3; ++j)
+                    {
+                        float* vertex = triangle + j * Vertex::ARRAY_SIZE;
+                        size_t index = get_corner(i, j);
+                        ReadFloats(positions, index, vertex, 3);
+                        if (has_normals)
+                            ReadFloats(normals, index, vertex + 3, 3);
+                        if (has_uvs)
+                            ReadFloats(uvs, index, vertex + 6, 2);
+                        if (has_tangents)
+                            ReadFloats(tangents, index, vertex + 8, 3);
+                    }
+                    float* v1 = triangle, * v2 = triangle + Vertex::ARRAY_SIZE, * v3 = triangle + 2 * Vertex::ARRAY_SIZE;
+                    if (!has_normals)
+                    {
+                        ComputeFlatNormal(v1, v2, v3, v1 + 3);
+                        std::memcpy(v2 + 3, v1 + 3, 3 * sizeof(float));
+                        std::memcpy(v3 + 3, v1 + 3, 3 * sizeof(float));
+                    }
+                    if (!has_tangents)
+                    {
+                        ComputeTangent(v1, v2, v3, v1 + 8);
+                        std::memcpy(v2 + 8, v1 + 8, 3 * sizeof(float));
+                        std::memcpy(v3 + 8, v1 + 8, 3 * sizeof(float));
+                    }
+                }
+            };
+            return std::make_shared<MeshCache>(MeshCache::Create(triangle_count * 3, write));
+        }
+
+        // The rotation of a rotation matrix, m is column major as in glTF.
+        Math::Vec4 GetQuaternion(const float* p_m) noexcept
+        {
+            auto r = [&](size_t p_row, size_t p_column) { return p_m[p_column * 4 + p_row]; };
+            float trace = r(0, 0) + r(1, 1) + r(2, 2);
+            Math::Vec4 result;
+            if (trace > 0.0f)
+            {
+                float s = std::sqrt(trace + 1.0f) * 2.0f;
+                result = Math::Vec4((r(2, 1) - r(1, 2)) / s, (r(0, 2) - r(2, 0)) / s, (r(1, 0) - r(0, 1)) / s, 0.25f * s);
+            }
+            else if (r(0, 0) > r(1, 1) && r(0, 0) > r(2, 2))
+            {
+                float s = std::sqrt(1.0f + r(0, 0) - r(1, 1) - r(2, 2)) * 2.0f;
+                result = Math::Vec4(0.25f * s, (r(0, 1) + r(1, 0)) / s, (r(0, 2) + r(2, 0)) / s, (r(2, 1) - r(1, 2)) / s);
+            }
+            else if (r(1, 1) > r(2, 2))
+            {
+                float s = std::sqrt(1.0f + r(1, 1) - r(0, 0) - r(2, 2)) * 2.0f;
+                result = Math::Vec4((r(0, 1) + r(1, 0)) / s, 0.25f * s, (r(1, 2) + r(2, 1)) / s, (r(0, 2) - r(2, 0)) / s);
+            }
+            else
+            {
+                float s = std::sqrt(1.0f + r(2, 2) - r(0, 0) - r(1, 1)) * 2.0f;
+                result = Math::Vec4((r(0, 2) + r(2, 0)) / s, (r(1, 2) + r(2, 1)) / s, 0.25f * s, (r(1, 0) - r(0, 1)) / s);
+            }
+            return result;
+        }
+
+        void TransformVertices(const Math::Mat4& p_model, const float* p_source, float* p_result, size_t p_vertex_count)
+        {
+            // Most assets place their meshes without any transform.
+            if (std::memcmp(p_model.GetRaw(), Math::Mat4().GetRaw(), sizeof(float) * 16) == 0)
+            {
+                std::memcpy(p_result, p_source, p_vertex_count * Vertex::ARRAY_SIZE * sizeof(float));
+                return;
+            }
+            Math::Mat4 normal_model = p_model;
+            try
+            {
+                normal_model = Math::Inverse(p_model).Transpose();
+            }
+            catch (const std::domain_error&)
+            {
+                // A node scaled to nothing has no visible normals anyway.
+            }
+            // The matrices are copied out of the math types, so the loop only multiplies floats.
+            float m[3][4], n[3][3];
+            for (size_t i = 0; i < 3; ++i)
+            {
+                for (size_t j = 0; j < 4; ++j)
+                    m[i][j] = p_model[i][j];
+                for (size_t j = 0; j < 3; ++j)
+                    n[i][j] = normal_model[i][j];
+            }
+            float determinant = m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1])
+                - m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0])
+                + m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+            for (size_t i = 0; i < p_vertex_count; ++i)
+            {
+                // A mirroring transform turns the triangles around, so their corners are swapped back.
+                size_t corner = i % 3;
+                size_t source_index = determinant >= 0.0f || corner == 0 ? i : corner == 1 ? i + 1 : i - 1;
+                const float* source = p_source + source_index * Vertex::ARRAY_SIZE;
+                float* result = p_result + i * Vertex::ARRAY_SIZE;
+                for (size_t k = 0; k < 3; ++k)
+                {
+                    result[k] = m[k][0] * source[0] + m[k][1] * source[1] + m[k][2] * source[2] + m[k][3];
+                    result[k + 3] = n[k][0] * source[3] + n[k][1] * source[4] + n[k][2] * source[5];
+                    result[k + 8] = m[k][0] * source[8] + m[k][1] * source[9] + m[k][2] * source[10];
+                }
+                result[6] = source[6];
+                result[7] = source[7];
+                Normalize3(result + 3);
+                Normalize3(result + 8);
+            }
+        }
+    }
+
+    size_t GltfAccessor::GetComponentSize() const noexcept
+    {
+        switch (component_type)
+        {
+        case BYTE:
+        case UNSIGNED_BYTE:
+            return 1;
+        case SHORT:
+        case UNSIGNED_SHORT:
+            return 2;
+        case UNSIGNED_INT:
+        case FLOAT:
+            return 4;
+        default:
+            return 0;
+        }
+    }
+
+    float GltfAccessor::GetFloat(size_t p_index, size_t p_component) const noexcept
+    {
+        const std::byte* element = data + p_index * stride + p_component * GetComponentSize();
+        auto read = [&]<typename T>(T p_max) {
+            T value;
+            std::memcpy(&value, element, sizeof(T));
+            if (!normalized)
+                return (float)value;
+            return std::max((float)value / (float)p_max, -1.0f);
+        };
+        switch (component_type)
+        {
+        case BYTE: return read((int8_t)INT8_MAX);
+        case UNSIGNED_BYTE: return read((uint8_t)UINT8_MAX);
+        case SHORT: return read((int16_t)INT16_MAX);
+        case UNSIGNED_SHORT: return read((uint16_t)UINT16_MAX);
+        case UNSIGNED_INT: return read((uint32_t)UINT32_MAX);
+        case FLOAT:
+        {
+            float value;
+            std::memcpy(&value, element, sizeof(float));
+            return value;
+        }
+        default:
+            return 0.0f;
+        }
+    }
+
+    uint32_t GltfAccessor::GetIndex(size_t p_index) const noexcept
+    {
+        const std::byte* element = data + p_index * stride;
+        switch (component_type)
+        {
+        case UNSIGNED_BYTE:
+            return (uint32_t)*reinterpret_cast<const uint8_t*>(element);
+        case UNSIGNED_SHORT:
+        {
+            uint16_t value;
+            std::memcpy(&value, element, sizeof(uint16_t));
+            return value;
+        }
+        case UNSIGNED_INT:
+        {
+            uint32_t value;
+            std::memcpy(&value, element, sizeof(uint32_t));
+            return value;
+        }
+        default:
+            return 0;
+        }
+    }
+
+    GltfAsset::GltfAsset(const std::string& p_path)
+        : path(p_path), file(VirtualFileSystem::GetInstance().Open(p_path))
+    {
+        const byte_t* data = file.GetData();
+        size_t size = file.GetSize();
+        if (size < 12 || ReadUInt32(data) != MAGIC)
+            Fail(path, "not a binary glTF file");
+        if (ReadUInt32(data + 4) != 2)
+            Fail(path, "unsupported version");
+        size = std::min(size, (size_t)ReadUInt32(data + 8));
+
+        size_t offset = 12;
+        bool has_json = false;
+        while (offset + 8 <= size)
+        {
+            size_t chunk_size = ReadUInt32(data + offset);
+            uint32_t chunk_type = ReadUInt32(data + offset + 4);
+            offset += 8;
+            if (chunk_size > size - offset)
+                Fail(path, "chunk out of range");
+            if (!has_json)
+            {
+                if (chunk_type != CHUNK_JSON)
+                    Fail(path, "the first chunk is not json");
+                document = Json::Parse(std::string_view(data + offset, chunk_size));
+                has_json = true;
+            }
+            else if (chunk_type == CHUNK_BIN && binary == nullptr)
+            {
+                binary = reinterpret_cast<const std::byte*>(data + offset);
+                binary_size = chunk_size;
+            }
+            // The chunks are padded to 4 bytes.
+            offset += (chunk_size + 3) & ~(size_t)3;
+        }
+        if (!has_json)
+            Fail(path, "missing json chunk");
+        if (!document["asset"]["version"].GetString().starts_with("2"))
+            Fail(path, "unsupported version");
+    }
+
+    std::span<const std::byte> GltfAsset::GetBuffer(size_t p_index) const
+    {
+        if (p_index >= document["buffers"].GetSize())
+            Fail(path, "buffer out of range");
+        auto& buffer = document["buffers"][p_index];
+        if (buffer.Find("uri") != nullptr)
+            Fail(path, "external buffers are not supported");
+        size_t byte_length = GetSize(path, buffer["byteLength"], "buffer length");
+        // The binary chunk may be padded after the buffer.
+        if (p_index != 0 || byte_length > binary_size)
+            Fail(path, "buffer out of range");
+        return std::span<const std::byte>(binary, byte_length);
+    }
+
+    std::span<const std::byte> GltfAsset::GetBufferView(size_t p_index) const
+    {
+        if (p_index >= document["bufferViews"].GetSize())
+            Fail(path, "buffer view out of range");
+        auto& view = document["bufferViews"][p_index];
+        auto buffer = GetBuffer(GetSize(path, view["buffer"], "buffer"));
+        size_t offset = view["byteOffset"].IsNull() ? 0 : GetSize(path, view["byteOffset"], "buffer view offset");
+        size_t length = GetSize(path, view["byteLength"], "buffer view length");
+        if (offset > buffer.size() || length > buffer.size() - offset)
+            Fail(path, "buffer view out of range");
+        return buffer.subspan(offset, length);
+    }
+
+    GltfAccessor GltfAsset::GetAccessor(size_t p_index) const
+    {
+        if (p_index >= document["accessors"].GetSize())
+            Fail(path, "accessor out of range");
+        auto& accessor = document["accessors"][p_index];
+        if (accessor.Find("sparse") != nullptr || accessor.Find("bufferView") == nullptr)
+            Fail(path, "sparse accessors are not supported");
+        GltfAccessor result;
+        result.component_type = (uint32_t)GetSize(path, accessor["componentType"], "component type");
+        result.component_count = GetComponentCount(accessor["type"].GetString());
+        result.count = GetSize(path, accessor["count"], "accessor count");
+        result.normalized = accessor["normalized"].GetBoolean();
+        size_t element_size = result.GetComponentSize() * result.component_count;
+        if (element_size == 0)
+            Fail(path, "invalid accessor type");
+
+        size_t view_index = GetSize(path, accessor["bufferView"], "buffer view");
+        auto view = GetBufferView(view_index);
+        auto& stride = document["bufferViews"][view_index]["byteStride"];
+        result.stride = stride.IsNull() ? element_size : GetSize(path, stride, "buffer view stride");
+        size_t offset = accessor["byteOffset"].IsNull() ? 0 : GetSize(path, accessor["byteOffset"], "accessor offset");
+        if (result.stride < element_size || offset > view.size()
+            || (result.count != 0 && (view.size() - offset < element_size || (result.count - 1) > (view.size() - offset - element_size) / result.stride)))
+            Fail(path, "accessor out of range");
+        result.data = view.data() + offset;
+        return result;
+    }
+
+    std::vector<std::vector<GltfPrimitive>> GltfAsset::DecodeMeshes() const
+    {
+        auto& meshes = document["meshes"];
+        std::vector<std::vector<GltfPrimitive>> result(meshes.GetSize());
+        std::vector<std::pair<size_t, size_t>> jobs;
+        for (size_t i = 0; i < meshes.GetSize(); ++i)
+        {
+            auto& primitives = meshes[i]["primitives"];
+            result[i].resize(primitives.GetSize());
+            for (size_t j = 0; j < primitives.GetSize(); ++j)
+            {
+                auto& material = primitives[j]["material"];
+                result[i][j].material = material.IsNull() ? -1 : (int64_t)GetSize(path, material, "material");
+                jobs.emplace_back(i, j);
+            }
+        }
+
+        // The primitives are taken by the workers one at a time, they are of very different sizes.
+        JobSystem::GetInstance().ParallelFor(jobs.size(), 1, [&](size_t p_first, size_t p_last) {
+            for (size_t job = p_first; job < p_last; ++job)
+            {
+                auto [mesh, primitive] = jobs[job];
+                result[mesh][primitive].cache = DecodePrimitive(*this, meshes[mesh]["primitives"][primitive]);
+            }
+        });
+        return result;
+    }
+
+    void GltfAsset::GetNodeTransform(size_t p_node, Math::Vec4& p_translation, Math::Vec4& p_rotation, Math::Vec4& p_scale) const
+    {
+        if (p_node >= document["nodes"].GetSize())
+            Fail(path, "node out of range");
+        auto& node = document["nodes"][p_node];
+        // The rotations of the engine turn the other way, so the quaternions of glTF are conjugated.
+        if (node["matrix"].GetSize() == 16)
+        {
+            float m[16];
+            for (size_t i = 0; i < 16; ++i)
+                m[i] = (float)node["matrix"][i].GetNumber();
+            float scale[3];
+            for (size_t i = 0; i < 3; ++i)
+                scale[i] = std::sqrt(m[i * 4] * m[i * 4] + m[i * 4 + 1] * m[i * 4 + 1] + m[i * 4 + 2] * m[i * 4 + 2]);
+            float determinant = m[0] * (m[5] * m[10] - m[9] * m[6]) - m[4] * (m[1] * m[10] - m[9] * m[2]) + m[8] * (m[1] * m[6] - m[5] * m[2]);
+            if (determinant < 0.0f)
+                scale[0] = -scale[0];
+            for (size_t i = 0; i < 3; ++i)
+            {
+                for (size_t j = 0; j < 3; ++j)
+                    m[i * 4 + j] = scale[i] == 0.0f ? (float)(i == j) : m[i * 4 + j] / scale[i];
+            }
+            auto rotation = GetQuaternion(m);
+            p_translation = Math::Pos(m[12], m[13], m[14]);
+            p_rotation = Math::Vec4(-rotation[0], -rotation[1], -rotation[2], rotation[3]);
+            p_scale = Math::Vec4(scale[0], scale[1], scale[2]);
+            return;
+        }
+        auto& translation = node["translation"];
+        auto& rotation = node["rotation"];
+        auto& scale = node["scale"];
+        p_translation = translation.GetSize() == 3
+            ? Math::Pos((float)translation[0].GetNumber(), (float)translation[1].GetNumber(), (float)translation[2].GetNumber())
+            : Math::Pos(0.0f, 0.0f, 0.0f);
+        p_rotation = rotation.GetSize() == 4
+            ? Math::Vec4(-(float)rotation[0].GetNumber(), -(float)rotation[1].GetNumber(), -(float)rotation[2].GetNumber(), (float)rotation[3].GetNumber())
+            : Math::Vec4(0.0f, 0.0f, 0.0f, 1.0f);
+        p_scale = scale.GetSize() == 3
+            ? Math::Vec4((float)scale[0].GetNumber(), (float)scale[1].GetNumber(), (float)scale[2].GetNumber())
+            : Math::Vec4(1.0f, 1.0f, 1.0f);
+    }
+
+    std::vector<size_t> GltfAsset::GetRootNodes() const
+    {
+        std::vector<size_t> result;
+        auto& scenes = document["scenes"];
+        size_t scene = document["scene"].IsNull() ? 0 : GetSize(path, document["scene"], "scene");
+        if (scene < scenes.GetSize())
+        {
+            auto& nodes = scenes[scene]["nodes"];
+            for (size_t i = 0; i < nodes.GetSize(); ++i)
+                result.push_back(GetSize(path, nodes[i], "node"));
+            return result;
+        }
+        auto& nodes = document["nodes"];
+        std::vector<bool> is_child(nodes.GetSize(), false);
+        for (size_t i = 0; i < nodes.GetSize(); ++i)
+        {
+            auto& children = nodes[i]["children"];
+            for (size_t j = 0; j < children.GetSize(); ++j)
+            {
+                size_t child = GetSize(path, children[j], "node");
+                if (child < is_child.size())
+                    is_child[child] = true;
+            }
+        }
+        for (size_t i = 0; i < nodes.GetSize(); ++i)
+        {
+            if (!is_child[i])
+                result.push_back(i);
+        }
+        return result;
+    }
+
+    MeshCache GltfAsset::CreateMeshCache(const MeshCacheSource& p_source) const
+    {
+        auto meshes = DecodeMeshes();
+        auto& nodes = document["nodes"];
+        // The primitives drawn by every node, with the transforms of the nodes.
+        std::vector<std::pair<Math::Mat4, const MeshCache*>> instances;
+        size_t vertex_count = 0;
+        std::vector<bool> is_visited(nodes.GetSize(), false);
+        auto visit = [&](auto& p_visit, size_t p_node, const Math::Mat4& p_parent) -> void {
+            if (p_node >= nodes.GetSize() || is_visited[p_node])
+                Fail(path, "invalid node hierarchy");
+            is_visited[p_node] = true;
+            Math::Vec4 translation, rotation, scale;
+            GetNodeTransform(p_node, translation, rotation, scale);
+            Math::Mat4 model = p_parent * Math::Model(translation, rotation, scale);
+            auto& node = nodes[p_node];
+            if (!node["mesh"].IsNull())
+            {
+                size_t mesh = GetSize(path, node["mesh"], "mesh");
+                if (mesh >= meshes.size())
+                    Fail(path, "mesh out of range");
+                for (auto& primitive : meshes[mesh])
+                {
+                    if (primitive.cache == nullptr)
+                        continue;
+                    instances.emplace_back(model, primitive.cache.get());
+                    vertex_count += primitive.cache->GetVertexCount();
+                }
+            }
+            auto& children = node["children"];
+            for (size_t i = 0; i < children.GetSize(); ++i)
+                p_visit(p_visit, GetSize(path, children[i], "node"), model);
+        };
+        for (auto root : GetRootNodes())
+            visit(visit, root, Math::Mat4());
+        return MeshCache::Create(vertex_count, [&](float* p_vertices) {
+            for (auto& [model, cache] : instances)
+            {
+                TransformVertices(model, cache->GetVertices(), p_vertices, cache->GetVertexCount());
+                p_vertices += cache->GetVertexCount() * Vertex::ARRAY_SIZE;
+            }
+        }, p_source);
+    }
+}
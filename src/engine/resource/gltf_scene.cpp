@@ -0,0 +1,199 @@
+#include "ce/resource/gltf.h"
+#include "ce/resource/resource.h"
+#include "ce/resource/mesh_cache.h"
+#include "ce/component/component3D.h"
+#include "ce/component/static_mesh.h"
+#include "ce/materials/pbr_material.h"
+#include "ce/texture/static_texture.h"
+#include "ce/graphics/graphics.h"
+#include <filesystem>
+#include <cstring>
+#include <mutex>
+
+namespace CrossEngine
+{
+    namespace
+    {
+        // An image of the asset, decoded once for every texture reading its channels.
+        struct SharedImage
+        {
+            std::shared_ptr<const GltfAsset> asset;
+            std::span<const std::byte> data;
+            std::string path;
+            std::once_flag decode_flag;
+            std::unique_ptr<ubyte_t[]> pixels;
+            size_t width = 0;
+            size_t height = 0;
+            size_t channels = 0;
+
+            void Decode()
+            {
+                std::call_once(decode_flag, [&]() {
+                    try
+                    {
+                        if (path.empty())
+                            pixels.reset(Resource::DecodeTextureImage(reinterpret_cast<const ubyte_t*>(data.data()), data.size(), width, height, channels));
+                        else
+                            pixels.reset(Resource::LoadTextureImage(path, nullptr, 0, width, height, channels));
+                    }
+                    catch (const std::runtime_error&)
+                    {
+                        // The textures of an image that cannot be decoded are left to their fallback.
+                        pixels.reset();
+                    }
+                    asset.reset();
+                });
+            }
+        };
+
+        // Read a channel of a shared image, or the whole image if the channel is SIZE_MAX.
+        StaticTexture::Decoder CreateDecoder(std::shared_ptr<SharedImage> p_image, size_t p_channel, std::vector<ubyte_t> p_fallback)
+        {
+            return [image = std::move(p_image), p_channel, fallback = std::move(p_fallback)](size_t& p_width, size_t& p_height, size_t& p_channels) {
+                image->Decode();
+                if (image->pixels == nullptr)
+                {
+                    p_width = p_height = 1;
+                    p_channels = fallback.size();
+                    ubyte_t* result = new ubyte_t[fallback.size()];
+                    std::memcpy(result, fallback.data(), fallback.size());
+                    return result;
+                }
+                p_width = image->width;
+                p_height = image->height;
+                size_t pixel_count = image->width * image->height;
+                if (p_channel == SIZE_MAX)
+                {
+                    p_channels = image->channels;
+                    ubyte_t* result = new ubyte_t[pixel_count * image->channels];
+                    std::memcpy(result, image->pixels.get(), pixel_count * image->channels);
+                    return result;
+                }
+                // The shader reads the metallic, the roughness and the ambient occlusion from the red channel.
+                size_t channel = std::min(p_channel, image->channels - 1);
+                p_channels = 1;
+                ubyte_t* result = new ubyte_t[pixel_count];
+                for (size_t i = 0; i < pixel_count; ++i)
+                    result[i] = image->pixels[i * image->channels + channel];
+                return result;
+            };
+        }
+
+        Math::Vec4 GetVec4(const Json& p_value, const Math::Vec4& p_default)
+        {
+            if (p_value.GetSize() != 4)
+                return p_default;
+            return Math::Vec4((float)p_value[0].GetNumber(), (float)p_value[1].GetNumber(), (float)p_value[2].GetNumber(), (float)p_value[3].GetNumber());
+        }
+    }
+
+    GltfScene GltfAsset::CreateScene() const
+    {
+        auto asset = shared_from_this();
+        auto meshes = DecodeMeshes();
+        std::string directory = std::filesystem::path(path).parent_path().string();
+
+        auto& images = document["images"];
+        std::vector<std::shared_ptr<SharedImage>> shared_images(images.GetSize());
+        for (size_t i = 0; i < images.GetSize(); ++i)
+        {
+            auto image = std::make_shared<SharedImage>();
+            auto& uri = images[i]["uri"].GetString();
+            double buffer_view = images[i]["bufferView"].GetNumber(-1.0);
+            if (buffer_view >= 0.0)
+            {
+                image->asset = asset;
+                image->data = GetBufferView((size_t)buffer_view);
+            }
+            else if (!uri.empty() && !uri.starts_with("data:"))
+                image->path = (std::filesystem::path(directory) / uri).string();
+            shared_images[i] = std::move(image);
+        }
+        auto& textures = document["textures"];
+        auto get_texture = [&](const Json& p_info, size_t p_channel, std::vector<ubyte_t> p_fallback,
+            std::shared_ptr<ATexture> p_placeholder, TextureContent p_content = TextureContent::LINEAR) -> std::shared_ptr<ATexture> {
+            double texture = p_info["index"].GetNumber(-1.0);
+            if (texture < 0.0 || texture >= textures.GetSize())
+                return nullptr;
+            double image = textures[(size_t)texture]["source"].GetNumber(-1.0);
+            if (image < 0.0 || image >= shared_images.size())
+                return nullptr;
+            TextureConfig config;
+            config.content = p_content;
+            auto result = std::make_shared<StaticTexture>(CreateDecoder(shared_images[(size_t)image], p_channel, std::move(p_fallback)), config);
+            result->SetPlaceholder(std::move(p_placeholder));
+            return result;
+        };
+
+        GltfScene scene;
+        auto& materials = document["materials"];
+        for (size_t i = 0; i < materials.GetSize(); ++i)
+        {
+            auto& material = materials[i];
+            auto& pbr = material["pbrMetallicRoughness"];
+            auto result = std::make_shared<PBRMaterial>(GetVec4(pbr["baseColorFactor"], Math::Vec4(1.0f, 1.0f, 1.0f, 1.0f)),
+                (float)pbr["roughnessFactor"].GetNumber(1.0), (float)pbr["metallicFactor"].GetNumber(1.0),
+                material["alphaMode"].GetString() == "BLEND");
+            if (auto texture = get_texture(pbr["baseColorTexture"], SIZE_MAX, {255, 255, 255, 255}, Graphics::GetDefaultAlbedo(),
+                TextureContent::SRGB))
+                result->Albedo() = texture;
+            // The roughness is in the green channel and the metallic in the blue channel.
+            if (auto texture = get_texture(pbr["metallicRoughnessTexture"], 1, {255}, Graphics::GetDefaultRoughness()))
+                result->Roughness() = texture;
+            if (auto texture = get_texture(pbr["metallicRoughnessTexture"], 2, {255}, Graphics::GetDefaultMetallic()))
+                result->Metallic() = texture;
+            if (auto texture = get_texture(material["normalTexture"], SIZE_MAX, {128, 128, 255}, Graphics::GetDefaultNormal(),
+                TextureContent::NORMAL))
+                result->Normal() = texture;
+            if (auto texture = get_texture(material["occlusionTexture"], 0, {255}, Graphics::GetDefaultAO()))
+                result->AO() = texture;
+            scene.materials.push_back(std::move(result));
+        }
+
+        // The mesh data of a mesh is shared by every node drawing it.
+        std::vector<std::vector<std::shared_ptr<MeshData>>> mesh_data(meshes.size());
+        auto& nodes = document["nodes"];
+        std::vector<bool> is_visited(nodes.GetSize(), false);
+        auto create_node = [&](auto& p_create_node, size_t p_node, Component3D& p_parent) -> void {
+            if (p_node >= nodes.GetSize() || is_visited[p_node])
+                throw std::runtime_error("Invalid glTF file: \"" + path + "\", invalid node hierarchy.");
+            is_visited[p_node] = true;
+            auto& node = nodes[p_node];
+            auto component = std::make_shared<Component3D>(node["name"].IsString() ? node["name"].GetString() : "node " + std::to_string(p_node));
+            GetNodeTransform(p_node, component->Position(), component->Rotation(), component->Scale());
+            p_parent.AddChild(component);
+            scene.components.push_back(component);
+
+            double mesh = node["mesh"].GetNumber(-1.0);
+            if (mesh >= 0.0 && mesh < meshes.size())
+            {
+                auto& primitives = meshes[(size_t)mesh];
+                mesh_data[(size_t)mesh].resize(primitives.size());
+                for (size_t i = 0; i < primitives.size(); ++i)
+                {
+                    if (primitives[i].cache == nullptr)
+                        continue;
+                    auto& data = mesh_data[(size_t)mesh][i];
+                    if (data == nullptr)
+                        data = std::make_shared<MeshData>(primitives[i].cache);
+                    auto static_mesh = std::make_shared<StaticMesh>(data, component->GetName() + " primitive " + std::to_string(i));
+                    if (primitives[i].material >= 0 && (size_t)primitives[i].material < scene.materials.size())
+                        static_mesh->SetMaterial(scene.materials[primitives[i].material]);
+                    component->AddChild(static_mesh);
+                    scene.components.push_back(static_mesh);
+                }
+            }
+            auto& children = node["children"];
+            for (size_t i = 0; i < children.GetSize(); ++i)
+            {
+                double child = children[i].GetNumber(-1.0);
+                p_create_node(p_create_node, child < 0.0 ? SIZE_MAX : (size_t)child, *component);
+            }
+        };
+
+        scene.root = std::make_shared<Component3D>(std::filesystem::path(path).stem().string());
+        for (auto root : GetRootNodes())
+            create_node(create_node, root, *scene.root);
+        return scene;
+    }
+}
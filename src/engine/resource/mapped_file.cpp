@@ -0,0 +1,130 @@
+#include "ce/resource/mapped_file.h"
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace CrossEngine
+{
+    namespace
+    {
+        // The handles of the file are closed once it is mapped, the view keeps the mapping alive.
+        void* MapFile(const std::string& p_path, size_t& p_size, bool& p_is_opened)
+        {
+#ifdef _WIN32
+            HANDLE file = CreateFileA(p_path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+            if (file == INVALID_HANDLE_VALUE)
+                return nullptr;
+            p_is_opened = true;
+            LARGE_INTEGER file_size;
+            if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0)
+            {
+                p_size = 0;
+                CloseHandle(file);
+                return nullptr;
+            }
+            p_size = (size_t)file_size.QuadPart;
+            HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+            CloseHandle(file);
+            if (mapping == NULL)
+                return nullptr;
+            void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mapping);
+            return view;
+#else
+            int file = open(p_path.c_str(), O_RDONLY);
+            if (file == -1)
+                return nullptr;
+            p_is_opened = true;
+            struct stat file_stat;
+            if (fstat(file, &file_stat) == -1 || file_stat.st_size == 0)
+            {
+                p_size = 0;
+                close(file);
+                return nullptr;
+            }
+            p_size = (size_t)file_stat.st_size;
+            void* view = mmap(nullptr, p_size, PROT_READ, MAP_PRIVATE, file, 0);
+            close(file);
+            if (view == MAP_FAILED)
+                return nullptr;
+            madvise(view, p_size, MADV_SEQUENTIAL);
+            return view;
+#endif
+        }
+
+        void UnmapFile(void* p_view, size_t p_size) noexcept
+        {
+#ifdef _WIN32
+            UnmapViewOfFile(p_view);
+#else
+            munmap(p_view, p_size);
+#endif
+        }
+    }
+
+    MappedFile::MappedFile(const std::string& p_path)
+    {
+        bool is_opened = false;
+        mapping = MapFile(p_path, size, is_opened);
+        if (!is_opened)
+            throw std::runtime_error("Failed to open file: \"" + p_path + "\".");
+        if (mapping != nullptr)
+        {
+            data = static_cast<const byte_t*>(mapping);
+            return;
+        }
+        if (size == 0)
+            return;
+
+        std::ifstream file(p_path.c_str(), std::ios::binary);
+        if (!file.is_open())
+            throw std::runtime_error("Failed to open file: \"" + p_path + "\".");
+        buffer = std::make_unique<byte_t[]>(size);
+        file.read(buffer.get(), size);
+        size = file.gcount();
+        data = buffer.get();
+    }
+
+    MappedFile::MappedFile(MappedFile&& p_other) noexcept
+        : data(std::exchange(p_other.data, nullptr)), size(std::exchange(p_other.size, 0)),
+        mapping(std::exchange(p_other.mapping, nullptr)), buffer(std::move(p_other.buffer))
+    {
+    }
+
+    MappedFile& MappedFile::operator=(MappedFile&& p_other) noexcept
+    {
+        if (this == &p_other)
+            return *this;
+        Release();
+        data = std::exchange(p_other.data, nullptr);
+        size = std::exchange(p_other.size, 0);
+        mapping = std::exchange(p_other.mapping, nullptr);
+        buffer = std::move(p_other.buffer);
+        return *this;
+    }
+
+    MappedFile::~MappedFile()
+    {
+        Release();
+    }
+
+    void MappedFile::Release() noexcept
+    {
+        if (mapping != nullptr)
+            UnmapFile(mapping, size);
+        mapping = nullptr;
+        buffer.reset();
+        data = nullptr;
+        size = 0;
+    }
+}
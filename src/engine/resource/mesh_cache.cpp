@@ -0,0 +1,271 @@
+#include "ce/resource/mesh_cache.h"
+#include "ce/geometry/geometry_arena.h"
+#include "ce/resource/mapped_file.h"
+#include <filesystem>
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <cmath>
+#include <stdexcept>
+
+namespace CrossEngine
+{
+    namespace
+    {
+        constexpr char MAGIC[8] = {'C', 'E', 'M', 'E', 'S', 'H', '\0', '\0'};
+
+        constexpr size_t AlignUp(size_t p_size, size_t p_alignment)
+        {
+            return (p_size + p_alignment - 1) / p_alignment * p_alignment;
+        }
+
+        // FNV-1a over words, the content is only hashed to tell apart files with the same size.
+        uint64_t HashData(const byte_t* p_data, size_t p_size)
+        {
+            uint64_t hash = 14695981039346656037ull;
+            size_t i = 0;
+            for (; i + sizeof(uint64_t) <= p_size; i += sizeof(uint64_t))
+            {
+                uint64_t word;
+                std::memcpy(&word, p_data + i, sizeof(uint64_t));
+                hash = (hash ^ word) * 1099511628211ull;
+            }
+            for (; i < p_size; ++i)
+                hash = (hash ^ (uint8_t)p_data[i]) * 1099511628211ull;
+            return hash;
+        }
+
+        bool IsRangeValid(uint64_t p_offset, uint64_t p_count, size_t p_element_size, size_t p_size)
+        {
+            return p_offset % MeshCache::ALIGNMENT == 0 && p_offset <= p_size
+                && p_count <= (p_size - p_offset) / p_element_size;
+        }
+    }
+
+    MeshCache::MeshCache(const std::string& p_path)
+        : file(VirtualFileSystem::GetInstance().Open(p_path))
+    {
+        data = reinterpret_cast<const std::byte*>(file.GetData());
+        size = file.GetSize();
+        Validate(p_path);
+    }
+
+    void MeshCache::Validate(const std::string& p_name) const
+    {
+        if (size < sizeof(MeshCacheHeader) || std::memcmp(GetHeader().magic, MAGIC, sizeof(MAGIC)) != 0)
+            throw std::runtime_error("Invalid mesh cache: \"" + p_name + "\".");
+        auto& header = GetHeader();
+        if (header.version != VERSION)
+            throw std::runtime_error("Mesh cache version mismatch: \"" + p_name + "\".");
+        if (header.vertex_stride != Vertex::ARRAY_SIZE
+            || !IsRangeValid(header.vertex_offset, header.vertex_count, Vertex::ARRAY_SIZE * sizeof(float), size)
+            || !IsRangeValid(header.index_offset, header.index_count, sizeof(uint32_t), size)
+            || !IsRangeValid(header.lod_offset, header.lod_count, sizeof(MeshCacheLod), size)
+            || header.lod_count == 0)
+            throw std::runtime_error("Invalid mesh cache: \"" + p_name + "\".");
+        for (size_t i = 0; i < header.lod_count; ++i)
+        {
+            auto& lod = GetLod(i);
+            if ((uint64_t)lod.first_vertex + lod.vertex_count > header.vertex_count
+                || (uint64_t)lod.first_index + lod.index_count > header.index_count
+                || (lod.index_count == 0 ? lod.vertex_count : lod.index_count) % 3 != 0)
+                throw std::runtime_error("Invalid mesh cache: \"" + p_name + "\".");
+        }
+        const uint32_t* indices = GetIndices();
+        for (size_t i = 0; i < header.index_count; ++i)
+        {
+            if (indices[i] >= header.vertex_count)
+                throw std::runtime_error("Invalid mesh cache: \"" + p_name + "\".");
+        }
+    }
+
+    MeshCache MeshCache::Allocate(const std::vector<size_t>& p_lod_vertex_counts, const MeshCacheSource& p_source)
+    {
+        if (p_lod_vertex_counts.empty())
+            throw std::invalid_argument("A mesh cache needs at least one level of detail.");
+        size_t vertex_count = 0;
+        for (auto count : p_lod_vertex_counts)
+            vertex_count += count;
+        if (vertex_count > std::numeric_limits<uint32_t>::max())
+            throw std::invalid_argument("Too many vertices for a mesh cache.");
+
+        MeshCacheHeader header = {};
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.vertex_stride = Vertex::ARRAY_SIZE;
+        header.vertex_count = vertex_count;
+        header.index_count = 0;
+        header.lod_count = p_lod_vertex_counts.size();
+        header.lod_offset = AlignUp(sizeof(MeshCacheHeader), ALIGNMENT);
+        header.vertex_offset = AlignUp(header.lod_offset + p_lod_vertex_counts.size() * sizeof(MeshCacheLod), ALIGNMENT);
+        header.index_offset = AlignUp(header.vertex_offset + vertex_count * Vertex::ARRAY_SIZE * sizeof(float), ALIGNMENT);
+        header.source_size = p_source.size;
+        header.source_time = p_source.time;
+        header.source_hash = p_source.hash;
+
+        MeshCache result;
+        result.memory.resize(header.index_offset);
+        result.data = result.memory.data();
+        result.size = result.memory.size();
+        std::memcpy(result.memory.data(), &header, sizeof(MeshCacheHeader));
+        auto lods = reinterpret_cast<MeshCacheLod*>(result.memory.data() + header.lod_offset);
+        size_t first_vertex = 0;
+        for (size_t i = 0; i < p_lod_vertex_counts.size(); ++i)
+        {
+            lods[i] = {(uint32_t)first_vertex, (uint32_t)p_lod_vertex_counts[i], 0, 0};
+            first_vertex += p_lod_vertex_counts[i];
+        }
+        return result;
+    }
+
+    void MeshCache::UpdateBounds() noexcept
+    {
+        auto& header = *reinterpret_cast<MeshCacheHeader*>(memory.data());
+        const float* vertices = GetVertices();
+        Math::Vec4 bounds_min = Math::Pos(INFINITY, INFINITY, INFINITY);
+        Math::Vec4 bounds_max = Math::Pos(-INFINITY, -INFINITY, -INFINITY);
+        for (size_t i = 0; i < header.vertex_count; ++i)
+        {
+            for (size_t k = 0; k < 3; ++k)
+            {
+                bounds_min[k] = std::min(bounds_min[k], vertices[i * Vertex::ARRAY_SIZE + k]);
+                bounds_max[k] = std::max(bounds_max[k], vertices[i * Vertex::ARRAY_SIZE + k]);
+            }
+        }
+        for (size_t k = 0; k < 3; ++k)
+        {
+            header.bounds_min[k] = header.vertex_count == 0 ? 0.0f : bounds_min[k];
+            header.bounds_max[k] = header.vertex_count == 0 ? 0.0f : bounds_max[k];
+        }
+    }
+
+    MeshCache MeshCache::Create(const std::vector<std::vector<Triangle*>>& p_lods, const MeshCacheSource& p_source)
+    {
+        std::vector<size_t> lod_vertex_counts;
+        lod_vertex_counts.reserve(p_lods.size());
+        for (auto& lod : p_lods)
+            lod_vertex_counts.push_back(lod.size() * 3);
+        MeshCache result = Allocate(lod_vertex_counts, p_source);
+
+        // The vertices are drawn as arrays from the vertex arena, so the stream is written without indices.
+        float* vertices = result.GetVertexData();
+        for (auto& lod : p_lods)
+        {
+            for (auto triangle : lod)
+            {
+                triangle->GetVertexArray(vertices, Triangle::TRIANGLE_ARRAY_SIZE);
+                vertices += Triangle::TRIANGLE_ARRAY_SIZE;
+            }
+        }
+        result.UpdateBounds();
+        return result;
+    }
+
+    MeshCache MeshCache::Create(size_t p_vertex_count, const std::function<void(float* p_vertices)>& p_write, const MeshCacheSource& p_source)
+    {
+        if (p_vertex_count % 3 != 0)
+            throw std::invalid_argument("The vertex count of a mesh cache should be a multiple of 3.");
+        MeshCache result = Allocate({p_vertex_count}, p_source);
+        p_write(result.GetVertexData());
+        result.UpdateBounds();
+        return result;
+    }
+
+    std::string MeshCache::GetCachePath(const std::string& p_source_path)
+    {
+        return p_source_path + EXTENSION;
+    }
+
+    MeshCacheSource MeshCache::IdentifySource(const std::string& p_path, bool p_hash)
+    {
+        std::error_code error;
+        MeshCacheSource source;
+        source.size = std::filesystem::file_size(p_path, error);
+        if (error)
+            throw std::runtime_error("Failed to open file: \"" + p_path + "\".");
+        source.time = std::filesystem::last_write_time(p_path, error).time_since_epoch().count();
+        if (p_hash && source.size != 0)
+        {
+            MappedFile file(p_path);
+            source.hash = HashData(file.GetData(), file.GetSize());
+        }
+        return source;
+    }
+
+    std::unique_ptr<MeshCache> MeshCache::Open(const std::string& p_source_path)
+    {
+        std::string path = GetCachePath(p_source_path);
+        std::error_code error;
+        if (!std::filesystem::exists(path, error))
+            return nullptr;
+        try
+        {
+            auto cache = std::make_unique<MeshCache>(path);
+            if (!cache->IsUpToDate(p_source_path))
+                return nullptr;
+            return cache;
+        }
+        catch (const std::runtime_error&)
+        {
+            // Caches of older versions or broken caches are converted again.
+            return nullptr;
+        }
+    }
+
+    void MeshCache::Save(const std::string& p_path) const
+    {
+        std::string temp_path = p_path + ".tmp";
+        {
+            std::ofstream output(temp_path, std::ios::binary | std::ios::trunc);
+            if (!output.is_open())
+                throw std::runtime_error("Failed to write file: \"" + p_path + "\".");
+            output.write(reinterpret_cast<const char*>(data), size);
+            if (!output.good())
+                throw std::runtime_error("Failed to write file: \"" + p_path + "\".");
+        }
+        std::error_code error;
+        std::filesystem::rename(temp_path, p_path, error);
+        if (error)
+        {
+            std::filesystem::remove(temp_path, error);
+            throw std::runtime_error("Failed to write file: \"" + p_path + "\".");
+        }
+    }
+
+    bool MeshCache::IsUpToDate(const std::string& p_source_path) const
+    {
+        std::error_code error;
+        if (!std::filesystem::exists(p_source_path, error))
+            return true;
+        auto& header = GetHeader();
+        auto source = IdentifySource(p_source_path, false);
+        if (source.size != header.source_size)
+            return false;
+        if (source.time == header.source_time)
+            return true;
+        return IdentifySource(p_source_path).hash == header.source_hash;
+    }
+
+    void MeshCache::CreateTriangles(std::vector<Triangle*>& p_result, GeometryArena* p_arena, size_t p_lod) const
+    {
+        if (p_lod >= GetLodCount())
+            throw std::out_of_range("The level of detail is out of range.");
+        auto& lod = GetLod(p_lod);
+        const float* vertices = GetVertices();
+        const uint32_t* indices = GetIndices() + lod.first_index;
+        size_t corner_count = lod.index_count == 0 ? lod.vertex_count : lod.index_count;
+        auto create_vertex = [&](size_t p_corner) {
+            size_t index = lod.index_count == 0 ? lod.first_vertex + p_corner : indices[p_corner];
+            const float* vertex = vertices + index * Vertex::ARRAY_SIZE;
+            return Vertex(Math::Pos(vertex[0], vertex[1], vertex[2]), Math::Vec4(vertex[3], vertex[4], vertex[5], 0),
+                Math::Vec2(vertex[6], vertex[7]));
+        };
+        p_result.reserve(p_result.size() + corner_count / 3);
+        for (size_t i = 0; i < corner_count; i += 3)
+        {
+            Vertex v1 = create_vertex(i), v2 = create_vertex(i + 1), v3 = create_vertex(i + 2);
+            p_result.push_back(p_arena != nullptr ? p_arena->CreateTriangle(v1, v2, v3) : new Triangle(v1, v2, v3));
+        }
+    }
+}
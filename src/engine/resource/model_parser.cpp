@@ -0,0 +1,412 @@
+#include "ce/resource/model_parser.h"
+#include "ce/geometry/polygon.h"
+#include "ce/geometry/geometry_arena.h"
+#include "ce/utils/job_system.h"
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+
+namespace CrossEngine
+{
+    namespace
+    {
+        FORCE_INLINE bool IsSpace(byte_t p_char)
+        {
+            return p_char == ' ' || p_char == '\t' || p_char == '\r';
+        }
+
+        FORCE_INLINE const byte_t* SkipSpaces(const byte_t* p, const byte_t* p_end)
+        {
+            while (p < p_end && IsSpace(*p))
+                ++p;
+            return p;
+        }
+
+        FORCE_INLINE const byte_t* SkipWhitespaces(const byte_t* p, const byte_t* p_end)
+        {
+            while (p < p_end && (IsSpace(*p) || *p == '\n'))
+                ++p;
+            return p;
+        }
+
+        FORCE_INLINE const byte_t* SkipLine(const byte_t* p, const byte_t* p_end)
+        {
+            auto line_end = static_cast<const byte_t*>(std::memchr(p, '\n', p_end - p));
+            return line_end == nullptr ? p_end : line_end + 1;
+        }
+
+        template <typename T>
+        FORCE_INLINE const byte_t* ParseNumber(const byte_t* p, const byte_t* p_end, T& p_value, const char* p_error)
+        {
+            if (p < p_end && *p == '+')
+                ++p;
+            auto [next, error] = std::from_chars(p, p_end, p_value);
+            if (error == std::errc::invalid_argument)
+                throw std::runtime_error(p_error);
+            if (error == std::errc::result_out_of_range)
+            {
+                // from_chars leaves the value as it is, so numbers too large are clamped to the range of the
+                // type, and numbers too small are flushed to 0.
+                bool is_negative = *p == '-';
+                if constexpr (std::is_floating_point_v<T>)
+                {
+                    double value = std::abs(std::strtod(std::string(p, next).c_str(), nullptr));
+                    if (value > std::numeric_limits<T>::max())
+                        p_value = std::numeric_limits<T>::max();
+                    else if (value < std::numeric_limits<T>::min())
+                        p_value = 0;
+                    else
+                        p_value = static_cast<T>(value);
+                    if (is_negative)
+                        p_value = -p_value;
+                }
+                else
+                    p_value = is_negative ? std::numeric_limits<T>::min() : std::numeric_limits<T>::max();
+            }
+            return next;
+        }
+
+        std::vector<std::string_view> SplitChunks(std::string_view p_text)
+        {
+            // A chunk for each worker and the calling thread.
+            size_t thread_count = JobSystem::GetInstance().GetWorkerCount() + 1;
+            size_t chunk_count = std::clamp(p_text.size() / ModelParser::MIN_CHUNK_SIZE, (size_t)1, thread_count);
+            size_t chunk_size = p_text.size() / chunk_count;
+            std::vector<std::string_view> chunks;
+            chunks.reserve(chunk_count);
+            size_t begin = 0;
+            for (size_t i = 1; i < chunk_count && begin < p_text.size(); ++i)
+            {
+                size_t end = p_text.find('\n', std::max(begin, i * chunk_size));
+                end = end == std::string_view::npos ? p_text.size() : end + 1;
+                chunks.push_back(p_text.substr(begin, end - begin));
+                begin = end;
+            }
+            if (begin < p_text.size())
+                chunks.push_back(p_text.substr(begin));
+            return chunks;
+        }
+
+        template <typename T, typename F>
+        std::vector<T> ParseChunks(const std::vector<std::string_view>& p_chunks, F&& p_parse)
+        {
+            std::vector<T> results(p_chunks.size());
+            JobSystem::GetInstance().ParallelFor(p_chunks.size(), 1, [&](size_t p_first, size_t p_last) {
+                for (size_t i = p_first; i < p_last; ++i)
+                    p_parse(p_chunks[i], results[i], i);
+            });
+            return results;
+        }
+
+        Triangle* CreateTriangle(GeometryArena* p_arena, const Vertex& p_v1, const Vertex& p_v2, const Vertex& p_v3)
+        {
+            if (p_arena != nullptr)
+                return p_arena->CreateTriangle(p_v1, p_v2, p_v3);
+            return new Triangle(p_v1, p_v2, p_v3);
+        }
+
+        /**
+         * @brief Reads the numbers parsed from the chunks of a text in the order of the text.
+         */
+        class ChunkReader
+        {
+        private:
+            const std::vector<std::vector<real_t>>& chunks;
+            size_t chunk = 0;
+            size_t index = 0;
+        public:
+            explicit ChunkReader(const std::vector<std::vector<real_t>>& p_chunks)
+                : chunks(p_chunks) {}
+
+            FORCE_INLINE real_t Next()
+            {
+                while (index >= chunks[chunk].size())
+                {
+                    ++chunk;
+                    index = 0;
+                }
+                return chunks[chunk][index++];
+            }
+
+            FORCE_INLINE Math::Vec4 NextVec4(real_t p_w)
+            {
+                real_t x = Next();
+                real_t y = Next();
+                return Math::Vec4(x, y, Next(), p_w);
+            }
+        };
+
+        std::vector<std::vector<real_t>> ParseTrisNumbers(std::string_view p_text, size_t p_numbers_per_triangle, size_t& p_tri_count)
+        {
+            const byte_t* p = SkipWhitespaces(p_text.data(), p_text.data() + p_text.size());
+            p = ParseNumber(p, p_text.data() + p_text.size(), p_tri_count, "Invalid tris file.");
+            p_text.remove_prefix(p - p_text.data());
+
+            auto numbers = ParseChunks<std::vector<real_t>>(SplitChunks(p_text),
+                [](std::string_view p_chunk, std::vector<real_t>& p_numbers, size_t) {
+                    const byte_t* end = p_chunk.data() + p_chunk.size();
+                    // A number takes at least two bytes with its separator.
+                    p_numbers.reserve(p_chunk.size() / 8);
+                    for (const byte_t* p = SkipWhitespaces(p_chunk.data(), end); p < end; p = SkipWhitespaces(p, end))
+                    {
+                        real_t value = 0;
+                        p = ParseNumber(p, end, value, "Invalid tris file.");
+                        p_numbers.push_back(value);
+                    }
+                });
+
+            size_t number_count = 0;
+            for (auto& chunk : numbers)
+                number_count += chunk.size();
+            if (number_count < p_tri_count * p_numbers_per_triangle)
+                throw std::runtime_error("Invalid tris file.");
+            return numbers;
+        }
+
+        struct ObjChunk
+        {
+            std::vector<real_t> positions;
+            std::vector<real_t> tex_coords;
+            std::vector<real_t> normals;
+            // The position, texture coordinate and normal indices of every corner of the faces, -1 if left out.
+            std::vector<int32_t> corners;
+            std::vector<uint32_t> face_sizes;
+        };
+
+        struct ObjCounts
+        {
+            int32_t positions = 0;
+            int32_t tex_coords = 0;
+            int32_t normals = 0;
+        };
+
+        FORCE_INLINE const byte_t* ParseNumbers(const byte_t* p, const byte_t* p_end, size_t p_count, std::vector<real_t>& p_result)
+        {
+            for (size_t i = 0; i < p_count; ++i)
+            {
+                real_t value = 0;
+                p = ParseNumber(SkipSpaces(p, p_end), p_end, value, "Invalid obj file.");
+                p_result.push_back(value);
+            }
+            return p;
+        }
+
+        FORCE_INLINE const byte_t* ParseIndex(const byte_t* p, const byte_t* p_end, int32_t p_count, int32_t p_total, int32_t& p_index)
+        {
+            int32_t index = 0;
+            p = ParseNumber(p, p_end, index, "Invalid obj file.");
+            if (index == 0)
+                throw std::runtime_error("Invalid obj file.");
+            // Negative indices count back from the last element defined before the face.
+            index = index > 0 ? index - 1 : p_count + index;
+            if (index < 0 || index >= p_total)
+                throw std::runtime_error("Invalid obj file.");
+            p_index = index;
+            return p;
+        }
+
+        /**
+         * @brief Parse the attributes of the lines of a chunk, the faces are left to the second pass.
+         */
+        void ParseObjAttributes(std::string_view p_chunk, ObjChunk& p_result)
+        {
+            const byte_t* p = p_chunk.data();
+            const byte_t* end = p + p_chunk.size();
+            while (p < end)
+            {
+                p = SkipSpaces(p, end);
+                if (end - p > 2 && p[0] == 'v')
+                {
+                    if (IsSpace(p[1]))
+                        ParseNumbers(p + 1, end, 3, p_result.positions);
+                    else if (p[1] == 't' && IsSpace(p[2]))
+                        ParseNumbers(p + 2, end, 2, p_result.tex_coords);
+                    else if (p[1] == 'n' && IsSpace(p[2]))
+                        ParseNumbers(p + 2, end, 3, p_result.normals);
+                }
+                p = SkipLine(p, end);
+            }
+        }
+
+        /**
+         * @brief Parse the faces of the lines of a chunk. The counts are the elements defined before the chunk.
+         */
+        void ParseObjFaces(std::string_view p_chunk, ObjChunk& p_result, ObjCounts p_counts, const ObjCounts& p_totals)
+        {
+            const byte_t* p = p_chunk.data();
+            const byte_t* end = p + p_chunk.size();
+            while (p < end)
+            {
+                p = SkipSpaces(p, end);
+                if (end - p > 2 && p[0] == 'v')
+                {
+                    if (IsSpace(p[1]))
+                        ++p_counts.positions;
+                    else if (p[1] == 't' && IsSpace(p[2]))
+                        ++p_counts.tex_coords;
+                    else if (p[1] == 'n' && IsSpace(p[2]))
+                        ++p_counts.normals;
+                }
+                else if (end - p > 1 && p[0] == 'f' && IsSpace(p[1]))
+                {
+                    uint32_t face_size = 0;
+                    for (p = SkipSpaces(p + 1, end); p < end && *p != '\n'; p = SkipSpaces(p, end))
+                    {
+                        int32_t corner[3] = {-1, -1, -1};
+                        p = ParseIndex(p, end, p_counts.positions, p_totals.positions, corner[0]);
+                        if (p < end && *p == '/')
+                        {
+                            ++p;
+                            if (p < end && *p != '/')
+                                p = ParseIndex(p, end, p_counts.tex_coords, p_totals.tex_coords, corner[1]);
+                            if (p < end && *p == '/')
+                                p = ParseIndex(p + 1, end, p_counts.normals, p_totals.normals, corner[2]);
+                        }
+                        if (p < end && !IsSpace(*p) && *p != '\n')
+                            throw std::runtime_error("Invalid obj file.");
+                        p_result.corners.insert(p_result.corners.end(), corner, corner + 3);
+                        ++face_size;
+                    }
+                    if (face_size < 3)
+                        throw std::runtime_error("Invalid obj file.");
+                    p_result.face_sizes.push_back(face_size);
+                }
+                p = SkipLine(p, end);
+            }
+        }
+
+        template <typename T>
+        std::vector<T> MergeChunks(std::vector<ObjChunk>& p_chunks, std::vector<T> ObjChunk::* p_member)
+        {
+            size_t size = 0;
+            for (auto& chunk : p_chunks)
+                size += (chunk.*p_member).size();
+            std::vector<T> result;
+            result.reserve(size);
+            for (auto& chunk : p_chunks)
+            {
+                result.insert(result.end(), (chunk.*p_member).begin(), (chunk.*p_member).end());
+                std::vector<T>().swap(chunk.*p_member);
+            }
+            return result;
+        }
+    }
+
+    void ModelParser::ParseTris(std::string_view p_text, std::vector<Triangle*>& p_result, GeometryArena* p_arena)
+    {
+        size_t tri_count;
+        auto numbers = ParseTrisNumbers(p_text, 9, tri_count);
+        ChunkReader reader(numbers);
+        p_result.reserve(p_result.size() + tri_count);
+        for (size_t i = 0; i < tri_count; ++i)
+        {
+            Vertex v1(reader.NextVec4(1));
+            Vertex v2(reader.NextVec4(1));
+            Vertex v3(reader.NextVec4(1));
+            Triangle* triangle = CreateTriangle(p_arena, v1, v2, v3);
+            for (size_t j = 0; j < 3; ++j)
+                triangle->GetVertex(j)->ResetNormal();
+            p_result.push_back(triangle);
+        }
+    }
+
+    void ModelParser::ParseTrisWithNormal(std::string_view p_text, std::vector<Triangle*>& p_result, GeometryArena* p_arena)
+    {
+        size_t tri_count;
+        auto numbers = ParseTrisNumbers(p_text, 18, tri_count);
+        ChunkReader reader(numbers);
+        p_result.reserve(p_result.size() + tri_count);
+        for (size_t i = 0; i < tri_count; ++i)
+        {
+            Vertex vertices[3];
+            for (auto& vertex : vertices)
+            {
+                vertex.Position() = reader.NextVec4(1);
+                vertex.Normal() = reader.NextVec4(0);
+            }
+            p_result.push_back(CreateTriangle(p_arena, vertices[0], vertices[1], vertices[2]));
+        }
+    }
+
+    void ModelParser::ParseObj(std::string_view p_text, std::vector<Triangle*>& p_result, GeometryArena* p_arena)
+    {
+        auto chunk_texts = SplitChunks(p_text);
+        auto chunks = ParseChunks<ObjChunk>(chunk_texts, [](std::string_view p_chunk, ObjChunk& p_result, size_t) {
+            ParseObjAttributes(p_chunk, p_result);
+        });
+
+        // The faces index every element of the file, so they are parsed once the elements of the previous
+        // chunks are counted.
+        std::vector<ObjCounts> offsets(chunks.size());
+        ObjCounts totals;
+        for (size_t i = 0; i < chunks.size(); ++i)
+        {
+            offsets[i] = totals;
+            totals.positions += (int32_t)(chunks[i].positions.size() / 3);
+            totals.tex_coords += (int32_t)(chunks[i].tex_coords.size() / 2);
+            totals.normals += (int32_t)(chunks[i].normals.size() / 3);
+        }
+        ParseChunks<int>(chunk_texts, [&](std::string_view p_chunk, int&, size_t p_index) {
+            ParseObjFaces(p_chunk, chunks[p_index], offsets[p_index], totals);
+        });
+
+        auto positions = MergeChunks(chunks, &ObjChunk::positions);
+        auto tex_coords = MergeChunks(chunks, &ObjChunk::tex_coords);
+        auto normals = MergeChunks(chunks, &ObjChunk::normals);
+        auto create_vertex = [&](const int32_t* p_corner) {
+            Vertex vertex;
+            const real_t* position = positions.data() + p_corner[0] * 3;
+            vertex.Position() = Math::Pos(position[0], position[1], position[2]);
+            if (p_corner[1] >= 0)
+                vertex.UV() = Math::Vec2(tex_coords[p_corner[1] * 2], tex_coords[p_corner[1] * 2 + 1]);
+            if (p_corner[2] >= 0)
+            {
+                const real_t* normal = normals.data() + p_corner[2] * 3;
+                vertex.Normal() = Math::Vec4(normal[0], normal[1], normal[2], 0);
+            }
+            return vertex;
+        };
+
+        size_t tri_count = 0;
+        for (auto& chunk : chunks)
+            for (auto face_size : chunk.face_sizes)
+                tri_count += face_size - 2;
+        p_result.reserve(p_result.size() + tri_count);
+        for (auto& chunk : chunks)
+        {
+            const int32_t* corner = chunk.corners.data();
+            for (auto face_size : chunk.face_sizes)
+            {
+                bool has_normals = true;
+                for (uint32_t i = 0; i < face_size; ++i)
+                    has_normals = has_normals && corner[i * 3 + 2] >= 0;
+                size_t first = p_result.size();
+                if (face_size == 3)
+                {
+                    p_result.push_back(CreateTriangle(p_arena, create_vertex(corner), create_vertex(corner + 3),
+                        create_vertex(corner + 6)));
+                }
+                else
+                {
+                    PolygonN poly;
+                    for (uint32_t i = 0; i < face_size; ++i)
+                        poly.AddVertex(poly.GetVertexCount(), new Vertex(create_vertex(corner + i * 3)));
+                    poly.Triangulate(p_result, p_arena);
+                }
+                if (!has_normals)
+                {
+                    for (size_t i = first; i < p_result.size(); ++i)
+                        for (size_t j = 0; j < 3; ++j)
+                            p_result[i]->GetVertex(j)->ResetNormal();
+                }
+                corner += face_size * 3;
+            }
+        }
+    }
+}
@@ -0,0 +1,302 @@
+#include "ce/resource/pack_file.h"
+#include <fstream>
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+
+namespace CrossEngine
+{
+    namespace
+    {
+        // Entries smaller than a page are packed closer, so many small files do not pad the pack to pages.
+        constexpr size_t SMALL_ENTRY_ALIGNMENT = 16;
+        // The last bytes of a block are always literals, and the last match starts before them.
+        constexpr size_t LAST_LITERALS = 5;
+        constexpr size_t MATCH_LIMIT = 12;
+        constexpr size_t MIN_MATCH = 4;
+        constexpr size_t MAX_OFFSET = 65535;
+        constexpr size_t HASH_BITS = 16;
+
+        FORCE_INLINE size_t AlignUp(size_t p_value, size_t p_alignment) noexcept
+        {
+            return (p_value + p_alignment - 1) / p_alignment * p_alignment;
+        }
+
+        FORCE_INLINE uint32_t Load32(const byte_t* p_data) noexcept
+        {
+            uint32_t result;
+            std::memcpy(&result, p_data, sizeof(uint32_t));
+            return result;
+        }
+
+        void WriteLength(std::vector<byte_t>& p_result, size_t p_length)
+        {
+            for (; p_length >= 255; p_length -= 255)
+                p_result.push_back((byte_t)255);
+            p_result.push_back((byte_t)p_length);
+        }
+
+        void WriteSequence(std::vector<byte_t>& p_result, const byte_t* p_literals, size_t p_literal_count,
+            size_t p_offset, size_t p_match_length)
+        {
+            size_t match_code = p_match_length == 0 ? 0 : p_match_length - MIN_MATCH;
+            p_result.push_back((byte_t)((std::min<size_t>(p_literal_count, 15) << 4) | std::min<size_t>(match_code, 15)));
+            if (p_literal_count >= 15)
+                WriteLength(p_result, p_literal_count - 15);
+            p_result.insert(p_result.end(), p_literals, p_literals + p_literal_count);
+            if (p_match_length == 0)
+                return;
+            p_result.push_back((byte_t)(p_offset & 0xFF));
+            p_result.push_back((byte_t)(p_offset >> 8));
+            if (match_code >= 15)
+                WriteLength(p_result, match_code - 15);
+        }
+
+        size_t ReadLength(const ubyte_t*& p_data, const ubyte_t* p_end, size_t p_length)
+        {
+            if (p_length != 15)
+                return p_length;
+            ubyte_t byte;
+            do
+            {
+                if (p_data >= p_end)
+                    throw std::runtime_error("Corrupted compressed data.");
+                byte = *p_data++;
+                p_length += byte;
+            } while (byte == 255);
+            return p_length;
+        }
+    }
+
+    PackFile::PackFile(const std::string& p_path)
+        : path(p_path), file(p_path)
+    {
+        auto invalid = [&]() { return std::runtime_error("Invalid pack file: \"" + path + "\"."); };
+        size_t size = file.GetSize();
+        if (size < sizeof(Header))
+            throw invalid();
+        header = reinterpret_cast<const Header*>(file.GetData());
+        if (header->magic != MAGIC || header->version != VERSION)
+            throw invalid();
+        if (header->slot_count == 0 || (header->slot_count & (header->slot_count - 1)) != 0
+            || header->entry_count >= header->slot_count
+            || header->table_offset % alignof(Entry) != 0 || header->table_offset > size
+            || header->slot_count > (size - header->table_offset) / sizeof(Entry)
+            || header->names_offset > size || header->names_size > size - header->names_offset)
+            throw invalid();
+        table = reinterpret_cast<const Entry*>(file.GetData() + header->table_offset);
+        names = file.GetData() + header->names_offset;
+        // The entries are checked once, so they are read without checks afterwards.
+        size_t entry_count = 0;
+        for (size_t i = 0; i < header->slot_count; ++i)
+        {
+            auto& entry = table[i];
+            if (entry.name_size == 0)
+                continue;
+            ++entry_count;
+            if (entry.name_offset > header->names_size || entry.name_size > header->names_size - entry.name_offset
+                || entry.offset > size || entry.stored_size > size - entry.offset
+                || (entry.compression == COMPRESSION_NONE && entry.stored_size != entry.size)
+                || (entry.compression != COMPRESSION_NONE && entry.compression != COMPRESSION_LZ4))
+                throw invalid();
+        }
+        if (entry_count != header->entry_count)
+            throw invalid();
+    }
+
+    uint64_t PackFile::HashName(std::string_view p_name) noexcept
+    {
+        uint64_t result = 14695981039346656037ull;
+        for (char c : p_name)
+        {
+            result ^= (ubyte_t)c;
+            result *= 1099511628211ull;
+        }
+        return result;
+    }
+
+    const PackFile::Entry* PackFile::Find(std::string_view p_name) const noexcept
+    {
+        uint64_t hash = HashName(p_name);
+        size_t mask = header->slot_count - 1;
+        for (size_t i = hash & mask, probe = 0; probe < header->slot_count; i = (i + 1) & mask, ++probe)
+        {
+            auto& entry = table[i];
+            if (entry.name_size == 0)
+                return nullptr;
+            if (entry.hash == hash && GetName(entry) == p_name)
+                return &entry;
+        }
+        return nullptr;
+    }
+
+    std::vector<const PackFile::Entry*> PackFile::GetEntries() const
+    {
+        std::vector<const Entry*> result;
+        result.reserve(header->entry_count);
+        for (size_t i = 0; i < header->slot_count; ++i)
+        {
+            if (table[i].name_size != 0)
+                result.push_back(table + i);
+        }
+        return result;
+    }
+
+    void PackFile::Read(const Entry& p_entry, byte_t* p_buffer) const
+    {
+        auto data = GetStoredData(p_entry);
+        if (p_entry.compression == COMPRESSION_NONE)
+            std::memcpy(p_buffer, data.data(), data.size());
+        else
+            Decompress(data.data(), data.size(), p_buffer, p_entry.size);
+    }
+
+    void PackFile::Create(const std::string& p_path, const std::vector<Source>& p_sources, bool p_compress)
+    {
+        size_t slot_count = 2;
+        while (slot_count < p_sources.size() * 2)
+            slot_count *= 2;
+        std::vector<Entry> entries(slot_count, Entry{});
+        std::vector<size_t> slots(p_sources.size());
+        std::string names;
+        for (size_t i = 0; i < p_sources.size(); ++i)
+        {
+            auto& name = p_sources[i].name;
+            if (name.empty())
+                throw std::runtime_error("The entries of a pack must have names.");
+            Entry entry{};
+            entry.hash = HashName(name);
+            entry.name_offset = (uint32_t)names.size();
+            entry.name_size = (uint32_t)name.size();
+            names += name;
+            size_t slot = entry.hash & (slot_count - 1);
+            while (entries[slot].name_size != 0)
+            {
+                if (entries[slot].hash == entry.hash && names.compare(entries[slot].name_offset, entries[slot].name_size, name) == 0)
+                    throw std::runtime_error("Duplicated pack entry: \"" + name + "\".");
+                slot = (slot + 1) & (slot_count - 1);
+            }
+            entries[slot] = entry;
+            slots[i] = slot;
+        }
+
+        Header header{};
+        header.magic = MAGIC;
+        header.version = VERSION;
+        header.entry_count = p_sources.size();
+        header.slot_count = slot_count;
+        header.table_offset = sizeof(Header);
+        header.names_offset = header.table_offset + slot_count * sizeof(Entry);
+        header.names_size = names.size();
+
+        std::ofstream output(p_path, std::ios::binary | std::ios::trunc);
+        if (!output.is_open())
+            throw std::runtime_error("Failed to open file: \"" + p_path + "\".");
+        // The data is written first, the table is written once the offsets are known.
+        size_t offset = AlignUp(header.names_offset + header.names_size, PAGE_SIZE);
+        const std::vector<char> padding(PAGE_SIZE, 0);
+        output.seekp(offset);
+        for (size_t i = 0; i < p_sources.size(); ++i)
+        {
+            auto& entry = entries[slots[i]];
+            MappedFile source(p_sources[i].path);
+            std::vector<byte_t> compressed;
+            const byte_t* data = source.GetData();
+            size_t stored_size = source.GetSize();
+            if (p_compress && source.GetSize() != 0)
+            {
+                compressed = Compress(source.GetData(), source.GetSize());
+                // Data that does not get smaller enough is stored as is, so it is read in place.
+                if (compressed.size() < source.GetSize() - source.GetSize() / 8)
+                {
+                    data = compressed.data();
+                    stored_size = compressed.size();
+                    entry.compression = COMPRESSION_LZ4;
+                }
+            }
+            size_t aligned = AlignUp(offset, stored_size >= PAGE_SIZE ? PAGE_SIZE : SMALL_ENTRY_ALIGNMENT);
+            output.write(padding.data(), aligned - offset);
+            entry.offset = aligned;
+            entry.size = source.GetSize();
+            entry.stored_size = stored_size;
+            output.write(data, stored_size);
+            offset = aligned + stored_size;
+        }
+        output.seekp(0);
+        output.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+        output.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(Entry));
+        output.write(names.data(), names.size());
+        if (!output.good())
+            throw std::runtime_error("Failed to write file: \"" + p_path + "\".");
+    }
+
+    std::vector<byte_t> PackFile::Compress(const byte_t* p_data, size_t p_size)
+    {
+        std::vector<byte_t> result;
+        result.reserve(p_size / 2 + 16);
+        size_t anchor = 0;
+        if (p_size > MATCH_LIMIT)
+        {
+            std::vector<uint32_t> positions(size_t(1) << HASH_BITS, UINT32_MAX);
+            size_t limit = p_size - MATCH_LIMIT;
+            size_t match_limit = p_size - LAST_LITERALS;
+            size_t i = 0;
+            while (i < limit)
+            {
+                uint32_t sequence = Load32(p_data + i);
+                uint32_t hash = (sequence * 2654435761u) >> (32 - HASH_BITS);
+                size_t candidate = positions[hash];
+                positions[hash] = (uint32_t)i;
+                if (candidate == UINT32_MAX || i - candidate > MAX_OFFSET || Load32(p_data + candidate) != sequence)
+                {
+                    ++i;
+                    continue;
+                }
+                size_t end = i + MIN_MATCH;
+                while (end < match_limit && p_data[end] == p_data[candidate + end - i])
+                    ++end;
+                WriteSequence(result, p_data + anchor, i - anchor, i - candidate, end - i);
+                i = end;
+                anchor = i;
+            }
+        }
+        WriteSequence(result, p_data + anchor, p_size - anchor, 0, 0);
+        return result;
+    }
+
+    void PackFile::Decompress(const byte_t* p_data, size_t p_size, byte_t* p_buffer, size_t p_buffer_size)
+    {
+        auto corrupted = []() { return std::runtime_error("Corrupted compressed data."); };
+        auto input = reinterpret_cast<const ubyte_t*>(p_data);
+        auto input_end = input + p_size;
+        auto output = reinterpret_cast<ubyte_t*>(p_buffer);
+        auto output_begin = output;
+        auto output_end = output + p_buffer_size;
+        while (input < input_end)
+        {
+            ubyte_t token = *input++;
+            size_t literal_count = ReadLength(input, input_end, token >> 4);
+            if (literal_count > (size_t)(input_end - input) || literal_count > (size_t)(output_end - output))
+                throw corrupted();
+            std::memcpy(output, input, literal_count);
+            input += literal_count;
+            output += literal_count;
+            if (input == input_end)
+                break;
+            if (input_end - input < 2)
+                throw corrupted();
+            size_t offset = input[0] | (input[1] << 8);
+            input += 2;
+            size_t match_length = ReadLength(input, input_end, token & 0x0F) + MIN_MATCH;
+            if (offset == 0 || offset > (size_t)(output - output_begin) || match_length > (size_t)(output_end - output))
+                throw corrupted();
+            // The match may overlap the bytes it writes, so it is copied forward byte by byte.
+            const ubyte_t* match = output - offset;
+            for (size_t i = 0; i < match_length; ++i)
+                output[i] = match[i];
+            output += match_length;
+        }
+        if (output != output_end)
+            throw corrupted();
+    }
+}
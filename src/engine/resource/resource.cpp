@@ -1,7 +1,18 @@
 #include "ce/resource/resource.h"
-#include "ce/geometry/polygon.h"
+#include "ce/resource/mapped_file.h"
+#include "ce/resource/virtual_file_system.h"
+#include "ce/resource/model_parser.h"
+#include "ce/resource/mesh_cache.h"
+#include "ce/resource/gltf.h"
+#include "ce/geometry/geometry_arena.h"
+#include "ce/graphics/mesh_data.h"
+#include "ce/texture/static_texture.h"
+#include <filesystem>
 #include <memory>
 #include <fstream>
+#include <algorithm>
+#include <cstring>
+#define NOMINMAX
 #include <windows.h>
 #include <functional>
 
@@ -10,79 +21,6 @@
 
 namespace CrossEngine
 {
-    static FORCE_INLINE bool IsAlpha(byte_t p_char)
-    {
-        return (p_char >= 'a' && p_char <= 'z') || (p_char >= 'A' && p_char <= 'Z');
-    }
-
-    static FORCE_INLINE bool IsDigit(byte_t p_char)
-    {
-        return (p_char >= '0' && p_char <= '9') || p_char == '.' || p_char == '-';
-    }
-
-    static byte_t* GetWord(byte_t* p_start, byte_t* buff, size_t buff_size)
-    {
-        for (size_t i = 0; i < buff_size; ++i)
-        {
-            if (!(IsAlpha(p_start[i]) || IsDigit(p_start[i]) || p_start[i] == '_'))
-            {
-                buff[i] = '\0';
-                return buff;
-            }
-            buff[i] = p_start[i];
-        }
-        buff[buff_size - 1] = '\0';
-        return buff;
-    }
-
-    static byte_t* GetLine(byte_t* p_start, byte_t* buff, size_t buff_size)
-    {
-        for (size_t i = 0; i < buff_size; ++i)
-        {
-            if (p_start[i] == '\n' || p_start[i] == '\0')
-            {
-                buff[i] = '\0';
-                return buff;
-            }
-            buff[i] = p_start[i];
-        }
-        buff[buff_size - 1] = '\0';
-        return buff;
-    }
-
-    static byte_t* MovePToNextSpace(byte_t** p, byte_t* p_end)
-    {
-        while (**p != '\n' && **p != ' ' && **p != '\t' && **p != '\0')
-        { 
-            if (*p >= p_end)
-                throw std::out_of_range("Out of range.");
-            ++(*p);
-        }
-        return *p;
-    }
-
-    static byte_t* MovePToNextWord(byte_t** p, byte_t* p_end)
-    {
-        while (IsAlpha(**p) || IsDigit(**p) || **p == '_')
-        {
-            if (*p >= p_end)
-                throw std::out_of_range("Out of range.");
-            ++(*p);
-        }
-        return *p;
-    }
-
-    static byte_t* MovePToNextLine(byte_t** p, byte_t* p_end)
-    {
-        while (**p != '\n' && **p != '\0')
-        { 
-            if (*p >= p_end)
-                throw std::out_of_range("Out of range.");
-            ++(*p);
-        }
-        return *p;
-    }
-
     std::string Resource::GetExeDirectory()
     {
         char buff[256];
@@ -102,99 +40,39 @@ namespace CrossEngine
 
     byte_t* Resource::LoadFile(const std::string& p_path)
     {
-        std::ifstream file(p_path.c_str(), std::ios::binary);
-        if (!file.is_open())
-            throw std::runtime_error("Failed to open file: \"" + p_path + "\".");
-        file.seekg(0, std::ios::end);
-        size_t size = file.tellg();
-        file.seekg(0, std::ios::beg);
-        byte_t* data = new byte_t[size];
-        file.read(reinterpret_cast<char*>(data), size);
-        file.close();
+        auto file = VirtualFileSystem::GetInstance().Open(p_path);
+        byte_t* data = new byte_t[file.GetSize()];
+        std::memcpy(data, file.GetData(), file.GetSize());
         return data;
     }
 
     byte_t* Resource::LoadFile(const std::string& p_path, size_t& p_size)
     {
-        std::ifstream file(p_path.c_str(), std::ios::binary);
-        if (!file.is_open())
-            throw std::runtime_error("Failed to open file: \"" + p_path + "\".");
-        file.seekg(0, std::ios::end);
-        p_size = file.tellg();
-        file.seekg(0, std::ios::beg);
+        auto file = VirtualFileSystem::GetInstance().Open(p_path);
+        p_size = file.GetSize();
         byte_t* data = new byte_t[p_size + 10]; // 10 bytes for safety
-        file.read(reinterpret_cast<char*>(data), p_size);
-        file.close();
+        std::memcpy(data, file.GetData(), p_size);
         return data;
     }
 
     byte_t* Resource::LoadFile(const std::string& p_path, byte_t* p_buffer, size_t p_buff_size)
     {
-        std::ifstream file(p_path.c_str(), std::ios::binary);
-        if (!file.is_open())
-            throw std::runtime_error("Failed to open file: \"" + p_path + "\".");
-        file.seekg(0, std::ios::end);
-        size_t size = file.tellg();
-        file.seekg(0, std::ios::beg);
-        for (size_t i = 0; i < size; i++)
-        {
-            if (i >= p_buff_size)
-                break;
-            file.read(reinterpret_cast<char*>(p_buffer + i), 1);
-        }
-        return p_buffer;
+        size_t size;
+        return LoadFile(p_path, p_buffer, p_buff_size, size);
     }
 
     byte_t* Resource::LoadFile(const std::string& p_path, byte_t* p_buffer, size_t p_buff_size, size_t& p_size)
     {
-        std::ifstream file(p_path.c_str(), std::ios::binary);
-        if (!file.is_open())
-            throw std::runtime_error("Failed to open file: \"" + p_path + "\".");
-        file.seekg(0, std::ios::end);
-        size_t size = file.tellg();
-        file.seekg(0, std::ios::beg);
-        for (size_t i = 0; i < size; i++)
-        {
-            if (i >= p_buff_size)
-                break;
-            file.read(reinterpret_cast<char*>(p_buffer + i), 1);
-        }
-        p_size = min(p_buff_size, size);
+        auto file = VirtualFileSystem::GetInstance().Open(p_path);
+        p_size = std::min(p_buff_size, file.GetSize());
+        std::memcpy(p_buffer, file.GetData(), p_size);
         return p_buffer;
     }
 
-    void Resource::LoadTris(const std::string& p_path, std::vector<Triangle*>& p_result)
+    void Resource::LoadTris(const std::string& p_path, std::vector<Triangle*>& p_result, GeometryArena* p_arena)
     {
-        size_t file_size;
-        auto data = std::unique_ptr<byte_t[]>(LoadFile(p_path.c_str(), file_size));
-        byte_t* p = data.get();
-        byte_t buff[256];
-        GetWord(p, buff, 256);
-        size_t tri_count = (size_t)std::atoi(buff);
-        MovePToNextSpace(&p, data.get() + file_size);
-        ++p;
-        
-        Math::Vec4 temp = Math::Pos();
-        p_result.reserve(tri_count);
-        for (size_t i = 0; i < tri_count; ++i)
-        {
-            Triangle* current_tri = new Triangle;
-            for (size_t j = 0; j < 3; ++j)
-            {
-                for (size_t k = 0; k < 3; ++k)
-                {
-                    GetWord(p, buff, 256);
-                    temp[k] = std::atof(buff);
-                    MovePToNextSpace(&p, data.get() + file_size);
-                    ++p;
-                }
-                current_tri->GetVertex(j)->SetPosition(temp);
-            }
-            for (size_t j = 0; j < 3; ++j)
-                current_tri->GetVertex(j)->ResetNormal();
-            p_result.push_back(current_tri);
-            ++p;
-        }
+        auto file = VirtualFileSystem::GetInstance().Open(p_path);
+        ModelParser::ParseTris(file.GetText(), p_result, p_arena);
     }
 
     std::vector<Triangle*> Resource::LoadTris(const std::string& p_path)
@@ -227,8 +105,9 @@ namespace CrossEngine
 
     void Resource::GetImageSize(const std::string& p_path, size_t& p_width, size_t& p_height, size_t& p_channels)
     {
-        int width, height, channels;
-        stbi_info(p_path.c_str(), &width, &height, &channels);
+        int width = 0, height = 0, channels = 0;
+        auto file = VirtualFileSystem::GetInstance().Open(p_path);
+        stbi_info_from_memory(reinterpret_cast<const ubyte_t*>(file.GetData()), (int)file.GetSize(), &width, &height, &channels);
         p_width = width;
         p_height = height;
         p_channels = channels;
@@ -237,10 +116,15 @@ namespace CrossEngine
     ubyte_t* Resource::LoadTextureImage(const std::string& p_path, ubyte_t* p_buffer, size_t p_buffer_size,
             size_t& p_width, size_t& p_height, size_t& p_channels)
     {
+        auto file = VirtualFileSystem::GetInstance().Open(p_path);
+        int width, height, channels;
         auto result = std::unique_ptr<ubyte_t[], std::function<decltype(stbi_image_free)>>(
-                stbi_load(p_path.c_str(), (int*)&p_width, (int*)&p_height, (int*)&p_channels, 0), stbi_image_free);
+                stbi_load_from_memory(reinterpret_cast<const ubyte_t*>(file.GetData()), (int)file.GetSize(), &width, &height, &channels, 0), stbi_image_free);
         if (result.get() == nullptr)
             throw std::runtime_error("Failed to load image at path: " + p_path + ".");
+        p_width = width;
+        p_height = height;
+        p_channels = channels;
         
         size_t image_size = p_width * p_height * p_channels;
 
@@ -253,6 +137,22 @@ namespace CrossEngine
         return p_buffer;
     }
 
+    ubyte_t* Resource::DecodeTextureImage(const ubyte_t* p_data, size_t p_size, size_t& p_width, size_t& p_height, size_t& p_channels)
+    {
+        int width, height, channels;
+        auto result = std::unique_ptr<ubyte_t[], std::function<decltype(stbi_image_free)>>(
+                stbi_load_from_memory(p_data, (int)p_size, &width, &height, &channels, 0), stbi_image_free);
+        if (result.get() == nullptr)
+            throw std::runtime_error("Failed to decode image.");
+        p_width = width;
+        p_height = height;
+        p_channels = channels;
+        size_t image_size = p_width * p_height * p_channels;
+        ubyte_t* buffer = new ubyte_t[image_size];
+        memcpy(buffer, result.get(), image_size * sizeof(ubyte_t));
+        return buffer;
+    }
+
     float* LoadHDRImage(const std::string& p_path, float* p_buffer, size_t p_buffer_size,
             size_t& p_width, size_t& p_height, size_t& p_channels)
     {
@@ -271,45 +171,10 @@ namespace CrossEngine
         return p_buffer;
     }
 
-    void Resource::LoadTrisWithNormal(const std::string& p_path, std::vector<Triangle*>& p_result)
+    void Resource::LoadTrisWithNormal(const std::string& p_path, std::vector<Triangle*>& p_result, GeometryArena* p_arena)
     {
-        size_t file_size;
-        auto data = std::unique_ptr<byte_t[]>(LoadFile(p_path.c_str(), file_size));
-        byte_t* p = data.get();
-        byte_t buff[256];
-        GetWord(p, buff, 256);
-        size_t tri_count = (size_t)std::atoi(buff);
-        MovePToNextSpace(&p, data.get() + file_size);
-        ++p;
-        
-        Math::Vec4 temp_pos = Math::Pos();
-        Math::Vec4 temp_normal = Math::Vec4();
-        p_result.reserve(tri_count);
-        for (size_t i = 0; i < tri_count; ++i)
-        {
-            Triangle* current_tri = new Triangle;
-            for (size_t j = 0; j < 3; ++j)
-            {
-                for (size_t k = 0; k < 3; ++k)
-                {
-                    GetWord(p, buff, 256);
-                    temp_pos[k] = std::atof(buff);
-                    MovePToNextSpace(&p, data.get() + file_size);
-                    ++p;
-                }
-                for (size_t k = 0; k < 3; ++k)
-                {
-                    GetWord(p, buff, 256);
-                    temp_normal[k] = std::atof(buff);
-                    MovePToNextSpace(&p, data.get() + file_size);
-                    ++p;
-                }
-                current_tri->GetVertex(j)->Position() = temp_pos;
-                current_tri->GetVertex(j)->Normal() = temp_normal;
-            }
-            p_result.push_back(current_tri);
-            ++p;
-        }
+        auto file = VirtualFileSystem::GetInstance().Open(p_path);
+        ModelParser::ParseTrisWithNormal(file.GetText(), p_result, p_arena);
     }
 
     float* Resource::CreateModelVertexArray(const std::initializer_list<Triangle*>& p_triangles, float* p_buffer, size_t p_buffer_size)
@@ -330,103 +195,159 @@ namespace CrossEngine
         return p_buffer;
     }
 
-    void Resource::LoadModel(const std::string& p_path, std::vector<Triangle*>& p_result)
+    void Resource::LoadModel(const std::string& p_path, std::vector<Triangle*>& p_result, GeometryArena* p_arena)
     {
         std::string ext = p_path.substr(p_path.find_last_of('.') + 1);
+        if ("." + ext == MeshCache::EXTENSION)
+        {
+            MeshCache(p_path).CreateTriangles(p_result, p_arena);
+            return;
+        }
+        if (ext == "glb")
+        {
+            LoadMeshCache(p_path)->CreateTriangles(p_result, p_arena);
+            return;
+        }
+        // Caches are kept next to the files on the disk, the files of packs are parsed every time.
+        auto disk_path = VirtualFileSystem::GetInstance().GetDiskPath(p_path);
+        if (disk_path.has_value())
+        {
+            if (auto cache = MeshCache::Open(*disk_path))
+            {
+                cache->CreateTriangles(p_result, p_arena);
+                return;
+            }
+        }
+        size_t first = p_result.size();
         if (ext == "tris")
-            LoadTris(p_path, p_result);
+            LoadTris(p_path, p_result, p_arena);
         else if (ext == "norm")
-            LoadTrisWithNormal(p_path, p_result);
+            LoadTrisWithNormal(p_path, p_result, p_arena);
         else if (ext == "obj")
-            LoadObjModel(p_path, p_result);
+            LoadObjModel(p_path, p_result, p_arena);
+        else
+            return;
+        if (!disk_path.has_value())
+            return;
+        try
+        {
+            std::vector<std::vector<Triangle*>> lods = {std::vector<Triangle*>(p_result.begin() + first, p_result.end())};
+            MeshCache::Create(lods, MeshCache::IdentifySource(*disk_path)).Save(MeshCache::GetCachePath(*disk_path));
+        }
+        catch (const std::runtime_error&)
+        {
+            // The model is still loaded if the cache cannot be written, such as in a read only directory.
+        }
     }
 
-    void Resource::LoadObjModel(const std::string& p_path, std::vector<Triangle*>& p_result)
+    std::shared_ptr<const MeshCache> Resource::LoadMeshCache(const std::string& p_path)
     {
-        size_t file_size;
-        auto data = std::unique_ptr<byte_t[]>(LoadFile(p_path.c_str(), file_size));
-        byte_t* p = data.get();
+        std::string ext = p_path.substr(p_path.find_last_of('.') + 1);
+        if ("." + ext == MeshCache::EXTENSION)
+            return std::make_shared<MeshCache>(p_path);
+        // The files of packs are converted in memory, their caches are neither read nor written.
+        auto disk_path = VirtualFileSystem::GetInstance().GetDiskPath(p_path);
+        MeshCacheSource source;
+        if (disk_path.has_value())
+        {
+            if (auto cache = MeshCache::Open(*disk_path))
+                return std::move(cache);
+            source = MeshCache::IdentifySource(*disk_path);
+        }
 
-        std::vector<Math::Vec4> positions;
-        std::vector<Math::Vec4> normals;
-        std::vector<Math::Vec2> tex_coords;
-        byte_t line_buff[1024];
-        byte_t word_buff[256];
-        size_t counter = 0;
-        while (p < data.get() + file_size) {
-            GetLine(p, line_buff, 1024);
-            auto *pp = line_buff;
-            if (pp[0] == 'v' && pp[1] == ' ')
-            {
-                pp += 2;
-                Math::Vec4 pos = Math::Pos();
-                for (size_t i = 0; i < 3; ++i)
-                {
-                    GetWord(pp, word_buff, 256);
-                    pos[i] = std::atof(word_buff);
-                    MovePToNextSpace(&pp, line_buff + 1024);
-                    ++pp;
-                }
-                positions.push_back(pos);
-            }
-            else if (pp[0] == 'v' && pp[1] == 't')
-            {
-                pp += 3;
-                Math::Vec2 tex_coord;
-                for (size_t i = 0; i < 2; ++i)
-                {
-                    GetWord(pp, word_buff, 256);
-                    tex_coord[i] = std::atof(word_buff);
-                    MovePToNextSpace(&pp, line_buff + 1024);
-                    ++pp;
-                }
-                tex_coords.push_back(tex_coord);
-            }
-            else if (pp[0] == 'v' && pp[1] == 'n')
-            {
-                pp += 3;
-                Math::Vec4 norm =Math::Vec4();
-                for (size_t i = 0; i < 3; ++i)
-                {
-                    GetWord(pp, word_buff, 256);
-                    norm[i] = std::atof(word_buff);
-                    MovePToNextSpace(&pp, line_buff + 1024);
-                    ++pp;
-                }
-                normals.push_back(norm);
-            }
-            else if (pp[0] == 'f' && pp[1] == ' ')
-            {
-                ++pp;
-                PolygonN poly;
-                while (*pp != '\0')
-                {
-                    ++pp;
-                    Vertex* vert = new Vertex;
-                    if (std::atoi(GetWord(pp, word_buff, 256)) - 1 >= positions.size())
-                        throw std::runtime_error("Invalid obj file.");
-                    vert->Position() = positions[std::atoi(GetWord(pp, word_buff, 256)) - 1];
-                    MovePToNextWord(&pp, line_buff + 1024);
-                    ++pp;
-                    auto temp = atoi(GetWord(pp, word_buff, 256)) - 1;
-                    vert->UV() = tex_coords[std::atoi(GetWord(pp, word_buff, 256)) - 1];
-                    MovePToNextWord(&pp, line_buff + 1024);
-                    ++pp;
-                    if (std::atoi(GetWord(pp, word_buff, 256)) - 1 >= normals.size())
-                        throw std::runtime_error("Invalid obj file.");
-                    vert->Normal() = normals[std::atoi(GetWord(pp, word_buff, 256)) - 1];
-                    MovePToNextWord(&pp, line_buff + 1024);
-                    poly.AddVertex(poly.GetVertexCount(), vert);
-                }
-                std::vector<Triangle*> temp_triangles;
-                poly.Triangulate(temp_triangles);
-                for (size_t i = 0; i < temp_triangles.size(); ++i)
-                {
-                    p_result.push_back(temp_triangles[i]);
-                }
-            }
-            MovePToNextLine(&p, data.get() + file_size);
-            ++p;
+        std::shared_ptr<MeshCache> cache;
+        if (ext == "glb")
+            cache = std::make_shared<MeshCache>(GltfAsset(p_path).CreateMeshCache(source));
+        else
+        {
+            GeometryArena arena;
+            std::vector<std::vector<Triangle*>> lods(1);
+            if (ext == "tris")
+                LoadTris(p_path, lods[0], &arena);
+            else if (ext == "norm")
+                LoadTrisWithNormal(p_path, lods[0], &arena);
+            else if (ext == "obj")
+                LoadObjModel(p_path, lods[0], &arena);
+            else
+                throw std::runtime_error("Unsupported model file: \"" + p_path + "\".");
+            cache = std::make_shared<MeshCache>(MeshCache::Create(lods, source));
         }
+        if (!disk_path.has_value())
+            return cache;
+        try
+        {
+            cache->Save(MeshCache::GetCachePath(*disk_path));
+        }
+        catch (const std::runtime_error&)
+        {
+            // The cache is used from memory if it cannot be written.
+        }
+        return cache;
+    }
+
+    void Resource::LoadObjModel(const std::string& p_path, std::vector<Triangle*>& p_result, GeometryArena* p_arena)
+    {
+        auto file = VirtualFileSystem::GetInstance().Open(p_path);
+        ModelParser::ParseObj(file.GetText(), p_result, p_arena);
+    }
+
+    GltfScene Resource::LoadGltfScene(const std::string& p_path)
+    {
+        return std::make_shared<GltfAsset>(p_path)->CreateScene();
+    }
+
+    std::string Resource::GetCanonicalPath(const std::string& p_path)
+    {
+        std::error_code error;
+        auto result = std::filesystem::weakly_canonical(std::filesystem::absolute(p_path, error), error);
+        if (error)
+            return std::filesystem::path(p_path).lexically_normal().generic_string();
+        return result.generic_string();
+    }
+
+    ResourceCache<ATexture>& Resource::GetTextureCache()
+    {
+        static ResourceCache<ATexture> cache([](const ATexture& p_texture) {
+            return p_texture.GetWidth() * p_texture.GetHeight() * p_texture.GetChannels();
+        }, DEFAULT_TEXTURE_CACHE_BUDGET);
+        return cache;
+    }
+
+    ResourceCache<MeshData>& Resource::GetMeshDataCache()
+    {
+        static ResourceCache<MeshData> cache([](const MeshData& p_mesh_data) {
+            return p_mesh_data.GetVertexCount() * Vertex::ARRAY_SIZE * sizeof(float);
+        }, DEFAULT_MESH_DATA_CACHE_BUDGET);
+        return cache;
+    }
+
+    std::shared_ptr<ATexture> Resource::LoadSharedTexture(const std::string& p_path)
+    {
+        return LoadSharedTexture(p_path, TextureConfig());
+    }
+
+    std::shared_ptr<ATexture> Resource::LoadSharedTexture(const std::string& p_path, const TextureConfig& p_config)
+    {
+        std::string key = GetCanonicalPath(p_path) + "?mipmap=" + std::to_string(p_config.mipmap)
+            + "&repeat=" + std::to_string((int)p_config.repeat_mode_h) + "," + std::to_string((int)p_config.repeat_mode_v)
+            + "&filter=" + std::to_string((int)p_config.filter_mode_min) + "," + std::to_string((int)p_config.filter_mode_mag)
+            + "&mip=" + std::to_string((int)p_config.mip_filter) + "," + std::to_string((int)p_config.content);
+        return GetTextureCache().Get(key, [&]() -> std::shared_ptr<ATexture> {
+            return std::make_shared<StaticTexture>(p_path, p_config);
+        });
+    }
+
+    std::shared_ptr<ATexture> Resource::LoadSharedTexture(const std::string& p_path, TextureContent p_content)
+    {
+        TextureConfig config;
+        config.content = p_content;
+        return LoadSharedTexture(p_path, config);
+    }
+
+    std::shared_ptr<MeshData> Resource::LoadSharedMeshData(const std::string& p_path)
+    {
+        return GetMeshDataCache().Get(GetCanonicalPath(p_path), [&]() {
+            return std::make_shared<MeshData>(LoadMeshCache(p_path));
+        });
     }
 }
\ No newline at end of file
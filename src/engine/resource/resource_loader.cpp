@@ -0,0 +1,87 @@
+#include "ce/resource/resource_loader.h"
+#include "ce/resource/resource.h"
+#include "ce/texture/texture_file.h"
+#include <algorithm>
+
+namespace CrossEngine
+{
+    ResourceLoader::ResourceLoader(size_t p_worker_count)
+    {
+        p_worker_count = std::max<size_t>(p_worker_count, 1);
+        workers.reserve(p_worker_count);
+        for (size_t i = 0; i < p_worker_count; ++i)
+            workers.emplace_back(&ResourceLoader::WorkerFunc, this);
+    }
+
+    ResourceLoader::~ResourceLoader()
+    {
+        {
+            std::lock_guard<std::mutex> lock(jobs_mutex);
+            is_stopping = true;
+        }
+        jobs_condition.notify_all();
+        for (auto& worker : workers)
+            worker.join();
+    }
+
+    ResourceLoader& ResourceLoader::GetInstance()
+    {
+        // The window threads render, so one hardware thread is left to them.
+        static ResourceLoader instance(std::max<size_t>(std::thread::hardware_concurrency(), 2) - 1);
+        return instance;
+    }
+
+    void ResourceLoader::WorkerFunc()
+    {
+        while (true)
+        {
+            std::move_only_function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(jobs_mutex);
+                jobs_condition.wait(lock, [this]() { return is_stopping || !jobs.empty(); });
+                if (is_stopping)
+                    return;
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+            job();
+        }
+    }
+
+    void ResourceLoader::PushJob(std::move_only_function<void()>&& p_job)
+    {
+        {
+            std::lock_guard<std::mutex> lock(jobs_mutex);
+            if (is_stopping)
+                throw std::runtime_error("The resource loader is being destroyed.");
+            jobs.push_back(std::move(p_job));
+        }
+        jobs_condition.notify_one();
+    }
+
+    size_t ResourceLoader::GetPendingJobCount() const
+    {
+        std::lock_guard<std::mutex> lock(jobs_mutex);
+        return jobs.size();
+    }
+
+    std::future<TextureImage> ResourceLoader::LoadTextureImage(const std::string& p_path)
+    {
+        return Submit([p_path]() {
+            TextureImage result;
+            result.pixels.reset(Resource::LoadTextureImage(p_path, nullptr, 0, result.width, result.height, result.channels));
+            return result;
+        });
+    }
+
+    std::future<MipChain> ResourceLoader::LoadMipChain(const std::string& p_path, const MipConfig& p_config)
+    {
+        return Submit([p_path, p_config]() {
+            if (TextureFile::IsTextureFile(p_path))
+                return TextureFile::Load(p_path);
+            TextureImage image;
+            image.pixels.reset(Resource::LoadTextureImage(p_path, nullptr, 0, image.width, image.height, image.channels));
+            return MipChain::Generate(image.pixels.get(), image.width, image.height, image.channels, p_config);
+        });
+    }
+}
\ No newline at end of file
@@ -0,0 +1,144 @@
+#include "ce/resource/virtual_file_system.h"
+#include "ce/resource/pack_file.h"
+#include "ce/resource/mapped_file.h"
+#include <filesystem>
+#include <optional>
+#include <algorithm>
+#include <mutex>
+
+namespace CrossEngine
+{
+    namespace
+    {
+        // Get the path relative to a mount point, if the path is under it.
+        std::optional<std::string_view> GetRelativePath(std::string_view p_path, std::string_view p_mount_point) noexcept
+        {
+            if (p_mount_point.empty())
+                return p_path;
+            if (p_path.size() <= p_mount_point.size() || !p_path.starts_with(p_mount_point))
+                return std::nullopt;
+            if (p_mount_point.back() == '/')
+                return p_path.substr(p_mount_point.size());
+            if (p_path[p_mount_point.size()] != '/')
+                return std::nullopt;
+            return p_path.substr(p_mount_point.size() + 1);
+        }
+
+        VirtualFile OpenDiskFile(const std::string& p_path)
+        {
+            auto file = std::make_shared<MappedFile>(p_path);
+            return VirtualFile(file, file->GetData(), file->GetSize());
+        }
+    }
+
+    VirtualFileSystem& VirtualFileSystem::GetInstance()
+    {
+        static VirtualFileSystem instance;
+        return instance;
+    }
+
+    std::string VirtualFileSystem::NormalizePath(std::string_view p_path)
+    {
+        std::string result = std::filesystem::path(p_path).lexically_normal().generic_string();
+        // A directory path names the same directory with or without its trailing separator.
+        if (result.size() > 1 && result.back() == '/' && result[result.size() - 2] != ':')
+            result.pop_back();
+        if (result == ".")
+            result.clear();
+        return result;
+    }
+
+    void VirtualFileSystem::Mount(const std::string& p_mount_point, const std::string& p_path)
+    {
+        MountPoint mount;
+        mount.mount_point = NormalizePath(p_mount_point);
+        if (p_path.ends_with(PackFile::EXTENSION))
+            mount.pack = std::make_shared<PackFile>(p_path);
+        else
+            mount.directory = NormalizePath(p_path);
+        std::unique_lock<std::shared_mutex> lock(mounts_mutex);
+        mounts.push_back(std::move(mount));
+    }
+
+    size_t VirtualFileSystem::Unmount(const std::string& p_mount_point)
+    {
+        std::string mount_point = NormalizePath(p_mount_point);
+        std::unique_lock<std::shared_mutex> lock(mounts_mutex);
+        return std::erase_if(mounts, [&](const MountPoint& p_mount) { return p_mount.mount_point == mount_point; });
+    }
+
+    bool VirtualFileSystem::Exists(const std::string& p_path) const
+    {
+        std::string path = NormalizePath(p_path);
+        {
+            std::shared_lock<std::shared_mutex> lock(mounts_mutex);
+            for (auto mount = mounts.rbegin(); mount != mounts.rend(); ++mount)
+            {
+                auto relative = GetRelativePath(path, mount->mount_point);
+                if (!relative.has_value())
+                    continue;
+                if (mount->pack != nullptr ? mount->pack->Find(*relative) != nullptr
+                    : std::filesystem::is_regular_file(mount->directory + "/" + std::string(*relative)))
+                    return true;
+            }
+        }
+        return std::filesystem::is_regular_file(p_path);
+    }
+
+    std::optional<std::string> VirtualFileSystem::GetDiskPath(const std::string& p_path) const
+    {
+        std::string path = NormalizePath(p_path);
+        {
+            std::shared_lock<std::shared_mutex> lock(mounts_mutex);
+            for (auto mount = mounts.rbegin(); mount != mounts.rend(); ++mount)
+            {
+                auto relative = GetRelativePath(path, mount->mount_point);
+                if (!relative.has_value())
+                    continue;
+                if (mount->pack != nullptr)
+                {
+                    if (mount->pack->Find(*relative) != nullptr)
+                        return std::nullopt;
+                    continue;
+                }
+                std::string disk_path = mount->directory + "/" + std::string(*relative);
+                if (std::filesystem::is_regular_file(disk_path))
+                    return disk_path;
+            }
+        }
+        if (std::filesystem::is_regular_file(p_path))
+            return p_path;
+        return std::nullopt;
+    }
+
+    VirtualFile VirtualFileSystem::Open(const std::string& p_path) const
+    {
+        std::string path = NormalizePath(p_path);
+        {
+            std::shared_lock<std::shared_mutex> lock(mounts_mutex);
+            for (auto mount = mounts.rbegin(); mount != mounts.rend(); ++mount)
+            {
+                auto relative = GetRelativePath(path, mount->mount_point);
+                if (!relative.has_value())
+                    continue;
+                if (mount->pack == nullptr)
+                {
+                    std::string disk_path = mount->directory + "/" + std::string(*relative);
+                    if (std::filesystem::is_regular_file(disk_path))
+                        return OpenDiskFile(disk_path);
+                    continue;
+                }
+                auto entry = mount->pack->Find(*relative);
+                if (entry == nullptr)
+                    continue;
+                // An uncompressed entry is read in place, the file keeps the pack mapped.
+                if (entry->compression == PackFile::COMPRESSION_NONE)
+                    return VirtualFile(mount->pack, mount->pack->GetStoredData(*entry).data(), entry->size);
+                auto buffer = std::shared_ptr<byte_t[]>(new byte_t[entry->size]);
+                mount->pack->Read(*entry, buffer.get());
+                return VirtualFile(buffer, buffer.get(), entry->size);
+            }
+        }
+        return OpenDiskFile(p_path);
+    }
+}
@@ -0,0 +1,696 @@
+#include "ce/texture/block_compression.h"
+#include "ce/texture/mip_chain.h"
+#include "ce/utils/job_system.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#ifdef CE_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace CrossEngine
+{
+    namespace
+    {
+        constexpr size_t PIXEL_COUNT = BlockCompression::BLOCK_WIDTH * BlockCompression::BLOCK_WIDTH;
+        constexpr float BC1_WEIGHTS[4] = {0.0f, 1.0f / 3.0f, 2.0f / 3.0f, 1.0f};
+        // The weights of the 16 levels of BC7 mode 6, out of 64.
+        constexpr int BC7_WEIGHTS[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+        // The code of each level of a BC1 color block, from the first endpoint to the second.
+        constexpr uint32_t BC1_CODES[4] = {0, 2, 3, 1};
+
+        // The pixels of a block a channel at a time, so a channel of 4 pixels is a vector.
+        struct alignas(16) BlockPixels
+        {
+            float channels[4][PIXEL_COUNT];
+        };
+
+        class BitWriter
+        {
+        private:
+            ubyte_t* data;
+            size_t position = 0;
+        public:
+            explicit BitWriter(ubyte_t* p_data) : data(p_data) {}
+
+            void Write(uint32_t p_value, size_t p_count)
+            {
+                for (size_t i = 0; i < p_count; ++i, ++position)
+                    data[position >> 3] |= (ubyte_t)(((p_value >> i) & 1) << (position & 7));
+            }
+        };
+
+        class BitReader
+        {
+        private:
+            const ubyte_t* data;
+            size_t position = 0;
+        public:
+            explicit BitReader(const ubyte_t* p_data) : data(p_data) {}
+
+            uint32_t Read(size_t p_count)
+            {
+                uint32_t result = 0;
+                for (size_t i = 0; i < p_count; ++i, ++position)
+                    result |= (uint32_t)((data[position >> 3] >> (position & 7)) & 1) << i;
+                return result;
+            }
+        };
+
+        FORCE_INLINE int Quantize(float p_value, int p_max) noexcept
+        {
+            return std::clamp((int)std::lround(p_value * p_max / 255.0f), 0, p_max);
+        }
+
+        BlockPixels LoadBlock(const ubyte_t* p_pixels)
+        {
+            BlockPixels result;
+            for (size_t i = 0; i < PIXEL_COUNT; ++i)
+            {
+                for (size_t c = 0; c < 4; ++c)
+                    result.channels[c][i] = p_pixels[i * 4 + c];
+            }
+            return result;
+        }
+
+        // The distance of each pixel from an origin along an axis.
+        void Project(const BlockPixels& p_block, size_t p_channel_count, const float* p_origin, const float* p_axis, float* p_result)
+        {
+        #ifdef CE_SIMD_SSE2
+            for (size_t i = 0; i < PIXEL_COUNT; i += 4)
+            {
+                __m128 sum = _mm_setzero_ps();
+                for (size_t c = 0; c < p_channel_count; ++c)
+                {
+                    __m128 value = _mm_sub_ps(_mm_load_ps(p_block.channels[c] + i), _mm_set1_ps(p_origin[c]));
+                    sum = _mm_add_ps(sum, _mm_mul_ps(value, _mm_set1_ps(p_axis[c])));
+                }
+                _mm_storeu_ps(p_result + i, sum);
+            }
+        #else
+            for (size_t i = 0; i < PIXEL_COUNT; ++i)
+            {
+                float sum = 0.0f;
+                for (size_t c = 0; c < p_channel_count; ++c)
+                    sum += (p_block.channels[c][i] - p_origin[c]) * p_axis[c];
+                p_result[i] = sum;
+            }
+        #endif
+        }
+
+        // Fit a segment to the pixels along their principal axis.
+        void FitSegment(const BlockPixels& p_block, size_t p_channel_count, float* p_start, float* p_end)
+        {
+            float mean[4] = {};
+            float axis[4] = {};
+            for (size_t c = 0; c < p_channel_count; ++c)
+            {
+                auto [min, max] = std::minmax_element(p_block.channels[c], p_block.channels[c] + PIXEL_COUNT);
+                for (size_t i = 0; i < PIXEL_COUNT; ++i)
+                    mean[c] += p_block.channels[c][i];
+                mean[c] /= PIXEL_COUNT;
+                axis[c] = *max - *min;
+            }
+            float covariance[4][4] = {};
+            for (size_t a = 0; a < p_channel_count; ++a)
+            {
+                for (size_t b = a; b < p_channel_count; ++b)
+                {
+                    for (size_t i = 0; i < PIXEL_COUNT; ++i)
+                        covariance[a][b] += (p_block.channels[a][i] - mean[a]) * (p_block.channels[b][i] - mean[b]);
+                    covariance[b][a] = covariance[a][b];
+                }
+            }
+            // Power iteration, starting from the diagonal of the bounding box.
+            for (size_t iteration = 0; iteration < 8; ++iteration)
+            {
+                float next[4] = {};
+                float scale = 0.0f;
+                for (size_t a = 0; a < p_channel_count; ++a)
+                {
+                    for (size_t b = 0; b < p_channel_count; ++b)
+                        next[a] += covariance[a][b] * axis[b];
+                    scale = std::max(scale, std::abs(next[a]));
+                }
+                if (scale == 0.0f)
+                    break;
+                for (size_t c = 0; c < p_channel_count; ++c)
+                    axis[c] = next[c] / scale;
+            }
+            float length = 0.0f;
+            for (size_t c = 0; c < p_channel_count; ++c)
+                length += axis[c] * axis[c];
+            if (length == 0.0f)
+            {
+                // Every pixel has the same color.
+                std::copy(mean, mean + p_channel_count, p_start);
+                std::copy(mean, mean + p_channel_count, p_end);
+                return;
+            }
+            for (size_t c = 0; c < p_channel_count; ++c)
+                axis[c] /= std::sqrt(length);
+            float distances[PIXEL_COUNT];
+            Project(p_block, p_channel_count, mean, axis, distances);
+            auto [min, max] = std::minmax_element(distances, distances + PIXEL_COUNT);
+            for (size_t c = 0; c < p_channel_count; ++c)
+            {
+                p_start[c] = std::clamp(mean[c] + axis[c] * *min, 0.0f, 255.0f);
+                p_end[c] = std::clamp(mean[c] + axis[c] * *max, 0.0f, 255.0f);
+            }
+        }
+
+        // Choose the nearest level between two colors for each pixel. The levels are positions from 0 to 1.
+        void SelectLevels(const BlockPixels& p_block, size_t p_channel_count, const float* p_start, const float* p_end,
+            const float* p_weights, size_t p_level_count, int* p_levels)
+        {
+            float axis[4] = {};
+            float length = 0.0f;
+            for (size_t c = 0; c < p_channel_count; ++c)
+            {
+                axis[c] = p_end[c] - p_start[c];
+                length += axis[c] * axis[c];
+            }
+            if (length == 0.0f)
+            {
+                std::fill(p_levels, p_levels + PIXEL_COUNT, 0);
+                return;
+            }
+            for (size_t c = 0; c < p_channel_count; ++c)
+                axis[c] /= length;
+            float positions[PIXEL_COUNT];
+            Project(p_block, p_channel_count, p_start, axis, positions);
+            for (size_t i = 0; i < PIXEL_COUNT; ++i)
+            {
+                int level = 0;
+                for (size_t j = 1; j < p_level_count; ++j)
+                {
+                    if (std::abs(positions[i] - p_weights[j]) < std::abs(positions[i] - p_weights[level]))
+                        level = (int)j;
+                }
+                p_levels[i] = level;
+            }
+        }
+
+        // Move the endpoints to the least squares fit of the pixels at their chosen levels.
+        void RefineSegment(const BlockPixels& p_block, size_t p_channel_count, const int* p_levels, const float* p_weights,
+            float* p_start, float* p_end)
+        {
+            float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+            float a_sum[4] = {}, b_sum[4] = {};
+            for (size_t i = 0; i < PIXEL_COUNT; ++i)
+            {
+                float b = p_weights[p_levels[i]];
+                float a = 1.0f - b;
+                aa += a * a;
+                ab += a * b;
+                bb += b * b;
+                for (size_t c = 0; c < p_channel_count; ++c)
+                {
+                    a_sum[c] += a * p_block.channels[c][i];
+                    b_sum[c] += b * p_block.channels[c][i];
+                }
+            }
+            float determinant = aa * bb - ab * ab;
+            if (std::abs(determinant) < 1e-6f)
+                return;
+            for (size_t c = 0; c < p_channel_count; ++c)
+            {
+                p_start[c] = std::clamp((bb * a_sum[c] - ab * b_sum[c]) / determinant, 0.0f, 255.0f);
+                p_end[c] = std::clamp((aa * b_sum[c] - ab * a_sum[c]) / determinant, 0.0f, 255.0f);
+            }
+        }
+
+        float GetError(const BlockPixels& p_block, size_t p_channel_count, const float* p_start, const float* p_end,
+            const float* p_weights, const int* p_levels)
+        {
+            float result = 0.0f;
+            for (size_t i = 0; i < PIXEL_COUNT; ++i)
+            {
+                float weight = p_weights[p_levels[i]];
+                for (size_t c = 0; c < p_channel_count; ++c)
+                {
+                    float difference = p_start[c] + (p_end[c] - p_start[c]) * weight - p_block.channels[c][i];
+                    result += difference * difference;
+                }
+            }
+            return result;
+        }
+
+        FORCE_INLINE uint16_t To565(const float* p_color) noexcept
+        {
+            return (uint16_t)((Quantize(p_color[0], 31) << 11) | (Quantize(p_color[1], 63) << 5) | Quantize(p_color[2], 31));
+        }
+
+        FORCE_INLINE void From565(uint16_t p_color, int* p_result) noexcept
+        {
+            int r = (p_color >> 11) & 31, g = (p_color >> 5) & 63, b = p_color & 31;
+            p_result[0] = (r << 3) | (r >> 2);
+            p_result[1] = (g << 2) | (g >> 4);
+            p_result[2] = (b << 3) | (b >> 2);
+        }
+
+        void EncodeColorBlock(const BlockPixels& p_block, ubyte_t* p_result)
+        {
+            float start[4], end[4];
+            FitSegment(p_block, 3, start, end);
+            uint16_t best_colors[2] = {};
+            int best_levels[PIXEL_COUNT] = {};
+            float best_error = std::numeric_limits<float>::max();
+            for (size_t iteration = 0; iteration < 3; ++iteration)
+            {
+                uint16_t colors[2] = {To565(start), To565(end)};
+                int decoded[2][3];
+                From565(colors[0], decoded[0]);
+                From565(colors[1], decoded[1]);
+                float decoded_start[3] = {(float)decoded[0][0], (float)decoded[0][1], (float)decoded[0][2]};
+                float decoded_end[3] = {(float)decoded[1][0], (float)decoded[1][1], (float)decoded[1][2]};
+                int levels[PIXEL_COUNT];
+                SelectLevels(p_block, 3, decoded_start, decoded_end, BC1_WEIGHTS, 4, levels);
+                float error = GetError(p_block, 3, decoded_start, decoded_end, BC1_WEIGHTS, levels);
+                if (error < best_error)
+                {
+                    best_error = error;
+                    std::copy(colors, colors + 2, best_colors);
+                    std::copy(levels, levels + PIXEL_COUNT, best_levels);
+                }
+                RefineSegment(p_block, 3, levels, BC1_WEIGHTS, start, end);
+            }
+            // The first color must be the greater one to select the four color mode.
+            if (best_colors[0] < best_colors[1])
+            {
+                std::swap(best_colors[0], best_colors[1]);
+                for (auto& level : best_levels)
+                    level = 3 - level;
+            }
+            else if (best_colors[0] == best_colors[1])
+            {
+                std::fill(best_levels, best_levels + PIXEL_COUNT, 0);
+            }
+            uint32_t indices = 0;
+            for (size_t i = 0; i < PIXEL_COUNT; ++i)
+                indices |= BC1_CODES[best_levels[i]] << (i * 2);
+            p_result[0] = (ubyte_t)(best_colors[0] & 0xFF);
+            p_result[1] = (ubyte_t)(best_colors[0] >> 8);
+            p_result[2] = (ubyte_t)(best_colors[1] & 0xFF);
+            p_result[3] = (ubyte_t)(best_colors[1] >> 8);
+            for (size_t i = 0; i < 4; ++i)
+                p_result[4 + i] = (ubyte_t)(indices >> (i * 8));
+        }
+
+        void DecodeColorBlock(const ubyte_t* p_block, ubyte_t* p_pixels, bool p_allow_three_colors)
+        {
+            uint16_t colors[2] = {(uint16_t)(p_block[0] | (p_block[1] << 8)), (uint16_t)(p_block[2] | (p_block[3] << 8))};
+            int palette[4][3];
+            From565(colors[0], palette[0]);
+            From565(colors[1], palette[1]);
+            for (size_t c = 0; c < 3; ++c)
+            {
+                if (colors[0] > colors[1] || !p_allow_three_colors)
+                {
+                    palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                    palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+                }
+                else
+                {
+                    palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+                    palette[3][c] = 0;
+                }
+            }
+            uint32_t indices = p_block[4] | (p_block[5] << 8) | (p_block[6] << 16) | ((uint32_t)p_block[7] << 24);
+            for (size_t i = 0; i < PIXEL_COUNT; ++i)
+            {
+                auto& color = palette[(indices >> (i * 2)) & 3];
+                for (size_t c = 0; c < 3; ++c)
+                    p_pixels[i * 4 + c] = (ubyte_t)color[c];
+                p_pixels[i * 4 + 3] = 255;
+            }
+        }
+
+        void EncodeChannelBlock(const float* p_values, ubyte_t* p_result)
+        {
+            auto [min, max] = std::minmax_element(p_values, p_values + PIXEL_COUNT);
+            int first = std::clamp((int)std::lround(*max), 0, 255);
+            int second = std::clamp((int)std::lround(*min), 0, 255);
+            p_result[0] = (ubyte_t)first;
+            p_result[1] = (ubyte_t)second;
+            uint64_t indices = 0;
+            // With the first value greater, the block has 8 levels, and the code of a level is the order of its
+            // value from the first, except the second value is 1.
+            if (first > second)
+            {
+                for (size_t i = 0; i < PIXEL_COUNT; ++i)
+                {
+                    int level = std::clamp((int)std::lround((first - p_values[i]) * 7.0f / (first - second)), 0, 7);
+                    uint64_t code = level == 0 ? 0 : level == 7 ? 1 : level + 1;
+                    indices |= code << (i * 3);
+                }
+            }
+            for (size_t i = 0; i < 6; ++i)
+                p_result[2 + i] = (ubyte_t)(indices >> (i * 8));
+        }
+
+        void DecodeChannelBlock(const ubyte_t* p_block, ubyte_t* p_pixels, size_t p_channel)
+        {
+            int palette[8] = {p_block[0], p_block[1]};
+            if (palette[0] > palette[1])
+            {
+                for (int i = 2; i < 8; ++i)
+                    palette[i] = ((8 - i) * palette[0] + (i - 1) * palette[1] + 3) / 7;
+            }
+            else
+            {
+                for (int i = 2; i < 6; ++i)
+                    palette[i] = ((6 - i) * palette[0] + (i - 1) * palette[1] + 2) / 5;
+                palette[6] = 0;
+                palette[7] = 255;
+            }
+            uint64_t indices = 0;
+            for (size_t i = 0; i < 6; ++i)
+                indices |= (uint64_t)p_block[2 + i] << (i * 8);
+            for (size_t i = 0; i < PIXEL_COUNT; ++i)
+                p_pixels[i * 4 + p_channel] = (ubyte_t)palette[(indices >> (i * 3)) & 7];
+        }
+
+        // Quantize an endpoint of BC7 mode 6 to 7 bits per channel, with the shared lowest bit closer to it.
+        void QuantizeEndpoint(const float* p_color, int* p_result, int& p_bit)
+        {
+            float best_error = std::numeric_limits<float>::max();
+            for (int bit = 0; bit < 2; ++bit)
+            {
+                int quantized[4];
+                float error = 0.0f;
+                for (size_t c = 0; c < 4; ++c)
+                {
+                    quantized[c] = std::clamp((int)std::lround((p_color[c] - bit) / 2.0f), 0, 127);
+                    float difference = (float)((quantized[c] << 1) | bit) - p_color[c];
+                    error += difference * difference;
+                }
+                if (error < best_error)
+                {
+                    best_error = error;
+                    std::copy(quantized, quantized + 4, p_result);
+                    p_bit = bit;
+                }
+            }
+        }
+
+        void EncodeBC7Block(const BlockPixels& p_block, ubyte_t* p_result)
+        {
+            float weights[16];
+            for (size_t i = 0; i < 16; ++i)
+                weights[i] = BC7_WEIGHTS[i] / 64.0f;
+            float start[4], end[4];
+            FitSegment(p_block, 4, start, end);
+            int best_endpoints[2][4] = {};
+            int best_bits[2] = {};
+            int best_levels[PIXEL_COUNT] = {};
+            float best_error = std::numeric_limits<float>::max();
+            for (size_t iteration = 0; iteration < 3; ++iteration)
+            {
+                int endpoints[2][4];
+                int bits[2];
+                QuantizeEndpoint(start, endpoints[0], bits[0]);
+                QuantizeEndpoint(end, endpoints[1], bits[1]);
+                float decoded[2][4];
+                for (size_t e = 0; e < 2; ++e)
+                {
+                    for (size_t c = 0; c < 4; ++c)
+                        decoded[e][c] = (float)((endpoints[e][c] << 1) | bits[e]);
+                }
+                int levels[PIXEL_COUNT];
+                SelectLevels(p_block, 4, decoded[0], decoded[1], weights, 16, levels);
+                float error = GetError(p_block, 4, decoded[0], decoded[1], weights, levels);
+                if (error < best_error)
+                {
+                    best_error = error;
+                    std::memcpy(best_endpoints, endpoints, sizeof(endpoints));
+                    std::copy(bits, bits + 2, best_bits);
+                    std::copy(levels, levels + PIXEL_COUNT, best_levels);
+                }
+                RefineSegment(p_block, 4, levels, weights, start, end);
+            }
+            // The highest bit of the first index is implied 0, the weights are symmetric so the endpoints swap.
+            if (best_levels[0] & 8)
+            {
+                std::swap(best_endpoints[0], best_endpoints[1]);
+                std::swap(best_bits[0], best_bits[1]);
+                for (auto& level : best_levels)
+                    level = 15 - level;
+            }
+            std::memset(p_result, 0, 16);
+            BitWriter writer(p_result);
+            writer.Write(1 << 6, 7);
+            for (size_t c = 0; c < 4; ++c)
+            {
+                writer.Write(best_endpoints[0][c], 7);
+                writer.Write(best_endpoints[1][c], 7);
+            }
+            writer.Write(best_bits[0], 1);
+            writer.Write(best_bits[1], 1);
+            writer.Write(best_levels[0], 3);
+            for (size_t i = 1; i < PIXEL_COUNT; ++i)
+                writer.Write(best_levels[i], 4);
+        }
+
+        void DecodeBC7Block(const ubyte_t* p_block, ubyte_t* p_pixels)
+        {
+            if ((p_block[0] & 0x7F) != 0x40)
+                throw std::runtime_error("Unsupported BC7 block, only mode 6 is decoded.");
+            BitReader reader(p_block);
+            reader.Read(7);
+            int endpoints[2][4];
+            for (size_t c = 0; c < 4; ++c)
+            {
+                endpoints[0][c] = reader.Read(7) << 1;
+                endpoints[1][c] = reader.Read(7) << 1;
+            }
+            int bits[2] = {(int)reader.Read(1), (int)reader.Read(1)};
+            for (size_t i = 0; i < PIXEL_COUNT; ++i)
+            {
+                int weight = BC7_WEIGHTS[reader.Read(i == 0 ? 3 : 4)];
+                for (size_t c = 0; c < 4; ++c)
+                    p_pixels[i * 4 + c] = (ubyte_t)(((64 - weight) * (endpoints[0][c] | bits[0]) + weight * (endpoints[1][c] | bits[1]) + 32) >> 6);
+            }
+        }
+    }
+
+    size_t BlockCompression::GetBlockSize(BlockFormat p_format) noexcept
+    {
+        switch (p_format)
+        {
+        case BlockFormat::BC1:
+            return 8;
+        case BlockFormat::BC3:
+        case BlockFormat::BC5:
+        case BlockFormat::BC7:
+            return 16;
+        default:
+            return 0;
+        }
+    }
+
+    size_t BlockCompression::GetChannels(BlockFormat p_format) noexcept
+    {
+        switch (p_format)
+        {
+        case BlockFormat::BC1:
+        case BlockFormat::BC5:
+            return 3;
+        case BlockFormat::BC3:
+        case BlockFormat::BC7:
+            return 4;
+        default:
+            return 0;
+        }
+    }
+
+    size_t BlockCompression::GetCompressedSize(BlockFormat p_format, size_t p_width, size_t p_height) noexcept
+    {
+        return (p_width + BLOCK_WIDTH - 1) / BLOCK_WIDTH * ((p_height + BLOCK_WIDTH - 1) / BLOCK_WIDTH) * GetBlockSize(p_format);
+    }
+
+    BlockFormat BlockCompression::ParseFormat(std::string_view p_name)
+    {
+        std::string name(p_name);
+        std::transform(name.begin(), name.end(), name.begin(), [](char c) { return (char)std::tolower((unsigned char)c); });
+        if (name == "bc1")
+            return BlockFormat::BC1;
+        if (name == "bc3")
+            return BlockFormat::BC3;
+        if (name == "bc5")
+            return BlockFormat::BC5;
+        if (name == "bc7")
+            return BlockFormat::BC7;
+        throw std::runtime_error("Unknown compressed texture format: \"" + name + "\".");
+    }
+
+    void BlockCompression::EncodeBlock(BlockFormat p_format, const ubyte_t* p_pixels, ubyte_t* p_block)
+    {
+        BlockPixels block = LoadBlock(p_pixels);
+        switch (p_format)
+        {
+        case BlockFormat::BC1:
+            EncodeColorBlock(block, p_block);
+            break;
+        case BlockFormat::BC3:
+            EncodeChannelBlock(block.channels[3], p_block);
+            EncodeColorBlock(block, p_block + 8);
+            break;
+        case BlockFormat::BC5:
+            EncodeChannelBlock(block.channels[0], p_block);
+            EncodeChannelBlock(block.channels[1], p_block + 8);
+            break;
+        case BlockFormat::BC7:
+            EncodeBC7Block(block, p_block);
+            break;
+        default:
+            throw std::runtime_error("Not a compressed texture format.");
+        }
+    }
+
+    void BlockCompression::DecodeBlock(BlockFormat p_format, const ubyte_t* p_block, ubyte_t* p_pixels)
+    {
+        switch (p_format)
+        {
+        case BlockFormat::BC1:
+            DecodeColorBlock(p_block, p_pixels, true);
+            break;
+        case BlockFormat::BC3:
+            DecodeColorBlock(p_block + 8, p_pixels, false);
+            DecodeChannelBlock(p_block, p_pixels, 3);
+            break;
+        case BlockFormat::BC5:
+            DecodeChannelBlock(p_block, p_pixels, 0);
+            DecodeChannelBlock(p_block + 8, p_pixels, 1);
+            for (size_t i = 0; i < PIXEL_COUNT; ++i)
+            {
+                float x = p_pixels[i * 4] / 127.5f - 1.0f;
+                float y = p_pixels[i * 4 + 1] / 127.5f - 1.0f;
+                float z = std::sqrt(std::max(1.0f - x * x - y * y, 0.0f));
+                p_pixels[i * 4 + 2] = (ubyte_t)std::lround((z + 1.0f) * 127.5f);
+                p_pixels[i * 4 + 3] = 255;
+            }
+            break;
+        case BlockFormat::BC7:
+            DecodeBC7Block(p_block, p_pixels);
+            break;
+        default:
+            throw std::runtime_error("Not a compressed texture format.");
+        }
+    }
+
+    void BlockCompression::Encode(BlockFormat p_format, const ubyte_t* p_pixels, size_t p_width, size_t p_height, size_t p_channels,
+        ubyte_t* p_output, size_t p_thread_count)
+    {
+        size_t block_size = GetBlockSize(p_format);
+        if (block_size == 0)
+            throw std::runtime_error("Not a compressed texture format.");
+        if (p_channels == 0 || p_channels > 4)
+            throw std::runtime_error("Unsupported number of channels.");
+        if (p_width == 0 || p_height == 0)
+            return;
+        size_t blocks_x = (p_width + BLOCK_WIDTH - 1) / BLOCK_WIDTH;
+        size_t blocks_y = (p_height + BLOCK_WIDTH - 1) / BLOCK_WIDTH;
+        auto encode_rows = [&](size_t p_first, size_t p_last) {
+            ubyte_t block[PIXEL_COUNT * 4];
+            for (size_t by = p_first; by < p_last; ++by)
+            {
+                for (size_t bx = 0; bx < blocks_x; ++bx)
+                {
+                    for (size_t i = 0; i < PIXEL_COUNT; ++i)
+                    {
+                        // The blocks over the edges repeat the last row and column.
+                        size_t x = std::min(bx * BLOCK_WIDTH + i % BLOCK_WIDTH, p_width - 1);
+                        size_t y = std::min(by * BLOCK_WIDTH + i / BLOCK_WIDTH, p_height - 1);
+                        const ubyte_t* pixel = p_pixels + (y * p_width + x) * p_channels;
+                        ubyte_t* rgba = block + i * 4;
+                        rgba[0] = pixel[0];
+                        rgba[1] = p_channels == 1 ? pixel[0] : pixel[1];
+                        rgba[2] = p_channels == 1 ? pixel[0] : p_channels == 2 ? 0 : pixel[2];
+                        rgba[3] = p_channels == 4 ? pixel[3] : 255;
+                    }
+                    EncodeBlock(p_format, block, p_output + (by * blocks_x + bx) * block_size);
+                }
+            }
+        };
+        size_t thread_count = std::clamp<size_t>(p_thread_count, 1, blocks_y);
+        if (thread_count == 1)
+        {
+            encode_rows(0, blocks_y);
+            return;
+        }
+        JobSystem::GetInstance().ParallelFor(blocks_y, (blocks_y + thread_count - 1) / thread_count, encode_rows);
+    }
+
+    void BlockCompression::Decode(BlockFormat p_format, const ubyte_t* p_data, size_t p_width, size_t p_height, ubyte_t* p_output)
+    {
+        size_t block_size = GetBlockSize(p_format);
+        size_t channels = GetChannels(p_format);
+        if (block_size == 0)
+            throw std::runtime_error("Not a compressed texture format.");
+        size_t blocks_x = (p_width + BLOCK_WIDTH - 1) / BLOCK_WIDTH;
+        size_t blocks_y = (p_height + BLOCK_WIDTH - 1) / BLOCK_WIDTH;
+        ubyte_t block[PIXEL_COUNT * 4];
+        for (size_t by = 0; by < blocks_y; ++by)
+        {
+            for (size_t bx = 0; bx < blocks_x; ++bx)
+            {
+                DecodeBlock(p_format, p_data + (by * blocks_x + bx) * block_size, block);
+                for (size_t i = 0; i < PIXEL_COUNT; ++i)
+                {
+                    size_t x = bx * BLOCK_WIDTH + i % BLOCK_WIDTH;
+                    size_t y = by * BLOCK_WIDTH + i / BLOCK_WIDTH;
+                    if (x < p_width && y < p_height)
+                        std::memcpy(p_output + (y * p_width + x) * channels, block + i * 4, channels);
+                }
+            }
+        }
+    }
+
+    MipChain BlockCompression::Compress(const MipChain& p_image, BlockFormat p_format, size_t p_thread_count)
+    {
+        if (p_image.format != BlockFormat::NONE)
+            throw std::runtime_error("The texture is already compressed.");
+        MipChain result;
+        result.format = p_format;
+        result.channels = GetChannels(p_format);
+        size_t offset = 0;
+        for (auto& level : p_image.levels)
+        {
+            result.levels.push_back(MipChain::Level{level.width, level.height, offset});
+            offset += GetCompressedSize(p_format, level.width, level.height);
+        }
+        result.pixels = std::unique_ptr<ubyte_t[]>(new ubyte_t[offset]);
+        for (size_t i = 0; i < p_image.levels.size(); ++i)
+        {
+            Encode(p_format, p_image.GetLevelData(i), p_image.levels[i].width, p_image.levels[i].height, p_image.channels,
+                result.pixels.get() + result.levels[i].offset, p_thread_count);
+        }
+        return result;
+    }
+
+    MipChain BlockCompression::Decompress(const MipChain& p_image)
+    {
+        if (p_image.format == BlockFormat::NONE)
+            throw std::runtime_error("The texture is not compressed.");
+        MipChain result;
+        result.channels = GetChannels(p_image.format);
+        size_t offset = 0;
+        for (auto& level : p_image.levels)
+        {
+            result.levels.push_back(MipChain::Level{level.width, level.height, offset});
+            offset += level.width * level.height * result.channels;
+        }
+        result.pixels = std::unique_ptr<ubyte_t[]>(new ubyte_t[offset]);
+        for (size_t i = 0; i < p_image.levels.size(); ++i)
+        {
+            Decode(p_image.format, p_image.GetLevelData(i), p_image.levels[i].width, p_image.levels[i].height,
+                result.pixels.get() + result.levels[i].offset);
+        }
+        return result;
+    }
+}
@@ -0,0 +1,287 @@
+#include "ce/texture/mip_chain.h"
+#include "ce/utils/job_system.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <numbers>
+#include <stdexcept>
+#include <vector>
+#ifdef CE_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace CrossEngine
+{
+    namespace
+    {
+        // The half width of the Kaiser filter in pixels of the smaller level, and the shape of its window.
+        constexpr float KAISER_WIDTH = 3.0f;
+        constexpr float KAISER_ALPHA = 4.0f;
+        // The fewest rows a thread filters, so the small levels are not shared.
+        constexpr size_t MIN_THREAD_ROWS = 16;
+
+        // The zeroth order modified Bessel function of the first kind.
+        float BesselI0(float p_x)
+        {
+            float sum = 1.0f;
+            float term = 1.0f;
+            for (int k = 1; k < 32 && term > sum * 1e-8f; ++k)
+            {
+                float factor = p_x / (2.0f * k);
+                term *= factor * factor;
+                sum += term;
+            }
+            return sum;
+        }
+
+        float Kaiser(float p_x)
+        {
+            if (std::abs(p_x) >= KAISER_WIDTH)
+                return 0.0f;
+            float ratio = p_x / KAISER_WIDTH;
+            float window = BesselI0(KAISER_ALPHA * std::sqrt(1.0f - ratio * ratio)) / BesselI0(KAISER_ALPHA);
+            if (p_x == 0.0f)
+                return window;
+            float x = std::numbers::pi_v<float> * p_x;
+            return std::sin(x) / x * window;
+        }
+
+        float SrgbToLinear(float p_value)
+        {
+            return p_value <= 0.04045f ? p_value / 12.92f : std::pow((p_value + 0.055f) / 1.055f, 2.4f);
+        }
+
+        float LinearToSrgb(float p_value)
+        {
+            return p_value <= 0.0031308f ? p_value * 12.92f : 1.055f * std::pow(p_value, 1.0f / 2.4f) - 0.055f;
+        }
+
+        ubyte_t ToByte(float p_value)
+        {
+            return (ubyte_t)(std::clamp(p_value, 0.0f, 1.0f) * 255.0f + 0.5f);
+        }
+
+        // The pixels of the larger level each pixel of the smaller level is filtered from, along one axis.
+        struct Taps
+        {
+            size_t count = 0;
+            std::vector<size_t> indices;
+            std::vector<float> weights;
+        };
+
+        Taps ComputeTaps(size_t p_source_size, size_t p_size, MipFilter p_filter)
+        {
+            Taps result;
+            if (p_source_size == p_size)
+            {
+                result.count = 1;
+                for (size_t i = 0; i < p_size; ++i)
+                {
+                    result.indices.push_back(i);
+                    result.weights.push_back(1.0f);
+                }
+                return result;
+            }
+            float scale = (float)p_source_size / p_size;
+            float radius = p_filter == MipFilter::BOX ? scale * 0.5f : KAISER_WIDTH * scale;
+            result.count = (size_t)std::ceil(radius * 2.0f) + 2;
+            result.indices.resize(result.count * p_size);
+            result.weights.resize(result.count * p_size);
+            for (size_t i = 0; i < p_size; ++i)
+            {
+                float center = (i + 0.5f) * scale;
+                long long first = (long long)std::floor(center - radius);
+                float sum = 0.0f;
+                for (size_t k = 0; k < result.count; ++k)
+                {
+                    long long source = first + (long long)k;
+                    float weight = p_filter == MipFilter::BOX
+                        ? std::max(std::min(source + 1.0f, center + radius) - std::max((float)source, center - radius), 0.0f)
+                        : Kaiser((source + 0.5f - center) / scale);
+                    // The pixels over the edges repeat the first and last pixels.
+                    result.indices[i * result.count + k] = (size_t)std::clamp<long long>(source, 0, (long long)p_source_size - 1);
+                    result.weights[i * result.count + k] = weight;
+                    sum += weight;
+                }
+                for (size_t k = 0; k < result.count; ++k)
+                    result.weights[i * result.count + k] /= sum;
+            }
+            return result;
+        }
+
+        void AccumulateRow(float* p_target, const float* p_source, float p_weight, size_t p_size)
+        {
+            size_t i = 0;
+#ifdef CE_SIMD_SSE2
+            __m128 weight = _mm_set1_ps(p_weight);
+            for (; i + 4 <= p_size; i += 4)
+                _mm_storeu_ps(p_target + i, _mm_add_ps(_mm_loadu_ps(p_target + i), _mm_mul_ps(_mm_loadu_ps(p_source + i), weight)));
+#endif
+            for (; i < p_size; ++i)
+                p_target[i] += p_source[i] * p_weight;
+        }
+
+        void FilterRow(float* p_target, const float* p_row, const Taps& p_taps, size_t p_width, size_t p_channels)
+        {
+#ifdef CE_SIMD_SSE2
+            if (p_channels == 4)
+            {
+                for (size_t x = 0; x < p_width; ++x)
+                {
+                    __m128 sum = _mm_setzero_ps();
+                    for (size_t k = 0; k < p_taps.count; ++k)
+                    {
+                        size_t tap = x * p_taps.count + k;
+                        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(p_row + p_taps.indices[tap] * 4), _mm_set1_ps(p_taps.weights[tap])));
+                    }
+                    _mm_storeu_ps(p_target + x * 4, sum);
+                }
+                return;
+            }
+#endif
+            for (size_t x = 0; x < p_width; ++x)
+            {
+                for (size_t c = 0; c < p_channels; ++c)
+                {
+                    float sum = 0.0f;
+                    for (size_t k = 0; k < p_taps.count; ++k)
+                    {
+                        size_t tap = x * p_taps.count + k;
+                        sum += p_row[p_taps.indices[tap] * p_channels + c] * p_taps.weights[tap];
+                    }
+                    p_target[x * p_channels + c] = sum;
+                }
+            }
+        }
+
+        void ForEachRows(size_t p_height, size_t p_thread_count, const std::function<void(size_t, size_t)>& p_function)
+        {
+            size_t thread_count = std::clamp<size_t>(p_thread_count, 1, (p_height + MIN_THREAD_ROWS - 1) / MIN_THREAD_ROWS);
+            if (thread_count == 1)
+            {
+                p_function(0, p_height);
+                return;
+            }
+            JobSystem::GetInstance().ParallelFor(p_height, (p_height + thread_count - 1) / thread_count, p_function);
+        }
+    }
+
+    size_t MipChain::GetLevelCount(size_t p_width, size_t p_height) noexcept
+    {
+        size_t result = 1;
+        for (size_t size = std::max(p_width, p_height); size > 1; size /= 2)
+            ++result;
+        return result;
+    }
+
+    MipChain MipChain::Generate(const ubyte_t* p_pixels, size_t p_width, size_t p_height, size_t p_channels, bool p_mipmap)
+    {
+        MipConfig config;
+        config.mipmap = p_mipmap;
+        return Generate(p_pixels, p_width, p_height, p_channels, config);
+    }
+
+    MipChain MipChain::Generate(const ubyte_t* p_pixels, size_t p_width, size_t p_height, size_t p_channels, const MipConfig& p_config)
+    {
+        if (p_channels == 0 || p_channels > 4)
+            throw std::runtime_error("Unsupported number of channels.");
+        if (p_config.content == TextureContent::NORMAL && p_channels < 3)
+            throw std::runtime_error("A normal map should have at least 3 channels.");
+        MipChain result;
+        result.channels = p_channels;
+        size_t level_count = p_config.mipmap ? GetLevelCount(p_width, p_height) : 1;
+        size_t offset = 0;
+        for (size_t i = 0, width = p_width, height = p_height; i < level_count; ++i)
+        {
+            result.levels.push_back(Level{width, height, offset});
+            offset += width * height * p_channels;
+            width = std::max<size_t>(width / 2, 1);
+            height = std::max<size_t>(height / 2, 1);
+        }
+        result.pixels = std::unique_ptr<ubyte_t[]>(new ubyte_t[offset]);
+        std::memcpy(result.pixels.get(), p_pixels, result.GetLevelSize(0));
+        if (level_count == 1)
+            return result;
+
+        // The alpha of 2 and 4 channel textures is always linear.
+        size_t color_channels = (p_channels == 2 || p_channels == 4) ? p_channels - 1 : p_channels;
+        float decode[4][256];
+        for (size_t c = 0; c < p_channels; ++c)
+        {
+            for (size_t i = 0; i < 256; ++i)
+            {
+                float value = i / 255.0f;
+                if (c < color_channels && p_config.content == TextureContent::SRGB)
+                    value = SrgbToLinear(value);
+                else if (c < 3 && p_config.content == TextureContent::NORMAL)
+                    value = value * 2.0f - 1.0f;
+                decode[c][i] = value;
+            }
+        }
+        auto encode = [&](const float* p_source, ubyte_t* p_target, size_t p_count) {
+            for (size_t i = 0; i < p_count; ++i)
+            {
+                size_t c = i % p_channels;
+                float value = p_source[i];
+                if (c < color_channels && p_config.content == TextureContent::SRGB)
+                    value = LinearToSrgb(std::clamp(value, 0.0f, 1.0f));
+                else if (c < 3 && p_config.content == TextureContent::NORMAL)
+                    value = value * 0.5f + 0.5f;
+                p_target[i] = ToByte(value);
+            }
+        };
+
+        // Each level is filtered from the floating point pixels of the previous one.
+        std::vector<float> source(result.GetLevelSize(0));
+        for (size_t i = 0; i < source.size(); ++i)
+            source[i] = decode[i % p_channels][p_pixels[i]];
+        std::vector<float> target;
+        for (size_t i = 1; i < level_count; ++i)
+        {
+            const auto& from = result.levels[i - 1];
+            const auto& level = result.levels[i];
+            Taps taps_x = ComputeTaps(from.width, level.width, p_config.filter);
+            Taps taps_y = ComputeTaps(from.height, level.height, p_config.filter);
+            target.resize(level.width * level.height * p_channels);
+            ubyte_t* pixels = result.pixels.get() + level.offset;
+            ForEachRows(level.height, p_config.thread_count, [&](size_t p_first, size_t p_last) {
+                std::vector<float> row(from.width * p_channels);
+                for (size_t y = p_first; y < p_last; ++y)
+                {
+                    // Filter the rows first, then the columns of the filtered row.
+                    std::fill(row.begin(), row.end(), 0.0f);
+                    for (size_t k = 0; k < taps_y.count; ++k)
+                    {
+                        size_t tap = y * taps_y.count + k;
+                        if (taps_y.weights[tap] != 0.0f)
+                            AccumulateRow(row.data(), source.data() + taps_y.indices[tap] * row.size(), taps_y.weights[tap], row.size());
+                    }
+                    float* output = target.data() + y * level.width * p_channels;
+                    FilterRow(output, row.data(), taps_x, level.width, p_channels);
+                    if (p_config.content == TextureContent::NORMAL)
+                    {
+                        for (size_t x = 0; x < level.width; ++x)
+                        {
+                            float* normal = output + x * p_channels;
+                            float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+                            // Opposite normals cancel out, facing the surface is the safest guess.
+                            if (length < 1e-6f)
+                            {
+                                normal[0] = 0.0f;
+                                normal[1] = 0.0f;
+                                normal[2] = 1.0f;
+                                continue;
+                            }
+                            for (size_t c = 0; c < 3; ++c)
+                                normal[c] /= length;
+                        }
+                    }
+                    encode(output, pixels + y * level.width * p_channels, level.width * p_channels);
+                }
+            });
+            source.swap(target);
+        }
+        return result;
+    }
+}
@@ -1,11 +1,32 @@
 #include "ce/texture/static_texture.h"
 #include "ce/resource/resource.h"
+#include "ce/resource/resource_loader.h"
+#include "ce/texture/texture_file.h"
 #include "ce/graphics/window.h"
+#include "ce/graphics/texture_streamer.h"
 #include "ce/graphics/renderer/renderer.h"
 #include "ce/game/game.h"
+#include "glad/glad.h"
 
 namespace CrossEngine
 {
+    struct StaticTexture::PendingImage
+    {
+        std::mutex mutex;
+        std::future<MipChain> image;
+        TextureConfig config;
+        // The texture is bound once its smallest level is streamed.
+        std::shared_ptr<TextureStream> stream;
+        unsigned int texture_id = 0;
+        size_t width = 0;
+        size_t height = 0;
+        size_t channels = 0;
+        BlockFormat format = BlockFormat::NONE;
+        bool is_queued = false;
+        // Set when the texture is destroyed or loaded again, the queued upload is skipped.
+        bool is_released = false;
+    };
+
     StaticTexture::StaticTexture(const TextureConfig& p_config)
         : ATexture(p_config)
     {
@@ -18,50 +39,215 @@ namespace CrossEngine
         LoadTexture(p_path);
     }
 
+    StaticTexture::StaticTexture(Decoder&& p_decoder, const TextureConfig& p_config)
+        : ATexture(p_config)
+    {
+        LoadTexture(std::move(p_decoder));
+    }
+
     StaticTexture::~StaticTexture()
     {
+        ReleasePending();
         if (!Game::IsInitialized())
             return;
-        for (auto& i : texture_ids)
-        {
-            if (Game::GetInstance()->IsContextAvailable(i.first))
-                Graphics::DeleteTexture(i.second, i.first);
-        }
+        if (texture_id != 0)
+            Graphics::DeleteTexture(texture_id);
+        Graphics::FreeFence(upload_fence);
     }
 
     void StaticTexture::LoadTexture(const std::string& p_path)
     {
-        data = std::unique_ptr<ubyte_t[]>(Resource::LoadTextureImage(p_path, nullptr, 0, width, height, channels));
+        if (TextureFile::IsTextureFile(p_path))
+        {
+            // The baked levels are streamed as they are, possibly compressed.
+            std::promise<MipChain> image;
+            image.set_value(TextureFile::Load(p_path));
+            std::lock_guard<std::mutex> lock(texture_mutex);
+            data.reset();
+            decoder = nullptr;
+            ReleasePending();
+            pending = std::make_shared<PendingImage>();
+            pending->config = config;
+            pending->image = image.get_future();
+            return;
+        }
+        // Decoded before taking the lock, so binding the texture meanwhile does not wait for it.
+        size_t image_width, image_height, image_channels;
+        auto image_data = std::unique_ptr<ubyte_t[]>(Resource::LoadTextureImage(p_path, nullptr, 0, image_width, image_height, image_channels));
+        std::lock_guard<std::mutex> lock(texture_mutex);
+        width = image_width;
+        height = image_height;
+        channels = image_channels;
+        data = std::move(image_data);
+        decoder = nullptr;
+        ReleasePending();
     };
 
     void StaticTexture::LoadTexture(ubyte_t*&& p_data, size_t p_width, size_t p_height, size_t p_channels)
     {
+        std::lock_guard<std::mutex> lock(texture_mutex);
         width = p_width;
         height = p_height;
         channels = p_channels;
         data = std::unique_ptr<ubyte_t[]>(p_data);
         p_data = nullptr;
+        decoder = nullptr;
+        ReleasePending();
     }
 
     void StaticTexture::LoadTexture(const ubyte_t* p_data, size_t p_width, size_t p_height, size_t p_channels)
     {
+        auto size = p_width * p_height * p_channels;
+        auto copy = std::unique_ptr<ubyte_t[]>(new ubyte_t[size]);
+        memcpy(copy.get(), p_data, size);
+        std::lock_guard<std::mutex> lock(texture_mutex);
         width = p_width;
         height = p_height;
         channels = p_channels;
-        auto size = width * height * channels;
-        data = std::unique_ptr<ubyte_t[]>(new ubyte_t[size]);
-        memcpy(data.get(), p_data, size);
+        data = std::move(copy);
+        decoder = nullptr;
+        ReleasePending();
+    }
+
+    void StaticTexture::LoadTexture(Decoder&& p_decoder)
+    {
+        std::lock_guard<std::mutex> lock(texture_mutex);
+        decoder = std::move(p_decoder);
+        data.reset();
+        ReleasePending();
+    }
+
+    void StaticTexture::LoadTextureAsync(const std::string& p_path)
+    {
+        std::lock_guard<std::mutex> lock(texture_mutex);
+        decoder = nullptr;
+        data.reset();
+        ReleasePending();
+        pending = std::make_shared<PendingImage>();
+        pending->config = config;
+        pending->image = ResourceLoader::GetInstance().LoadMipChain(p_path, config.GetMipConfig());
+    }
+
+    void StaticTexture::ReleasePending()
+    {
+        if (pending == nullptr)
+            return;
+        {
+            std::lock_guard<std::mutex> lock(pending->mutex);
+            pending->is_released = true;
+            if (pending->stream != nullptr)
+                pending->stream->Cancel();
+            // The texture is uploaded but not bound yet.
+            if (pending->texture_id != 0 && Game::IsInitialized())
+                Graphics::DeleteTexture(pending->texture_id);
+        }
+        pending.reset();
     }
 
     void StaticTexture::BindTexture(Window* p_context, const std::string& p_uniform_name)
     {
-        if (!texture_ids.contains(p_context))
+        unsigned int texture;
         {
-            unsigned int texture = Graphics::GenerateTexture(p_context);
-            Graphics::SetTexture(texture, width, height, channels, data.get(), config.mipmap);
-            Graphics::ConfigTexture(texture, config);
-            texture_ids[p_context] = texture;
+            std::lock_guard<std::mutex> lock(texture_mutex);
+            if (texture_id == 0 && (decoder || (data != nullptr && (config.mipmap || width * height * channels >= TextureStreamer::MIN_STREAMED_SIZE))))
+            {
+                pending = std::make_shared<PendingImage>();
+                pending->config = config;
+                if (decoder)
+                {
+                    pending->image = ResourceLoader::GetInstance().Submit([decoder = std::move(decoder), mip_config = config.GetMipConfig()]() {
+                        TextureImage image;
+                        image.pixels.reset(decoder(image.width, image.height, image.channels));
+                        return MipChain::Generate(image.pixels.get(), image.width, image.height, image.channels, mip_config);
+                    });
+                }
+                else
+                {
+                    // Large textures are streamed, so they do not stall the frame they are first bound in. The levels
+                    // are built on a worker thread too, instead of the driver building them on this thread.
+                    pending->image = ResourceLoader::GetInstance().Submit([data = std::move(data), width = width, height = height,
+                        channels = channels, mip_config = config.GetMipConfig()]() {
+                        return MipChain::Generate(data.get(), width, height, channels, mip_config);
+                    });
+                }
+                // Release what the decoder holds, such as the file of the image, once it is decoded.
+                decoder = nullptr;
+            }
+            // The stream is kept until its last level is finished, so every context waits for the levels it binds.
+            if (texture_id != 0 && pending != nullptr && pending->stream != nullptr && pending->stream->IsComplete() &&
+                pending->stream->WaitUpload())
+                pending.reset();
+            if (texture_id == 0 && pending != nullptr)
+            {
+                auto image = pending;
+                std::lock_guard<std::mutex> pending_lock(image->mutex);
+                if (image->texture_id != 0 && image->stream->GetUploadedLevelCount() != 0)
+                {
+                    texture_id = image->texture_id;
+                    width = image->width;
+                    height = image->height;
+                    channels = image->channels;
+                    format = image->format;
+                    image->texture_id = 0;
+                    // Kept until every level is streamed, so the stream is cancelled if the texture is released.
+                    bool is_complete = image->stream->IsComplete();
+                    if (image->stream->WaitUpload() && is_complete)
+                        pending.reset();
+                }
+                else if (!image->is_queued && ResourceLoader::IsReady(image->image))
+                {
+                    image->is_queued = true;
+                    p_context->QueueUpload([image, p_context]() {
+                        std::lock_guard<std::mutex> lock(image->mutex);
+                        if (image->is_released)
+                            return;
+                        try
+                        {
+                            auto result = std::make_shared<MipChain>(image->image.get());
+                            unsigned int id = Graphics::GenerateTexture();
+                            Graphics::ConfigTexture(id, image->config);
+                            image->texture_id = id;
+                            image->width = result->levels[0].width;
+                            image->height = result->levels[0].height;
+                            image->channels = result->channels;
+                            image->format = result->format;
+                            image->stream = p_context->GetTextureStreamer()->Stream(id, std::move(result));
+                        }
+                        catch (const std::exception&)
+                        {
+                            // A texture that cannot be loaded keeps its placeholder.
+                            if (image->texture_id != 0)
+                                Graphics::DeleteTexture(image->texture_id);
+                            image->texture_id = 0;
+                        }
+                    });
+                }
+            }
+            else if (texture_id == 0)
+            {
+                texture_id = Graphics::GenerateTexture();
+                Graphics::SetTexture(texture_id, width, height, channels, data.get(), false);
+                format = BlockFormat::NONE;
+                Graphics::ConfigTexture(texture_id, config);
+                Graphics::FenceUpload(upload_fence);
+            }
+            else if (pending != nullptr && pending->stream != nullptr)
+            {
+                pending->stream->WaitUpload();
+            }
+            else
+            {
+                Graphics::WaitUpload(upload_fence);
+            }
+            texture = texture_id;
+        }
+        if (texture == 0)
+        {
+            auto fallback = placeholder != nullptr ? placeholder : Graphics::GetDefaultAlbedo();
+            if (fallback != nullptr && fallback.get() != this)
+                fallback->BindTexture(p_context, p_uniform_name);
+            return;
         }
-        p_context->GetRenderer()->GetShaderProgram()->SetSampler2DUniform(p_uniform_name, texture_ids[p_context]);
+        p_context->GetRenderer()->GetShaderProgram()->SetSampler2DUniform(p_uniform_name, texture);
     }
 }
\ No newline at end of file
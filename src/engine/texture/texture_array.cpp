@@ -0,0 +1,110 @@
+#include "ce/texture/texture_array.h"
+#include "ce/texture/mip_chain.h"
+#include "ce/graphics/graphics.h"
+#include "ce/graphics/window.h"
+#include "ce/graphics/renderer/renderer.h"
+#include "ce/graphics/shader/shader_program.h"
+#include "ce/game/game.h"
+#include "glad/glad.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace CrossEngine
+{
+    TextureArray::TextureArray(size_t p_width, size_t p_height, size_t p_layer_count, size_t p_level_count)
+        : width(p_width), height(p_height), layer_count(p_layer_count), level_count(p_level_count)
+    {
+        if (p_width == 0 || p_height == 0 || p_layer_count == 0 || p_level_count == 0)
+            throw std::invalid_argument("The size of a texture array should not be 0.");
+        if (p_level_count > MipChain::GetLevelCount(p_width, p_height))
+            throw std::invalid_argument("Too many levels for the size of the texture array.");
+    }
+
+    TextureArray::~TextureArray()
+    {
+        if (!Game::IsInitialized())
+            return;
+        if (texture_id != 0)
+            Graphics::DeleteTexture(texture_id);
+        Graphics::FreeFence(upload_fence);
+    }
+
+    void TextureArray::Write(size_t p_layer, size_t p_level, size_t p_x, size_t p_y, size_t p_width, size_t p_height,
+        std::vector<ubyte_t>&& p_pixels)
+    {
+        size_t level_width = std::max<size_t>(width >> std::min<size_t>(p_level, 63), 1);
+        size_t level_height = std::max<size_t>(height >> std::min<size_t>(p_level, 63), 1);
+        if (p_layer >= layer_count || p_level >= level_count || p_x + p_width > level_width || p_y + p_height > level_height
+            || p_pixels.size() != p_width * p_height * 4)
+            throw std::out_of_range("The write is out of the texture array.");
+        std::lock_guard<std::mutex> lock(array_mutex);
+        pending_writes.push_back(PendingWrite{p_layer, p_level, p_x, p_y, p_width, p_height, std::move(p_pixels)});
+    }
+
+    size_t TextureArray::GetPendingWriteCount() const
+    {
+        std::lock_guard<std::mutex> lock(array_mutex);
+        return pending_writes.size();
+    }
+
+    std::optional<std::array<ubyte_t, 4>> TextureArray::GetPendingPixel(size_t p_layer, size_t p_level, size_t p_x, size_t p_y) const
+    {
+        std::lock_guard<std::mutex> lock(array_mutex);
+        for (auto write = pending_writes.rbegin(); write != pending_writes.rend(); ++write)
+        {
+            if (write->layer != p_layer || write->level != p_level || p_x < write->x || p_y < write->y ||
+                p_x >= write->x + write->width || p_y >= write->y + write->height)
+                continue;
+            const ubyte_t* pixel = write->pixels.data() + ((p_y - write->y) * write->width + p_x - write->x) * 4;
+            return std::array<ubyte_t, 4>{pixel[0], pixel[1], pixel[2], pixel[3]};
+        }
+        return std::nullopt;
+    }
+
+    void TextureArray::BindTexture(Window* p_context, const std::string& p_uniform_name)
+    {
+        unsigned int texture;
+        {
+            std::lock_guard<std::mutex> lock(array_mutex);
+            if (texture_id == 0)
+            {
+                texture_id = Graphics::GenerateTexture();
+                glBindTexture(GL_TEXTURE_2D_ARRAY, texture_id);
+                for (size_t i = 0; i < level_count; ++i)
+                {
+                    glTexImage3D(GL_TEXTURE_2D_ARRAY, i, GL_RGBA8, std::max<size_t>(width >> i, 1), std::max<size_t>(height >> i, 1),
+                        layer_count, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+                }
+                glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, 0);
+                glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, level_count - 1);
+                glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, level_count > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+                glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+                glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+                glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+                glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+            }
+            if (!pending_writes.empty())
+            {
+                size_t bytes = 0;
+                glBindTexture(GL_TEXTURE_2D_ARRAY, texture_id);
+                glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+                for (const auto& write : pending_writes)
+                {
+                    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, write.level, write.x, write.y, write.layer, write.width, write.height, 1,
+                        GL_RGBA, GL_UNSIGNED_BYTE, write.pixels.data());
+                    bytes += write.pixels.size();
+                }
+                glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+                pending_writes.clear();
+                p_context->AddUploadBytes(bytes);
+                Graphics::FenceUpload(upload_fence);
+            }
+            else
+            {
+                Graphics::WaitUpload(upload_fence);
+            }
+            texture = texture_id;
+        }
+        p_context->GetRenderer()->GetShaderProgram()->SetSampler2DArrayUniform(p_uniform_name, texture);
+    }
+}
@@ -0,0 +1,102 @@
+#include "ce/texture/texture_file.h"
+#include "ce/resource/virtual_file_system.h"
+#include "ce/graphics/graphics.h"
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace CrossEngine
+{
+    namespace
+    {
+        constexpr uint64_t MAX_SIZE = 1 << 16;
+    }
+
+    bool TextureFile::IsTextureFile(const std::string& p_path) noexcept
+    {
+        std::string_view extension = EXTENSION;
+        return p_path.size() >= extension.size() && p_path.compare(p_path.size() - extension.size(), extension.size(), extension) == 0;
+    }
+
+    MipChain TextureFile::Read(const std::string& p_path)
+    {
+        auto file = VirtualFileSystem::GetInstance().Open(p_path);
+        auto invalid = [&]() { return std::runtime_error("Invalid texture file: \"" + p_path + "\"."); };
+        if (file.GetSize() < sizeof(Header))
+            throw invalid();
+        Header header;
+        std::memcpy(&header, file.GetData(), sizeof(Header));
+        auto format = static_cast<BlockFormat>(header.format);
+        // Larger textures than any context supports are rejected, so the sizes of the levels cannot overflow.
+        if (header.magic != MAGIC || header.version != VERSION || header.width > MAX_SIZE || header.height > MAX_SIZE
+            || (format != BlockFormat::NONE && BlockCompression::GetBlockSize(format) == 0)
+            || (format == BlockFormat::NONE && (header.channels == 0 || header.channels > 4))
+            || header.level_count == 0 || header.level_count > MipChain::GetLevelCount(header.width, header.height)
+            || header.level_count > (file.GetSize() - sizeof(Header)) / sizeof(Level))
+            throw invalid();
+
+        MipChain result;
+        result.format = format;
+        result.channels = format == BlockFormat::NONE ? header.channels : BlockCompression::GetChannels(format);
+        std::vector<Level> levels(header.level_count);
+        std::memcpy(levels.data(), file.GetData() + sizeof(Header), levels.size() * sizeof(Level));
+        size_t offset = 0;
+        for (size_t i = 0, width = header.width, height = header.height; i < levels.size(); ++i)
+        {
+            result.levels.push_back(MipChain::Level{width, height, offset});
+            // The levels are checked against the size they must have, so they are uploaded without checks.
+            if (levels[i].size != result.GetLevelSize(i) || levels[i].offset > file.GetSize()
+                || levels[i].size > file.GetSize() - levels[i].offset)
+                throw invalid();
+            offset += levels[i].size;
+            width = std::max<size_t>(width / 2, 1);
+            height = std::max<size_t>(height / 2, 1);
+        }
+        result.pixels = std::unique_ptr<ubyte_t[]>(new ubyte_t[offset]);
+        for (size_t i = 0; i < levels.size(); ++i)
+            std::memcpy(result.pixels.get() + result.levels[i].offset, file.GetData() + levels[i].offset, levels[i].size);
+        return result;
+    }
+
+    MipChain TextureFile::Load(const std::string& p_path)
+    {
+        auto result = Read(p_path);
+        if (result.format != BlockFormat::NONE && !Graphics::IsBlockFormatSupported(result.format))
+            return BlockCompression::Decompress(result);
+        return result;
+    }
+
+    void TextureFile::Write(const std::string& p_path, const MipChain& p_image)
+    {
+        if (p_image.levels.empty())
+            throw std::runtime_error("Cannot write a texture without level.");
+        Header header{};
+        header.magic = MAGIC;
+        header.version = VERSION;
+        header.format = static_cast<uint32_t>(p_image.format);
+        header.channels = (uint32_t)p_image.channels;
+        header.width = p_image.levels[0].width;
+        header.height = p_image.levels[0].height;
+        header.level_count = p_image.levels.size();
+        std::vector<Level> levels(p_image.levels.size());
+        // The data starts 16 bytes aligned, after the table of the levels.
+        size_t offset = (sizeof(Header) + levels.size() * sizeof(Level) + 15) / 16 * 16;
+        for (size_t i = 0; i < levels.size(); ++i)
+        {
+            levels[i].offset = offset + p_image.levels[i].offset;
+            levels[i].size = p_image.GetLevelSize(i);
+        }
+
+        std::ofstream output(p_path, std::ios::binary | std::ios::trunc);
+        if (!output.is_open())
+            throw std::runtime_error("Failed to open file: \"" + p_path + "\".");
+        output.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+        output.write(reinterpret_cast<const char*>(levels.data()), levels.size() * sizeof(Level));
+        const char padding[16] = {};
+        output.write(padding, offset - sizeof(Header) - levels.size() * sizeof(Level));
+        output.write(reinterpret_cast<const char*>(p_image.pixels.get()), p_image.GetSize());
+        if (!output.good())
+            throw std::runtime_error("Failed to write file: \"" + p_path + "\".");
+    }
+}
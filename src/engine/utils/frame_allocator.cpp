@@ -0,0 +1,182 @@
+#include "ce/utils/frame_allocator.h"
+#include <new>
+#include <cstdlib>
+#include <iostream>
+#include <algorithm>
+#include <cstdint>
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
+
+#ifdef CE_TRACK_HEAP_ALLOCATIONS
+namespace
+{
+    thread_local size_t heap_allocation_count = 0;
+
+    void* AllocateAligned(std::size_t p_size, std::align_val_t p_alignment)
+    {
+        ++heap_allocation_count;
+        size_t alignment = static_cast<size_t>(p_alignment);
+        size_t size = p_size == 0 ? alignment : (p_size + alignment - 1) & ~(alignment - 1);
+#ifdef _MSC_VER
+        void* result = _aligned_malloc(size, alignment);
+#else
+        void* result = std::aligned_alloc(alignment, size);
+#endif
+        if (result == nullptr)
+            throw std::bad_alloc();
+        return result;
+    }
+
+    void FreeAligned(void* p_ptr) noexcept
+    {
+#ifdef _MSC_VER
+        _aligned_free(p_ptr);
+#else
+        std::free(p_ptr);
+#endif
+    }
+}
+
+void* operator new(std::size_t p_size)
+{
+    ++heap_allocation_count;
+    if (void* result = std::malloc(p_size == 0 ? 1 : p_size))
+        return result;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p_ptr) noexcept
+{
+    std::free(p_ptr);
+}
+
+void operator delete(void* p_ptr, std::size_t) noexcept
+{
+    std::free(p_ptr);
+}
+
+// The aligned forms do not go through operator new(size_t), and the pools allocate with them.
+void* operator new(std::size_t p_size, std::align_val_t p_alignment)
+{
+    return AllocateAligned(p_size, p_alignment);
+}
+
+void* operator new[](std::size_t p_size, std::align_val_t p_alignment)
+{
+    return AllocateAligned(p_size, p_alignment);
+}
+
+void operator delete(void* p_ptr, std::align_val_t) noexcept
+{
+    FreeAligned(p_ptr);
+}
+
+void operator delete(void* p_ptr, std::size_t, std::align_val_t) noexcept
+{
+    FreeAligned(p_ptr);
+}
+
+void operator delete[](void* p_ptr, std::align_val_t) noexcept
+{
+    FreeAligned(p_ptr);
+}
+
+void operator delete[](void* p_ptr, std::size_t, std::align_val_t) noexcept
+{
+    FreeAligned(p_ptr);
+}
+#endif
+
+namespace CrossEngine
+{
+    FrameAllocator::FrameAllocator(size_t p_block_size)
+        : block_size(p_block_size)
+    {
+    }
+
+    FrameAllocator::~FrameAllocator()
+    {
+        ReleaseBlocks();
+    }
+
+    FrameAllocator& FrameAllocator::GetThreadInstance()
+    {
+        thread_local FrameAllocator instance;
+        return instance;
+    }
+
+    size_t FrameAllocator::GetThreadHeapAllocationCount() noexcept
+    {
+#ifdef CE_TRACK_HEAP_ALLOCATIONS
+        return heap_allocation_count;
+#else
+        return 0;
+#endif
+    }
+
+    void FrameAllocator::AddBlock(size_t p_size)
+    {
+        blocks.push_back({static_cast<std::byte*>(::operator new(p_size)), p_size});
+        offset = 0;
+        ++upstream_allocation_count;
+    }
+
+    void FrameAllocator::ReleaseBlocks()
+    {
+        for (auto& block : blocks)
+            ::operator delete(block.data);
+        blocks.clear();
+        offset = 0;
+    }
+
+    void* FrameAllocator::do_allocate(size_t p_bytes, size_t p_alignment)
+    {
+        // The alignment is of the address, the blocks may be less aligned than it.
+        size_t aligned_offset = 0;
+        if (!blocks.empty())
+        {
+            uintptr_t base = reinterpret_cast<uintptr_t>(blocks.back().data);
+            aligned_offset = (base + offset + p_alignment - 1) / p_alignment * p_alignment - base;
+        }
+        if (blocks.empty() || aligned_offset + p_bytes > blocks.back().size)
+        {
+            AddBlock(std::max(block_size, p_bytes + p_alignment));
+            uintptr_t base = reinterpret_cast<uintptr_t>(blocks.back().data);
+            aligned_offset = (base + p_alignment - 1) / p_alignment * p_alignment - base;
+        }
+        offset = aligned_offset + p_bytes;
+        frame_bytes += p_bytes;
+        return blocks.back().data + aligned_offset;
+    }
+
+    void FrameAllocator::Reset()
+    {
+        ++frame_count;
+        peak_bytes = std::max(peak_bytes, frame_bytes);
+        if (blocks.size() > 1)
+        {
+            // Merge the blocks, so the next frame of the same size fits in one.
+            size_t size = 0;
+            for (auto& block : blocks)
+                size += block.size;
+            ReleaseBlocks();
+            block_size = std::max(block_size, size);
+            AddBlock(block_size);
+        }
+        offset = 0;
+        frame_bytes = 0;
+
+        size_t heap_allocations = GetThreadHeapAllocationCount();
+        if (frame_count > WARM_UP_FRAME_COUNT && heap_allocations != heap_allocation_mark)
+        {
+            if (steady_heap_allocation_count == 0)
+            {
+                std::cerr << "Frame " << frame_count << " made " << heap_allocations - heap_allocation_mark
+                    << " global heap allocations after the warm up frames." << std::endl;
+            }
+            steady_heap_allocation_count += heap_allocations - heap_allocation_mark;
+        }
+        heap_allocation_mark = GetThreadHeapAllocationCount();
+    }
+}
@@ -0,0 +1,133 @@
+#include "ce/utils/job_system.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+
+namespace CrossEngine
+{
+    namespace
+    {
+        // The chunks of a ParallelFor. Workers starting after every chunk is taken only touch this state,
+        // so it is shared with them.
+        struct ParallelForState
+        {
+            const std::function<void(size_t, size_t)>* func;
+            size_t count;
+            size_t chunk_size;
+            size_t chunk_count;
+            std::atomic<size_t> next_chunk = 0;
+            size_t finished_count = 0;
+            std::exception_ptr exception;
+            std::mutex mutex;
+            std::condition_variable finished_condition;
+
+            // Run chunks until none is left.
+            void Run()
+            {
+                size_t finished = 0;
+                std::exception_ptr first_exception;
+                for (size_t chunk = next_chunk++; chunk < chunk_count; chunk = next_chunk++)
+                {
+                    try
+                    {
+                        size_t first = chunk * chunk_size;
+                        (*func)(first, std::min(first + chunk_size, count));
+                    }
+                    catch (...)
+                    {
+                        if (first_exception == nullptr)
+                            first_exception = std::current_exception();
+                    }
+                    ++finished;
+                }
+                if (finished == 0)
+                    return;
+                std::lock_guard<std::mutex> lock(mutex);
+                if (exception == nullptr)
+                    exception = first_exception;
+                finished_count += finished;
+                if (finished_count == chunk_count)
+                    finished_condition.notify_all();
+            }
+        };
+    }
+
+    JobSystem::JobSystem(size_t p_worker_count)
+    {
+        p_worker_count = std::max<size_t>(p_worker_count, 1);
+        workers.reserve(p_worker_count);
+        for (size_t i = 0; i < p_worker_count; ++i)
+            workers.emplace_back(&JobSystem::WorkerFunc, this);
+    }
+
+    JobSystem::~JobSystem()
+    {
+        {
+            std::lock_guard<std::mutex> lock(jobs_mutex);
+            is_stopping = true;
+        }
+        jobs_condition.notify_all();
+        for (auto& worker : workers)
+            worker.join();
+    }
+
+    JobSystem& JobSystem::GetInstance()
+    {
+        // The calling thread takes part in the work, so one hardware thread is left to it.
+        static JobSystem instance(std::max<size_t>(std::thread::hardware_concurrency(), 2) - 1);
+        return instance;
+    }
+
+    void JobSystem::WorkerFunc()
+    {
+        while (true)
+        {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(jobs_mutex);
+                jobs_condition.wait(lock, [this]() { return is_stopping || !jobs.empty(); });
+                if (jobs.empty())
+                    return;
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+            job();
+        }
+    }
+
+    void JobSystem::ParallelFor(size_t p_count, size_t p_chunk_size, const std::function<void(size_t, size_t)>& p_func)
+    {
+        if (p_count == 0)
+            return;
+        p_chunk_size = std::max<size_t>(p_chunk_size, 1);
+        size_t chunk_count = (p_count + p_chunk_size - 1) / p_chunk_size;
+        if (chunk_count == 1)
+        {
+            p_func(0, p_count);
+            return;
+        }
+
+        auto state = std::make_shared<ParallelForState>();
+        state->func = &p_func;
+        state->count = p_count;
+        state->chunk_size = p_chunk_size;
+        state->chunk_count = chunk_count;
+        size_t helper_count = std::min(chunk_count - 1, workers.size());
+        {
+            std::lock_guard<std::mutex> lock(jobs_mutex);
+            for (size_t i = 0; i < helper_count; ++i)
+                jobs.push_back([state]() { state->Run(); });
+        }
+        if (helper_count == 1)
+            jobs_condition.notify_one();
+        else
+            jobs_condition.notify_all();
+
+        state->Run();
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->finished_condition.wait(lock, [&state]() { return state->finished_count == state->chunk_count; });
+        if (state->exception != nullptr)
+            std::rethrow_exception(state->exception);
+    }
+}
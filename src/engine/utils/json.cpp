@@ -0,0 +1,236 @@
+#include "ce/utils/json.h"
+#include <charconv>
+#include <stdexcept>
+
+namespace CrossEngine
+{
+    class JsonParser
+    {
+    private:
+        static constexpr size_t MAX_DEPTH = 256;
+
+        std::string_view text;
+        size_t position = 0;
+        size_t depth = 0;
+
+        [[noreturn]] void Fail(const char* p_message) const
+        {
+            throw std::runtime_error(std::string("Invalid json: ") + p_message + " at " + std::to_string(position) + ".");
+        }
+
+        void SkipSpaces() noexcept
+        {
+            while (position < text.size() && (text[position] == ' ' || text[position] == '\t'
+                || text[position] == '\n' || text[position] == '\r'))
+                ++position;
+        }
+
+        bool Consume(char p_char) noexcept
+        {
+            SkipSpaces();
+            if (position < text.size() && text[position] == p_char)
+            {
+                ++position;
+                return true;
+            }
+            return false;
+        }
+
+        void Expect(char p_char)
+        {
+            if (!Consume(p_char))
+                Fail("unexpected character");
+        }
+
+        void ExpectWord(std::string_view p_word)
+        {
+            if (text.substr(position, p_word.size()) != p_word)
+                Fail("unexpected word");
+            position += p_word.size();
+        }
+
+        uint32_t ParseHex()
+        {
+            uint32_t result = 0;
+            auto begin = text.data() + position;
+            if (position + 4 > text.size() || std::from_chars(begin, begin + 4, result, 16).ptr != begin + 4)
+                Fail("invalid escape");
+            position += 4;
+            return result;
+        }
+
+        void AppendUtf8(std::string& p_result, uint32_t p_code)
+        {
+            if (p_code < 0x80)
+                p_result += (char)p_code;
+            else if (p_code < 0x800)
+            {
+                p_result += (char)(0xC0 | (p_code >> 6));
+                p_result += (char)(0x80 | (p_code & 0x3F));
+            }
+            else if (p_code < 0x10000)
+            {
+                p_result += (char)(0xE0 | (p_code >> 12));
+                p_result += (char)(0x80 | ((p_code >> 6) & 0x3F));
+                p_result += (char)(0x80 | (p_code & 0x3F));
+            }
+            else
+            {
+                p_result += (char)(0xF0 | (p_code >> 18));
+                p_result += (char)(0x80 | ((p_code >> 12) & 0x3F));
+                p_result += (char)(0x80 | ((p_code >> 6) & 0x3F));
+                p_result += (char)(0x80 | (p_code & 0x3F));
+            }
+        }
+
+        std::string ParseString()
+        {
+            Expect('"');
+            std::string result;
+            while (true)
+            {
+                // Copy the runs without escapes at once.
+                size_t end = text.find_first_of("\"\\", position);
+                if (end == std::string_view::npos)
+                    Fail("unterminated string");
+                result.append(text.data() + position, end - position);
+                position = end + 1;
+                if (text[end] == '"')
+                    return result;
+                if (position >= text.size())
+                    Fail("unterminated string");
+                char escape = text[position++];
+                switch (escape)
+                {
+                case '"': result += '"'; break;
+                case '\\': result += '\\'; break;
+                case '/': result += '/'; break;
+                case 'b': result += '\b'; break;
+                case 'f': result += '\f'; break;
+                case 'n': result += '\n'; break;
+                case 'r': result += '\r'; break;
+                case 't': result += '\t'; break;
+                case 'u':
+                {
+                    uint32_t code = ParseHex();
+                    if (code >= 0xD800 && code < 0xDC00 && text.substr(position, 2) == "\\u")
+                    {
+                        position += 2;
+                        uint32_t low = ParseHex();
+                        if (low < 0xDC00 || low >= 0xE000)
+                            Fail("invalid surrogate pair");
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    AppendUtf8(result, code);
+                    break;
+                }
+                default:
+                    Fail("invalid escape");
+                }
+            }
+        }
+
+        void ParseValue(Json& p_result)
+        {
+            SkipSpaces();
+            if (position >= text.size())
+                Fail("unexpected end");
+            if (++depth > MAX_DEPTH)
+                Fail("too deeply nested");
+            char c = text[position];
+            if (c == '{')
+            {
+                ++position;
+                p_result.type = Json::Type::Object;
+                if (!Consume('}'))
+                {
+                    do
+                    {
+                        SkipSpaces();
+                        auto& member = p_result.members.emplace_back(ParseString(), Json());
+                        Expect(':');
+                        ParseValue(member.second);
+                    } while (Consume(','));
+                    Expect('}');
+                }
+            }
+            else if (c == '[')
+            {
+                ++position;
+                p_result.type = Json::Type::Array;
+                if (!Consume(']'))
+                {
+                    do
+                    {
+                        ParseValue(p_result.elements.emplace_back());
+                    } while (Consume(','));
+                    Expect(']');
+                }
+            }
+            else if (c == '"')
+            {
+                p_result.type = Json::Type::String;
+                p_result.string = ParseString();
+            }
+            else if (c == 't' || c == 'f')
+            {
+                p_result.type = Json::Type::Boolean;
+                p_result.boolean = c == 't';
+                ExpectWord(c == 't' ? "true" : "false");
+            }
+            else if (c == 'n')
+                ExpectWord("null");
+            else
+            {
+                p_result.type = Json::Type::Number;
+                auto begin = text.data() + position;
+                auto [end, error] = std::from_chars(begin, text.data() + text.size(), p_result.number);
+                if (error != std::errc() || end == begin)
+                    Fail("invalid number");
+                position += end - begin;
+            }
+            --depth;
+        }
+    public:
+        explicit JsonParser(std::string_view p_text) noexcept : text(p_text) {}
+
+        Json Parse()
+        {
+            Json result;
+            ParseValue(result);
+            SkipSpaces();
+            if (position != text.size())
+                Fail("trailing characters");
+            return result;
+        }
+    };
+
+    Json Json::Parse(std::string_view p_text)
+    {
+        return JsonParser(p_text).Parse();
+    }
+
+    const Json& Json::operator[](size_t p_index) const
+    {
+        if (p_index >= elements.size())
+            throw std::out_of_range("The json array index is out of range.");
+        return elements[p_index];
+    }
+
+    const Json* Json::Find(std::string_view p_key) const noexcept
+    {
+        for (auto& member : members)
+        {
+            if (member.first == p_key)
+                return &member.second;
+        }
+        return nullptr;
+    }
+
+    const Json& Json::operator[](std::string_view p_key) const noexcept
+    {
+        static const Json null_value;
+        auto result = Find(p_key);
+        return result != nullptr ? *result : null_value;
+    }
+}
@@ -0,0 +1,72 @@
+#include "ce/utils/radix_sort.h"
+#include <cstring>
+#include <stdexcept>
+
+namespace CrossEngine
+{
+    void RadixSort(std::vector<uint32_t>& p_keys, std::vector<uint32_t>& p_values, RadixSortBuffers& p_buffers)
+    {
+        constexpr uint32_t RADIX_BITS = 11;
+        constexpr uint32_t BUCKET_COUNT = 1 << RADIX_BITS;
+        constexpr uint32_t PASS_COUNT = (32 + RADIX_BITS - 1) / RADIX_BITS;
+
+        if (p_keys.size() != p_values.size())
+            throw std::invalid_argument("The count of keys does not match the count of values.");
+        size_t count = p_keys.size();
+        if (count < 2)
+            return;
+
+        // Histograms of every pass are built in a single read of the keys.
+        auto& histograms = p_buffers.histograms;
+        histograms.assign(BUCKET_COUNT * PASS_COUNT, 0);
+        for (size_t i = 0; i < count; ++i)
+        {
+            uint32_t key = p_keys[i];
+            for (uint32_t pass = 0; pass < PASS_COUNT; ++pass)
+                ++histograms[pass * BUCKET_COUNT + ((key >> (pass * RADIX_BITS)) & (BUCKET_COUNT - 1))];
+        }
+
+        if (p_buffers.keys.size() < count)
+        {
+            p_buffers.keys.resize(count);
+            p_buffers.values.resize(count);
+        }
+        uint32_t* keys = p_keys.data();
+        uint32_t* values = p_values.data();
+        uint32_t* keys_out = p_buffers.keys.data();
+        uint32_t* values_out = p_buffers.values.data();
+        for (uint32_t pass = 0; pass < PASS_COUNT; ++pass)
+        {
+            uint32_t* histogram = histograms.data() + pass * BUCKET_COUNT;
+            // Skip the pass if every key falls in the same bucket.
+            if (histogram[(keys[0] >> (pass * RADIX_BITS)) & (BUCKET_COUNT - 1)] == count)
+                continue;
+            uint32_t sum = 0;
+            for (uint32_t i = 0; i < BUCKET_COUNT; ++i)
+            {
+                uint32_t bucket_count = histogram[i];
+                histogram[i] = sum;
+                sum += bucket_count;
+            }
+            for (size_t i = 0; i < count; ++i)
+            {
+                uint32_t position = histogram[(keys[i] >> (pass * RADIX_BITS)) & (BUCKET_COUNT - 1)]++;
+                keys_out[position] = keys[i];
+                values_out[position] = values[i];
+            }
+            std::swap(keys, keys_out);
+            std::swap(values, values_out);
+        }
+        if (keys != p_keys.data())
+        {
+            std::memcpy(p_keys.data(), keys, count * sizeof(uint32_t));
+            std::memcpy(p_values.data(), values, count * sizeof(uint32_t));
+        }
+    }
+
+    void RadixSort(std::vector<uint32_t>& p_keys, std::vector<uint32_t>& p_values)
+    {
+        RadixSortBuffers buffers;
+        RadixSort(p_keys, p_values, buffers);
+    }
+}
@@ -0,0 +1,81 @@
+#include "ce/utils/rectangle_packer.h"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace CrossEngine
+{
+    RectanglePacker::RectanglePacker(size_t p_width, size_t p_height)
+        : width(p_width), height(p_height)
+    {
+        if (p_width == 0 || p_height == 0)
+            throw std::invalid_argument("The size to pack into should not be 0.");
+        Clear();
+    }
+
+    std::optional<RectanglePacker::Rect> RectanglePacker::Insert(size_t p_width, size_t p_height)
+    {
+        if (p_width == 0 || p_height == 0 || p_width > width || p_height > height)
+            return std::nullopt;
+        size_t best_index = skyline.size();
+        size_t best_y = 0;
+        size_t best_top = std::numeric_limits<size_t>::max();
+        size_t best_width = std::numeric_limits<size_t>::max();
+        for (size_t i = 0; i < skyline.size() && skyline[i].x + p_width <= width; ++i)
+        {
+            // The rectangle rests on the highest segment below it.
+            size_t y = 0;
+            size_t covered = 0;
+            for (size_t j = i; covered < p_width; ++j)
+            {
+                y = std::max(y, skyline[j].y);
+                covered += skyline[j].width;
+            }
+            if (y + p_height > height)
+                continue;
+            if (y + p_height < best_top || (y + p_height == best_top && skyline[i].width < best_width))
+            {
+                best_index = i;
+                best_y = y;
+                best_top = y + p_height;
+                best_width = skyline[i].width;
+            }
+        }
+        if (best_index == skyline.size())
+            return std::nullopt;
+
+        Rect result{skyline[best_index].x, best_y, p_width, p_height};
+        skyline.insert(skyline.begin() + best_index, Segment{result.x, best_top, p_width});
+        // Cut the segments now below the rectangle.
+        size_t end = result.x + p_width;
+        for (size_t i = best_index + 1; i < skyline.size() && skyline[i].x < end;)
+        {
+            size_t overlap = end - skyline[i].x;
+            if (skyline[i].width > overlap)
+            {
+                skyline[i].x += overlap;
+                skyline[i].width -= overlap;
+                break;
+            }
+            skyline.erase(skyline.begin() + i);
+        }
+        for (size_t i = 0; i + 1 < skyline.size();)
+        {
+            if (skyline[i].y == skyline[i + 1].y)
+            {
+                skyline[i].width += skyline[i + 1].width;
+                skyline.erase(skyline.begin() + i + 1);
+            }
+            else
+                ++i;
+        }
+        used_area += p_width * p_height;
+        return result;
+    }
+
+    void RectanglePacker::Clear()
+    {
+        skyline.assign(1, Segment{0, 0, width});
+        used_area = 0;
+    }
+}
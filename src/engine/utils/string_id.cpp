@@ -0,0 +1,71 @@
+#include "ce/utils/string_id.h"
+#include <deque>
+#include <unordered_map>
+#include <shared_mutex>
+#include <mutex>
+
+namespace CrossEngine
+{
+    namespace
+    {
+        struct StringTable
+        {
+            // The strings never move, the ids map views of them.
+            std::deque<std::string> strings;
+            std::unordered_map<std::string_view, uint32_t> ids;
+            std::shared_mutex mutex;
+        };
+
+        StringTable& GetStringTable()
+        {
+            static StringTable table;
+            return table;
+        }
+    }
+
+    StringId StringId::Intern(std::string_view p_string)
+    {
+        auto& table = GetStringTable();
+        {
+            std::shared_lock lock(table.mutex);
+            auto it = table.ids.find(p_string);
+            if (it != table.ids.end())
+                return StringId(it->second);
+        }
+        std::unique_lock lock(table.mutex);
+        auto it = table.ids.find(p_string);
+        if (it != table.ids.end())
+            return StringId(it->second);
+        uint32_t id = (uint32_t)table.strings.size();
+        table.strings.emplace_back(p_string);
+        table.ids.emplace(table.strings.back(), id);
+        return StringId(id);
+    }
+
+    StringId StringId::Find(std::string_view p_string)
+    {
+        auto& table = GetStringTable();
+        std::shared_lock lock(table.mutex);
+        auto it = table.ids.find(p_string);
+        if (it == table.ids.end())
+            return StringId();
+        return StringId(it->second);
+    }
+
+    size_t StringId::GetInternedCount()
+    {
+        auto& table = GetStringTable();
+        std::shared_lock lock(table.mutex);
+        return table.strings.size();
+    }
+
+    const std::string& StringId::GetString() const
+    {
+        static const std::string empty;
+        if (!IsValid())
+            return empty;
+        auto& table = GetStringTable();
+        std::shared_lock lock(table.mutex);
+        return table.strings[id];
+    }
+}
@@ -0,0 +1,226 @@
+#include "ce/utils/tlsf_allocator.h"
+#include <bit>
+#include <stdexcept>
+
+namespace CrossEngine
+{
+    TLSFAllocator::TLSFAllocator(size_t p_size, size_t p_granularity)
+        : granularity(p_granularity)
+    {
+        if (p_granularity == 0)
+            throw std::invalid_argument("The granularity must not be 0.");
+        for (auto& i : free_lists)
+        {
+            for (auto& j : i)
+                j = INVALID_BLOCK;
+        }
+        Grow(p_size);
+    }
+
+    void TLSFAllocator::MapSize(size_t p_units, size_t& p_fl, size_t& p_sl)
+    {
+        if (p_units < SL_COUNT)
+        {
+            p_fl = 0;
+            p_sl = p_units;
+            return;
+        }
+        size_t msb = std::bit_width(p_units) - 1;
+        p_fl = msb - SL_LOG2 + 1;
+        p_sl = (p_units >> (msb - SL_LOG2)) - SL_COUNT;
+    }
+
+    uint32_t TLSFAllocator::NewBlock()
+    {
+        if (!unused_blocks.empty())
+        {
+            uint32_t block = unused_blocks.back();
+            unused_blocks.pop_back();
+            blocks[block] = Block();
+            return block;
+        }
+        blocks.emplace_back();
+        return (uint32_t)(blocks.size() - 1);
+    }
+
+    void TLSFAllocator::InsertFreeBlock(uint32_t p_block)
+    {
+        size_t fl, sl;
+        MapSize(blocks[p_block].size, fl, sl);
+        auto& block = blocks[p_block];
+        block.is_free = true;
+        block.prev_free = INVALID_BLOCK;
+        block.next_free = free_lists[fl][sl];
+        if (block.next_free != INVALID_BLOCK)
+            blocks[block.next_free].prev_free = p_block;
+        free_lists[fl][sl] = p_block;
+        fl_bitmap |= (uint64_t)1 << fl;
+        sl_bitmaps[fl] |= (uint32_t)1 << sl;
+        free_size += block.size;
+    }
+
+    void TLSFAllocator::RemoveFreeBlock(uint32_t p_block)
+    {
+        size_t fl, sl;
+        auto& block = blocks[p_block];
+        MapSize(block.size, fl, sl);
+        if (block.prev_free != INVALID_BLOCK)
+            blocks[block.prev_free].next_free = block.next_free;
+        else
+            free_lists[fl][sl] = block.next_free;
+        if (block.next_free != INVALID_BLOCK)
+            blocks[block.next_free].prev_free = block.prev_free;
+        if (free_lists[fl][sl] == INVALID_BLOCK)
+        {
+            sl_bitmaps[fl] &= ~((uint32_t)1 << sl);
+            if (sl_bitmaps[fl] == 0)
+                fl_bitmap &= ~((uint64_t)1 << fl);
+        }
+        block.is_free = false;
+        free_size -= block.size;
+    }
+
+    void TLSFAllocator::MergeWithNext(uint32_t p_block)
+    {
+        uint32_t next = blocks[p_block].next_physical;
+        blocks[p_block].size += blocks[next].size;
+        blocks[p_block].next_physical = blocks[next].next_physical;
+        if (blocks[next].next_physical != INVALID_BLOCK)
+            blocks[blocks[next].next_physical].prev_physical = p_block;
+        else
+            last_block = p_block;
+        blocks[next].size = 0;
+        unused_blocks.push_back(next);
+    }
+
+    void TLSFAllocator::MapSearchSize(size_t p_size, size_t& p_fl, size_t& p_sl) const
+    {
+        size_t units = std::max<size_t>((p_size + granularity - 1) / granularity, 1);
+        // Round up to the next list, so every block of the list found fits.
+        if (units >= SL_COUNT)
+            units += ((size_t)1 << (std::bit_width(units) - 1 - SL_LOG2)) - 1;
+        MapSize(units, p_fl, p_sl);
+    }
+
+    uint32_t TLSFAllocator::GetLargestFreeClass() const noexcept
+    {
+        if (fl_bitmap == 0)
+            return INVALID_CLASS;
+        size_t fl = std::bit_width(fl_bitmap) - 1;
+        size_t sl = std::bit_width(sl_bitmaps[fl]) - 1;
+        return (uint32_t)(fl * SL_COUNT + sl);
+    }
+
+    uint32_t TLSFAllocator::GetAllocationClass(size_t p_size) const noexcept
+    {
+        size_t fl, sl;
+        MapSearchSize(p_size, fl, sl);
+        if (fl >= FL_COUNT)
+            return INVALID_CLASS;
+        return (uint32_t)(fl * SL_COUNT + sl);
+    }
+
+    uint32_t TLSFAllocator::Allocate(size_t p_size)
+    {
+        size_t units = std::max<size_t>((p_size + granularity - 1) / granularity, 1);
+        size_t fl, sl;
+        MapSearchSize(p_size, fl, sl);
+        if (fl >= FL_COUNT)
+            return INVALID_BLOCK;
+
+        uint32_t sl_map = sl_bitmaps[fl] & (~(uint32_t)0 << sl);
+        if (sl_map == 0)
+        {
+            uint64_t fl_map = fl + 1 < 64 ? fl_bitmap & (~(uint64_t)0 << (fl + 1)) : 0;
+            if (fl_map == 0)
+                return INVALID_BLOCK;
+            fl = std::countr_zero(fl_map);
+            sl_map = sl_bitmaps[fl];
+        }
+        sl = std::countr_zero(sl_map);
+
+        uint32_t block = free_lists[fl][sl];
+        RemoveFreeBlock(block);
+        if (blocks[block].size > units)
+        {
+            uint32_t remain = NewBlock();
+            auto& split = blocks[block];
+            blocks[remain].offset = split.offset + units;
+            blocks[remain].size = split.size - units;
+            blocks[remain].prev_physical = block;
+            blocks[remain].next_physical = split.next_physical;
+            if (split.next_physical != INVALID_BLOCK)
+                blocks[split.next_physical].prev_physical = remain;
+            else
+                last_block = remain;
+            split.next_physical = remain;
+            split.size = units;
+            InsertFreeBlock(remain);
+        }
+        return block;
+    }
+
+    void TLSFAllocator::Free(uint32_t p_block)
+    {
+        if (p_block >= blocks.size() || blocks[p_block].is_free || blocks[p_block].size == 0)
+            throw std::invalid_argument("The block is not allocated.");
+        uint32_t next = blocks[p_block].next_physical;
+        if (next != INVALID_BLOCK && blocks[next].is_free)
+        {
+            RemoveFreeBlock(next);
+            MergeWithNext(p_block);
+        }
+        uint32_t prev = blocks[p_block].prev_physical;
+        if (prev != INVALID_BLOCK && blocks[prev].is_free)
+        {
+            RemoveFreeBlock(prev);
+            MergeWithNext(prev);
+            p_block = prev;
+        }
+        InsertFreeBlock(p_block);
+    }
+
+    void TLSFAllocator::Grow(size_t p_size)
+    {
+        size_t units = p_size / granularity;
+        if (units <= size)
+            return;
+        size_t added = units - size;
+        if (last_block != INVALID_BLOCK && blocks[last_block].is_free)
+        {
+            RemoveFreeBlock(last_block);
+            blocks[last_block].size += added;
+            InsertFreeBlock(last_block);
+        }
+        else
+        {
+            uint32_t block = NewBlock();
+            blocks[block].offset = size;
+            blocks[block].size = added;
+            blocks[block].prev_physical = last_block;
+            if (last_block != INVALID_BLOCK)
+                blocks[last_block].next_physical = block;
+            last_block = block;
+            InsertFreeBlock(block);
+        }
+        size = units;
+    }
+
+    uint32_t TLSFAllocator::AllocateLast()
+    {
+        if (last_block == INVALID_BLOCK || !blocks[last_block].is_free)
+            return INVALID_BLOCK;
+        RemoveFreeBlock(last_block);
+        return last_block;
+    }
+
+    uint32_t TLSFAllocator::GetLastAllocatedBlock() const noexcept
+    {
+        if (last_block == INVALID_BLOCK)
+            return INVALID_BLOCK;
+        // Free neighbours are merged, so the block before a free last block is allocated.
+        if (blocks[last_block].is_free)
+            return blocks[last_block].prev_physical;
+        return last_block;
+    }
+}
@@ -0,0 +1,122 @@
+#include "../unit_test/unit_test.h"
+#include "ce/component/component3D.h"
+#include "ce/component/component_pool.hpp"
+
+using namespace CrossEngine;
+
+namespace
+{
+    class CountedComponent : public Component3D
+    {
+    public:
+        inline static size_t destroyed_count = 0;
+        ~CountedComponent() { ++destroyed_count; }
+    };
+}
+
+void UnitTest::TestComponentPool0()
+{
+    CountedComponent::destroyed_count = 0;
+    ComponentPool<CountedComponent> pool;
+    auto root = std::make_shared<Component3D>();
+    auto a = pool.Create();
+    auto child = pool.Get(a);
+    root->AddChild(child);
+    EXPECT_VALUES_EQUAL(root->GetChildren().size(), (size_t)1);
+    CHECK_EXPECT(child->GetParent() == root, "The parent of a pooled child should be resolved.");
+
+    // Moving the parent marks the pooled child dirty.
+    root->SetGlobalPosition(Math::Pos(1.0f, 2.0f, 3.0f));
+    EXPECT_VALUES_EQUAL(child->GetGlobalPosition(), Math::Pos(1.0f, 2.0f, 3.0f));
+
+    // A destroyed component is detached at once, and destructed after every thread finishes two frames.
+    auto registry_handle = child->GetHandle();
+    pool.Destroy(a);
+    CHECK_EXPECT(pool.Get(a) == nullptr, "A destroyed component should not be resolved.");
+    CHECK_EXPECT(ComponentRegistry::Get(registry_handle) == nullptr, "A destroyed component should be unregistered.");
+    EXPECT_VALUES_EQUAL(root->GetChildren().size(), (size_t)0);
+    EXPECT_VALUES_EQUAL(pool.Size(), (size_t)0);
+    EXPECT_VALUES_EQUAL(CountedComponent::destroyed_count, (size_t)0);
+    int thread;
+    ComponentRegistry::EndFrame(&thread);
+    ComponentRegistry::EndFrame(&thread);
+    pool.Collect();
+    EXPECT_VALUES_EQUAL(CountedComponent::destroyed_count, (size_t)1);
+    ComponentRegistry::RemoveThread(&thread);
+
+    // The slot is reused, the stale handle stays stale.
+    auto b = pool.Create();
+    EXPECT_VALUES_EQUAL(b.index, a.index);
+    CHECK_EXPECT(!(b == a), "A reused slot should have a new generation.");
+    CHECK_EXPECT(pool.Get(a) == nullptr, "A stale handle should not resolve to the new component.");
+    pool.Destroy(a);
+    EXPECT_VALUES_EQUAL(pool.Size(), (size_t)1);
+
+    // Children owned by shared pointers are dropped from the tree when they expire.
+    auto shared_child = std::make_shared<Component3D>();
+    root->AddChild(shared_child);
+    EXPECT_VALUES_EQUAL(root->GetChildren().size(), (size_t)1);
+    shared_child.reset();
+    EXPECT_VALUES_EQUAL(root->GetChildren().size(), (size_t)0);
+}
+
+void UnitTest::TestComponentPath0()
+{
+    auto root = std::make_shared<Component>("root");
+    auto level = std::make_shared<Component>("level");
+    root->AddChild(level);
+    std::vector<std::shared_ptr<Component>> rooms;
+    for (size_t i = 0; i < 100; ++i)
+    {
+        rooms.push_back(std::make_shared<Component>("room" + std::to_string(i)));
+        level->AddChild(rooms.back());
+    }
+    auto door = std::make_shared<Component>("door");
+    rooms[3]->AddChild(door);
+
+    CHECK_EXPECT(level->GetChild("room42") == rooms[42], "The child should be found by its name.");
+    CHECK_EXPECT(level->GetChild(StringId::Intern("room42")) == rooms[42], "The child should be found by its interned name.");
+    CHECK_EXPECT(level->GetChild("a name never used") == nullptr, "An unknown name should not be found.");
+    CHECK_EXPECT(root->FindPath("level/room3/door") == door, "The path should be resolved.");
+    CHECK_EXPECT(root->FindPath("level/room3/door") == door, "The cached path should be resolved.");
+    CHECK_EXPECT(root->FindPath("level/room4/door") == nullptr, "A wrong path should not be resolved.");
+
+    // Two children of the same name resolve to the first one, then to the second one once it is removed.
+    auto other_door = std::make_shared<Component>("door");
+    rooms[3]->AddChild(other_door);
+    CHECK_EXPECT(root->FindPath("level/room3/door") == door, "The first child of the name should be found.");
+    rooms[3]->RemoveChild(door.get());
+    CHECK_EXPECT(root->FindPath("level/room3/door") == other_door, "Removing a child should invalidate the cached path.");
+    other_door->SetName("gate");
+    CHECK_EXPECT(root->FindPath("level/room3/door") == nullptr, "Renaming a child should invalidate the cached path.");
+    CHECK_EXPECT(root->FindPath("level/room3/gate") == other_door, "The renamed child should be found by its new name.");
+
+    // A destroyed child is skipped.
+    rooms[5]->AddChild(door);
+    auto second = std::make_shared<Component>("door");
+    rooms[5]->AddChild(second);
+    door.reset();
+    CHECK_EXPECT(root->FindPath("level/room5/door") == second, "A destroyed child should be skipped.");
+
+    // Moving or hiding a component changes the content version of its ancestors, not their structure version.
+    auto lamp = std::make_shared<Component3D>("lamp");
+    rooms[7]->AddChild(lamp);
+    uint64_t structure_version = root->GetStructureVersion();
+    uint64_t content_version = root->GetContentVersion();
+    lamp->SetPosition(Math::Pos(1.0f, 2.0f, 3.0f));
+    CHECK_EXPECT(root->GetContentVersion() > content_version, "Moving a component should change the content version.");
+    lamp->GetSubspaceMatrix();
+    content_version = root->GetContentVersion();
+    // A write through the reference is seen once the matrix is recomputed, after the write.
+    lamp->Position() = Math::Pos(4.0f, 5.0f, 6.0f);
+    EXPECT_VALUES_EQUAL(root->GetContentVersion(), content_version);
+    lamp->GetSubspaceMatrix();
+    CHECK_EXPECT(root->GetContentVersion() > content_version, "Recomputing the matrix should change the content version.");
+    content_version = root->GetContentVersion();
+    rooms[7]->SetVisible(false);
+    CHECK_EXPECT(root->GetContentVersion() > content_version, "Hiding a component should change the content version.");
+    content_version = root->GetContentVersion();
+    rooms[7]->SetVisible(false);
+    EXPECT_VALUES_EQUAL(root->GetContentVersion(), content_version);
+    EXPECT_VALUES_EQUAL(root->GetStructureVersion(), structure_version);
+}
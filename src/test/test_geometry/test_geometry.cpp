@@ -0,0 +1,149 @@
+#include "../unit_test/unit_test.h"
+#include "ce/geometry/bvh.h"
+#include "ce/geometry/geometry_arena.h"
+#include "ce/geometry/polygon.h"
+
+using namespace CrossEngine;
+
+namespace
+{
+    // A grid of quads on the z = 0 plane, two triangles per cell.
+    std::vector<float> CreateGrid(size_t p_size)
+    {
+        std::vector<float> positions;
+        for (size_t i = 0; i < p_size; ++i)
+        {
+            for (size_t j = 0; j < p_size; ++j)
+            {
+                float x = (float)i, y = (float)j;
+                positions.insert(positions.end(), {x, y, 0.0f, x + 1, y, 0.0f, x, y + 1, 0.0f});
+                positions.insert(positions.end(), {x + 1, y, 0.0f, x + 1, y + 1, 0.0f, x, y + 1, 0.0f});
+            }
+        }
+        return positions;
+    }
+}
+
+void UnitTest::TestBVH0()
+{
+    TriangleBVH bvh;
+    RayHit hit;
+    EXPECT_VALUES_EQUAL(bvh.Intersect(Math::Pos(), Math::Vec4(0.0f, 0.0f, 1.0f, 0.0f), hit), false);
+    Math::Vec4 min, max;
+    EXPECT_EXPRESSION_THROW_TYPE(([&](){ bvh.GetBounds(min, max); }), std::out_of_range);
+
+    auto positions = CreateGrid(32);
+    bvh.Build(positions.data(), positions.size() / 9);
+    EXPECT_VALUES_EQUAL(bvh.GetTriangleCount(), (size_t)(32 * 32 * 2));
+    bvh.GetBounds(min, max);
+    EXPECT_VALUES_EQUAL(max[0], 32.0f);
+    EXPECT_VALUES_EQUAL(max[1], 32.0f);
+
+    CHECK_EXPECT(bvh.Intersect(Math::Pos(10.25f, 3.25f, -5.0f), Math::Vec4(0.0f, 0.0f, 2.0f, 0.0f), hit), "The ray should hit the grid.");
+    EXPECT_VALUES_EQUAL(hit.distance, 2.5f);
+    EXPECT_VALUES_EQUAL(hit.triangle_index, (size_t)((10 * 32 + 3) * 2));
+    EXPECT_VALUES_EQUAL(bvh.Intersect(Math::Pos(10.25f, 3.25f, -5.0f), Math::Vec4(0.0f, 0.0f, 1.0f, 0.0f), hit, 4.0f), false);
+    EXPECT_VALUES_EQUAL(bvh.Intersect(Math::Pos(40.0f, 3.25f, -5.0f), Math::Vec4(0.0f, 0.0f, 1.0f, 0.0f), hit), false);
+    EXPECT_VALUES_EQUAL(bvh.Intersect(Math::Pos(10.25f, 3.25f, 5.0f), Math::Vec4(0.0f, 0.0f, 1.0f, 0.0f), hit), false);
+
+    Math::Mat4 transform = Math::Trans(0.0f, 0.0f, 10.0f) * Math::Scale(2.0f, 2.0f, 2.0f);
+    CHECK_EXPECT(bvh.Intersect(transform, Math::Pos(20.5f, 6.5f, 0.0f), Math::Vec4(0.0f, 0.0f, 1.0f, 0.0f), hit), "The ray should hit the instance.");
+    EXPECT_VALUES_EQUAL(hit.distance, 10.0f);
+    EXPECT_VALUES_EQUAL(hit.triangle_index, (size_t)((10 * 32 + 3) * 2));
+}
+
+void UnitTest::TestBVH1()
+{
+    auto positions = CreateGrid(16);
+    TriangleBVH bvh(positions.data(), positions.size() / 9);
+
+    ClosestHit closest;
+    CHECK_EXPECT(bvh.GetClosestPosition(Math::Pos(4.5f, 4.5f, 3.0f), closest), "A closest position should be found.");
+    EXPECT_VALUES_EQUAL(closest.distance_squared, 9.0f);
+    EXPECT_VALUES_EQUAL(closest.position[2], 0.0f);
+    CHECK_EXPECT(bvh.GetClosestPosition(Math::Pos(-3.0f, -4.0f, 0.0f), closest), "A closest position should be found.");
+    EXPECT_VALUES_EQUAL(closest.distance_squared, 25.0f);
+    EXPECT_VALUES_EQUAL(bvh.GetClosestPosition(Math::Pos(-3.0f, -4.0f, 0.0f), closest, 4.0f), false);
+
+    std::vector<size_t> overlaps;
+    EXPECT_VALUES_EQUAL(bvh.OverlapSphere(Math::Pos(4.5f, 4.5f, 3.0f), 1.0f, overlaps), (size_t)0);
+    EXPECT_VALUES_EQUAL(bvh.OverlapSphere(Math::Pos(4.5f, 4.5f, 0.5f), 0.6f, overlaps), (size_t)2);
+    EXPECT_VALUES_EQUAL(overlaps.size(), (size_t)2);
+
+    Math::Mat4 transform = Math::Trans(0.0f, 0.0f, 10.0f) * Math::Scale(2.0f, 2.0f, 2.0f);
+    CHECK_EXPECT(bvh.GetClosestPosition(transform, Math::Pos(9.0f, 9.0f, 13.0f), closest), "A closest position should be found.");
+    EXPECT_VALUES_EQUAL(closest.distance_squared, 9.0f);
+    EXPECT_VALUES_EQUAL(closest.position[2], 10.0f);
+    overlaps.clear();
+    EXPECT_VALUES_EQUAL(bvh.OverlapSphere(transform, Math::Pos(9.0f, 9.0f, 11.0f), 1.2f, overlaps), (size_t)2);
+}
+
+void UnitTest::TestBVH2()
+{
+    auto positions = CreateGrid(8);
+    auto grid = std::make_shared<const TriangleBVH>(positions.data(), positions.size() / 9);
+    InstanceBVH instances;
+    instances.Build({grid, grid, std::make_shared<const TriangleBVH>()},
+        {Math::Trans(0.0f, 0.0f, 10.0f), Math::Trans(100.0f, 0.0f, 20.0f), Math::Mat4()});
+    EXPECT_VALUES_EQUAL(instances.GetInstanceCount(), (size_t)3);
+
+    InstanceHit hit;
+    CHECK_EXPECT(instances.Intersect(Math::Pos(104.5f, 4.5f, 0.0f), Math::Vec4(0.0f, 0.0f, 1.0f, 0.0f), hit), "The ray should hit the second instance.");
+    EXPECT_VALUES_EQUAL(hit.instance_index, (size_t)1);
+    EXPECT_VALUES_EQUAL(hit.distance, 20.0f);
+
+    // Move the second instance in front of the first one.
+    instances.SetSubspaceMatrix(1, Math::Trans(0.0f, 0.0f, 5.0f));
+    EXPECT_EXPRESSION_THROW_TYPE(([&](){ instances.Intersect(Math::Pos(), Math::Vec4(0.0f, 0.0f, 1.0f, 0.0f), hit); }), std::logic_error);
+    instances.Refit();
+    std::vector<InstanceHit> hits;
+    EXPECT_VALUES_EQUAL(instances.IntersectAll(Math::Pos(4.5f, 4.5f, 0.0f), Math::Vec4(0.0f, 0.0f, 1.0f, 0.0f), hits), (size_t)2);
+    EXPECT_VALUES_EQUAL(hits[0].instance_index, (size_t)1);
+    EXPECT_VALUES_EQUAL(hits[1].instance_index, (size_t)0);
+
+    std::vector<Ray> rays;
+    for (size_t i = 0; i < 6; ++i)
+        rays.push_back({Math::Pos(i * 2.0f + 0.5f, 0.5f, 0.0f), Math::Vec4(0.0f, 0.0f, 1.0f, 0.0f)});
+    std::vector<InstanceHit> packet_hits(rays.size());
+    EXPECT_VALUES_EQUAL(instances.Intersect(rays.data(), packet_hits.data(), rays.size()), (size_t)4);
+    EXPECT_VALUES_EQUAL(packet_hits[0].distance, 5.0f);
+    EXPECT_VALUES_EQUAL(packet_hits[0].instance_index, (size_t)1);
+    CHECK_EXPECT(std::isinf(packet_hits[5].distance), "The last ray should miss.");
+}
+
+void UnitTest::TestGeometryArena0()
+{
+    // Pooled triangles are counted by the triangle pool, and their blocks are reused.
+    auto before = PoolAllocator<Triangle>::GetStats();
+    Triangle* pooled = new Triangle(Math::Pos(0.0f, 0.0f, 0.0f), Math::Pos(1.0f, 0.0f, 0.0f), Math::Pos(0.0f, 1.0f, 0.0f));
+    auto after = PoolAllocator<Triangle>::GetStats();
+    EXPECT_VALUES_EQUAL(after.allocation_count - before.allocation_count, (size_t)1);
+    EXPECT_VALUES_EQUAL(after.live_count - before.live_count, (size_t)1);
+    delete pooled;
+    Triangle* reused = new Triangle();
+    CHECK_EXPECT(reused == pooled, "The block of the freed triangle should be reused.");
+    delete reused;
+    EXPECT_VALUES_EQUAL(PoolAllocator<Triangle>::GetStats().live_count, before.live_count);
+
+    GeometryArena arena(1024);
+    Triangle* triangle = arena.CreateTriangle(Vertex(Math::Pos(0.0f, 0.0f, 0.0f)), Vertex(Math::Pos(1.0f, 0.0f, 0.0f)), Vertex(Math::Pos(0.0f, 1.0f, 0.0f)));
+    EXPECT_VALUES_EQUAL(triangle->GetVertex(1)->GetPosition()[0], 1.0f);
+    CHECK_EXPECT(triangle->GetVertex(0)->GetNext() == triangle->GetVertex(1), "The vertices should be connected.");
+    CHECK_EXPECT(triangle->GetVertex(0)->GetPrev() == triangle->GetVertex(2), "The vertices should be connected.");
+
+    // The triangles are bumped out of blocks of the given size.
+    for (size_t i = 0; i < 100; ++i)
+        arena.CreateTriangle();
+    EXPECT_VALUES_EQUAL(arena.GetTriangleCount(), (size_t)101);
+    EXPECT_VALUES_EQUAL(arena.GetUsedBytes() >= 101 * GeometryArena::TRIANGLE_SIZE, true);
+    EXPECT_VALUES_EQUAL(arena.GetBlockCount() >= arena.GetUsedBytes() / 1024, true);
+    EXPECT_VALUES_EQUAL(arena.GetReservedBytes(), arena.GetBlockCount() * 1024);
+
+    PolygonN quad;
+    for (auto& position : {Math::Pos(0.0f, 0.0f, 0.0f), Math::Pos(1.0f, 0.0f, 0.0f), Math::Pos(1.0f, 1.0f, 0.0f), Math::Pos(0.0f, 1.0f, 0.0f)})
+        quad.AddVertex(quad.GetVertexCount(), new Vertex(position));
+    std::vector<Triangle*> triangles;
+    quad.Triangulate(triangles, &arena);
+    CHECK_EXPECT(!triangles.empty(), "The quad should be triangulated.");
+    EXPECT_VALUES_EQUAL(arena.GetTriangleCount(), 101 + triangles.size());
+}
@@ -0,0 +1,714 @@
+#include "../unit_test/unit_test.h"
+#include "ce/graphics/buffer_arena.h"
+#include "ce/graphics/gpu_resource_registry.h"
+#include "ce/graphics/texture_streamer.h"
+#include "ce/texture/block_compression.h"
+#include "ce/texture/texture_file.h"
+#include "ce/graphics/renderer/indirect_draw_list.h"
+#include "ce/graphics/renderer/static_batcher.h"
+#include "ce/graphics/renderer/oit_math.h"
+#include "ce/component/component3D.h"
+#include "ce/component/visual_mesh.h"
+#include "ce/materials/material.h"
+#include "ce/materials/material_atlas.h"
+#include "ce/texture/mip_chain.h"
+#include "ce/geometry/vertex.h"
+#include <map>
+#include <set>
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+using namespace CrossEngine;
+
+namespace
+{
+    // Only tells the batches apart.
+    class MockMaterial : public AMaterial
+    {
+    public:
+        virtual void SetUniform(Window*) const override {}
+    };
+
+    // A mesh without triangles, batched by its transform and material only.
+    class MockMesh : public VisualMesh
+    {
+    private:
+        std::vector<Triangle*> triangles;
+    public:
+        virtual size_t GetVertexCount() const override { return 0; }
+        virtual void LoadTriangles(std::vector<Triangle*>&&) override {}
+        virtual void LoadTriangles(const std::string&) override {}
+        virtual void LoadTrisWithNormal(const std::string&) override {}
+        virtual const std::vector<Triangle*>& GetTriangles() override { return triangles; }
+    };
+
+    // Keeps the buffers in memory instead of calling OpenGL.
+    class MockBufferBackend : public IBufferBackend
+    {
+    public:
+        std::map<unsigned int, std::vector<unsigned char>> buffers;
+        unsigned int next_buffer = 1;
+        size_t copy_count = 0;
+        std::set<void*> fences;
+        bool is_fence_signaled = false;
+        size_t next_fence = 1;
+
+        virtual unsigned int CreateBuffer(size_t p_size) override
+        {
+            buffers[next_buffer].resize(p_size);
+            return next_buffer++;
+        }
+
+        virtual void DeleteBuffer(unsigned int p_buffer) override
+        {
+            buffers.erase(p_buffer);
+        }
+
+        virtual void UploadBuffer(unsigned int p_buffer, size_t p_offset, size_t p_size, const void* p_data) override
+        {
+            std::memcpy(buffers.at(p_buffer).data() + p_offset, p_data, p_size);
+        }
+
+        virtual void CopyBuffer(unsigned int p_buffer, size_t p_src_offset, size_t p_dst_offset, size_t p_size) override
+        {
+            auto& buffer = buffers.at(p_buffer);
+            std::memcpy(buffer.data() + p_dst_offset, buffer.data() + p_src_offset, p_size);
+            ++copy_count;
+        }
+
+        virtual void Flush() override {}
+
+        virtual void* CreateFence() override
+        {
+            void* fence = reinterpret_cast<void*>(next_fence++);
+            fences.insert(fence);
+            return fence;
+        }
+
+        virtual bool IsFenceSignaled(void* p_fence) override
+        {
+            return fences.contains(p_fence) && is_fence_signaled;
+        }
+
+        virtual void DeleteFence(void* p_fence) override
+        {
+            fences.erase(p_fence);
+        }
+    };
+
+}
+
+void UnitTest::TestBufferArena0()
+{
+    auto backend = new MockBufferBackend();
+    {
+        // The arena owns the backend.
+        BufferArena arena(std::unique_ptr<IBufferBackend>(backend), 1024, 16);
+        int context;
+
+        auto a = arena.Allocate(256);
+        auto b = arena.Allocate(256);
+        auto c = arena.Allocate(256);
+        EXPECT_VALUES_EQUAL(arena.GetPageCount(), (size_t)1);
+        EXPECT_VALUES_EQUAL(arena.GetBuffer(a), arena.GetBuffer(c));
+
+        // Ranges larger than a page get a buffer of their own.
+        auto large = arena.Allocate(4096);
+        EXPECT_VALUES_EQUAL(arena.GetPageCount(), (size_t)2);
+        CHECK_EXPECT(arena.GetBuffer(large) != arena.GetBuffer(a), "The large range should be in a new buffer.");
+
+        unsigned char data[256];
+        for (size_t i = 0; i < 256; ++i)
+            data[i] = (unsigned char)i;
+        arena.Upload(c, data, 256);
+        EXPECT_EXPRESSION_THROW_TYPE(([&](){ arena.Upload(c, data, 512); }), std::out_of_range);
+
+        // The freed range is not reused until every context has finished a frame.
+        arena.EndFrame(&context);
+        arena.Free(a);
+        arena.Free(b);
+        size_t free_size = arena.GetFreeSize();
+        arena.EndFrame(&context);
+        EXPECT_VALUES_EQUAL(arena.GetFreeSize(), free_size);
+        arena.EndFrame(&context);
+        EXPECT_VALUES_EQUAL(arena.GetFreeSize(), free_size + 512);
+
+        // The last range is not moved until its upload has completed.
+        size_t old_offset = arena.GetOffset(c);
+        EXPECT_VALUES_EQUAL(arena.Defragment(1024), (size_t)0);
+        EXPECT_VALUES_EQUAL(backend->copy_count, (size_t)0);
+
+        // The last range is moved to the front, and keeps its data. The new offset is only used once the
+        // copy has completed.
+        backend->is_fence_signaled = true;
+        EXPECT_VALUES_EQUAL(arena.Defragment(1024), (size_t)256);
+        EXPECT_VALUES_EQUAL(backend->copy_count, (size_t)1);
+        EXPECT_VALUES_EQUAL(arena.GetOffset(c), old_offset);
+        backend->is_fence_signaled = false;
+        EXPECT_VALUES_EQUAL(arena.Defragment(1024), (size_t)0);
+        EXPECT_VALUES_EQUAL(arena.GetOffset(c), old_offset);
+        backend->is_fence_signaled = true;
+        EXPECT_VALUES_EQUAL(arena.Defragment(1024), (size_t)0);
+        CHECK_EXPECT(arena.GetOffset(c) < old_offset, "The range should be moved to the front.");
+        CHECK_EXPECT(backend->fences.empty(), "The fence should be deleted.");
+        auto& buffer = backend->buffers.at(arena.GetBuffer(c));
+        CHECK_EXPECT(std::memcmp(buffer.data() + arena.GetOffset(c), data, 256) == 0, "The moved range should keep its data.");
+
+        // A range written while it is copied keeps its offset, and the copy is released.
+        backend->is_fence_signaled = false;
+        arena.EndFrame(&context);
+        arena.EndFrame(&context);
+        auto hole = arena.Allocate(256);
+        auto d = arena.Allocate(256);
+        arena.Free(hole);
+        arena.EndFrame(&context);
+        arena.EndFrame(&context);
+        size_t d_offset = arena.GetOffset(d);
+        free_size = arena.GetFreeSize();
+        EXPECT_VALUES_EQUAL(arena.Defragment(1024), (size_t)256);
+        arena.Upload(d, data, 256);
+        backend->is_fence_signaled = true;
+        EXPECT_VALUES_EQUAL(arena.Defragment(0), (size_t)0);
+        EXPECT_VALUES_EQUAL(arena.GetOffset(d), d_offset);
+        EXPECT_VALUES_EQUAL(arena.GetFreeSize(), free_size);
+        arena.Free(d);
+
+        arena.Free(c);
+        EXPECT_EXPRESSION_THROW_TYPE(([&](){ arena.Free(c); }), std::invalid_argument);
+        arena.Free(large);
+        arena.RemoveContext(&context);
+        EXPECT_VALUES_EQUAL(backend->buffers.size(), (size_t)2);
+        CHECK_EXPECT(backend->fences.empty(), "The upload fences should be deleted with their ranges.");
+    }
+
+    // A range goes to a buffer with a fitting free range, however many buffers there are.
+    {
+        auto pages_backend = new MockBufferBackend();
+        BufferArena arena(std::unique_ptr<IBufferBackend>(pages_backend), 1024, 16);
+        int context;
+        std::vector<BufferArena::Handle> handles;
+        for (size_t i = 0; i < 8; ++i)
+            handles.push_back(arena.Allocate(768));
+        EXPECT_VALUES_EQUAL(arena.GetPageCount(), (size_t)8);
+        arena.Allocate(256);
+        EXPECT_VALUES_EQUAL(arena.GetPageCount(), (size_t)8);
+        arena.Allocate(512);
+        EXPECT_VALUES_EQUAL(arena.GetPageCount(), (size_t)9);
+
+        unsigned int buffer = arena.GetBuffer(handles[3]);
+        arena.Free(handles[3]);
+        arena.EndFrame(&context);
+        arena.EndFrame(&context);
+        auto reused = arena.Allocate(768);
+        EXPECT_VALUES_EQUAL(arena.GetPageCount(), (size_t)9);
+        EXPECT_VALUES_EQUAL(arena.GetBuffer(reused), buffer);
+    }
+}
+
+namespace
+{
+    std::vector<unsigned int> released_resources;
+
+    void MockRelease(int p_count, const unsigned int* p_ids)
+    {
+        released_resources.insert(released_resources.end(), p_ids, p_ids + p_count);
+    }
+}
+
+void UnitTest::TestGPUResourceRegistry0()
+{
+    released_resources.clear();
+    GPUResourceRegistry registry;
+    auto a = registry.Register(1, MockRelease);
+    auto b = registry.Register(2, MockRelease);
+    auto c = registry.Register(3, MockRelease);
+    EXPECT_VALUES_EQUAL(a.GetId(), 1u);
+    EXPECT_VALUES_EQUAL(registry.GetResourceCount(), (size_t)3);
+    CHECK_EXPECT(!GPUResourceRegistry::Handle().IsValid(), "A default handle should be invalid.");
+
+    // Freeing only queues the resources.
+    registry.Free(b);
+    registry.Free(b);
+    registry.Free(GPUResourceRegistry::Handle());
+    EXPECT_VALUES_EQUAL(released_resources.size(), (size_t)0);
+    EXPECT_VALUES_EQUAL(registry.ReleaseFreed(), (size_t)1);
+    EXPECT_VALUES_EQUAL(released_resources.size(), (size_t)1);
+    EXPECT_VALUES_EQUAL(released_resources[0], 2u);
+
+    // A stale handle does not release the resource reusing its slot.
+    auto d = registry.Register(4, MockRelease);
+    registry.Free(b);
+    EXPECT_VALUES_EQUAL(registry.ReleaseFreed(), (size_t)0);
+    EXPECT_VALUES_EQUAL(registry.GetResourceCount(), (size_t)3);
+
+    registry.Free(a);
+    registry.ReleaseAll();
+    std::sort(released_resources.begin(), released_resources.end());
+    EXPECT_VALUES_EQUAL(released_resources.size(), (size_t)4);
+    EXPECT_VALUES_EQUAL(released_resources[3], d.GetId());
+    EXPECT_VALUES_EQUAL(registry.GetResourceCount(), (size_t)0);
+    (void)c;
+}
+
+void UnitTest::TestTextureStreamer0()
+{
+    // A 5x3 RGB texture, the box filter averages the area each pixel covers in the previous level.
+    std::vector<ubyte_t> pixels(5 * 3 * 3);
+    for (size_t i = 0; i < pixels.size(); ++i)
+        pixels[i] = (ubyte_t)(i * 5);
+    MipConfig box;
+    box.filter = MipFilter::BOX;
+    auto image = MipChain::Generate(pixels.data(), 5, 3, 3, box);
+    EXPECT_VALUES_EQUAL(MipChain::GetLevelCount(5, 3), (size_t)3);
+    EXPECT_VALUES_EQUAL(image.levels.size(), (size_t)3);
+    EXPECT_VALUES_EQUAL(image.levels[1].width, (size_t)2);
+    EXPECT_VALUES_EQUAL(image.levels[1].height, (size_t)1);
+    EXPECT_VALUES_EQUAL(image.levels[2].width, (size_t)1);
+    EXPECT_VALUES_EQUAL(image.GetSize(), (size_t)(45 + 6 + 3));
+    CHECK_EXPECT(std::memcmp(image.GetLevelData(0), pixels.data(), pixels.size()) == 0, "The first level should be the texture.");
+    // The red channel of the first 2.5 columns, weighted 0.4, 0.4 and 0.2, of the 3 rows.
+    EXPECT_VALUES_EQUAL((int)image.GetLevelData(1)[0], (int)(15 * (5 + 0.4 + 0.2 * 2)));
+    EXPECT_VALUES_EQUAL(MipChain::Generate(pixels.data(), 5, 3, 3, false).levels.size(), (size_t)1);
+
+    // The chunks go from the smallest level to the largest, each within the size of a pixel buffer.
+    auto large = MipChain::Generate(std::vector<ubyte_t>(64 * 64 * 4).data(), 64, 64, 4, true);
+    auto chunks = TextureStreamer::SplitLevels(large, 64 * 4 * 16);
+    EXPECT_VALUES_EQUAL(chunks.front().level, (size_t)6);
+    EXPECT_VALUES_EQUAL(chunks.back().level, (size_t)0);
+    std::vector<size_t> rows(large.levels.size(), 0);
+    for (size_t i = 0; i < chunks.size(); ++i)
+    {
+        if (i != 0)
+            CHECK_EXPECT(chunks[i].level <= chunks[i - 1].level, "The chunks should go from the smallest level.");
+        CHECK_EXPECT(chunks[i].row_count * large.levels[chunks[i].level].width * 4 <= 64 * 4 * 16, "A chunk should fit in a pixel buffer.");
+        EXPECT_VALUES_EQUAL(chunks[i].first_row, rows[chunks[i].level]);
+        rows[chunks[i].level] += chunks[i].row_count;
+    }
+    for (size_t i = 0; i < rows.size(); ++i)
+        EXPECT_VALUES_EQUAL(rows[i], large.levels[i].height);
+    EXPECT_VALUES_EQUAL(std::count_if(chunks.begin(), chunks.end(), [](auto& p_chunk) { return p_chunk.level == 0; }), (long)4);
+    // A row larger than a pixel buffer is still a chunk.
+    EXPECT_VALUES_EQUAL(TextureStreamer::SplitLevels(large, 1).size(), (size_t)(64 + 32 + 16 + 8 + 4 + 2 + 1));
+}
+
+void UnitTest::TestMipChain0()
+{
+    // A flat texture stays flat, the weights of the Kaiser filter add up to 1.
+    std::vector<ubyte_t> flat(37 * 23 * 4, 77);
+    auto image = MipChain::Generate(flat.data(), 37, 23, 4, true);
+    CHECK_EXPECT(std::all_of(image.pixels.get(), image.pixels.get() + image.GetSize(), [](ubyte_t p_value) { return p_value == 77; }),
+        "A flat texture should stay flat.");
+
+    // Black and white average to a middle gray in linear space, which is lighter in sRGB.
+    const ubyte_t black_white[] = {0, 255};
+    MipConfig config;
+    config.filter = MipFilter::BOX;
+    EXPECT_VALUES_EQUAL((int)MipChain::Generate(black_white, 2, 1, 1, config).GetLevelData(1)[0], 128);
+    config.content = TextureContent::SRGB;
+    EXPECT_VALUES_EQUAL((int)MipChain::Generate(black_white, 2, 1, 1, config).GetLevelData(1)[0], 188);
+    // The alpha is linear.
+    const ubyte_t transparent[] = {0, 0, 0, 0, 255, 255, 255, 255};
+    auto srgb = MipChain::Generate(transparent, 2, 1, 4, config);
+    EXPECT_VALUES_EQUAL((int)srgb.GetLevelData(1)[0], 188);
+    EXPECT_VALUES_EQUAL((int)srgb.GetLevelData(1)[3], 128);
+
+    // +X and +Z average to a normal halfway between them, not a shorter one.
+    const ubyte_t normals[] = {255, 128, 128, 128, 128, 255};
+    config.content = TextureContent::NORMAL;
+    auto normal = MipChain::Generate(normals, 2, 1, 3, config);
+    EXPECT_VALUES_EQUAL((int)normal.GetLevelData(1)[0], 218);
+    EXPECT_VALUES_EQUAL((int)normal.GetLevelData(1)[2], 218);
+    EXPECT_EXPRESSION_THROW_TYPE([&](){ MipChain::Generate(normals, 3, 1, 2, config); }, std::runtime_error);
+
+    // The levels are the same however many threads share the rows.
+    std::vector<ubyte_t> noise(96 * 80 * 3);
+    for (size_t i = 0; i < noise.size(); ++i)
+        noise[i] = (ubyte_t)(i * 7919 % 251);
+    config.content = TextureContent::SRGB;
+    config.filter = MipFilter::KAISER;
+    auto single = MipChain::Generate(noise.data(), 96, 80, 3, config);
+    config.thread_count = 4;
+    auto shared = MipChain::Generate(noise.data(), 96, 80, 3, config);
+    EXPECT_VALUES_EQUAL(shared.GetSize(), single.GetSize());
+    CHECK_EXPECT(std::memcmp(shared.pixels.get(), single.pixels.get(), single.GetSize()) == 0, "The levels should not depend on the threads.");
+}
+
+void UnitTest::TestBlockCompression0()
+{
+    EXPECT_VALUES_EQUAL(BlockCompression::GetCompressedSize(BlockFormat::BC1, 5, 3), (size_t)(2 * 1 * 8));
+    EXPECT_VALUES_EQUAL(BlockCompression::GetCompressedSize(BlockFormat::BC7, 8, 8), (size_t)(2 * 2 * 16));
+    EXPECT_VALUES_EQUAL(BlockCompression::GetCompressedSize(BlockFormat::NONE, 8, 8), (size_t)0);
+    CHECK_EXPECT(BlockCompression::ParseFormat("bc5") == BlockFormat::BC5, "The name should be parsed to its format.");
+    EXPECT_EXPRESSION_THROW_TYPE([](){ BlockCompression::ParseFormat("bc2"); }, std::runtime_error);
+
+    // A solid block is decoded to its color. The endpoints of BC7 mode 6 share a low bit across the channels,
+    // so red and black cannot both be exact.
+    ubyte_t solid[64];
+    for (size_t i = 0; i < 16; ++i)
+    {
+        solid[i * 4] = 255;
+        solid[i * 4 + 1] = 0;
+        solid[i * 4 + 2] = 0;
+        solid[i * 4 + 3] = 255;
+    }
+    for (auto format : {BlockFormat::BC1, BlockFormat::BC3, BlockFormat::BC7})
+    {
+        ubyte_t block[16];
+        ubyte_t decoded[64];
+        BlockCompression::EncodeBlock(format, solid, block);
+        BlockCompression::DecodeBlock(format, block, decoded);
+        int max_error = 0;
+        for (size_t i = 0; i < 64; ++i)
+            max_error = std::max(max_error, std::abs((int)decoded[i] - (int)solid[i]));
+        EXPECT_VALUES_EQUAL(max_error, format == BlockFormat::BC7 ? 1 : 0);
+    }
+    // Only mode 6 BC7 blocks are decoded.
+    ubyte_t mode_0[16] = {1};
+    ubyte_t decoded[64];
+    EXPECT_EXPRESSION_THROW_TYPE([&](){ BlockCompression::DecodeBlock(BlockFormat::BC7, mode_0, decoded); }, std::runtime_error);
+
+    // A smooth gradient stays close to the original pixels, in a texture that is not a multiple of the block
+    // width. The colors lie along a line, as the endpoints of a block are.
+    constexpr size_t WIDTH = 18;
+    constexpr size_t HEIGHT = 10;
+    std::vector<ubyte_t> pixels(WIDTH * HEIGHT * 4);
+    for (size_t y = 0; y < HEIGHT; ++y)
+        for (size_t x = 0; x < WIDTH; ++x)
+        {
+            ubyte_t* pixel = &pixels[(y * WIDTH + x) * 4];
+            size_t t = x * 2 + y * 3;
+            pixel[0] = (ubyte_t)(t * 3);
+            pixel[1] = (ubyte_t)(200 - t * 2);
+            pixel[2] = (ubyte_t)(64 + t);
+            pixel[3] = (ubyte_t)(255 - t * 4);
+        }
+    auto image = MipChain::Generate(pixels.data(), WIDTH, HEIGHT, 4, true);
+    for (auto format : {BlockFormat::BC1, BlockFormat::BC3, BlockFormat::BC5, BlockFormat::BC7})
+    {
+        auto compressed = BlockCompression::Compress(image, format, 3);
+        CHECK_EXPECT(compressed.format == format, "The levels should be compressed to the format.");
+        EXPECT_VALUES_EQUAL(compressed.levels.size(), image.levels.size());
+        EXPECT_VALUES_EQUAL(compressed.GetLevelSize(0), BlockCompression::GetCompressedSize(format, WIDTH, HEIGHT));
+        auto result = BlockCompression::Decompress(compressed);
+        size_t channels = BlockCompression::GetChannels(format);
+        EXPECT_VALUES_EQUAL(result.channels, channels);
+        // BC5 only keeps X and Y, BC1 has no alpha. The colors of BC1 and BC3 have 4 levels.
+        size_t compared = format == BlockFormat::BC5 ? 2 : std::min<size_t>(channels, 4);
+        int max_error = 0;
+        for (size_t i = 0; i < WIDTH * HEIGHT; ++i)
+            for (size_t c = 0; c < compared; ++c)
+                max_error = std::max(max_error, std::abs((int)result.GetLevelData(0)[i * channels + c] - (int)pixels[i * 4 + c]));
+        CHECK_EXPECT(max_error <= (format == BlockFormat::BC1 || format == BlockFormat::BC3 ? 10 : 4), "The decoded gradient should be close to the original.");
+    }
+    EXPECT_EXPRESSION_THROW_TYPE([&](){ BlockCompression::Decompress(image); }, std::runtime_error);
+
+    // A compressed level is split in rows of blocks.
+    auto compressed = BlockCompression::Compress(MipChain::Generate(std::vector<ubyte_t>(64 * 64 * 4).data(), 64, 64, 4, true), BlockFormat::BC7, 1);
+    for (auto& chunk : TextureStreamer::SplitLevels(compressed, 16 * 16 * 4))
+    {
+        EXPECT_VALUES_EQUAL(chunk.first_row % 4, (size_t)0);
+        CHECK_EXPECT(chunk.row_count % 4 == 0 || chunk.first_row + chunk.row_count >= compressed.levels[chunk.level].height,
+            "A chunk should hold whole rows of blocks.");
+    }
+
+    // The texture file holds the levels as they are.
+    auto path = (std::filesystem::temp_directory_path() / "ce_test_texture.cetex").string();
+    auto bc3 = BlockCompression::Compress(image, BlockFormat::BC3, 2);
+    TextureFile::Write(path, bc3);
+    CHECK_EXPECT(TextureFile::IsTextureFile(path), "The path should be a texture file.");
+    auto read = TextureFile::Read(path);
+    CHECK_EXPECT(read.format == BlockFormat::BC3, "The format should be read as it is written.");
+    EXPECT_VALUES_EQUAL(read.levels.size(), bc3.levels.size());
+    EXPECT_VALUES_EQUAL(read.levels[0].width, WIDTH);
+    EXPECT_VALUES_EQUAL(read.GetSize(), bc3.GetSize());
+    CHECK_EXPECT(std::memcmp(read.pixels.get(), bc3.pixels.get(), bc3.GetSize()) == 0, "The levels should be read as they are written.");
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file << "CETX";
+    }
+    EXPECT_EXPRESSION_THROW_TYPE([&](){ TextureFile::Read(path); }, std::runtime_error);
+    std::filesystem::remove(path);
+}
+
+void UnitTest::TestIndirectDrawList0()
+{
+    std::vector<std::shared_ptr<Component3D>> components;
+    auto make_instances = [&components](size_t p_count) {
+        std::vector<const Component3D*> result;
+        for (size_t i = 0; i < p_count; ++i)
+        {
+            components.push_back(std::make_shared<Component3D>());
+            components.back()->Position() = Math::Pos((float)components.size(), 0.0f, 0.0f);
+            result.push_back(components.back().get());
+        }
+        return result;
+    };
+
+    // A bucket of a material and a vertex buffer: one command per mesh data, the instances of each command
+    // following the ones of the previous commands.
+    auto first_mesh = make_instances(3);
+    auto second_mesh = make_instances(2);
+    IndirectDrawList bucket;
+    bucket.AddDraw(0, 36, first_mesh);
+    bucket.AddDraw(36, 6, second_mesh);
+    bucket.Build();
+    const auto& commands = bucket.GetCommands();
+    EXPECT_VALUES_EQUAL(commands.size(), (size_t)2);
+    EXPECT_VALUES_EQUAL(commands[0].first, (uint32_t)0);
+    EXPECT_VALUES_EQUAL(commands[0].count, (uint32_t)36);
+    EXPECT_VALUES_EQUAL(commands[0].instance_count, (uint32_t)3);
+    EXPECT_VALUES_EQUAL(commands[0].base_instance, (uint32_t)0);
+    EXPECT_VALUES_EQUAL(commands[1].first, (uint32_t)36);
+    EXPECT_VALUES_EQUAL(commands[1].count, (uint32_t)6);
+    EXPECT_VALUES_EQUAL(commands[1].instance_count, (uint32_t)2);
+    EXPECT_VALUES_EQUAL(commands[1].base_instance, (uint32_t)3);
+    EXPECT_VALUES_EQUAL(bucket.GetInstanceCount(), (size_t)5);
+    // The matrices are column by column, the translation is the last column.
+    const auto& matrices = bucket.GetMatrices();
+    EXPECT_VALUES_EQUAL(matrices.size(), (size_t)5 * 16);
+    EXPECT_VALUES_EQUAL(matrices[(commands[1].base_instance + 1) * 16 + 12], 5.0f);
+    EXPECT_VALUES_EQUAL(matrices[(commands[1].base_instance + 1) * 16 + 15], 1.0f);
+
+    // Another bucket starts its base instances from 0.
+    IndirectDrawList other_bucket;
+    other_bucket.AddDraw(100, 3, make_instances(1));
+    other_bucket.Build();
+    EXPECT_VALUES_EQUAL(other_bucket.GetCommands()[0].base_instance, (uint32_t)0);
+    EXPECT_VALUES_EQUAL(other_bucket.GetMatrices()[12], 6.0f);
+
+    // The buckets are reused every frame.
+    bucket.Clear();
+    EXPECT_VALUES_EQUAL(bucket.GetCommands().size(), (size_t)0);
+    EXPECT_VALUES_EQUAL(bucket.GetInstanceCount(), (size_t)0);
+
+    // A bucket larger than a chunk is filled by the workers.
+    auto many = make_instances(IndirectDrawList::FILL_CHUNK_SIZE * 3 + 7);
+    bucket.AddDraw(0, 3, many);
+    bucket.AddDraw(3, 3, first_mesh);
+    bucket.Build();
+    EXPECT_VALUES_EQUAL(bucket.GetCommands()[1].base_instance, (uint32_t)many.size());
+    bool is_filled = true;
+    for (size_t i = 0; i < many.size(); ++i)
+        is_filled = is_filled && bucket.GetMatrices()[i * 16 + 12] == many[i]->GetPosition()[0];
+    CHECK_EXPECT(is_filled, "Every matrix should be filled.");
+    EXPECT_VALUES_EQUAL(bucket.GetMatrices()[(many.size() + 2) * 16 + 12], 3.0f);
+}
+
+void UnitTest::TestStaticBatcher0()
+{
+    // The meshes of a chunk with the same material share a batch, negative coordinates round down.
+    auto first_material = std::make_shared<MockMaterial>();
+    auto second_material = std::make_shared<MockMaterial>();
+    auto origin_key = StaticBatcher::GetBatchKey(Math::Pos(1.0f, 2.0f, 3.0f), 32.0f, first_material.get());
+    CHECK_EXPECT(origin_key == StaticBatcher::GetBatchKey(Math::Pos(31.0f, 0.0f, 0.5f), 32.0f, first_material.get()),
+        "Meshes in the same chunk should share a batch.");
+    CHECK_EXPECT(origin_key != StaticBatcher::GetBatchKey(Math::Pos(1.0f, 2.0f, 3.0f), 32.0f, second_material.get()),
+        "Meshes with different materials should not share a batch.");
+    CHECK_EXPECT(StaticBatcher::GetBatchKey(Math::Pos(-0.5f, 0.0f, 33.0f), 32.0f, nullptr) ==
+        StaticBatcher::BatchKey(-1, 0, 1, nullptr), "The chunk coordinates should round down.");
+
+    auto root = std::make_shared<Component3D>();
+    std::vector<std::shared_ptr<MockMesh>> meshes;
+    auto make_mesh = [&](const Math::Vec4& p_position, const std::shared_ptr<AMaterial>& p_material) {
+        meshes.push_back(std::make_shared<MockMesh>());
+        meshes.back()->Position() = p_position;
+        meshes.back()->SetMaterial(p_material);
+        root->AddChild(meshes.back());
+        return meshes.back().get();
+    };
+    auto a = make_mesh(Math::Pos(1.0f, 0.0f, 0.0f), first_material);
+    auto b = make_mesh(Math::Pos(5.0f, 0.0f, 0.0f), first_material);
+    auto c = make_mesh(Math::Pos(40.0f, 0.0f, 0.0f), first_material);
+    auto d = make_mesh(Math::Pos(1.0f, 0.0f, 0.0f), second_material);
+    StaticBatcher batcher;
+    for (auto mesh : { a, b, c, d })
+        batcher.AddMesh(mesh);
+    batcher.EndFrame();
+    EXPECT_VALUES_EQUAL(batcher.GetBatchCount(), (size_t)3);
+    EXPECT_VALUES_EQUAL(batcher.GetBatchMeshCount({0, 0, 0, first_material.get()}), (size_t)2);
+    EXPECT_VALUES_EQUAL(batcher.GetBatchMeshCount({1, 0, 0, first_material.get()}), (size_t)1);
+    EXPECT_VALUES_EQUAL(batcher.GetBatchMeshCount({0, 0, 0, second_material.get()}), (size_t)1);
+
+    // A moved mesh and a mesh with a new material move to the batches of their new keys.
+    b->Position() = Math::Pos(70.0f, 0.0f, 0.0f);
+    d->SetMaterial(first_material);
+    for (auto mesh : { a, b, c, d })
+        batcher.AddMesh(mesh);
+    batcher.EndFrame();
+    EXPECT_VALUES_EQUAL(batcher.GetBatchMeshCount({0, 0, 0, first_material.get()}), (size_t)2);
+    EXPECT_VALUES_EQUAL(batcher.GetBatchMeshCount({2, 0, 0, first_material.get()}), (size_t)1);
+    EXPECT_VALUES_EQUAL(batcher.GetBatchMeshCount({0, 0, 0, second_material.get()}), (size_t)0);
+
+    // Moving an ancestor moves the meshes too.
+    root->Position() = Math::Pos(0.0f, 64.0f, 0.0f);
+    for (auto mesh : { a, b, c, d })
+        batcher.AddMesh(mesh);
+    batcher.EndFrame();
+    EXPECT_VALUES_EQUAL(batcher.GetBatchMeshCount({0, 2, 0, first_material.get()}), (size_t)2);
+    EXPECT_VALUES_EQUAL(batcher.GetBatchMeshCount({0, 0, 0, first_material.get()}), (size_t)0);
+
+    // The vertices are moved to world space, the normals by the inverse transpose of the world matrix.
+    Math::Mat4 model = {
+        2.0f, 0.0f, 0.0f, 10.0f,
+        0.0f, 1.0f, 0.0f, 0.0f,
+        0.0f, 0.0f, 1.0f, 0.0f,
+        0.0f, 0.0f, 0.0f, 1.0f
+    };
+    Math::Mat4 model_inverse = {
+        0.5f, 0.0f, 0.0f, -5.0f,
+        0.0f, 1.0f, 0.0f, 0.0f,
+        0.0f, 0.0f, 1.0f, 0.0f,
+        0.0f, 0.0f, 0.0f, 1.0f
+    };
+    float vertex[Vertex::ARRAY_SIZE] = {};
+    vertex[0] = 1.0f;
+    vertex[1] = 1.0f;
+    vertex[3] = 1.0f;
+    vertex[4] = 1.0f;
+    vertex[8] = 1.0f;
+    float bounds_min[3] = { 100.0f, 100.0f, 100.0f };
+    float bounds_max[3] = { -100.0f, -100.0f, -100.0f };
+    StaticBatcher::TransformVertices(vertex, 1, model, model_inverse, bounds_min, bounds_max);
+    EXPECT_VALUES_EQUAL(vertex[0], 12.0f);
+    EXPECT_VALUES_EQUAL(vertex[1], 1.0f);
+    EXPECT_VALUES_EQUAL(vertex[2], 0.0f);
+    EXPECT_VALUES_EQUAL(vertex[3], 0.5f);
+    EXPECT_VALUES_EQUAL(vertex[4], 1.0f);
+    EXPECT_VALUES_EQUAL(vertex[8], 2.0f);
+    EXPECT_VALUES_EQUAL(bounds_min[0], 12.0f);
+    EXPECT_VALUES_EQUAL(bounds_max[1], 1.0f);
+}
+
+void UnitTest::TestOITPass0()
+{
+    // Nearer and more opaque fragments weigh more until the weight is clamped.
+    CHECK_EXPECT(OITMath::GetWeight(0.01f, 0.85f) > OITMath::GetWeight(0.01f, 0.95f), "Nearer fragments should weigh more.");
+    CHECK_EXPECT(OITMath::GetWeight(0.01f, 0.95f) > OITMath::GetWeight(0.005f, 0.95f), "More opaque fragments should weigh more.");
+    EXPECT_VALUES_EQUAL(OITMath::GetWeight(1.0f, 0.0f), 3e3f);
+    EXPECT_VALUES_EQUAL(OITMath::GetWeight(0.5f, 0.99f), 3e3f);
+    CHECK_EXPECT(OITMath::GetWeight(0.0f, 1.0f) >= 1e-2f, "The weight should not be below the minimum.");
+    // The shaders are compiled with the same constants.
+    auto defines = OITMath::GetShaderDefines();
+    CHECK_EXPECT(defines.find("#define OIT_WEIGHT_MAX 3e+03\n") != std::string::npos, "The shaders should share the maximum weight.");
+    CHECK_EXPECT(defines.find("#define OIT_WEIGHT_DEPTH_SCALE 9e-01\n") != std::string::npos, "The shaders should share the depth scale.");
+
+    auto is_near = [](const Math::Vec4& p_a, const Math::Vec4& p_b) {
+        for (size_t i = 0; i < 4; ++i)
+        {
+            if (std::abs(p_a[i] - p_b[i]) > 1e-4f)
+                return false;
+        }
+        return true;
+    };
+    Math::Vec4 opaque(0.2f, 0.4f, 0.6f, 1.0f);
+
+    // Without transparent fragments the opaque color is kept.
+    EXPECT_VALUES_EQUAL(OITMath::ResolvePixel(opaque, Math::Vec4(0.0f, 0.0f, 0.0f, 0.0f), Math::Vec4(0.0f, 0.0f, 0.0f, 1.0f)), opaque);
+
+    // A single fragment is blended over the opaque color.
+    Math::Vec4 red(1.0f, 0.0f, 0.0f, 0.25f);
+    Math::Vec4 accumulation(0.0f, 0.0f, 0.0f, 0.0f);
+    Math::Vec4 revealage(0.0f, 0.0f, 0.0f, 1.0f);
+    OITMath::BlendFragment(red, 0.5f, accumulation, revealage);
+    EXPECT_VALUES_EQUAL(revealage[3], 0.75f);
+    CHECK_EXPECT(is_near(OITMath::ResolvePixel(opaque, accumulation, revealage), Math::Vec4(0.4f, 0.3f, 0.45f, 1.0f)),
+        "A single fragment should be blended over the opaque color.");
+
+    // The result does not depend on the order of the fragments.
+    Math::Vec4 blue(0.0f, 0.0f, 1.0f, 0.5f);
+    Math::Vec4 accumulation_a(0.0f, 0.0f, 0.0f, 0.0f), revealage_a(0.0f, 0.0f, 0.0f, 1.0f);
+    OITMath::BlendFragment(red, 0.3f, accumulation_a, revealage_a);
+    OITMath::BlendFragment(blue, 0.6f, accumulation_a, revealage_a);
+    Math::Vec4 accumulation_b(0.0f, 0.0f, 0.0f, 0.0f), revealage_b(0.0f, 0.0f, 0.0f, 1.0f);
+    OITMath::BlendFragment(blue, 0.6f, accumulation_b, revealage_b);
+    OITMath::BlendFragment(red, 0.3f, accumulation_b, revealage_b);
+    auto resolved = OITMath::ResolvePixel(opaque, accumulation_a, revealage_a);
+    CHECK_EXPECT(is_near(resolved, OITMath::ResolvePixel(opaque, accumulation_b, revealage_b)),
+        "The result should not depend on the order of the fragments.");
+    // The opaque color is revealed by the product of (1 - alpha). Both weights are clamped to the maximum, so
+    // the transparent color is the average of the colors weighted by their alphas.
+    EXPECT_VALUES_EQUAL(revealage_a[3], 0.375f);
+    CHECK_EXPECT(is_near(resolved, Math::Vec4(0.625f / 3.0f + 0.2f * 0.375f, 0.4f * 0.375f, 1.25f / 3.0f + 0.6f * 0.375f, 1.0f)),
+        "The transparent color should cover (1 - revealage) of the pixel.");
+}
+
+void UnitTest::TestMaterialAtlas0()
+{
+    EXPECT_EXPRESSION_THROW_TYPE([](){ MaterialAtlas atlas(30, 1, 3); }, std::invalid_argument);
+
+    // 3 levels, the packed textures are aligned to and padded by 4 pixels.
+    MaterialAtlas atlas(64, 2, 3);
+    std::vector<ubyte_t> pixels(8 * 8 * 4);
+    for (size_t y = 0; y < 8; ++y)
+    {
+        for (size_t x = 0; x < 8; ++x)
+        {
+            ubyte_t* pixel = pixels.data() + (y * 8 + x) * 4;
+            pixel[0] = (ubyte_t)(x * 16);
+            pixel[1] = (ubyte_t)(y * 16);
+            pixel[2] = 7;
+            pixel[3] = 255;
+        }
+    }
+    auto image = MipChain::Generate(pixels.data(), 8, 8, 4, true);
+    MaterialTextures textures;
+    textures.albedo = &image;
+    auto first = atlas.Add(textures);
+    EXPECT_VALUES_EQUAL(first.layer, (size_t)0);
+    EXPECT_VALUES_EQUAL(first.uv_transform[0], 8.0f / 64.0f);
+    EXPECT_VALUES_EQUAL(first.uv_transform[1], 8.0f / 64.0f);
+    size_t x = (size_t)(first.uv_transform[2] * 64.0f);
+    size_t y = (size_t)(first.uv_transform[3] * 64.0f);
+    CHECK_EXPECT(x % 4 == 0 && y % 4 == 0 && x >= 4 && y >= 4, "The texture should be aligned to a cell, after the padding.");
+    // A write for each level of each kind of texture.
+    for (size_t i = 0; i < MaterialAtlas::TEXTURE_COUNT; ++i)
+        EXPECT_VALUES_EQUAL(atlas.GetArray(i)->GetPendingWriteCount(), (size_t)3);
+
+    auto albedo_pixel = [&](size_t p_level, size_t p_x, size_t p_y) {
+        return atlas.GetArray(0)->GetPendingPixel(first.layer, p_level, p_x, p_y).value_or(std::array<ubyte_t, 4>{});
+    };
+    auto source_pixel = [&](size_t p_level, size_t p_x, size_t p_y) {
+        const ubyte_t* pixel = image.GetLevelData(p_level) + (p_y * image.levels[p_level].width + p_x) * 4;
+        return std::array<ubyte_t, 4>{pixel[0], pixel[1], pixel[2], pixel[3]};
+    };
+    CHECK_EXPECT(albedo_pixel(0, x + 2, y + 5) == source_pixel(0, 2, 5), "The texture should be copied to its rectangle.");
+    // The padding repeats the edge pixels.
+    CHECK_EXPECT(albedo_pixel(0, x - 4, y - 4) == source_pixel(0, 0, 0), "The corner of the padding should repeat the corner.");
+    CHECK_EXPECT(albedo_pixel(0, x - 1, y + 3) == source_pixel(0, 0, 3), "The padding should repeat the left edge.");
+    CHECK_EXPECT(albedo_pixel(0, x + 11, y + 7) == source_pixel(0, 7, 7), "The padding should repeat the right edge.");
+    CHECK_EXPECT(!atlas.GetArray(0)->GetPendingPixel(first.layer, 0, x + 12, y).has_value(), "The padding should end after 4 pixels.");
+    // The padding of the smaller levels shrinks with them, down to a pixel at the smallest level.
+    CHECK_EXPECT(albedo_pixel(2, (x >> 2) - 1, (y >> 2) - 1) == source_pixel(2, 0, 0), "The smallest level should be padded by a pixel.");
+    CHECK_EXPECT(albedo_pixel(2, (x >> 2) + 2, (y >> 2) + 1) == source_pixel(2, 1, 1), "The smallest level should be padded by a pixel.");
+    // A missing texture is filled with the default value.
+    auto normal = atlas.GetArray(1)->GetPendingPixel(first.layer, 0, x, y);
+    CHECK_EXPECT(normal.has_value() && *normal == (std::array<ubyte_t, 4>{128, 128, 255, 255}), "A missing normal should be flat.");
+
+    // The padded rectangles do not overlap.
+    auto second = atlas.Add(textures);
+    size_t second_x = (size_t)(second.uv_transform[2] * 64.0f);
+    size_t second_y = (size_t)(second.uv_transform[3] * 64.0f);
+    CHECK_EXPECT(second.layer != first.layer || second_x >= x + 16 || x >= second_x + 16 || second_y >= y + 16 || y >= second_y + 16,
+        "The padded rectangles should not overlap.");
+
+    // A texture as large as a layer takes a whole layer without padding.
+    std::vector<ubyte_t> page_pixels(64 * 64 * 4, 255);
+    auto page_image = MipChain::Generate(page_pixels.data(), 64, 64, 4, true);
+    MaterialTextures page_textures;
+    page_textures.albedo = &page_image;
+    auto page = atlas.Add(page_textures);
+    EXPECT_VALUES_EQUAL(page.layer, (size_t)1);
+    EXPECT_VALUES_EQUAL(page.uv_transform, Math::Vec4(1.0f, 1.0f, 0.0f, 0.0f));
+    EXPECT_EXPRESSION_THROW_TYPE([&](){ atlas.Add(page_textures); }, std::runtime_error);
+
+    auto large_image = MipChain::Generate(std::vector<ubyte_t>(128 * 128 * 4).data(), 128, 128, 4, false);
+    MaterialTextures large_textures;
+    large_textures.albedo = &large_image;
+    EXPECT_EXPRESSION_THROW_TYPE([&](){ atlas.Add(large_textures); }, std::invalid_argument);
+    MaterialTextures mixed_textures;
+    mixed_textures.albedo = &image;
+    mixed_textures.normal = &page_image;
+    EXPECT_EXPRESSION_THROW_TYPE([&](){ atlas.Add(mixed_textures); }, std::invalid_argument);
+}
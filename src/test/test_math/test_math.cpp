@@ -252,6 +252,14 @@ void UnitTest::TestMatrix3()
             -20, -24, -28, -32
         }))
     );
+
+    EXPECT_EXPRESSION_THROW_TYPE(([&](){ Inverse(mat2); }), std::domain_error);
+    Mat4 transform = Trans(1.0f, -2.0f, 3.0f) * Yaw(0.5f) * Scale(2.0f, 4.0f, 0.5f);
+    auto vector = Inverse(transform) * (transform * Vec4(1.0f, 2.0f, 3.0f, 1.0f));
+    EXPECT_VALUES_EQUAL(vector[0], 1.0f);
+    EXPECT_VALUES_EQUAL(vector[1], 2.0f);
+    EXPECT_VALUES_EQUAL(vector[2], 3.0f);
+    EXPECT_VALUES_EQUAL(vector[3], 1.0f);
 }
 
 void UnitTest::TestTransformation0()
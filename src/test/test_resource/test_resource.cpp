@@ -0,0 +1,399 @@
+#include "../unit_test/unit_test.h"
+#include "ce/resource/resource.h"
+#include "ce/resource/model_parser.h"
+#include "ce/resource/mapped_file.h"
+#include "ce/resource/mesh_cache.h"
+#include "ce/resource/gltf.h"
+#include "ce/resource/resource_loader.h"
+#include "ce/resource/resource_cache.hpp"
+#include "ce/resource/pack_file.h"
+#include "ce/resource/virtual_file_system.h"
+#include "ce/geometry/geometry_arena.h"
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <string>
+
+using namespace CrossEngine;
+
+namespace
+{
+    void WriteGlb(const std::string& p_path, std::string p_json, std::string p_binary)
+    {
+        p_json.resize((p_json.size() + 3) / 4 * 4, ' ');
+        p_binary.resize((p_binary.size() + 3) / 4 * 4, '\0');
+        auto write_uint = [](std::ofstream& p_file, uint32_t p_value) { p_file.write(reinterpret_cast<const char*>(&p_value), sizeof(uint32_t)); };
+        std::ofstream file(p_path, std::ios::binary);
+        write_uint(file, GltfAsset::MAGIC);
+        write_uint(file, 2);
+        write_uint(file, (uint32_t)(12 + 8 + p_json.size() + 8 + p_binary.size()));
+        write_uint(file, (uint32_t)p_json.size());
+        write_uint(file, 0x4E4F534A);
+        file << p_json;
+        write_uint(file, (uint32_t)p_binary.size());
+        write_uint(file, 0x004E4942);
+        file << p_binary;
+    }
+}
+
+void UnitTest::TestModelParser0()
+{
+    GeometryArena arena;
+    std::vector<Triangle*> triangles;
+    ModelParser::ParseTris("2\n0 0 0 1 0 0 0 1 0\n1 2 3 4 5 6 7 8 9\n", triangles, &arena);
+    EXPECT_VALUES_EQUAL(triangles.size(), (size_t)2);
+    EXPECT_VALUES_EQUAL(triangles[1]->GetVertex(2)->GetPosition(), Math::Pos(7.0f, 8.0f, 9.0f));
+    EXPECT_VALUES_EQUAL(triangles[0]->GetVertex(0)->GetNormal(), Math::Vec4(0.0f, 0.0f, 1.0f, 0.0f));
+    EXPECT_EXPRESSION_THROW_TYPE([&](){ ModelParser::ParseTris("2\n0 0 0 1 0 0 0 1 0\n", triangles, &arena); }, std::runtime_error);
+
+    // Numbers out of the range of a float are clamped, and numbers too small are flushed to 0.
+    triangles.clear();
+    ModelParser::ParseTris("1\n1e-50 -1e50 3.4e39 1 0 0 0 1 0\n", triangles, &arena);
+    EXPECT_VALUES_EQUAL(triangles[0]->GetVertex(0)->GetPosition(),
+        Math::Pos(0.0f, -std::numeric_limits<float>::max(), std::numeric_limits<float>::max()));
+
+    triangles.clear();
+    ModelParser::ParseTrisWithNormal("1\n0 0 0 0 1 0  1 0 0 0 1 0  0 1 0 0 1 0\r\n", triangles, &arena);
+    EXPECT_VALUES_EQUAL(triangles.size(), (size_t)1);
+    EXPECT_VALUES_EQUAL(triangles[0]->GetVertex(1)->GetPosition(), Math::Pos(1.0f, 0.0f, 0.0f));
+    EXPECT_VALUES_EQUAL(triangles[0]->GetVertex(1)->GetNormal(), Math::Vec4(0.0f, 1.0f, 0.0f, 0.0f));
+
+    // Faces with every index form, negative indices and comments.
+    triangles.clear();
+    ModelParser::ParseObj(
+        "# a quad\n"
+        "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\n"
+        "vt 0.5 0.25\n"
+        "vn 0 0 -1\n"
+        "f 1/1/1 2/1/1 3/1/1\n"
+        "f 1//1 3//1 4//1\n"
+        "f -4 -2 -1\n"
+        "f 1 2 3 4\n", triangles, &arena);
+    CHECK_EXPECT(triangles.size() >= 5, "The quad should be triangulated.");
+    EXPECT_VALUES_EQUAL(triangles[0]->GetVertex(1)->GetPosition(), Math::Pos(1.0f, 0.0f, 0.0f));
+    EXPECT_VALUES_EQUAL(triangles[0]->GetVertex(1)->GetUV(), Math::Vec2(0.5f, 0.25f));
+    EXPECT_VALUES_EQUAL(triangles[1]->GetVertex(2)->GetNormal(), Math::Vec4(0.0f, 0.0f, -1.0f, 0.0f));
+    EXPECT_VALUES_EQUAL(triangles[2]->GetVertex(1)->GetPosition(), Math::Pos(1.0f, 1.0f, 0.0f));
+    EXPECT_VALUES_EQUAL(triangles[2]->GetVertex(0)->GetNormal(), Math::Vec4(0.0f, 0.0f, 1.0f, 0.0f));
+    EXPECT_EXPRESSION_THROW_TYPE([&](){ ModelParser::ParseObj("v 0 0 0\nf 1 2 3\n", triangles, &arena); }, std::runtime_error);
+    EXPECT_EXPRESSION_THROW_TYPE([&](){ ModelParser::ParseObj("v 0 0 0\nf 1 1\n", triangles, &arena); }, std::runtime_error);
+    EXPECT_EXPRESSION_THROW_TYPE([&](){ ModelParser::ParseObj("v 0 0 0\nf 1 1 99999999999\n", triangles, &arena); }, std::runtime_error);
+    // Index 0 is invalid even when elements are defined after the face.
+    EXPECT_EXPRESSION_THROW_TYPE([&](){ ModelParser::ParseObj("v 0 0 0\nf 1 0 1\nv 1 0 0\n", triangles, &arena); }, std::runtime_error);
+
+    // A file large enough to be parsed in chunks, the faces reference the vertices of the other chunks.
+    std::string text;
+    constexpr size_t VERTEX_COUNT = 100000;
+    for (size_t i = 0; i < VERTEX_COUNT; ++i)
+        text += "v " + std::to_string(i) + " 0.5 -1.25\n";
+    for (size_t i = 0; i + 2 < VERTEX_COUNT; i += 3)
+        text += "f " + std::to_string(VERTEX_COUNT - i) + " " + std::to_string(i + 2) + " " + std::to_string(i + 3) + "\n";
+    CHECK_EXPECT(text.size() > 2 * ModelParser::MIN_CHUNK_SIZE, "The text should be split into chunks.");
+    triangles.clear();
+    GeometryArena large_arena;
+    ModelParser::ParseObj(text, triangles, &large_arena);
+    EXPECT_VALUES_EQUAL(triangles.size(), VERTEX_COUNT / 3);
+    bool is_ordered = true;
+    for (size_t i = 0; i < triangles.size(); ++i)
+    {
+        is_ordered = is_ordered && triangles[i]->GetVertex(0)->GetPosition() == Math::Pos((real_t)(VERTEX_COUNT - 1 - i * 3), 0.5f, -1.25f)
+            && triangles[i]->GetVertex(2)->GetPosition() == Math::Pos((real_t)(i * 3 + 2), 0.5f, -1.25f);
+    }
+    CHECK_EXPECT(is_ordered, "The triangles should be in the order of the file.");
+
+    auto path = std::filesystem::temp_directory_path() / "ce_test_model_parser.obj";
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << text;
+    }
+    {
+        MappedFile file(path.string());
+        EXPECT_VALUES_EQUAL(file.GetSize(), text.size());
+        CHECK_EXPECT(file.GetText() == text, "The mapped file should hold the content of the file.");
+    }
+    std::filesystem::remove(path);
+    EXPECT_EXPRESSION_THROW_TYPE([&](){ MappedFile file(path.string()); }, std::runtime_error);
+}
+
+void UnitTest::TestMeshCache0()
+{
+    auto directory = std::filesystem::temp_directory_path();
+    std::string source_path = (directory / "ce_test_mesh_cache.tris").string();
+    std::string cache_path = MeshCache::GetCachePath(source_path);
+    std::filesystem::remove(cache_path);
+    {
+        std::ofstream file(source_path, std::ios::binary);
+        file << "2\n0 0 0 1 0 0 0 1 0\n1 2 3 4 5 6 7 8 -9\n";
+    }
+    CHECK_EXPECT(MeshCache::Open(source_path) == nullptr, "A missing cache should not be opened.");
+
+    GeometryArena arena;
+    std::vector<std::vector<Triangle*>> lods(2);
+    ModelParser::ParseTris("2\n0 0 0 1 0 0 0 1 0\n1 2 3 4 5 6 7 8 -9\n", lods[0], &arena);
+    lods[1].push_back(lods[0][0]);
+    MeshCache::Create(lods, MeshCache::IdentifySource(source_path)).Save(cache_path);
+
+    auto cache = MeshCache::Open(source_path);
+    CHECK_EXPECT(cache != nullptr && cache->IsMapped(), "An up to date cache should be mapped.");
+    EXPECT_VALUES_EQUAL(cache->GetVertexCount(), (size_t)9);
+    EXPECT_VALUES_EQUAL(cache->GetLodCount(), (size_t)2);
+    EXPECT_VALUES_EQUAL((size_t)cache->GetLod(1).first_vertex, (size_t)6);
+    CHECK_EXPECT(reinterpret_cast<uintptr_t>(cache->GetVertices()) % MeshCache::ALIGNMENT == 0, "The vertex stream should be aligned.");
+    EXPECT_VALUES_EQUAL(cache->GetBoundsMin(), Math::Pos(0.0f, 0.0f, -9.0f));
+    EXPECT_VALUES_EQUAL(cache->GetBoundsMax(), Math::Pos(7.0f, 8.0f, 6.0f));
+    EXPECT_VALUES_EQUAL(cache->GetVertices()[Vertex::ARRAY_SIZE * 4 + 1], 5.0f);
+
+    std::vector<Triangle*> triangles;
+    cache->CreateTriangles(triangles, &arena);
+    EXPECT_VALUES_EQUAL(triangles.size(), (size_t)2);
+    EXPECT_VALUES_EQUAL(triangles[1]->GetVertex(2)->GetPosition(), Math::Pos(7.0f, 8.0f, -9.0f));
+    EXPECT_VALUES_EQUAL(triangles[0]->GetVertex(0)->GetNormal(), lods[0][0]->GetVertex(0)->GetNormal());
+    cache.reset();
+
+    // A source with the same size but another content is converted again.
+    {
+        std::ofstream file(source_path, std::ios::binary);
+        file << "2\n0 0 0 1 0 0 0 1 0\n1 2 3 4 5 6 7 8 -8\n";
+    }
+    std::filesystem::last_write_time(source_path, std::filesystem::last_write_time(source_path) + std::chrono::seconds(10));
+    CHECK_EXPECT(MeshCache::Open(source_path) == nullptr, "A stale cache should not be opened.");
+
+    {
+        std::ofstream file(cache_path, std::ios::binary);
+        file << "not a mesh cache";
+    }
+    EXPECT_EXPRESSION_THROW_TYPE([&](){ MeshCache file(cache_path); }, std::runtime_error);
+    std::filesystem::remove(source_path);
+    std::filesystem::remove(cache_path);
+}
+
+void UnitTest::TestGltf0()
+{
+    // A quad drawn by a child node rotated by 90 degrees around z, under a translated parent.
+    const float positions[] = {0, 0, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0};
+    const float uvs[] = {0, 0, 1, 0, 1, 1, 0, 1};
+    uint16_t indices[] = {0, 1, 2, 0, 2, 3};
+    std::string binary(reinterpret_cast<const char*>(positions), sizeof(positions));
+    binary.append(reinterpret_cast<const char*>(uvs), sizeof(uvs));
+    binary.append(reinterpret_cast<const char*>(indices), sizeof(indices));
+    std::string json = R"({"asset": {"version": "2.0"}, "scene": 0, "scenes": [{"nodes": [0]}],
+        "nodes": [{"name": "parent", "translation": [1, 2, 3], "children": [1]},
+            {"name": "child", "mesh": 0, "matrix": [0, 1, 0, 0, -1, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1]}],
+        "meshes": [{"primitives": [{"attributes": {"POSITION": 0, "TEXCOORD_0": 1}, "indices": 2, "material": 0}]}],
+        "materials": [{"pbrMetallicRoughness": {"baseColorFactor": [1, 0.5, 0.25, 1], "metallicFactor": 0.5}}],
+        "buffers": [{"byteLength": 92}],
+        "bufferViews": [{"buffer": 0, "byteLength": 48}, {"buffer": 0, "byteOffset": 48, "byteLength": 32},
+            {"buffer": 0, "byteOffset": 80, "byteLength": 12}],
+        "accessors": [{"bufferView": 0, "componentType": 5126, "count": 4, "type": "VEC3"},
+            {"bufferView": 1, "componentType": 5126, "count": 4, "type": "VEC2"},
+            {"bufferView": 2, "componentType": 5123, "count": 6, "type": "SCALAR"}]})";
+    std::string path = (std::filesystem::temp_directory_path() / "ce_test_gltf.glb").string();
+    WriteGlb(path, json, binary);
+
+    {
+        GltfAsset asset(path);
+        auto position_span = asset.GetAccessor(0).AsSpan<float>();
+        EXPECT_VALUES_EQUAL(position_span.size(), (size_t)12);
+        EXPECT_VALUES_EQUAL(position_span[3], 1.0f);
+        EXPECT_VALUES_EQUAL(asset.GetAccessor(2).AsSpan<uint16_t>()[5], (uint16_t)3);
+        EXPECT_EXPRESSION_THROW_TYPE([&](){ asset.GetAccessor(2).AsSpan<uint32_t>(); }, std::runtime_error);
+        EXPECT_EXPRESSION_THROW_TYPE([&](){ asset.GetAccessor(3); }, std::runtime_error);
+
+        auto meshes = asset.DecodeMeshes();
+        EXPECT_VALUES_EQUAL(meshes.size(), (size_t)1);
+        EXPECT_VALUES_EQUAL(meshes[0][0].material, (int64_t)0);
+        auto& cache = *meshes[0][0].cache;
+        EXPECT_VALUES_EQUAL(cache.GetVertexCount(), (size_t)6);
+        const float* vertices = cache.GetVertices();
+        EXPECT_VALUES_EQUAL(Math::Pos(vertices[22], vertices[23], vertices[24]), Math::Pos(1.0f, 1.0f, 0.0f));
+        EXPECT_VALUES_EQUAL(Math::Vec4(vertices[3], vertices[4], vertices[5], 0.0f), Math::Vec4(0.0f, 0.0f, 1.0f, 0.0f));
+        EXPECT_VALUES_EQUAL(Math::Vec2(vertices[17], vertices[18]), Math::Vec2(1.0f, 0.0f));
+
+        // The transform of the node is converted to the conventions of the components.
+        Math::Vec4 translation, rotation, scale;
+        asset.GetNodeTransform(1, translation, rotation, scale);
+        auto rotated = Math::Model(translation, rotation, scale) * Math::Pos(1.0f, 0.0f, 0.0f);
+        CHECK_EXPECT((rotated - Math::Pos(0.0f, 1.0f, 0.0f)).Length() < 1e-5f, "The node should rotate x to y.");
+
+        auto merged = asset.CreateMeshCache({});
+        EXPECT_VALUES_EQUAL(merged.GetVertexCount(), (size_t)6);
+        vertices = merged.GetVertices();
+        CHECK_EXPECT((Math::Pos(vertices[11], vertices[12], vertices[13]) - Math::Pos(1.0f, 3.0f, 3.0f)).Length() < 1e-5f,
+            "The vertices should be moved by the transforms of the nodes.");
+        CHECK_EXPECT((Math::Vec4(vertices[14], vertices[15], vertices[16], 0.0f) - Math::Vec4(0.0f, 0.0f, 1.0f, 0.0f)).Length() < 1e-5f,
+            "The normals should be turned by the transforms of the nodes.");
+    }
+
+    indices[4] = 9;
+    binary.replace(80, sizeof(indices), reinterpret_cast<const char*>(indices), sizeof(indices));
+    WriteGlb(path, json, binary);
+    EXPECT_EXPRESSION_THROW_TYPE([&](){ GltfAsset(path).DecodeMeshes(); }, std::runtime_error);
+
+    // Indices must be unsigned, signed types would be read past their buffer view.
+    indices[4] = 2;
+    binary.replace(80, sizeof(indices), reinterpret_cast<const char*>(indices), sizeof(indices));
+    std::string signed_json = json;
+    signed_json.replace(signed_json.find("5123"), 4, "5122");
+    WriteGlb(path, signed_json, binary);
+    EXPECT_EXPRESSION_THROW_TYPE([&](){ GltfAsset(path).DecodeMeshes(); }, std::runtime_error);
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << "not a glb file";
+    }
+    EXPECT_EXPRESSION_THROW_TYPE([&](){ GltfAsset asset(path); }, std::runtime_error);
+    std::filesystem::remove(path);
+}
+
+void UnitTest::TestResourceLoader0()
+{
+    ResourceLoader loader(1);
+    EXPECT_VALUES_EQUAL(loader.GetWorkerCount(), (size_t)1);
+
+    // Hold the only worker, so the next jobs wait in order.
+    std::promise<void> started;
+    std::promise<void> gate;
+    auto blocker = loader.Submit([&started, future = gate.get_future()]() mutable { started.set_value(); future.wait(); });
+    started.get_future().wait();
+    std::vector<int> order;
+    auto first = loader.Submit([&order]() { order.push_back(1); return 1; });
+    auto second = loader.Submit([&order]() { order.push_back(2); return std::string("second"); });
+    auto failed = loader.Submit([]() -> int { throw std::runtime_error("failed"); });
+    EXPECT_VALUES_EQUAL(loader.GetPendingJobCount(), (size_t)3);
+    CHECK_EXPECT(!ResourceLoader::IsReady(first), "A waiting job should not be ready.");
+
+    gate.set_value();
+    EXPECT_VALUES_EQUAL(first.get(), 1);
+    EXPECT_VALUES_EQUAL(second.get(), std::string("second"));
+    EXPECT_EXPRESSION_THROW_TYPE([&](){ failed.get(); }, std::runtime_error);
+    EXPECT_VALUES_EQUAL(order.size(), (size_t)2);
+    EXPECT_VALUES_EQUAL(order[0], 1);
+    EXPECT_VALUES_EQUAL(order[1], 2);
+    CHECK_EXPECT(!ResourceLoader::IsReady(first), "A consumed future should not be ready.");
+    CHECK_EXPECT(ResourceLoader::IsReady(blocker), "A finished job should be ready.");
+
+    EXPECT_EXPRESSION_THROW_TYPE([&](){ loader.LoadTextureImage("ce_missing_image.png").get(); }, std::runtime_error);
+}
+
+void UnitTest::TestResourceCache0()
+{
+    ResourceCache<std::string> cache([](const std::string& p_value) { return p_value.size(); }, 8);
+    size_t load_count = 0;
+    auto load = [&](const char* p_value) {
+        return [&load_count, p_value]() { ++load_count; return std::make_shared<std::string>(p_value); };
+    };
+
+    auto a = cache.Get("a", load("aaaa"));
+    auto a2 = cache.Get("a", load("other"));
+    CHECK_EXPECT(a == a2, "A cached resource should be shared.");
+    EXPECT_VALUES_EQUAL(load_count, (size_t)1);
+    a2.reset();
+
+    // Referenced resources are kept over the budget.
+    auto b = cache.Get("b", load("bbbb"));
+    auto c = cache.Get("c", load("cccc"));
+    auto statistics = cache.GetStatistics();
+    EXPECT_VALUES_EQUAL(statistics.entry_count, (size_t)3);
+    EXPECT_VALUES_EQUAL(statistics.memory_usage, (size_t)12);
+
+    // The least recently used unused resource is evicted first.
+    cache.Get("a", load("aaaa"));
+    a.reset();
+    b.reset();
+    c.reset();
+    cache.Trim();
+    statistics = cache.GetStatistics();
+    EXPECT_VALUES_EQUAL(statistics.entry_count, (size_t)2);
+    EXPECT_VALUES_EQUAL(statistics.eviction_count, (size_t)1);
+    cache.Get("a", load("aaaa"));
+    cache.Get("c", load("cccc"));
+    EXPECT_VALUES_EQUAL(load_count, (size_t)3);
+    cache.Get("b", load("bbbb"));
+    EXPECT_VALUES_EQUAL(load_count, (size_t)4);
+
+    // A failed load is not cached.
+    EXPECT_EXPRESSION_THROW_TYPE([&](){ cache.Get("d", []() -> std::shared_ptr<std::string> { throw std::runtime_error("failed"); }); }, std::runtime_error);
+    cache.Clear();
+    statistics = cache.GetStatistics();
+    EXPECT_VALUES_EQUAL(statistics.entry_count, (size_t)0);
+    EXPECT_VALUES_EQUAL(statistics.memory_usage, (size_t)0);
+    EXPECT_VALUES_EQUAL(statistics.hit_count, (size_t)4);
+    EXPECT_VALUES_EQUAL(statistics.miss_count, (size_t)5);
+}
+
+void UnitTest::TestPackFile0()
+{
+    // The compressed data decompresses to the same bytes, including long literal runs and overlapping matches.
+    std::string data;
+    for (size_t i = 0; i < 20000; ++i)
+        data += (i % 1000 < 300) ? (char)(i * 7919 % 251) : (char)('a' + i % 3);
+    auto compressed = PackFile::Compress(data.data(), data.size());
+    CHECK_EXPECT(compressed.size() < data.size() / 2, "Repeated data should be compressed.");
+    std::string decompressed(data.size(), '\0');
+    PackFile::Decompress(compressed.data(), compressed.size(), decompressed.data(), decompressed.size());
+    CHECK_EXPECT(decompressed == data, "The decompressed data should be the original data.");
+    EXPECT_EXPRESSION_THROW_TYPE([&](){ PackFile::Decompress(compressed.data(), compressed.size() - 1, decompressed.data(), decompressed.size()); }, std::runtime_error);
+    for (size_t size : {0, 1, 12, 13, 100})
+    {
+        std::string small = data.substr(data.size() - size);
+        auto result = PackFile::Compress(small.data(), small.size());
+        std::string output(size, '\0');
+        PackFile::Decompress(result.data(), result.size(), output.data(), output.size());
+        CHECK_EXPECT(output == small, "Small data should be decompressed to the original data.");
+    }
+
+    auto directory = std::filesystem::temp_directory_path() / "ce_test_pack";
+    std::filesystem::create_directories(directory / "models");
+    std::string large_path = (directory / "large.bin").string();
+    std::string small_path = (directory / "models" / "small.tris").string();
+    std::string pack_path = (directory.parent_path() / "ce_test_pack.pack").string();
+    {
+        std::ofstream file(large_path, std::ios::binary);
+        file << data;
+    }
+    {
+        std::ofstream file(small_path, std::ios::binary);
+        file << "1\n0 0 0 1 0 0 0 1 0\n";
+    }
+    PackFile::Create(pack_path, {{"large.bin", large_path}, {"models/small.tris", small_path}}, true);
+    EXPECT_EXPRESSION_THROW_TYPE([&](){ PackFile::Create(pack_path + ".tmp", {{"a", small_path}, {"a", small_path}}, false); }, std::runtime_error);
+    std::filesystem::remove(pack_path + ".tmp");
+    {
+        PackFile pack(pack_path);
+        EXPECT_VALUES_EQUAL(pack.GetEntryCount(), (size_t)2);
+        CHECK_EXPECT(pack.Find("missing") == nullptr, "A missing entry should not be found.");
+        auto large = pack.Find("large.bin");
+        CHECK_EXPECT(large != nullptr && large->compression == PackFile::COMPRESSION_LZ4, "The large entry should be compressed.");
+        std::string read(large->size, '\0');
+        pack.Read(*large, read.data());
+        CHECK_EXPECT(read == data, "The entry should be read to the original data.");
+        auto small = pack.Find("models/small.tris");
+        CHECK_EXPECT(small != nullptr && small->compression == PackFile::COMPRESSION_NONE, "The small entry should be stored as is.");
+        EXPECT_VALUES_EQUAL(pack.GetName(*small), std::string_view("models/small.tris"));
+    }
+
+    // The packed files are read through the mount point, and the other files from the disk.
+    VirtualFileSystem file_system;
+    std::string mount_point = directory.generic_string();
+    file_system.Mount(mount_point, pack_path);
+    std::filesystem::remove_all(directory);
+    CHECK_EXPECT(file_system.Exists(mount_point + "/models/../models/small.tris"), "A packed file should exist.");
+    CHECK_EXPECT(!file_system.Exists(mount_point + "/models/missing.tris"), "A missing file should not exist.");
+    EXPECT_VALUES_EQUAL(file_system.Open(mount_point + "/models/small.tris").GetText(), std::string_view("1\n0 0 0 1 0 0 0 1 0\n"));
+    CHECK_EXPECT(file_system.Open(mount_point + "/large.bin").GetText() == data, "A compressed file should be decompressed.");
+    EXPECT_VALUES_EQUAL(file_system.Open(pack_path).GetSize(), (size_t)std::filesystem::file_size(pack_path));
+    CHECK_EXPECT(!file_system.GetDiskPath(mount_point + "/models/small.tris").has_value(), "A packed file should not be on the disk.");
+    EXPECT_VALUES_EQUAL(file_system.GetDiskPath(pack_path).value_or(""), pack_path);
+    EXPECT_VALUES_EQUAL(file_system.Unmount(mount_point + "/"), (size_t)1);
+    EXPECT_EXPRESSION_THROW_TYPE([&](){ file_system.Open(mount_point + "/large.bin"); }, std::runtime_error);
+
+    // Packed models are loaded without a mesh cache.
+    VirtualFileSystem::GetInstance().Mount(mount_point, pack_path);
+    std::vector<Triangle*> triangles;
+    GeometryArena arena;
+    Resource::LoadModel(mount_point + "/models/small.tris", triangles, &arena);
+    EXPECT_VALUES_EQUAL(triangles.size(), (size_t)1);
+    EXPECT_VALUES_EQUAL(Resource::LoadMeshCache(mount_point + "/models/small.tris")->GetVertexCount(), (size_t)3);
+    CHECK_EXPECT(!std::filesystem::exists(directory), "No mesh cache should be written for a packed model.");
+    VirtualFileSystem::GetInstance().Unmount(mount_point);
+    std::filesystem::remove(pack_path);
+}
@@ -0,0 +1,304 @@
+#include "../unit_test/unit_test.h"
+#include "ce/utils/radix_sort.h"
+#include "ce/utils/tlsf_allocator.h"
+#include "ce/utils/slot_map.hpp"
+#include "ce/utils/mpsc_queue.hpp"
+#include "ce/utils/frame_allocator.h"
+#include "ce/utils/task.h"
+#include "ce/utils/json.h"
+#include "ce/utils/rectangle_packer.h"
+#include "ce/utils/job_system.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <thread>
+
+using namespace CrossEngine;
+
+void UnitTest::TestRadixSort0()
+{
+    std::vector<float> values = {3.5f, -1.0f, 0.0f, -0.0f, 1e20f, -1e20f, 2.0f, 3.5f, -7.25f, 1e-30f};
+    std::vector<uint32_t> keys, indices;
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        keys.push_back(FloatToSortKey(values[i]));
+        indices.push_back((uint32_t)i);
+    }
+    RadixSort(keys, indices);
+    for (size_t i = 1; i < indices.size(); ++i)
+        CHECK_EXPECT(values[indices[i - 1]] <= values[indices[i]], "The values should be sorted in ascending order.");
+    // Equal keys keep their order.
+    EXPECT_VALUES_EQUAL(indices[7], (uint32_t)0);
+    EXPECT_VALUES_EQUAL(indices[8], (uint32_t)7);
+
+    std::vector<uint32_t> large_keys, large_values;
+    for (uint32_t i = 0; i < 10000; ++i)
+    {
+        large_keys.push_back(i * 2654435761u);
+        large_values.push_back(i);
+    }
+    RadixSort(large_keys, large_values);
+    CHECK_EXPECT(std::is_sorted(large_keys.begin(), large_keys.end()), "The keys should be sorted.");
+    EXPECT_VALUES_EQUAL(large_values[0] * 2654435761u, large_keys[0]);
+
+    // The scratch memory of the caller is reused by the next sorts.
+    RadixSortBuffers buffers;
+    std::vector<uint32_t> reversed_keys(large_keys.rbegin(), large_keys.rend()), reversed_values(large_values.rbegin(), large_values.rend());
+    RadixSort(reversed_keys, reversed_values, buffers);
+    const uint32_t* scratch = buffers.keys.data();
+    CHECK_EXPECT(reversed_keys == large_keys && reversed_values == large_values, "The keys should be sorted with their values.");
+    keys = {5, 1, 3};
+    indices = {0, 1, 2};
+    RadixSort(keys, indices, buffers);
+    CHECK_EXPECT(indices == std::vector<uint32_t>({1, 2, 0}), "The values should follow their keys.");
+    CHECK_EXPECT(buffers.keys.data() == scratch, "A smaller sort should not allocate.");
+
+    std::vector<uint32_t> mismatched(3);
+    EXPECT_EXPRESSION_THROW_TYPE(([&](){ RadixSort(large_keys, mismatched); }), std::invalid_argument);
+}
+
+void UnitTest::TestTLSFAllocator0()
+{
+    TLSFAllocator allocator(1024, 16);
+    EXPECT_VALUES_EQUAL(allocator.GetFreeSize(), (size_t)1024);
+
+    uint32_t a = allocator.Allocate(100);
+    uint32_t b = allocator.Allocate(200);
+    uint32_t c = allocator.Allocate(300);
+    CHECK_EXPECT(a != TLSFAllocator::INVALID_BLOCK && b != TLSFAllocator::INVALID_BLOCK && c != TLSFAllocator::INVALID_BLOCK,
+        "The allocations should fit.");
+    EXPECT_VALUES_EQUAL(allocator.GetSize(a), (size_t)112);
+    EXPECT_VALUES_EQUAL(allocator.GetOffset(a) % 16, (size_t)0);
+    CHECK_EXPECT(allocator.GetOffset(a) + allocator.GetSize(a) <= allocator.GetOffset(b)
+        || allocator.GetOffset(b) + allocator.GetSize(b) <= allocator.GetOffset(a), "The ranges should not overlap.");
+    EXPECT_VALUES_EQUAL(allocator.GetLastAllocatedBlock(), c);
+    EXPECT_VALUES_EQUAL(allocator.Allocate(1024), TLSFAllocator::INVALID_BLOCK);
+
+    // Freed neighbours are merged into one range.
+    allocator.Free(b);
+    allocator.Free(a);
+    uint32_t d = allocator.Allocate(300);
+    EXPECT_VALUES_EQUAL(allocator.GetOffset(d), (size_t)0);
+
+    allocator.Free(c);
+    allocator.Free(d);
+    EXPECT_EXPRESSION_THROW_TYPE(([&](){ allocator.Free(d); }), std::invalid_argument);
+    EXPECT_VALUES_EQUAL(allocator.GetFreeSize(), (size_t)1024);
+    EXPECT_VALUES_EQUAL(allocator.GetLastAllocatedBlock(), TLSFAllocator::INVALID_BLOCK);
+    uint32_t whole = allocator.Allocate(1024);
+    EXPECT_VALUES_EQUAL(allocator.GetOffset(whole), (size_t)0);
+    allocator.Free(whole);
+
+    allocator.Grow(4096);
+    EXPECT_VALUES_EQUAL(allocator.GetFreeSize(), (size_t)4096);
+    std::vector<uint32_t> blocks;
+    for (size_t i = 0; i < 64; ++i)
+        blocks.push_back(allocator.Allocate(64));
+    EXPECT_VALUES_EQUAL(allocator.GetFreeSize(), (size_t)0);
+    for (size_t i = 0; i < blocks.size(); i += 2)
+        allocator.Free(blocks[i]);
+    // Only 64 byte holes are left.
+    EXPECT_VALUES_EQUAL(allocator.Allocate(128), TLSFAllocator::INVALID_BLOCK);
+    CHECK_EXPECT(allocator.GetLargestFreeClass() >= allocator.GetAllocationClass(64)
+        && allocator.GetLargestFreeClass() < allocator.GetAllocationClass(128), "The largest free class should only fit the holes.");
+    for (size_t i = 1; i < blocks.size(); i += 2)
+        allocator.Free(blocks[i]);
+    EXPECT_VALUES_EQUAL(allocator.GetOffset(allocator.Allocate(4096)), (size_t)0);
+    EXPECT_VALUES_EQUAL(allocator.GetLargestFreeClass(), TLSFAllocator::INVALID_CLASS);
+}
+
+void UnitTest::TestSlotMap0()
+{
+    SlotMap<int> map;
+    auto a = map.Insert(1);
+    auto b = map.Insert(2);
+    EXPECT_VALUES_EQUAL(map.Size(), (size_t)2);
+    EXPECT_VALUES_EQUAL(*map.Get(a), 1);
+    EXPECT_VALUES_EQUAL(*map.Get(b), 2);
+    CHECK_EXPECT(!map.Contains(SlotMap<int>::Handle()), "A default handle should not address a value.");
+
+    CHECK_EXPECT(map.Remove(a), "The value should be removed.");
+    CHECK_EXPECT(!map.Remove(a), "A value should only be removed once.");
+    CHECK_EXPECT(map.Get(a) == nullptr, "A removed value should not be addressed.");
+
+    // The slot is reused, the old handle stays stale.
+    auto c = map.Insert(3);
+    EXPECT_VALUES_EQUAL(c.index, a.index);
+    CHECK_EXPECT(!map.Contains(a), "A stale handle should not address the new value of its slot.");
+    EXPECT_VALUES_EQUAL(*map.Get(c), 3);
+
+    int sum = 0;
+    map.ForEach([&](int p_value){ sum += p_value; });
+    EXPECT_VALUES_EQUAL(sum, 5);
+    map.Clear();
+    EXPECT_VALUES_EQUAL(map.Size(), (size_t)0);
+    CHECK_EXPECT(!map.Contains(b) && !map.Contains(c), "The handles should be stale after clearing.");
+}
+
+void UnitTest::TestMPSCQueue0()
+{
+    constexpr size_t THREAD_COUNT = 4;
+    constexpr size_t PUSH_COUNT = 10000;
+    MPSCQueue<size_t> queue;
+    size_t value;
+    CHECK_EXPECT(!queue.Pop(value), "The queue should be empty.");
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < THREAD_COUNT; ++i)
+    {
+        threads.emplace_back([&queue, i](){
+            for (size_t j = 0; j < PUSH_COUNT; ++j)
+                queue.Push(i * PUSH_COUNT + j);
+        });
+    }
+    for (auto& i : threads)
+        i.join();
+
+    // Every value is popped once, in the order of its producer.
+    std::vector<size_t> last(THREAD_COUNT, SIZE_MAX);
+    size_t count = 0;
+    bool is_ordered = true;
+    while (queue.Pop(value))
+    {
+        size_t thread = value / PUSH_COUNT;
+        is_ordered = is_ordered && (last[thread] == SIZE_MAX || last[thread] < value);
+        last[thread] = value;
+        ++count;
+    }
+    EXPECT_VALUES_EQUAL(count, THREAD_COUNT * PUSH_COUNT);
+    CHECK_EXPECT(is_ordered, "The values of a producer should be popped in order.");
+}
+
+void UnitTest::TestFrameAllocator0()
+{
+    FrameAllocator allocator(256);
+    {
+        std::pmr::vector<int> values(&allocator);
+        for (int i = 0; i < 100; ++i)
+            values.push_back(i);
+        EXPECT_VALUES_EQUAL(values[99], 99);
+    }
+    void* aligned = allocator.allocate(8, 64);
+    EXPECT_VALUES_EQUAL(reinterpret_cast<uintptr_t>(aligned) % 64, (uintptr_t)0);
+    CHECK_EXPECT(allocator.GetFrameBytes() > 256, "The frame should outgrow the first block.");
+    size_t upstream_count = allocator.GetUpstreamAllocationCount();
+    CHECK_EXPECT(upstream_count > 1, "The frame should add blocks.");
+
+    // The blocks are merged, so a frame of the same size no longer allocates from the global heap.
+    allocator.Reset();
+    EXPECT_VALUES_EQUAL(allocator.GetFrameBytes(), (size_t)0);
+    upstream_count = allocator.GetUpstreamAllocationCount();
+    for (size_t frame = 0; frame < 3; ++frame)
+    {
+        std::pmr::vector<int> values(&allocator);
+        for (int i = 0; i < 100; ++i)
+            values.push_back(i);
+        aligned = allocator.allocate(8, 64);
+        allocator.Reset();
+    }
+    EXPECT_VALUES_EQUAL(allocator.GetUpstreamAllocationCount(), upstream_count);
+    EXPECT_VALUES_EQUAL(allocator.GetFrameCount(), (size_t)4);
+
+    // An alignment above the alignment of the block still keeps the allocation in the block, whatever the
+    // address of the block is.
+    for (size_t i = 0; i < 8; ++i)
+    {
+        FrameAllocator small_allocator(128);
+        auto first = static_cast<std::byte*>(small_allocator.allocate(8, 1));
+        auto second = static_cast<std::byte*>(small_allocator.allocate(56, 64));
+        EXPECT_VALUES_EQUAL(reinterpret_cast<uintptr_t>(second) % 64, (uintptr_t)0);
+        CHECK_EXPECT(second >= first + 8, "The aligned allocation should not overlap the previous one.");
+        std::memset(second, 0xff, 56);
+        auto third = static_cast<std::byte*>(small_allocator.allocate(200, 256));
+        EXPECT_VALUES_EQUAL(reinterpret_cast<uintptr_t>(third) % 256, (uintptr_t)0);
+        std::memset(third, 0xff, 200);
+    }
+
+    // Tasks store large captures in the frame allocator of the thread.
+    size_t frame_bytes = FrameAllocator::GetThreadInstance().GetFrameBytes();
+    size_t a = 1, b = 2, c = 3, result = 0;
+    Task task([&a, &b, &c, &result](){ result = a + b + c; }, 0);
+    task.task();
+    EXPECT_VALUES_EQUAL(result, (size_t)6);
+    CHECK_EXPECT(FrameAllocator::GetThreadInstance().GetFrameBytes() > frame_bytes, "The capture should be allocated by the frame allocator.");
+    FrameAllocator::GetThreadInstance().Reset();
+}
+
+void UnitTest::TestJson0()
+{
+    auto json = Json::Parse(" {\"asset\": {\"version\": \"2.0\"}, \"values\": [1, -2.5e3, true, null, \"a\\\"b\\u00e9\\ud83d\\ude00\"], \"empty\": {}}\n");
+    EXPECT_STRINGS_EQUAL(json["asset"]["version"].GetString(), std::string("2.0"));
+    EXPECT_VALUES_EQUAL(json["values"].GetSize(), (size_t)5);
+    EXPECT_VALUES_EQUAL(json["values"][1].GetNumber(), -2500.0);
+    CHECK_EXPECT(json["values"][2].GetBoolean() && json["values"][3].IsNull(), "The literals should be parsed.");
+    EXPECT_STRINGS_EQUAL(json["values"][4].GetString(), std::string("a\"b\xC3\xA9\xF0\x9F\x98\x80"));
+    CHECK_EXPECT(json["empty"].IsObject() && json["missing"].IsNull() && json.Find("missing") == nullptr, "Missing members should be null.");
+    EXPECT_VALUES_EQUAL(json["missing"]["nested"].GetNumber(7.0), 7.0);
+    EXPECT_EXPRESSION_THROW_TYPE([&](){ json["values"][5]; }, std::out_of_range);
+    EXPECT_EXPRESSION_THROW_TYPE([](){ Json::Parse("{\"a\": [1, 2}"); }, std::runtime_error);
+    EXPECT_EXPRESSION_THROW_TYPE([](){ Json::Parse("{} {}"); }, std::runtime_error);
+    EXPECT_EXPRESSION_THROW_TYPE([](){ Json::Parse(std::string(10000, '[')); }, std::runtime_error);
+}
+
+void UnitTest::TestRectanglePacker0()
+{
+    EXPECT_EXPRESSION_THROW_TYPE(([](){ RectanglePacker packer(0, 16); }), std::invalid_argument);
+    RectanglePacker packer(16, 16);
+    CHECK_EXPECT(!packer.Insert(17, 1).has_value(), "A rectangle wider than the packer should not fit.");
+    CHECK_EXPECT(!packer.Insert(0, 4).has_value(), "An empty rectangle should not be packed.");
+
+    // Rectangles of different sizes fill the packer without overlapping.
+    std::vector<RectanglePacker::Rect> rects;
+    for (auto size : {std::pair<size_t, size_t>{8, 8}, {8, 4}, {4, 4}, {4, 4}, {8, 4}, {8, 4}, {16, 4}})
+    {
+        auto rect = packer.Insert(size.first, size.second);
+        CHECK_EXPECT(rect.has_value(), "The rectangle should fit.");
+        if (!rect.has_value())
+            return;
+        CHECK_EXPECT(rect->x + rect->width <= 16 && rect->y + rect->height <= 16, "The rectangle should be in the packer.");
+        for (const auto& other : rects)
+        {
+            CHECK_EXPECT(rect->x + rect->width <= other.x || other.x + other.width <= rect->x
+                || rect->y + rect->height <= other.y || other.y + other.height <= rect->y, "The rectangles should not overlap.");
+        }
+        rects.push_back(*rect);
+    }
+    // The lowest place is taken first, the second rectangle sits next to the first.
+    EXPECT_VALUES_EQUAL(rects[1].x, (size_t)8);
+    EXPECT_VALUES_EQUAL(rects[1].y, (size_t)0);
+    EXPECT_VALUES_EQUAL(packer.GetUsedArea(), (size_t)(16 * 16));
+    CHECK_EXPECT(!packer.Insert(1, 1).has_value(), "A full packer should not fit anything.");
+
+    packer.Clear();
+    EXPECT_VALUES_EQUAL(packer.GetUsedArea(), (size_t)0);
+    auto full = packer.Insert(16, 16);
+    CHECK_EXPECT(full.has_value() && full->x == 0 && full->y == 0, "A cleared packer should fit a full rectangle.");
+}
+
+void UnitTest::TestJobSystem0()
+{
+    JobSystem jobs(3);
+    EXPECT_VALUES_EQUAL(jobs.GetWorkerCount(), (size_t)3);
+
+    // Every index is visited once, the last chunk being shorter.
+    std::vector<std::atomic<int>> visits(1000);
+    for (size_t frame = 0; frame < 10; ++frame)
+    {
+        jobs.ParallelFor(visits.size(), 64, [&visits](size_t p_first, size_t p_last) {
+            for (size_t i = p_first; i < p_last; ++i)
+                ++visits[i];
+        });
+    }
+    bool is_visited = std::all_of(visits.begin(), visits.end(), [](const std::atomic<int>& p_visit) { return p_visit == 10; });
+    CHECK_EXPECT(is_visited, "Every index should be visited once a frame.");
+
+    // A single chunk runs on the calling thread.
+    std::thread::id thread_id;
+    jobs.ParallelFor(10, 64, [&thread_id](size_t, size_t) { thread_id = std::this_thread::get_id(); });
+    CHECK_EXPECT(thread_id == std::this_thread::get_id(), "A single chunk should run on the calling thread.");
+
+    EXPECT_EXPRESSION_THROW_TYPE(([&](){ jobs.ParallelFor(100, 10, [](size_t p_first, size_t) {
+        if (p_first == 50)
+            throw std::runtime_error("Failed chunk.");
+    }); }), std::runtime_error);
+}
@@ -36,6 +36,39 @@ void UnitTest::Start()
     RUN_TEST(TestLerp1);
     RUN_TEST(TestLerp2);
     RUN_TEST(TestLerp3);
+
+    RUN_TEST(TestBVH0);
+    RUN_TEST(TestBVH1);
+    RUN_TEST(TestBVH2);
+    RUN_TEST(TestGeometryArena0);
+
+    RUN_TEST(TestRadixSort0);
+    RUN_TEST(TestTLSFAllocator0);
+    RUN_TEST(TestSlotMap0);
+    RUN_TEST(TestMPSCQueue0);
+    RUN_TEST(TestFrameAllocator0);
+    RUN_TEST(TestJson0);
+    RUN_TEST(TestRectanglePacker0);
+    RUN_TEST(TestJobSystem0);
+
+    RUN_TEST(TestBufferArena0);
+    RUN_TEST(TestGPUResourceRegistry0);
+    RUN_TEST(TestTextureStreamer0);
+    RUN_TEST(TestMipChain0);
+    RUN_TEST(TestBlockCompression0);
+    RUN_TEST(TestIndirectDrawList0);
+    RUN_TEST(TestStaticBatcher0);
+    RUN_TEST(TestOITPass0);
+    RUN_TEST(TestMaterialAtlas0);
+    RUN_TEST(TestComponentPool0);
+    RUN_TEST(TestComponentPath0);
+
+    RUN_TEST(TestModelParser0);
+    RUN_TEST(TestMeshCache0);
+    RUN_TEST(TestGltf0);
+    RUN_TEST(TestResourceLoader0);
+    RUN_TEST(TestResourceCache0);
+    RUN_TEST(TestPackFile0);
     
 
 
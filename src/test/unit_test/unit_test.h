@@ -234,4 +234,45 @@ private:
     static void TestLerp3();
     /** Lerp Test End **/
     /** Math Test End **/
+    /** Geometry Test Start **/
+    /** BVH Test Start **/
+    static void TestBVH0();
+    static void TestBVH1();
+    static void TestBVH2();
+    /** BVH Test End **/
+    static void TestGeometryArena0();
+    /** Geometry Test End **/
+    /** Utils Test Start **/
+    static void TestRadixSort0();
+    static void TestTLSFAllocator0();
+    static void TestSlotMap0();
+    static void TestMPSCQueue0();
+    static void TestFrameAllocator0();
+    static void TestJson0();
+    static void TestRectanglePacker0();
+    static void TestJobSystem0();
+    /** Utils Test End **/
+    /** Graphics Test Start **/
+    static void TestBufferArena0();
+    static void TestGPUResourceRegistry0();
+    static void TestTextureStreamer0();
+    static void TestMipChain0();
+    static void TestBlockCompression0();
+    static void TestIndirectDrawList0();
+    static void TestStaticBatcher0();
+    static void TestOITPass0();
+    static void TestMaterialAtlas0();
+    /** Graphics Test End **/
+    /** Component Test Start **/
+    static void TestComponentPool0();
+    static void TestComponentPath0();
+    /** Component Test End **/
+    /** Resource Test Start **/
+    static void TestModelParser0();
+    static void TestMeshCache0();
+    static void TestGltf0();
+    static void TestResourceLoader0();
+    static void TestResourceCache0();
+    static void TestPackFile0();
+    /** Resource Test End **/
 };
\ No newline at end of file
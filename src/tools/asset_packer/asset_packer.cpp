@@ -0,0 +1,74 @@
+#include "ce/resource/pack_file.h"
+#include <filesystem>
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace CrossEngine;
+
+namespace
+{
+    void PrintUsage()
+    {
+        std::cout << "Usage: AssetPacker <directory> [-o <output>] [-c]\n"
+            << "Packs every file under the directory to a pack file, named by its path relative to the directory.\n"
+            << "Mount the pack at the directory to read the files from it. The pack is written next to the\n"
+            << "directory by default. With -c, the files are compressed when it makes them smaller.\n";
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::string directory;
+    std::string output;
+    bool compress = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "-o" && i + 1 < argc)
+            output = argv[++i];
+        else if (arg == "-c")
+            compress = true;
+        else if (arg == "-h" || arg == "--help")
+        {
+            PrintUsage();
+            return 0;
+        }
+        else
+            directory = arg;
+    }
+    if (directory.empty())
+    {
+        PrintUsage();
+        return 1;
+    }
+    std::filesystem::path root = std::filesystem::path(directory).lexically_normal();
+    if (!root.has_filename())
+        root = root.parent_path();
+    if (output.empty())
+        output = root.string() + PackFile::EXTENSION;
+
+    try
+    {
+        std::vector<PackFile::Source> sources;
+        for (auto& entry : std::filesystem::recursive_directory_iterator(root))
+        {
+            if (!entry.is_regular_file())
+                continue;
+            sources.push_back({entry.path().lexically_relative(root).generic_string(), entry.path().string()});
+        }
+        // The pack is the same for the same files, whatever the order of the directory listing.
+        std::sort(sources.begin(), sources.end(), [](const PackFile::Source& p_a, const PackFile::Source& p_b) {
+            return p_a.name < p_b.name;
+        });
+        PackFile::Create(output, sources, compress);
+        std::cout << output << ": " << sources.size() << " files, " << std::filesystem::file_size(output) << " bytes.\n";
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,78 @@
+#include "ce/resource/resource.h"
+#include "ce/resource/mesh_cache.h"
+#include "ce/resource/gltf.h"
+#include "ce/geometry/geometry_arena.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace CrossEngine;
+
+namespace
+{
+    void PrintUsage()
+    {
+        std::cout << "Usage: MeshConverter <model> [<lod model>...] [-o <output>]\n"
+            << "Converts a .tris, .norm, .obj or .glb model to a mesh cache. The extra models are stored as the\n"
+            << "levels of detail of the first one. The cache is written next to the model by default.\n";
+    }
+
+    // The models are parsed directly, loading them through the cache would read the cache being replaced.
+    void ParseModel(const std::string& p_path, std::vector<Triangle*>& p_result, GeometryArena& p_arena)
+    {
+        std::string ext = p_path.substr(p_path.find_last_of('.') + 1);
+        if (ext == "tris")
+            Resource::LoadTris(p_path, p_result, &p_arena);
+        else if (ext == "norm")
+            Resource::LoadTrisWithNormal(p_path, p_result, &p_arena);
+        else if (ext == "obj")
+            Resource::LoadObjModel(p_path, p_result, &p_arena);
+        else if (ext == "glb")
+            GltfAsset(p_path).CreateMeshCache({}).CreateTriangles(p_result, &p_arena);
+        else
+            throw std::runtime_error("Unsupported model file: \"" + p_path + "\".");
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<std::string> models;
+    std::string output;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "-o" && i + 1 < argc)
+            output = argv[++i];
+        else if (arg == "-h" || arg == "--help")
+        {
+            PrintUsage();
+            return 0;
+        }
+        else
+            models.push_back(arg);
+    }
+    if (models.empty())
+    {
+        PrintUsage();
+        return 1;
+    }
+    if (output.empty())
+        output = MeshCache::GetCachePath(models[0]);
+
+    try
+    {
+        GeometryArena arena;
+        std::vector<std::vector<Triangle*>> lods(models.size());
+        for (size_t i = 0; i < models.size(); ++i)
+            ParseModel(models[i], lods[i], arena);
+        auto cache = MeshCache::Create(lods, MeshCache::IdentifySource(models[0]));
+        cache.Save(output);
+        std::cout << output << ": " << cache.GetVertexCount() << " vertices, " << cache.GetLodCount() << " levels of detail.\n";
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,98 @@
+#include "ce/resource/resource.h"
+#include "ce/texture/texture_file.h"
+#include "ce/texture/block_compression.h"
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+using namespace CrossEngine;
+
+namespace
+{
+    void PrintUsage()
+    {
+        std::cout << "Usage: TextureBaker <image> [-o <output>] [-f bc1|bc3|bc5|bc7|none] [-c linear|srgb|normal] [-b] [-n]\n"
+            << "    [-j <threads>]\n"
+            << "Bakes the levels of an image to a texture file. The image is compressed to BC3 if it has an alpha\n"
+            << "channel and to BC1 otherwise, unless a format is given. Use BC5 for normal maps, and BC7 for higher\n"
+            << "quality. The smaller levels are filtered with a Kaiser filter, or a box filter with -b, as the content\n"
+            << "of the image: sRGB colors are filtered in linear space, and normals are normalized. The content is\n"
+            << "linear, or normal for BC5, unless given. With -n, only the image itself is baked, without the smaller\n"
+            << "levels. The texture file is written next to the image by default.\n";
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::string input;
+    std::string output;
+    std::string format_name;
+    std::string content_name;
+    MipConfig config;
+    config.thread_count = std::max(std::thread::hardware_concurrency(), 1u);
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "-o" && i + 1 < argc)
+            output = argv[++i];
+        else if (arg == "-f" && i + 1 < argc)
+            format_name = argv[++i];
+        else if (arg == "-c" && i + 1 < argc)
+            content_name = argv[++i];
+        else if (arg == "-j" && i + 1 < argc)
+            config.thread_count = std::max(std::stoul(argv[++i]), 1ul);
+        else if (arg == "-b")
+            config.filter = MipFilter::BOX;
+        else if (arg == "-n")
+            config.mipmap = false;
+        else if (arg == "-h" || arg == "--help")
+        {
+            PrintUsage();
+            return 0;
+        }
+        else
+            input = arg;
+    }
+    if (input.empty())
+    {
+        PrintUsage();
+        return 1;
+    }
+    if (output.empty())
+        output = std::filesystem::path(input).replace_extension(TextureFile::EXTENSION).string();
+
+    try
+    {
+        auto start = std::chrono::steady_clock::now();
+        size_t width, height, channels;
+        std::unique_ptr<ubyte_t[]> pixels(Resource::LoadTextureImage(input, nullptr, 0, width, height, channels));
+        BlockFormat format = channels == 4 ? BlockFormat::BC3 : BlockFormat::BC1;
+        if (format_name == "none")
+            format = BlockFormat::NONE;
+        else if (!format_name.empty())
+            format = BlockCompression::ParseFormat(format_name);
+        if (content_name == "srgb")
+            config.content = TextureContent::SRGB;
+        else if (content_name == "normal" || (content_name.empty() && format == BlockFormat::BC5))
+            config.content = TextureContent::NORMAL;
+        else if (!content_name.empty() && content_name != "linear")
+            throw std::runtime_error("Unknown content: \"" + content_name + "\".");
+        auto image = MipChain::Generate(pixels.get(), width, height, channels, config);
+        if (format != BlockFormat::NONE)
+            image = BlockCompression::Compress(image, format, config.thread_count);
+        TextureFile::Write(output, image);
+        auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << output << ": " << width << "x" << height << ", " << image.levels.size() << " levels, "
+            << image.GetSize() << " bytes, " << seconds << " s.\n";
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+    return 0;
+}